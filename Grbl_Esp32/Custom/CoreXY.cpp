@@ -10,6 +10,10 @@
   - Must home one axis per cycle
   - limited to 3 axis systems...easy fix in increase (just donate)
 
+  LINEAR_KINEMATICS in Config.h drives a CoreXY, or a midTbot with the matrix
+  { { 2, 1, 0 }, { 2, -1, 0 }, { 0, 0, 1 } }, without this file, and limits the
+  rates and accelerations of the carriage rather than of the motors.
+
   ============================================================================
 
   Grbl is free software: you can redistribute it and/or modify
@@ -41,6 +41,15 @@ bool                atari_homing = false;
 uint8_t             homing_phase = HOMING_PHASE_FULL_APPROACH;
 uint8_t             current_tool;
 
+// Queues a line for the main loop, or says that it could not.
+static bool atari_submit(const char* line) {
+    if (!command_submit(line, CLIENT_INPUT)) {
+        grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Error, "Command queue full, %s dropped", line);
+        return false;
+    }
+    return true;
+}
+
 void machine_init() {
     solenoid_pull_count = 0;  // initialize
     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Atari 1020 Solenoid");
@@ -123,23 +132,23 @@ void atari_home_task(void* pvParameters) {
             if (sys.state == State::Idle) {
                 switch (homing_phase) {
                     case HOMING_PHASE_FULL_APPROACH:           // a full width move to insure it hits left end
-                        WebUI::inputBuffer.push("G90G0Z1\r");  // lift the pen
-                        sprintf(gcode_line, "G91G0X%3.2f\r", -ATARI_PAPER_WIDTH + ATARI_HOME_POS - 3.0);  // plus a little extra
-                        WebUI::inputBuffer.push(gcode_line);
+                        atari_submit("G90G0Z1");  // lift the pen
+                        sprintf(gcode_line, "G91G0X%3.2f", -ATARI_PAPER_WIDTH + ATARI_HOME_POS - 3.0);  // plus a little extra
+                        atari_submit(gcode_line);
                         homing_attempt = 1;
                         homing_phase   = HOMING_PHASE_CHECK;
                         break;
                     case HOMING_PHASE_CHECK:  // check the limits switch
                         if (digitalRead(REED_SW_PIN) == 0) {
                             // see if reed switch is grounded
-                            WebUI::inputBuffer.push("G4P0.1\n");  // dramtic pause
+                            atari_submit("G4P0.1");  // dramtic pause
                             sys_position[X_AXIS] = ATARI_HOME_POS * axis_settings[X_AXIS]->steps_per_mm->get();
                             sys_position[Y_AXIS] = 0.0;
                             sys_position[Z_AXIS] = 1.0 * axis_settings[Y_AXIS]->steps_per_mm->get();
                             gc_sync_position();
                             plan_sync_position();
-                            sprintf(gcode_line, "G90G0X%3.2f\r", ATARI_PAPER_WIDTH);  // alway return to right side to reduce home travel stalls
-                            WebUI::inputBuffer.push(gcode_line);
+                            sprintf(gcode_line, "G90G0X%3.2f", ATARI_PAPER_WIDTH);  // alway return to right side to reduce home travel stalls
+                            atari_submit(gcode_line);
                             current_tool  = 1;  // local copy for reference...until actual M6 change
                             gc_state.tool = current_tool;
                             atari_homing  = false;  // done with homing sequence
@@ -149,10 +158,10 @@ void atari_home_task(void* pvParameters) {
                         }
                         break;
                     case HOMING_PHASE_RETRACT:
-                        sprintf(gcode_line, "G0X%3.2f\r", -ATARI_HOME_POS);
-                        WebUI::inputBuffer.push(gcode_line);
-                        sprintf(gcode_line, "G0X%3.2f\r", ATARI_HOME_POS);
-                        WebUI::inputBuffer.push(gcode_line);
+                        sprintf(gcode_line, "G0X%3.2f", -ATARI_HOME_POS);
+                        atari_submit(gcode_line);
+                        sprintf(gcode_line, "G0X%3.2f", ATARI_HOME_POS);
+                        atari_submit(gcode_line);
                         homing_phase = HOMING_PHASE_CHECK;
                         break;
                     default:
@@ -165,7 +174,7 @@ void atari_home_task(void* pvParameters) {
                 if (homing_attempt > ATARI_HOMING_ATTEMPTS) {
                     // try all positions plus 1
                     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Atari homing failed");
-                    WebUI::inputBuffer.push("G90\r");
+                    atari_submit("G90");
                     atari_homing = false;
                 }
             }
@@ -225,12 +234,16 @@ void user_tool_change(uint8_t new_tool) {
         move_count = BUMPS_PER_PEN_CHANGE * (new_tool - current_tool);
     else
         move_count = BUMPS_PER_PEN_CHANGE * ((MAX_PEN_NUMBER - current_tool) + new_tool);
-    sprintf(gcode_line, "G0Z%3.2f\r", ATARI_TOOL_CHANGE_Z);  // go to tool change height
-    WebUI::inputBuffer.push(gcode_line);
+    // The queue holds all of the moves of the longest change, see COMMAND_QUEUE_SIZE.
+    sprintf(gcode_line, "G0Z%3.2f", ATARI_TOOL_CHANGE_Z);  // go to tool change height
+    if (!atari_submit(gcode_line)) {
+        return;
+    }
     for (uint8_t i = 0; i < move_count; i++) {
-        sprintf(gcode_line, "G0X%3.2f\r", ATARI_HOME_POS);  //
-        WebUI::inputBuffer.push(gcode_line);
-        WebUI::inputBuffer.push("G0X0\r");
+        sprintf(gcode_line, "G0X%3.2f", ATARI_HOME_POS);  //
+        if (!atari_submit(gcode_line) || !atari_submit("G0X0")) {
+            return;  // The pen is unknown until the next homing
+        }
     }
     current_tool = new_tool;
     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Change to Pen#%d", current_tool);
@@ -248,19 +261,19 @@ void user_defined_macro(uint8_t index) {
     switch (index) {
         case 0:
             grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Pen switch");
-            WebUI::inputBuffer.push("$H\r");
+            atari_submit("$H");
             break;
         case 1:
             grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Color switch");
             atari_next_pen();
-            sprintf(gcode_line, "G90G0X%3.2f\r", ATARI_PAPER_WIDTH);  // alway return to right side to reduce home travel stalls
-            WebUI::inputBuffer.push(gcode_line);
+            sprintf(gcode_line, "G90G0X%3.2f", ATARI_PAPER_WIDTH);  // alway return to right side to reduce home travel stalls
+            atari_submit(gcode_line);
             break;
         case 2:
             grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Paper switch");
-            WebUI::inputBuffer.push("G0Y-25\r");
-            WebUI::inputBuffer.push("G4P0.1\r");  // sync...forces wait for planner to clear
-            sys_position[Y_AXIS] = 0.0;           // reset the Y position
+            atari_submit("G0Y-25");
+            atari_submit("G4P0.1");      // sync...forces wait for planner to clear
+            sys_position[Y_AXIS] = 0.0;  // reset the Y position
             gc_sync_position();
             plan_sync_position();
             break;
@@ -271,6 +284,6 @@ void user_defined_macro(uint8_t index) {
 
 void user_m30() {
     char gcode_line[20];
-    sprintf(gcode_line, "G90G0X%3.2f\r", ATARI_PAPER_WIDTH);  //
-    WebUI::inputBuffer.push(gcode_line);
+    sprintf(gcode_line, "G90G0X%3.2f", ATARI_PAPER_WIDTH);  //
+    atari_submit(gcode_line);
 }
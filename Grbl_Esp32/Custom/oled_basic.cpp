@@ -65,6 +65,58 @@ SSD1306Wire display(OLED_ADDRESS, OLED_SDA, OLED_SCL, OLED_GEOMETRY);
 
 static TaskHandle_t displayUpdateTaskHandle = 0;
 
+// Frame periods in ticks (typically ms). The DRO follows a jog closely, and an idle machine
+// is only looked at now and then.
+#ifndef OLED_JOG_PERIOD
+#    define OLED_JOG_PERIOD 50
+#endif
+#ifndef OLED_RUN_PERIOD
+#    define OLED_RUN_PERIOD 100
+#endif
+#ifndef OLED_IDLE_PERIOD
+#    define OLED_IDLE_PERIOD 500
+#endif
+
+// The screen is made of fields. A field is only redrawn when what it shows changes, and the
+// screen is sent after each one, so only the bytes of that field go over I2C: the library
+// keeps a copy of what it last sent and sends the bounding box of the bytes that differ.
+struct DisplayField {
+    int16_t x, y, w, h;  // The area it owns, cleared before it is drawn
+    char    shown[52];   // What it shows now
+};
+
+enum class Screen : uint8_t { None, Alarm, DRO, SD };
+static Screen screen = Screen::None;
+
+static DisplayField state_field      = { 0, 0, 55, 16 };
+static DisplayField radio_name_field = { 0, 18, 128, 12 };
+static DisplayField radio_addr_field = { 0, 30, 128, 12 };
+static DisplayField radio_side_field = { 55, 2, 73, 12 };  // Next to the state on the DRO
+static DisplayField pos_type_field   = { 0, 14, 61, 11 };
+static DisplayField axis_fields[MAX_N_AXIS];
+static DisplayField limit_fields[MAX_N_AXIS];
+static DisplayField pin_fields[5];  // Probe, hold, start, reset and door
+static DisplayField sd_ticker_field = { 0, 0, 128, 12 };
+static DisplayField sd_path_field   = { 0, 12, 128, 13 };
+static DisplayField sd_perc_field   = { 0, 25, 128, 13 };
+static DisplayField sd_bar_field    = { 0, 45, 121, 11 };
+
+// Clears the field for drawing and returns true if text is not what it shows.
+static bool field_changed(DisplayField& field, const char* text) {
+    if (!strcmp(field.shown, text)) {
+        return false;
+    }
+    strncpy(field.shown, text, sizeof(field.shown) - 1);
+    display.setColor(BLACK);
+    display.fillRect(field.x, field.y, field.w, field.h);
+    display.setColor(WHITE);
+    return true;
+}
+
+static void field_forget(DisplayField& field) {
+    field.shown[0] = '\0';
+}
+
 // This displays the status of the ESP32 Radios...BT, WiFi, etc
 void displayRadioInfo() {
     String radio_addr   = "";
@@ -98,14 +150,19 @@ void displayRadioInfo() {
     display.setFont(ArialMT_Plain_10);
 
     if (sys.state == State::Alarm) {  // print below Alarm:
-        display.drawString(0, 18, radio_name);
-        display.drawString(0, 30, radio_addr);
-
+        if (field_changed(radio_name_field, radio_name.c_str())) {
+            display.drawString(0, 18, radio_name);
+            display.display();
+        }
+        if (field_changed(radio_addr_field, radio_addr.c_str())) {
+            display.drawString(0, 30, radio_addr);
+            display.display();
+        }
     } else {  // print next to status
-        if (WebUI::wifi_radio_mode->get() == ESP_BT) {
-            display.drawString(55, 2, radio_name);
-        } else {
-            display.drawString(55, 2, radio_addr);
+        const String& side = WebUI::wifi_radio_mode->get() == ESP_BT ? radio_name : radio_addr;
+        if (field_changed(radio_side_field, side.c_str())) {
+            display.drawString(55, 2, side);
+            display.display();
         }
     }
 }
@@ -118,16 +175,59 @@ void draw_checkbox(int16_t x, int16_t y, int16_t width, int16_t height, bool che
         display.drawRect(x, y, width, height);  // If log.1
 }
 
-void displayDRO() {
-    uint8_t oled_y_pos;
-    //float   wco[MAX_N_AXIS];
-
+// The labels that do not change, drawn when the DRO screen comes up.
+static void displayDROLabels() {
     display.setTextAlignment(TEXT_ALIGN_LEFT);
     display.setFont(ArialMT_Plain_10);
+    display.drawString(80, 14, "L");  // Limit switch
 
-    char axisVal[20];
+    auto n_axis = number_axis->get();
+    for (uint8_t axis = X_AXIS; axis < n_axis; axis++) {
+        int16_t oled_y_pos  = 24 + (axis * 10);
+        String  axis_letter = String(report_get_axis_letter(axis));
+        axis_letter += ":";
+        display.drawString(0, oled_y_pos, axis_letter);  // String('X') + ":");
+        axis_fields[axis]  = { 12, int16_t(oled_y_pos + 1), 49, 10 };
+        limit_fields[axis] = { 80, int16_t(27 + (axis * 10)), 7, 7 };
+    }
 
-    display.drawString(80, 14, "L");  // Limit switch
+    // The pin checkboxes in the right column, in the order displayDRO() fills them
+    const char* pin_labels[5];
+    int         pin_count = 0;
+    if (PROBE_PIN != UNDEFINED_PIN) {
+        pin_labels[pin_count++] = "P";
+    }
+#ifdef CONTROL_FEED_HOLD_PIN
+    pin_labels[pin_count++] = "H";
+#endif
+#ifdef CONTROL_CYCLE_START_PIN
+    pin_labels[pin_count++] = "S";
+#endif
+#ifdef CONTROL_RESET_PIN
+    pin_labels[pin_count++] = "R";
+#endif
+#ifdef CONTROL_SAFETY_DOOR_PIN
+    pin_labels[pin_count++] = "D";
+#endif
+    display.setTextAlignment(TEXT_ALIGN_RIGHT);
+    for (int i = 0; i < pin_count; i++) {
+        int16_t oled_y_pos = 14 + i * 10;
+        display.drawString(110, oled_y_pos, pin_labels[i]);
+        pin_fields[i] = { 120, int16_t(oled_y_pos + 3), 7, 7 };
+    }
+}
+
+static void displayCheckbox(DisplayField& field, bool checked) {
+    if (field_changed(field, checked ? "1" : "0")) {
+        draw_checkbox(field.x, field.y, field.w, field.h, checked);
+        display.display();
+    }
+}
+
+void displayDRO() {
+    display.setFont(ArialMT_Plain_10);
+
+    char axisVal[20];
 
     auto        n_axis         = number_axis->get();
     AxisMask    lim_pin_state  = limits_get_state();
@@ -136,117 +236,152 @@ void displayDRO() {
 
     display.setTextAlignment(TEXT_ALIGN_RIGHT);
 
-    float* print_position = system_get_mpos();
-    if (bit_istrue(status_mask->get(), RtStatus::Position)) {
-        display.drawString(60, 14, "M Pos");
-    } else {
-        display.drawString(60, 14, "W Pos");
+    float*      print_position = system_get_mpos();
+    const char* pos_type       = "M Pos";
+    if (!bit_istrue(status_mask->get(), RtStatus::Position)) {
+        pos_type = "W Pos";
         mpos_to_wpos(print_position);
     }
+    if (field_changed(pos_type_field, pos_type)) {
+        display.drawString(60, 14, pos_type);
+        display.display();
+    }
 
     for (uint8_t axis = X_AXIS; axis < n_axis; axis++) {
-        oled_y_pos = 24 + (axis * 10);
+        uint8_t oled_y_pos = 24 + (axis * 10);
 
-        String axis_letter = String(report_get_axis_letter(axis));
-        axis_letter += ":";
-        display.setTextAlignment(TEXT_ALIGN_LEFT);
-        display.drawString(0, oled_y_pos, axis_letter);  // String('X') + ":");
-
-        display.setTextAlignment(TEXT_ALIGN_RIGHT);
         snprintf(axisVal, 20 - 1, "%.3f", print_position[axis]);
-        display.drawString(60, oled_y_pos, axisVal);
+        if (field_changed(axis_fields[axis], axisVal)) {
+            display.drawString(60, oled_y_pos, axisVal);
+            display.display();
+        }
 
         if (limitsSwitchDefined(axis, 0)) {  // olny draw the box if a switch has been defined
-            draw_checkbox(80, 27 + (axis * 10), 7, 7, bit_istrue(lim_pin_state, bit(axis)));
+            displayCheckbox(limit_fields[axis], bit_istrue(lim_pin_state, bit(axis)));
         }
     }
 
-    oled_y_pos = 14;
-
+    int pin = 0;
     if (PROBE_PIN != UNDEFINED_PIN) {
-        display.drawString(110, oled_y_pos, "P");
-        draw_checkbox(120, oled_y_pos + 3, 7, 7, prb_pin_state);
-        oled_y_pos += 10;
+        displayCheckbox(pin_fields[pin++], prb_pin_state);
     }
-
 #ifdef CONTROL_FEED_HOLD_PIN
-    display.drawString(110, oled_y_pos, "H");
-    draw_checkbox(120, oled_y_pos + 3, 7, 7, ctrl_pin_state.bit.feedHold);
-    oled_y_pos += 10;
+    displayCheckbox(pin_fields[pin++], ctrl_pin_state.bit.feedHold);
 #endif
-
 #ifdef CONTROL_CYCLE_START_PIN
-    display.drawString(110, oled_y_pos, "S");
-    draw_checkbox(120, oled_y_pos + 3, 7, 7, ctrl_pin_state.bit.cycleStart);
-    oled_y_pos += 10;
+    displayCheckbox(pin_fields[pin++], ctrl_pin_state.bit.cycleStart);
 #endif
-
 #ifdef CONTROL_RESET_PIN
-    display.drawString(110, oled_y_pos, "R");
-    draw_checkbox(120, oled_y_pos + 3, 7, 7, ctrl_pin_state.bit.reset);
-    oled_y_pos += 10;
+    displayCheckbox(pin_fields[pin++], ctrl_pin_state.bit.reset);
 #endif
-
 #ifdef CONTROL_SAFETY_DOOR_PIN
-    display.drawString(110, oled_y_pos, "D");
-    draw_checkbox(120, oled_y_pos + 3, 7, 7, ctrl_pin_state.bit.safetyDoor);
+    displayCheckbox(pin_fields[pin++], ctrl_pin_state.bit.safetyDoor);
 #endif
 }
 
+void displaySDProgress(uint16_t sd_file_ticker) {
+    display.setTextAlignment(TEXT_ALIGN_CENTER);
+    display.setFont(ArialMT_Plain_10);
+
+    String state_string = "SD File";
+    for (int i = 0; i < sd_file_ticker % 10; i++) {
+        state_string += ".";
+    }
+    if (field_changed(sd_ticker_field, state_string.c_str())) {
+        display.drawString(63, 0, state_string);
+        display.display();
+    }
+
+    char path[50];
+    sd_get_current_filename(path);
+    if (field_changed(sd_path_field, path)) {
+        display.drawString(63, 12, path);
+        display.display();
+    }
+
+    int  progress = sd_report_perc_complete();
+    char perc[8];
+    snprintf(perc, sizeof(perc), "%d%%", progress);
+    if (field_changed(sd_perc_field, perc)) {
+        // draw the percentage as String
+        display.drawString(64, 25, perc);
+        // draw the progress bar
+        field_changed(sd_bar_field, perc);
+        display.drawProgressBar(0, 45, 120, 10, progress);
+        display.display();
+    }
+}
+
+// Clears the screen for another layout, so every field is drawn again.
+static void displayScreen(Screen next) {
+    if (next == screen) {
+        return;
+    }
+    screen = next;
+    display.clear();
+    for (auto field : { &state_field, &radio_name_field, &radio_addr_field, &radio_side_field, &pos_type_field, &sd_ticker_field,
+                        &sd_path_field, &sd_perc_field, &sd_bar_field }) {
+        field_forget(*field);
+    }
+    for (int i = 0; i < MAX_N_AXIS; i++) {
+        field_forget(axis_fields[i]);
+        field_forget(limit_fields[i]);
+    }
+    for (auto& field : pin_fields) {
+        field_forget(field);
+    }
+    if (screen == Screen::DRO) {
+        displayDROLabels();
+    }
+    display.display();
+}
+
+static TickType_t displayPeriod() {
+    switch (sys.state) {
+        case State::Jog:
+            return OLED_JOG_PERIOD;
+        case State::Cycle:
+        case State::Homing:
+        case State::Hold:
+            return OLED_RUN_PERIOD;
+        default:
+            return OLED_IDLE_PERIOD;
+    }
+}
+
 void displayUpdate(void* pvParameters) {
-    TickType_t       xLastWakeTime;
-    const TickType_t xDisplayFrequency = 100;                  // in ticks (typically ms)
-    xLastWakeTime                      = xTaskGetTickCount();  // Initialise the xLastWakeTime variable with the current time.
+    TickType_t xLastWakeTime;
+    xLastWakeTime = xTaskGetTickCount();  // Initialise the xLastWakeTime variable with the current time.
 
     vTaskDelay(2500);
     uint16_t sd_file_ticker = 0;
 
     display.init();
     display.flipScreenVertically();
+    screen = Screen::None;
 
     while (true) {
-        display.clear();
-
-        String state_string = "";
-
-        display.setTextAlignment(TEXT_ALIGN_LEFT);
-        display.setFont(ArialMT_Plain_16);
-        display.drawString(0, 0, report_state_text());
-
         if (get_sd_state(false) == SDState::BusyPrinting) {
-            display.clear();
-            display.setTextAlignment(TEXT_ALIGN_CENTER);
-            display.setFont(ArialMT_Plain_10);
-            state_string = "SD File";
-            for (int i = 0; i < sd_file_ticker % 10; i++) {
-                state_string += ".";
+            displayScreen(Screen::SD);
+            displaySDProgress(sd_file_ticker++);
+        } else {
+            displayScreen(sys.state == State::Alarm ? Screen::Alarm : Screen::DRO);
+
+            display.setTextAlignment(TEXT_ALIGN_LEFT);
+            display.setFont(ArialMT_Plain_16);
+            const char* state = report_state_text();
+            if (field_changed(state_field, state)) {
+                display.drawString(0, 0, state);
+                display.display();
             }
-            sd_file_ticker++;
-            display.drawString(63, 0, state_string);
-
-            char path[50];
-            sd_get_current_filename(path);
-            display.drawString(63, 12, path);
-
-            int progress = sd_report_perc_complete();
-            // draw the progress bar
-            display.drawProgressBar(0, 45, 120, 10, progress);
-
-            // draw the percentage as String
-            display.setFont(ArialMT_Plain_10);
-            display.setTextAlignment(TEXT_ALIGN_CENTER);
-            display.drawString(64, 25, String(progress) + "%");
 
-        } else if (sys.state == State::Alarm) {
-            displayRadioInfo();
-        } else {
-            displayDRO();
+            if (screen == Screen::DRO) {
+                displayDRO();
+            }
             displayRadioInfo();
         }
 
-        display.display();
-
-        vTaskDelayUntil(&xLastWakeTime, xDisplayFrequency);
+        vTaskDelayUntil(&xLastWakeTime, displayPeriod());
     }
 }
 
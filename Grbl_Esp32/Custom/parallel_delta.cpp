@@ -20,6 +20,9 @@
   To make the moves straight and smooth on a delta, the cartesian moves
   are broken into small segments where the non linearity will not be noticed.
   This is similar to how Grgl draws arcs.
+  $Kinematics/SegmentLength is the longest segment. When $Kinematics/Tolerance
+  is set, moves where the arms bend the path more are split further, so the
+  segment length can be raised to save planner blocks where the path is straight.
 
   If you request MPos status it will tell you the position in
   arm angles. The MPos will report in cartesian values using forward kinematics. 
@@ -96,16 +99,26 @@ KinematicError delta_calcAngleYZ(float x0, float y0, float z0, float& theta);
 float          three_axis_dist(float* point1, float* point2);
 void           read_settings();
 
+// Cached inverse kinematics results are stale once the geometry changes.
+static bool delta_geometry_changed(char* value) {
+    if (!value) {
+        mc_kinematics_cache_clear();
+    }
+    return true;
+}
+
 void machine_init() {
     float angles[N_AXIS]    = { 0.0, 0.0, 0.0 };
     float cartesian[N_AXIS] = { 0.0, 0.0, 0.0 };
 
     // Custom $ settings
     kinematic_segment_len   = new FloatSetting(EXTENDED, WG, NULL, "Kinematics/SegmentLength", KINEMATIC_SEGMENT_LENGTH, 0.2, 1000.0);
-    delta_crank_len         = new FloatSetting(EXTENDED, WG, NULL, "Delta/CrankLength", RADIUS_FIXED, 50.0, 500.0);
-    delta_link_len          = new FloatSetting(EXTENDED, WG, NULL, "Delta/LinkLength", RADIUS_EFF, 50.0, 500.0);
-    delta_crank_side_len    = new FloatSetting(EXTENDED, WG, NULL, "Delta/CrankSideLength", LENGTH_FIXED_SIDE, 20.0, 500.0);
-    delta_effector_side_len = new FloatSetting(EXTENDED, WG, NULL, "Delta/EffectorSideLength", LENGTH_EFF_SIDE, 20.0, 500.0);
+    delta_crank_len = new FloatSetting(EXTENDED, WG, NULL, "Delta/CrankLength", RADIUS_FIXED, 50.0, 500.0, delta_geometry_changed);
+    delta_link_len  = new FloatSetting(EXTENDED, WG, NULL, "Delta/LinkLength", RADIUS_EFF, 50.0, 500.0, delta_geometry_changed);
+    delta_crank_side_len =
+        new FloatSetting(EXTENDED, WG, NULL, "Delta/CrankSideLength", LENGTH_FIXED_SIDE, 20.0, 500.0, delta_geometry_changed);
+    delta_effector_side_len =
+        new FloatSetting(EXTENDED, WG, NULL, "Delta/EffectorSideLength", LENGTH_EFF_SIDE, 20.0, 500.0, delta_geometry_changed);
 
     // Calculate the Z offset at the arm zero angles ...
     // Z offset is the z distance from the motor axes to the end effector axes at zero angle
@@ -136,9 +149,7 @@ bool cartesian_to_motors(float* target, plan_line_data_t* pl_data, float* positi
     float dx, dy, dz;  // distances in each cartesian axis
     float motor_angles[3];
 
-    float seg_target[3];                    // The target of the current segment
-    float feed_rate  = pl_data->feed_rate;  // save original feed rate
-    bool  show_error = true;                // shows error once
+    float feed_rate = pl_data->feed_rate;  // save original feed rate
 
     KinematicError status;
 
@@ -171,53 +182,68 @@ bool cartesian_to_motors(float* target, plan_line_data_t* pl_data, float* positi
     float dist = sqrt((dx * dx) + (dy * dy) + (dz * dz));
 
     // determine the number of segments we need	... round up so there is at least 1 (except when dist is 0)
-    uint32_t segment_count = ceil(dist / kinematic_segment_len->get());
+    // With $Kinematics/Tolerance set, curved parts of the workspace get more than the segment length gives
+    uint32_t segment_count = mc_kinematics_segment_count(position, target, kinematic_segment_len->get());
 
     float segment_dist = dist / ((float)segment_count);  // distance of each segment...will be used for feedrate conversion
 
-    for (uint32_t segment = 1; segment <= segment_count; segment++) {
-        // determine this segment's target
-        seg_target[X_AXIS] = position[X_AXIS] + (dx / float(segment_count) * segment);
-        seg_target[Y_AXIS] = position[Y_AXIS] + (dy / float(segment_count) * segment);
-        seg_target[Z_AXIS] = position[Z_AXIS] + (dz / float(segment_count) * segment);
-
-        // calculate the delta motor angles
-        KinematicError status = delta_calcInverse(seg_target, motor_angles);
-
-        if (status != KinematicError ::NONE) {
-            if (show_error) {
-                // grbl_msg_sendf(CLIENT_SERIAL,
-                //                MsgLevel::Info,
-                //                "Error:%d, Angs X:%4.3f Y:%4.3f Z:%4.3f",
-                //                status,
-                //                motor_angles[0],
-                //                motor_angles[1],
-                //                motor_angles[2]);
-                show_error = false;
-            }
-            return false;
-        }
-        if (pl_data->motion.rapidMotion) {
-            pl_data->feed_rate = feed_rate;
-        } else {
-            float delta_distance = three_axis_dist(motor_angles, last_angle);
-            pl_data->feed_rate   = (feed_rate * delta_distance / segment_dist);
-        }
+    float seg_targets[KINEMATICS_BATCH_SIZE][MAX_N_AXIS] = {};  // The targets of the current batch of segments
+    float seg_angles[KINEMATICS_BATCH_SIZE][MAX_N_AXIS]  = {};  // Their motor angles
 
-        // mc_line() returns false if a jog is cancelled.
-        // In that case we stop sending segments to the planner.
-        if (!mc_line(motor_angles, pl_data)) {
-            return false;
+    for (uint32_t segment = 1; segment <= segment_count;) {
+        // determine the targets of the next batch of segments
+        uint8_t batch = MIN(segment_count - segment + 1, KINEMATICS_BATCH_SIZE);
+        for (uint8_t i = 0; i < batch; i++) {
+            seg_targets[i][X_AXIS] = position[X_AXIS] + (dx / float(segment_count) * (segment + i));
+            seg_targets[i][Y_AXIS] = position[Y_AXIS] + (dy / float(segment_count) * (segment + i));
+            seg_targets[i][Z_AXIS] = position[Z_AXIS] + (dz / float(segment_count) * (segment + i));
         }
 
-        // save angles for next distance calc
-        // This is after mc_line() so that we do not update
-        // last_angle if the segment was discarded.
-        memcpy(last_angle, motor_angles, sizeof(motor_angles));
+        // calculate the delta motor angles for the whole batch
+        uint8_t reachable = cartesian_to_motors_batch(seg_targets, seg_angles, batch);
+
+        for (uint8_t i = 0; i < batch; i++, segment++) {
+            if (i >= reachable) {
+                return false;
+            }
+            float* angles = seg_angles[i];
+            if (pl_data->motion.rapidMotion) {
+                pl_data->feed_rate = feed_rate;
+            } else {
+                float delta_distance = three_axis_dist(angles, last_angle);
+                pl_data->feed_rate   = (feed_rate * delta_distance / segment_dist);
+            }
+
+            // mc_line() returns false if a jog is cancelled.
+            // In that case we stop sending segments to the planner.
+            if (!mc_line(angles, pl_data)) {
+                return false;
+            }
+
+            // save angles for next distance calc
+            // This is after mc_line() so that we do not update
+            // last_angle if the segment was discarded.
+            memcpy(last_angle, angles, sizeof(last_angle));
+        }
     }
     return true;
 }
 
+// Inverse kinematics for a batch of segment targets. Stops at the first unreachable one.
+// Results are reused from the kinematics cache when $Kinematics/CacheTolerance is set.
+uint8_t cartesian_to_motors_batch(float cartesian[][MAX_N_AXIS], float motors[][MAX_N_AXIS], uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (mc_kinematics_cache_lookup(cartesian[i], motors[i])) {
+            continue;
+        }
+        if (delta_calcInverse(cartesian[i], motors[i]) != KinematicError::NONE) {
+            return i;
+        }
+        mc_kinematics_cache_store(cartesian[i], motors[i]);
+    }
+    return count;
+}
+
 // this is used used by Grbl soft limits to see if the range of the machine is exceeded.
 bool limitsCheckTravel(float* target) {
     float motor_angles[3];
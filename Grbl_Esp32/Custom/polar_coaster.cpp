@@ -223,13 +223,13 @@ float abs_angle(float ang) {
 void user_defined_macro(uint8_t index) {
     switch (index) {
         case 0:
-            WebUI::inputBuffer.push("$H\r");  // home machine
+            command_submit("$H", CLIENT_INPUT);  // home machine
             break;
         case 1:
-            WebUI::inputBuffer.push("[ESP220]/1.nc\r");  // run SD card file 1.nc
+            command_submit("[ESP220]/1.nc", CLIENT_INPUT);  // run SD card file 1.nc
             break;
         case 2:
-            WebUI::inputBuffer.push("[ESP220]/2.nc\r");  // run SD card file 2.nc
+            command_submit("[ESP220]/2.nc", CLIENT_INPUT);  // run SD card file 2.nc
             break;
         default:
             break;
@@ -238,5 +238,5 @@ void user_defined_macro(uint8_t index) {
 
 // handle the M30 command
 void user_m30() {
-    WebUI::inputBuffer.push("$H\r");
+    command_submit("$H", CLIENT_INPUT);
 }
@@ -0,0 +1,62 @@
+/*
+  AdaptiveFeed.cpp - Feed scaled to hold the spindle load, from the output current of the VFD
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The scale is a second feed override, multiplied with the one of the realtime commands, so
+  the operator keeps theirs. It goes through the same path: a higher feed is taken by the
+  segment generator for the executing block, a lower one replans. The control is integral,
+  one step per reading, as the readings come slowly over RS485 and are noisy. It only moves
+  during feed moves that cut, so rapids and moves in the air do not wind it up.
+*/
+
+#include "Grbl.h"
+
+static float    scale = FeedOverride::Default;  // Kept in fractions, applied in whole percent
+static uint32_t last_readings;
+static float    last_load = -1.0f;
+
+bool adaptive_feed_wants_load() {
+    return spindle_adaptive_enable->get() && sys.state == State::Cycle && gc_state.modal.spindle != SpindleState::Disable;
+}
+
+static bool adaptive_feed_cutting(float load) {
+    plan_block_t* block = plan_get_current_block();
+    return block && !block->motion.rapidMotion && !block->motion.noFeedOverride && load > spindle_adaptive_idle->get();
+}
+
+void adaptive_feed_poll() {
+    if (!adaptive_feed_wants_load()) {
+        scale             = FeedOverride::Default;
+        sys_rt_f_adaptive = FeedOverride::Default;
+        return;
+    }
+    float    load;
+    uint32_t readings;
+    if (!spindle->get_load(load, readings) || readings == last_readings) {
+        return;
+    }
+    last_readings = readings;
+    last_load     = load;
+    if (!adaptive_feed_cutting(load)) {
+        return;
+    }
+    float target = spindle_adaptive_target->get();
+    scale += spindle_adaptive_gain->get() * 100.0f * (target - load) / target;
+    scale             = constrain(scale, float(spindle_adaptive_min->get()), float(spindle_adaptive_max->get()));
+    sys_rt_f_adaptive = Percent(lroundf(scale));
+}
+
+float adaptive_feed_load() {
+    return last_load;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+/*
+  AdaptiveFeed.h - Feed scaled to hold the spindle load, from the output current of the VFD
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdint>
+
+// True while $Spindle/Adaptive/Enable is on and a job runs with the spindle on, when the VFD
+// task should read the output current as often as it can. Called from the VFD task.
+bool adaptive_feed_wants_load();
+
+// Takes each new load reading and moves sys_rt_f_adaptive towards the feed that holds
+// $Spindle/Adaptive/Target, within $Spindle/Adaptive/Min and Max. Back at 100% when not
+// cutting. Called from the realtime loop, before the overrides are applied.
+void adaptive_feed_poll();
+
+// The last load reading in amps, or a negative value if there is none.
+float adaptive_feed_load();
@@ -0,0 +1,273 @@
+/*
+  AxisEncoder.cpp - Lost step detection with quadrature encoders on the axes
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  Each axis encoder counts on its own PCNT unit, after the spindle encoder's unit 0. The task
+  reads the 16 bit counters often enough that they cannot move half their range in between,
+  so it unwraps them without an interrupt.
+
+  A correction moves the step position onto the encoder position at the start of the next
+  block, in the stepper ISR, which owns the step position. The planner then moves its
+  position by what the steppers took, before it plans the next line. The lines already
+  queued are relative, so they end up where they would have without the lost steps, and
+  the first line planned afterwards makes them up.
+*/
+
+#include "Grbl.h"
+
+#ifdef AXIS_ENCODERS
+
+#    include <driver/pcnt.h>
+#    include <atomic>
+
+#    ifndef X_ENCODER_A_PIN
+#        define X_ENCODER_A_PIN UNDEFINED_PIN
+#    endif
+#    ifndef X_ENCODER_B_PIN
+#        define X_ENCODER_B_PIN UNDEFINED_PIN
+#    endif
+#    ifndef Y_ENCODER_A_PIN
+#        define Y_ENCODER_A_PIN UNDEFINED_PIN
+#    endif
+#    ifndef Y_ENCODER_B_PIN
+#        define Y_ENCODER_B_PIN UNDEFINED_PIN
+#    endif
+#    ifndef Z_ENCODER_A_PIN
+#        define Z_ENCODER_A_PIN UNDEFINED_PIN
+#    endif
+#    ifndef Z_ENCODER_B_PIN
+#        define Z_ENCODER_B_PIN UNDEFINED_PIN
+#    endif
+#    ifndef A_ENCODER_A_PIN
+#        define A_ENCODER_A_PIN UNDEFINED_PIN
+#    endif
+#    ifndef A_ENCODER_B_PIN
+#        define A_ENCODER_B_PIN UNDEFINED_PIN
+#    endif
+#    ifndef B_ENCODER_A_PIN
+#        define B_ENCODER_A_PIN UNDEFINED_PIN
+#    endif
+#    ifndef B_ENCODER_B_PIN
+#        define B_ENCODER_B_PIN UNDEFINED_PIN
+#    endif
+#    ifndef C_ENCODER_A_PIN
+#        define C_ENCODER_A_PIN UNDEFINED_PIN
+#    endif
+#    ifndef C_ENCODER_B_PIN
+#        define C_ENCODER_B_PIN UNDEFINED_PIN
+#    endif
+
+static const uint8_t encoder_a_pins[MAX_N_AXIS] = { X_ENCODER_A_PIN, Y_ENCODER_A_PIN, Z_ENCODER_A_PIN,
+                                                    A_ENCODER_A_PIN, B_ENCODER_A_PIN, C_ENCODER_A_PIN };
+static const uint8_t encoder_b_pins[MAX_N_AXIS] = { X_ENCODER_B_PIN, Y_ENCODER_B_PIN, Z_ENCODER_B_PIN,
+                                                    A_ENCODER_B_PIN, B_ENCODER_B_PIN, C_ENCODER_B_PIN };
+
+static const int16_t  AXIS_ENCODER_LIMIT  = 30000;
+static const uint16_t AXIS_ENCODER_FILTER = 100;  // APB clock cycles, glitches shorter than this are ignored
+
+static uint8_t encoder_axes = 0;  // Axes with a working encoder
+static int16_t encoder_counter[MAX_N_AXIS];
+static int64_t encoder_count[MAX_N_AXIS];   // Unwrapped
+static float   encoder_origin[MAX_N_AXIS];  // Machine position in mm at count 0
+
+static volatile float encoder_error[MAX_N_AXIS];
+
+static std::atomic<int32_t> steps_pending[MAX_N_AXIS];  // Decided on, for the stepper ISR
+static std::atomic<int32_t> steps_taken[MAX_N_AXIS];    // Made by the stepper ISR, in total
+static int32_t              planner_taken[MAX_N_AXIS];  // Of steps_taken, moved into the planner position
+
+static pcnt_unit_t encoder_unit(uint8_t axis) {
+    return pcnt_unit_t(PCNT_UNIT_1 + axis);
+}
+
+static void axis_encoder_read(uint8_t axis) {
+    int16_t counter;
+    pcnt_get_counter_value(encoder_unit(axis), &counter);
+    // At either limit the counter starts over from 0, so crossing it looks like a jump by the limit
+    int32_t delta = counter - encoder_counter[axis];
+    if (delta > AXIS_ENCODER_LIMIT / 2) {
+        delta -= AXIS_ENCODER_LIMIT;
+    } else if (delta < -AXIS_ENCODER_LIMIT / 2) {
+        delta += AXIS_ENCODER_LIMIT;
+    }
+    encoder_counter[axis] = counter;
+    encoder_count[axis] += delta;
+}
+
+// Makes the encoder position the machine position, after homing has set it
+static void axis_encoder_reference(const int32_t* position) {
+    for (uint8_t axis = 0; axis < MAX_N_AXIS; axis++) {
+        if (bitnum_istrue(encoder_axes, axis)) {
+            steps_pending[axis]  = 0;
+            encoder_origin[axis] = position[axis] / axis_settings[axis]->steps_per_mm->get() -
+                                   encoder_count[axis] / axis_settings[axis]->encoder_counts_per_mm->get();
+        }
+    }
+}
+
+static void axisEncoderTask(void* pvParameters) {
+    TickType_t       xLastWakeTime;
+    const TickType_t xCheck     = ENCODER_CHECK_MS;  // in ticks (typically ms)
+    State            last_state = sys.state;
+    int32_t          position[MAX_N_AXIS];
+
+    xLastWakeTime = xTaskGetTickCount();  // Initialise the xLastWakeTime variable with the current time.
+    while (true) {                        // don't ever return from this or the task dies
+        st_get_position(position);
+        for (uint8_t axis = 0; axis < MAX_N_AXIS; axis++) {
+            if (bitnum_istrue(encoder_axes, axis)) {
+                axis_encoder_read(axis);
+            }
+        }
+        if (last_state == State::Homing && sys.state != State::Homing) {
+            axis_encoder_reference(position);
+        }
+        last_state = sys.state;
+
+        float         tolerance = encoder_tolerance->get();
+        EncoderAction action    = static_cast<EncoderAction>(encoder_action->get());
+        bool          moving    = sys.state == State::Cycle || sys.state == State::Jog || sys.state == State::Hold;
+        for (uint8_t axis = 0; axis < MAX_N_AXIS; axis++) {
+            if (!bitnum_istrue(encoder_axes, axis)) {
+                continue;
+            }
+            float steps_per_mm  = axis_settings[axis]->steps_per_mm->get();
+            float encoder_mpos  = encoder_origin[axis] + encoder_count[axis] / axis_settings[axis]->encoder_counts_per_mm->get();
+            float error         = position[axis] / steps_per_mm - encoder_mpos;
+            encoder_error[axis] = error;
+
+            if (!moving || tolerance == 0.0 || fabsf(error) <= tolerance || steps_pending[axis] != 0) {
+                continue;
+            }
+            switch (action) {
+                case EncoderAction::Report:
+                    break;
+                case EncoderAction::Hold:
+                    if (sys.state != State::Hold) {
+                        grbl_msg_sendf(CLIENT_ALL, MsgLevel::Error, "%c following error %.3fmm", report_get_axis_letter(axis), error);
+                        sys_rt_exec_state.bit.feedHold = true;
+                    }
+                    break;
+                case EncoderAction::Alarm:
+                    if (sys_rt_exec_alarm == ExecAlarm::None) {
+                        grbl_msg_sendf(CLIENT_ALL, MsgLevel::Error, "%c following error %.3fmm", report_get_axis_letter(axis), error);
+                        mc_reset();
+                        sys_rt_exec_alarm = ExecAlarm::FollowingError;
+                    }
+                    break;
+                case EncoderAction::Correct:
+                    grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "%c corrected by %.3fmm", report_get_axis_letter(axis), -error);
+                    steps_pending[axis] = lroundf(-error * steps_per_mm);
+                    break;
+            }
+        }
+
+        vTaskDelayUntil(&xLastWakeTime, xCheck);
+
+        static UBaseType_t uxHighWaterMark = 0;
+#    ifdef DEBUG_TASK_STACK
+        reportTaskStackSize(uxHighWaterMark);
+#    endif
+    }
+}
+
+void axis_encoder_following_error(float* error) {
+    for (uint8_t axis = 0; axis < MAX_N_AXIS; axis++) {
+        error[axis] = bitnum_istrue(encoder_axes, axis) ? encoder_error[axis] : 0.0;
+    }
+}
+
+void IRAM_ATTR axis_encoder_correct_steps(int32_t* position) {
+    for (uint8_t axis = 0; axis < MAX_N_AXIS; axis++) {
+        if (steps_pending[axis] != 0) {
+            int32_t steps = steps_pending[axis].exchange(0);
+            position[axis] += steps;
+            steps_taken[axis] += steps;
+        }
+    }
+}
+
+void axis_encoder_correct_planner(int32_t* position) {
+    for (uint8_t axis = 0; axis < MAX_N_AXIS; axis++) {
+        int32_t taken = steps_taken[axis];
+        if (position) {
+            position[axis] += taken - planner_taken[axis];
+        }
+        planner_taken[axis] = taken;
+    }
+}
+
+void axis_encoder_init() {
+    auto n_axis = number_axis->get();
+    for (uint8_t axis = 0; axis < n_axis; axis++) {
+        if (encoder_a_pins[axis] == UNDEFINED_PIN || encoder_b_pins[axis] == UNDEFINED_PIN ||
+            axis_settings[axis]->encoder_counts_per_mm->get() == 0.0) {
+            continue;
+        }
+
+        // Both edges of both channels: A counts with B as its direction and the other way round.
+        pcnt_config_t config  = {};
+        config.pulse_gpio_num = encoder_a_pins[axis];
+        config.ctrl_gpio_num  = encoder_b_pins[axis];
+        config.channel        = PCNT_CHANNEL_0;
+        config.unit           = encoder_unit(axis);
+        config.pos_mode       = PCNT_COUNT_DEC;
+        config.neg_mode       = PCNT_COUNT_INC;
+        config.lctrl_mode     = PCNT_MODE_KEEP;
+        config.hctrl_mode     = PCNT_MODE_REVERSE;
+        config.counter_h_lim  = AXIS_ENCODER_LIMIT;
+        config.counter_l_lim  = -AXIS_ENCODER_LIMIT;
+        pcnt_unit_config(&config);
+
+        config.pulse_gpio_num = encoder_b_pins[axis];
+        config.ctrl_gpio_num  = encoder_a_pins[axis];
+        config.channel        = PCNT_CHANNEL_1;
+        config.pos_mode       = PCNT_COUNT_INC;
+        config.neg_mode       = PCNT_COUNT_DEC;
+        pcnt_unit_config(&config);
+
+        pcnt_set_filter_value(encoder_unit(axis), AXIS_ENCODER_FILTER);
+        pcnt_filter_enable(encoder_unit(axis));
+        pcnt_counter_pause(encoder_unit(axis));
+        pcnt_counter_clear(encoder_unit(axis));
+        pcnt_counter_resume(encoder_unit(axis));
+
+        bitnum_true(encoder_axes, axis);
+        grbl_msg_sendf(CLIENT_SERIAL,
+                       MsgLevel::Info,
+                       "%c encoder A:%s B:%s %.3f counts/mm",
+                       report_get_axis_letter(axis),
+                       pinName(encoder_a_pins[axis]).c_str(),
+                       pinName(encoder_b_pins[axis]).c_str(),
+                       axis_settings[axis]->encoder_counts_per_mm->get());
+    }
+    if (encoder_axes == 0) {
+        return;
+    }
+
+    int32_t position[MAX_N_AXIS];
+    st_get_position(position);
+    axis_encoder_reference(position);
+
+    heap_task_create(axisEncoderTask,    // task
+                     "axisEncoderTask",  // name for task
+                     4096,               // size of task stack
+                     NULL,               // parameters
+                     1,                  // priority
+                     NULL,               // handle
+                     SUPPORT_TASK_CORE   // core
+    );
+}
+
+#endif
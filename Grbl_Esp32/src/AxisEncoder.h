@@ -0,0 +1,52 @@
+#pragma once
+
+/*
+  AxisEncoder.h - Lost step detection with quadrature encoders on the axes
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdint>
+
+#ifdef AXIS_ENCODERS
+
+// What happens when an axis is further than $Encoder/Tolerance from its encoder while moving
+enum class EncoderAction : int8_t {
+    Report  = 0,  // Only show it in the status report
+    Hold    = 1,  // Feed hold
+    Alarm   = 2,  // Reset with ExecAlarm::FollowingError, since the position is lost
+    Correct = 3,  // Take the encoder position as the machine position at the next block
+};
+
+// How often the encoders are compared with the machine position
+#    ifndef ENCODER_CHECK_MS
+#        define ENCODER_CHECK_MS 5
+#    endif
+
+// Starts counting on a PCNT unit for every axis with encoder pins and $<axis>/Encoder/CountsPerMm,
+// and the task that follows them. The encoders start out at the machine position.
+void axis_encoder_init();
+
+// Per axis, mm from the encoder position to the stepper position, 0 for axes without an encoder.
+void axis_encoder_following_error(float* error);
+
+// Called by the stepper ISR at the start of a block. Adds the corrections that Correct has
+// decided on to the step position.
+void axis_encoder_correct_steps(int32_t* position);
+
+// Called by the planner before a line. Adds the corrections that the steppers have made since
+// the last call to the planner position. With NULL, after the planner position has been synced
+// to the stepper position, only marks them as taken.
+void axis_encoder_correct_planner(int32_t* position);
+
+#endif
@@ -0,0 +1,262 @@
+/*
+  Bench.cpp - Throughput of the parser, planner and segment generator on the machine
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The lines go through gc_execute_line() one after the other, as $HeightMap/Probe sends its
+  moves, so neither the host link nor the input buffers are timed. Only the time spent running
+  the lines counts, not reading them from the card. The stages that run no steppers keep the
+  planner full, the way a job streamed faster than the machine moves does: bench_drain() is
+  called from protocol_auto_cycle_start() when a line needs room, and from the wait in
+  protocol_buffer_synchronize(). It drops the oldest block, or preps and drops segments.
+
+  No stage moves the machine. The gang mode stops every step pulse, even if a cycle start
+  comes in mid run, the spindle is swapped for a null one and the coolant is left as it was.
+  Files with G10, G28.1 or G30.1 still store their offsets, and probing will fail.
+*/
+
+#include "Grbl.h"
+#include "Spindles/NullSpindle.h"
+
+// The built-in program is this many passes of a 10mm circle in short chords, as CAM output
+// has it, then the same circle as one G2 and a rapid out and back.
+static const int BENCH_PASSES = 8;
+static const int BENCH_CHORDS = 72;
+
+static BenchStage     bench_stage = BenchStage::None;
+static Spindles::Null null_spindle;   // Stands in for the spindle during a run
+static float          bench_planned;  // Seconds of motion in the blocks dropped by the plan stage
+
+typedef struct {
+    uint32_t        index;   // Lines read so far
+    BenchLineReader reader;  // Where the lines come from, if not the card or the built-in program
+#ifdef ENABLE_SD_CARD
+    File file;
+    bool sd;
+#endif
+} bench_source_t;
+
+// Line index of the built-in program, false past its end.
+static bool bench_program_line(uint32_t index, char* line, size_t size) {
+    const uint32_t pass_lines = BENCH_CHORDS + 3;
+    if (index == 0) {
+        snprintf(line, size, "G21G17G90G94G0F3000");
+        return true;
+    }
+    index--;
+    if (index == BENCH_PASSES * pass_lines) {
+        snprintf(line, size, "G90");
+        return true;
+    }
+    if (index > BENCH_PASSES * pass_lines) {
+        return false;
+    }
+    uint32_t step = index % pass_lines;
+    if (step < BENCH_CHORDS) {
+        float a0 = 2 * M_PI * step / BENCH_CHORDS;
+        float a1 = 2 * M_PI * (step + 1) / BENCH_CHORDS;
+        snprintf(line, size, "G91G1X%.4fY%.4f", 5 * (cosf(a1) - cosf(a0)), 5 * (sinf(a1) - sinf(a0)));
+    } else if (step == BENCH_CHORDS) {
+        snprintf(line, size, "G2X0Y0I-5J0");
+    } else if (step == BENCH_CHORDS + 1) {
+        snprintf(line, size, "G0X2Y2");
+    } else {
+        snprintf(line, size, "X-2Y-2");
+    }
+    return true;
+}
+
+static bool bench_read_line(bench_source_t* source, char* line, size_t size) {
+    if (source->reader) {
+        if (!source->reader(line, size)) {
+            return false;
+        }
+        source->index++;
+        return true;
+    }
+#ifdef ENABLE_SD_CARD
+    if (source->sd) {
+        if (!source->file.available()) {
+            return false;
+        }
+        size_t len = 0;
+        int    c;
+        while ((c = source->file.read()) >= 0 && c != '\n') {
+            if (c != '\r' && len < size - 1) {
+                line[len++] = c;
+            }
+        }
+        line[len] = '\0';
+        source->index++;
+        return true;
+    }
+#endif
+    return bench_program_line(source->index++, line, size);
+}
+
+float bench_planned_time() {
+    return bench_planned;
+}
+
+bool bench_active() {
+    return bench_stage != BenchStage::None;
+}
+
+bool bench_drain() {
+    if (sys.state != State::Idle) {
+        return false;  // Started by a cycle start from the user, the buffers belong to the stepper now
+    }
+    switch (bench_stage) {
+        case BenchStage::Plan:
+            if (plan_get_current_block() != NULL) {
+                bench_planned += plan_get_block_time(plan_get_current_block());
+            }
+            plan_discard_current_block();
+            return true;
+        case BenchStage::Prep:
+            st_prep_buffer();
+            st_discard_segments();
+            return true;
+        default:
+            return false;
+    }
+}
+
+// What protocol_main_loop() does between lines. Cycles start only in a dry run.
+static void bench_loop_pass() {
+    mc_continue_arc();
+    plan_idle_recalculate();
+    if (plan_get_block_buffer_count() <= 1) {
+        mc_flush_fitted_lines();
+        mc_flush_merged_line();
+    }
+    if (bench_stage == BenchStage::DryRun) {
+        protocol_auto_cycle_start();
+    }
+    protocol_execute_realtime();
+}
+
+static Error bench_run_source(BenchStage stage, bench_source_t& source, uint8_t client) {
+    static const char* names[] = { "", "Parse", "Plan", "Prep", "DryRun" };
+
+    parser_state_t     modes        = gc_state;
+    PlannerStats       stats        = plan_stats;
+    Spindles::Spindle* real_spindle = spindle;
+    int32_t            position[MAX_N_AXIS];
+    memcpy(position, sys_position, sizeof(position));
+
+    bench_stage   = stage;
+    bench_planned = 0.0f;
+    ganged_mode   = SquaringMode::None;
+    spindle       = &null_spindle;
+    if (stage == BenchStage::Parse) {
+        sys.state = State::CheckMode;
+    }
+
+    char     line[LINE_BUFFER_SIZE];
+    uint32_t errors   = 0;
+    uint32_t blocks   = plan_stats.blocks;
+    uint32_t segments = st_get_segment_count();
+    int64_t  busy_us  = 0;
+    while (!sys.abort && bench_read_line(&source, line, sizeof(line))) {
+        int64_t start = esp_timer_get_time();
+        if (line[0] != '\0' && line[0] != '$' && line[0] != '[' && gc_execute_line(line, client) != Error::Ok) {
+            errors++;
+        }
+        bench_loop_pass();
+        busy_us += esp_timer_get_time() - start;
+    }
+    int64_t start = esp_timer_get_time();
+    protocol_buffer_synchronize();
+    busy_us += esp_timer_get_time() - start;
+    blocks   = plan_stats.blocks - blocks;
+    segments = st_get_segment_count() - segments;
+
+#ifdef ENABLE_SD_CARD
+    if (source.sd) {
+        source.file.close();
+        set_sd_state(SDState::Idle);
+    }
+#endif
+    bench_stage = BenchStage::None;
+    ganged_mode = SquaringMode::Dual;
+    spindle     = real_spindle;
+    if (sys.state == State::CheckMode) {
+        sys.state = State::Idle;
+    }
+    // Nothing moved, so the position the steps were counted from still holds.
+    plan_reset();
+    st_reset();
+    memcpy(sys_position, position, sizeof(position));
+    gc_state   = modes;
+    plan_stats = stats;
+    plan_sync_position();
+    gc_sync_position();
+
+    if (sys.abort) {
+        return Error::Ok;
+    }
+    float seconds = busy_us / 1e6;
+    if (seconds <= 0) {
+        seconds = 1e-6;
+    }
+    grbl_sendf(client,
+               "[MSG: Bench %s: %u lines, %u errors, %u blocks, %u segments in %.3f s. %.0f lines/s, %.0f blocks/s, "
+               "%.0f segments/s, %.0f cycles/line]\r\n",
+               names[int(stage)],
+               source.index,
+               errors,
+               blocks,
+               segments,
+               seconds,
+               source.index / seconds,
+               blocks / seconds,
+               segments / seconds,
+               source.index ? double(busy_us) * getCpuFrequencyMhz() / source.index : 0.0);
+    if (stage == BenchStage::Plan) {
+        grbl_sendf(client, "[MSG: Bench Plan: %.1f s of motion as planned]\r\n", bench_planned);
+    }
+    return Error::Ok;
+}
+
+Error bench_run(BenchStage stage, const char* path, uint8_t client) {
+    if (sys.state != State::Idle) {
+        return Error::IdleError;
+    }
+    bench_source_t source = {};
+    if (path) {
+#ifdef ENABLE_SD_CARD
+        if (get_sd_state(true) != SDState::Idle) {
+            return Error::FsFailedMount;
+        }
+        source.file = sd_fs().open(path[0] == '/' ? path : (String("/") + path).c_str());
+        if (!source.file) {
+            return Error::FsFailedOpenFile;
+        }
+        source.sd = true;
+        set_sd_state(SDState::BusyParsing);
+#else
+        return Error::InvalidValue;
+#endif
+    }
+    return bench_run_source(stage, source, client);
+}
+
+Error bench_run_lines(BenchStage stage, BenchLineReader reader, uint8_t client) {
+    if (sys.state != State::Idle) {
+        return Error::IdleError;
+    }
+    bench_source_t source = {};
+    source.reader         = reader;
+    return bench_run_source(stage, source, client);
+}
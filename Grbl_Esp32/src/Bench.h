@@ -0,0 +1,54 @@
+#pragma once
+
+/*
+  Bench.h - Throughput of the parser, planner and segment generator on the machine
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Error.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// How far down the motion pipeline a bench run takes its lines.
+enum class BenchStage : uint8_t {
+    None = 0,
+    Parse,   // Parser only, as in check mode
+    Plan,    // Parser and planner, the oldest block is dropped whenever the planner is full
+    Prep,    // Parser, planner and segment generator, the segments are dropped unexecuted
+    DryRun,  // The whole job in real time, with no step pulses, spindle or coolant
+};
+
+// Runs the built-in program, or the SD file at path if it is not null, through stage and
+// reports lines, blocks and segments per second and CPU cycles per line. The machine
+// position, the parser modes and the planner statistics are put back afterwards.
+// The plan stage also reports how long the motion takes at the planned speeds, which makes
+// it an estimate of the run time with the override settings in force.
+Error bench_run(BenchStage stage, const char* path, uint8_t client);
+
+// Reads the next line into line, false at the end.
+typedef bool (*BenchLineReader)(char* line, size_t size);
+
+// Runs the lines reader gives, as bench_run() does a file. The host simulation's -e uses it.
+Error bench_run_lines(BenchStage stage, BenchLineReader reader, uint8_t client);
+
+// Seconds of motion the last plan stage planned.
+float bench_planned_time();
+
+// True while a bench run is going, when the spindle and coolant outputs are held off.
+bool bench_active();
+
+// Called where the motion would be started. Takes what the planner and segment buffers hold
+// instead, for the stages that run no steppers, and returns true if it did.
+bool bench_drain();
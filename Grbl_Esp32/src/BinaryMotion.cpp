@@ -0,0 +1,280 @@
+/*
+  BinaryMotion.cpp - Packed binary motion records streamed alongside text G-code
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  Frames travel through the same client buffers as text, so they keep their order with the
+  lines around them and use the same ok based flow control. The client task only tracks frame
+  boundaries, so that payload bytes are not mistaken for realtime commands. The main loop
+  collects and executes the frames, going straight to cartesian_to_motors() and mc_arc()
+  with the targets converted as gc_execute_line() would for G90 G21 G94 moves.
+*/
+
+#include "Grbl.h"
+
+#ifdef RASTER_ENGRAVING
+const int BINARY_RECEIVE_MAX = BINARY_RASTER_MAX;
+#else
+const int BINARY_RECEIVE_MAX = BINARY_FRAME_MAX;
+#endif
+
+static volatile bool enabled[CLIENT_COUNT];
+
+// Client task side. skip counts the bytes left in the frame, including the checksum.
+typedef struct {
+    bool     length_next;
+    uint16_t skip;
+} frame_tracker_t;
+static frame_tracker_t tracker[CLIENT_COUNT];
+
+// Main loop side
+typedef struct {
+    bool     active;
+    bool     ready;
+    int16_t  length;  // Payload length from the header, -1 until it has been read
+    uint16_t count;   // Bytes received after the length
+    uint8_t  data[BINARY_RECEIVE_MAX + 1];
+} frame_t;
+static frame_t frames[CLIENT_COUNT];
+
+void binary_motion_enable(uint8_t client, bool enable) {
+    if (client < CLIENT_COUNT) {
+        enabled[client] = enable;
+    }
+}
+
+bool binary_motion_in_frame(uint8_t client, uint8_t data) {
+    frame_tracker_t* t = &tracker[client];
+    if (t->length_next) {
+        t->length_next = false;
+        t->skip        = data + 1;
+        return true;
+    }
+    if (t->skip) {
+        t->skip--;
+        return true;
+    }
+    if (enabled[client] && data == BINARY_FRAME_START) {
+        t->length_next = true;
+        return true;
+    }
+    return false;
+}
+
+bool binary_motion_receive(uint8_t client, uint8_t data) {
+    frame_t* f = &frames[client];
+    if (!f->active) {
+        // In text mode the client task never buffers bytes above 0x7F, so this can only be the
+        // start of a frame, even if binary mode has been turned off since it was received.
+        if (data != BINARY_FRAME_START) {
+            return false;
+        }
+        f->active = true;
+        f->length = -1;
+        f->count  = 0;
+        return true;
+    }
+    if (f->length < 0) {
+        f->length = data;
+        return true;
+    }
+    if (f->count < sizeof(f->data)) {
+        f->data[f->count] = data;
+    }
+    if (++f->count == f->length + 1) {
+        f->active = false;
+        f->ready  = true;
+    }
+    return true;
+}
+
+bool binary_motion_ready(uint8_t client) {
+    return frames[client].ready;
+}
+
+static int32_t read_int32(const uint8_t* p) {
+    return (int32_t)(p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+#ifdef RASTER_ENGRAVING
+// Queues a raster line, a checked payload of BINARY_RASTER_TYPE.
+static Error binary_motion_raster(int16_t length, const uint8_t* data) {
+    if (!spindle->inLaserMode()) {
+        return Error::RasterNotLaserMode;
+    }
+    uint8_t axis   = data[1];
+    float   feed   = (uint32_t)read_int32(data + 2) / BINARY_FEED_SCALE;
+    float   pitch  = read_int32(data + 6) / BINARY_POSITION_SCALE;
+    int16_t pixels = length - 10;
+    if (axis >= number_axis->get() || pixels < 1 || pitch == 0.0) {
+        return Error::BinaryFrameInvalid;
+    }
+    if (feed <= 0.0) {
+        return Error::GcodeUndefinedFeedRate;
+    }
+
+    float target[MAX_N_AXIS];
+    memcpy(target, gc_state.position, sizeof(target));
+    target[axis] += pitch * pixels;
+    if (sys.state == State::CheckMode) {
+        memcpy(gc_state.position, target, sizeof(target));  // Nothing would use up the stored line
+        return Error::Ok;
+    }
+
+    plan_line_data_t pl_data;
+    memset(&pl_data, 0, sizeof(plan_line_data_t));
+    pl_data.spindle       = gc_state.modal.spindle;
+    pl_data.coolant       = gc_state.modal.coolant;
+    pl_data.spindle_speed = gc_state.spindle_speed;
+    pl_data.feed_rate     = feed;
+    pl_data.raster_pixels = pixels;
+    pl_data.raster_line   = raster_store(data + 10, pixels);
+    if (pl_data.raster_line == 0) {
+        return Error::Ok;  // Reset while waiting, so the line is dropped like any other motion
+    }
+    cartesian_to_motors(target, &pl_data, gc_state.position);
+    memcpy(gc_state.position, target, sizeof(target));
+    return Error::Ok;
+}
+#endif
+
+// data is the payload followed by the checksum.
+static Error binary_motion_run(int16_t length, const uint8_t* data, bool set_modes) {
+    if (length > BINARY_RECEIVE_MAX || length < 6) {
+        return Error::BinaryFrameInvalid;
+    }
+    uint8_t sum = 0;
+    for (int i = 0; i < length; i++) {
+        sum += data[i];
+    }
+    if ((uint8_t)~sum != data[length]) {
+        return Error::BinaryFrameInvalid;
+    }
+    // Same restrictions as for G-code lines
+    if (sys.state == State::Alarm || sys.state == State::Jog) {
+        return Error::SystemGcLock;
+    }
+#ifdef RASTER_ENGRAVING
+    if (data[0] == BINARY_RASTER_TYPE) {
+        return binary_motion_raster(length, data);
+    }
+#endif
+    if (length > BINARY_FRAME_MAX) {
+        return Error::BinaryFrameInvalid;
+    }
+
+    const uint8_t* p      = data;
+    uint8_t        type   = *p++;
+    uint8_t        mask   = *p++;
+    float          feed   = (uint32_t)read_int32(p) / BINARY_FEED_SCALE;
+    auto           n_axis = number_axis->get();
+    p += 4;
+    if (type > 3 || (mask >> n_axis)) {
+        return Error::BinaryFrameInvalid;
+    }
+    bool    is_arc = type >= 2;
+    uint8_t needed = 6 + 4 * (__builtin_popcount(mask) + (is_arc ? 2 : 0));
+    if (length != needed) {
+        return Error::BinaryFrameInvalid;
+    }
+
+    float target[MAX_N_AXIS];
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        if (bit_istrue(mask, bit(idx))) {
+            target[idx] = read_int32(p) / BINARY_POSITION_SCALE + gc_state.coord_system[idx] + gc_state.coord_offset[idx];
+            if (idx == TOOL_LENGTH_OFFSET_AXIS) {
+                target[idx] += gc_state.tool_length_offset;
+            }
+            p += 4;
+        } else {
+            target[idx] = gc_state.position[idx];
+        }
+    }
+
+    plan_line_data_t pl_data;
+    memset(&pl_data, 0, sizeof(plan_line_data_t));
+    pl_data.spindle = gc_state.modal.spindle;
+    pl_data.coolant = gc_state.modal.coolant;
+    // NOTE: Pass zero spindle speed for rapids in laser mode, as the parser does.
+    if (type != 0 || !spindle->inLaserMode()) {
+        pl_data.spindle_speed = gc_state.spindle_speed;
+    }
+    if (type == 0) {
+        pl_data.motion.rapidMotion = 1;
+    } else {
+        if (feed <= 0.0) {
+            return Error::GcodeUndefinedFeedRate;
+        }
+        pl_data.feed_rate = feed;
+    }
+
+    if (!is_arc) {
+        cartesian_to_motors(target, &pl_data, gc_state.position);
+    } else {
+        uint8_t axis_0, axis_1, axis_linear;
+        switch (gc_state.modal.plane_select) {
+            case Plane::XY:
+                axis_0      = X_AXIS;
+                axis_1      = Y_AXIS;
+                axis_linear = Z_AXIS;
+                break;
+            case Plane::ZX:
+                axis_0      = Z_AXIS;
+                axis_1      = X_AXIS;
+                axis_linear = Y_AXIS;
+                break;
+            default:  // case Plane::YZ:
+                axis_0      = Y_AXIS;
+                axis_1      = Z_AXIS;
+                axis_linear = X_AXIS;
+        }
+        float offset[3] = {};
+        offset[axis_0]  = read_int32(p) / BINARY_POSITION_SCALE;
+        offset[axis_1]  = read_int32(p + 4) / BINARY_POSITION_SCALE;
+        // Check the end point is on the circle, as the parser does for IJK arcs.
+        float radius   = hypot_f(offset[axis_0], offset[axis_1]);
+        float target_r = hypot_f(target[axis_0] - gc_state.position[axis_0] - offset[axis_0],
+                                 target[axis_1] - gc_state.position[axis_1] - offset[axis_1]);
+        float delta_r  = fabs(target_r - radius);
+        if (delta_r > 0.005 && (delta_r > 0.5 || delta_r > (0.001 * radius))) {
+            return Error::GcodeInvalidTarget;  // [Arc definition error]
+        }
+        mc_arc(target, &pl_data, gc_state.position, offset, radius, axis_0, axis_1, axis_linear, type == 2);
+    }
+    memcpy(gc_state.position, target, sizeof(target));
+    if (set_modes) {
+        gc_state.modal.motion = Motion(type);
+        if (feed > 0.0) {
+            gc_state.feed_rate = feed;
+        }
+    }
+    return Error::Ok;
+}
+
+Error binary_motion_run_frame(const uint8_t* frame, bool set_modes) {
+    return binary_motion_run(frame[0], frame + 1, set_modes);
+}
+
+void binary_motion_execute(uint8_t client) {
+    frame_t* f = &frames[client];
+    f->ready   = false;
+    report_status_message(binary_motion_run(f->length, f->data, false), client);
+}
+
+void binary_motion_reset() {
+    for (uint8_t client = 0; client < CLIENT_COUNT; client++) {
+        enabled[client]       = false;
+        frames[client].active = false;
+        frames[client].ready  = false;
+    }
+}
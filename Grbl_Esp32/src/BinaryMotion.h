@@ -0,0 +1,77 @@
+#pragma once
+
+/*
+  BinaryMotion.h - Packed binary motion records streamed alongside text G-code
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Error.h"
+
+#include <cstdint>
+
+// While Cmd::BinaryMotionOn is in effect for a client, BINARY_FRAME_START begins a frame:
+//
+//   BINARY_FRAME_START, length, payload[length], checksum
+//
+// where checksum is the inverted low byte of the sum of the payload bytes. Realtime commands
+// are recognized between frames but not inside them, and text lines may still be sent between
+// frames. Each frame is answered with ok or error:N, exactly like a line, and frames are
+// executed in order with the surrounding text. All values are little endian. The payload is
+//
+//   type, axis mask, feed rate, one target per axis in the mask[, two arc center offsets]
+//
+// type is the G-code motion number, 0 to 3, and the feed rate, ignored for rapids, is a uint32
+// in BINARY_FEED_SCALE units. Targets are int32 absolute work coordinates and the arc offsets
+// int32 distances from the start point to the center along the two axes of the active plane,
+// both in BINARY_POSITION_SCALE units. Axes not in the mask stay where they are.
+//
+// With RASTER_ENGRAVING, type BINARY_RASTER_TYPE is a raster line in laser mode instead:
+//
+//   type, axis, feed rate, pixel pitch, one power level per pixel
+//
+// It moves from the current position along the axis by the pitch, an int32 in
+// BINARY_POSITION_SCALE units whose sign gives the direction, times the number of pixels.
+// The power levels run from 0, off, to 255, the S in effect. Longer lines are sent as several
+// frames, which the planner runs through at full speed as they are in line.
+const uint8_t BINARY_FRAME_START    = 0xB5;
+const int     BINARY_FRAME_MAX      = 40;     // Longest payload
+const int     BINARY_RASTER_MAX     = 255;    // Longest raster payload
+const uint8_t BINARY_RASTER_TYPE    = 4;
+const float   BINARY_POSITION_SCALE = 10000;  // Steps of 0.0001 mm
+const float   BINARY_FEED_SCALE     = 1000;   // Steps of 0.001 mm/min
+
+// Turns binary frames on or off for a client. Called for the realtime commands.
+void binary_motion_enable(uint8_t client, bool enable);
+
+// Called by the client task for each received byte. Returns true for bytes of a frame, which
+// must be passed on to the client buffer without looking for realtime commands.
+bool binary_motion_in_frame(uint8_t client, uint8_t data);
+
+// Called by the main loop for each byte read from a client buffer. Returns true if the byte
+// belongs to a frame, and so is not part of a text line.
+bool binary_motion_receive(uint8_t client, uint8_t data);
+
+// True while a received frame waits to be executed.
+bool binary_motion_ready(uint8_t client);
+
+// Executes the waiting frame and reports its status to the client.
+void binary_motion_execute(uint8_t client);
+
+// Executes a frame held in memory, starting at its length byte. With set_modes the motion mode
+// and feed rate are left as a G-code line with the same move would leave them, so text lines
+// that follow can rely on the modes, as they do in compiled SD files.
+Error binary_motion_run_frame(const uint8_t* frame, bool set_modes);
+
+// Turns binary frames off for all clients and drops any partial frame. Called on reset.
+void binary_motion_reset();
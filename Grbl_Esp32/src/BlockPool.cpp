@@ -0,0 +1,101 @@
+/*
+  BlockPool.cpp - Fixed-size blocks for short-lived buffers
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Grbl.h"
+
+// The largest pool holds a web response chunk, see ESPResponseStream.
+static uint8_t pool_small[8][128] __attribute__((aligned(4)));
+static uint8_t pool_medium[4][512] __attribute__((aligned(4)));
+static uint8_t pool_large[2][1536] __attribute__((aligned(4)));
+
+typedef struct {
+    uint8_t* storage;
+    uint16_t block_size;
+    uint8_t  count;
+    uint8_t  in_use;
+    uint8_t  peak;
+    uint32_t used;  // Bit per block
+    uint32_t allocs;
+} pool_t;
+
+static pool_t pools[] = {
+    { &pool_small[0][0], sizeof(pool_small[0]), 8, 0, 0, 0, 0 },
+    { &pool_medium[0][0], sizeof(pool_medium[0]), 4, 0, 0, 0, 0 },
+    { &pool_large[0][0], sizeof(pool_large[0]), 2, 0, 0, 0, 0 },
+};
+static const int    POOL_COUNT     = sizeof(pools) / sizeof(pools[0]);
+static uint32_t     pool_fallbacks = 0;  // Requests the pools could not take
+static portMUX_TYPE pool_mux       = portMUX_INITIALIZER_UNLOCKED;
+
+void* pool_alloc(size_t size) {
+    portENTER_CRITICAL(&pool_mux);
+    for (int i = 0; i < POOL_COUNT; i++) {
+        pool_t& pool = pools[i];
+        if (size > pool.block_size || pool.in_use == pool.count) {
+            continue;
+        }
+        int block = 0;
+        while (pool.used & (1 << block)) {
+            block++;
+        }
+        pool.used |= 1 << block;
+        pool.in_use++;
+        if (pool.in_use > pool.peak) {
+            pool.peak = pool.in_use;
+        }
+        pool.allocs++;
+        portEXIT_CRITICAL(&pool_mux);
+        return pool.storage + block * pool.block_size;
+    }
+    pool_fallbacks++;
+    portEXIT_CRITICAL(&pool_mux);
+    return malloc(size);
+}
+
+void pool_free(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    uint8_t* p = static_cast<uint8_t*>(ptr);
+    for (int i = 0; i < POOL_COUNT; i++) {
+        pool_t& pool = pools[i];
+        if (p >= pool.storage && p < pool.storage + pool.count * pool.block_size) {
+            int block = (p - pool.storage) / pool.block_size;
+            portENTER_CRITICAL(&pool_mux);
+            pool.used &= ~(1 << block);
+            pool.in_use--;
+            portEXIT_CRITICAL(&pool_mux);
+            return;
+        }
+    }
+    free(ptr);
+}
+
+void pool_report(uint8_t client) {
+    for (int i = 0; i < POOL_COUNT; i++) {
+        portENTER_CRITICAL(&pool_mux);
+        pool_t pool = pools[i];
+        portEXIT_CRITICAL(&pool_mux);
+        grbl_sendf(client,
+                   "[POOL:%u,Blocks %u,Used %u,Peak %u,Allocs %u]\r\n",
+                   pool.block_size,
+                   pool.count,
+                   pool.in_use,
+                   pool.peak,
+                   pool.allocs);
+    }
+    grbl_sendf(client, "[POOL:Heap,Allocs %u]\r\n", pool_fallbacks);
+}
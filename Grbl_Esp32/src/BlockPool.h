@@ -0,0 +1,32 @@
+#pragma once
+
+/*
+  BlockPool.h - Fixed-size blocks for short-lived buffers
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+// Buffers that live for one request or one message come from a few pools of blocks set
+// aside at boot, so they neither fragment the heap while a job runs nor wait on the heap
+// lock. A request goes to the smallest pool with blocks of at least its size and a block
+// free, and to the heap only when there is none.
+void* pool_alloc(size_t size);
+
+// Returns a block from pool_alloc() to its pool, or to the heap.
+void pool_free(void* ptr);
+
+// Sends the size, use and high water mark of each pool and how often the heap was used instead.
+void pool_report(uint8_t client);
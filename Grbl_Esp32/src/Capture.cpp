@@ -0,0 +1,211 @@
+/*
+  Capture.cpp - Machine position and probe pin sampled at a fixed rate by the stepper interrupt
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  Time is counted in step timer ticks from the periods of the segments, as the step trace does,
+  so no timer of its own is needed; every hardware timer already has a user. A sample is taken
+  on the first tick at or after it is due, which puts it within one step period of its slot.
+  Only 32 bit arithmetic is used in the interrupt, whose code must stay in IRAM.
+
+  The interrupt is the only producer. The consumer is the realtime loop for a file and the
+  client task for the socket, one of them for each capture. A record that finds the ring full
+  is dropped and counted; the times of the others show where the gap is.
+
+  The probe pin is read as the probe monitor reads it. An analog input is left out, as the ADC
+  driver takes a lock and cannot be read from the interrupt.
+*/
+
+#include "Config.h"
+#ifdef POSITION_CAPTURE
+#    include "Grbl.h"
+
+static CaptureRecord*                    capture_records;
+static SpscRing<CaptureRecord, uint16_t> capture_ring;
+static volatile CaptureSink              capture_to = CaptureSink::None;
+static uint32_t                          capture_period;    // Step timer ticks between samples
+static uint32_t                          capture_due;       // Ticks since the last sample was due
+static uint32_t                          capture_us;        // Time of the current tick
+static uint32_t                          capture_us_ticks;  // Short of a microsecond, carried on
+static uint32_t                          capture_taken;     // Records taken since the start
+static uint32_t                          capture_dropped;   // Records that found the ring full
+static uint32_t                          capture_rate_hz;
+static uint8_t                           capture_client;
+
+#    ifdef ENABLE_SD_CARD
+static File capture_file;
+
+// Mounts the card for the capture and opens path through the write-behind buffers.
+static bool capture_open(const char* path) {
+    if (get_sd_state(true) != SDState::Idle) {
+        return false;
+    }
+    set_sd_state(SDState::BusyUploading);
+    capture_file = sd_fs().open(path, FILE_WRITE);
+    if (!capture_file || !sd_write_begin(capture_file)) {
+        if (capture_file) {
+            capture_file.close();
+        }
+        set_sd_state(SDState::Idle);
+        sd_unmount();
+        return false;
+    }
+    CaptureHeader header;
+    capture_header(&header);
+    sd_write((const uint8_t*)&header, sizeof(header));
+    return true;
+}
+
+static void capture_close() {
+    sd_write_end();
+    capture_file.close();
+    sd_dir_index_invalidate();
+    set_sd_state(SDState::Idle);
+    sd_unmount();
+}
+#    endif
+
+bool capture_start(CaptureSink sink, const char* path, uint8_t client) {
+    if (capture_to != CaptureSink::None || sink == CaptureSink::None) {
+        return false;
+    }
+#    if !defined(ENABLE_WIFI) || !defined(ENABLE_HTTP) || !defined(ENABLE_WEBSOCKET_EVENTS)
+    if (sink == CaptureSink::Socket) {
+        return false;  // Nothing would take the records
+    }
+#    endif
+    if (!capture_records) {
+        // Internal RAM, since the interrupt can run while the cache is off
+        capture_records = (CaptureRecord*)heap_alloc(
+            HeapTag::Stepper, CAPTURE_RECORDS * sizeof(CaptureRecord), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!capture_records) {
+            return false;
+        }
+        capture_ring.attach(capture_records, CAPTURE_RECORDS);
+    }
+    capture_ring.reset();
+    capture_rate_hz  = capture_rate->get();
+    capture_period   = fStepperTimer / capture_rate_hz;
+    capture_due      = capture_period;  // The first tick takes a sample
+    capture_us       = 0;
+    capture_us_ticks = 0;
+    capture_taken    = 0;
+    capture_dropped  = 0;
+    capture_client   = client;
+    if (sink == CaptureSink::File) {
+#    ifdef ENABLE_SD_CARD
+        if (!capture_open(path)) {
+            return false;
+        }
+#    else
+        return false;
+#    endif
+    }
+    capture_to = sink;
+    return true;
+}
+
+void capture_stop() {
+    CaptureSink sink = capture_to;
+    capture_to       = CaptureSink::None;
+#    ifdef ENABLE_SD_CARD
+    if (sink == CaptureSink::File) {
+        capture_poll();  // The records the interrupt took before it saw the stop
+        if (capture_file) {
+            capture_close();
+        }
+    }
+#    endif
+}
+
+CaptureSink capture_sink() {
+    return capture_to;
+}
+
+void capture_header(CaptureHeader* header) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, "GCAP", sizeof(header->magic));
+    header->version     = 1;
+    header->record_size = sizeof(CaptureRecord);
+    header->n_axis      = number_axis->get();
+    header->rate_hz     = capture_rate_hz;
+    for (int axis = 0; axis < header->n_axis; axis++) {
+        header->steps_per_mm[axis] = axis_settings[axis]->steps_per_mm->get();
+    }
+}
+
+void IRAM_ATTR capture_sample(uint32_t period) {
+    if (capture_to == CaptureSink::None) {
+        return;
+    }
+    capture_us_ticks += period;
+    capture_us += capture_us_ticks / ticksPerMicrosecond;
+    capture_us_ticks %= ticksPerMicrosecond;
+    capture_due += period;
+    if (capture_due < capture_period) {
+        return;
+    }
+    uint32_t late = capture_due / capture_period - 1;
+    capture_due %= capture_period;
+    CaptureRecord* record = capture_ring.producer_slot();
+    if (record == nullptr) {
+        capture_dropped++;
+        return;
+    }
+    int32_t position[MAX_N_AXIS];
+    st_get_position(position);
+    memcpy(record->position, position, sizeof(position));
+    record->time_us = capture_us;
+    record->probe   = probe_get_state();
+    record->state   = uint8_t(sys.state);
+    record->late    = late > UINT16_MAX ? UINT16_MAX : late;
+    capture_ring.push();
+    capture_taken++;
+}
+
+size_t capture_read(CaptureRecord* out, size_t count) {
+    size_t n = 0;
+    while (n < count && capture_ring.pop(out[n])) {
+        n++;
+    }
+    return n;
+}
+
+void capture_poll() {
+#    ifdef ENABLE_SD_CARD
+    if (!capture_file) {
+        return;
+    }
+    CaptureRecord* record;
+    while ((record = capture_ring.consumer_slot()) != nullptr) {
+        if (!sd_write((const uint8_t*)record, sizeof(*record))) {
+            grbl_msg_sendf(capture_client, MsgLevel::Info, "Capture write failed");
+            capture_to = CaptureSink::None;
+            capture_close();
+            return;
+        }
+        capture_ring.pop();
+    }
+#    endif
+}
+
+void capture_report(uint8_t client) {
+    static const char* sinks[] = { "off", "to socket", "to file" };
+    grbl_sendf(client,
+               "[MSG: Capture %s Rate: %u Records: %u Dropped: %u]\r\n",
+               sinks[int(capture_to)],
+               capture_rate_hz,
+               capture_taken,
+               capture_dropped);
+}
+#endif
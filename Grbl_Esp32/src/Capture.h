@@ -0,0 +1,77 @@
+#pragma once
+
+/*
+  Capture.h - Machine position and probe pin sampled at a fixed rate by the stepper interrupt
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Config.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Records held until the sink takes them, a second at the default $Capture/Rate.
+const uint16_t CAPTURE_RECORDS = 1024;
+
+// Records sent in one WebSocket message.
+const int CAPTURE_MESSAGE_RECORDS = 32;
+
+// A capture file starts with this header, then the records, little endian. Each WebSocket
+// message is a header and up to CAPTURE_MESSAGE_RECORDS records.
+struct __attribute__((packed)) CaptureHeader {
+    char     magic[4];     // "GCAP"
+    uint8_t  version;      // 1
+    uint8_t  record_size;  // sizeof(CaptureRecord), so older readers can skip new fields
+    uint8_t  n_axis;       // Axes with a position in each record
+    uint8_t  reserved;     // 0
+    uint32_t rate_hz;      // $Capture/Rate when the capture started
+    float    steps_per_mm[MAX_N_AXIS];
+};
+
+struct __attribute__((packed)) CaptureRecord {
+    uint32_t time_us;               // Step timer time since the capture started, not counting idle time
+    int32_t  position[MAX_N_AXIS];  // Motor steps, as sys_position
+    uint8_t  probe;                 // 1 while the probe pin reads triggered
+    uint8_t  state;                 // sys.state
+    uint16_t late;                  // Samples that fell inside the tick before this one and were not taken
+};
+
+enum class CaptureSink : uint8_t {
+    None = 0,
+    Socket,  // WebUI socket connections subscribed to "capture", see SocketEvents.h
+    File,    // A file on the SD card
+};
+
+// Starts a capture into sink, allocating the buffer the first time. path is the SD file for
+// CaptureSink::File, which mounts the card and keeps it busy until capture_stop(). False if the
+// buffer or the file cannot be had, or a capture is running.
+bool capture_start(CaptureSink sink, const char* path, uint8_t client);
+void capture_stop();
+
+CaptureSink capture_sink();
+void        capture_header(CaptureHeader* header);
+
+// Called by the stepper interrupt on every tick with the period of the tick in step timer
+// ticks. Takes a record whenever a sample period has passed, so samples are never closer than
+// the ticks, and not taken at all while the steppers are idle.
+void capture_sample(uint32_t period);
+
+// Moves up to count records to out and returns how many there were.
+size_t capture_read(CaptureRecord* out, size_t count);
+
+// Writes what has been captured to the file. Called from the realtime loop.
+void capture_poll();
+
+// Sends the state of the capture, with counts of the records taken and dropped.
+void capture_report(uint8_t client);
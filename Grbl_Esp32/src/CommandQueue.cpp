@@ -0,0 +1,127 @@
+/*
+  CommandQueue.cpp - Whole lines submitted by the firmware itself to the main loop
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Grbl.h"
+
+typedef struct {
+    char                       line[LINE_BUFFER_SIZE];
+    uint8_t                    client;
+    WebUI::AuthenticationLevel auth_level;
+    command_done_t             done;
+    void*                      arg;
+} command_t;
+
+// Any task sends, only the main loop receives. The line at the head is taken out while it waits
+// for the planner, so it keeps its place.
+static QueueHandle_t command_queue = NULL;
+static command_t     command_waiting;
+static bool          command_is_waiting = false;
+
+void command_queue_init() {
+    if (command_queue == NULL) {
+        command_queue = xQueueCreate(COMMAND_QUEUE_SIZE, sizeof(command_t));
+    }
+}
+
+bool command_submit(const char* line, uint8_t client, command_done_t done, void* arg, WebUI::AuthenticationLevel auth_level) {
+    size_t len = strlen(line);
+    while (len && (line[len - 1] == '\r' || line[len - 1] == '\n')) {
+        len--;
+    }
+    if (command_queue == NULL || len >= LINE_BUFFER_SIZE) {
+        return false;
+    }
+    command_t cmd;
+    memcpy(cmd.line, line, len);
+    cmd.line[len]  = '\0';
+    cmd.client     = client;
+    cmd.auth_level = auth_level;
+    cmd.done       = done;
+    cmd.arg        = arg;
+    return xQueueSend(command_queue, &cmd, 0) == pdTRUE;
+}
+
+typedef struct {
+    TaskHandle_t task;
+    Error        status;
+} command_wait_t;
+
+static void command_run_done(Error status, void* arg) {
+    command_wait_t* wait = (command_wait_t*)arg;
+    wait->status         = status;
+    xTaskNotifyGive(wait->task);
+}
+
+Error command_run(const char* line, uint8_t client, WebUI::AuthenticationLevel auth_level) {
+    command_wait_t wait = { xTaskGetCurrentTaskHandle(), Error::Ok };
+    if (!command_submit(line, client, command_run_done, &wait, auth_level)) {
+        return Error::Overflow;
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    return wait.status;
+}
+
+static void command_finish(command_t* cmd, Error status) {
+    if (cmd->done) {
+        cmd->done(status, cmd->arg);
+    } else {
+        report_status_message(status, cmd->client);
+    }
+}
+
+// While an SD job runs, only lines that just report may run beside it, as with the clients.
+static bool command_held_off_by_job(const char* line) {
+#ifdef ENABLE_SD_CARD
+    return get_sd_state(false) >= SDState::Busy && !system_line_is_query(line);
+#else
+    return false;
+#endif
+}
+
+void command_queue_poll() {
+    if (!command_is_waiting) {
+        if (command_queue == NULL || xQueueReceive(command_queue, &command_waiting, 0) != pdTRUE) {
+            return;
+        }
+        command_is_waiting = true;
+    }
+    char* line = command_waiting.line;
+    if (command_held_off_by_job(line)) {
+        command_is_waiting = false;
+        command_finish(&command_waiting, Error::AnotherInterfaceBusy);
+        return;
+    }
+    if (line[0] != 0 && line[0] != '$' && line[0] != '[' && plan_check_full_buffer()) {
+        return;  // G-code can queue motion, so it waits for room
+    }
+    command_is_waiting = false;
+    command_finish(&command_waiting, execute_line(line, command_waiting.client, command_waiting.auth_level));
+}
+
+void command_queue_reset() {
+    if (command_is_waiting) {
+        command_is_waiting = false;
+        if (command_waiting.done) {
+            command_waiting.done(Error::CommandDropped, command_waiting.arg);
+        }
+    }
+    command_t cmd;
+    while (command_queue != NULL && xQueueReceive(command_queue, &cmd, 0) == pdTRUE) {
+        if (cmd.done) {
+            cmd.done(Error::CommandDropped, cmd.arg);
+        }
+    }
+}
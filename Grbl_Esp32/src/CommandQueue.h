@@ -0,0 +1,53 @@
+#pragma once
+
+/*
+  CommandQueue.h - Whole lines submitted by the firmware itself to the main loop
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Error.h"
+#include "WebUI/Authentication.h"
+
+#include <cstdint>
+
+// Lines queued at once. command_submit() fails while they are all waiting, and callers in the
+// main loop cannot wait for room, so it holds the longest burst a machine submits, the 20 lines
+// of an Atari 1020 pen change from a button.
+const int COMMAND_QUEUE_SIZE = 24;
+
+// Told how a submitted line ended. Called from the main loop, or from command_queue_reset().
+typedef void (*command_done_t)(Error status, void* arg);
+
+void command_queue_init();
+
+// Queues one line, without the main loop reading it back a byte at a time, to run as if client
+// had sent it. Its output goes to client, CLIENT_INPUT for none. Its status goes to done if
+// there is one, and is reported to client otherwise. A trailing end of line is dropped. Can be
+// called from any task; false if the line is too long or the queue is full.
+bool command_submit(const char*                line,
+                    uint8_t                    client,
+                    command_done_t             done       = nullptr,
+                    void*                      arg        = nullptr,
+                    WebUI::AuthenticationLevel auth_level = WebUI::AuthenticationLevel::LEVEL_GUEST);
+
+// Submits line and waits until it has run, returning its status. Output still goes to client.
+// Never call it from the main loop, which would wait for itself.
+Error command_run(const char* line, uint8_t client, WebUI::AuthenticationLevel auth_level = WebUI::AuthenticationLevel::LEVEL_GUEST);
+
+// Runs the next queued line. A G-code line waits while the planner is full, as a client's does,
+// and while an SD job runs only lines that just report are run. Called from the main loop.
+void command_queue_poll();
+
+// Drops the queued lines, telling each one's done that it was dropped. Called on a reset.
+void command_queue_reset();
@@ -59,8 +59,34 @@ Some features should not be changed. See notes below.
 // #define ENABLE_CONTROL_SW_DEBOUNCE     // Default disabled. Uncomment to enable.
 #define CONTROL_SW_DEBOUNCE_PERIOD 32  // in milliseconds default 32 microseconds
 
+// Glitch filter for the control inputs, in place of ENABLE_CONTROL_SW_DEBOUNCE. A control pin edge
+// arms a one-shot hardware timer (timer group 1, timer 1), and the pins are read and acted on from
+// its interrupt once they have been quiet for CONTROL_INPUT_FILTER_US, setting the realtime bits
+// directly. Pulses shorter than that are ignored. A pin that keeps bouncing stops restarting the
+// timer once its first edge is CONTROL_INPUT_FILTER_US old, so the response comes within twice
+// that time. $Control/Stats shows the measured latency from each input's edge to Grbl acting on it.
+// #define ENABLE_CONTROL_INPUT_FILTER // Default disabled. Uncomment to enable.
+#define CONTROL_INPUT_FILTER_US 1000  // in microseconds
+
 #define USE_RMT_STEPS
 
+// Timer-driven step pulses for the ST_TIMED and ST_I2S_STATIC steppers. Normally the stepper
+// interrupt spins for the direction delay ($Stepper/Direction/Delay) and the step pulse width
+// ($0 Stepper/Pulse) on every step. With this option the interrupt sets the outputs and arms a
+// one-shot hardware timer (timer group 0, timer 1) whose interrupt raises the step pins after
+// the direction delay and clears them at the end of the pulse, so those cycles are given back.
+// #define USE_STEP_PULSE_TIMER // Default disabled. Uncomment to enable.
+
+// Batched RMT stepping. Normally the RMT peripheral only times the width of each step pulse and
+// the stepper interrupt still runs once per step event. With this option, each interrupt runs the
+// Bresenham tracer ahead for up to RMT_BATCH_MAX_STEPS step events of the current segment and
+// loads the resulting pulse train for each axis into its RMT channel, which plays it out on its own.
+// This cuts the interrupt rate at high step rates on machines that cannot use I2S. Homing and
+// probing fall back to one step event per interrupt so switches are still checked on every step,
+// except probing with PROBE_EDGE_CAPTURE, which does not need the interrupt to check the pin.
+// Requires USE_RMT_STEPS and step/direction motors (StandardStepper and the Trinamic drivers).
+// #define USE_RMT_BATCH_STEPS // Default disabled. Uncomment to enable.
+
 // Include the file that loads the machine-specific config file.
 // machine.h must be edited to choose the desired file.
 #include "Machine.h"
@@ -74,6 +100,11 @@ Some features should not be changed. See notes below.
 #        undef USE_RMT_STEPS
 #    endif
 #endif
+#ifndef USE_RMT_STEPS
+#    ifdef USE_RMT_BATCH_STEPS
+#        undef USE_RMT_BATCH_STEPS
+#    endif
+#endif
 
 const int MAX_N_AXIS = 6;
 
@@ -90,6 +121,8 @@ const int MAX_N_AXIS = 6;
 // Serial baud rate
 // OK to change, but the ESP32 boot text is 115200, so you will not see that is your
 // serial monitor, sender, etc uses a different value than 115200
+// This is the boot rate; $Serial/Baud switches to another one, up to 2000000, once the
+// settings are loaded. Define SERIAL_RTS_PIN and SERIAL_CTS_PIN for $Serial/FlowControl.
 #define BAUD_RATE 115200
 
 //Connect to your local AP with these credentials
@@ -117,6 +150,39 @@ const int MAX_N_AXIS = 6;
 #define ENABLE_SERIAL2SOCKET_IN
 #define ENABLE_SERIAL2SOCKET_OUT
 
+// A WebSocket connection to /stream on the WebUI socket port is a client of its own, with
+// credit-based flow control, for senders running in a browser. See WebUI/SocketStream.h.
+#define ENABLE_WEBSOCKET_STREAM
+
+// WebUI socket connections can subscribe to state, alarm, position, SD progress and override
+// events instead of polling for them. See WebUI/SocketEvents.h.
+#define ENABLE_WEBSOCKET_EVENTS
+
+// A plain TCP socket on this port is a client of its own that behaves like the serial port,
+// for senders that stream over the network. See WebUI/TcpStream.h.
+#define ENABLE_TCP_STREAM
+#define TCP_STREAM_PORT 2323
+
+// Wired Ethernet through an RMII PHY, a LAN8720 by default, alongside WiFi. The same services
+// answer on it, and they also run on it alone when the radio is off. It needs ENABLE_WIFI.
+// The RMII pins are fixed (GPIO 0, 19, 21, 22, 25, 26 and 27) and MDC/MDIO default to 23/18,
+// so the machine definition must leave them free. The ETH_PHY_* and ETH_CLK_MODE defaults of
+// the Arduino ETH library can be overridden there.
+// #define ENABLE_ETHERNET
+
+// Coordinates controllers over ESP-NOW, without wires. With $Sync/Role=Leader a controller
+// broadcasts its cycle starts, holds, alarms and block starts to the controllers with
+// $Sync/Role=Follower and the same $Sync/Group. A follower only starts its queued motion while
+// the leader runs, and holds and resumes with it. The boards must share a WiFi channel. $Sync
+// shows the frame counts and how far a follower's block starts trail the leader's, when both
+// run with line numbers. It needs ENABLE_WIFI.
+// #define ENABLE_ESP_NOW_SYNC
+
+// Starts WiFi, Bluetooth and the network services in a task of their own once motion control
+// is up, instead of before it, so the machine takes commands on the serial port sooner after
+// power on. $Boot/Times shows when each stage of startup finished.
+#define ENABLE_LAZY_NETWORK
+
 // Captive portal is used when WiFi is in access point mode.  It lets the
 // WebUI come up automatically in the browser, instead of requiring the user
 // to browse manually to a default URL.  It works like airport and hotel
@@ -131,6 +197,60 @@ const int MAX_N_AXIS = 6;
 // #define ENABLE_AUTHENTICATION
 //CONFIGURE_EYECATCH_END (DO NOT MODIFY THIS LINE)
 
+// Keep the local file system on LittleFS instead of SPIFFS, on the same partition, for real
+// directories and faster opens. See LocalFS.h. The first boot moves the files of an existing
+// SPIFFS image across. The littlefs environment in platformio.ini sets it.
+// #define USE_LITTLEFS  // Default disabled. Uncomment to enable.
+
+// The native USB port of the ESP32-S2 and ESP32-S3 is a client of its own, CLIENT_USB, that
+// streams at full speed USB rates with no baud rate to set. See UsbCdc.h. The esp32s3
+// environment in platformio.ini defines it. Those chips have no classic Bluetooth for SerialBT.
+#ifdef ENABLE_USB_CDC
+#    undef ENABLE_BLUETOOTH
+#    ifndef ENABLE_WIFI
+#        undef WIFI_OR_BLUETOOTH
+#    endif
+#endif
+
+// A small build for lasers, plotters and other machines run over USB or from the SD card. It
+// leaves out the radio and every network service, and only has the spindle types named by
+// SPINDLE_TYPE and SPINDLE_ALT_TYPE in the machine definition. The motors are always only
+// those the machine definition names. The RAM it saves can go to a deeper planner and
+// segment buffer, and the smaller image takes less time to flash and to boot. The tiny
+// environment in platformio.ini, or build-machine.py -t, builds it.
+#ifdef TINY_BUILD
+#    undef ENABLE_BLUETOOTH
+#    undef ENABLE_WIFI
+#    undef WIFI_OR_BLUETOOTH
+#    undef ENABLE_HTTP
+#    undef ENABLE_OTA
+#    undef ENABLE_TELNET
+#    undef ENABLE_TELNET_WELCOME_MSG
+#    undef ENABLE_MDNS
+#    undef ENABLE_SSDP
+#    undef ENABLE_NOTIFICATIONS
+#    undef ENABLE_SERIAL2SOCKET_IN
+#    undef ENABLE_SERIAL2SOCKET_OUT
+#    undef ENABLE_WEBSOCKET_STREAM
+#    undef ENABLE_WEBSOCKET_EVENTS
+#    undef ENABLE_TCP_STREAM
+#    undef ENABLE_ETHERNET
+#    undef ENABLE_ESP_NOW_SYNC
+#    undef ENABLE_LAZY_NETWORK
+#    undef ENABLE_CAPTIVE_PORTAL
+#    undef ENABLE_AUTHENTICATION
+#endif
+
+// The host build in sim/ runs the motion core without a radio or SD card, and can record
+// step traces.
+#ifdef GRBL_SIM
+#    undef ENABLE_BLUETOOTH
+#    undef ENABLE_WIFI
+#    undef WIFI_OR_BLUETOOTH
+#    undef ENABLE_SD_CARD
+#    define STEP_TRACE
+#endif
+
 #ifdef ENABLE_AUTHENTICATION
 const char* const DEFAULT_ADMIN_PWD   = "admin";
 const char* const DEFAULT_USER_PWD    = "user";
@@ -197,6 +317,8 @@ enum class Cmd : uint8_t {
     SpindleOvrStop        = 0x9E,
     CoolantFloodOvrToggle = 0xA0,
     CoolantMistOvrToggle  = 0xA1,
+    BinaryMotionOn        = 0xB0,  // Accept binary motion frames from this client. See BinaryMotion.h
+    BinaryMotionOff       = 0xB1,
 };
 
 // If homing is enabled, homing init lock sets Grbl into an alarm state upon power up. This forces
@@ -279,6 +401,11 @@ static const uint8_t NHomingLocateCycle = 1;  // Integer (1-128)
 // OEMs and LinuxCNC users that would like this power-cycle behavior.
 // #define FORCE_INITIALIZATION_ALARM // Default disabled. Uncomment to enable.
 
+// Fixes steps/mm, max rate, acceleration and max travel ($100-$132) to the values in the
+// machine definition, for production builds whose mechanics never change. They are then
+// not stored in NVS, not listed by $$ and cannot be set.
+// #define LOCKED_AXIS_SETTINGS // Default disabled. Uncomment to enable.
+
 // At power-up or a reset, Grbl will check the limit switch states to ensure they are not active
 // before initialization. If it detects a problem and the hard limits setting is enabled, Grbl will
 // simply message the user to check the limits and enter an alarm state, rather than idle. Grbl will
@@ -316,6 +443,17 @@ namespace SpindleSpeedOverride {
     const int FineIncrement   = 1;    // (1-99). Usually 1%.
 }
 
+// Normally every feed or rapid override command replans the whole planner buffer. With this
+// option the applied overrides move toward the requested ones by at most OVERRIDE_SLEW_PERCENT
+// every OVERRIDE_SLEW_MS, so a fast turn of the knob is taken in a few steps. Only a reduction
+// replans the buffer right away, because the planned junction speeds could then be above the new
+// nominal speeds. An increase only refreshes the executing block, and the junctions are replanned
+// once the overrides have not changed for OVERRIDE_SETTLE_MS.
+// #define OVERRIDE_SMOOTHING  // Default disabled. Uncomment to enable.
+#define OVERRIDE_SLEW_PERCENT 10
+#define OVERRIDE_SLEW_MS 25
+#define OVERRIDE_SETTLE_MS 250
+
 // When a M2 or M30 program end command is executed, most GCode states are restored to their defaults.
 // This compile-time option includes the restoring of the feed, rapid, and spindle speed override values
 // to their default values at program end.
@@ -334,6 +472,21 @@ namespace SpindleSpeedOverride {
 #define REPORT_FIELD_OVERRIDES           // Default enabled. Comment to disable.
 #define REPORT_FIELD_LINE_NUMBERS        // Default enabled. Comment to disable.
 
+// Adds stepper interrupt headroom to the status report as |Isr:<missed>,<max us>,<min slack us>, where
+// missed counts interrupts that were re-entered or ran past the next alarm. Also see $Stepper/IsrStats.
+// Timer-driven steppers only; the I2S stream stepper does not use the stepper interrupt.
+// #define REPORT_FIELD_STEPPER_ISR // Default disabled. Uncomment to enable.
+
+// Adds the following error of motors with position feedback, like Dynamixel servos, to the status
+// report as |FE:<x>,<y>,... in the report units. It is 0 for axes without feedback. Always on
+// with axis encoders, which it reports instead.
+// #define REPORT_FIELD_FOLLOWING_ERROR // Default disabled. Uncomment to enable.
+
+// Adds the seconds until the queued motion is done to the status report as |Qt:<seconds>, while
+// the planner holds any. It is worked out from the planned speed profiles at the current
+// overrides, so it leaves out dwells and holds and only sees as far ahead as the planner does.
+// #define REPORT_FIELD_QUEUED_TIME // Default disabled. Uncomment to enable.
+
 // Some status report data isn't necessary for realtime, only intermittently, because the values don't
 // change often. The following macros configures how many times a status report needs to be called before
 // the associated data is refreshed and included in the status report. However, if one of these value
@@ -357,6 +510,44 @@ const int REPORT_WCO_REFRESH_IDLE_COUNT = 10;  // (2-255) Must be less than or e
 // certain the step segment buffer is increased/decreased to account for these changes.
 const int ACCELERATION_TICKS_PER_SECOND = 100;
 
+// Jerk-limited (S-curve) acceleration. The planner still plans trapezoids, but the segment
+// generator follows a smoothstep velocity curve through each acceleration and deceleration ramp,
+// so acceleration rises and falls gradually instead of switching on and off. The curve covers the
+// same distance in the same time as the trapezoid ramp, with a peak acceleration 1.5 times the
+// average, so the planner uses 2/3 of the axis acceleration limit. The average acceleration is
+// further limited by the $<axis>/Jerk settings so that a ramp from rest to the programmed rate
+// does not exceed the jerk limit. Feed hold and override decelerations stay linear.
+// #define S_CURVE_ACCELERATION // Default disabled. Uncomment to enable.
+
+// Input shaping. The segment generator shapes each acceleration and deceleration ramp with a ZV,
+// ZVD or EI shaper tuned to the machine's resonance, set by $Shaper/Type, $Shaper/Frequency and
+// $Shaper/Damping. The ramp becomes the sum of shorter linear ramps that start half a period of
+// ringing apart, so the vibration each one excites is cancelled by the next. The planner couples
+// all axes to one path, so the shaper acts on the path speed and the same shaper applies to every
+// axis; tune it to the resonance that rings the most. Speed changes at corners and ramps shorter
+// than the shaper are not shaped. A shaped ramp takes the same distance, but its steepest part is
+// steeper than the planned ramp, so leave some margin in the acceleration settings. Use it with
+// ADAPTIVE_SEGMENT_DURATION, since the shaper steps are only a few milliseconds apart.
+// Cannot be combined with S_CURVE_ACCELERATION.
+// #define INPUT_SHAPING // Default disabled. Uncomment to enable.
+
+// Adaptive segment duration. Instead of a fixed 1/ACCELERATION_TICKS_PER_SECOND, segments that
+// start in an acceleration or deceleration ramp are ADAPTIVE_RAMP_SEGMENT_DIVISOR times shorter,
+// which traces the velocity profile more finely, and segments that start at cruise speed are
+// ADAPTIVE_CRUISE_SEGMENT_MULTIPLIER times longer, which cuts the ISR reload overhead when the
+// rate is constant anyway. Keep the multiplier small, since a feed hold cannot begin to decelerate
+// until the segments already in the buffer have executed.
+// #define ADAPTIVE_SEGMENT_DURATION // Default disabled. Uncomment to enable.
+const int ADAPTIVE_RAMP_SEGMENT_DIVISOR     = 2;
+const int ADAPTIVE_CRUISE_SEGMENT_MULTIPLIER = 2;
+
+// Once a feed hold has stopped the machine, the segment buffer is filled with the segments that
+// accelerate it again, so cycle start sets the steppers going at once instead of first
+// recomputing the profile and preparing a buffer of segments. They are only prepared when they
+// end inside the held block, and are taken back if an override change, a safety door parking
+// motion or anything else replans the held motion first.
+#define PRIME_HOLD_RESUME  // Default enabled. Comment to disable.
+
 // Sets the maximum step rate allowed to be written as a Grbl setting. This option enables an error
 // check in the settings module to prevent settings values that will exceed this limitation. The maximum
 // step rate is strictly limited by the CPU speed and will change if something other than an AVR running
@@ -401,6 +592,12 @@ const int TOOL_LENGTH_OFFSET_AXIS = Z_AXIS;  // Default z-axis. Valid values are
 // received, including not only GCode lines, but also $ and [ESP commands.
 //#define REPORT_ECHO_RAW_LINE_RECEIVED // Default disabled. Uncomment to enable.
 
+// Remembers the parsed words of the last few short G-code lines, so that a line repeated in the
+// same modal state, as on every pass of a raster or pocketing job, skips the word parsing and
+// modal group checks. The checks that depend on the position still run on every line. Each
+// entry takes about 200 bytes of RAM. Comment to disable.
+#define GCODE_LINE_CACHE_SIZE 8
+
 // Minimum planner junction speed. Sets the default minimum junction speed the planner plans to at
 // every buffer block junction, except for starting from rest and end of the buffer, which are always
 // zero. This value controls how fast the machine moves through junctions with no regard for acceleration
@@ -421,6 +618,12 @@ const double MINIMUM_FEED_RATE = 1.0;  // (mm/min)
 // bogged down by too many trig calculations.
 const int N_ARC_CORRECTION = 12;  // Integer (1-255)
 
+// Computes the exact arc correction with the single precision sinf() and cosf(), which use the
+// ESP32 FPU, instead of the double precision sin() and cos() emulated in software. The float
+// error grows with radius and angle, so arcs where it could reach a tenth of the arc tolerance
+// ($12) still use double precision. Comment out to always use double precision.
+#define ARC_SINGLE_PRECISION_CORRECTION  // Default enabled. Comment to disable.
+
 // The arc G2/3 GCode standard is problematic by definition. Radius-based arcs have horrible numerical
 // errors when arc at semi-circles(pi) or full-circles(2*pi). Offset-based arcs are much more accurate
 // but still have a problem when arcs are full-circles (2*pi). This define accounts for the floating
@@ -453,7 +656,10 @@ const int DWELL_TIME_STEP = 50;  // Integer (1-255) (milliseconds)
 // available RAM, like when re-compiling for a Mega2560. Or decrease if the Arduino begins to
 // crash due to the lack of available RAM or if the CPU is having trouble keeping up with planning
 // new incoming motions as they are executed.
-// #define BLOCK_BUFFER_SIZE 16 // Uncomment to override default in planner.h.
+// The size is now the $Planner/BlockBuffer setting, up to 255 blocks, which takes effect after a
+// restart. Dense toolpaths need 128 or more blocks to reach the programmed feed. When the board
+// has PSRAM, $Planner/BlockBuffer/PSRAM places the buffer there to save internal RAM.
+// #define BLOCK_BUFFER_SIZE 16 // Uncomment to override the default value of the setting in planner.h.
 
 // Governs the size of the intermediary step segment buffer between the step execution algorithm
 // and the planner blocks. Each segment is set of steps executed at a constant velocity over a
@@ -461,7 +667,65 @@ const int DWELL_TIME_STEP = 50;  // Integer (1-255) (milliseconds)
 // block velocity profile is traced exactly. The size of this buffer governs how much step
 // execution lead time there is for other Grbl processes have to compute and do their thing
 // before having to come back and refill this buffer, currently at ~50msec of step moves.
-// #define SEGMENT_BUFFER_SIZE 6 // Uncomment to override default in stepper.h.
+// The size is now the $Stepper/SegmentBuffer setting, which takes effect after a restart.
+// $Stepper/SegmentStats reports the allocated size and the high-water mark.
+// #define SEGMENT_BUFFER_SIZE 6 // Uncomment to override the default value of the setting in stepper.h.
+
+// By default the stepper ISR updates the shared machine position (sys_position) on every step.
+// With this option enabled, the ISR instead accumulates signed step counts for the executing
+// segment in a private counter and folds them into sys_position when the segment completes.
+// Code that needs the true real-time position, like status reports and probing, must read it
+// with st_get_position(), which combines the committed and the in-flight steps.
+// #define DEFER_STEP_POSITION_UPDATES // Default disabled. Uncomment to enable.
+
+// Step trace. Records the time, step mask and direction mask of every step event the stepper
+// interrupt puts out, compressed, for comparing the motion of two builds. $Stepper/Trace=on
+// starts a trace, $Stepper/Trace sends what has been recorded so far and $Stepper/Trace=off
+// stops it. sim/trace_diff.py compares two traces; see sim/README.md. Costs a call on every
+// stepper interrupt even while no trace is running.
+// #define STEP_TRACE // Default disabled. Uncomment to enable.
+
+// Position capture, for digitizing. The stepper interrupt samples the machine position and the
+// probe pin every 1/$Capture/Rate seconds of motion into a buffer of CAPTURE_RECORDS records.
+// $Capture=socket sends them in binary to the WebUI socket connections subscribed to "capture",
+// $Capture=/file.cap writes them to the SD card, $Capture=off stops and $Capture reports how
+// many were taken and dropped. See Capture.h for the format. Like the step trace, it costs a
+// call on every stepper interrupt even while no capture is running.
+// #define POSITION_CAPTURE // Default disabled. Uncomment to enable.
+
+// Event trace. Times the parser, the planner, the segment generator, the client task, the VFD
+// task and the I2S fill task into a ring of the last EVENT_TRACE_ENTRIES events, with the task
+// and core each ran on. $Trace sends the ring as Chrome trace JSON, for chrome://tracing or
+// Perfetto, and $Trace=clear empties it. Each event costs a few microseconds of timer reads.
+// #define EVENT_TRACE // Default disabled. Uncomment to enable.
+
+// Normally the step segment buffer is refilled opportunistically by the main loop, so a slow
+// GCode line or SD card read can starve it. This option adds a dedicated task that refills the
+// buffer every SEGMENT_PREP_TASK_PERIOD ticks while motion is active. It runs at a higher
+// priority than the main loop and the client tasks, on the core that WiFi does not use.
+// The planner and segment generator are then protected by a recursive mutex.
+// #define ENABLE_SEGMENT_PREP_TASK // Default disabled. Uncomment to enable.
+#define SEGMENT_PREP_TASK_CORE 1      // APP CPU. WiFi and Bluetooth run on core 0
+#define SEGMENT_PREP_TASK_PRIORITY 3  // Above the Arduino loop task and clientCheckTask
+#define SEGMENT_PREP_TASK_PERIOD 2    // Ticks (ms) between refills. Must be well below the ~50ms buffer depth
+
+// Splits the motion work between the two cores. The Arduino loop task reads, parses and plans
+// on core 1, and the segment prep task preps on core 0, above the TCP/IP task so network bursts
+// cannot starve it. The main loop then leaves the segment buffer to the task. clientCheckTask,
+// which formats the status reports, moves to core 0 as well; $Tasks/Placement can put it back.
+// The planner and segment rings are single producer, single consumer; the mutex above only
+// covers the replanning of queued blocks.
+// #define ENABLE_DUAL_CORE_PIPELINE  // Default disabled. Uncomment to enable.
+#ifdef ENABLE_DUAL_CORE_PIPELINE
+#    define ENABLE_SEGMENT_PREP_TASK
+#    undef SEGMENT_PREP_TASK_CORE
+#    define SEGMENT_PREP_TASK_CORE 0  // PRO CPU, away from the parser
+#    undef SEGMENT_PREP_TASK_PRIORITY
+#    define SEGMENT_PREP_TASK_PRIORITY 19  // Above tcpip_thread (18), below the WiFi task (23)
+#    define CLIENT_TASK_CORE 0
+#else
+#    define CLIENT_TASK_CORE SUPPORT_TASK_CORE
+#endif
 
 // Line buffer size from the serial input stream to be executed. Also, governs the size of
 // each of the startup blocks, as they are each stored as a string of this size.
@@ -480,15 +744,34 @@ const int DWELL_TIME_STEP = 50;  // Integer (1-255) (milliseconds)
 // 115200 baud will take 5 msec to transmit a typical 55 character report. Worst case reports are
 // around 90-100 characters. As long as the serial TX buffer doesn't get continually maxed, Grbl
 // will continue operating efficiently. Size the TX buffer around the size of a worst-case report.
-// #define RX_BUFFER_SIZE 128 // (1-254) Uncomment to override defaults in serial.h
+// #define RX_BUFFER_SIZE 128 // (1-65534) Uncomment to override defaults in serial.h
+// #define SERIAL_RX_BUFFER_SIZE 1024 // (1-65534)
+// #define TELNET_RX_BUFFER_SIZE 1024 // (1-65534)
 // #define TX_BUFFER_SIZE 100 // (1-254)
 
+// Serial output is queued in memory and fed to the UART as it drains, so the main loop does not
+// wait on the serial line. Once the queue fills, [MSG:] lines are dropped, and counted by
+// $Uart/Stats, to keep room for the ok and error responses that senders wait on.
+// #define UART_TX_QUEUE_SIZE 4096 // Uncomment to override the default in serial.h
+
+// Serial input is read by its own task, which the UART receive interrupt wakes. It runs above
+// the main loop and the client task, so realtime commands like feed hold are acted on at once
+// rather than when one of those next yields.
+#define SERIAL_RX_TASK_PRIORITY 2  // Above the Arduino loop task and clientCheckTask, below segment prep
+
 // A simple software debouncing feature for hard limit switches. When enabled, the limit
 // switch interrupt unblock a waiting task which will recheck the limit switch pins after
 // a short delay. Default disabled
 //#define ENABLE_SOFTWARE_DEBOUNCE // Default disabled. Uncomment to enable.
 const int DEBOUNCE_PERIOD = 32;  // in milliseconds default 32 microseconds
 
+// Hardware timer debouncing for hard limit switches, in place of ENABLE_SOFTWARE_DEBOUNCE. Each
+// limit pin edge restarts a one-shot hardware timer (timer group 1, timer 0), and the pins are
+// checked from the timer interrupt once they have been quiet for DEBOUNCE_PERIOD. No task is woken
+// per edge. A switch that keeps bouncing stops restarting the timer once its first edge is
+// DEBOUNCE_PERIOD old, so the alarm comes within twice DEBOUNCE_PERIOD of the first edge.
+// #define ENABLE_TIMER_DEBOUNCE // Default disabled. Uncomment to enable.
+
 // Configures the position after a probing cycle during Grbl's check mode. Disabled sets
 // the position to the probe target, when enabled sets the position to the start position.
 // #define SET_CHECK_MODE_PROBE_TO_START // Default disabled. Uncomment to enable.
@@ -500,7 +783,7 @@ const int DEBOUNCE_PERIOD = 32;  // in milliseconds default 32 microseconds
 // reason that this option is disabled by default. Only if your system/electronics can guarantee
 // that the switches don't bounce, we recommend enabling this option. This will help prevent
 // triggering a hard limit when the machine disengages from the switch.
-// NOTE: This option has no effect if SOFTWARE_DEBOUNCE is enabled.
+// NOTE: This option has no effect if SOFTWARE_DEBOUNCE or TIMER_DEBOUNCE is enabled.
 // #define HARD_LIMIT_FORCE_STATE_CHECK // Default disabled. Uncomment to enable.
 
 // Adjusts homing cycle search and locate scalars. These are the multipliers used by Grbl's
@@ -533,10 +816,16 @@ const int DEBOUNCE_PERIOD = 32;  // in milliseconds default 32 microseconds
 // serial Rx buffer.  GUIs should detect GCodes that write to NVS - notably G10,G28.1,G30.1 -
 // and wait for an 'ok' before sending more data.
 // NOTE: Most setting changes - $ commands - are blocked when a job is running. Coordinate setting
-// GCode commands (G10,G28/30.1) are not blocked, since they are part of an active streaming job.
-// This option forces a planner buffer sync only with such GCode commands.
+// GCode commands (G10,G28/30.1) are not blocked, since they are part of an active streaming job,
+// but they only change the copy in RAM, and the change is written once the machine has been idle
+// for COORDS_PERSIST_DELAY_MS, so they do not stall the motion.
 #define FORCE_BUFFER_SYNC_DURING_NVS_WRITE  // Default enabled. Comment to disable.
 
+// How long the machine must be idle, with no job running, before coordinate systems changed by
+// G10, G28.1 or G30.1 are written to NVS, in milliseconds. Changes not yet written when the
+// power goes are lost; a restart from $Bye or the web UI writes them first.
+#define COORDS_PERSIST_DELAY_MS 2000
+
 // In Grbl v0.9 and prior, there is an old outstanding bug where the `WPos:` work position reported
 // may not correlate to what is executing, because `WPos:` is based on the GCode parser state, which
 // can be several motions behind. This option forces the planner buffer to empty, sync, and stop
@@ -552,6 +841,15 @@ const int DEBOUNCE_PERIOD = 32;  // in milliseconds default 32 microseconds
 // repeatable. If needed, you can disable this behavior by uncommenting the define below.
 // #define ALLOW_FEED_OVERRIDE_DURING_PROBE_CYCLES // Default disabled. Uncomment to enable.
 
+// Probe edge capture. Normally the stepper interrupt reads the probe pin on every tick and takes
+// the position at the first tick after contact, which already counts the step the tick prepared
+// for the next one. With this option the probe pin has its own edge interrupt, which reads how
+// far the step timer is into the current step period and keeps only the step events that were
+// due within half a period of the edge, so the position is the step nearest to the contact. The
+// stepper interrupt no longer reads the pin, and batched RMT stepping keeps its batches while
+// probing, which allows faster probing feeds with the same repeatability.
+// #define PROBE_EDGE_CAPTURE // Default disabled. Uncomment to enable.
+
 // Enables and configures parking motion methods upon a safety door state. Primarily for OEMs
 // that desire this feature for their integrated machines. At the moment, Grbl assumes that
 // the parking motion only involves one axis, although the parking implementation was written
@@ -587,6 +885,52 @@ const double PARKING_PULLOUT_INCREMENT = 5.0;    // Spindle pull-out and plunge
 // to ensure the laser doesn't inadvertently remain powered while at a stop and cause a fire.
 #define DISABLE_LASER_DURING_HOLD  // Default enabled. Comment to disable.
 
+// In laser mode with M4, power normally follows the speed once per step segment, set to the
+// speed at the segment's end when it loads. This option ramps it instead, step by step in the
+// stepper ISR, from the speed at the start of each segment to the speed at its end, so that
+// burns stay even through acceleration. It costs a fixed point add per step, and a PWM update
+// when the power changes. With I2S streaming, the power runs ahead of the motion by the length
+// of the DMA buffers, as it already does at segment loads.
+// #define LASER_STEP_POWER  // Default disabled. Uncomment to enable.
+
+// Raster engraving in laser mode. A whole scanline is sent as one binary motion frame holding
+// a power level for each pixel, see BinaryMotion.h, and is run as one planner block along
+// which the stepper ISR changes the power at every pixel boundary. Lines are not merged, split
+// for the height map or blended. They need kinematics that keep a line in one planner block.
+// #define RASTER_ENGRAVING  // Default disabled. Uncomment to enable.
+
+// Constant surface speed for lathes. With G96, S is the cutting speed in m/min (ft/min in G20)
+// and the segment generator sets the spindle rpm from the radius of the tool, which is X in the
+// work coordinates, capped by $30. Spindles that are slow to command, like the RS485 VFDs, are
+// only given a new rpm every so often. G97 returns to S in rpm, keeping the last rpm.
+// #define CONSTANT_SURFACE_SPEED  // Default disabled. Uncomment to enable.
+
+// Kinematics for machines whose motors each drive a fixed mix of the cartesian axes, like CoreXY
+// and H-bot, without custom code. The rows of the matrix are the X, Y and Z motors and the columns
+// the cartesian X, Y and Z; the default is CoreXY, with the X motor turning by X + Y and the Y
+// motor by X - Y. The planner holds each axis's rate and acceleration to the carriage rather than
+// the motor, so the machine runs at its real limits. Axes that share a motor home one at a time.
+// #define LINEAR_KINEMATICS  // Default disabled. Uncomment to enable.
+#ifndef LINEAR_KINEMATICS_MATRIX
+#    define LINEAR_KINEMATICS_MATRIX { { 1, 1, 0 }, { 1, -1, 0 }, { 0, 0, 1 } }
+#endif
+
+// Motion synchronized user outputs. M62, M63 and M67 normally wait for the planner to drain
+// before changing the output, which stops the machine. With this option the change rides along
+// with the next motion block and the stepper ISR makes it as that block starts, without slowing
+// down. A change made while nothing is moving or queued is made at once, and one still waiting
+// for a motion is made when the buffer is next synchronized, like at a G4 or M2.
+// #define SYNC_USER_OUTPUTS  // Default disabled. Uncomment to enable.
+
+// The same for M7, M8 and M9. The block queued after the change sets the coolant as it starts,
+// instead of the program stopping for the planner to drain. Coolant overrides still act at once.
+// #define SYNC_COOLANT  // Default disabled. Uncomment to enable.
+
+// The same for an S word while the spindle runs. Each block already carries its spindle speed,
+// which the stepper ISR sets as the block starts, for PWM and VFD spindles alike. Starting,
+// stopping and reversing the spindle still drain the planner.
+// #define SYNC_SPINDLE_SPEED  // Default disabled. Uncomment to enable.
+
 // Enables a piecewise linear model of the spindle PWM/speed output. Requires a solution by the
 // 'fit_nonlinear_spindle.py' script in the /doc/script folder of the repo. See file comments
 // on how to gather spindle data and run the script to generate a solution.
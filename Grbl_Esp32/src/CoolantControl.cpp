@@ -104,11 +104,12 @@ void coolant_stop() {
 // Main program only. Immediately sets flood coolant running state and also mist coolant,
 // if enabled. Also sets a flag to report an update to a coolant state.
 // Called by coolant toggle override, parking restore, parking retract, sleep mode, g-code
-// parser program end, and g-code parser coolant_sync().
+// parser program end, and g-code parser coolant_sync(). With SYNC_COOLANT, also called by
+// the stepper ISR as a block starts, which the pin writes allow.
 
 void coolant_set_state(CoolantState state) {
-    if (sys.abort) {
-        return;  // Block during abort.
+    if (sys.abort || bench_active()) {
+        return;  // Block during abort and $Bench.
     }
     coolant_write(state);
     sys.report_ovr_counter = 0;  // Set to report change immediately
@@ -120,11 +121,22 @@ void coolant_off() {
 }
 
 // G-code parser entry-point for setting coolant state. Forces a planner buffer sync and bails
-// if an abort or check-mode is active.
+// if an abort or check-mode is active. With SYNC_COOLANT, the change waits for the next block
+// instead, unless nothing is moving or queued.
 void coolant_sync(CoolantState state) {
     if (sys.state == State::CheckMode) {
         return;
     }
+#ifdef SYNC_COOLANT
+    // The rest of an arc and a held back line come before the change.
+    mc_finish_arc();
+    mc_flush_merged_line();
+    if (plan_get_current_block() != NULL || sys.state == State::Cycle) {
+        plan_sync_coolant(state);
+        return;
+    }
+#else
     protocol_buffer_synchronize();  // Ensure coolant turns on when specified in program.
+#endif
     coolant_set_state(state);
 }
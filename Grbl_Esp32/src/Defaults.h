@@ -86,6 +86,134 @@
 #    define DEFAULT_JUNCTION_DEVIATION 0.01  // $11 mm
 #endif
 
+#ifndef DEFAULT_PLANNER_RECALCULATE_LIMIT
+#    define DEFAULT_PLANNER_RECALCULATE_LIMIT 32  // blocks, 0 for no limit
+#endif
+
+#ifndef DEFAULT_PLANNER_MERGE_TOLERANCE
+#    define DEFAULT_PLANNER_MERGE_TOLERANCE 0.0  // mm, 0 disables segment merging
+#endif
+
+#ifndef DEFAULT_PLANNER_ARC_FIT_TOLERANCE
+#    define DEFAULT_PLANNER_ARC_FIT_TOLERANCE 0.0  // mm, 0 disables arc fitting
+#endif
+
+#ifndef DEFAULT_SD_BUS
+#    define DEFAULT_SD_BUS 0  // SPI
+#endif
+
+#ifndef DEFAULT_SD_SPI_FREQUENCY
+#    define DEFAULT_SD_SPI_FREQUENCY (GRBL_SPI_FREQ / 1000)  // kHz
+#endif
+
+#ifndef DEFAULT_SD_BINARY_CACHE
+#    define DEFAULT_SD_BINARY_CACHE 0  // false
+#endif
+
+#ifndef DEFAULT_SD_ESTIMATE_TIME
+#    define DEFAULT_SD_ESTIMATE_TIME 0  // false
+#endif
+
+#ifndef DEFAULT_SD_PREVIEW
+#    define DEFAULT_SD_PREVIEW 0  // false
+#endif
+
+#ifndef DEFAULT_SD_JOB_LOG_PERIOD
+#    define DEFAULT_SD_JOB_LOG_PERIOD 0  // ms, off
+#endif
+
+#ifndef DEFAULT_HEIGHTMAP_ENABLE
+#    define DEFAULT_HEIGHTMAP_ENABLE 0  // false
+#endif
+
+#ifndef DEFAULT_HEIGHTMAP_PROBE_FEED
+#    define DEFAULT_HEIGHTMAP_PROBE_FEED 100.0  // mm/min
+#endif
+
+#ifndef DEFAULT_HEIGHTMAP_PROBE_DEPTH
+#    define DEFAULT_HEIGHTMAP_PROBE_DEPTH 10.0  // mm below the start height
+#endif
+
+#ifndef DEFAULT_PROBE_FEED
+#    define DEFAULT_PROBE_FEED 100.0  // mm/min
+#endif
+
+#ifndef DEFAULT_PROBE_DEPTH
+#    define DEFAULT_PROBE_DEPTH 10.0  // mm below the start height, for $Probe/Flatness
+#endif
+
+#ifndef DEFAULT_ATC_ENABLE
+#    define DEFAULT_ATC_ENABLE 0  // false, M6 only records the tool
+#endif
+
+#ifndef DEFAULT_ATC_SAFE_Z
+#    define DEFAULT_ATC_SAFE_Z -1.0  // mm, machine Z the tool changer travels at
+#endif
+
+#ifndef DEFAULT_ATC_CLEARANCE
+#    define DEFAULT_ATC_CLEARANCE 10.0  // mm above a pocket where the slow approach starts
+#endif
+
+#ifndef DEFAULT_ATC_FEED
+#    define DEFAULT_ATC_FEED 1000.0  // mm/min into and out of a pocket
+#endif
+
+#ifndef DEFAULT_ATC_DRAWBAR
+#    define DEFAULT_ATC_DRAWBAR -1  // M62 output that releases the tool, -1 for none
+#endif
+
+#ifndef DEFAULT_ATC_DRAWBAR_DELAY
+#    define DEFAULT_ATC_DRAWBAR_DELAY 0.5  // seconds for the drawbar to act
+#endif
+
+#ifndef DEFAULT_ATC_MEASURE
+#    define DEFAULT_ATC_MEASURE 0  // false, measure each tool on the tool setter after loading it
+#endif
+
+#ifndef DEFAULT_ATC_SETTER_X
+#    define DEFAULT_ATC_SETTER_X 0.0  // mm, machine position of the tool setter
+#endif
+
+#ifndef DEFAULT_ATC_SETTER_Y
+#    define DEFAULT_ATC_SETTER_Y 0.0
+#endif
+
+#ifndef DEFAULT_ATC_SETTER_Z
+#    define DEFAULT_ATC_SETTER_Z -1.0  // mm, machine Z the touch starts from
+#endif
+
+#ifndef DEFAULT_ATC_SETTER_DEPTH
+#    define DEFAULT_ATC_SETTER_DEPTH 100.0  // mm the fast touch may go down
+#endif
+
+#ifndef DEFAULT_ATC_SETTER_FEED
+#    define DEFAULT_ATC_SETTER_FEED 500.0  // mm/min for the fast touch
+#endif
+
+#ifndef DEFAULT_ATC_SETTER_REFERENCE
+#    define DEFAULT_ATC_SETTER_REFERENCE -100.0  // mm, machine Z where a tool of zero length touches
+#endif
+
+#ifndef DEFAULT_SERIAL_BAUD
+#    define DEFAULT_SERIAL_BAUD BAUD_RATE
+#endif
+
+#ifndef DEFAULT_SERIAL_FLOW_CONTROL
+#    define DEFAULT_SERIAL_FLOW_CONTROL 0  // RTS/CTS on SERIAL_RTS_PIN and SERIAL_CTS_PIN
+#endif
+
+#ifndef DEFAULT_KINEMATICS_CACHE_TOLERANCE
+#    define DEFAULT_KINEMATICS_CACHE_TOLERANCE 0.0  // mm, 0 disables the inverse kinematics cache
+#endif
+
+#ifndef DEFAULT_KINEMATICS_TOLERANCE
+#    define DEFAULT_KINEMATICS_TOLERANCE 0.0  // mm, 0 splits kinematic lines by segment length alone
+#endif
+
+#ifndef DEFAULT_CAPTURE_RATE
+#    define DEFAULT_CAPTURE_RATE 1000  // Hz
+#endif
+
 #ifndef DEFAULT_ARC_TOLERANCE
 #    define DEFAULT_ARC_TOLERANCE 0.002  // $12 mm
 #endif
@@ -130,6 +258,14 @@
 #    define DEFAULT_HOMING_SQUARED_AXES 0
 #endif
 
+#ifndef DEFAULT_HOMING_PARALLEL_AXES
+#    define DEFAULT_HOMING_PARALLEL_AXES 0  // Axes allowed to home together with other cycles
+#endif
+
+#ifndef DEFAULT_HOMING_FAST_REF
+#    define DEFAULT_HOMING_FAST_REF 0  // Rapid near the switches from the position saved at shutdown
+#endif
+
 #ifndef DEFAULT_HOMING_CYCLE_0
 #    define DEFAULT_HOMING_CYCLE_0 bit(Z_AXIS)
 #endif
@@ -159,6 +295,10 @@
 #    define SPINDLE_TYPE SpindleType::NONE
 #endif
 
+#ifndef SPINDLE_ALT_TYPE
+#    define SPINDLE_ALT_TYPE SpindleType::NONE  // Second head, selected with M3/M4/M5 P1
+#endif
+
 #ifndef DEFAULT_SPINDLE_RPM_MIN          // $31
 #    define DEFAULT_SPINDLE_RPM_MIN 0.0  // rpm
 #endif
@@ -191,10 +331,83 @@
 #    define DEFAULT_SPINDLE_MAX_VALUE 100.0  // $36 Percent of full period (extended set)
 #endif
 
+#ifndef DEFAULT_SPINDLE_PWM_CURVE
+#    define DEFAULT_SPINDLE_PWM_CURVE ""  // Linear between $35 and $36
+#endif
+
+#ifndef DEFAULT_STALLGUARD_MONITOR_MASK
+#    define DEFAULT_STALLGUARD_MONITOR_MASK 0  // Axes whose Trinamic drivers alarm on a stall
+#endif
+
+#ifndef DEFAULT_STALLGUARD_MONITOR_PERIOD
+#    define DEFAULT_STALLGUARD_MONITOR_PERIOD 10  // ms between SG_RESULT samples
+#endif
+
+#ifndef DEFAULT_STALLGUARD_MONITOR_DROP
+#    define DEFAULT_STALLGUARD_MONITOR_DROP 50  // Percent of the running average that is a stall
+#endif
+
+#ifndef DEFAULT_ENCODER_TOLERANCE
+#    define DEFAULT_ENCODER_TOLERANCE 0.1  // mm between an axis and its encoder before acting on it
+#endif
+
+#ifndef DEFAULT_ENCODER_ACTION
+#    define DEFAULT_ENCODER_ACTION 2  // Alarm
+#endif
+
+#ifndef DEFAULT_SYNC_ROLE
+#    define DEFAULT_SYNC_ROLE 0  // Off
+#endif
+
+#ifndef DEFAULT_SYNC_GROUP
+#    define DEFAULT_SYNC_GROUP 0
+#endif
+
+#ifndef DEFAULT_SHAPER_TYPE
+#    define DEFAULT_SHAPER_TYPE 0  // None, until the resonance has been measured
+#endif
+
+#ifndef DEFAULT_SHAPER_FREQUENCY
+#    define DEFAULT_SHAPER_FREQUENCY 40.0  // Hz of the resonance to cancel
+#endif
+
+#ifndef DEFAULT_SHAPER_DAMPING
+#    define DEFAULT_SHAPER_DAMPING 0.1  // damping ratio of the resonance
+#endif
+
+#ifndef DEFAULT_SPINDLE_PWM_RAMP
+#    define DEFAULT_SPINDLE_PWM_RAMP 0  // Seconds from off to full, 0 to switch at once
+#endif
+
 #ifndef DEFAULT_SPINDLE_DELAY_SPINUP
 #    define DEFAULT_SPINDLE_DELAY_SPINUP 0
 #endif
 
+// Adaptive feed, for VFDs that report their output current
+#ifndef DEFAULT_SPINDLE_ADAPTIVE_ENABLE
+#    define DEFAULT_SPINDLE_ADAPTIVE_ENABLE 0  // false
+#endif
+
+#ifndef DEFAULT_SPINDLE_ADAPTIVE_TARGET
+#    define DEFAULT_SPINDLE_ADAPTIVE_TARGET 4.0  // amps to hold while cutting
+#endif
+
+#ifndef DEFAULT_SPINDLE_ADAPTIVE_IDLE
+#    define DEFAULT_SPINDLE_ADAPTIVE_IDLE 1.0  // amps at or below which the tool is taken to cut air
+#endif
+
+#ifndef DEFAULT_SPINDLE_ADAPTIVE_MIN
+#    define DEFAULT_SPINDLE_ADAPTIVE_MIN 50  // percent of the feed
+#endif
+
+#ifndef DEFAULT_SPINDLE_ADAPTIVE_MAX
+#    define DEFAULT_SPINDLE_ADAPTIVE_MAX 150  // percent of the feed
+#endif
+
+#ifndef DEFAULT_SPINDLE_ADAPTIVE_GAIN
+#    define DEFAULT_SPINDLE_ADAPTIVE_GAIN 0.2  // feed percent per percent of load error, per reading
+#endif
+
 #ifndef DEFAULT_COOLANT_DELAY_TURNON
 #    define DEFAULT_COOLANT_DELAY_TURNON 1.0
 #endif
@@ -467,6 +680,141 @@
 #    define DEFAULT_C_STALLGUARD 16  // $175 stallguard (extended set)
 #endif
 
+// Encoder counts (4 per line) per mm of the axis, 0 if it has none. Negative if the encoder
+// counts up when the axis moves in the negative direction.
+#ifndef DEFAULT_X_ENCODER_COUNTS_PER_MM
+#    define DEFAULT_X_ENCODER_COUNTS_PER_MM 0.0
+#endif
+#ifndef DEFAULT_Y_ENCODER_COUNTS_PER_MM
+#    define DEFAULT_Y_ENCODER_COUNTS_PER_MM 0.0
+#endif
+#ifndef DEFAULT_Z_ENCODER_COUNTS_PER_MM
+#    define DEFAULT_Z_ENCODER_COUNTS_PER_MM 0.0
+#endif
+#ifndef DEFAULT_A_ENCODER_COUNTS_PER_MM
+#    define DEFAULT_A_ENCODER_COUNTS_PER_MM 0.0
+#endif
+#ifndef DEFAULT_B_ENCODER_COUNTS_PER_MM
+#    define DEFAULT_B_ENCODER_COUNTS_PER_MM 0.0
+#endif
+#ifndef DEFAULT_C_ENCODER_COUNTS_PER_MM
+#    define DEFAULT_C_ENCODER_COUNTS_PER_MM 0.0
+#endif
+
+// ========== Jerk (S_CURVE_ACCELERATION) ================
+#define SEC_PER_MIN_CUBE (60.0 * 60.0 * 60.0)  // Seconds Per Minute Cubed, for jerk conversion
+// Default jerk limits are expressed in mm/sec^3
+
+#ifndef DEFAULT_X_JERK
+#    define DEFAULT_X_JERK 5000.0  // mm/sec^3
+#endif
+#ifndef DEFAULT_Y_JERK
+#    define DEFAULT_Y_JERK 5000.0  // mm/sec^3
+#endif
+#ifndef DEFAULT_Z_JERK
+#    define DEFAULT_Z_JERK 5000.0  // mm/sec^3
+#endif
+#ifndef DEFAULT_A_JERK
+#    define DEFAULT_A_JERK 5000.0  // mm/sec^3
+#endif
+#ifndef DEFAULT_B_JERK
+#    define DEFAULT_B_JERK 5000.0  // mm/sec^3
+#endif
+#ifndef DEFAULT_C_JERK
+#    define DEFAULT_C_JERK 5000.0  // mm/sec^3
+#endif
+
+// ========== Per-axis junction deviation ================
+// Cornering tolerance of each axis in mm. A corner uses the values of the axes
+// that take up its change of direction, weighted by their share of it, so a
+// stiff axis can corner faster than a heavy one. 0 uses $11 for that axis.
+
+#ifndef DEFAULT_X_JUNCTION_DEVIATION
+#    define DEFAULT_X_JUNCTION_DEVIATION 0.0  // mm, 0 uses $11
+#endif
+#ifndef DEFAULT_Y_JUNCTION_DEVIATION
+#    define DEFAULT_Y_JUNCTION_DEVIATION 0.0  // mm, 0 uses $11
+#endif
+#ifndef DEFAULT_Z_JUNCTION_DEVIATION
+#    define DEFAULT_Z_JUNCTION_DEVIATION 0.0  // mm, 0 uses $11
+#endif
+#ifndef DEFAULT_A_JUNCTION_DEVIATION
+#    define DEFAULT_A_JUNCTION_DEVIATION 0.0  // mm, 0 uses $11
+#endif
+#ifndef DEFAULT_B_JUNCTION_DEVIATION
+#    define DEFAULT_B_JUNCTION_DEVIATION 0.0  // mm, 0 uses $11
+#endif
+#ifndef DEFAULT_C_JUNCTION_DEVIATION
+#    define DEFAULT_C_JUNCTION_DEVIATION 0.0  // mm, 0 uses $11
+#endif
+
+// ========== Backlash compensation ================
+// Lost motion of each axis in mm, taken up by a correction block whenever the axis reverses.
+// The correction steps are not counted into the machine position. 0 disables it for the axis.
+
+#ifndef DEFAULT_X_BACKLASH
+#    define DEFAULT_X_BACKLASH 0.0  // mm
+#endif
+#ifndef DEFAULT_Y_BACKLASH
+#    define DEFAULT_Y_BACKLASH 0.0  // mm
+#endif
+#ifndef DEFAULT_Z_BACKLASH
+#    define DEFAULT_Z_BACKLASH 0.0  // mm
+#endif
+#ifndef DEFAULT_A_BACKLASH
+#    define DEFAULT_A_BACKLASH 0.0  // mm
+#endif
+#ifndef DEFAULT_B_BACKLASH
+#    define DEFAULT_B_BACKLASH 0.0  // mm
+#endif
+#ifndef DEFAULT_C_BACKLASH
+#    define DEFAULT_C_BACKLASH 0.0  // mm
+#endif
+
+// ========== Rotary axes ================
+// 0 is a linear axis, 1 a rotary axis in degrees, 2 a rotary axis whose absolute angles are
+// taken within the current turn and 3 one whose absolute angles are reached the shorter way
+// round. Both of the last two fold the position back into the first turn when at rest.
+// The radius turns degrees into the surface distance that F is given in, 0 leaves them as mm.
+
+#ifndef DEFAULT_X_ROTARY
+#    define DEFAULT_X_ROTARY 0  // Linear
+#endif
+#ifndef DEFAULT_Y_ROTARY
+#    define DEFAULT_Y_ROTARY 0  // Linear
+#endif
+#ifndef DEFAULT_Z_ROTARY
+#    define DEFAULT_Z_ROTARY 0  // Linear
+#endif
+#ifndef DEFAULT_A_ROTARY
+#    define DEFAULT_A_ROTARY 0  // Linear
+#endif
+#ifndef DEFAULT_B_ROTARY
+#    define DEFAULT_B_ROTARY 0  // Linear
+#endif
+#ifndef DEFAULT_C_ROTARY
+#    define DEFAULT_C_ROTARY 0  // Linear
+#endif
+
+#ifndef DEFAULT_X_RADIUS
+#    define DEFAULT_X_RADIUS 0.0  // mm
+#endif
+#ifndef DEFAULT_Y_RADIUS
+#    define DEFAULT_Y_RADIUS 0.0  // mm
+#endif
+#ifndef DEFAULT_Z_RADIUS
+#    define DEFAULT_Z_RADIUS 0.0  // mm
+#endif
+#ifndef DEFAULT_A_RADIUS
+#    define DEFAULT_A_RADIUS 0.0  // mm
+#endif
+#ifndef DEFAULT_B_RADIUS
+#    define DEFAULT_B_RADIUS 0.0  // mm
+#endif
+#ifndef DEFAULT_C_RADIUS
+#    define DEFAULT_C_RADIUS 0.0  // mm
+#endif
+
 // ==================  pin defaults ========================
 
 // Here is a place to default pins to UNDEFINED_PIN.
@@ -477,6 +825,14 @@
 #    define SDCARD_DET_PIN UNDEFINED_PIN
 #endif
 
+#ifndef SERIAL_RTS_PIN
+#    define SERIAL_RTS_PIN UNDEFINED_PIN
+#endif
+
+#ifndef SERIAL_CTS_PIN
+#    define SERIAL_CTS_PIN UNDEFINED_PIN
+#endif
+
 #ifndef STEPPERS_DISABLE_PIN
 #    define STEPPERS_DISABLE_PIN UNDEFINED_PIN
 #endif
@@ -599,6 +955,12 @@
 #    define SERVO_TIMER_INTERVAL 75.0  // Hz This is the update inveral in milliseconds
 #endif
 
+// How far ahead of the steppers, in milliseconds, the servo setpoints are taken from the
+// queued motion. One update interval lets the servo arrive when the next update is sent.
+#ifndef SERVO_LOOKAHEAD_MS
+#    define SERVO_LOOKAHEAD_MS SERVO_TIMER_INTERVAL
+#endif
+
 #ifndef DYNAMIXEL_TXD
 #    define DYNAMIXEL_TXD UNDEFINED_PIN
 #endif
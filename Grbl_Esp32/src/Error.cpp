@@ -21,64 +21,179 @@
 
 #include "Error.h"
 
-std::map<Error, const char*> ErrorNames = {
-    { Error::Ok, "No error" },
-    { Error::ExpectedCommandLetter, "Expected GCodecommand letter" },
-    { Error::BadNumberFormat, "Bad GCode number format" },
-    { Error::InvalidStatement, "Invalid $ statement" },
-    { Error::NegativeValue, "Negative value" },
-    { Error::SettingDisabled, "Setting disabled" },
-    { Error::SettingStepPulseMin, "Step pulse too short" },
-    { Error::SettingReadFail, "Failed to read settings" },
-    { Error::IdleError, "Command requires idle state" },
-    { Error::SystemGcLock, "GCode cannot be executed in lock or alarm state" },
-    { Error::SoftLimitError, "Soft limit error" },
-    { Error::Overflow, "Line too long" },
-    { Error::MaxStepRateExceeded, "Max step rate exceeded" },
-    { Error::CheckDoor, "Check door" },
-    { Error::LineLengthExceeded, "Startup line too long" },
-    { Error::TravelExceeded, "Max travel exceeded during jog" },
-    { Error::InvalidJogCommand, "Invalid jog command" },
-    { Error::SettingDisabledLaser, "Laser mode requires PWM output" },
-    { Error::HomingNoCycles, "No Homing/Cycle defined in settings" },
-    { Error::GcodeUnsupportedCommand, "Unsupported GCode command" },
-    { Error::GcodeModalGroupViolation, "Gcode modal group violation" },
-    { Error::GcodeUndefinedFeedRate, "Gcode undefined feed rate" },
-    { Error::GcodeCommandValueNotInteger, "Gcode command value not integer" },
-    { Error::GcodeAxisCommandConflict, "Gcode axis command conflict" },
-    { Error::GcodeWordRepeated, "Gcode word repeated" },
-    { Error::GcodeNoAxisWords, "Gcode no axis words" },
-    { Error::GcodeInvalidLineNumber, "Gcode invalid line number" },
-    { Error::GcodeValueWordMissing, "Gcode value word missing" },
-    { Error::GcodeUnsupportedCoordSys, "Gcode unsupported coordinate system" },
-    { Error::GcodeG53InvalidMotionMode, "Gcode G53 invalid motion mode" },
-    { Error::GcodeAxisWordsExist, "Gcode extra axis words" },
-    { Error::GcodeNoAxisWordsInPlane, "Gcode no axis words in plane" },
-    { Error::GcodeInvalidTarget, "Gcode invalid target" },
-    { Error::GcodeArcRadiusError, "Gcode arc radius error" },
-    { Error::GcodeNoOffsetsInPlane, "Gcode no offsets in plane" },
-    { Error::GcodeUnusedWords, "Gcode unused words" },
-    { Error::GcodeG43DynamicAxisError, "Gcode G43 dynamic axis error" },
-    { Error::GcodeMaxValueExceeded, "Gcode max value exceeded" },
-    { Error::PParamMaxExceeded, "P param max exceeded" },
-    { Error::FsFailedMount, "Failed to mount device" },
-    { Error::FsFailedRead, "Failed to read" },
-    { Error::FsFailedOpenDir, "Failed to open directory" },
-    { Error::FsDirNotFound, "Directory not found" },
-    { Error::FsFileEmpty, "File empty" },
-    { Error::FsFileNotFound, "File not found" },
-    { Error::FsFailedOpenFile, "Failed to open file" },
-    { Error::FsFailedBusy, "Device is busy" },
-    { Error::FsFailedDelDir, "Failed to delete directory" },
-    { Error::FsFailedDelFile, "Failed to delete file" },
-    { Error::BtFailBegin, "Bluetooth failed to start" },
-    { Error::WifiFailBegin, "WiFi failed to start" },
-    { Error::NumberRange, "Number out of range for setting" },
-    { Error::InvalidValue, "Invalid value for setting" },
-    { Error::MessageFailed, "Failed to send message" },
-    { Error::NvsSetFailed, "Failed to store setting" },
-    { Error::NvsGetStatsFailed, "Failed to get setting status" },
-    { Error::AuthenticationFailed, "Authentication failed!" },
-    { Error::AnotherInterfaceBusy, "Another interface is busy" },
-    { Error::JogCancelled, "Jog Cancelled" },
-};
+#include <cstddef>
+
+// The names are string literals, so they stay in flash, and the compiler turns the switch into
+// a jump table on the code. Codes without a name give NULL.
+const char* errorString(Error errorNumber) {
+    switch (errorNumber) {
+        case Error::Ok:
+            return "No error";
+        case Error::ExpectedCommandLetter:
+            return "Expected GCodecommand letter";
+        case Error::BadNumberFormat:
+            return "Bad GCode number format";
+        case Error::InvalidStatement:
+            return "Invalid $ statement";
+        case Error::NegativeValue:
+            return "Negative value";
+        case Error::SettingDisabled:
+            return "Setting disabled";
+        case Error::SettingStepPulseMin:
+            return "Step pulse too short";
+        case Error::SettingReadFail:
+            return "Failed to read settings";
+        case Error::IdleError:
+            return "Command requires idle state";
+        case Error::SystemGcLock:
+            return "GCode cannot be executed in lock or alarm state";
+        case Error::SoftLimitError:
+            return "Soft limit error";
+        case Error::Overflow:
+            return "Line too long";
+        case Error::MaxStepRateExceeded:
+            return "Max step rate exceeded";
+        case Error::CheckDoor:
+            return "Check door";
+        case Error::LineLengthExceeded:
+            return "Startup line too long";
+        case Error::TravelExceeded:
+            return "Max travel exceeded during jog";
+        case Error::InvalidJogCommand:
+            return "Invalid jog command";
+        case Error::SettingDisabledLaser:
+            return "Laser mode requires PWM output";
+        case Error::HomingNoCycles:
+            return "No Homing/Cycle defined in settings";
+        case Error::GcodeUnsupportedCommand:
+            return "Unsupported GCode command";
+        case Error::GcodeModalGroupViolation:
+            return "Gcode modal group violation";
+        case Error::GcodeUndefinedFeedRate:
+            return "Gcode undefined feed rate";
+        case Error::GcodeCommandValueNotInteger:
+            return "Gcode command value not integer";
+        case Error::GcodeAxisCommandConflict:
+            return "Gcode axis command conflict";
+        case Error::GcodeWordRepeated:
+            return "Gcode word repeated";
+        case Error::GcodeNoAxisWords:
+            return "Gcode no axis words";
+        case Error::GcodeInvalidLineNumber:
+            return "Gcode invalid line number";
+        case Error::GcodeValueWordMissing:
+            return "Gcode value word missing";
+        case Error::GcodeUnsupportedCoordSys:
+            return "Gcode unsupported coordinate system";
+        case Error::GcodeG53InvalidMotionMode:
+            return "Gcode G53 invalid motion mode";
+        case Error::GcodeAxisWordsExist:
+            return "Gcode extra axis words";
+        case Error::GcodeNoAxisWordsInPlane:
+            return "Gcode no axis words in plane";
+        case Error::GcodeInvalidTarget:
+            return "Gcode invalid target";
+        case Error::GcodeArcRadiusError:
+            return "Gcode arc radius error";
+        case Error::GcodeNoOffsetsInPlane:
+            return "Gcode no offsets in plane";
+        case Error::GcodeUnusedWords:
+            return "Gcode unused words";
+        case Error::GcodeG43DynamicAxisError:
+            return "Gcode G43 dynamic axis error";
+        case Error::GcodeMaxValueExceeded:
+            return "Gcode max value exceeded";
+        case Error::PParamMaxExceeded:
+            return "P param max exceeded";
+        case Error::FsFailedMount:
+            return "Failed to mount device";
+        case Error::FsFailedRead:
+            return "Failed to read";
+        case Error::FsFailedOpenDir:
+            return "Failed to open directory";
+        case Error::FsDirNotFound:
+            return "Directory not found";
+        case Error::FsFileEmpty:
+            return "File empty";
+        case Error::FsFileNotFound:
+            return "File not found";
+        case Error::FsFailedOpenFile:
+            return "Failed to open file";
+        case Error::FsFailedBusy:
+            return "Device is busy";
+        case Error::FsFailedDelDir:
+            return "Failed to delete directory";
+        case Error::FsFailedDelFile:
+            return "Failed to delete file";
+        case Error::BtFailBegin:
+            return "Bluetooth failed to start";
+        case Error::WifiFailBegin:
+            return "WiFi failed to start";
+        case Error::NumberRange:
+            return "Number out of range for setting";
+        case Error::InvalidValue:
+            return "Invalid value for setting";
+        case Error::MessageFailed:
+            return "Failed to send message";
+        case Error::NvsSetFailed:
+            return "Failed to store setting";
+        case Error::NvsGetStatsFailed:
+            return "Failed to get setting status";
+        case Error::AuthenticationFailed:
+            return "Authentication failed!";
+        case Error::AnotherInterfaceBusy:
+            return "Another interface is busy";
+        case Error::JogCancelled:
+            return "Jog Cancelled";
+        case Error::HeightMapIncomplete:
+            return "Height map probing did not complete";
+        case Error::ProbeRoutineIncomplete:
+            return "Probing routine did not complete";
+        case Error::BinaryFrameInvalid:
+            return "Binary motion frame is malformed";
+        case Error::RasterNotLaserMode:
+            return "Raster lines need laser mode";
+        case Error::GcodeOWordInvalid:
+            return "Invalid or unmatched O-word";
+        case Error::GcodeOWordOverflow:
+            return "O-word storage or nesting exceeded";
+        case Error::GcodeOWordUndefined:
+            return "Subroutine not defined";
+        case Error::GcodeExpressionInvalid:
+            return "Invalid expression";
+        case Error::GcodeParameterInvalid:
+            return "Invalid or undefined parameter";
+        case Error::GcodeCannedCycleInvalid:
+            return "Invalid canned cycle words or mode";
+        case Error::GcodeSpindleSyncInvalid:
+            return "Invalid spindle synchronized motion";
+        case Error::GcodeSpindleHeadInvalid:
+            return "Spindle head not configured";
+        case Error::FsFailedCompile:
+            return "Failed to compile file";
+        case Error::ProfileInvalid:
+            return "Invalid settings profile";
+        case Error::ProfileSaveFailed:
+            return "Failed to save settings profile";
+        case Error::StepTraceNoMemory:
+            return "No memory for the step trace";
+        case Error::ToolNumberInvalid:
+            return "Tool number is not in the tool table";
+        case Error::ToolNoPocket:
+            return "Tool has no pocket in the rack";
+        case Error::ToolChangeFailed:
+            return "Tool change did not complete";
+        case Error::LineChecksum:
+            return "Line checksum mismatch";
+        case Error::LineOutOfSequence:
+            return "Line number out of sequence";
+        case Error::CommandDropped:
+            return "Reset before the command ran";
+        case Error::CaptureFailed:
+            return "Position capture could not start";
+        case Error::PlannerNoMemory:
+            return "No memory for the planner buffer";
+        default:
+            return NULL;
+    }
+}
@@ -21,7 +21,7 @@
   along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <map>
+#include <cstdint>
 
 // Grbl error codes. Valid values (0-255)
 enum class Error : uint8_t {
@@ -85,6 +85,32 @@ enum class Error : uint8_t {
     Eol                         = 111,
     AnotherInterfaceBusy        = 120,
     JogCancelled                = 130,
+    HeightMapIncomplete         = 140,
+    ProbeRoutineIncomplete      = 141,
+    BinaryFrameInvalid          = 150,
+    RasterNotLaserMode          = 151,
+    GcodeOWordInvalid           = 160,
+    GcodeOWordOverflow          = 161,
+    GcodeOWordUndefined         = 162,
+    GcodeExpressionInvalid      = 170,
+    GcodeParameterInvalid       = 171,
+    GcodeCannedCycleInvalid     = 180,
+    GcodeSpindleSyncInvalid     = 181,
+    GcodeSpindleHeadInvalid     = 182,
+    FsFailedCompile             = 190,  // SD file could not be compiled
+    ProfileInvalid              = 200,
+    ProfileSaveFailed           = 201,
+    StepTraceNoMemory           = 210,
+    PlannerNoMemory             = 211,
+    ToolNumberInvalid           = 220,
+    ToolNoPocket                = 221,
+    ToolChangeFailed            = 222,
+    LineChecksum                = 230,
+    LineOutOfSequence           = 231,
+    CommandDropped              = 240,
+    CaptureFailed               = 250,
 };
 
-extern std::map<Error, const char*> ErrorNames;
+// The name of an error, for verbose errors and $E, or NULL if it has none. Takes no heap and
+// constant time, so it can be used on every response.
+const char* errorString(Error errorNumber);
@@ -0,0 +1,247 @@
+/*
+  EspNowSync.cpp - Hold, resume and block starts shared between controllers over ESP-NOW
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  Frames are broadcast on the channel WiFi is already on, so the boards must be on the same
+  access point, or the followers on the leader's. A frame takes about a millisecond, which
+  is how closely the followers start and hold with the leader. Block starts are timed on the
+  leader's clock; the follower takes the fastest frame it has seen as the clock offset, so
+  the lag it reports is late by that frame's time in the air.
+*/
+
+#include "Config.h"
+#ifdef ENABLE_ESP_NOW_SYNC
+#    include "Grbl.h"
+#    include <esp_now.h>
+
+#    ifndef ENABLE_WIFI
+#        error "ENABLE_ESP_NOW_SYNC needs ENABLE_WIFI"
+#    endif
+
+static const uint8_t broadcast_mac[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+
+static bool      sync_started = false;
+static SyncRole  sync_started_role;
+static uint16_t  sync_sequence;
+static uint32_t  sync_sent;
+static SyncEvent sync_last_event = SyncEvent::Stop;
+static uint32_t  sync_heartbeat_ms;
+
+static plan_block_t* sync_last_block;
+
+// Written by the receive callback in the WiFi task.
+static volatile bool     leader_running;
+static volatile bool     leader_held;  // By a hold or alarm, so its next start is a resume
+static volatile uint32_t sync_received;
+static volatile uint32_t sync_lost;
+static volatile uint16_t sync_expected;
+static volatile uint32_t sync_heard_ms;
+static volatile int64_t  sync_offset_us = INT64_MAX;  // Follower's clock less the leader's, fastest frame
+static volatile uint32_t leader_line;
+static volatile int64_t  leader_line_us;  // On the follower's clock
+
+static float    sync_lag_ms;
+static float    sync_lag_max_ms;
+static uint32_t sync_lag_line;
+
+static SyncRole sync_role() {
+    return static_cast<SyncRole>(sync_role_setting->get());
+}
+
+static void sync_send(SyncEvent event, uint32_t line) {
+    SyncMessage msg = { { 'G', 'S' }, uint8_t(sync_group->get()), event, sync_sequence++, line, esp_timer_get_time() };
+    if (esp_now_send(broadcast_mac, (const uint8_t*)&msg, sizeof(msg)) == ESP_OK) {
+        sync_sent++;
+    }
+    sync_heartbeat_ms = millis() + SYNC_HEARTBEAT_MS;
+}
+
+static void sync_receive(const uint8_t* mac, const uint8_t* data, int len) {
+    if (len != sizeof(SyncMessage) || sync_role() != SyncRole::Follower) {
+        return;
+    }
+    SyncMessage msg;
+    memcpy(&msg, data, sizeof(msg));
+    if (msg.magic[0] != 'G' || msg.magic[1] != 'S' || msg.group != sync_group->get()) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    if (sync_received && msg.sequence != sync_expected) {
+        sync_lost += uint16_t(msg.sequence - sync_expected);
+    }
+    sync_expected = msg.sequence + 1;
+    sync_received++;
+    sync_heard_ms = millis();
+    if (now - msg.time_us < sync_offset_us) {
+        sync_offset_us = now - msg.time_us;
+    }
+    switch (msg.event) {
+        case SyncEvent::Stop:
+            leader_running = false;
+            leader_held    = false;
+            break;
+        case SyncEvent::BlockStart:
+            leader_line    = msg.line;
+            leader_line_us = msg.time_us + sync_offset_us;
+            // fall through
+        case SyncEvent::CycleStart:
+            leader_running = true;
+            // Only the leader's resume resumes; a hold of the follower's own is left alone.
+            if (leader_held && sys.state == State::Hold && sys.suspend.bit.holdComplete) {
+                sys_rt_exec_state.bit.cycleStart = true;
+            }
+            leader_held = false;
+            break;
+        case SyncEvent::FeedHold:
+        case SyncEvent::Alarm:
+            leader_running = false;
+            leader_held    = true;
+            if (sys.state == State::Cycle || sys.state == State::Jog) {
+                sys_rt_exec_state.bit.feedHold = true;
+            }
+            break;
+    }
+}
+
+static bool sync_start(SyncRole role) {
+    if (esp_now_init() != ESP_OK) {
+        return false;
+    }
+    if (role == SyncRole::Leader) {
+        esp_now_peer_info_t peer = {};
+        memcpy(peer.peer_addr, broadcast_mac, sizeof(broadcast_mac));
+        peer.ifidx = WiFi.getMode() == WIFI_AP ? WIFI_IF_AP : WIFI_IF_STA;
+        if (esp_now_add_peer(&peer) != ESP_OK) {
+            esp_now_deinit();
+            return false;
+        }
+    } else {
+        esp_now_register_recv_cb(sync_receive);
+    }
+    leader_running = false;
+    leader_held    = false;
+    sync_offset_us = INT64_MAX;
+    grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "Sync %s on group %d", role == SyncRole::Leader ? "leader" : "follower", sync_group->get());
+    return true;
+}
+
+static void sync_stop() {
+    esp_now_unregister_recv_cb();
+    esp_now_deinit();
+    sync_started   = false;
+    leader_running = false;
+}
+
+// The event the leader's state stands for.
+static SyncEvent sync_state_event() {
+    switch (sys.state) {
+        case State::Cycle:
+        case State::Jog:
+        case State::Homing:
+            return SyncEvent::CycleStart;
+        case State::Hold:
+        case State::SafetyDoor:
+            return SyncEvent::FeedHold;
+        case State::Alarm:
+            return SyncEvent::Alarm;
+        default:
+            return SyncEvent::Stop;
+    }
+}
+
+static uint32_t sync_block_line(plan_block_t* block) {
+#    ifdef USE_LINE_NUMBERS
+    return block ? block->line_number : 0;
+#    else
+    return 0;
+#    endif
+}
+
+static void sync_lead() {
+    SyncEvent event = sync_state_event();
+    if (event != sync_last_event) {
+        sync_last_event = event;
+        sync_last_block = NULL;
+        sync_send(event, 0);
+    }
+    plan_block_t* block = plan_get_current_block();
+    if (event == SyncEvent::CycleStart && block && block != sync_last_block) {
+        sync_last_block = block;
+        sync_send(SyncEvent::BlockStart, sync_block_line(block));
+    } else if (int32_t(millis() - sync_heartbeat_ms) >= 0) {
+        sync_send(event, 0);
+    }
+}
+
+static void sync_follow() {
+#    ifdef USE_LINE_NUMBERS
+    if (sys.state != State::Cycle) {
+        return;
+    }
+    uint32_t line = sync_block_line(plan_get_current_block());
+    if (line && line != sync_lag_line && line == leader_line) {
+        sync_lag_line   = line;
+        sync_lag_ms     = (esp_timer_get_time() - leader_line_us) / 1000.0;
+        sync_lag_max_ms = MAX(sync_lag_max_ms, fabsf(sync_lag_ms));
+    }
+#    endif
+}
+
+void esp_now_sync_poll() {
+    SyncRole role = sync_role();
+    bool     up   = WiFi.getMode() != WIFI_OFF;
+    if (sync_started && (!up || role != sync_started_role)) {
+        sync_stop();
+    }
+    if (!sync_started) {
+        if (role == SyncRole::Off || !up || !sync_start(role)) {
+            return;
+        }
+        sync_started      = true;
+        sync_started_role = role;
+    }
+    if (role == SyncRole::Leader) {
+        sync_lead();
+    } else {
+        sync_follow();
+    }
+}
+
+bool esp_now_sync_hold_start() {
+    return sync_started && sync_started_role == SyncRole::Follower && !leader_running;
+}
+
+void esp_now_sync_report(uint8_t client) {
+    SyncRole role = sync_role();
+    if (role == SyncRole::Off) {
+        grbl_sendf(client, "[SYNC:Off]\r\n");
+    } else if (!sync_started) {
+        grbl_sendf(client, "[SYNC:%s,waiting for WiFi]\r\n", role == SyncRole::Leader ? "Leader" : "Follower");
+    } else if (role == SyncRole::Leader) {
+        grbl_sendf(client, "[SYNC:Leader,Group %d,Sent %u]\r\n", sync_group->get(), sync_sent);
+    } else if (!sync_received) {
+        grbl_sendf(client, "[SYNC:Follower,Group %d,No leader heard]\r\n", sync_group->get());
+    } else {
+        grbl_sendf(client,
+                   "[SYNC:Follower,Group %d,Received %u,Lost %u,Heard %u ms ago,Leader %s,Lag %.1f ms,Max lag %.1f ms]\r\n",
+                   sync_group->get(),
+                   sync_received,
+                   sync_lost,
+                   millis() - sync_heard_ms,
+                   leader_running ? "running" : "stopped",
+                   sync_lag_ms,
+                   sync_lag_max_ms);
+    }
+}
+#endif
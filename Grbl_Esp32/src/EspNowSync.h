@@ -0,0 +1,64 @@
+#pragma once
+
+/*
+  EspNowSync.h - Hold, resume and block starts shared between controllers over ESP-NOW
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdint>
+
+#ifdef ENABLE_ESP_NOW_SYNC
+
+// $Sync/Role
+enum class SyncRole : int8_t {
+    Off      = 0,
+    Leader   = 1,  // Broadcasts its cycle starts, holds, alarms and block starts
+    Follower = 2,  // Starts, holds and resumes with the leader of its $Sync/Group
+};
+
+// What a leader broadcasts. Each is sent when it happens and the state is repeated every
+// SYNC_HEARTBEAT_MS, so a follower that missed a frame catches up.
+enum class SyncEvent : uint8_t {
+    Stop       = 0,  // Idle, nothing running
+    CycleStart = 1,
+    FeedHold   = 2,
+    Alarm      = 3,
+    BlockStart = 4,  // The segment generator started the block of line
+};
+
+struct __attribute__((packed)) SyncMessage {
+    char      magic[2];  // "GS"
+    uint8_t   group;     // $Sync/Group of the leader
+    SyncEvent event;
+    uint16_t  sequence;  // Per frame, so a follower can count the lost ones
+    uint32_t  line;      // Of the block, with USE_LINE_NUMBERS
+    int64_t   time_us;   // Leader's esp_timer_get_time() when it happened
+};
+
+#    ifndef SYNC_HEARTBEAT_MS
+#        define SYNC_HEARTBEAT_MS 250
+#    endif
+
+// Starts ESP-NOW once WiFi is up, sends what the leader did and acts on what the follower
+// heard. Called from the realtime loop.
+void esp_now_sync_poll();
+
+// True while a follower must not start the motion it has queued: until the leader runs.
+bool esp_now_sync_hold_start();
+
+// Sends the role, frame counts and, for a follower with line numbers, how far its block
+// starts trail the leader's.
+void esp_now_sync_report(uint8_t client);
+
+#endif
@@ -0,0 +1,110 @@
+/*
+  EventTrace.cpp - Ring of timed events from the hot paths, for finding stalls in the field
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  Writers take a slot with one atomic increment and fill it in, so any task on either core
+  can record without a lock. Times are esp_timer microseconds rather than cycle counts,
+  because each core has its own cycle counter and the events of both go on one time line.
+  In the Chrome trace each task is a thread, named from FreeRTOS, and the core an event ran
+  on is in its args.
+*/
+
+#include "Config.h"
+#ifdef EVENT_TRACE
+#    include "Grbl.h"
+
+#    include <atomic>
+
+typedef struct {
+    uint32_t     time_us;
+    uint32_t     arg;
+    TaskHandle_t task;
+    TraceEvent   event;
+    bool         begin;
+    uint8_t      core;
+} trace_entry_t;
+
+static trace_entry_t         trace_ring[EVENT_TRACE_ENTRIES];
+static std::atomic<uint32_t> trace_next;  // Slots taken since the last clear
+static volatile bool         trace_paused;
+
+// By TraceEvent
+static const char* const trace_names[] = {
+    "gc_execute_line", "plan_buffer_line", "st_prep_buffer", "clientCheckTask", "vfd_cmd_task", "i2sOutTask",
+};
+
+void IRAM_ATTR event_trace_record(TraceEvent event, bool begin, uint32_t arg) {
+    if (trace_paused) {
+        return;
+    }
+    trace_entry_t* entry = &trace_ring[trace_next.fetch_add(1) & (EVENT_TRACE_ENTRIES - 1)];
+    entry->time_us       = esp_timer_get_time();
+    entry->arg           = arg;
+    entry->task          = xTaskGetCurrentTaskHandle();
+    entry->event         = event;
+    entry->begin         = begin;
+    entry->core          = xPortGetCoreID();
+}
+
+void event_trace_clear() {
+    trace_next = 0;
+}
+
+void event_trace_report(uint8_t client) {
+    trace_paused   = true;
+    uint32_t count = trace_next;
+    uint32_t first = 0;
+    if (count > EVENT_TRACE_ENTRIES) {
+        first = count - EVENT_TRACE_ENTRIES;
+    }
+    uint32_t start = trace_ring[first & (EVENT_TRACE_ENTRIES - 1)].time_us;
+
+    // One thread name per task, ahead of the events.
+    const int    max_tasks = 16;
+    TaskHandle_t tasks[max_tasks];
+    int          n_tasks = 0;
+    grbl_send(client, "{\"traceEvents\":[\r\n");
+    const char* separator = "";
+    for (uint32_t i = first; i < count; i++) {
+        TaskHandle_t task = trace_ring[i & (EVENT_TRACE_ENTRIES - 1)].task;
+        int          t;
+        for (t = 0; t < n_tasks && tasks[t] != task; t++) {}
+        if (t == n_tasks && n_tasks < max_tasks) {
+            tasks[n_tasks++] = task;
+            grbl_sendf(client,
+                       "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}\r\n",
+                       separator,
+                       uint32_t(uintptr_t(task)),
+                       pcTaskGetTaskName(task));
+            separator = ",";
+        }
+    }
+    for (uint32_t i = first; i < count; i++) {
+        trace_entry_t* entry = &trace_ring[i & (EVENT_TRACE_ENTRIES - 1)];
+        grbl_sendf(client,
+                   "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%u,\"pid\":0,\"tid\":%u,\"args\":{\"arg\":%u,\"core\":%u}}\r\n",
+                   separator,
+                   trace_names[int(entry->event)],
+                   entry->begin ? 'B' : 'E',
+                   entry->time_us - start,
+                   uint32_t(uintptr_t(entry->task)),
+                   entry->arg,
+                   entry->core);
+        separator = ",";
+    }
+    grbl_send(client, "]}\r\n");
+    event_trace_clear();
+    trace_paused = false;
+}
+#endif
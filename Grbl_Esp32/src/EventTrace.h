@@ -0,0 +1,63 @@
+#pragma once
+
+/*
+  EventTrace.h - Ring of timed events from the hot paths, for finding stalls in the field
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Config.h"
+
+#include <cstdint>
+
+enum class TraceEvent : uint8_t {
+    GCodeLine = 0,   // gc_execute_line(), arg is the client
+    PlanBufferLine,  // plan_buffer_line(), arg is the blocks already queued
+    PrepBuffer,      // st_prep_buffer(), arg is the segments already queued
+    ClientCheck,     // One pass of clientCheckTask()
+    VfdCommand,      // One RS485 transaction of the VFD task, arg is the Modbus function code
+    I2SFill,         // One DMA buffer refilled by the I2S task, arg is the pulser status
+    Count,
+};
+
+// Events kept. Once the ring is full each new one replaces the oldest. Must be a power of two.
+const uint32_t EVENT_TRACE_ENTRIES = 1024;
+
+// Records the start or the end of event in the calling task. Safe from any task, with
+// interrupts off or in an interrupt.
+void event_trace_record(TraceEvent event, bool begin, uint32_t arg);
+
+// Sends the events in the ring as a Chrome trace, JSON that chrome://tracing and Perfetto
+// open, and clears it. Recording pauses while it is sent.
+void event_trace_report(uint8_t client);
+void event_trace_clear();
+
+#ifdef EVENT_TRACE
+// Records the start of event and, when it goes out of scope, the end.
+class EventTraceScope {
+public:
+    EventTraceScope(TraceEvent event, uint32_t arg) : _event(event) { event_trace_record(event, true, arg); }
+    ~EventTraceScope() { event_trace_record(_event, false, 0); }
+
+private:
+    TraceEvent _event;
+};
+
+#    define TRACE_SCOPE(event, arg) EventTraceScope event_trace_scope(TraceEvent::event, arg)
+#    define TRACE_BEGIN(event, arg) event_trace_record(TraceEvent::event, true, arg)
+#    define TRACE_END(event, arg) event_trace_record(TraceEvent::event, false, arg)
+#else
+#    define TRACE_SCOPE(event, arg)
+#    define TRACE_BEGIN(event, arg)
+#    define TRACE_END(event, arg)
+#endif
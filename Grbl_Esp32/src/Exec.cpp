@@ -1,15 +1,37 @@
 #include "Exec.h"
 
-std::map<ExecAlarm, const char*> AlarmNames = {
-    { ExecAlarm::None, "None"},
-    { ExecAlarm::HardLimit, "Hard Limit"},
-    { ExecAlarm::SoftLimit, "Soft Limit"},
-    { ExecAlarm::AbortCycle, "Abort Cycle"},
-    { ExecAlarm::ProbeFailInitial, "Probe Fail Initial"},
-    { ExecAlarm::ProbeFailContact, "Probe Fail Contact"},
-    { ExecAlarm::HomingFailReset, "Homing Fail Reset"},
-    { ExecAlarm::HomingFailDoor, "Homing Fail Door"},
-    { ExecAlarm::HomingFailPulloff, "Homing Fail Pulloff"},
-    { ExecAlarm::HomingFailApproach, "Homing Fail Approach"},
-    { ExecAlarm::SpindleControl, "Spindle Control"},
-};
+#include <cstddef>
+
+// As errorString(), in flash with no lookup structure.
+const char* alarmString(ExecAlarm alarmNumber) {
+    switch (alarmNumber) {
+        case ExecAlarm::None:
+            return "None";
+        case ExecAlarm::HardLimit:
+            return "Hard Limit";
+        case ExecAlarm::SoftLimit:
+            return "Soft Limit";
+        case ExecAlarm::AbortCycle:
+            return "Abort Cycle";
+        case ExecAlarm::ProbeFailInitial:
+            return "Probe Fail Initial";
+        case ExecAlarm::ProbeFailContact:
+            return "Probe Fail Contact";
+        case ExecAlarm::HomingFailReset:
+            return "Homing Fail Reset";
+        case ExecAlarm::HomingFailDoor:
+            return "Homing Fail Door";
+        case ExecAlarm::HomingFailPulloff:
+            return "Homing Fail Pulloff";
+        case ExecAlarm::HomingFailApproach:
+            return "Homing Fail Approach";
+        case ExecAlarm::SpindleControl:
+            return "Spindle Control";
+        case ExecAlarm::MotorStall:
+            return "Motor Stall";
+        case ExecAlarm::FollowingError:
+            return "Following Error";
+        default:
+            return NULL;
+    }
+}
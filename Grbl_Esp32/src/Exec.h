@@ -1,6 +1,6 @@
 #pragma once
 
-#include <map>
+#include <cstdint>
 
 // System executor bit map. Used internally by realtime protocol as realtime command flags,
 // which notifies the main program to execute the specified realtime command asynchronously.
@@ -52,6 +52,9 @@ enum class ExecAlarm : uint8_t {
     HomingFailPulloff  = 8,
     HomingFailApproach = 9,
     SpindleControl     = 10,
+    MotorStall         = 11,
+    FollowingError     = 12,
 };
 
-extern std::map<ExecAlarm, const char*> AlarmNames;
+// The name of an alarm, for $A, or NULL if it has none.
+const char* alarmString(ExecAlarm alarmNumber);
@@ -0,0 +1,642 @@
+/*
+  Expression.cpp - G-code parameters and [expression] evaluation
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  Expressions are compiled by recursive descent into a short RPN program, in which parameters
+  are referred to by slot, so the program holds no values and can be kept and rerun. Named
+  parameters take the slots after the numbered ones. Lines are expanded by replacing each value
+  with its number, so the parser itself never sees a parameter or an expression.
+*/
+
+#include "Grbl.h"
+
+enum class ExprOp : uint8_t {
+    Number,
+    Parameter,
+    Indirect,  // Parameter whose number is on the stack
+    Negate,
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Modulo,
+    Power,
+    Eq,
+    Ne,
+    Gt,
+    Ge,
+    Lt,
+    Le,
+    And,
+    Or,
+    Xor,
+    Abs,
+    Acos,
+    Asin,
+    Atan,
+    Atan2,
+    Cos,
+    Exp,
+    Fix,
+    Fup,
+    Ln,
+    Round,
+    Sin,
+    Sqrt,
+    Tan,
+};
+
+typedef struct {
+    ExprOp  op;
+    uint8_t slot;
+    float   value;
+} expr_token_t;
+
+const int EXPR_MAX_TOKENS   = 32;
+const int EXPR_STACK_DEPTH  = 16;
+const int EXPR_CACHE_SIZE   = 8;
+const int EXPR_CACHE_LENGTH = 63;  // Longer expressions are compiled every time
+const int EXPR_MAX_ASSIGN   = 8;   // Assignments on one line
+
+typedef struct {
+    expr_token_t token[EXPR_MAX_TOKENS];
+    uint8_t      n_tokens;
+} expr_program_t;
+
+typedef struct {
+    char           text[EXPR_CACHE_LENGTH + 1];  // Empty for an unused entry
+    expr_program_t program;
+} expr_cache_entry_t;
+
+static float              parameters[EXPR_NUMBERED_PARAMETERS + EXPR_NAMED_PARAMETERS];
+static char               names[EXPR_NAMED_PARAMETERS][EXPR_NAME_LENGTH + 1];
+static uint8_t            n_names;
+static expr_cache_entry_t expr_cache[EXPR_CACHE_SIZE];
+static uint8_t            expr_cache_next;
+static expr_program_t     scratch;  // Program of an expression that is not cached
+
+static const struct {
+    const char* name;
+    ExprOp      op;
+} functions[] = {
+    { "ABS", ExprOp::Abs },     { "ACOS", ExprOp::Acos }, { "ASIN", ExprOp::Asin }, { "ATAN", ExprOp::Atan }, { "COS", ExprOp::Cos },
+    { "EXP", ExprOp::Exp },     { "FIX", ExprOp::Fix },   { "FUP", ExprOp::Fup },   { "LN", ExprOp::Ln },     { "ROUND", ExprOp::Round },
+    { "SIN", ExprOp::Sin },     { "SQRT", ExprOp::Sqrt }, { "TAN", ExprOp::Tan },
+};
+
+static const struct {
+    const char* name;
+    ExprOp      op;
+} relations[] = {
+    { "EQ", ExprOp::Eq }, { "NE", ExprOp::Ne }, { "GT", ExprOp::Gt }, { "GE", ExprOp::Ge }, { "LT", ExprOp::Lt }, { "LE", ExprOp::Le },
+};
+
+typedef struct {
+    const char*     s;
+    expr_program_t* program;
+    Error           status;
+} compiler_t;
+
+static void emit(compiler_t* c, ExprOp op, uint8_t slot = 0, float value = 0.0) {
+    expr_program_t* p = c->program;
+    if (p->n_tokens == EXPR_MAX_TOKENS) {
+        c->status = Error::GcodeExpressionInvalid;
+        return;
+    }
+    p->token[p->n_tokens++] = { op, slot, value };
+}
+
+static bool accept(compiler_t* c, const char* text) {
+    size_t length = strlen(text);
+    if (strncmp(c->s, text, length) == 0) {
+        c->s += length;
+        return true;
+    }
+    return false;
+}
+
+static void expect(compiler_t* c, char ch) {
+    if (*c->s != ch) {
+        c->status = Error::GcodeExpressionInvalid;
+        return;
+    }
+    c->s++;
+}
+
+// Reads a parameter name after #<, up to and including the >.
+static bool read_name(const char** s, char* name) {
+    uint8_t length = 0;
+    while (**s && **s != '>') {
+        if (length == EXPR_NAME_LENGTH) {
+            return false;
+        }
+        name[length++] = *(*s)++;
+    }
+    name[length] = '\0';
+    if (**s != '>' || length == 0) {
+        return false;
+    }
+    (*s)++;
+    return true;
+}
+
+static int find_name(const char* name) {
+    for (uint8_t i = 0; i < n_names; i++) {
+        if (strcmp(names[i], name) == 0) {
+            return EXPR_NUMBERED_PARAMETERS + i;
+        }
+    }
+    return -1;
+}
+
+// Reads the parameter number or name after a #. Returns its slot, or -1.
+static int read_slot(const char** s, bool create) {
+    if (isdigit(**s)) {
+        int number = 0;
+        while (isdigit(**s)) {
+            number = number * 10 + *(*s)++ - '0';
+            if (number >= EXPR_NUMBERED_PARAMETERS) {
+                return -1;
+            }
+        }
+        return number ? number : -1;
+    }
+    char name[EXPR_NAME_LENGTH + 1];
+    if (**s != '<') {
+        return -1;
+    }
+    (*s)++;
+    if (!read_name(s, name)) {
+        return -1;
+    }
+    int slot = find_name(name);
+    if (slot < 0 && create && n_names < EXPR_NAMED_PARAMETERS) {
+        strcpy(names[n_names], name);
+        parameters[EXPR_NUMBERED_PARAMETERS + n_names] = 0.0;
+        slot                                           = EXPR_NUMBERED_PARAMETERS + n_names++;
+    }
+    return slot;
+}
+
+static void compile_expression(compiler_t* c);
+static void compile_unary(compiler_t* c);
+
+static void compile_primary(compiler_t* c) {
+    char ch = *c->s;
+    if (ch == '[') {
+        c->s++;
+        compile_expression(c);
+        expect(c, ']');
+    } else if (ch == '#') {
+        c->s++;
+        if (*c->s == '[' || *c->s == '#') {
+            compile_primary(c);  // #[expression] and ##n read the parameter numbered by the value.
+            emit(c, ExprOp::Indirect);
+        } else {
+            int slot = read_slot(&c->s, false);
+            if (slot < 0) {
+                c->status = Error::GcodeParameterInvalid;
+                return;
+            }
+            emit(c, ExprOp::Parameter, slot);
+        }
+    } else if (isdigit(ch) || ch == '.') {
+        uint8_t char_counter = 0;
+        float   value;
+        if (!read_float(c->s, &char_counter, &value)) {
+            c->status = Error::GcodeExpressionInvalid;
+            return;
+        }
+        c->s += char_counter;
+        emit(c, ExprOp::Number, 0, value);
+    } else {
+        for (auto& function : functions) {
+            if (accept(c, function.name)) {
+                expect(c, '[');
+                compile_expression(c);
+                expect(c, ']');
+                if (function.op == ExprOp::Atan && accept(c, "/")) {
+                    expect(c, '[');
+                    compile_expression(c);
+                    expect(c, ']');
+                    emit(c, ExprOp::Atan2);
+                } else {
+                    emit(c, function.op);
+                }
+                return;
+            }
+        }
+        c->status = Error::GcodeExpressionInvalid;
+    }
+}
+
+static void compile_unary(compiler_t* c) {
+    if (accept(c, "-")) {
+        compile_unary(c);
+        emit(c, ExprOp::Negate);
+    } else if (accept(c, "+")) {
+        compile_unary(c);
+    } else {
+        compile_primary(c);
+    }
+}
+
+static void compile_power(compiler_t* c) {
+    compile_unary(c);
+    while (c->status == Error::Ok && accept(c, "**")) {
+        compile_unary(c);
+        emit(c, ExprOp::Power);
+    }
+}
+
+static void compile_product(compiler_t* c) {
+    compile_power(c);
+    while (c->status == Error::Ok) {
+        ExprOp op;
+        if (accept(c, "*")) {
+            op = ExprOp::Multiply;
+        } else if (accept(c, "/")) {
+            op = ExprOp::Divide;
+        } else if (accept(c, "MOD")) {
+            op = ExprOp::Modulo;
+        } else {
+            return;
+        }
+        compile_power(c);
+        emit(c, op);
+    }
+}
+
+static void compile_sum(compiler_t* c) {
+    compile_product(c);
+    while (c->status == Error::Ok) {
+        ExprOp op;
+        if (accept(c, "+")) {
+            op = ExprOp::Add;
+        } else if (accept(c, "-")) {
+            op = ExprOp::Subtract;
+        } else {
+            return;
+        }
+        compile_product(c);
+        emit(c, op);
+    }
+}
+
+static void compile_relation(compiler_t* c) {
+    compile_sum(c);
+    while (c->status == Error::Ok) {
+        bool found = false;
+        for (auto& relation : relations) {
+            if (accept(c, relation.name)) {
+                compile_sum(c);
+                emit(c, relation.op);
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            return;
+        }
+    }
+}
+
+static void compile_expression(compiler_t* c) {
+    compile_relation(c);
+    while (c->status == Error::Ok) {
+        ExprOp op;
+        if (accept(c, "AND")) {
+            op = ExprOp::And;
+        } else if (accept(c, "OR")) {
+            op = ExprOp::Or;
+        } else if (accept(c, "XOR")) {
+            op = ExprOp::Xor;
+        } else {
+            return;
+        }
+        compile_relation(c);
+        emit(c, op);
+    }
+}
+
+static Error run(const expr_program_t* p, float* result) {
+    float stack[EXPR_STACK_DEPTH];
+    int   sp = 0;
+    for (uint8_t i = 0; i < p->n_tokens; i++) {
+        const expr_token_t* t = &p->token[i];
+        float               a, b;
+        switch (t->op) {
+            case ExprOp::Number:
+            case ExprOp::Parameter:
+                if (sp == EXPR_STACK_DEPTH) {
+                    return Error::GcodeExpressionInvalid;
+                }
+                stack[sp++] = t->op == ExprOp::Number ? t->value : parameters[t->slot];
+                continue;
+            case ExprOp::Indirect: {
+                int number = (int)stack[sp - 1];
+                if (number < 1 || number >= EXPR_NUMBERED_PARAMETERS) {
+                    return Error::GcodeParameterInvalid;
+                }
+                stack[sp - 1] = parameters[number];
+                continue;
+            }
+            case ExprOp::Negate:
+            case ExprOp::Abs:
+            case ExprOp::Acos:
+            case ExprOp::Asin:
+            case ExprOp::Atan:
+            case ExprOp::Cos:
+            case ExprOp::Exp:
+            case ExprOp::Fix:
+            case ExprOp::Fup:
+            case ExprOp::Ln:
+            case ExprOp::Round:
+            case ExprOp::Sin:
+            case ExprOp::Sqrt:
+            case ExprOp::Tan:
+                a = stack[sp - 1];
+                switch (t->op) {
+                    case ExprOp::Negate:
+                        a = -a;
+                        break;
+                    case ExprOp::Abs:
+                        a = fabsf(a);
+                        break;
+                    case ExprOp::Acos:
+                        a = acosf(a) * RAD_TO_DEG;
+                        break;
+                    case ExprOp::Asin:
+                        a = asinf(a) * RAD_TO_DEG;
+                        break;
+                    case ExprOp::Atan:
+                        a = atanf(a) * RAD_TO_DEG;
+                        break;
+                    case ExprOp::Cos:
+                        a = cosf(a * DEG_TO_RAD);
+                        break;
+                    case ExprOp::Exp:
+                        a = expf(a);
+                        break;
+                    case ExprOp::Fix:
+                        a = floorf(a);
+                        break;
+                    case ExprOp::Fup:
+                        a = ceilf(a);
+                        break;
+                    case ExprOp::Ln:
+                        if (a <= 0.0) {
+                            return Error::GcodeExpressionInvalid;
+                        }
+                        a = logf(a);
+                        break;
+                    case ExprOp::Round:
+                        a = roundf(a);
+                        break;
+                    case ExprOp::Sin:
+                        a = sinf(a * DEG_TO_RAD);
+                        break;
+                    case ExprOp::Sqrt:
+                        if (a < 0.0) {
+                            return Error::GcodeExpressionInvalid;
+                        }
+                        a = sqrtf(a);
+                        break;
+                    default:  // case ExprOp::Tan:
+                        a = tanf(a * DEG_TO_RAD);
+                        break;
+                }
+                stack[sp - 1] = a;
+                continue;
+            default:
+                break;
+        }
+        // Binary operators
+        b = stack[--sp];
+        a = stack[sp - 1];
+        switch (t->op) {
+            case ExprOp::Add:
+                a += b;
+                break;
+            case ExprOp::Subtract:
+                a -= b;
+                break;
+            case ExprOp::Multiply:
+                a *= b;
+                break;
+            case ExprOp::Divide:
+                if (b == 0.0) {
+                    return Error::GcodeExpressionInvalid;
+                }
+                a /= b;
+                break;
+            case ExprOp::Modulo:
+                if (b == 0.0) {
+                    return Error::GcodeExpressionInvalid;
+                }
+                a -= b * floorf(a / b);
+                break;
+            case ExprOp::Power:
+                a = powf(a, b);
+                break;
+            case ExprOp::Atan2:
+                a = atan2f(a, b) * RAD_TO_DEG;
+                break;
+            case ExprOp::Eq:
+                a = a == b;
+                break;
+            case ExprOp::Ne:
+                a = a != b;
+                break;
+            case ExprOp::Gt:
+                a = a > b;
+                break;
+            case ExprOp::Ge:
+                a = a >= b;
+                break;
+            case ExprOp::Lt:
+                a = a < b;
+                break;
+            case ExprOp::Le:
+                a = a <= b;
+                break;
+            case ExprOp::And:
+                a = a != 0.0 && b != 0.0;
+                break;
+            case ExprOp::Or:
+                a = a != 0.0 || b != 0.0;
+                break;
+            default:  // case ExprOp::Xor:
+                a = (a != 0.0) != (b != 0.0);
+                break;
+        }
+        stack[sp - 1] = a;
+    }
+    *result = stack[0];
+    return Error::Ok;
+}
+
+// Compiles the bracketed expression at the start of *text, reusing the program of an identical
+// expression compiled before.
+static Error compile_bracketed(const char** text, const expr_program_t** program) {
+    // Find the matching bracket, so that the whole expression is the cache key.
+    const char* end   = *text;
+    int         level = 0;
+    do {
+        if (*end == '[') {
+            level++;
+        } else if (*end == ']') {
+            level--;
+        } else if (*end == '\0') {
+            return Error::GcodeExpressionInvalid;
+        }
+        end++;
+    } while (level);
+    size_t length = end - *text;
+
+    if (length <= EXPR_CACHE_LENGTH) {
+        for (auto& entry : expr_cache) {
+            if (strncmp(entry.text, *text, length) == 0 && entry.text[length] == '\0') {
+                *text    = end;
+                *program = &entry.program;
+                return Error::Ok;
+            }
+        }
+    }
+    compiler_t c = { *text, &scratch, Error::Ok };
+    scratch.n_tokens = 0;
+    compile_primary(&c);
+    if (c.status != Error::Ok) {
+        return c.status;
+    }
+    if (length <= EXPR_CACHE_LENGTH) {
+        expr_cache_entry_t* entry = &expr_cache[expr_cache_next];
+        expr_cache_next           = (expr_cache_next + 1) % EXPR_CACHE_SIZE;
+        memcpy(entry->text, *text, length);
+        entry->text[length] = '\0';
+        entry->program      = scratch;
+        *program            = &entry->program;
+    } else {
+        *program = &scratch;
+    }
+    *text = end;
+    return Error::Ok;
+}
+
+Error expr_read_value(const char** text, float* value) {
+    const expr_program_t* program;
+    if (**text == '[') {
+        Error status = compile_bracketed(text, &program);
+        if (status != Error::Ok) {
+            return status;
+        }
+    } else {
+        // Numbers and parameters, possibly signed, are too short to be worth caching.
+        compiler_t c     = { *text, &scratch, Error::Ok };
+        scratch.n_tokens = 0;
+        compile_unary(&c);
+        if (c.status != Error::Ok) {
+            return c.status;
+        }
+        *text   = c.s;
+        program = &scratch;
+    }
+    return run(program, value);
+}
+
+Error expr_evaluate(const char* text, float* value) {
+    Error status = expr_read_value(&text, value);
+    if (status == Error::Ok && *text != '\0') {
+        status = Error::GcodeExpressionInvalid;
+    }
+    return status;
+}
+
+Error expr_set_parameter(int number, float value) {
+    if (number < 1 || number >= EXPR_NUMBERED_PARAMETERS) {
+        return Error::GcodeParameterInvalid;
+    }
+    parameters[number] = value;
+    return Error::Ok;
+}
+
+Error expr_expand_line(char** line) {
+    if (!strpbrk(*line, "#[")) {
+        return Error::Ok;  // Nothing to evaluate, as for nearly every line.
+    }
+    static char out[LINE_BUFFER_SIZE];
+    struct {
+        uint8_t slot;
+        float   value;
+    } assignment[EXPR_MAX_ASSIGN];
+    uint8_t n_assignments = 0;
+    size_t  length        = 0;
+
+    collapseGCode(*line);
+    const char* s = *line;
+    while (*s) {
+        if (*s != '#' && *s != '[') {
+            if (length == sizeof(out) - 1) {
+                return Error::Overflow;
+            }
+            out[length++] = *s++;
+            continue;
+        }
+        if (*s == '#') {
+            // An assignment, if the parameter is followed by =. Named parameters are created by
+            // their first assignment.
+            const char* target = s + 1;
+            int         slot   = read_slot(&target, false);
+            if (*target == '=' && slot < 0) {
+                const char* name = s + 1;
+                slot             = read_slot(&name, true);
+            }
+            if (slot >= 0 && *target == '=') {
+                if (n_assignments == EXPR_MAX_ASSIGN) {
+                    return Error::GcodeParameterInvalid;
+                }
+                s            = target + 1;
+                Error status = expr_read_value(&s, &assignment[n_assignments].value);
+                if (status != Error::Ok) {
+                    return status;
+                }
+                assignment[n_assignments++].slot = slot;
+                continue;
+            }
+        }
+        float value;
+        Error status = expr_read_value(&s, &value);
+        if (status != Error::Ok) {
+            return status;
+        }
+        // Fold a sign in front of the value into it, so that X-#1 reads for a negative #1.
+        if (length && (out[length - 1] == '-' || out[length - 1] == '+')) {
+            if (out[--length] == '-') {
+                value = -value;
+            }
+        }
+        int n = snprintf(&out[length], sizeof(out) - length, "%.4f", value);
+        if (n < 0 || (size_t)n >= sizeof(out) - length) {
+            return Error::Overflow;
+        }
+        length += n;
+    }
+    out[length] = '\0';
+    // Assignments take effect after the line has been read.
+    for (uint8_t i = 0; i < n_assignments; i++) {
+        parameters[assignment[i].slot] = assignment[i].value;
+    }
+    *line = out;
+    return Error::Ok;
+}
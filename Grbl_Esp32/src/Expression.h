@@ -0,0 +1,49 @@
+#pragma once
+
+/*
+  Expression.h - G-code parameters and [expression] evaluation
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Error.h"
+
+#include <cstdint>
+
+// Parameters, in the LinuxCNC syntax, are numbered, #1 to #(EXPR_NUMBERED_PARAMETERS - 1),
+// which start at 0, or named, #<name>, which must be assigned before they are read. A line may
+// assign them with #1=<value>, where the value is a number, a parameter or an expression, and
+// the assignments take effect after the rest of the line has been read. Any word value may be a
+// parameter or an expression in brackets, such as X[#1 * 2 + #<offset>]. Expressions support
+// + - * / MOD ** EQ NE GT GE LT LE AND OR XOR, unary minus, and the functions ABS ACOS ASIN
+// ATAN COS EXP FIX FUP LN ROUND SIN SQRT TAN, with angles in degrees and ATAN[y]/[x] for the
+// two argument arc tangent. Each expression is compiled to RPN once, and the compiled form of
+// the most recent ones is kept, so expressions in repeated lines and loops are not reparsed.
+const int EXPR_NUMBERED_PARAMETERS = 100;
+const int EXPR_NAMED_PARAMETERS    = 16;
+const int EXPR_NAME_LENGTH         = 15;
+
+// Evaluates the parameters and expressions in a line and applies its assignments. *line is
+// left alone if there are none, and otherwise pointed at a static copy with them replaced by
+// their values.
+Error expr_expand_line(char** line);
+
+// Reads one value, a number, a parameter or a bracketed expression, from a collapsed line
+// and advances *text past it.
+Error expr_read_value(const char** text, float* value);
+
+// Evaluates a collapsed string holding exactly one value.
+Error expr_evaluate(const char* text, float* value);
+
+// Sets a numbered parameter, as for the arguments of an O-word call.
+Error expr_set_parameter(int number, float value);
@@ -0,0 +1,107 @@
+/*
+  FileCheck.cpp - Fast check mode run of a G-code file, for $SD/Check and $LocalFS/Check
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The file is read in blocks and split into lines here, rather than a character at a time, and
+  the lines go straight to gc_execute_line(). System commands are skipped, as check mode does
+  not run them either. The lines run in file order, so O-word loops and calls are parsed once
+  each, and the offsets of G10, G28.1 and G30.1 are still stored, as they are by $C.
+*/
+
+#include "Grbl.h"
+
+static const size_t FILE_CHECK_READ_SIZE = 512;
+static const int    FILE_CHECK_POLL      = 64;  // Lines between checks for realtime commands
+
+typedef struct {
+    uint32_t lines;
+    uint32_t errors;
+    struct {
+        uint32_t line;
+        Error    error;
+    } listed[FILE_CHECK_ERRORS_LISTED];
+} file_check_t;
+
+static void file_check_line(file_check_t* check, char* line, bool overflow, uint8_t client) {
+    check->lines++;
+    Error status = overflow ? Error::Overflow : Error::Ok;
+    if (!overflow && line[0] != '\0' && line[0] != '$' && line[0] != '[') {
+        status = gc_execute_line(line, client);
+    }
+    if (status != Error::Ok) {
+        if (check->errors < FILE_CHECK_ERRORS_LISTED) {
+            check->listed[check->errors].line  = check->lines;
+            check->listed[check->errors].error = status;
+        }
+        check->errors++;
+    }
+    if (check->lines % FILE_CHECK_POLL == 0) {
+        protocol_execute_realtime();
+    }
+}
+
+Error file_check(File& file, const char* name, uint8_t client) {
+    if (sys.state != State::Idle) {
+        return Error::IdleError;
+    }
+    parser_state_t modes = gc_state;
+    sys.state            = State::CheckMode;
+
+    file_check_t check = {};
+    uint8_t      block[FILE_CHECK_READ_SIZE];
+    char         line[LINE_BUFFER_SIZE];
+    size_t       len      = 0;
+    bool         overflow = false;
+    size_t       count;
+    int64_t      start = esp_timer_get_time();
+    while (!sys.abort && (count = file.read(block, sizeof(block))) > 0) {
+        for (size_t i = 0; i < count && !sys.abort; i++) {
+            char c = block[i];
+            if (c == '\n') {
+                line[len] = '\0';
+                file_check_line(&check, line, overflow, client);
+                len      = 0;
+                overflow = false;
+            } else if (c != '\r') {
+                if (len < sizeof(line) - 1) {
+                    line[len++] = c;
+                } else {
+                    overflow = true;
+                }
+            }
+        }
+    }
+    if (!sys.abort && (len > 0 || overflow)) {
+        line[len] = '\0';
+        file_check_line(&check, line, overflow, client);  // The last line has no newline
+    }
+    if (sys.abort) {
+        return Error::Ok;  // The reset puts the modes back
+    }
+    float seconds = (esp_timer_get_time() - start) / 1e6;
+
+    gc_state  = modes;
+    sys.state = State::Idle;
+    gc_sync_position();
+
+    grbl_sendf(client, "[MSG: Check %s: %u lines, %u errors in %.1f s]\r\n", name, check.lines, check.errors, seconds);
+    for (uint32_t i = 0; i < check.errors && i < FILE_CHECK_ERRORS_LISTED; i++) {
+        Error error = check.listed[i].error;
+        grbl_sendf(client, "[MSG: Check error:%d at line %u, %s]\r\n", int(error), check.listed[i].line, errorString(error));
+    }
+    if (check.errors > FILE_CHECK_ERRORS_LISTED) {
+        grbl_sendf(client, "[MSG: Check %u more errors not listed]\r\n", check.errors - FILE_CHECK_ERRORS_LISTED);
+    }
+    return Error::Ok;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+/*
+  FileCheck.h - Fast check mode run of a G-code file, for $SD/Check and $LocalFS/Check
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Error.h"
+
+#include <FS.h>
+#include <cstdint>
+
+// Errors listed with their line numbers in the summary. The rest are only counted.
+const int FILE_CHECK_ERRORS_LISTED = 16;
+
+// Parses every line of file in check mode, as $C does, without going through a client's
+// input buffer or sending a reply per line, then sends one summary of the lines and the
+// errors, listing the first few with their line numbers. Nothing moves, and the parser
+// modes are put back afterwards. name is only used in the summary.
+Error file_check(File& file, const char* name, uint8_t client);
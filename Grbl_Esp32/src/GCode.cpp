@@ -53,7 +53,13 @@ void gc_init() {
 // Sets g-code parser position in mm. Input in steps. Called by the system abort and hard
 // limit pull-off routines.
 void gc_sync_position() {
-    system_convert_array_steps_to_mpos(gc_state.position, sys_position);
+    int32_t position[MAX_N_AXIS];
+    st_get_position(position);
+    system_convert_array_steps_to_mpos(gc_state.position, position);
+}
+
+static bool gc_is_canned_cycle(Motion motion) {
+    return motion == Motion::DrillChipBreak || motion == Motion::Drill || motion == Motion::DrillDwell || motion == Motion::DrillPeck;
 }
 
 // Edit GCode line in-place, removing whitespace and comments and
@@ -115,6 +121,215 @@ void collapseGCode(char* line) {
     *outPtr = '\0';
 }
 
+// Splits the line into words in a single pass, skipping whitespace and comments and converting
+// letters to upper case, with the same effect as collapseGCode() followed by reading each
+// word. The digits of each number are compacted in place at the front of the line, so
+// numbers split by spaces still read as one, and then converted with read_float().
+static Error gc_tokenize_line(char* line, uint8_t start, gc_word_t* words, uint8_t* n_words) {
+    char*   parenPtr = NULL;  // If non-NULL, the address of the character after (
+    char*   outPtr   = line;  // Where the digits of the current number are compacted
+    char*   number   = NULL;  // Start of the current number, if a word letter has been read
+    uint8_t count    = 0;
+    char    c;
+    for (char* inPtr = line + start;; inPtr++) {
+        c = *inPtr;
+        if (parenPtr) {
+            if (c == ')') {
+                *inPtr = '\0';  // Terminate comment by replacing ) with NUL
+                report_gcode_comment(parenPtr);
+                parenPtr = NULL;
+            } else if (c == '\0') {
+                report_gcode_comment(parenPtr);  // Handle unterminated ( comments
+                break;
+            }
+            continue;
+        }
+        if (isspace(c) || c == ')' || c == '%' || c == '\r') {
+            continue;  // See collapseGCode() for why these are ignored
+        }
+        if (c == '(') {
+            parenPtr = inPtr + 1;
+            continue;
+        }
+        if (c == ';') {
+#ifdef REPORT_SEMICOLON_COMMENTS
+            report_gcode_comment(inPtr + 1);
+#endif
+            c = '\0';
+        }
+        c = toupper(c);
+        if (number && (isdigit(c) || c == '.' || c == '-' || c == '+')) {
+            *outPtr++ = c;
+            continue;
+        }
+        if (number) {
+            // Finish the current word. outPtr is behind inPtr, as letters are not copied.
+            *outPtr              = '\0';
+            uint8_t char_counter = number - line;
+            float   value;
+            if (!read_float(line, &char_counter, &value)) {
+                FAIL(Error::BadNumberFormat);  // [Expected word value]
+            }
+            if (line[char_counter] != '\0') {
+                FAIL(Error::ExpectedCommandLetter);  // [Expected word letter]
+            }
+            // Convert values to smaller uint8 significand and mantissa values for parsing this word.
+            // NOTE: Mantissa is multiplied by 100 to catch non-integer command values. This is more
+            // accurate than the NIST gcode requirement of x10 when used for commands, but not quite
+            // accurate enough for value words that require integers to within 0.0001. This should be
+            // a good enough compromise and catch most all non-integer errors. To make it compliant,
+            // we would simply need to change the mantissa to int16, but this add compiled flash space.
+            // Maybe update this later.
+            words[count].value     = value;
+            words[count].int_value = trunc(value);
+            // NOTE: Rounding must be used to catch small floating point errors.
+            words[count].mantissa = round(100 * (value - words[count].int_value));  // Compute mantissa for Gxx.x commands.
+            count++;
+            number = NULL;
+        }
+        if (c == '\0') {
+            break;
+        }
+        if ((c < 'A') || (c > 'Z')) {
+            FAIL(Error::ExpectedCommandLetter);  // [Expected word letter]
+        }
+        if (count == MAX_GCODE_WORDS) {
+            FAIL(Error::Overflow);
+        }
+        words[count].letter = c;
+        number              = outPtr;
+    }
+    *n_words = count;
+    return Error::Ok;
+}
+
+#ifdef GCODE_LINE_CACHE_SIZE
+// Lines longer than this, or with comments, which must be reported every time, are not cached.
+const int GCODE_LINE_CACHE_LENGTH = 48;
+
+// The result of STEP 2 of gc_execute_line() for a line parsed in the modes in modal. STEP 2
+// depends on nothing else, so the result can be reused while both match.
+typedef struct {
+    uint32_t       hash;  // 0 for an empty entry
+    char           line[GCODE_LINE_CACHE_LENGTH + 1];
+    gc_modal_t     modal;
+    parser_block_t block;
+    AxisCommand    axis_command;
+    uint8_t        axis_words;
+    uint8_t        ijk_words;
+    uint32_t       command_words;
+    uint32_t       value_words;
+} gc_line_cache_entry_t;
+static gc_line_cache_entry_t gc_line_cache[GCODE_LINE_CACHE_SIZE];
+static uint8_t               gc_line_cache_next;  // Entry replaced by the next store
+
+// FNV-1a hash of the line, or 0 if it cannot be cached.
+static uint32_t gc_line_cache_hash(const char* line) {
+    uint32_t hash = 2166136261u;
+    int      i;
+    for (i = 0; line[i]; i++) {
+        if (i == GCODE_LINE_CACHE_LENGTH || line[i] == '(' || line[i] == ';') {
+            return 0;
+        }
+        hash = (hash ^ (uint8_t)line[i]) * 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+static gc_line_cache_entry_t* gc_line_cache_find(uint32_t hash, const char* line, const gc_modal_t* modal) {
+    for (int i = 0; i < GCODE_LINE_CACHE_SIZE; i++) {
+        gc_line_cache_entry_t* entry = &gc_line_cache[i];
+        if (entry->hash == hash && strcmp(entry->line, line) == 0 && memcmp(&entry->modal, modal, sizeof(gc_modal_t)) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static gc_line_cache_entry_t* gc_line_cache_store(uint32_t hash, const char* line, const gc_modal_t* modal) {
+    gc_line_cache_entry_t* entry = &gc_line_cache[gc_line_cache_next];
+    gc_line_cache_next           = (gc_line_cache_next + 1) % GCODE_LINE_CACHE_SIZE;
+    entry->hash                  = hash;
+    strcpy(entry->line, line);
+    memcpy(&entry->modal, modal, sizeof(gc_modal_t));
+    return entry;
+}
+#endif
+
+// Set while gc_prepare_line() runs the parser, which then stops once STEP 2 is cached.
+static bool gc_preparing = false;
+
+// Set by gc_execute_words() for the parser to take these words instead of tokenizing the line.
+static const gc_word_t* gc_stored_words = NULL;
+static uint8_t          gc_stored_count;
+
+#ifdef SYNC_USER_OUTPUTS
+// M62, M63 and M67. The change waits for the next motion block, unless nothing is moving or queued.
+static void gc_sync_outputs(const PlOutputs* outputs) {
+    // The rest of an arc and a held back line come before the change.
+    mc_finish_arc();
+    mc_flush_merged_line();
+    if (plan_get_current_block() == NULL && sys.state != State::Cycle) {
+        sys_set_outputs(outputs);
+    } else {
+        plan_sync_outputs(outputs);
+    }
+}
+#endif
+
+// Wrapped and shortest-path rotary axes take absolute angles modulo 360. A wrapped axis goes to
+// the angle within the turn it is on, a shortest-path axis goes the shorter way round. offset
+// is the work offset of the axis, so that turns are counted in work coordinates.
+static float gc_rotary_target(uint8_t axis, float target, float offset) {
+    RotaryMode mode = plan_rotary_mode(axis);
+    if (mode != RotaryMode::Wrapped && mode != RotaryMode::Shortest) {
+        return target;
+    }
+    float current = gc_state.position[axis] - offset;
+    float angle   = target - offset;
+    if (mode == RotaryMode::Wrapped) {
+        angle = fmodf(angle, 360.0f);
+        if (angle < 0.0f) {
+            angle += 360.0f;
+        }
+        angle += 360.0f * floorf(current / 360.0f);
+    } else {
+        angle = current + remainderf(angle - current, 360.0f);
+    }
+    return angle + offset;
+}
+
+// Folds the wrapped and shortest-path rotary axes back into their first turn, so that the angles
+// of a long job do not grow until the floats lose their resolution. Only done at rest, when no
+// queued or held back motion depends on the old position. A turn is rounded to whole steps.
+static void gc_fold_rotary_axes() {
+    if (sys.state != State::Idle || plan_get_current_block()) {
+        return;
+    }
+    bool folded = false;
+    for (uint8_t idx = 0; idx < number_axis->get(); idx++) {
+        RotaryMode mode = plan_rotary_mode(idx);
+        if ((mode != RotaryMode::Wrapped && mode != RotaryMode::Shortest) || fabsf(gc_state.position[idx]) < 360.0f) {
+            continue;
+        }
+        if (!folded) {
+            mc_finish_arc();
+            mc_flush_merged_line();
+            if (plan_get_current_block()) {
+                return;  // Next time
+            }
+        }
+        float   steps_per_degree = axis_settings[idx]->steps_per_mm->get();
+        int32_t steps            = lroundf(floorf(gc_state.position[idx] / 360.0f) * 360.0f * steps_per_degree);
+        sys_position[idx] -= steps;
+        gc_state.position[idx] -= steps / steps_per_degree;
+        folded = true;
+    }
+    if (folded) {
+        plan_sync_position();
+    }
+}
+
 // Executes one line of NUL-terminated G-Code.
 // The line may contain whitespace and comments, which are first removed,
 // and lower case characters, which are converted to upper case.
@@ -122,11 +337,26 @@ void collapseGCode(char* line) {
 // exported to grbl's internal functions in terms of (mm, mm/min) and absolute machine
 // coordinates, respectively.
 Error gc_execute_line(char* line, uint8_t client) {
-    // Step 0 - remove whitespace and comments and convert to upper case
-    collapseGCode(line);
+    TRACE_SCOPE(GCodeLine, client);
+    // gc_prepare_line() and gc_execute_words() only pass lines that none of this applies to.
+    if (!gc_preparing && !gc_stored_words) {
+        // O-word blocks, and the lines recorded into them, never reach the parser.
+        Error oword_status;
+        if (oword_intercept(line, client, &oword_status)) {
+            return oword_status;
+        }
+        // Replace parameters and expressions by their values.
+        Error expr_status = expr_expand_line(&line);
+        if (expr_status != Error::Ok) {
+            return expr_status;
+        }
 #ifdef REPORT_ECHO_LINE_RECEIVED
-    report_echo_line_received(line, client);
+        // Step 0 - remove whitespace and comments and convert to upper case, for the echo only.
+        // The tokenizer does the same as it splits the line.
+        collapseGCode(line);
+        report_echo_line_received(line, client);
 #endif
+    }
 
     /* -------------------------------------------------------------------------------------
        STEP 1: Initialize parser block struct and copy current g-code state modes. The parser
@@ -139,6 +369,10 @@ Error gc_execute_line(char* line, uint8_t client) {
     AxisCommand axis_command = AxisCommand::None;
     uint8_t     axis_0, axis_1, axis_linear;
     CoordIndex  coord_select = CoordIndex::G54;  // Tracks G10 P coordinate selection for execution
+    int8_t      spindle_head = -1;               // M3/M4/M5 P head selection, -1 keeps the current head
+#ifdef CONSTANT_SURFACE_SPEED
+    bool css_word = false;  // S is a G96 surface speed
+#endif
     // Initialize bitflag tracking variables for axis indices compatible operations.
     uint8_t axis_words = 0;  // XYZ tracking
     uint8_t ijk_words  = 0;  // IJK tracking
@@ -149,6 +383,8 @@ Error gc_execute_line(char* line, uint8_t client) {
     auto     n_axis          = number_axis->get();
     float    coord_data[MAX_N_AXIS];  // Used by WCO-related commands
     uint8_t  pValue;                  // Integer value of P word
+    float    tool_length;             // G10 L1 Z, mm
+    float    tool_diameter;           // G10 L1 R as a diameter in mm, negative to keep the table's
 
     // Determine if the line is a jogging motion or a normal g-code block.
     if (line[0] == '$') {  // NOTE: `$J=` already parsed when passed to this function.
@@ -168,36 +404,50 @@ Error gc_execute_line(char* line, uint8_t client) {
        words, and for negative values set for the value words F, N, P, T, and S. */
     ModalGroup mg_word_bit;  // Bit-value for assigning tracking variables
     uint32_t   bitmask = 0;
-    uint8_t    char_counter;
     char       letter;
     float      value;
     uint8_t    int_value = 0;
     uint16_t   mantissa  = 0;
-    if (gc_parser_flags & GCParserJogMotion) {
-        char_counter = 3;  // Start parsing after `$J=`
+    gc_word_t  words[MAX_GCODE_WORDS];
+    uint8_t    n_words;
+    Error      token_status;
+#ifdef GCODE_LINE_CACHE_SIZE
+    // The tokenizer compacts the line in place, so the cache key is copied first.
+    gc_modal_t modal_in;
+    char       line_key[GCODE_LINE_CACHE_LENGTH + 1];
+    uint32_t   line_hash = gc_stored_words ? 0 : gc_line_cache_hash(line);
+    if (line_hash) {
+        gc_line_cache_entry_t* entry = gc_line_cache_find(line_hash, line, &gc_block.modal);
+        if (entry) {
+            memcpy(&gc_block, &entry->block, sizeof(parser_block_t));
+            axis_command  = entry->axis_command;
+            axis_words    = entry->axis_words;
+            ijk_words     = entry->ijk_words;
+            command_words = entry->command_words;
+            value_words   = entry->value_words;
+            goto parsing_complete;
+        }
+        memcpy(&modal_in, &gc_block.modal, sizeof(gc_modal_t));
+        strcpy(line_key, line);
+    }
+#endif
+    if (gc_stored_words) {
+        memcpy(words, gc_stored_words, gc_stored_count * sizeof(gc_word_t));
+        n_words         = gc_stored_count;
+        gc_stored_words = NULL;
+        token_status    = Error::Ok;
     } else {
-        char_counter = 0;
+        // Start parsing after `$J=` for jog motions.
+        token_status = gc_tokenize_line(line, (gc_parser_flags & GCParserJogMotion) ? 3 : 0, words, &n_words);
     }
-    while (line[char_counter] != 0) {  // Loop until no more g-code words in line.
-        // Import the next g-code word, expecting a letter followed by a value. Otherwise, error out.
-        letter = line[char_counter];
-        if ((letter < 'A') || (letter > 'Z')) {
-            FAIL(Error::ExpectedCommandLetter);  // [Expected word letter]
-        }
-        char_counter++;
-        if (!read_float(line, &char_counter, &value)) {
-            FAIL(Error::BadNumberFormat);  // [Expected word value]
-        }
-        // Convert values to smaller uint8 significand and mantissa values for parsing this word.
-        // NOTE: Mantissa is multiplied by 100 to catch non-integer command values. This is more
-        // accurate than the NIST gcode requirement of x10 when used for commands, but not quite
-        // accurate enough for value words that require integers to within 0.0001. This should be
-        // a good enough compromise and catch most all non-integer errors. To make it compliant,
-        // we would simply need to change the mantissa to int16, but this add compiled flash space.
-        // Maybe update this later.
-        int_value = trunc(value);
-        mantissa  = round(100 * (value - int_value));  // Compute mantissa for Gxx.x commands.
-        // NOTE: Rounding must be used to catch small floating point errors.
+    if (token_status != Error::Ok) {
+        FAIL(token_status);
+    }
+    for (uint8_t word = 0; word < n_words; word++) {  // Loop until no more g-code words in line.
+        letter    = words[word].letter;
+        value     = words[word].value;
+        int_value = words[word].int_value;
+        mantissa  = words[word].mantissa;
         // Check if the g-code word is supported or errors due to modal group violations or has
         // been repeated in the g-code block. If ok, update the command or record its value.
         switch (letter) {
@@ -279,7 +529,9 @@ Error gc_execute_line(char* line, uint8_t client) {
                     case 38:  // G38 - probe
                         //only allow G38 "Probe" commands if a probe pin is defined.
                         if (PROBE_PIN == UNDEFINED_PIN) {
-                            grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "No probe pin defined");
+                            if (!gc_preparing) {
+                                grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "No probe pin defined");
+                            }
                             FAIL(Error::GcodeUnsupportedCommand);  // [Unsupported G command]
                         }
                         // Check for G0/1/2/3/38 being called with G10/28/30/92 on same block.
@@ -313,6 +565,40 @@ Error gc_execute_line(char* line, uint8_t client) {
                         gc_block.modal.motion = Motion::None;
                         mg_word_bit           = ModalGroup::MG1;
                         break;
+#ifdef SPINDLE_SYNC
+                    case 33:  // G33 - spindle synchronized motion, G33.1 - rigid tapping
+                        axis_command = AxisCommand::MotionMode;
+                        switch (mantissa) {
+                            case 0:
+                                gc_block.modal.motion = Motion::SpindleSync;
+                                break;
+                            case 10:
+                                gc_block.modal.motion = Motion::RigidTap;
+                                break;
+                            default:
+                                FAIL(Error::GcodeUnsupportedCommand);
+                                break;  // [Unsupported G33.x command]
+                        }
+                        mantissa    = 0;  // Set to zero to indicate valid non-integer G command.
+                        mg_word_bit = ModalGroup::MG1;
+                        break;
+#endif
+                    case 73:  // G73 - chip breaking drilling cycle
+                    case 81:  // G81 - drilling cycle
+                    case 82:  // G82 - drilling cycle with dwell
+                    case 83:  // G83 - peck drilling cycle
+                        axis_command          = AxisCommand::MotionMode;
+                        gc_block.modal.motion = Motion(int_value);
+                        mg_word_bit           = ModalGroup::MG1;
+                        break;
+                    case 98:
+                        gc_block.modal.retract = RetractMode::OldZ;
+                        mg_word_bit            = ModalGroup::MG10;
+                        break;
+                    case 99:
+                        gc_block.modal.retract = RetractMode::RPlane;
+                        mg_word_bit            = ModalGroup::MG10;
+                        break;
                     case 17:
                         gc_block.modal.plane_select = Plane::XY;
                         mg_word_bit                 = ModalGroup::MG2;
@@ -358,6 +644,16 @@ Error gc_execute_line(char* line, uint8_t client) {
                                 break;
                         }
                         break;
+#ifdef CONSTANT_SURFACE_SPEED
+                    case 96:
+                        gc_block.modal.speed_mode = SpindleSpeedMode::SurfaceSpeed;
+                        mg_word_bit               = ModalGroup::MG14;
+                        break;
+                    case 97:
+                        gc_block.modal.speed_mode = SpindleSpeedMode::Rpm;
+                        mg_word_bit               = ModalGroup::MG14;
+                        break;
+#endif
                     case 93:
                         gc_block.modal.feed_rate = FeedRate::InverseTime;
                         mg_word_bit              = ModalGroup::MG5;
@@ -394,6 +690,8 @@ Error gc_execute_line(char* line, uint8_t client) {
                             gc_block.modal.tool_length = ToolLengthOffset::Cancel;
                         } else if (mantissa == 10) {  // G43.1
                             gc_block.modal.tool_length = ToolLengthOffset::EnableDynamic;
+                        } else if (mantissa == 0) {  // G43
+                            gc_block.modal.tool_length = ToolLengthOffset::Enable;
                         } else {
                             FAIL(Error::GcodeUnsupportedCommand);  // [Unsupported G43.x command]
                         }
@@ -429,8 +727,12 @@ Error gc_execute_line(char* line, uint8_t client) {
                         if (mantissa != 0) {
                             FAIL(Error::GcodeUnsupportedCommand);  // [G61.1 not supported]
                         }
-                        // gc_block.modal.control = ControlMode::ExactPath; // G61
-                        mg_word_bit = ModalGroup::MG13;
+                        gc_block.modal.control = ControlMode::ExactPath;  // G61
+                        mg_word_bit            = ModalGroup::MG13;
+                        break;
+                    case 64:
+                        gc_block.modal.control = ControlMode::Continuous;  // G64
+                        mg_word_bit            = ModalGroup::MG13;
                         break;
                     default:
                         FAIL(Error::GcodeUnsupportedCommand);  // [Unsupported G command]
@@ -478,13 +780,8 @@ Error gc_execute_line(char* line, uint8_t client) {
                             case 3:
                                 gc_block.modal.spindle = SpindleState::Cw;
                                 break;
-                            case 4:  // Supported if SPINDLE_DIR_PIN is defined or laser mode is on.
-                                if (spindle->is_reversable || spindle->inLaserMode()) {
-                                    gc_block.modal.spindle = SpindleState::Ccw;
-                                } else {
-                                    grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "M4 requires laser mode or a reversable spindle");
-                                    FAIL(Error::GcodeUnsupportedCommand);
-                                }
+                            case 4:  // Supported if SPINDLE_DIR_PIN is defined or laser mode is on. See [7. Spindle control].
+                                gc_block.modal.spindle = SpindleState::Ccw;
                                 break;
                             case 5:
                                 gc_block.modal.spindle = SpindleState::Disable;
@@ -494,8 +791,7 @@ Error gc_execute_line(char* line, uint8_t client) {
                         break;
                     case 6:  // tool change
                         gc_block.modal.tool_change = ToolChange::Enable;
-                        //user_tool_change(gc_state.tool);
-                        mg_word_bit = ModalGroup::MM6;
+                        mg_word_bit                = ModalGroup::MM6;
                         break;
                     case 7:
                     case 8:
@@ -602,7 +898,13 @@ Error gc_execute_line(char* line, uint8_t client) {
                         axis_word_bit     = GCodeWord::F;
                         gc_block.values.f = value;
                         break;
-                    // case 'H': // Not supported
+                    case 'H':
+                        axis_word_bit = GCodeWord::H;
+                        if (value > MaxToolNumber) {
+                            FAIL(Error::GcodeMaxValueExceeded);
+                        }
+                        gc_block.values.h = int_value;
+                        break;
                     case 'I':
                         axis_word_bit               = GCodeWord::I;
                         gc_block.values.ijk[X_AXIS] = value;
@@ -648,8 +950,7 @@ Error gc_execute_line(char* line, uint8_t client) {
                         if (value > MaxToolNumber) {
                             FAIL(Error::GcodeMaxValueExceeded);
                         }
-                        grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Tool No: %d", int_value);
-                        gc_state.tool = int_value;
+                        gc_block.values.t = int_value;
                         break;
                     case 'X':
                         if (n_axis > X_AXIS) {
@@ -687,9 +988,10 @@ Error gc_execute_line(char* line, uint8_t client) {
                 if (bit_istrue(value_words, bitmask)) {
                     FAIL(Error::GcodeWordRepeated);  // [Word repeated]
                 }
-                // Check for invalid negative values for words F, N, P, T, and S.
+                // Check for invalid negative values for words F, H, N, P, T, and S.
                 // NOTE: Negative value check is done here simply for code-efficiency.
-                if (bitmask & (bit(GCodeWord::F) | bit(GCodeWord::N) | bit(GCodeWord::P) | bit(GCodeWord::T) | bit(GCodeWord::S))) {
+                if (bitmask & (bit(GCodeWord::F) | bit(GCodeWord::H) | bit(GCodeWord::N) | bit(GCodeWord::P) | bit(GCodeWord::T) |
+                               bit(GCodeWord::S))) {
                     if (value < 0.0) {
                         FAIL(Error::NegativeValue);  // [Word value cannot be negative]
                     }
@@ -697,6 +999,21 @@ Error gc_execute_line(char* line, uint8_t client) {
                 value_words |= bitmask;  // Flag to indicate parameter assigned.
         }
     }
+#ifdef GCODE_LINE_CACHE_SIZE
+    if (line_hash) {
+        gc_line_cache_entry_t* entry = gc_line_cache_store(line_hash, line_key, &modal_in);
+        memcpy(&entry->block, &gc_block, sizeof(parser_block_t));
+        entry->axis_command  = axis_command;
+        entry->axis_words    = axis_words;
+        entry->ijk_words     = ijk_words;
+        entry->command_words = command_words;
+        entry->value_words   = value_words;
+    }
+parsing_complete:
+    if (gc_preparing) {
+        return Error::Ok;  // The block is cached for when the line runs.
+    }
+#endif
     // Parsing complete!
     /* -------------------------------------------------------------------------------------
        STEP 3: Error-check all commands and values passed in this block. This step ensures all of
@@ -722,6 +1039,7 @@ Error gc_execute_line(char* line, uint8_t client) {
        new g-code block when the EOL character is received. However, this would break Grbl's startup
        lines in how it currently works and would require some refactoring to make it compatible.
     */
+    gc_fold_rotary_axes();
     // [0. Non-specific/common error-checks and miscellaneous setup]:
     // Determine implicit axis command conditions. Axis words have been passed, but no explicit axis
     // command has been sent. If so, set axis command to current motion mode.
@@ -794,13 +1112,27 @@ Error gc_execute_line(char* line, uint8_t client) {
     if (bit_isfalse(value_words, bit(GCodeWord::S))) {
         gc_block.values.s = gc_state.spindle_speed;
         // bit_false(value_words,bit(GCodeWord::S)); // NOTE: Single-meaning value word. Set at end of error-checking.
-        // [5. Select tool ]: NOT SUPPORTED. Only tracks value. T is negative (done.) Not an integer. Greater than max tool value.
-        // bit_false(value_words,bit(GCodeWord::T)); // NOTE: Single-meaning value word. Set at end of error-checking.
         // [6. Change tool ]: N/A
         // [7. Spindle control ]: N/A
         // [8. Coolant control ]: N/A
         // [9. Enable/disable feed rate or spindle overrides ]: NOT SUPPORTED.
     }
+    // [5. Select tool ]: T is negative (done.) Greater than max tool value (done.)
+    // bit_false(value_words,bit(GCodeWord::T)); // NOTE: Single-meaning value word. Set at end of error-checking.
+    if (bit_isfalse(value_words, bit(GCodeWord::T))) {
+        gc_block.values.t = gc_state.tool;
+    }
+    // [6. Change tool ]: The tool changer only knows the tools of the table.
+    if (gc_block.modal.tool_change == ToolChange::Enable && atc_enable->get() && !tool_table_get(gc_block.values.t)) {
+        FAIL(Error::ToolNumberInvalid);
+    }
+#ifdef CONSTANT_SURFACE_SPEED
+    // [4. Set spindle speed ]: G96 needs its surface speed in the same block.
+    css_word = bit_istrue(value_words, bit(GCodeWord::S)) && gc_block.modal.speed_mode == SpindleSpeedMode::SurfaceSpeed;
+    if (gc_block.modal.speed_mode == SpindleSpeedMode::SurfaceSpeed && bit_istrue(command_words, bit(ModalGroup::MG14)) && !css_word) {
+        FAIL(Error::GcodeValueWordMissing);  // [S word missing]
+    }
+#endif
 #ifdef ENABLE_PARKING_OVERRIDE_CONTROL
     if (bit_istrue(command_words, bit(ModalGroup::MM9))) {  // Already set as enabled in parser.
         if (bit_istrue(value_words, bit(GCodeWord::P))) {
@@ -865,16 +1197,31 @@ Error gc_execute_line(char* line, uint8_t client) {
     // [G40 Errors]: G2/3 arc is programmed after a G40. The linear move after disabling is less than tool diameter.
     //   NOTE: Since cutter radius compensation is never enabled, these G40 errors don't apply. Grbl supports G40
     //   only for the purpose to not error when G40 is sent with a g-code program header to setup the default modes.
-    // [14. Cutter length compensation ]: G43 NOT SUPPORTED, but G43.1 and G49 are.
+    // [14. Cutter length compensation ]: G43, G43.1 and G49 are supported.
     // [G43.1 Errors]: Motion command in same line.
     //   NOTE: Although not explicitly stated so, G43.1 should be applied to only one valid
     //   axis that is configured (in config.h). There should be an error if the configured axis
     //   is absent or if any of the other axis words are present.
+    // [G43 Errors]: Axis words. H is not a tool of the table. Without H, the tool in the spindle is used.
     if (axis_command == AxisCommand::ToolLengthOffset) {  // Indicates called in block.
         if (gc_block.modal.tool_length == ToolLengthOffset::EnableDynamic) {
             if (axis_words ^ bit(TOOL_LENGTH_OFFSET_AXIS)) {
                 FAIL(Error::GcodeG43DynamicAxisError);
             }
+        } else if (gc_block.modal.tool_length == ToolLengthOffset::Enable) {
+            if (axis_words) {
+                FAIL(Error::GcodeAxisCommandConflict);
+            }
+            if (bit_isfalse(value_words, bit(GCodeWord::H))) {
+                gc_block.values.h = tool_table_loaded();
+            }
+            const tool_entry_t* entry = tool_table_get(gc_block.values.h);
+            if (!entry) {
+                FAIL(Error::ToolNumberInvalid);
+            }
+            // Executed the same way as G43.1 with this value.
+            gc_block.values.xyz[TOOL_LENGTH_OFFSET_AXIS] = entry->length;
+            bit_false(value_words, bit(GCodeWord::H));
         }
     }
     // [15. Coordinate system selection ]: *N/A. Error, if cutter radius comp is active.
@@ -894,9 +1241,22 @@ Error gc_execute_line(char* line, uint8_t client) {
             coords[gc_block.modal.coord_select]->get(block_coord_system);
         }
     }
-    // [16. Set path control mode ]: N/A. Only G61. G61.1 and G64 NOT SUPPORTED.
+    // [16. Set path control mode ]: G64 P is the blending tolerance. Without P, the junction deviation
+    // is used. G61.1 NOT SUPPORTED.
+    float path_tolerance = gc_state.path_tolerance;
+    if (bit_istrue(command_words, bit(ModalGroup::MG13)) && gc_block.modal.control == ControlMode::Continuous) {
+        if (bit_istrue(value_words, bit(GCodeWord::P))) {
+            path_tolerance = gc_block.values.p;
+            if (gc_block.modal.units == Units::Inches) {
+                path_tolerance *= MM_PER_INCH;
+            }
+            bit_false(value_words, bit(GCodeWord::P));
+        } else {
+            path_tolerance = junction_deviation->get();
+        }
+    }
     // [17. Set distance mode ]: N/A. Only G91.1. G90.1 NOT SUPPORTED.
-    // [18. Set retract mode ]: NOT SUPPORTED.
+    // [18. Set retract mode ]: N/A. G98/G99 only select where a canned cycle retracts to.
     // [19. Remaining non-modal actions ]: Check go to predefined position, set G10, or set axis offsets.
     // NOTE: We need to separate the non-modal commands that are axis word-using (G10/G28/G30/G92), as these
     // commands all treat axis words differently. G10 as absolute offsets or computes current position as
@@ -904,7 +1264,34 @@ Error gc_execute_line(char* line, uint8_t client) {
     // all the current coordinate system and G92 offsets.
     switch (gc_block.non_modal_command) {
         case NonModal::SetCoordinateData:
-            // [G10 Errors]: L missing and is not 2 or 20. P word missing. (Negative P value done.)
+            // [G10 L1 Errors]: P not a tool of the table. Axis words other than the tool length axis.
+            //   Neither the tool length axis word nor R.
+            if (bit_istrue(value_words, bit(GCodeWord::L)) && gc_block.values.l == 1) {
+                if (bit_isfalse(value_words, bit(GCodeWord::P))) {
+                    FAIL(Error::GcodeValueWordMissing);  // [P word missing]
+                }
+                if (gc_block.values.p != truncf(gc_block.values.p) || gc_block.values.p < 1 || gc_block.values.p > TOOL_TABLE_MAX) {
+                    FAIL(Error::ToolNumberInvalid);
+                }
+                if (axis_words & ~bit(TOOL_LENGTH_OFFSET_AXIS)) {
+                    FAIL(Error::GcodeUnsupportedCommand);  // [G10 L1 only sets the tool length]
+                }
+                if (!axis_words && bit_isfalse(value_words, bit(GCodeWord::R))) {
+                    FAIL(Error::GcodeNoAxisWords);
+                }
+                pValue        = gc_block.values.p;
+                tool_length   = axis_words ? gc_block.values.xyz[TOOL_LENGTH_OFFSET_AXIS] : tool_table_get(pValue)->length;
+                tool_diameter = -1.0;
+                if (bit_istrue(value_words, bit(GCodeWord::R))) {
+                    tool_diameter = 2.0 * gc_block.values.r;
+                    if (gc_block.modal.units == Units::Inches) {
+                        tool_diameter *= MM_PER_INCH;
+                    }
+                }
+                bit_false(value_words, (bit(GCodeWord::L) | bit(GCodeWord::P) | bit(GCodeWord::R)));
+                break;
+            }
+            // [G10 Errors]: L missing and is not 1, 2 or 20. P word missing. (Negative P value done.)
             // [G10 L2 Errors]: R word NOT SUPPORTED. P value not 0 to nCoordSys(max 9). Axis words missing.
             // [G10 L20 Errors]: P must be 0 to nCoordSys(max 9). Axis words missing.
             if (!axis_words) {
@@ -990,13 +1377,17 @@ Error gc_execute_line(char* line, uint8_t client) {
                             if (gc_block.non_modal_command != NonModal::AbsoluteOverride) {
                                 // Apply coordinate offsets based on distance mode.
                                 if (gc_block.modal.distance == Distance::Absolute) {
-                                    gc_block.values.xyz[idx] += block_coord_system[idx] + gc_state.coord_offset[idx];
+                                    float offset = block_coord_system[idx] + gc_state.coord_offset[idx];
+                                    gc_block.values.xyz[idx] += offset;
                                     if (idx == TOOL_LENGTH_OFFSET_AXIS) {
                                         gc_block.values.xyz[idx] += gc_state.tool_length_offset;
                                     }
+                                    gc_block.values.xyz[idx] = gc_rotary_target(idx, gc_block.values.xyz[idx], offset);
                                 } else {  // Incremental mode
                                     gc_block.values.xyz[idx] += gc_state.position[idx];
                                 }
+                            } else {
+                                gc_block.values.xyz[idx] = gc_rotary_target(idx, gc_block.values.xyz[idx], 0.0f);
                             }
                         }
                     }
@@ -1044,6 +1435,7 @@ Error gc_execute_line(char* line, uint8_t client) {
             }
     }
     // [20. Motion modes ]:
+    gc_canned_cycle_t canned_cycle = gc_state.canned_cycle;
     if (gc_block.modal.motion == Motion::None) {
         // [G80 Errors]: Axis word are programmed while G80 is active.
         // NOTE: Even non-modal commands or TLO that use axis words will throw this strict error.
@@ -1062,8 +1454,10 @@ Error gc_execute_line(char* line, uint8_t client) {
             // All remaining motion modes (all but G0 and G80), require a valid feed rate value. In units per mm mode,
             // the value must be positive. In inverse time mode, a positive value must be passed with each block.
         } else {
-            // Check if feed rate is defined for the motion modes that require it.
-            if (gc_block.values.f == 0.0) {
+            // Check if feed rate is defined for the motion modes that require it. G33 and G33.1 take
+            // theirs from the spindle.
+            bool spindle_synced = gc_block.modal.motion == Motion::SpindleSync || gc_block.modal.motion == Motion::RigidTap;
+            if (gc_block.values.f == 0.0 && !spindle_synced) {
                 FAIL(Error::GcodeUndefinedFeedRate);  // [Feed rate undefined]
             }
             switch (gc_block.modal.motion) {
@@ -1222,6 +1616,98 @@ Error gc_execute_line(char* line, uint8_t client) {
                         }
                     }
                     break;
+                case Motion::DrillChipBreak:
+                case Motion::Drill:
+                case Motion::DrillDwell:
+                case Motion::DrillPeck:
+                    // [G73/G81/G82/G83 Errors]: Not in the XY plane. Inverse time mode. R or Z missing when the cycle
+                    //   starts. R plane below the bottom of the hole. Q missing or not positive for G73/G83. L is zero.
+                    // NOTE: R, Z, Q and P stay in effect until the cycle is cancelled, so the following blocks only
+                    //   need the position of the next hole. Axis words other than Z give the hole position.
+                    if (gc_block.modal.plane_select != Plane::XY || gc_block.modal.feed_rate == FeedRate::InverseTime) {
+                        FAIL(Error::GcodeCannedCycleInvalid);
+                    }
+                    if (!gc_is_canned_cycle(gc_state.modal.motion)) {
+                        if (bit_isfalse(value_words, bit(GCodeWord::R)) || bit_isfalse(axis_words, bit(Z_AXIS))) {
+                            FAIL(Error::GcodeValueWordMissing);  // [R or Z word missing]
+                        }
+                        canned_cycle.peck  = 0.0;
+                        canned_cycle.dwell = 0.0;
+                    }
+                    if (bit_istrue(value_words, bit(GCodeWord::R))) {
+                        if (gc_block.modal.units == Units::Inches) {
+                            gc_block.values.r *= MM_PER_INCH;
+                        }
+                        if (gc_block.modal.distance == Distance::Absolute) {
+                            canned_cycle.r_plane = gc_block.values.r + block_coord_system[Z_AXIS] + gc_state.coord_offset[Z_AXIS] +
+                                                   gc_state.tool_length_offset;
+                        } else {  // Incremental R is measured from the height the cycle starts at.
+                            canned_cycle.r_plane = gc_state.position[Z_AXIS] + gc_block.values.r;
+                        }
+                        bit_false(value_words, bit(GCodeWord::R));
+                    }
+                    if (bit_istrue(axis_words, bit(Z_AXIS))) {
+                        if (gc_block.modal.distance == Distance::Absolute) {
+                            canned_cycle.depth = gc_block.values.xyz[Z_AXIS];
+                        } else {  // Incremental Z is measured from the R plane.
+                            canned_cycle.depth = canned_cycle.r_plane + gc_block.values.xyz[Z_AXIS] - gc_state.position[Z_AXIS];
+                        }
+                        // The hole is drilled in place of the Z move. The parser position ends at the retract height.
+                        gc_block.values.xyz[Z_AXIS] = gc_state.position[Z_AXIS];
+                    }
+                    if (canned_cycle.r_plane < canned_cycle.depth) {
+                        FAIL(Error::GcodeCannedCycleInvalid);  // [R plane below the bottom of the hole]
+                    }
+                    if (bit_istrue(value_words, bit(GCodeWord::Q))) {
+                        canned_cycle.peck = gc_block.values.q;
+                        if (gc_block.modal.units == Units::Inches) {
+                            canned_cycle.peck *= MM_PER_INCH;
+                        }
+                        bit_false(value_words, bit(GCodeWord::Q));
+                    }
+                    if ((gc_block.modal.motion == Motion::DrillChipBreak || gc_block.modal.motion == Motion::DrillPeck) &&
+                        canned_cycle.peck <= 0.0) {
+                        FAIL(Error::GcodeCannedCycleInvalid);  // [Q missing or not positive]
+                    }
+                    if (bit_istrue(value_words, bit(GCodeWord::P))) {
+                        canned_cycle.dwell = gc_block.values.p;
+                        bit_false(value_words, bit(GCodeWord::P));
+                    }
+                    if (bit_istrue(value_words, bit(GCodeWord::L))) {
+                        if (gc_block.values.l == 0) {
+                            FAIL(Error::GcodeCannedCycleInvalid);  // [L must be at least one]
+                        }
+                        bit_false(value_words, bit(GCodeWord::L));
+                    } else {
+                        gc_block.values.l = 1;
+                    }
+                    if (!axis_words) {
+                        axis_command = AxisCommand::None;  // Nothing to drill without a hole position.
+                    }
+                    break;
+#ifdef SPINDLE_SYNC
+                case Motion::SpindleSync:
+                case Motion::RigidTap:
+                    // [G33/G33.1 Errors]: K missing, or not positive. Inverse time mode. Spindle off or in laser
+                    //   mode. No Z motion. G33.1 moves another axis.
+                    // NOTE: K is the Z travel per spindle revolution, required in every block.
+                    if (bit_isfalse(value_words, bit(GCodeWord::K))) {
+                        FAIL(Error::GcodeValueWordMissing);  // [K word missing]
+                    }
+                    if (gc_block.values.ijk[Z_AXIS] <= 0.0 || gc_block.modal.feed_rate == FeedRate::InverseTime ||
+                        gc_block.modal.spindle == SpindleState::Disable || spindle->inLaserMode() ||
+                        gc_block.values.xyz[Z_AXIS] == gc_state.position[Z_AXIS]) {
+                        FAIL(Error::GcodeSpindleSyncInvalid);
+                    }
+                    if (gc_block.modal.motion == Motion::RigidTap && (axis_words & ~bit(Z_AXIS))) {
+                        FAIL(Error::GcodeSpindleSyncInvalid);  // [G33.1 taps along Z only]
+                    }
+                    if (gc_block.modal.units == Units::Inches) {
+                        gc_block.values.ijk[Z_AXIS] *= MM_PER_INCH;
+                    }
+                    bit_false(value_words, bit(GCodeWord::K));
+                    break;
+#endif
                 case Motion::ProbeTowardNoError:
                 case Motion::ProbeAwayNoError:
                     gc_parser_flags |= GCParserProbeIsNoError;  // No break intentional.
@@ -1244,6 +1730,25 @@ Error gc_execute_line(char* line, uint8_t client) {
             }
         }
     }
+    // [7. Spindle control ]: P selects the head on machines with two. It is checked last, so that it
+    // only takes a P that no other command of the block has used.
+    if (bit_istrue(command_words, bit(ModalGroup::MM7))) {
+        if (bit_istrue(value_words, bit(GCodeWord::P))) {
+            if (gc_block.values.p != truncf(gc_block.values.p) || gc_block.values.p < 0 ||
+                !Spindles::Spindle::has_head(uint8_t(gc_block.values.p))) {
+                FAIL(Error::GcodeSpindleHeadInvalid);
+            }
+            spindle_head = gc_block.values.p;
+            bit_false(value_words, bit(GCodeWord::P));
+        }
+        Spindles::Spindle* head = spindle_head < 0 ? spindle : Spindles::Spindle::get_head(spindle_head);
+        if (gc_block.modal.spindle == SpindleState::Ccw && !(head->is_reversable || head->inLaserMode())) {
+            if (!gc_preparing) {
+                grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "M4 requires laser mode or a reversable spindle");
+            }
+            FAIL(Error::GcodeUnsupportedCommand);
+        }
+    }
     // [21. Program flow ]: No error checks required.
     // [0. Non-specific error-checks]: Complete unused value words check, i.e. IJK used when in arc
     // radius mode, or axis words that aren't used in the block.
@@ -1296,6 +1801,11 @@ Error gc_execute_line(char* line, uint8_t client) {
         // JogCancelled is not reported as a GCode error
         return status == Error::JogCancelled ? Error::Ok : status;
     }
+    // [7. Spindle control ]: A change of head comes before anything asks the spindle about laser
+    // mode. The old head is stopped here and the new one is started below with the block's state.
+    if (spindle_head >= 0 && Spindles::Spindle::select_head(spindle_head)) {
+        gc_state.modal.spindle = SpindleState::Disable;
+    }
     // If in laser mode, setup laser power based on current and past parser conditions.
     if (spindle->inLaserMode()) {
         if (!((gc_block.modal.motion == Motion::Linear) || (gc_block.modal.motion == Motion::CwArc) ||
@@ -1341,27 +1851,71 @@ Error gc_execute_line(char* line, uint8_t client) {
     gc_state.feed_rate = gc_block.values.f;   // Always copy this value. See feed rate error-checking.
     pl_data->feed_rate = gc_state.feed_rate;  // Record data for planner use.
     // [4. Set spindle speed ]:
-    if ((gc_state.spindle_speed != gc_block.values.s) || bit_istrue(gc_parser_flags, GCParserLaserForceSync)) {
+    float spindle_rpm = gc_block.values.s;
+#ifdef CONSTANT_SURFACE_SPEED
+    pl_data->css_origin = gc_state.coord_system[X_AXIS] + gc_state.coord_offset[X_AXIS];
+    // The rpm for where the tool is now is set like an S word when G96 or its S is given. The
+    // segment generator follows the radius from there, so motions alone do not sync the spindle.
+    if (gc_block.modal.speed_mode == SpindleSpeedMode::SurfaceSpeed) {
+        if (css_word) {
+            gc_state.css_speed = gc_block.values.s * (gc_block.modal.units == Units::Inches ? MM_PER_INCH * 12.0 : 1000.0);
+        }
+        spindle_rpm = gc_state.spindle_speed;
+        if (css_word || gc_state.modal.speed_mode != SpindleSpeedMode::SurfaceSpeed) {
+            spindle_rpm = st_css_rpm(gc_state.css_speed, gc_state.position[X_AXIS] - pl_data->css_origin);
+        }
+    } else {
+        gc_state.css_speed = 0.0;
+    }
+    gc_state.modal.speed_mode = gc_block.modal.speed_mode;
+    pl_data->css_speed        = gc_state.css_speed;
+#endif
+    if ((gc_state.spindle_speed != spindle_rpm) || bit_istrue(gc_parser_flags, GCParserLaserForceSync)) {
         if (gc_state.modal.spindle != SpindleState::Disable) {
             if (bit_isfalse(gc_parser_flags, GCParserLaserIsMotion)) {
                 if (bit_istrue(gc_parser_flags, GCParserLaserDisable)) {
                     spindle->sync(gc_state.modal.spindle, 0);
                 } else {
-                    spindle->sync(gc_state.modal.spindle, (uint32_t)gc_block.values.s);
+#ifdef SYNC_SPINDLE_SPEED
+                    spindle->sync_rpm(gc_state.modal.spindle, (uint32_t)spindle_rpm);
+#else
+                    spindle->sync(gc_state.modal.spindle, (uint32_t)spindle_rpm);
+#endif
                 }
             }
         }
-        gc_state.spindle_speed = gc_block.values.s;  // Update spindle speed state.
+        gc_state.spindle_speed = spindle_rpm;  // Update spindle speed state.
     }
     // NOTE: Pass zero spindle speed for all restricted laser motions.
     if (bit_isfalse(gc_parser_flags, GCParserLaserDisable)) {
         pl_data->spindle_speed = gc_state.spindle_speed;  // Record data for planner use.
     }                                                     // else { pl_data->spindle_speed = 0.0; } // Initialized as zero already.
-    // [5. Select tool ]: NOT SUPPORTED. Only tracks tool value.
-    //	gc_state.tool = gc_block.values.t;
-    // [6. Change tool ]: NOT SUPPORTED
+    // [5. Select tool ]:
+    if (gc_state.tool != gc_block.values.t) {
+        gc_state.tool = gc_block.values.t;
+        grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Tool No: %d", gc_state.tool);
+    }
+    // [6. Change tool ]: Done by the tool changer with $ATC/Enable, else left to user_tool_change().
     if (gc_block.modal.tool_change == ToolChange::Enable) {
-        user_tool_change(gc_state.tool);
+        mc_flush_merged_line();  // The moves before the change must be queued before it starts.
+        if (atc_enable->get()) {
+            // The changer runs its moves through the parser, which reuses gc_block.
+            parser_block_t block  = gc_block;
+            Error          status = tool_change(gc_state.tool, client);
+            gc_block              = block;
+            if (status != Error::Ok) {
+                FAIL(status);
+            }
+            // The spindle stays stopped, as it was for the change, unless this block starts it.
+            if (bit_isfalse(command_words, bit(ModalGroup::MM7))) {
+                gc_block.modal.spindle = gc_state.modal.spindle;
+            }
+        } else {
+            user_tool_change(gc_state.tool);
+            if (sys.state != State::CheckMode) {
+                tool_table_set_loaded(gc_state.tool);
+            }
+        }
     }
     // [7. Spindle control ]:
     if (gc_state.modal.spindle != gc_block.modal.spindle) {
@@ -1399,13 +1953,27 @@ Error gc_execute_line(char* line, uint8_t client) {
     if ((gc_block.modal.io_control == IoControl::DigitalOnSync) || (gc_block.modal.io_control == IoControl::DigitalOffSync) ||
         (gc_block.modal.io_control == IoControl::DigitalOnImmediate) || (gc_block.modal.io_control == IoControl::DigitalOffImmediate)) {
         if (gc_block.values.p < MaxUserDigitalPin) {
+            bool turnOn = gc_block.modal.io_control == IoControl::DigitalOnSync || gc_block.modal.io_control == IoControl::DigitalOnImmediate;
+#ifdef SYNC_USER_OUTPUTS
+            if ((gc_block.modal.io_control == IoControl::DigitalOnSync) || (gc_block.modal.io_control == IoControl::DigitalOffSync)) {
+                PlOutputs outputs = {};
+                if (turnOn) {
+                    outputs.digitalOn = bit((int)gc_block.values.p);
+                } else {
+                    outputs.digitalOff = bit((int)gc_block.values.p);
+                }
+                gc_sync_outputs(&outputs);
+            } else if (!sys_set_digital((int)gc_block.values.p, turnOn)) {
+                FAIL(Error::PParamMaxExceeded);
+            }
+#else
             if ((gc_block.modal.io_control == IoControl::DigitalOnSync) || (gc_block.modal.io_control == IoControl::DigitalOffSync)) {
                 protocol_buffer_synchronize();
             }
-            bool turnOn = gc_block.modal.io_control == IoControl::DigitalOnSync || gc_block.modal.io_control == IoControl::DigitalOnImmediate;
             if (!sys_set_digital((int)gc_block.values.p, turnOn)) {
                 FAIL(Error::PParamMaxExceeded);
             }
+#endif
         } else {
             FAIL(Error::PParamMaxExceeded);
         }
@@ -1413,12 +1981,27 @@ Error gc_execute_line(char* line, uint8_t client) {
     if ((gc_block.modal.io_control == IoControl::SetAnalogSync) || (gc_block.modal.io_control == IoControl::SetAnalogImmediate)) {
         if (gc_block.values.e < MaxUserDigitalPin) {
             gc_block.values.q = constrain(gc_block.values.q, 0.0, 100.0);  // force into valid range
+#ifdef SYNC_USER_OUTPUTS
+            if (gc_block.modal.io_control == IoControl::SetAnalogSync) {
+                int32_t numerator = sys_analog_numerator((int)gc_block.values.e, gc_block.values.q);
+                if (numerator < 0) {
+                    FAIL(Error::PParamMaxExceeded);
+                }
+                PlOutputs outputs                      = {};
+                outputs.analogSet                      = bit((int)gc_block.values.e);
+                outputs.analog[(int)gc_block.values.e] = numerator;
+                gc_sync_outputs(&outputs);
+            } else if (!sys_set_analog((int)gc_block.values.e, gc_block.values.q)) {
+                FAIL(Error::PParamMaxExceeded);
+            }
+#else
             if (gc_block.modal.io_control == IoControl::SetAnalogSync) {
                 protocol_buffer_synchronize();
             }
             if (!sys_set_analog((int)gc_block.values.e, gc_block.values.q)) {
                 FAIL(Error::PParamMaxExceeded);
             }
+#endif
         } else {
             FAIL(Error::PParamMaxExceeded);
         }
@@ -1441,16 +2024,15 @@ Error gc_execute_line(char* line, uint8_t client) {
     gc_state.modal.units = gc_block.modal.units;
     // [13. Cutter radius compensation ]: G41/42 NOT SUPPORTED
     // gc_state.modal.cutter_comp = gc_block.modal.cutter_comp; // NOTE: Not needed since always disabled.
-    // [14. Cutter length compensation ]: G43.1 and G49 supported. G43 NOT SUPPORTED.
-    // NOTE: If G43 were supported, its operation wouldn't be any different from G43.1 in terms
-    // of execution. The error-checking step would simply load the offset value into the correct
-    // axis of the block XYZ value array.
+    // [14. Cutter length compensation ]: G43, G43.1 and G49 supported.
+    // NOTE: G43 is no different from G43.1 in terms of execution. The error-checking step has
+    // loaded the table's offset value into the correct axis of the block XYZ value array.
     if (axis_command == AxisCommand::ToolLengthOffset) {  // Indicates a change.
         gc_state.modal.tool_length = gc_block.modal.tool_length;
         if (gc_state.modal.tool_length == ToolLengthOffset::Cancel) {  // G49
             gc_block.values.xyz[TOOL_LENGTH_OFFSET_AXIS] = 0.0;
         }
-        // else G43.1
+        // else G43 or G43.1
         if (gc_state.tool_length_offset != gc_block.values.xyz[TOOL_LENGTH_OFFSET_AXIS]) {
             gc_state.tool_length_offset = gc_block.values.xyz[TOOL_LENGTH_OFFSET_AXIS];
             system_flag_wco_change();
@@ -1462,14 +2044,23 @@ Error gc_execute_line(char* line, uint8_t client) {
         memcpy(gc_state.coord_system, block_coord_system, sizeof(gc_state.coord_system));
         system_flag_wco_change();
     }
-    // [16. Set path control mode ]: G61.1/G64 NOT SUPPORTED
-    // gc_state.modal.control = gc_block.modal.control; // NOTE: Always default.
+    // [16. Set path control mode ]: G61.1 NOT SUPPORTED
+    gc_state.modal.control  = gc_block.modal.control;
+    gc_state.path_tolerance = path_tolerance;
+    if (gc_state.modal.control == ControlMode::Continuous) {
+        pl_data->blend_tolerance = gc_state.path_tolerance;  // Record data for planner use.
+    }
     // [17. Set distance mode ]:
     gc_state.modal.distance = gc_block.modal.distance;
-    // [18. Set retract mode ]: NOT SUPPORTED
+    // [18. Set retract mode ]:
+    gc_state.modal.retract = gc_block.modal.retract;
     // [19. Go to predefined position, Set G10, or Set axis offsets ]:
     switch (gc_block.non_modal_command) {
         case NonModal::SetCoordinateData:
+            if (gc_block.values.l == 1) {
+                tool_table_set_offsets(pValue, tool_length, tool_diameter);
+                break;
+            }
             coords[coord_select]->set(coord_data);
             // Update system coordinate system if currently active.
             if (gc_state.modal.coord_select == coord_select) {
@@ -1513,7 +2104,7 @@ Error gc_execute_line(char* line, uint8_t client) {
         if (axis_command == AxisCommand::MotionMode) {
             GCUpdatePos gc_update_pos = GCUpdatePos::Target;
             if (gc_state.modal.motion == Motion::Linear) {
-                cartesian_to_motors(gc_block.values.xyz, pl_data, gc_state.position);
+                mc_fit_line(gc_block.values.xyz, pl_data, gc_state.position, axis_0, axis_1, axis_linear);
             } else if (gc_state.modal.motion == Motion::Seek) {
                 pl_data->motion.rapidMotion = 1;  // Set rapid motion flag.
                 cartesian_to_motors(gc_block.values.xyz, pl_data, gc_state.position);
@@ -1527,6 +2118,38 @@ Error gc_execute_line(char* line, uint8_t client) {
                        axis_1,
                        axis_linear,
                        bit_istrue(gc_parser_flags, GCParserArcIsClockwise));
+            } else if (gc_is_canned_cycle(gc_state.modal.motion)) {
+                // G98 retracts to the height the tool was at before the hole, but never below the R plane.
+                gc_state.canned_cycle = canned_cycle;
+                float retract_z       = canned_cycle.r_plane;
+                if (gc_state.modal.retract == RetractMode::OldZ) {
+                    retract_z = MAX(retract_z, gc_state.position[Z_AXIS]);
+                }
+                // L repeats the hole. In incremental mode each repeat moves on by the programmed distance.
+                float step[MAX_N_AXIS];
+                float hole[MAX_N_AXIS];
+                memcpy(hole, gc_block.values.xyz, sizeof(hole));
+                for (idx = 0; idx < n_axis; idx++) {
+                    step[idx] = gc_block.values.xyz[idx] - gc_state.position[idx];
+                }
+                for (uint8_t repeat = 0; repeat < gc_block.values.l; repeat++) {
+                    if (gc_block.modal.distance == Distance::Incremental) {
+                        for (idx = 0; idx < n_axis; idx++) {
+                            hole[idx] = gc_state.position[idx] + step[idx];
+                        }
+                    }
+                    if (!mc_canned_cycle(hole, pl_data, gc_state.position, gc_state.modal.motion, &canned_cycle, retract_z)) {
+                        break;
+                    }
+                }
+                gc_update_pos = GCUpdatePos::None;  // mc_canned_cycle() leaves gc_state.position at the retract height.
+#ifdef SPINDLE_SYNC
+            } else if (gc_state.modal.motion == Motion::SpindleSync) {
+                mc_spindle_sync(gc_block.values.xyz, pl_data, gc_state.position, gc_block.values.ijk[Z_AXIS]);
+            } else if (gc_state.modal.motion == Motion::RigidTap) {
+                mc_rigid_tap(gc_block.values.xyz, pl_data, gc_state.position, gc_block.values.ijk[Z_AXIS]);
+                gc_update_pos = GCUpdatePos::None;  // mc_rigid_tap() leaves gc_state.position at the start.
+#endif
             } else {
                 // NOTE: gc_block.values.xyz is returned from mc_probe_cycle with the updated position value. So
                 // upon a successful probing cycle, the machine position and the returned value should be the same.
@@ -1609,6 +2232,57 @@ Error gc_execute_line(char* line, uint8_t client) {
     return Error::Ok;
 }
 
+bool gc_tokenize_stored(const char* line, gc_word_t* words, uint8_t* n_words) {
+    char copy[256];
+    if (strlen(line) >= sizeof(copy) || strpbrk(line, "()#[;%$")) {
+        return false;
+    }
+    const char* s = line;
+    while (isspace(*s)) {
+        s++;
+    }
+    if (toupper(*s) == 'O') {
+        return false;
+    }
+    strcpy(copy, line);
+    return gc_tokenize_line(copy, 0, words, n_words) == Error::Ok;
+}
+
+Error gc_execute_words(const gc_word_t* words, uint8_t n_words, uint8_t client) {
+    static char empty[] = "";
+    gc_stored_words     = words;
+    gc_stored_count     = n_words;
+    Error status        = gc_execute_line(empty, client);
+    gc_stored_words     = NULL;  // In case the parser returned before it took them
+    return status;
+}
+
+// Lines with comments, O-words or parameters have side effects before or during STEP 2, and
+// long lines are not cached, so those are left alone. The parse is stored against
+// the current modes, so if another client changes them first it is simply not used.
+void gc_prepare_line(const char* line, uint8_t client) {
+#ifdef GCODE_LINE_CACHE_SIZE
+    char copy[GCODE_LINE_CACHE_LENGTH + 1];
+    if (strlen(line) > GCODE_LINE_CACHE_LENGTH || strpbrk(line, "()#[;") || *line == '$') {
+        return;
+    }
+    const char* s = line;
+    while (isspace(*s)) {
+        s++;
+    }
+    if (toupper(*s) == 'O') {
+        return;
+    }
+    strcpy(copy, line);
+#    ifdef REPORT_ECHO_LINE_RECEIVED
+    collapseGCode(copy);  // As gc_execute_line() does before it looks the line up
+#    endif
+    gc_preparing = true;
+    gc_execute_line(copy, client);
+    gc_preparing = false;
+#endif
+}
+
 /*
   Not supported:
 
@@ -1618,18 +2292,15 @@ Error gc_execute_line(char* line, uint8_t client) {
   - Evaluation of expressions
   - Variables
   - Override control (TBD)
-  - Tool changes
   - Switches
 
    (*) Indicates optional parameter, enabled through config.h and re-compile
    group 0 = {G92.2, G92.3} (Non modal: Cancel and re-enable G92 offsets)
    group 1 = {G81 - G89} (Motion modes: Canned cycles)
    group 4 = {M1} (Optional stop, ignored)
-   group 6 = {M6} (Tool change)
    group 7 = {G41, G42} cutter radius compensation (G40 is supported)
-   group 8 = {G43} tool length offset (G43.1/G49 are supported)
    group 8 = {M7*} enable mist coolant (* Compile-option)
    group 9 = {M48, M49} enable/disable feed and speed override switches
    group 10 = {G98, G99} return mode canned cycles
-   group 13 = {G61.1, G64} path control mode (G61 is supported)
+   group 13 = {G61.1} path control mode (G61 and G64 are supported)
 */
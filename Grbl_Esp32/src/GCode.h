@@ -40,7 +40,7 @@ enum class ModalGroup : uint8_t {
     MG5  = 5,   // [G93,G94] Feed rate mode
     MG6  = 6,   // [G20,G21] Units
     MG7  = 7,   // [G40] Cutter radius compensation mode. G41/42 NOT SUPPORTED.
-    MG8  = 8,   // [G43.1,G49] Tool length offset
+    MG8  = 8,   // [G43,G43.1,G49] Tool length offset
     MG12 = 9,   // [G54,G55,G56,G57,G58,G59] Coordinate system selection
     MG13 = 10,  // [G61] Control mode
     MM4  = 11,  // [M0,M1,M2,M30] Stopping
@@ -49,6 +49,8 @@ enum class ModalGroup : uint8_t {
     MM8  = 13,  // [M7,M8,M9] Coolant control
     MM9  = 14,  // [M56] Override control
     MM10 = 15,  // [M62, M63, M64, M65, M67, M68] User Defined http://linuxcnc.org/docs/html/gcode/overview.html#_modal_groups
+    MG10 = 16,  // [G98,G99] Canned cycle return mode
+    MG14 = 17,  // [G96,G97] Spindle speed mode
 };
 
 // Command actions for within execution-type modal groups (motion, stopping, non-modal). Used
@@ -83,6 +85,12 @@ enum class Motion : uint8_t {
     ProbeTowardNoError = 141,  // G38.3 (Do not alter value)
     ProbeAway          = 142,  // G38.4 (Do not alter value)
     ProbeAwayNoError   = 143,  // G38.5 (Do not alter value)
+    DrillChipBreak     = 73,   // G73 (Do not alter value)
+    Drill              = 81,   // G81 (Do not alter value)
+    DrillDwell         = 82,   // G82 (Do not alter value)
+    DrillPeck          = 83,   // G83 (Do not alter value)
+    SpindleSync        = 33,   // G33 (Do not alter value)
+    RigidTap           = 133,  // G33.1 (Do not alter value)
     None               = 80,   // G80 (Do not alter value)
 };
 
@@ -132,9 +140,22 @@ enum class CutterCompensation : uint8_t {
     Enable  = 1,
 };
 
+// Modal Group G10: Canned cycle return mode
+enum class RetractMode : uint8_t {
+    OldZ   = 0,  // G98 (Default: Must be zero)
+    RPlane = 1,  // G99
+};
+
 // Modal Group G13: Control mode
 enum class ControlMode : uint8_t {
-    ExactPath = 0,  // G61 (Default: Must be zero)
+    ExactPath  = 0,  // G61 (Default: Must be zero)
+    Continuous = 1,  // G64
+};
+
+// Modal Group G14: Spindle speed mode
+enum class SpindleSpeedMode : uint8_t {
+    Rpm          = 0,  // G97 (Default: Must be zero)
+    SurfaceSpeed = 1,  // G96
 };
 
 // Modal Group M7: Spindle control
@@ -180,6 +201,7 @@ static const int MaxUserDigitalPin = 4;
 enum class ToolLengthOffset : uint8_t {
     Cancel        = 0,  // G49 (Default: Must be zero)
     EnableDynamic = 1,  // G43.1
+    Enable        = 2,  // G43, from the tool table
 };
 
 enum class ToolChange : uint8_t {
@@ -210,6 +232,7 @@ enum class GCodeWord : uint8_t {
     A = 15,
     B = 16,
     C = 17,
+    H = 18,
 };
 
 // GCode parser position updating flags
@@ -260,27 +283,30 @@ CoordIndex& operator ++ (CoordIndex& i);
 
 // NOTE: When this struct is zeroed, the 0 values in the above types set the system defaults.
 typedef struct {
-    Motion   motion;     // {G0,G1,G2,G3,G38.2,G80}
+    Motion   motion;     // {G0,G1,G2,G3,G38.2,G73,G80,G81,G82,G83}
     FeedRate feed_rate;  // {G93,G94}
     Units    units;      // {G20,G21}
     Distance distance;   // {G90,G91}
     // ArcDistance distance_arc; // {G91.1} NOTE: Don't track. Only default supported.
     Plane plane_select;  // {G17,G18,G19}
     // CutterCompensation cutter_comp;  // {G40} NOTE: Don't track. Only default supported.
-    ToolLengthOffset tool_length;   // {G43.1,G49}
+    ToolLengthOffset tool_length;   // {G43,G43.1,G49}
     CoordIndex       coord_select;  // {G54,G55,G56,G57,G58,G59}
-    // uint8_t control;      // {G61} NOTE: Don't track. Only default supported.
-    ProgramFlow  program_flow;  // {M0,M1,M2,M30}
-    CoolantState coolant;       // {M7,M8,M9}
-    SpindleState spindle;       // {M3,M4,M5}
-    ToolChange   tool_change;   // {M6}
-    IoControl    io_control;    // {M62, M63, M67}
-    Override     override;      // {M56}
+    RetractMode      retract;       // {G98,G99}
+    ControlMode      control;       // {G61,G64}
+    SpindleSpeedMode speed_mode;    // {G96,G97}
+    ProgramFlow      program_flow;  // {M0,M1,M2,M30}
+    CoolantState     coolant;       // {M7,M8,M9}
+    SpindleState     spindle;       // {M3,M4,M5}
+    ToolChange       tool_change;   // {M6}
+    IoControl        io_control;    // {M62, M63, M67}
+    Override         override;      // {M56}
 } gc_modal_t;
 
 typedef struct {
     uint8_t e;                // M67
     float   f;                // Feed
+    uint8_t h;                // G43 tool length offset
     float   ijk[3];           // I,J,K Axis arc offsets - only 3 are possible
     uint8_t l;                // G10 or canned cycles parameters
     int32_t n;                // Line number
@@ -292,12 +318,22 @@ typedef struct {
     float   xyz[MAX_N_AXIS];  // X,Y,Z Translational axes
 } gc_values_t;
 
+// Words of a canned drilling cycle. They stay in effect for the following blocks until the
+// cycle is cancelled, so a row of holes only needs the XY of each hole.
+typedef struct {
+    float r_plane;  // R retract plane, machine Z in mm
+    float depth;    // Z bottom of the hole, machine Z in mm
+    float peck;     // Q peck depth in mm (G73,G83)
+    float dwell;    // P dwell at the bottom in seconds (G82)
+} gc_canned_cycle_t;
+
 typedef struct {
     gc_modal_t modal;
 
     float   spindle_speed;  // RPM
+    float   css_speed;      // G96 surface speed in mm/min
     float   feed_rate;      // Millimeters/min
-    uint8_t tool;           // Tracks tool number. NOT USED.
+    uint8_t tool;           // Tool selected by T, loaded by M6
     int32_t line_number;    // Last line number sent
 
     float position[MAX_N_AXIS];  // Where the interpreter considers the tool to be at this point in the code
@@ -307,6 +343,9 @@ typedef struct {
     float coord_offset[MAX_N_AXIS];  // Retains the G92 coordinate offset (work coordinates) relative to
     // machine zero in mm. Non-persistent. Cleared upon reset and boot.
     float tool_length_offset;  // Tracks tool length offset value when enabled.
+    float path_tolerance;      // G64 P blending tolerance in mm.
+
+    gc_canned_cycle_t canned_cycle;  // Sticky R, Z, Q and P words of the active canned cycle.
 } parser_state_t;
 extern parser_state_t gc_state;
 
@@ -324,11 +363,38 @@ enum class AxisCommand : uint8_t {
     ToolLengthOffset = 3,
 };
 
+// One word of a block, split from the line by the tokenizer. int_value and mantissa are the
+// integer and hundredths parts of value, as used to decode G and M commands and integer words.
+typedef struct {
+    char     letter;
+    uint8_t  int_value;
+    uint16_t mantissa;
+    float    value;
+} gc_word_t;
+
+// A word is at least two characters, but a valid block has at most one of each value word and
+// one command per modal group, so this is ample for any block that could pass validation.
+const int MAX_GCODE_WORDS = 40;
+
 // Initialize the parser
 void gc_init();
 
 // Execute one block of rs275/ngc/g-code
 Error gc_execute_line(char* line, uint8_t client);
 
+// Parse ahead a line that is waiting for planner space, so that it runs from the line cache.
+void gc_prepare_line(const char* line, uint8_t client);
+
+// Splits a line kept to be run many times, for gc_execute_words(). Returns false if the line
+// must be read as text each time it runs: one with a comment, an O-word, a parameter or
+// expression, or a $ command, or one with a bad word, for gc_execute_line() to report.
+bool gc_tokenize_stored(const char* line, gc_word_t* words, uint8_t* n_words);
+
+// Executes a block split by gc_tokenize_stored(), as gc_execute_line() would its line.
+Error gc_execute_words(const gc_word_t* words, uint8_t n_words, uint8_t client);
+
+// Remove whitespace and comments from a line in place and convert it to upper case
+void collapseGCode(char* line);
+
 // Set g-code parser position. Input in steps.
 void gc_sync_position();
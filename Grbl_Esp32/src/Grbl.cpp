@@ -20,6 +20,61 @@
 
 #include "Grbl.h"
 #include <WiFi.h>
+#include <esp_timer.h>
+
+// When each stage of startup finished, in microseconds since the chip started.
+static const int BOOT_STAGES_MAX = 8;
+static struct {
+    const char* name;
+    int64_t     us;
+} boot_stages[BOOT_STAGES_MAX];
+static volatile int  boot_stage_count = 0;
+static volatile bool network_started  = false;
+
+static void boot_stage(const char* name) {
+    if (boot_stage_count < BOOT_STAGES_MAX) {
+        boot_stages[boot_stage_count].name = name;
+        boot_stages[boot_stage_count].us   = esp_timer_get_time();
+        boot_stage_count++;
+    }
+}
+
+void report_boot_stages(uint8_t client) {
+    int64_t previous = 0;
+    for (int i = 0; i < boot_stage_count; i++) {
+        grbl_sendf(client,
+                   "[BOOT:%s,%.1f,%.1f]\r\n",
+                   boot_stages[i].name,
+                   boot_stages[i].us / 1000.0,
+                   (boot_stages[i].us - previous) / 1000.0);
+        previous = boot_stages[i].us;
+    }
+    if (!network_started) {
+        grbl_sendf(client, "[BOOT:network,starting]\r\n");
+    }
+}
+
+bool network_ready() {
+    return network_started;
+}
+
+static void network_init() {
+#ifdef ENABLE_WIFI
+    WebUI::wifi_config.begin();
+#endif
+#ifdef ENABLE_BLUETOOTH
+    WebUI::bt_config.begin();
+#endif
+    boot_stage("network");
+    network_started = true;
+}
+
+#ifdef ENABLE_LAZY_NETWORK
+static void networkInitTask(void* pvParameters) {
+    network_init();
+    vTaskDelete(NULL);
+}
+#endif
 
 void grbl_init() {
 #ifdef USE_I2S_OUT
@@ -30,7 +85,9 @@ void grbl_init() {
     WiFi.enableSTA(false);
     WiFi.enableAP(false);
     WiFi.mode(WIFI_OFF);
-    client_init();  // Setup serial baud rate and interrupts
+    heap_watch_task(xTaskGetCurrentTaskHandle());  // The Arduino loop task, which runs Grbl
+    report_init();                                 // Setup the output formatting buffers
+    client_init();                                 // Setup serial baud rate and interrupts
     display_init();
     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Grbl_ESP32 Ver %s Date %s", GRBL_VERSION, GRBL_VERSION_BUILD);  // print grbl_esp32 verion info
     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Compiled with ESP32 SDK:%s", ESP.getSdkVersion());              // print the SDK version
@@ -38,11 +95,21 @@ void grbl_init() {
 #ifdef MACHINE_NAME
     report_machine_type(CLIENT_SERIAL);
 #endif
-    settings_init();  // Load Grbl settings from non-volatile storage
-    stepper_init();   // Configure stepper pins and interrupt timers
-    system_ini();     // Configure pinout pins and pin-change interrupt (Renamed due to conflict with esp32 files)
+    boot_stage("serial");
+    settings_init();   // Load Grbl settings from non-volatile storage
+    client_apply_serial_settings();
+    report_settings_init();
+    limits_settings_init();
+    task_apply_placement();  // The tasks started before the settings were loaded
+    boot_stage("settings");
+    plan_init();        // Allocate the planner buffer
+    heightmap_init();   // Load the saved Z compensation grid
+    tool_table_init();  // Load the saved tool offsets and pockets
+    stepper_init();     // Configure stepper pins and interrupt timers
+    system_ini();       // Configure pinout pins and pin-change interrupt (Renamed due to conflict with esp32 files)
     init_motors();
     memset(sys_position, 0, sizeof(sys_position));  // Clear machine position.
+    limits_restore_position();                      // Unless it was saved for $Homing/FastRef
     machine_init();                                 // weak definition in Grbl.cpp does nothing
     // Initialize system state.
 #ifdef FORCE_INITIALIZATION_ALARM
@@ -63,14 +130,24 @@ void grbl_init() {
         sys.state = State::Alarm;
     }
 #endif
+    if (!plan_ready()) {
+        sys.state = State::Alarm;  // Nothing can move without a planner buffer
+    }
     Spindles::Spindle::select();
-#ifdef ENABLE_WIFI
-    WebUI::wifi_config.begin();
+#ifdef SPINDLE_SYNC
+    spindle_encoder_init();
 #endif
-#ifdef ENABLE_BLUETOOTH
-    WebUI::bt_config.begin();
+#ifdef AXIS_ENCODERS
+    axis_encoder_init();
+#endif
+    command_queue_init();
+    boot_stage("motion");
+#ifdef ENABLE_LAZY_NETWORK
+    // WiFi can take seconds to connect; motion control does not wait for it.
+    xTaskCreatePinnedToCore(networkInitTask, "networkInitTask", 8192, NULL, 1, NULL, SUPPORT_TASK_CORE);
+#else
+    network_init();
 #endif
-    WebUI::inputBuffer.begin();
 }
 
 static void reset_variables() {
@@ -80,6 +157,7 @@ static void reset_variables() {
     sys.state             = prior_state;
     sys.f_override        = FeedOverride::Default;              // Set to 100%
     sys.r_override        = RapidOverride::Default;             // Set to 100%
+    sys.f_adaptive        = FeedOverride::Default;              // Set to 100%
     sys.spindle_speed_ovr = SpindleSpeedOverride::Default;      // Set to 100%
     memset(sys_probe_position, 0, sizeof(sys_probe_position));  // Clear probe position.
 
@@ -90,6 +168,7 @@ static void reset_variables() {
     cycle_stop                           = false;
     sys_rt_f_override                    = FeedOverride::Default;
     sys_rt_r_override                    = RapidOverride::Default;
+    sys_rt_f_adaptive                    = FeedOverride::Default;
     sys_rt_s_override                    = SpindleSpeedOverride::Default;
 
     // Reset Grbl primary systems.
@@ -99,6 +178,14 @@ static void reset_variables() {
     coolant_init();
     limits_init();
     probe_init();
+    mc_discard_arc();
+    jog_velocity_stop();
+    binary_motion_reset();
+    oword_reset();
+    stored_macro_reset();
+    command_queue_reset();
+    mc_discard_fitted_lines();
+    mc_discard_merged_line();
     plan_reset();  // Clear block buffer and planner variables
     st_reset();    // Clear stepper subsystem variables
     // Sync cleared gcode and planner positions to current system position.
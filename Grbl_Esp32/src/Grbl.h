@@ -37,6 +37,7 @@ const char* const GRBL_VERSION_BUILD = "20210424";
 // Define the Grbl system include files. NOTE: Do not alter organization.
 #include "Config.h"
 #include "NutsBolts.h"
+#include "SpscRing.h"
 
 #include "Defaults.h"
 #include "Error.h"
@@ -50,18 +51,39 @@ const char* const GRBL_VERSION_BUILD = "20210424";
 #include "CoolantControl.h"
 #include "Limits.h"
 #include "MotionControl.h"
+#include "LinearKinematics.h"
+#include "HeightMap.h"
+#include "ProbeRoutines.h"
+#include "ToolTable.h"
+#include "HeapStats.h"
+#include "TaskStats.h"
+#include "BlockPool.h"
+#include "Profiles.h"
+#include "BinaryMotion.h"
+#include "Raster.h"
+#include "OWord.h"
+#include "Expression.h"
+#include "Bench.h"
+#include "FileCheck.h"
+#include "StepTrace.h"
+#include "Capture.h"
+#include "EventTrace.h"
 #include "Protocol.h"
 #include "Uart.h"
 #include "Serial.h"
 #include "Report.h"
 #include "Pins.h"
 #include "Spindles/Spindle.h"
+#include "SpindleEncoder.h"
+#include "AxisEncoder.h"
 #include "Motors/Motors.h"
 #include "Stepper.h"
 #include "Jog.h"
 #include "WebUI/InputBuffer.h"
 #include "Settings.h"
 #include "SettingsDefinitions.h"
+#include "StoredLines.h"
+#include "CommandQueue.h"
 #include "WebUI/WebSettings.h"
 
 #include "UserOutput.h"
@@ -70,19 +92,35 @@ const char* const GRBL_VERSION_BUILD = "20210424";
 
 // Do not guard this because it is needed for local files too
 #include "SDCard.h"
+#include "SDCache.h"
+#include "SDEstimate.h"
+#include "SDPreview.h"
+#include "SDQueue.h"
+#include "JobLog.h"
+#include "EspNowSync.h"
+#include "AdaptiveFeed.h"
 
 #ifdef ENABLE_BLUETOOTH
 #    include "WebUI/BTConfig.h"
 #endif
 
+#ifdef ENABLE_USB_CDC
+#    include "UsbCdc.h"
+#endif
+
 #ifdef ENABLE_WIFI
 #    include "WebUI/WifiConfig.h"
 #    ifdef ENABLE_HTTP
 #        include "WebUI/Serial2Socket.h"
+#        include "WebUI/SocketStream.h"
+#        include "WebUI/SocketEvents.h"
 #    endif
 #    ifdef ENABLE_TELNET
 #        include "WebUI/TelnetServer.h"
 #    endif
+#    ifdef ENABLE_TCP_STREAM
+#        include "WebUI/TcpStream.h"
+#    endif
 #    ifdef ENABLE_NOTIFICATIONS
 #        include "WebUI/NotificationsService.h"
 #    endif
@@ -93,6 +131,13 @@ const char* const GRBL_VERSION_BUILD = "20210424";
 void grbl_init();
 void run_once();
 
+// True once WiFi and Bluetooth have been started, which with ENABLE_LAZY_NETWORK happens after
+// grbl_init() has returned.
+bool network_ready();
+
+// Sends when each stage of startup finished, and how long it took.
+void report_boot_stages(uint8_t client);
+
 void machine_init();                      // weak definition in Grbl.cpp
 void display_init();                      // weak definition in Grbl.cpp
 void user_m30();                          // weak definition in Grbl.cpp/
@@ -105,6 +150,15 @@ bool cartesian_to_motors(float* target, plan_line_data_t* pl_data, float* positi
 bool kinematics_pre_homing(uint8_t cycle_mask);
 void kinematics_post_homing();
 
+// Converts count cartesian points to motor positions in one call, so kinematics that split
+// lines into segments can transform a whole batch together. Returns how many points, counting
+// from the first, were converted; the rest are unreachable.
+const int KINEMATICS_BATCH_SIZE = 8;
+uint8_t   cartesian_to_motors_batch(float cartesian[][MAX_N_AXIS], float motors[][MAX_N_AXIS], uint8_t count);
+
+// mm, the shortest segment mc_kinematics_segment_count() splits a line into, however curved
+const float KINEMATICS_MIN_SEGMENT_LENGTH = 0.05;
+
 bool limitsCheckTravel(float* target);  // weak in Limits.cpp; true if out of range
 
 void motors_to_cartesian(float* cartestian, float* motors, int n_axis);  // weak definition
@@ -0,0 +1,153 @@
+/*
+  HeapStats.cpp - Memory use by subsystem, for $Heap
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  A largest free block much smaller than the free total means the heap is fragmented, and a
+  low water mark near zero means something came close to running out.
+*/
+
+#include "Grbl.h"
+
+#include <soc/soc_memory_layout.h>
+
+static const char* heap_tag_names[] = { "Planner", "Stepper", "Serial", "SD", "I2S", "Web" };
+
+typedef struct {
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t failed;
+    uint32_t bytes;  // Held now
+    uint32_t psram;  // Part of bytes in PSRAM
+    uint32_t peak;
+} heap_tag_stats_t;
+
+static heap_tag_stats_t heap_tags[int(HeapTag::Count)];
+static portMUX_TYPE     heap_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static const int    HEAP_TASKS_MAX = 16;
+static TaskHandle_t heap_tasks[HEAP_TASKS_MAX];
+static int          heap_task_count = 0;
+
+void* heap_alloc(HeapTag tag, size_t size, uint32_t caps) {
+    void*             ptr = heap_caps_calloc(1, size, caps);
+    heap_tag_stats_t& t   = heap_tags[int(tag)];
+    portENTER_CRITICAL(&heap_mux);
+    if (ptr) {
+        t.allocs++;
+        t.bytes += size;
+        if (esp_ptr_external_ram(ptr)) {
+            t.psram += size;
+        }
+        if (t.bytes > t.peak) {
+            t.peak = t.bytes;
+        }
+    } else {
+        t.failed++;
+    }
+    portEXIT_CRITICAL(&heap_mux);
+    return ptr;
+}
+
+void heap_free(HeapTag tag, void* ptr, size_t size) {
+    if (!ptr) {
+        return;
+    }
+    bool external = esp_ptr_external_ram(ptr);
+    heap_caps_free(ptr);
+    heap_tag_stats_t& t = heap_tags[int(tag)];
+    portENTER_CRITICAL(&heap_mux);
+    t.frees++;
+    t.bytes -= size;
+    if (external) {
+        t.psram -= size;
+    }
+    portEXIT_CRITICAL(&heap_mux);
+}
+
+void* heap_alloc_large(HeapTag tag, size_t size) {
+    // Checked first so that falling back is not counted as a failure
+    if (size >= HEAP_PSRAM_MIN && psramFound() && heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM) >= size) {
+        return heap_alloc(tag, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    return heap_alloc(tag, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+}
+
+void heap_watch_task(TaskHandle_t task) {
+    portENTER_CRITICAL(&heap_mux);
+    if (task && heap_task_count < HEAP_TASKS_MAX) {
+        heap_tasks[heap_task_count++] = task;
+    }
+    portEXIT_CRITICAL(&heap_mux);
+}
+
+int heap_watched_tasks(TaskHandle_t* tasks, int max) {
+    portENTER_CRITICAL(&heap_mux);
+    int count = heap_task_count < max ? heap_task_count : max;
+    memcpy(tasks, heap_tasks, count * sizeof(TaskHandle_t));
+    portEXIT_CRITICAL(&heap_mux);
+    return count;
+}
+
+BaseType_t heap_task_create(TaskFunction_t function,
+                            const char*    name,
+                            uint32_t       stack_size,
+                            void*          parameters,
+                            UBaseType_t    priority,
+                            TaskHandle_t*  handle,
+                            BaseType_t     core) {
+    task_placement(name, &priority, &core);
+    TaskHandle_t task   = NULL;
+    BaseType_t   result = xTaskCreatePinnedToCore(function, name, stack_size, parameters, priority, &task, core);
+    if (result == pdPASS) {
+        heap_watch_task(task);
+    }
+    if (handle) {
+        *handle = task;
+    }
+    return result;
+}
+
+void heap_report(uint8_t client) {
+    grbl_sendf(client,
+               "[HEAP:Free %u,Min %u,Largest %u,Internal %u]\r\n",
+               heap_caps_get_free_size(MALLOC_CAP_8BIT),
+               heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT),
+               heap_caps_get_largest_free_block(MALLOC_CAP_8BIT),
+               heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    if (psramFound()) {
+        grbl_sendf(client,
+                   "[HEAP:PSRAM %u,Largest %u]\r\n",
+                   heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+                   heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM));
+    }
+    for (int i = 0; i < int(HeapTag::Count); i++) {
+        portENTER_CRITICAL(&heap_mux);
+        heap_tag_stats_t t = heap_tags[i];
+        portEXIT_CRITICAL(&heap_mux);
+        grbl_sendf(client,
+                   "[HEAP:%s,Bytes %u,PSRAM %u,Peak %u,Allocs %u,Frees %u,Failed %u]\r\n",
+                   heap_tag_names[i],
+                   t.bytes,
+                   t.psram,
+                   t.peak,
+                   t.allocs,
+                   t.frees,
+                   t.failed);
+    }
+    pool_report(client);
+    for (int i = 0; i < heap_task_count; i++) {
+        // The stack high water mark is in bytes on the ESP32.
+        grbl_sendf(client, "[STACK:%s,Unused %u]\r\n", pcTaskGetTaskName(heap_tasks[i]), uxTaskGetStackHighWaterMark(heap_tasks[i]));
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+/*
+  HeapStats.h - Memory use by subsystem, for $Heap
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_heap_caps.h>
+#include <cstdint>
+
+// The subsystems whose buffers are counted. Memory taken by libraries, the web server among
+// them, is not, but shows in the free and largest block figures.
+enum class HeapTag : uint8_t {
+    Planner = 0,
+    Stepper,
+    Serial,
+    SD,
+    I2S,
+    Web,
+    Count,
+};
+
+// heap_caps_calloc() counted against tag. The size given to heap_free() must be the one
+// that was allocated.
+void* heap_alloc(HeapTag tag, size_t size, uint32_t caps = MALLOC_CAP_8BIT);
+void  heap_free(HeapTag tag, void* ptr, size_t size);
+
+// For buffers that only tasks touch, never an ISR or DMA. On modules with PSRAM, those of
+// HEAP_PSRAM_MIN bytes or more go there to leave internal RAM for the planner, the stepper
+// and the network stack; otherwise, or if PSRAM is full, they come from internal RAM.
+const size_t HEAP_PSRAM_MIN = 1024;
+void*        heap_alloc_large(HeapTag tag, size_t size);
+
+// xTaskCreatePinnedToCore() that also puts the task in the $Heap stack report, on the core
+// and at the priority $Tasks/Placement gives it, if any. Tasks made this way must not be deleted.
+BaseType_t heap_task_create(TaskFunction_t function,
+                            const char*    name,
+                            uint32_t       stack_size,
+                            void*          parameters,
+                            UBaseType_t    priority,
+                            TaskHandle_t*  handle,
+                            BaseType_t     core);
+
+// Adds a task that was not made by heap_task_create(), such as the Arduino loop task.
+void heap_watch_task(TaskHandle_t task);
+
+// Copies up to max of the watched tasks into tasks and returns how many it copied.
+int heap_watched_tasks(TaskHandle_t* tasks, int max);
+
+// Sends the free heap, its low water mark and largest block, the counts for each tag, the
+// block pools and the unused stack of each watched task.
+void heap_report(uint8_t client);
@@ -0,0 +1,220 @@
+/*
+  HeightMap.cpp - Z compensation from a probed grid of surface heights
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The map is kept in machine coordinates so that changing work offsets after probing does
+  not move it. Heights are stored relative to the first probed point, where the user
+  normally zeroes Z. The map is written to LocalFS as a raw image of heightmap_t.
+*/
+
+#include "Grbl.h"
+
+#include "LocalFS.h"
+
+static const char*    HEIGHTMAP_FILE  = "/heightmap.bin";
+static const uint32_t HEIGHTMAP_MAGIC = 0x484d4150;  // "HMAP"
+
+typedef struct {
+    uint32_t magic;
+    uint8_t  nx;
+    uint8_t  ny;
+    float    x0;  // Machine position of the first grid point
+    float    y0;
+    float    dx;  // Grid spacing
+    float    dy;
+    float    z[HEIGHTMAP_MAX_POINTS][HEIGHTMAP_MAX_POINTS];  // z[row][column], row along Y
+} heightmap_t;
+
+static heightmap_t heightmap;
+static bool        map_valid;
+static bool        probing;
+
+static bool heightmap_mount() {
+    return localfs_mount();
+}
+
+static void heightmap_save() {
+    if (!heightmap_mount()) {
+        return;
+    }
+    File file = LocalFS.open(HEIGHTMAP_FILE, FILE_WRITE);
+    if (file) {
+        file.write((const uint8_t*)&heightmap, sizeof(heightmap));
+        file.close();
+    }
+}
+
+void heightmap_init() {
+    map_valid = false;
+    if (!heightmap_mount() || !LocalFS.exists(HEIGHTMAP_FILE)) {
+        return;
+    }
+    File file = LocalFS.open(HEIGHTMAP_FILE, FILE_READ);
+    if (!file) {
+        return;
+    }
+    map_valid = file.read((uint8_t*)&heightmap, sizeof(heightmap)) == sizeof(heightmap) && heightmap.magic == HEIGHTMAP_MAGIC &&
+                heightmap.nx >= 2 && heightmap.ny >= 2 && heightmap.nx <= HEIGHTMAP_MAX_POINTS && heightmap.ny <= HEIGHTMAP_MAX_POINTS;
+    file.close();
+    if (map_valid) {
+        grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Height map %dx%d loaded", heightmap.nx, heightmap.ny);
+    }
+}
+
+bool heightmap_active() {
+    return map_valid && !probing && heightmap_enable->get();
+}
+
+// Grid cell and fraction along it for a position, clamped to the grid.
+static void heightmap_locate(float position, float origin, float spacing, uint8_t points, uint8_t* cell, float* fraction) {
+    float index = (position - origin) / spacing;
+    if (index <= 0.0f) {
+        *cell     = 0;
+        *fraction = 0.0f;
+    } else if (index >= points - 1) {
+        *cell     = points - 2;
+        *fraction = 1.0f;
+    } else {
+        *cell     = (uint8_t)index;
+        *fraction = index - *cell;
+    }
+}
+
+float heightmap_offset(float x, float y) {
+    uint8_t i, j;
+    float   u, v;
+    heightmap_locate(x, heightmap.x0, heightmap.dx, heightmap.nx, &i, &u);
+    heightmap_locate(y, heightmap.y0, heightmap.dy, heightmap.ny, &j, &v);
+    float bottom = heightmap.z[j][i] + u * (heightmap.z[j][i + 1] - heightmap.z[j][i]);
+    float top    = heightmap.z[j + 1][i] + u * (heightmap.z[j + 1][i + 1] - heightmap.z[j + 1][i]);
+    return bottom + v * (top - bottom);
+}
+
+float heightmap_segment_length() {
+    return 0.5f * MIN(fabsf(heightmap.dx), fabsf(heightmap.dy));
+}
+
+// Runs one line of G-code for the probing sequence.
+static Error heightmap_execute(uint8_t client, const char* format, ...) {
+    char    line[LINE_BUFFER_SIZE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    Error status = gc_execute_line(line, client);
+    if (status == Error::Ok && sys.abort) {
+        status = Error::HeightMapIncomplete;
+    }
+    return status;
+}
+
+Error heightmap_probe(float x0, float y0, float x1, float y1, uint8_t nx, uint8_t ny, uint8_t client) {
+    if (nx < 2 || ny < 2 || nx > HEIGHTMAP_MAX_POINTS || ny > HEIGHTMAP_MAX_POINTS || x0 == x1 || y0 == y1) {
+        return Error::InvalidValue;
+    }
+    if (sys.state != State::Idle) {
+        return Error::IdleError;
+    }
+    // Work to machine coordinates, the same way the parser applies them.
+    float x_offset = gc_state.coord_system[X_AXIS] + gc_state.coord_offset[X_AXIS];
+    float y_offset = gc_state.coord_system[Y_AXIS] + gc_state.coord_offset[Y_AXIS];
+    float mpos[MAX_N_AXIS];
+    system_convert_array_steps_to_mpos(mpos, sys_position);
+    float safe_z = mpos[Z_AXIS];
+
+    heightmap_t probed;
+    probed.magic = HEIGHTMAP_MAGIC;
+    probed.nx    = nx;
+    probed.ny    = ny;
+    probed.x0    = x0 + x_offset;
+    probed.y0    = y0 + y_offset;
+    probed.dx    = (x1 - x0) / (nx - 1);
+    probed.dy    = (y1 - y0) / (ny - 1);
+
+    bool  was_incremental = gc_state.modal.distance == Distance::Incremental;
+    Error status          = Error::Ok;
+    float reference       = 0.0;
+    map_valid             = false;
+    probing               = true;
+    for (uint8_t j = 0; j < ny && status == Error::Ok; j++) {
+        for (uint8_t n = 0; n < nx && status == Error::Ok; n++) {
+            uint8_t i = (j & 1) ? nx - 1 - n : n;  // Serpentine order keeps the XY moves short
+            float   x = probed.x0 + i * probed.dx;
+            float   y = probed.y0 + j * probed.dy;
+            status    = heightmap_execute(client, "G53G0X%.4fY%.4f", x, y);
+            if (status == Error::Ok) {
+                status = heightmap_execute(client, "G91G38.2Z%.4fF%.1f", -heightmap_probe_depth->get(), heightmap_probe_feed->get());
+            }
+            if (status == Error::Ok && !sys.probe_succeeded) {
+                status = Error::HeightMapIncomplete;  // G38.2 has already raised the probe alarm.
+            }
+            if (status == Error::Ok) {
+                float probe[MAX_N_AXIS];
+                system_convert_array_steps_to_mpos(probe, sys_probe_position);
+                if (i == 0 && j == 0) {
+                    reference = probe[Z_AXIS];
+                }
+                probed.z[j][i] = probe[Z_AXIS] - reference;
+                status         = heightmap_execute(client, "G53G0Z%.4f", safe_z);
+            }
+        }
+    }
+    if (!sys.abort) {
+        heightmap_execute(client, was_incremental ? "G91" : "G90");
+    }
+    probing = false;
+    if (status != Error::Ok) {
+        return status;
+    }
+    memcpy(&heightmap, &probed, sizeof(heightmap));
+    map_valid = true;
+    heightmap_save();
+    return Error::Ok;
+}
+
+void heightmap_clear() {
+    map_valid = false;
+    if (heightmap_mount() && LocalFS.exists(HEIGHTMAP_FILE)) {
+        LocalFS.remove(HEIGHTMAP_FILE);
+    }
+}
+
+void heightmap_report(uint8_t client) {
+    if (!map_valid) {
+        grbl_sendf(client, "[MSG: No height map]\r\n");
+        return;
+    }
+    grbl_sendf(client,
+               "[MSG: Height map %dx%d from X%.3f Y%.3f step X%.3f Y%.3f%s]\r\n",
+               heightmap.nx,
+               heightmap.ny,
+               heightmap.x0,
+               heightmap.y0,
+               heightmap.dx,
+               heightmap.dy,
+               heightmap_enable->get() ? "" : " disabled");
+    for (uint8_t j = 0; j < heightmap.ny; j++) {
+        char   row[HEIGHTMAP_MAX_POINTS * 9 + 1];
+        size_t len = 0;
+        row[0]     = '\0';
+        for (uint8_t i = 0; i < heightmap.nx && len < sizeof(row); i++) {
+            int n = snprintf(row + len, sizeof(row) - len, " %.3f", heightmap.z[j][i]);
+            if (n < 0) {
+                break;
+            }
+            len += n;
+        }
+        grbl_sendf(client, "[MSG:%s]\r\n", row);
+    }
+}
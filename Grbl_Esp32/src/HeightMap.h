@@ -0,0 +1,47 @@
+#pragma once
+
+/*
+  HeightMap.h - Z compensation from a probed grid of surface heights
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Error.h"
+
+#include <cstdint>
+
+// Grid points per axis are limited so that the whole map stays a small, fixed block of RAM.
+const int HEIGHTMAP_MAX_POINTS = 16;
+
+// Loads the height map saved on SPIFFS, if any.
+void heightmap_init();
+
+// True while a valid map is loaded, $HeightMap/Enable is on and probing is not in progress.
+bool heightmap_active();
+
+// Height of the surface at a machine XY position, relative to the first probed point. Bilinear
+// between grid points and held constant past the edges of the grid.
+float heightmap_offset(float x, float y);
+
+// Longest XY distance a compensated line moves before it is split, half the smaller grid spacing.
+float heightmap_segment_length();
+
+// Probes an nx by ny grid spanning the work coordinates x0,y0 to x1,y1 with G38.2, starting
+// and returning to the current Z between points, and saves the result.
+Error heightmap_probe(float x0, float y0, float x1, float y1, uint8_t nx, uint8_t ny, uint8_t client);
+
+// Forgets the map and removes the saved copy.
+void heightmap_clear();
+
+// Sends the grid to the client.
+void heightmap_report(uint8_t client);
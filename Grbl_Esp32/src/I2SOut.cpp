@@ -61,6 +61,8 @@
 
 #include "Pins.h"
 #include "I2SOut.h"
+#include "HeapStats.h"
+#include "EventTrace.h"
 
 // Always enable I2S streaming logic
 #define USE_I2S_OUT_STREAM_IMPL
@@ -68,7 +70,7 @@
 //
 // Configrations for DMA connected I2S
 //
-// One DMA buffer transfer takes about 2 ms
+// With the default geometry, one DMA buffer transfer takes about 2 ms
 //   I2S_OUT_DMABUF_LEN / I2S_SAMPLE_SIZE x I2S_OUT_USEC_PER_PULSE
 //   = 2000 / 4 x 4
 //   = 2000us = 2ms
@@ -81,9 +83,11 @@
 // Reference information:
 //   FreeRTOS task time slice = portTICK_PERIOD_MS = 1 ms (ESP32 FreeRTOS port)
 //
-const int I2S_SAMPLE_SIZE   = 4;                                    /* 4 bytes, 32 bits per sample */
-const int DMA_SAMPLE_COUNT  = I2S_OUT_DMABUF_LEN / I2S_SAMPLE_SIZE; /* number of samples per buffer */
-const int SAMPLE_SAFE_COUNT = (20 / I2S_OUT_USEC_PER_PULSE);        /* prevent buffer overrun (GRBL's $0 should be less than or equal 20) */
+// The geometry is set by i2s_out_init() and can be changed in the passthrough mode,
+// or while the unified stream carries no pulses, by i2s_out_set_dma_geometry().
+//
+const int I2S_SAMPLE_SIZE   = 4;                             /* 4 bytes, 32 bits per sample */
+const int SAMPLE_SAFE_COUNT = (20 / I2S_OUT_USEC_PER_PULSE); /* prevent buffer overrun (GRBL's $0 should be less than or equal 20) */
 
 #ifdef USE_I2S_OUT_STREAM_IMPL
 typedef struct {
@@ -92,6 +96,10 @@ typedef struct {
     uint32_t     rw_pos;
     lldesc_t**   desc;
     xQueueHandle queue;
+    uint32_t     count;         // number of DMA buffers
+    uint32_t     len;           // size of each buffer in bytes
+    uint32_t     sample_count;  // number of samples per buffer
+    uint32_t     fill_count;    // number of samples to fill per buffer, for adaptive latency
 } i2s_out_dma_t;
 
 static i2s_out_dma_t o_dma;
@@ -128,6 +136,10 @@ static int i2s_out_initialized = 0;
 static volatile uint32_t             i2s_out_pulse_period;
 static uint32_t                      i2s_out_remain_time_until_next_pulse;  // Time remaining until the next pulse (μsec)
 static volatile i2s_out_pulse_func_t i2s_out_pulse_func;
+static volatile bool                 i2s_out_adaptive_latency = false;
+static uint32_t                      i2s_out_last_pulse_period;
+static volatile bool                 i2s_out_unified = false;  // The stream runs all the time and carries the static writes too
+static volatile bool                 i2s_out_pulsing = false;  // The pulse callback is called while streaming
 #endif
 
 static uint8_t i2s_out_ws_pin   = 255;
@@ -195,30 +207,108 @@ static void IRAM_ATTR i2s_out_reset_fifo() {
 #ifdef USE_I2S_OUT_STREAM_IMPL
 static int IRAM_ATTR i2s_clear_dma_buffer(lldesc_t* dma_desc, uint32_t port_data) {
     uint32_t* buf = (uint32_t*)dma_desc->buf;
-    for (int i = 0; i < DMA_SAMPLE_COUNT; i++) {
+    for (int i = 0; i < o_dma.sample_count; i++) {
         buf[i] = port_data;
     }
     // Restore the buffer length.
     // The length may have been changed short when the data was filled in to prevent buffer overrun.
-    dma_desc->length = I2S_OUT_DMABUF_LEN;
+    dma_desc->length = o_dma.len;
     return 0;
 }
 
 static int IRAM_ATTR i2s_clear_o_dma_buffers(uint32_t port_data) {
-    for (int buf_idx = 0; buf_idx < I2S_OUT_DMABUF_COUNT; buf_idx++) {
+    for (int buf_idx = 0; buf_idx < o_dma.count; buf_idx++) {
         // Initialize DMA descriptor
         o_dma.desc[buf_idx]->owner        = 1;
         o_dma.desc[buf_idx]->eof          = 1;  // set to 1 will trigger the interrupt
         o_dma.desc[buf_idx]->sosf         = 0;
-        o_dma.desc[buf_idx]->length       = I2S_OUT_DMABUF_LEN;
-        o_dma.desc[buf_idx]->size         = I2S_OUT_DMABUF_LEN;
+        o_dma.desc[buf_idx]->length       = o_dma.len;
+        o_dma.desc[buf_idx]->size         = o_dma.len;
         o_dma.desc[buf_idx]->buf          = (uint8_t*)o_dma.buffers[buf_idx];
         o_dma.desc[buf_idx]->offset       = 0;
-        o_dma.desc[buf_idx]->qe.stqe_next = (lldesc_t*)((buf_idx < (I2S_OUT_DMABUF_COUNT - 1)) ? (o_dma.desc[buf_idx + 1]) : o_dma.desc[0]);
+        o_dma.desc[buf_idx]->qe.stqe_next = (lldesc_t*)((buf_idx < (o_dma.count - 1)) ? (o_dma.desc[buf_idx + 1]) : o_dma.desc[0]);
         i2s_clear_dma_buffer(o_dma.desc[buf_idx], port_data);
     }
     return 0;
 }
+
+static void i2s_out_free_dma(uint32_t count, uint32_t len, uint32_t** buffers, lldesc_t** desc) {
+    if (buffers != nullptr) {
+        for (int buf_idx = 0; buf_idx < count; buf_idx++) {
+            heap_free(HeapTag::I2S, buffers[buf_idx], len);
+        }
+        heap_free(HeapTag::I2S, buffers, count * sizeof(uint32_t*));
+    }
+    if (desc != nullptr) {
+        for (int buf_idx = 0; buf_idx < count; buf_idx++) {
+            heap_free(HeapTag::I2S, desc[buf_idx], sizeof(lldesc_t));
+        }
+        heap_free(HeapTag::I2S, desc, count * sizeof(lldesc_t*));
+    }
+}
+
+// Allocate count buffers of len bytes that can be used by the DMA controller, and their descriptors.
+static int i2s_out_alloc_dma(uint32_t count, uint32_t len, uint32_t*** buffers, lldesc_t*** desc) {
+    *buffers = (uint32_t**)heap_alloc(HeapTag::I2S, count * sizeof(uint32_t*));
+    *desc    = (lldesc_t**)heap_alloc(HeapTag::I2S, count * sizeof(lldesc_t*));
+    if (*buffers == nullptr || *desc == nullptr) {
+        i2s_out_free_dma(count, len, *buffers, *desc);
+        return -1;
+    }
+    for (int buf_idx = 0; buf_idx < count; buf_idx++) {
+        (*buffers)[buf_idx] = (uint32_t*)heap_alloc(HeapTag::I2S, len, MALLOC_CAP_DMA);
+        (*desc)[buf_idx]    = (lldesc_t*)heap_alloc(HeapTag::I2S, sizeof(lldesc_t), MALLOC_CAP_DMA);
+        if ((*buffers)[buf_idx] == nullptr || (*desc)[buf_idx] == nullptr) {
+            i2s_out_free_dma(count, len, *buffers, *desc);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// A descriptor taken from the queue may belong to a ring that has since been replaced.
+static bool IRAM_ATTR i2s_out_is_dma_desc(lldesc_t* dma_desc) {
+    for (int buf_idx = 0; buf_idx < o_dma.count; buf_idx++) {
+        if (o_dma.desc[buf_idx] == dma_desc) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Nothing is stepped out: the passthrough mode, or the unified stream without pulses.
+// Call with the I2S_OUT_PULSER lock acquired.
+static bool IRAM_ATTR i2s_out_resting() {
+    return i2s_out_pulser_status == PASSTHROUGH || (i2s_out_pulser_status == STEPPING && i2s_out_unified && !i2s_out_pulsing);
+}
+
+// Choose how much of the next buffer to fill. A buffer filled only partially is sent sooner,
+// which shortens the time from the stepper to the motors, at the cost of underrun tolerance.
+// The unified stream without pulses only carries the static writes, so it always fills little.
+static void IRAM_ATTR i2s_out_adapt_fill_count() {
+    uint32_t fill_max = o_dma.sample_count;
+    bool     resting  = i2s_out_unified && !i2s_out_pulsing;
+    if (!i2s_out_adaptive_latency && !resting) {
+        o_dma.fill_count = fill_max;
+        return;
+    }
+    uint32_t fill_min = fill_max / 4;
+    if (fill_min < SAMPLE_SAFE_COUNT * 4) {
+        fill_min = SAMPLE_SAFE_COUNT * 4;
+    }
+    if (resting || sys.state == State::Jog || sys.state == State::Idle) {
+        o_dma.fill_count = fill_min;
+    } else if (i2s_out_pulse_period == i2s_out_last_pulse_period) {
+        // Cruising: grow towards the full buffer
+        o_dma.fill_count += fill_max / 8;
+    }
+    if (o_dma.fill_count < fill_min) {
+        o_dma.fill_count = fill_min;
+    } else if (o_dma.fill_count > fill_max) {
+        o_dma.fill_count = fill_max;
+    }
+    i2s_out_last_pulse_period = i2s_out_pulse_period;
+}
 #endif
 
 static int IRAM_ATTR i2s_out_gpio_attach(uint8_t ws, uint8_t bck, uint8_t data) {
@@ -368,12 +458,13 @@ static int IRAM_ATTR i2s_fillout_dma_buffer(lldesc_t* dma_desc) {
         // the generation of the buffer is interrupted (the buffer length is shortened slightly)
         // and the pulse generation is postponed until the next buffer is filled.
         //
-        o_dma.rw_pos = 0;
-        while (o_dma.rw_pos < (DMA_SAMPLE_COUNT - SAMPLE_SAFE_COUNT)) {
+        o_dma.rw_pos        = 0;
+        uint32_t fill_limit = o_dma.fill_count - SAMPLE_SAFE_COUNT;
+        while (o_dma.rw_pos < fill_limit) {
             // no data to read (buffer empty)
             if (i2s_out_remain_time_until_next_pulse < I2S_OUT_USEC_PER_PULSE) {
                 // pulser status may change in pulse phase func, so I need to check it every time.
-                if (i2s_out_pulser_status == STEPPING) {
+                if (i2s_out_pulser_status == STEPPING && i2s_out_pulsing) {
                     // fillout future DMA buffer (tail of the DMA buffer chains)
                     if (i2s_out_pulse_func != NULL) {
                         uint32_t old_rw_pos = o_dma.rw_pos;
@@ -392,18 +483,34 @@ static int IRAM_ATTR i2s_fillout_dma_buffer(lldesc_t* dma_desc) {
                             // I2S has already in static mode, and buffers has cleared to zero.
                             // To prevent the pulse function from being called back,
                             // we assume that the buffer is already full.
-                            i2s_out_remain_time_until_next_pulse = 0;                 // There is no need to fill the current buffer.
-                            o_dma.rw_pos                         = DMA_SAMPLE_COUNT;  // The buffer is full.
+                            i2s_out_remain_time_until_next_pulse = 0;                   // There is no need to fill the current buffer.
+                            o_dma.rw_pos                         = o_dma.sample_count;  // The buffer is full.
                             break;
+                        } else if (!i2s_out_pulsing) {
+                            // i2s_out_set_passthrough() has called from the pulse function in the unified mode.
+                            // The stream goes on with the port data alone.
+                            i2s_out_remain_time_until_next_pulse = 0;
                         }
                         continue;
                     }
                 }
             }
             // no pulse data in push buffer (pulse off or idle or callback is not defined)
-            buf[o_dma.rw_pos++] = atomic_load(&i2s_out_port_data);
+            // Fill the whole gap up to the next pulse, or to the end of the buffer, in one go.
+            // The port data is sampled once per gap instead of once per sample.
+            uint32_t n = i2s_out_remain_time_until_next_pulse / I2S_OUT_USEC_PER_PULSE;
+            if (n == 0 || n > fill_limit - o_dma.rw_pos) {
+                n = fill_limit - o_dma.rw_pos;  // No pulse is coming in this buffer
+            }
+            uint32_t  port_data = atomic_load(&i2s_out_port_data);
+            uint32_t* fill      = &buf[o_dma.rw_pos];
+            uint32_t* fill_end  = fill + n;
+            while (fill < fill_end) {
+                *fill++ = port_data;
+            }
+            o_dma.rw_pos += n;
             if (i2s_out_remain_time_until_next_pulse >= I2S_OUT_USEC_PER_PULSE) {
-                i2s_out_remain_time_until_next_pulse -= I2S_OUT_USEC_PER_PULSE;
+                i2s_out_remain_time_until_next_pulse -= n * I2S_OUT_USEC_PER_PULSE;
             }
         }
         // set filled length to the DMA descriptor
@@ -447,7 +554,8 @@ static void IRAM_ATTR i2s_out_intr_handler(void* arg) {
 
         // If the queue is full it's because we have an underflow,
         // more than buf_count isr without new data, remove the front buffer
-        if (xQueueIsQueueFullFromISR(o_dma.queue)) {
+        // (The queue is sized for the largest geometry, so compare against the buffer count.)
+        if (uxQueueMessagesWaitingFromISR(o_dma.queue) >= o_dma.count) {
             lldesc_t* front_desc;
             // Remove a descriptor from the DMA complete event queue
             xQueueReceiveFromISR(o_dma.queue, &front_desc, &high_priority_task_awoken);
@@ -457,10 +565,10 @@ static void IRAM_ATTR i2s_out_intr_handler(void* arg) {
                 port_data = atomic_load(&i2s_out_port_data);
             }
             I2S_OUT_PULSER_EXIT_CRITICAL_ISR();
-            for (int i = 0; i < DMA_SAMPLE_COUNT; i++) {
+            for (int i = 0; i < o_dma.sample_count; i++) {
                 front_desc->buf[i] = port_data;
             }
-            front_desc->length = I2S_OUT_DMABUF_LEN;
+            front_desc->length = o_dma.len;
         }
 
         // Send a DMA complete event to the I2S bitstreamer task with finished buffer
@@ -484,10 +592,16 @@ static void IRAM_ATTR i2sOutTask(void* parameter) {
         // Wait a DMA complete event from I2S isr
         // (Block until a DMA transfer has complete)
         xQueueReceive(o_dma.queue, &dma_desc, portMAX_DELAY);
-        o_dma.current = (uint32_t*)(dma_desc->buf);
+        TRACE_SCOPE(I2SFill, i2s_out_pulser_status);
+        I2S_OUT_PULSER_ENTER_CRITICAL();  // Lock pulser status
+        if (!i2s_out_is_dma_desc(dma_desc)) {
+            // The DMA buffers were reallocated after this event was queued.
+            I2S_OUT_PULSER_EXIT_CRITICAL();
+            continue;
+        }
         // It reuses the oldest (just transferred) buffer with the name "current"
         // and fills the buffer for later DMA.
-        I2S_OUT_PULSER_ENTER_CRITICAL();  // Lock pulser status
+        o_dma.current = (uint32_t*)(dma_desc->buf);
         if (i2s_out_pulser_status == STEPPING) {
             //
             // Fillout the buffer for pulse
@@ -499,6 +613,7 @@ static void IRAM_ATTR i2sOutTask(void* parameter) {
             // the generation of the buffer is interrupted (the buffer length is shortened slightly)
             // and the pulse generation is postponed until the next buffer is filled.
             //
+            i2s_out_adapt_fill_count();
             i2s_fillout_dma_buffer(dma_desc);
             dma_desc->length = o_dma.rw_pos * I2S_SAMPLE_SIZE;
         } else if (i2s_out_pulser_status == WAITING) {
@@ -506,10 +621,17 @@ static void IRAM_ATTR i2sOutTask(void* parameter) {
                 // Tail of the DMA descriptor found
                 // I2S TX module has alrewdy stopped by ISR
                 i2s_out_stop();
-                i2s_clear_o_dma_buffers(0);  // 0 for static I2S control mode (right ch. data is always 0)
                 // You need to set the status before calling i2s_out_start()
                 // because the process in i2s_out_start() is different depending on the status.
-                i2s_out_pulser_status = PASSTHROUGH;
+                if (i2s_out_unified) {
+                    // The unified mode was turned on while the stream drained. Keep streaming, without pulses.
+                    i2s_clear_o_dma_buffers(atomic_load(&i2s_out_port_data));
+                    i2s_out_pulsing       = false;
+                    i2s_out_pulser_status = STEPPING;
+                } else {
+                    i2s_clear_o_dma_buffers(0);  // 0 for static I2S control mode (right ch. data is always 0)
+                    i2s_out_pulser_status = PASSTHROUGH;
+                }
                 i2s_out_start();
             } else {
                 // Processing a buffer slightly ahead of the tail buffer.
@@ -547,7 +669,7 @@ void IRAM_ATTR i2s_out_delay() {
     } else {
         // Just wait until the data now registered in the DMA descripter
         // is reflected in the I2S TX module via FIFO.
-        delay(I2S_OUT_DELAY_MS);
+        delay(i2s_out_get_delay_ms());
     }
     I2S_OUT_PULSER_EXIT_CRITICAL();
 #else
@@ -555,6 +677,106 @@ void IRAM_ATTR i2s_out_delay() {
 #endif
 }
 
+uint32_t IRAM_ATTR i2s_out_get_delay_ms() {
+#ifdef USE_I2S_OUT_STREAM_IMPL
+    // The whole ring may be queued ahead of the buffer the data goes into next. The filled
+    // lengths are counted, as the buffers are partly filled with adaptive latency.
+    I2S_OUT_PULSER_ENTER_CRITICAL();
+    uint32_t samples = o_dma.fill_count;
+    for (int buf_idx = 0; buf_idx < o_dma.count; buf_idx++) {
+        samples += o_dma.desc[buf_idx]->length / I2S_SAMPLE_SIZE;
+    }
+    I2S_OUT_PULSER_EXIT_CRITICAL();
+    return (samples * I2S_OUT_USEC_PER_PULSE + 999) / 1000;
+#else
+    return 0;
+#endif
+}
+
+int i2s_out_set_dma_geometry(uint32_t count, uint32_t len) {
+#ifdef USE_I2S_OUT_STREAM_IMPL
+    len -= len % I2S_SAMPLE_SIZE;
+    if (count < I2S_OUT_DMABUF_COUNT_MIN || count > I2S_OUT_DMABUF_COUNT_MAX || len < I2S_OUT_DMABUF_LEN_MIN || len > I2S_OUT_DMABUF_LEN_MAX) {
+        return -1;
+    }
+    if (count == o_dma.count && len == o_dma.len) {
+        return 0;
+    }
+    I2S_OUT_PULSER_ENTER_CRITICAL();
+    bool resting = i2s_out_resting();
+    I2S_OUT_PULSER_EXIT_CRITICAL();
+    if (!resting) {
+        return -1;
+    }
+
+    // Allocate outside of the lock; heap functions must not be called in a critical section.
+    uint32_t** buffers;
+    lldesc_t** desc;
+    if (i2s_out_alloc_dma(count, len, &buffers, &desc) != 0) {
+        return -1;
+    }
+
+    I2S_OUT_PULSER_ENTER_CRITICAL();
+    if (!i2s_out_resting()) {
+        I2S_OUT_PULSER_EXIT_CRITICAL();
+        i2s_out_free_dma(count, len, buffers, desc);
+        return -1;
+    }
+    i2s_out_stop();
+    uint32_t** old_buffers = o_dma.buffers;
+    lldesc_t** old_desc    = o_dma.desc;
+    uint32_t   old_count   = o_dma.count;
+    uint32_t   old_len     = o_dma.len;
+
+    o_dma.buffers      = buffers;
+    o_dma.desc         = desc;
+    o_dma.count        = count;
+    o_dma.len          = len;
+    o_dma.sample_count = len / I2S_SAMPLE_SIZE;
+    o_dma.fill_count   = o_dma.sample_count;
+    o_dma.rw_pos       = 0;
+    o_dma.current      = NULL;
+    // 0 for static I2S control mode (right ch. data is always 0)
+    i2s_clear_o_dma_buffers(i2s_out_pulser_status == STEPPING ? atomic_load(&i2s_out_port_data) : 0);
+    xQueueReset(o_dma.queue);  // Drop completion events for the old buffers
+    i2s_out_start();
+    I2S_OUT_PULSER_EXIT_CRITICAL();
+
+    i2s_out_free_dma(old_count, old_len, old_buffers, old_desc);
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+void i2s_out_set_adaptive_latency(bool enable) {
+#ifdef USE_I2S_OUT_STREAM_IMPL
+    i2s_out_adaptive_latency = enable;
+#endif
+}
+
+void i2s_out_set_unified(bool enable) {
+#ifdef USE_I2S_OUT_STREAM_IMPL
+    I2S_OUT_PULSER_ENTER_CRITICAL();
+    if (enable != i2s_out_unified) {
+        i2s_out_unified = enable;
+        if (enable && i2s_out_pulser_status == PASSTHROUGH) {
+            // Start the stream that runs from now on, without pulses until the stepper starts.
+            i2s_out_stop();
+            i2s_clear_o_dma_buffers(atomic_load(&i2s_out_port_data));
+            i2s_out_pulsing       = false;
+            i2s_out_pulser_status = STEPPING;
+            i2s_out_start();
+        } else if (!enable && i2s_out_pulser_status == STEPPING && !i2s_out_pulsing) {
+            i2s_out_pulser_status = WAITING;  // Drain the stream, as i2s_out_set_passthrough() does
+        }
+        // A stream with pulses goes on until the stepper stops. One that is draining is
+        // picked up by i2sOutTask().
+    }
+    I2S_OUT_PULSER_EXIT_CRITICAL();
+#endif
+}
+
 void IRAM_ATTR i2s_out_write(uint8_t pin, uint8_t val) {
     uint32_t bit = bit(pin);
     if (val) {
@@ -612,7 +834,11 @@ int IRAM_ATTR i2s_out_set_passthrough() {
     // The mode is not changed directly by this function.
     // Pull the trigger
     if (i2s_out_pulser_status == STEPPING) {
-        i2s_out_pulser_status = WAITING;  // Start stopping the pulser (trigger)
+        if (i2s_out_unified) {
+            i2s_out_pulsing = false;  // Only the pulses stop. The stream goes on with the port data.
+        } else {
+            i2s_out_pulser_status = WAITING;  // Start stopping the pulser (trigger)
+        }
     }
     // It is a function that may be called via i2sOutTask().
     // (i2sOutTask() -> stepper_pulse_func() -> st_go_idle() -> Stepper_Timer_Stop() -> this function)
@@ -630,7 +856,12 @@ int IRAM_ATTR i2s_out_set_stepping() {
     I2S_OUT_PULSER_ENTER_CRITICAL();
 #ifdef USE_I2S_OUT_STREAM_IMPL
     if (i2s_out_pulser_status == STEPPING) {
-        // Re-entered (fail safe)
+        if (!i2s_out_pulsing) {
+            // Unified mode: the stream is running, so the pulses start with the next buffer filled.
+            i2s_out_remain_time_until_next_pulse = 0;
+            i2s_out_pulsing                      = true;
+        }
+        // Otherwise re-entered (fail safe)
         I2S_OUT_PULSER_EXIT_CRITICAL();
         return 0;
     }
@@ -639,7 +870,7 @@ int IRAM_ATTR i2s_out_set_stepping() {
         // Wait for complete DMAs
         for (;;) {
             I2S_OUT_PULSER_EXIT_CRITICAL();
-            delay(I2S_OUT_DELAY_DMABUF_MS);
+            delay(o_dma.sample_count * I2S_OUT_USEC_PER_PULSE / 1000);
             I2S_OUT_PULSER_ENTER_CRITICAL();
             if (i2s_out_pulser_status == WAITING) {
                 continue;
@@ -649,6 +880,7 @@ int IRAM_ATTR i2s_out_set_stepping() {
                 break;
             }
             // Another function change the I2S state to STEPPING
+            i2s_out_pulsing = true;
             I2S_OUT_PULSER_EXIT_CRITICAL();
             return 0;
         }
@@ -662,6 +894,7 @@ int IRAM_ATTR i2s_out_set_stepping() {
 
     // You need to set the status before calling i2s_out_start()
     // because the process in i2s_out_start() is different depending on the status.
+    i2s_out_pulsing       = true;
     i2s_out_pulser_status = STEPPING;
     i2s_out_start();
 #else
@@ -748,39 +981,26 @@ int IRAM_ATTR i2s_out_init(i2s_out_init_t& init_param) {
    */
 
 #ifdef USE_I2S_OUT_STREAM_IMPL
-    // Allocate the array of pointers to the buffers
-    o_dma.buffers = (uint32_t**)malloc(sizeof(uint32_t*) * I2S_OUT_DMABUF_COUNT);
-    if (o_dma.buffers == nullptr) {
+    // Allocate the DMA buffers and their descriptors
+    uint32_t dmabuf_len = init_param.dmabuf_len - init_param.dmabuf_len % I2S_SAMPLE_SIZE;
+    if (init_param.dmabuf_count < I2S_OUT_DMABUF_COUNT_MIN || init_param.dmabuf_count > I2S_OUT_DMABUF_COUNT_MAX ||
+        dmabuf_len < I2S_OUT_DMABUF_LEN_MIN || dmabuf_len > I2S_OUT_DMABUF_LEN_MAX) {
         return -1;
     }
-
-    // Allocate each buffer that can be used by the DMA controller
-    for (int buf_idx = 0; buf_idx < I2S_OUT_DMABUF_COUNT; buf_idx++) {
-        o_dma.buffers[buf_idx] = (uint32_t*)heap_caps_calloc(1, I2S_OUT_DMABUF_LEN, MALLOC_CAP_DMA);
-        if (o_dma.buffers[buf_idx] == nullptr) {
-            return -1;
-        }
-    }
-
-    // Allocate the array of DMA descriptors
-    o_dma.desc = (lldesc_t**)malloc(sizeof(lldesc_t*) * I2S_OUT_DMABUF_COUNT);
-    if (o_dma.desc == nullptr) {
+    if (i2s_out_alloc_dma(init_param.dmabuf_count, dmabuf_len, &o_dma.buffers, &o_dma.desc) != 0) {
         return -1;
     }
-
-    // Allocate each DMA descriptor that will be used by the DMA controller
-    for (int buf_idx = 0; buf_idx < I2S_OUT_DMABUF_COUNT; buf_idx++) {
-        o_dma.desc[buf_idx] = (lldesc_t*)heap_caps_malloc(sizeof(lldesc_t), MALLOC_CAP_DMA);
-        if (o_dma.desc[buf_idx] == nullptr) {
-            return -1;
-        }
-    }
+    o_dma.count        = init_param.dmabuf_count;
+    o_dma.len          = dmabuf_len;
+    o_dma.sample_count = dmabuf_len / I2S_SAMPLE_SIZE;
+    o_dma.fill_count   = o_dma.sample_count;
 
     // Initialize
     i2s_clear_o_dma_buffers(init_param.init_val);
     o_dma.rw_pos  = 0;
     o_dma.current = NULL;
-    o_dma.queue   = xQueueCreate(I2S_OUT_DMABUF_COUNT, sizeof(uint32_t*));
+    // Sized for the largest geometry so that it never needs to be recreated
+    o_dma.queue = xQueueCreate(I2S_OUT_DMABUF_COUNT_MAX, sizeof(uint32_t*));
 
     // Set the first DMA descriptor
     I2S0.out_link.addr = (uint32_t)o_dma.desc[0];
@@ -919,13 +1139,13 @@ int IRAM_ATTR i2s_out_init(i2s_out_init_t& init_param) {
     i2s_out_pulse_func   = init_param.pulse_func;
 
     // Create the task that will feed the buffer
-    xTaskCreatePinnedToCore(i2sOutTask,
-                            "I2SOutTask",
-                            4096,
-                            NULL,
-                            1,
-                            nullptr,
-                            CONFIG_ARDUINO_RUNNING_CORE  // must run the task on same core
+    heap_task_create(i2sOutTask,
+                     "I2SOutTask",
+                     4096,
+                     NULL,
+                     1,
+                     nullptr,
+                     CONFIG_ARDUINO_RUNNING_CORE  // must run the task on same core
     );
 
     // Allocate and Enable the I2S interrupt
@@ -970,6 +1190,8 @@ int IRAM_ATTR i2s_out_init() {
         .pulse_func   = NULL,
         .pulse_period = I2S_OUT_USEC_PER_PULSE,
         .init_val     = I2S_OUT_INIT_VAL,
+        .dmabuf_count = I2S_OUT_DMABUF_COUNT,
+        .dmabuf_len   = I2S_OUT_DMABUF_LEN,
     };
     return i2s_out_init(default_param);
 }
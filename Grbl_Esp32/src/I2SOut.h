@@ -58,11 +58,14 @@
 /* 32-bit mode: 1000000 usec / ((160000000 Hz) /  5 / 2) x 32 bit/pulse x 2(stereo) = 4 usec/pulse */
 const int I2S_OUT_USEC_PER_PULSE = 4;
 
+// Default DMA buffer geometry. It can be changed at run time by i2s_out_set_dma_geometry().
 const int I2S_OUT_DMABUF_COUNT = 5;    /* number of DMA buffers to store data */
 const int I2S_OUT_DMABUF_LEN   = 2000; /* maximum size in bytes (4092 is DMA's limit) */
 
-const int I2S_OUT_DELAY_DMABUF_MS = (I2S_OUT_DMABUF_LEN / sizeof(uint32_t) * I2S_OUT_USEC_PER_PULSE / 1000);
-const int I2S_OUT_DELAY_MS        = (I2S_OUT_DELAY_DMABUF_MS * (I2S_OUT_DMABUF_COUNT + 1));
+const int I2S_OUT_DMABUF_COUNT_MIN = 2;
+const int I2S_OUT_DMABUF_COUNT_MAX = 16;
+const int I2S_OUT_DMABUF_LEN_MIN   = 400;
+const int I2S_OUT_DMABUF_LEN_MAX   = 4092;
 
 typedef void (*i2s_out_pulse_func_t)(void);
 
@@ -86,6 +89,8 @@ typedef struct {
     i2s_out_pulse_func_t pulse_func;
     uint32_t             pulse_period;  // aka step rate.
     uint32_t             init_val;
+    uint32_t             dmabuf_count;  // number of DMA buffers
+    uint32_t             dmabuf_len;    // size of each DMA buffer in bytes
 } i2s_out_init_t;
 
 /*
@@ -103,6 +108,8 @@ int i2s_out_init(i2s_out_init_t& init_param);
         .pulse_func = NULL,
         .pulse_period = I2S_OUT_USEC_PER_PULSE,
         .init_val = I2S_OUT_INIT_VAL,
+        .dmabuf_count = I2S_OUT_DMABUF_COUNT,
+        .dmabuf_len = I2S_OUT_DMABUF_LEN,
     };
   return -1 ... already initialized
 */
@@ -155,6 +162,38 @@ int i2s_out_set_stepping();
  */
 void i2s_out_delay();
 
+/*
+  Time in milliseconds for the data now registered in the DMA buffer chain
+  to reach the shift registers, for the current DMA buffer geometry.
+ */
+uint32_t i2s_out_get_delay_ms();
+
+/*
+   Reallocate the DMA buffers with count buffers of len bytes each.
+   len is rounded down to a multiple of the sample size.
+   Only possible in the passthrough mode, or in the unified mode while the stepper is stopped.
+   return -1 ... streaming, invalid geometry or out of memory
+ */
+int i2s_out_set_dma_geometry(uint32_t count, uint32_t len);
+
+/*
+   Enable adaptive latency. When enabled, only part of each DMA buffer
+   is filled while idle or jogging, so pulses reach the motors sooner,
+   and the filled part grows back to the whole buffer while the pulse
+   period stays constant (cruising), for the best underrun tolerance.
+ */
+void i2s_out_set_adaptive_latency(bool enable);
+
+/*
+   Enable the unified mode. The DMA stream then runs all the time and
+   i2s_out_write() reaches the shift registers through it, so switching
+   to and from stepping only starts and stops the pulse callback, with
+   no wait for the stream to drain. Static writes take the stream latency,
+   kept to a few buffers of a quarter length while there are no pulses.
+   The mode stays STEPPING; i2s_out_set_passthrough() only stops the pulses.
+ */
+void i2s_out_set_unified(bool enable);
+
 /*
    Set the pulse callback period in microseconds
  */
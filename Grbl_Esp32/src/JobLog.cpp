@@ -0,0 +1,157 @@
+/*
+  JobLog.cpp - Performance log of a job, written to the SD card while it runs
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The records go through the SD write-behind buffers, the ones uploads use, so the main loop
+  only copies them and the card is written from core 0. Nothing is uploaded during a job, as
+  the card is busy. At 20 bytes a record, a log at 100 ms takes 700 kB an hour.
+*/
+
+#include "Config.h"
+#ifdef ENABLE_SD_CARD
+#    include "Grbl.h"
+
+static File              log_file;
+static volatile bool     log_open = false;
+static bool              log_owns_card;  // Mounted for the log, not for an SD job
+static uint8_t           log_client;
+static uint32_t          log_period_ms;
+static int64_t           log_start_us;
+static int64_t           log_next_us;
+static SemaphoreHandle_t log_lock = NULL;
+
+static uint16_t log_clamp(float value) {
+    return value <= 0 ? 0 : value >= UINT16_MAX ? UINT16_MAX : uint16_t(value);
+}
+
+bool job_log_start(const char* path, uint8_t client) {
+    if (log_open || sd_job_log_period->get() == 0) {
+        return false;
+    }
+    if (log_lock == NULL) {
+        log_lock = xSemaphoreCreateMutex();
+    }
+    // An SD job has the card mounted and busy already.
+    log_owns_card = get_sd_state(false) != SDState::BusyPrinting;
+    if (log_owns_card) {
+        if (get_sd_state(true) != SDState::Idle) {
+            return false;
+        }
+        set_sd_state(SDState::BusyUploading);
+    }
+    log_file = sd_fs().open(path, FILE_WRITE);
+    if (!log_file || !sd_write_begin(log_file)) {
+        if (log_file) {
+            log_file.close();
+        }
+        if (log_owns_card) {
+            set_sd_state(SDState::Idle);
+            sd_unmount();
+        }
+        return false;
+    }
+    log_period_ms       = sd_job_log_period->get();
+    log_client          = client;
+    JobLogHeader header = { { 'G', 'T', 'L', 'M' }, 1, sizeof(JobLogRecord), uint16_t(log_period_ms) };
+    sd_write((const uint8_t*)&header, sizeof(header));
+    st_isr_stats.recent_max_cycles = 0;
+    log_start_us                   = esp_timer_get_time();
+    log_next_us                    = log_start_us;
+    log_open                       = true;
+    return true;
+}
+
+void job_log_start_job(const char* job_path, uint8_t client) {
+    if (sd_job_log_period->get() == 0) {
+        return;
+    }
+    String path = String(job_path) + JOB_LOG_EXTENSION;
+    if (!job_log_start(path.c_str(), client)) {
+        grbl_msg_sendf(client, MsgLevel::Info, "Cannot write job log %s", path.c_str());
+    }
+}
+
+// Called with log_lock held.
+static void log_close() {
+    log_open = false;
+    sd_write_end();
+    log_file.close();
+    sd_dir_index_invalidate();
+    if (log_owns_card) {
+        set_sd_state(SDState::Idle);
+        sd_unmount();
+    }
+}
+
+void job_log_stop() {
+    if (!log_open) {
+        return;
+    }
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    if (log_open) {
+        log_close();
+    }
+    xSemaphoreGive(log_lock);
+}
+
+bool job_log_active() {
+    return log_open;
+}
+
+void job_log_poll() {
+    if (!log_open) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    if (now < log_next_us) {
+        return;
+    }
+    log_next_us += int64_t(log_period_ms) * 1000;
+    if (log_next_us < now) {
+        log_next_us = now;  // Held up; record the gap rather than a burst
+    }
+
+    JobLogRecord  record = {};
+    plan_block_t* block  = plan_get_current_block();
+    record.time_ms       = (now - log_start_us) / 1000;
+    if (get_sd_state(false) == SDState::BusyPrinting) {
+        record.line = sd_get_current_line_number();
+    }
+#    ifdef USE_LINE_NUMBERS
+    else if (block) {
+        record.line = block->line_number;
+    }
+#    endif
+    record.feed                    = log_clamp(st_get_realtime_rate());
+    record.programmed              = block ? log_clamp(block->programmed_rate) : 0;
+    record.isr_max_us              = log_clamp(st_isr_stats.recent_max_cycles / getCpuFrequencyMhz());
+    st_isr_stats.recent_max_cycles = 0;
+    record.rx_used                 = log_clamp(client_get_rx_buffer_size(log_client) - client_get_rx_buffer_available(log_client));
+    record.planner                 = plan_get_block_buffer_count();
+    record.segments                = st_get_segment_buffer_count();
+    record.state                   = uint8_t(sys.state);
+#    ifdef ENABLE_WIFI
+    if (WiFi.status() == WL_CONNECTED) {
+        record.rssi = WiFi.RSSI();
+    }
+#    endif
+
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    if (log_open && !sd_write((const uint8_t*)&record, sizeof(record))) {
+        grbl_msg_sendf(log_client, MsgLevel::Info, "Job log write failed");
+        log_close();
+    }
+    xSemaphoreGive(log_lock);
+}
+#endif
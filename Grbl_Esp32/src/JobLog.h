@@ -0,0 +1,60 @@
+#pragma once
+
+/*
+  JobLog.h - Performance log of a job, written to the SD card while it runs
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdint>
+
+// The log of an SD job is the job's path with this added. doc/script/job_log.py turns a log
+// into CSV for a spreadsheet or plot.
+const char* const JOB_LOG_EXTENSION = ".tlm";
+
+// The file starts with this header, then one record each $SD/JobLog milliseconds, little endian.
+struct __attribute__((packed)) JobLogHeader {
+    char     magic[4];     // "GTLM"
+    uint8_t  version;      // 1
+    uint8_t  record_size;  // sizeof(JobLogRecord), so older readers can skip new fields
+    uint16_t period_ms;
+};
+
+struct __attribute__((packed)) JobLogRecord {
+    uint32_t time_ms;     // Since the log started
+    uint32_t line;        // Line being read from the file, or executed when streamed with line numbers
+    uint16_t feed;        // mm/min the steppers are running at
+    uint16_t programmed;  // mm/min programmed for the executing block, 0 when there is none
+    uint16_t isr_max_us;  // Longest stepper interrupt since the last record
+    uint16_t rx_used;     // Bytes waiting in the job client's receive buffer
+    uint8_t  planner;     // Blocks in the planner
+    uint8_t  segments;    // Step segments prepped
+    uint8_t  state;       // sys.state
+    int8_t   rssi;        // WiFi signal in dBm, 0 when not connected as a station
+};
+
+// Starts logging to path, for the job streamed or run from the card by client. A log of its
+// own mounts the card and keeps it busy until job_log_stop(). Returns false if the log could
+// not be opened or $SD/JobLog is 0.
+bool job_log_start(const char* path, uint8_t client);
+
+// Starts the log of an SD job beside the job file, if $SD/JobLog is on. Called with the card busy.
+void job_log_start_job(const char* job_path, uint8_t client);
+
+// Finishes the log, if one is open. Can be called from another task by a reset.
+void job_log_stop();
+
+bool job_log_active();
+
+// Writes a record when one is due. Called from the realtime loop.
+void job_log_poll();
@@ -23,6 +23,17 @@
 
 #include "Grbl.h"
 
+// Starts the steppers if the jog queued the first block.
+static void jog_start_motion() {
+    if (sys.state == State::Idle) {
+        if (plan_get_current_block() != NULL) {  // Check if there is a block to execute.
+            sys.state = State::Jog;
+            st_prep_buffer();
+            st_wake_up();  // NOTE: Manual start. No state machine required.
+        }
+    }
+}
+
 // Sets up valid jog motion received from g-code parser, checks for soft-limits, and executes the jog.
 // cancelledInflight will be set to true if was not added to parser due to a cancelJog.
 Error jog_execute(plan_line_data_t* pl_data, parser_block_t* gc_block, bool* cancelledInflight) {
@@ -43,13 +54,115 @@ Error jog_execute(plan_line_data_t* pl_data, parser_block_t* gc_block, bool* can
     if (!cartesian_to_motors(gc_block->values.xyz, pl_data, gc_state.position)) {
         return Error::JogCancelled;
     }
+    jog_start_motion();
+    return Error::Ok;
+}
 
-    if (sys.state == State::Idle) {
-        if (plan_get_current_block() != NULL) {  // Check if there is a block to execute.
-            sys.state = State::Jog;
-            st_prep_buffer();
-            st_wake_up();  // NOTE: Manual start. No state machine required.
+// Velocity mode jogging. Rather than one block per $J= line, the direction and rate are given
+// once and jog_velocity_update() keeps extending the target with short blocks. Only enough
+// blocks to stop in are queued ahead of the tool, so a jog cancel decelerates within a known
+// distance, and a pendant that stops repeating the command stops the machine by itself.
+typedef struct {
+    bool             active;
+    float            unit_vec[MAX_N_AXIS];
+    float            block_mm;  // Length of each queued block
+    plan_line_data_t pl_data;
+    int64_t          deadline;  // esp_timer_get_time() after which no more blocks are queued
+} jog_velocity_t;
+static jog_velocity_t jog_velocity;
+
+Error jog_velocity_start(const char* value) {
+    if (sys.state != State::Idle && sys.state != State::Jog) {
+        return Error::IdleError;
+    }
+    if (sys.state == State::Jog && !jog_velocity.active) {
+        return Error::InvalidJogCommand;  // A $J= jog is still running.
+    }
+    float   direction[MAX_N_AXIS] = {};
+    float   feed_rate             = 0.0;
+    uint8_t char_counter          = 0;
+    auto    n_axis                = number_axis->get();
+    while (value[char_counter]) {
+        char letter = toupper(value[char_counter++]);
+        float number;
+        if (!read_float(value, &char_counter, &number)) {
+            return Error::BadNumberFormat;
+        }
+        const char* axis = strchr("XYZABC", letter);
+        if (letter == 'F') {
+            feed_rate = number;
+        } else if (letter && axis && axis - "XYZABC" < n_axis) {
+            direction[axis - "XYZABC"] = number;
+        } else {
+            return Error::InvalidJogCommand;
         }
     }
+    float length = 0.0;
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        length += direction[idx] * direction[idx];
+    }
+    if (feed_rate <= 0.0 || length == 0.0) {
+        return Error::InvalidJogCommand;
+    }
+    length = sqrtf(length);
+
+    // The rate and acceleration along the direction, limited by each axis as the planner does.
+    float rate         = feed_rate / 60.0;  // mm/sec
+    float acceleration = SOME_LARGE_VALUE;  // mm/sec^2
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        float unit = direction[idx] / length;
+        if (unit != 0.0) {
+            rate         = MIN(rate, axis_settings[idx]->max_rate->get() / 60.0f / fabsf(unit));
+            acceleration = MIN(acceleration, axis_settings[idx]->acceleration->get() / fabsf(unit));
+        }
+        jog_velocity.unit_vec[idx] = unit;
+    }
+    float stop_mm         = rate * rate / (2.0f * acceleration);
+    jog_velocity.block_mm = MAX(rate * JOG_VELOCITY_BLOCK_TIME, stop_mm / (JOG_VELOCITY_BLOCKS - 1));
+
+    memset(&jog_velocity.pl_data, 0, sizeof(jog_velocity.pl_data));
+    jog_velocity.pl_data.feed_rate             = feed_rate;
+    jog_velocity.pl_data.motion.noFeedOverride = 1;
+    jog_velocity.pl_data.is_jog                = true;
+    jog_velocity.pl_data.spindle_speed         = gc_state.spindle_speed;
+    jog_velocity.pl_data.spindle               = gc_state.modal.spindle;
+    jog_velocity.pl_data.coolant               = gc_state.modal.coolant;
+    jog_velocity.deadline                      = esp_timer_get_time() + JOG_VELOCITY_TIMEOUT_MS * 1000LL;
+    jog_velocity.active                        = true;
+    jog_velocity_update();
     return Error::Ok;
 }
+
+void jog_velocity_update() {
+    if (!jog_velocity.active) {
+        return;
+    }
+    if (sys.suspend.bit.jogCancel || (sys.state != State::Idle && sys.state != State::Jog) ||
+        esp_timer_get_time() > jog_velocity.deadline) {
+        jog_velocity.active = false;  // The queued blocks run out and the jog stops.
+        return;
+    }
+    auto n_axis = number_axis->get();
+    while (plan_get_block_buffer_count() < JOG_VELOCITY_BLOCKS) {
+        float target[MAX_N_AXIS];
+        memcpy(target, gc_state.position, sizeof(target));
+        for (uint8_t idx = 0; idx < n_axis; idx++) {
+            target[idx] += jog_velocity.unit_vec[idx] * jog_velocity.block_mm;
+        }
+        if (soft_limits->get() && limitsCheckTravel(target)) {
+            jog_velocity.active = false;  // Stop at the last target inside the limits.
+            return;
+        }
+        plan_line_data_t pl_data = jog_velocity.pl_data;  // Kinematics may alter the feed rate
+        if (!cartesian_to_motors(target, &pl_data, gc_state.position)) {
+            jog_velocity.active = false;
+            return;
+        }
+        memcpy(gc_state.position, target, sizeof(target));
+        jog_start_motion();
+    }
+}
+
+void jog_velocity_stop() {
+    jog_velocity.active = false;
+}
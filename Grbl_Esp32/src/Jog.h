@@ -30,3 +30,14 @@ const int JOG_LINE_NUMBER = 0;
 // Sets up valid jog motion received from g-code parser, checks for soft-limits, and executes the jog.
 // cancelledInflight will be set to true if was not added to parser due to a cancelJog.
 Error jog_execute(plan_line_data_t* pl_data, parser_block_t* gc_block, bool* cancelledInflight);
+
+// Velocity mode jogging, $JV=<axis directions>F<rate>, e.g. $JV=X1Y-1F2000. Jogs along the
+// direction at the rate in mm/min until a jog cancel, or until the command has not been repeated
+// for JOG_VELOCITY_TIMEOUT_MS. Repeating it with another direction or rate changes course.
+const int   JOG_VELOCITY_BLOCKS     = 4;     // Blocks kept queued ahead of the tool, enough to stop in
+const float JOG_VELOCITY_BLOCK_TIME = 0.05;  // Shortest block, in seconds at the jog rate
+const int   JOG_VELOCITY_TIMEOUT_MS = 500;   // Keep-alive interval the pendant must repeat the command within
+
+Error jog_velocity_start(const char* value);
+void  jog_velocity_update();  // Called from the main loop to keep the jog horizon filled
+void  jog_velocity_stop();
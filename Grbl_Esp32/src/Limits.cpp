@@ -27,10 +27,67 @@
 
 #include "Grbl.h"
 
+#include <cfloat>
+#include <soc/gpio_struct.h>
+
 uint8_t n_homing_locate_cycle = NHomingLocateCycle;
 
 xQueueHandle limit_sw_queue;  // used by limit switch debouncing
 
+#if defined(ENABLE_SOFTWARE_DEBOUNCE) && defined(ENABLE_TIMER_DEBOUNCE)
+#    error "ENABLE_SOFTWARE_DEBOUNCE and ENABLE_TIMER_DEBOUNCE cannot be used together"
+#endif
+
+#ifdef ENABLE_TIMER_DEBOUNCE
+const timer_group_t DEBOUNCE_TIMER_GROUP = TIMER_GROUP_1;
+const timer_idx_t   DEBOUNCE_TIMER_INDEX = TIMER_0;
+const uint32_t      fDebounceTimer       = 1000000;  // Counts microseconds
+
+static bool     limit_edge_pending;  // An edge has been seen since the last check of the pins
+static uint64_t limit_first_edge;    // esp_timer time of the first of those edges
+
+// Restarts the quiet period, unless the first edge since the last check is already one
+// period old, which bounds the wait for a switch that keeps bouncing.
+static void IRAM_ATTR limits_debounce_restart() {
+    uint64_t now = esp_timer_get_time();
+    if (!limit_edge_pending) {
+        limit_edge_pending = true;
+        limit_first_edge   = now;
+    } else if (now - limit_first_edge >= DEBOUNCE_PERIOD * 1000ULL) {
+        return;
+    }
+    timer_pause(DEBOUNCE_TIMER_GROUP, DEBOUNCE_TIMER_INDEX);
+    timer_set_counter_value(DEBOUNCE_TIMER_GROUP, DEBOUNCE_TIMER_INDEX, 0x00000000ULL);
+    timer_set_alarm(DEBOUNCE_TIMER_GROUP, DEBOUNCE_TIMER_INDEX, TIMER_ALARM_EN);
+    timer_start(DEBOUNCE_TIMER_GROUP, DEBOUNCE_TIMER_INDEX);
+}
+
+// The switches have settled. Same check as the debounce task, from the timer interrupt.
+static void IRAM_ATTR isr_limit_debounce(void* arg) {
+    TIMERG1.int_clr_timers.t0 = 1;
+    timer_pause(DEBOUNCE_TIMER_GROUP, DEBOUNCE_TIMER_INDEX);
+    limit_edge_pending = false;
+    if (sys.state != State::Alarm && sys.state != State::Homing && sys_rt_exec_alarm == ExecAlarm::None && limits_get_state()) {
+        mc_reset();                                // Initiate system kill.
+        sys_rt_exec_alarm = ExecAlarm::HardLimit;  // Indicate hard limit critical event
+    }
+}
+
+static void limits_debounce_timer_init() {
+    timer_config_t config;
+    config.divider     = fTimers / fDebounceTimer;
+    config.counter_dir = TIMER_COUNT_UP;
+    config.counter_en  = TIMER_PAUSE;
+    config.alarm_en    = TIMER_ALARM_EN;
+    config.intr_type   = TIMER_INTR_LEVEL;
+    config.auto_reload = false;
+    timer_init(DEBOUNCE_TIMER_GROUP, DEBOUNCE_TIMER_INDEX, &config);
+    timer_set_alarm_value(DEBOUNCE_TIMER_GROUP, DEBOUNCE_TIMER_INDEX, DEBOUNCE_PERIOD * (fDebounceTimer / 1000));
+    timer_enable_intr(DEBOUNCE_TIMER_GROUP, DEBOUNCE_TIMER_INDEX);
+    timer_isr_register(DEBOUNCE_TIMER_GROUP, DEBOUNCE_TIMER_INDEX, isr_limit_debounce, NULL, 0, NULL);
+}
+#endif
+
 // Homing axis search distance multiplier. Computed by this value times the cycle travel.
 #ifndef HOMING_AXIS_SEARCH_SCALAR
 #    define HOMING_AXIS_SEARCH_SCALAR 1.1  // Must be > 1 to ensure limit switch will be engaged.
@@ -38,6 +95,23 @@ xQueueHandle limit_sw_queue;  // used by limit switch debouncing
 #ifndef HOMING_AXIS_LOCATE_SCALAR
 #    define HOMING_AXIS_LOCATE_SCALAR 5.0  // Must be > 1 to ensure limit switch is cleared.
 #endif
+// Fast re-reference stops the rapid this many pull-off distances short of the switch, which is
+// how far the saved position may be wrong towards the switch.
+#ifndef HOMING_FAST_REF_SCALAR
+#    define HOMING_FAST_REF_SCALAR 2.0
+#endif
+
+// Axes homed since power up. An alarm may have lost steps, so it clears them.
+static AxisMask homed_axes;
+// Axes whose position was saved at a controlled shutdown and restored at power up, until homed.
+static AxisMask ref_axes;
+
+// The motor positions saved by limits_save_position(), in mm so a changed steps/mm keeps them.
+typedef struct {
+    AxisMask axes;
+    float    motors[MAX_N_AXIS];
+} home_ref_t;
+static const char* HOME_REF_KEY = "HomeRef";
 
 void IRAM_ATTR isr_limit_switches() {
     // Ignore limit switches if already in an alarm state or in-process of executing an alarm.
@@ -47,7 +121,10 @@ void IRAM_ATTR isr_limit_switches() {
     // limit setting if their limits are constantly triggering after a reset and move their axes.
     if (sys.state != State::Alarm && sys.state != State::Homing) {
         if (sys_rt_exec_alarm == ExecAlarm::None) {
-#ifdef ENABLE_SOFTWARE_DEBOUNCE
+#ifdef ENABLE_TIMER_DEBOUNCE
+            // the debounce timer will recheck the switches once they are quiet
+            limits_debounce_restart();
+#elif defined(ENABLE_SOFTWARE_DEBOUNCE)
             // we will start a task that will recheck the switches after a small delay
             int evt;
             xQueueSendFromISR(limit_sw_queue, &evt, NULL);
@@ -69,6 +146,75 @@ void IRAM_ATTR isr_limit_switches() {
     }
 }
 
+// Writes the letters of the axes in mask to buf, which must hold MAX_N_AXIS + 1 characters.
+static const char* homing_axis_letters(AxisMask mask, char* buf) {
+    char* s = buf;
+    for (uint8_t idx = 0; idx < MAX_N_AXIS; idx++) {
+        if (bit_istrue(mask, bit(idx))) {
+            *s++ = "XYZABC"[idx];
+        }
+    }
+    *s = '\0';
+    return buf;
+}
+
+// Rapids the cycle axes to HOMING_FAST_REF_SCALAR pull-off distances short of their switches,
+// from the position restored at power up. A switch that triggers on the way means the position
+// was wrong, which fails the homing, and the next one seeks the whole travel.
+static bool limits_rapid_near_home(uint8_t cycle_mask, plan_line_data_t* pl_data, uint8_t* step_pin) {
+    auto   n_axis    = number_axis->get();
+    auto   mask      = homing_dir_mask->get();
+    float  clearance = homing_pulloff->get() * HOMING_FAST_REF_SCALAR;
+    float* target    = system_get_mpos();
+    char   letters[MAX_N_AXIS + 1];
+
+    AxisMask axislock = 0;
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        if (bit_istrue(cycle_mask, bit(idx))) {
+            float mpos  = axis_settings[idx]->home_mpos->get();
+            target[idx] = bit_istrue(mask, bit(idx)) ? mpos + clearance : mpos - clearance;
+            axislock |= step_pin[idx];
+        }
+    }
+    sys.homing_axis_lock        = axislock;
+    pl_data->motion.rapidMotion = 1;
+    plan_buffer_line(target, pl_data);  // At the rapid rate, which the rapid override scales
+    pl_data->motion.rapidMotion       = 0;
+    sys.step_control                  = {};
+    sys.step_control.executeSysMotion = true;
+    st_prep_buffer();
+    st_wake_up();
+    AxisMask hit;
+    do {
+        hit = limits_get_state() & cycle_mask;
+        st_prep_buffer();
+        if (sys_rt_exec_state.bit.reset) {
+            sys_rt_exec_alarm = ExecAlarm::HomingFailReset;
+        } else if (sys_rt_exec_state.bit.safetyDoor) {
+            sys_rt_exec_alarm = ExecAlarm::HomingFailDoor;
+        } else if (hit) {
+            sys_rt_exec_alarm = ExecAlarm::HomingFailApproach;
+            grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "Homing %s switch before its saved position", homing_axis_letters(hit, letters));
+        }
+        if (sys_rt_exec_alarm != ExecAlarm::None) {
+            motors_set_homing_mode(cycle_mask, false);  // tell motors homing is done...failed
+            grbl_msg_sendf(CLIENT_ALL, MsgLevel::Debug, "Homing fail");
+            mc_reset();
+            protocol_execute_realtime();
+            return false;
+        }
+    } while (!cycle_stop);
+    cycle_stop = false;
+#ifdef USE_I2S_STEPS
+    if (current_stepper == ST_I2S_STREAM) {
+        delay_ms(i2s_out_get_delay_ms());
+    }
+#endif
+    st_reset();
+    delay_ms(homing_debounce->get());
+    return true;
+}
+
 // Homes the specified cycle axes, sets the machine position, and performs a pull-off motion after
 // completing. Homing is a special motion case, which involves rapid uncontrolled stops to locate
 // the trigger point of the limit switches. The rapid stops are handled by a system level axis lock
@@ -80,6 +226,17 @@ void limits_go_home(uint8_t cycle_mask) {
     if (sys.abort) {
         return;  // Block if system reset has been issued.
     }
+#ifdef LINEAR_KINEMATICS
+    // The first switch reached stops the motors of its axis, which would stop the other axis too.
+    if (linear_kinematics_coupled(cycle_mask)) {
+        for (uint8_t idx = 0; idx < MAX_N_AXIS && !sys.abort; idx++) {
+            if (bitnum_istrue(cycle_mask, idx)) {
+                limits_go_home(bit(idx));
+            }
+        }
+        return;
+    }
+#endif
     // Initialize plan data struct for homing motion. Spindle and coolant are disabled.
 
     // Put motors on axes listed in cycle_mask in homing mode and
@@ -109,7 +266,11 @@ void limits_go_home(uint8_t cycle_mask) {
     auto n_axis = number_axis->get();
     for (uint8_t idx = 0; idx < n_axis; idx++) {
         // Initialize step pin masks
+#ifdef LINEAR_KINEMATICS
+        step_pin[idx] = linear_kinematics_motors_of(idx);
+#else
         step_pin[idx] = bit(idx);
+#endif
         if (bit_istrue(cycle_mask, bit(idx))) {
             // Set target based on max_travel setting. Ensure homing switches engaged with search scalar.
             max_travel = MAX(max_travel, (HOMING_AXIS_SEARCH_SCALAR)*axis_settings[idx]->max_travel->get());
@@ -117,9 +278,28 @@ void limits_go_home(uint8_t cycle_mask) {
     }
     // Set search mode with approach at seek rate to quickly engage the specified cycle_mask limit switches.
     bool     approach    = true;
+    bool     seeking     = true;  // First approach, as opposed to the locate touches
     float    homing_rate = homing_seek_rate->get();
+
+    // With a trusted position, rapid near the switches and go straight to the locate touches.
+    // Squared axes home each side on its own, from wherever the first pass left it.
+    bool fast_ref = homing_fast_ref->get() && (ref_axes & cycle_mask) == cycle_mask && ganged_mode == SquaringMode::Dual &&
+                    n_homing_locate_cycle > 0;
+    ref_axes &= ~cycle_mask;  // Used once, whatever the outcome
+    if (fast_ref) {
+        if (!limits_rapid_near_home(cycle_mask, pl_data, step_pin)) {
+            return;
+        }
+        n_cycle -= 2;  // No seek and its pull-off
+        seeking = false;
+        max_travel  = homing_pulloff->get() * (HOMING_FAST_REF_SCALAR + HOMING_AXIS_LOCATE_SCALAR);
+        homing_rate = homing_feed_rate->get();
+    }
+
     uint8_t  n_active_axis;
     AxisMask limit_state, axislock;
+    AxisMask found;  // Axes whose switches triggered during this approach
+    char     letters[MAX_N_AXIS + 1];
     do {
         float* target = system_get_mpos();
         // Initialize and declare variables needed for homing routine.
@@ -129,21 +309,26 @@ void limits_go_home(uint8_t cycle_mask) {
             // Set target location for active axes and setup computation for homing rate.
             if (bit_istrue(cycle_mask, bit(idx))) {
                 n_active_axis++;
+#ifdef LINEAR_KINEMATICS
+                float start = target[idx];  // Its motors move other axes too, so their steps are kept
+#else
+                float start       = 0.0;
                 sys_position[idx] = 0;
+#endif
                 // Set target direction based on cycle mask and homing cycle approach state.
                 // NOTE: This happens to compile smaller than any other implementation tried.
                 auto mask = homing_dir_mask->get();
                 if (bit_istrue(mask, bit(idx))) {
                     if (approach) {
-                        target[idx] = -max_travel;
+                        target[idx] = start - max_travel;
                     } else {
-                        target[idx] = max_travel;
+                        target[idx] = start + max_travel;
                     }
                 } else {
                     if (approach) {
-                        target[idx] = max_travel;
+                        target[idx] = start + max_travel;
                     } else {
-                        target[idx] = -max_travel;
+                        target[idx] = start - max_travel;
                     }
                 }
                 // Apply axislock to the step port pins active in this cycle.
@@ -152,6 +337,7 @@ void limits_go_home(uint8_t cycle_mask) {
         }
         homing_rate *= sqrt(n_active_axis);  // [sqrt(number of active axis)] Adjust so individual axes all move at homing rate.
         sys.homing_axis_lock = axislock;
+        found                = 0;
         // Perform homing cycle. Planner buffer should be empty, as required to initiate the homing cycle.
         pl_data->feed_rate = homing_rate;   // Set current homing rate.
         plan_buffer_line(target, pl_data);  // Bypass mc_line(). Directly plan homing motion.
@@ -167,6 +353,7 @@ void limits_go_home(uint8_t cycle_mask) {
                     if (axislock & step_pin[idx]) {
                         if (limit_state & bit(idx)) {
                             axislock &= ~(step_pin[idx]);
+                            found |= bit(idx);
                         }
                     }
                 }
@@ -196,6 +383,9 @@ void limits_go_home(uint8_t cycle_mask) {
 
                 if (sys_rt_exec_alarm != ExecAlarm::None) {
                     motors_set_homing_mode(cycle_mask, false);  // tell motors homing is done...failed
+                    if (approach) {
+                        grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "Homing %s not found", homing_axis_letters(cycle_mask & ~found, letters));
+                    }
                     grbl_msg_sendf(CLIENT_ALL, MsgLevel::Debug, "Homing fail");
                     mc_reset();  // Stop motors, if they are running.
                     protocol_execute_realtime();
@@ -210,11 +400,16 @@ void limits_go_home(uint8_t cycle_mask) {
 #ifdef USE_I2S_STEPS
         if (current_stepper == ST_I2S_STREAM) {
             if (!approach) {
-                delay_ms(I2S_OUT_DELAY_MS);
+                delay_ms(i2s_out_get_delay_ms());
             }
         }
 #endif
-        st_reset();                        // Immediately force kill steppers and reset step segment buffer.
+        st_reset();  // Immediately force kill steppers and reset step segment buffer.
+        if (approach) {
+            // Per-axis progress. Reported after the motion, as the loop above has no time to spare.
+            grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "Homing %s %s", homing_axis_letters(found, letters), seeking ? "found" : "located");
+            seeking = false;
+        }
         delay_ms(homing_debounce->get());  // Delay to allow transient dynamics to dissipate.
         // Reverse direction and reset homing rate for locate cycle(s).
         approach = !approach;
@@ -237,6 +432,28 @@ void limits_go_home(uint8_t cycle_mask) {
     // Set machine positions for homed limit switches. Don't update non-homed axes.
     auto mask    = homing_dir_mask->get();
     auto pulloff = homing_pulloff->get();
+#ifdef LINEAR_KINEMATICS
+    // The homed axes are set in cartesian space, and the steps of the motors they share follow.
+    float* position = system_get_mpos();
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        if (cycle_mask & bit(idx)) {
+            float mpos    = axis_settings[idx]->home_mpos->get();
+            position[idx] = bit_istrue(mask, bit(idx)) ? mpos + pulloff : mpos - pulloff;
+        }
+    }
+    linear_kinematics_to_motors(position, position, n_axis);
+    uint8_t homed_motors = 0;
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        if (cycle_mask & bit(idx)) {
+            homed_motors |= linear_kinematics_motors_of(idx);
+        }
+    }
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        if (homed_motors & bit(idx)) {
+            sys_position[idx] = lroundf(position[idx] * axis_settings[idx]->steps_per_mm->get());
+        }
+    }
+#else
     for (uint8_t idx = 0; idx < n_axis; idx++) {
         auto steps = axis_settings[idx]->steps_per_mm->get();
         if (cycle_mask & bit(idx)) {
@@ -250,8 +467,11 @@ void limits_go_home(uint8_t cycle_mask) {
             }
         }
     }
+#endif
     sys.step_control = {};                      // Return step control to normal operation.
+    homed_axes |= cycle_mask;
     motors_set_homing_mode(cycle_mask, false);  // tell motors homing is done
+    grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "Homed %s", homing_axis_letters(cycle_mask, letters));
 }
 
 uint8_t limit_pins[MAX_N_AXIS][2] = { { X_LIMIT_PIN, X2_LIMIT_PIN }, { Y_LIMIT_PIN, Y2_LIMIT_PIN }, { Z_LIMIT_PIN, Z2_LIMIT_PIN },
@@ -259,6 +479,11 @@ uint8_t limit_pins[MAX_N_AXIS][2] = { { X_LIMIT_PIN, X2_LIMIT_PIN }, { Y_LIMIT_P
 
 uint8_t limit_mask = 0;
 
+// GPIO input register bits of each axis' limit pins, for limits_get_state(). Pins 0-31 are in
+// GPIO.in and pins 32-39 in GPIO.in1.
+static uint32_t limit_in_bits[MAX_N_AXIS];
+static uint32_t limit_in1_bits[MAX_N_AXIS];
+
 void limits_init() {
     limit_mask = 0;
     int mode   = INPUT_PULLUP;
@@ -266,12 +491,20 @@ void limits_init() {
     mode = INPUT;
 #endif
     auto n_axis = number_axis->get();
+    for (int axis = 0; axis < MAX_N_AXIS; axis++) {
+        limit_in_bits[axis] = limit_in1_bits[axis] = 0;
+    }
     for (int axis = 0; axis < n_axis; axis++) {
         for (int gang_index = 0; gang_index < 2; gang_index++) {
             uint8_t pin;
             if ((pin = limit_pins[axis][gang_index]) != UNDEFINED_PIN) {
                 pinMode(pin, mode);
                 limit_mask |= bit(axis);
+                if (pin < 32) {
+                    limit_in_bits[axis] |= 1UL << pin;
+                } else {
+                    limit_in1_bits[axis] |= 1UL << (pin - 32);
+                }
                 if (hard_limits->get()) {
                     attachInterrupt(pin, isr_limit_switches, CHANGE);
                 } else {
@@ -289,12 +522,17 @@ void limits_init() {
     // setup task used for debouncing
     if (limit_sw_queue == NULL) {
         limit_sw_queue = xQueueCreate(10, sizeof(int));
-        xTaskCreate(limitCheckTask,
-                    "limitCheckTask",
-                    2048,
-                    NULL,
-                    5,  // priority
-                    NULL);
+#ifdef ENABLE_TIMER_DEBOUNCE
+        limits_debounce_timer_init();  // The timer takes the place of the task
+#else
+        heap_task_create(limitCheckTask,
+                         "limitCheckTask",
+                         2048,
+                         NULL,
+                         5,  // priority
+                         NULL,
+                         tskNO_AFFINITY);
+#endif
     }
 }
 
@@ -311,21 +549,47 @@ void limits_disable() {
     }
 }
 
+// Returns true if every axis in mask has its own limit switches, so that each switch that
+// triggers during a shared homing cycle can be attributed to one axis.
+bool limits_independent(AxisMask mask) {
+    auto n_axis = number_axis->get();
+    for (uint8_t axis = 0; axis < n_axis; axis++) {
+        if (bit_isfalse(mask, bit(axis))) {
+            continue;
+        }
+        for (uint8_t other = axis + 1; other < n_axis; other++) {
+            if (bit_isfalse(mask, bit(other))) {
+                continue;
+            }
+            for (int gang_index = 0; gang_index < 2; gang_index++) {
+                for (int other_gang = 0; other_gang < 2; other_gang++) {
+                    uint8_t pin = limit_pins[axis][gang_index];
+                    if (pin != UNDEFINED_PIN && pin == limit_pins[other][other_gang]) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
 // Returns limit state as a bit-wise uint8 variable. Each bit indicates an axis limit, where
 // triggered is 1 and not triggered is 0. Invert mask is applied. Axes are defined by their
 // number in bit position, i.e. Z_AXIS is bit(2), and Y_AXIS is bit(1).
+// Reads all the limit pins with one read of each GPIO input register. An axis is active if
+// either of its ganged switches is.
 AxisMask limits_get_state() {
     AxisMask pinMask = 0;
-    auto     n_axis  = number_axis->get();
-    for (int axis = 0; axis < n_axis; axis++) {
-        for (int gang_index = 0; gang_index < 2; gang_index++) {
-            uint8_t pin = limit_pins[axis][gang_index];
-            if (pin != UNDEFINED_PIN) {
-                if (limit_invert->get())
-                    pinMask |= (!digitalRead(pin) << axis);
-                else
-                    pinMask |= (digitalRead(pin) << axis);
-            }
+    uint32_t in      = GPIO.in;
+    uint32_t in1     = GPIO.in1.data;
+    if (limit_invert->get()) {
+        in  = ~in;
+        in1 = ~in1;
+    }
+    for (int axis = 0; axis < MAX_N_AXIS; axis++) {
+        if ((in & limit_in_bits[axis]) | (in1 & limit_in1_bits[axis])) {
+            pinMask |= bit(axis);
         }
     }
 
@@ -381,32 +645,59 @@ void limitCheckTask(void* pvParameters) {
     }
 }
 
-float limitsMaxPosition(uint8_t axis) {
-    float mpos = axis_settings[axis]->home_mpos->get();
+// Travel of each axis from the homing and travel settings, kept up to date by their listeners
+// so that a soft limit check does not go through the settings for every line. check_min and
+// check_max are the same, but open ended for an axis with $<axis>/MaxTravel=0.
+static float limit_min[MAX_N_AXIS];
+static float limit_max[MAX_N_AXIS];
+static float limit_check_min[MAX_N_AXIS];
+static float limit_check_max[MAX_N_AXIS];
+
+static void limits_travel_changed(Setting* setting) {
+    for (int axis = 0; axis < MAX_N_AXIS; axis++) {
+        float mpos   = axis_settings[axis]->home_mpos->get();
+        float travel = axis_settings[axis]->max_travel->get();
+        if (bitnum_istrue(homing_dir_mask->get(), axis)) {
+            limit_min[axis] = mpos;
+            limit_max[axis] = mpos + travel;
+        } else {
+            limit_min[axis] = mpos - travel;
+            limit_max[axis] = mpos;
+        }
+        limit_check_min[axis] = travel > 0 ? limit_min[axis] : -FLT_MAX;
+        limit_check_max[axis] = travel > 0 ? limit_max[axis] : FLT_MAX;
+    }
+}
 
-    return bitnum_istrue(homing_dir_mask->get(), axis) ? mpos + axis_settings[axis]->max_travel->get() : mpos;
+void limits_settings_init() {
+    homing_dir_mask->onChange(limits_travel_changed);
+    for (int axis = 0; axis < MAX_N_AXIS; axis++) {
+        axis_settings[axis]->home_mpos->onChange(limits_travel_changed);
+#ifndef LOCKED_AXIS_SETTINGS
+        axis_settings[axis]->max_travel->onChange(limits_travel_changed);
+#endif
+    }
 }
 
-float limitsMinPosition(uint8_t axis) {
-    float mpos = axis_settings[axis]->home_mpos->get();
+float limitsMaxPosition(uint8_t axis) {
+    return limit_max[axis];
+}
 
-    return bitnum_istrue(homing_dir_mask->get(), axis) ? mpos : mpos - axis_settings[axis]->max_travel->get();
+float limitsMinPosition(uint8_t axis) {
+    return limit_min[axis];
 }
 
 // Checks and reports if target array exceeds machine travel limits.
 // Return true if exceeding limits
 // Set $<axis>/MaxTravel=0 to selectively remove an axis from soft limit checks
 bool __attribute__((weak)) limitsCheckTravel(float* target) {
-    uint8_t idx;
-    auto    n_axis = number_axis->get();
-    for (idx = 0; idx < n_axis; idx++) {
-        float max_mpos, min_mpos;
-
-        if ((target[idx] < limitsMinPosition(idx) || target[idx] > limitsMaxPosition(idx)) && axis_settings[idx]->max_travel->get() > 0) {
-            return true;
-        }
+    auto n_axis  = number_axis->get();
+    bool outside = false;
+    // Every axis is compared, without branching, so the loop does not depend on the data.
+    for (int idx = 0; idx < n_axis; idx++) {
+        outside |= (target[idx] < limit_check_min[idx]) | (target[idx] > limit_check_max[idx]);
     }
-    return false;
+    return outside;
 }
 
 bool limitsSwitchDefined(uint8_t axis, uint8_t gang_index) {
@@ -416,3 +707,43 @@ bool limitsSwitchDefined(uint8_t axis, uint8_t gang_index) {
 bool __attribute__((weak)) user_defined_homing(uint8_t cycle_mask) {
     return false;
 }
+
+// Saves the position of the homed axes for the fast re-reference of the next power up. Only
+// called on a controlled shutdown, with the machine idle, so no steps can have been lost.
+void limits_save_position() {
+    if (!homing_fast_ref->get() || !homed_axes || sys.state != State::Idle) {
+        return;
+    }
+    home_ref_t ref = {};
+    ref.axes       = homed_axes;
+    auto n_axis    = number_axis->get();
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        ref.motors[idx] = sys_position[idx] / axis_settings[idx]->steps_per_mm->get();
+    }
+    Setting::storeBlob(HOME_REF_KEY, &ref, sizeof(ref));
+}
+
+// Takes the position saved at the last controlled shutdown, if any. It is erased as it is read,
+// so a power loss later on, when the machine may have been moved, homes the whole way again.
+void limits_restore_position() {
+    home_ref_t ref = {};
+    size_t     len = sizeof(ref);
+    if (nvs_get_blob(Setting::_handle, HOME_REF_KEY, &ref, &len) != ESP_OK) {
+        return;
+    }
+    Setting::eraseKey(HOME_REF_KEY);
+    if (len != sizeof(ref) || !homing_fast_ref->get()) {
+        return;
+    }
+    auto n_axis = number_axis->get();
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        sys_position[idx] = lroundf(ref.motors[idx] * axis_settings[idx]->steps_per_mm->get());
+    }
+    ref_axes = ref.axes;
+    char letters[MAX_N_AXIS + 1];
+    grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Homing %s from saved position", homing_axis_letters(ref_axes, letters));
+}
+
+void limits_forget_homing() {
+    homed_axes = 0;
+}
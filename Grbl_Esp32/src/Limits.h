@@ -38,9 +38,19 @@ void limits_disable();
 // Returns limit state as a bit-wise uint8 variable.
 AxisMask limits_get_state();
 
+// Returns true if no two axes in mask share a limit pin.
+bool limits_independent(AxisMask mask);
+
 // Perform one portion of the homing cycle based on the input settings.
 void limits_go_home(uint8_t cycle_mask);
 
+// Fast re-reference. The position of the homed axes is saved at a controlled shutdown and
+// restored at power up, and the next homing of those axes rapids near the switches and only
+// does the locate touches. limits_forget_homing() is called when steps may have been lost.
+void limits_save_position();
+void limits_restore_position();
+void limits_forget_homing();
+
 // Check for soft limit violations
 void limits_soft_check(float* target);
 
@@ -49,6 +59,9 @@ void isr_limit_switches();
 // A task that runs after a limit switch interrupt.
 void limitCheckTask(void* pvParameters);
 
+// Registers the listeners that keep the travel of each axis for the functions below.
+void limits_settings_init();
+
 float limitsMaxPosition(uint8_t axis);
 float limitsMinPosition(uint8_t axis);
 
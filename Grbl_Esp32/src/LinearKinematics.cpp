@@ -0,0 +1,97 @@
+/*
+  LinearKinematics.cpp - Motors driven by a constant linear mix of the cartesian axes
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The inverse is worked out by the compiler, so a matrix that has none fails the build.
+*/
+
+#include "Config.h"
+#ifdef LINEAR_KINEMATICS
+#    include "Grbl.h"
+
+#    ifdef USE_KINEMATICS
+#        error "LINEAR_KINEMATICS and USE_KINEMATICS cannot be used together"
+#    endif
+
+static constexpr float matrix[3][3] = LINEAR_KINEMATICS_MATRIX;
+
+#    define M(r, c) matrix[r][c]
+#    define COFACTOR(r0, r1, c0, c1) (M(r0, c0) * M(r1, c1) - M(r0, c1) * M(r1, c0))
+
+static constexpr float determinant = M(0, 0) * COFACTOR(1, 2, 1, 2) - M(0, 1) * COFACTOR(1, 2, 0, 2) + M(0, 2) * COFACTOR(1, 2, 0, 1);
+static_assert(determinant != 0.0f, "LINEAR_KINEMATICS_MATRIX has no inverse");
+
+static constexpr float inverse[3][3] = {
+    { COFACTOR(1, 2, 1, 2) / determinant, -COFACTOR(0, 2, 1, 2) / determinant, COFACTOR(0, 1, 1, 2) / determinant },
+    { -COFACTOR(1, 2, 0, 2) / determinant, COFACTOR(0, 2, 0, 2) / determinant, -COFACTOR(0, 1, 0, 2) / determinant },
+    { COFACTOR(1, 2, 0, 1) / determinant, -COFACTOR(0, 2, 0, 1) / determinant, COFACTOR(0, 1, 0, 1) / determinant },
+};
+
+static void linear_apply(const float m[3][3], const float* in, float* out, uint8_t n_axis) {
+    uint8_t n = MIN(n_axis, 3);
+    float   mixed[3];
+    for (uint8_t r = 0; r < n; r++) {
+        mixed[r] = 0.0f;
+        for (uint8_t c = 0; c < n; c++) {
+            mixed[r] += m[r][c] * in[c];
+        }
+    }
+    for (uint8_t r = 0; r < n; r++) {
+        out[r] = mixed[r];
+    }
+    for (uint8_t idx = n; idx < n_axis; idx++) {
+        out[idx] = in[idx];
+    }
+}
+
+void linear_kinematics_to_motors(const float* cartesian, float* motors, uint8_t n_axis) {
+    linear_apply(matrix, cartesian, motors, n_axis);
+}
+
+void linear_kinematics_to_cartesian(const float* motors, float* cartesian, uint8_t n_axis) {
+    linear_apply(inverse, motors, cartesian, n_axis);
+}
+
+uint8_t linear_kinematics_motors_of(uint8_t axis) {
+    if (axis >= 3) {
+        return bit(axis);
+    }
+    uint8_t motors = 0;
+    for (uint8_t r = 0; r < 3; r++) {
+        if (matrix[r][axis] != 0.0f) {
+            motors |= bit(r);
+        }
+    }
+    return motors;
+}
+
+bool linear_kinematics_coupled(uint8_t axis_mask) {
+    uint8_t seen = 0;
+    for (uint8_t idx = 0; idx < MAX_N_AXIS; idx++) {
+        if (bitnum_istrue(axis_mask, idx)) {
+            uint8_t motors = linear_kinematics_motors_of(idx);
+            if (seen & motors) {
+                return true;
+            }
+            seen |= motors;
+        }
+    }
+    return false;
+}
+
+// Reports and probes read the machine position through this.
+void motors_to_cartesian(float* cartesian, float* motors, int n_axis) {
+    linear_kinematics_to_cartesian(motors, cartesian, n_axis);
+}
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+/*
+  LinearKinematics.h - Motors driven by a constant linear mix of the cartesian axes
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdint>
+
+// With LINEAR_KINEMATICS the X, Y and Z motor positions are LINEAR_KINEMATICS_MATRIX times
+// the cartesian X, Y and Z, and the other axes pass through. The planner counts the steps of
+// each motor but limits the rate and acceleration of each cartesian axis, so $X/MaxRate and
+// $X/Acceleration are those of the carriage, while $X/StepsPerMm is that of the X motor.
+
+// Both take the positions of the first n_axis axes and may be given the same array.
+void linear_kinematics_to_motors(const float* cartesian, float* motors, uint8_t n_axis);
+void linear_kinematics_to_cartesian(const float* motors, float* cartesian, uint8_t n_axis);
+
+// The motors that turn when the cartesian axis moves.
+uint8_t linear_kinematics_motors_of(uint8_t axis);
+
+// Homing locks the motors of an axis when its switch is reached, so axes that share a motor
+// home in cycles of their own.
+bool linear_kinematics_coupled(uint8_t axis_mask);
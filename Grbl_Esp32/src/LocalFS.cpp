@@ -0,0 +1,135 @@
+/*
+  LocalFS.cpp - The file system on the flash partition labelled "spiffs"
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Grbl.h"
+#include "LocalFS.h"
+
+#ifdef USE_LITTLEFS
+// LittleFS did not mount. If the partition still holds a SPIFFS image, its files are held in RAM,
+// each as its name, its size and its contents, while the partition is formatted, and then
+// written back. False if they did not all fit, which leaves the image as it was.
+static bool localfs_move_spiffs() {
+    if (!SPIFFS.begin(false)) {
+        return true;  // Blank or damaged, so there is nothing to keep
+    }
+    size_t   size  = SPIFFS.usedBytes();  // Page overhead leaves room for the names and sizes
+    uint8_t* held  = size ? (uint8_t*)heap_alloc_large(HeapTag::Web, size) : NULL;
+    size_t   used  = 0;
+    int      files = 0;
+    bool     fits  = size == 0 || held != NULL;
+    File     root  = SPIFFS.open("/");
+    for (File file = root.openNextFile(); fits && file; file = root.openNextFile()) {
+        size_t   name_len = strlen(file.name()) + 1;
+        uint32_t len      = file.size();
+        if (used + name_len + sizeof(len) + len > size) {
+            fits = false;
+            break;
+        }
+        memcpy(held + used, file.name(), name_len);
+        memcpy(held + used + name_len, &len, sizeof(len));
+        fits = file.read(held + used + name_len + sizeof(len), len) == len;
+        used += name_len + sizeof(len) + len;
+        files++;
+    }
+    root.close();
+    SPIFFS.end();
+    if (!fits || !LocalFS.begin(true)) {
+        if (held) {
+            heap_free(HeapTag::Web, held, size);
+        }
+        grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Error, "Cannot move the local files from SPIFFS, $LocalFS/Format to start over");
+        return false;
+    }
+    for (size_t pos = 0; pos < used;) {
+        const char* name = (const char*)held + pos;
+        uint32_t    len;
+        pos += strlen(name) + 1;
+        memcpy(&len, held + pos, sizeof(len));
+        pos += sizeof(len);
+        File file;
+        if (!localfs_make_parents(name) || !(file = LocalFS.open(name, FILE_WRITE)) || file.write(held + pos, len) != len) {
+            grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Error, "Cannot move %s to LittleFS", name);
+            files--;
+        }
+        if (file) {
+            file.close();
+        }
+        pos += len;
+    }
+    if (held) {
+        heap_free(HeapTag::Web, held, size);
+    }
+    grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Moved %d local files from SPIFFS to LittleFS", files);
+    return true;
+}
+#endif
+
+bool localfs_mount() {
+    if (LocalFS.begin(false)) {
+        return true;
+    }
+#ifdef USE_LITTLEFS
+    if (!localfs_move_spiffs()) {
+        return false;
+    }
+#endif
+    return LocalFS.begin(true);
+}
+
+bool localfs_mkdir(const String& path) {
+#ifdef USE_LITTLEFS
+    return LocalFS.exists(path) || LocalFS.mkdir(path);
+#else
+    File keep = LocalFS.open(path + "/.", FILE_WRITE);
+    if (!keep) {
+        return false;
+    }
+    keep.close();
+    return true;
+#endif
+}
+
+bool localfs_make_parents(const String& path) {
+#ifdef USE_LITTLEFS
+    for (int slash = path.indexOf('/', 1); slash > 0; slash = path.indexOf('/', slash + 1)) {
+        if (!localfs_mkdir(path.substring(0, slash))) {
+            return false;
+        }
+    }
+#endif
+    return true;  // A SPIFFS name can hold slashes as it is
+}
+
+// SPIFFS lists every file whose name starts with the path, LittleFS only the entries directly in
+// it, with the directories among them removed in turn.
+bool localfs_remove_dir(const String& path) {
+    File dir = LocalFS.open(path);
+    if (!dir) {
+        return false;
+    }
+    bool removed = true;
+    for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+        String name   = file.name();
+        bool   is_dir = file.isDirectory();
+        file.close();
+        removed = (is_dir ? localfs_remove_dir(name) : LocalFS.remove(name)) && removed;
+    }
+    dir.close();
+#ifdef USE_LITTLEFS
+    removed = LocalFS.rmdir(path) && removed;
+#endif
+    return removed;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+/*
+  LocalFS.h - The file system on the flash partition labelled "spiffs"
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Config.h"
+
+#include <WString.h>
+
+// SPIFFS keeps one flat list of names, so directories are only name prefixes, and finding and
+// opening a file gets slower as files are added. With USE_LITTLEFS the same partition holds
+// LittleFS instead, which has real directories, opens in time that does not grow with the file
+// count, and replaces a file whole or not at all when power is lost while writing it. The web
+// server, the $LocalFS commands and the files kept by the firmware all use LocalFS.
+#ifdef USE_LITTLEFS
+#    include <LITTLEFS.h>
+static auto& LocalFS = LITTLEFS;
+#else
+#    include <SPIFFS.h>
+static auto& LocalFS = SPIFFS;
+#endif
+
+// Mounts LocalFS if it is not mounted yet, formatting a blank or damaged partition. The first
+// time a LittleFS build finds a SPIFFS image there, it moves the files across; if they do not
+// fit in RAM meanwhile, the image is left alone and this fails. True once it is mounted.
+bool localfs_mount();
+
+// On SPIFFS a directory only exists while something is in it, so an empty one is kept listed
+// by a file named "." in it. localfs_make_parents() makes the directories above a file path.
+bool localfs_mkdir(const String& path);
+bool localfs_make_parents(const String& path);
+
+// Removes the directory and everything in it.
+bool localfs_remove_dir(const String& path);
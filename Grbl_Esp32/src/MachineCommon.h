@@ -14,6 +14,19 @@
 #    define GRBL_SPI_FREQ 4000000
 #endif
 
+// G33 and G33.1 follow a quadrature encoder on the spindle. Define SPINDLE_ENCODER_A_PIN
+// and SPINDLE_ENCODER_B_PIN, and SPINDLE_ENCODER_PPR if it does not have 1024 lines.
+#if defined(SPINDLE_ENCODER_A_PIN) && defined(SPINDLE_ENCODER_B_PIN)
+#    define SPINDLE_SYNC
+#endif
+
+// Quadrature encoders on the axes catch lost steps. Define <axis>_ENCODER_A_PIN and
+// <axis>_ENCODER_B_PIN, e.g. X_ENCODER_A_PIN, and set $<axis>/Encoder/CountsPerMm.
+#if defined(X_ENCODER_A_PIN) || defined(Y_ENCODER_A_PIN) || defined(Z_ENCODER_A_PIN) || \
+    defined(A_ENCODER_A_PIN) || defined(B_ENCODER_A_PIN) || defined(C_ENCODER_A_PIN)
+#    define AXIS_ENCODERS
+#endif
+
 // ESP32 CPU Settings
 const uint32_t fTimers = 80000000;  // a reference to the speed of ESP32 timers
 
@@ -24,6 +24,8 @@
 
 #include "Grbl.h"
 
+#include <cfloat>
+
 // M_PI is not defined in standard C/C++ but some compilers
 // support it anyway.  The following suppresses Intellisense
 // problem reports.
@@ -33,31 +35,10 @@
 
 SquaringMode ganged_mode = SquaringMode::Dual;
 
-// Execute linear motion in absolute millimeter coordinates. Feed rate given in millimeters/second
-// unless invert_feed_rate is true. Then the feed_rate means that the motion should be completed in
-// (1 minute)/feed_rate time.
-// NOTE: This is the primary gateway to the grbl planner. All line motions, including arc line
-// segments, must pass through this routine before being passed to the planner. The seperation of
-// mc_line and plan_buffer_line is done primarily to place non-planner-type functions from being
-// in the planner and to let backlash compensation or canned cycle integration simple and direct.
-// returns true if line was submitted to planner, or false if intentionally dropped.
-bool mc_line(float* target, plan_line_data_t* pl_data) {
+// Waits for room in the planner and queues the line.
+static bool mc_submit_line(float* target, plan_line_data_t* pl_data) {
     bool submitted_result = false;
-    // store the plan data so it can be cancelled by the protocol system if needed
-    sys_pl_data_inflight = pl_data;
-    // If enabled, check for soft limit violations. Placed here all line motions are picked up
-    // from everywhere in Grbl.
-    if (soft_limits->get()) {
-        // NOTE: Block jog state. Jogging is a special case and soft limits are handled independently.
-        if (sys.state != State::Jog) {
-            limits_soft_check(target);
-        }
-    }
-    // If in check gcode mode, prevent motion by blocking planner. Soft limits still work.
-    if (sys.state == State::CheckMode) {
-        sys_pl_data_inflight = NULL;
-        return submitted_result;
-    }
+    sys_pl_data_inflight  = pl_data;
     // NOTE: Backlash compensation may be installed here. It will need direction info to track when
     // to insert a backlash line motion(s) before the intended line motion and will require its own
     // plan_check_full_buffer() and check for system abort loop. Also for position reporting
@@ -80,6 +61,7 @@ bool mc_line(float* target, plan_line_data_t* pl_data) {
             return submitted_result;  // Bail, if system abort.
         }
         if (plan_check_full_buffer()) {
+            plan_idle_recalculate();      // Waiting anyway, so finish any deferred planning.
             protocol_auto_cycle_start();  // Auto-cycle start when buffer is full.
         } else {
             break;
@@ -95,10 +77,418 @@ bool mc_line(float* target, plan_line_data_t* pl_data) {
     return submitted_result;
 }
 
+// Colinear segment merging. While $Planner/MergeTolerance is non-zero, mc_line() holds
+// back the last line and extends it with each following line as long as every vertex
+// it covers stays within the tolerance of the merged chord and the lines share their
+// feed, spindle and coolant data. Merging stops at any other line, and the held line is
+// flushed whenever the planner is about to run dry or the buffer is synchronized.
+// In G64 mode the held line also provides the corner for path blending, see mc_blend_corner().
+static const int MERGE_MAX_VERTICES = 16;
+
+typedef struct {
+    bool             active;
+    plan_line_data_t pl_data;
+    float            start[MAX_N_AXIS];
+    float            end[MAX_N_AXIS];
+    float            vertices[MERGE_MAX_VERTICES][MAX_N_AXIS];  // Interior points of the merged line
+    uint8_t          n_vertices;
+} merge_line_t;
+static merge_line_t merge;
+
+static bool mc_merge_data_matches(const plan_line_data_t* a, const plan_line_data_t* b) {
+    return a->feed_rate == b->feed_rate && a->spindle_speed == b->spindle_speed && a->spindle == b->spindle &&
+           a->coolant.Mist == b->coolant.Mist && a->coolant.Flood == b->coolant.Flood && a->motion.rapidMotion == b->motion.rapidMotion &&
+           a->motion.noFeedOverride == b->motion.noFeedOverride && a->blend_tolerance == b->blend_tolerance;
+}
+
+// True if the point lies within tolerance of the chord from start to end, and between its ends.
+static bool mc_merge_point_on_chord(const float* point, const float* start, const float* end, float tolerance) {
+    auto  n_axis  = number_axis->get();
+    float dot     = 0.0;
+    float len_sqr = 0.0;
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        float chord = end[idx] - start[idx];
+        dot += (point[idx] - start[idx]) * chord;
+        len_sqr += chord * chord;
+    }
+    if (len_sqr == 0.0 || dot < 0.0 || dot > len_sqr) {
+        return false;
+    }
+    float t        = dot / len_sqr;
+    float dist_sqr = 0.0;
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        float offset = point[idx] - start[idx] - t * (end[idx] - start[idx]);
+        dist_sqr += offset * offset;
+    }
+    return dist_sqr <= tolerance * tolerance;
+}
+
+// Queues the held back line, if there is one.
+void mc_flush_merged_line() {
+    if (merge.active) {
+        merge.active = false;
+        mc_submit_line(merge.end, &merge.pl_data);
+    }
+}
+
+// G64 path blending. Rather than slowing down to the junction speed at the end of the held
+// line, round the corner off with an arc tangent to both lines that passes no further than
+// the tolerance from the corner. The arc meets each line at distance d from the corner,
+// with d at most half of either line so that the next corner has room too. The held line
+// is queued up to the start of the arc, and the arc as short lines within the arc
+// tolerance, the same way mc_arc() does it. The new line is held from the end of the arc.
+static void mc_blend_corner(const float* target, float tolerance) {
+    auto  n_axis = number_axis->get();
+    float in_vec[MAX_N_AXIS], out_vec[MAX_N_AXIS];
+    float in_len = 0.0, out_len = 0.0, dot = 0.0;
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        in_vec[idx]  = merge.end[idx] - merge.start[idx];
+        out_vec[idx] = target[idx] - merge.end[idx];
+        in_len += in_vec[idx] * in_vec[idx];
+        out_len += out_vec[idx] * out_vec[idx];
+        dot += in_vec[idx] * out_vec[idx];
+    }
+    in_len  = sqrtf(in_len);
+    out_len = sqrtf(out_len);
+    if (in_len == 0.0 || out_len == 0.0) {
+        mc_flush_merged_line();
+        return;
+    }
+    // Nearly straight junctions are already fast, and reversals cannot be blended.
+    float cos_theta = dot / (in_len * out_len);
+    if (cos_theta > 0.9999 || cos_theta < -0.9999) {
+        mc_flush_merged_line();
+        return;
+    }
+    float theta        = acosf(cos_theta);    // Change of direction at the corner
+    float sin_half     = cosf(0.5f * theta);  // Sine of half the inside angle of the corner
+    float tan_half     = sin_half / sinf(0.5f * theta);
+    float radius       = tolerance * sin_half / (1.0f - sin_half);
+    float distance     = radius / tan_half;
+    float max_distance = 0.5f * MIN(in_len, out_len);
+    if (distance > max_distance) {
+        distance = max_distance;
+        radius   = distance * tan_half;
+    }
+    float    arc_tol  = arc_tolerance->get();
+    uint16_t segments = 0;
+    if (2 * radius > arc_tol) {
+        segments = floorf(fabsf(0.5f * theta * radius) / sqrtf(arc_tol * (2 * radius - arc_tol)));
+    }
+    if (segments == 0) {
+        mc_flush_merged_line();  // The corner is already within the arc tolerance.
+        return;
+    }
+    // Arc end points, center, and the vectors from the center to the end points.
+    float arc_start[MAX_N_AXIS], arc_end[MAX_N_AXIS], center[MAX_N_AXIS], from_center[MAX_N_AXIS], to_center[MAX_N_AXIS];
+    float sin_theta = sinf(theta);
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        float in_unit    = in_vec[idx] / in_len;
+        float out_unit   = out_vec[idx] / out_len;
+        float normal     = (out_unit - cos_theta * in_unit) / sin_theta;  // Toward the inside of the corner
+        arc_start[idx]   = merge.end[idx] - distance * in_unit;
+        arc_end[idx]     = merge.end[idx] + distance * out_unit;
+        center[idx]      = arc_start[idx] + radius * normal;
+        from_center[idx] = arc_start[idx] - center[idx];
+        to_center[idx]   = arc_end[idx] - center[idx];
+    }
+    merge.active = false;
+    mc_submit_line(arc_start, &merge.pl_data);
+    // Spherical interpolation between the two radius vectors works in any number of axes.
+    float point[MAX_N_AXIS];
+    for (uint16_t i = 1; i < segments; i++) {
+        if (sys.abort) {
+            return;
+        }
+        float t  = float(i) / segments;
+        float wa = sinf((1.0f - t) * theta) / sin_theta;
+        float wb = sinf(t * theta) / sin_theta;
+        for (uint8_t idx = 0; idx < n_axis; idx++) {
+            point[idx] = center[idx] + wa * from_center[idx] + wb * to_center[idx];
+        }
+        mc_submit_line(point, &merge.pl_data);
+    }
+    if (!sys.abort) {
+        mc_submit_line(arc_end, &merge.pl_data);
+    }
+}
+
+// Drops the held back line. Called on reset.
+void mc_discard_merged_line() {
+    merge.active = false;
+}
+
+// Returns true if the line was absorbed into the held back line or became the new one.
+static bool mc_merge_line(float* target, plan_line_data_t* pl_data) {
+    float tolerance = planner_merge_tolerance->get();
+    float blend     = pl_data->motion.rapidMotion ? 0.0 : pl_data->blend_tolerance;
+    if ((tolerance <= 0.0 && blend <= 0.0) || pl_data->is_jog || pl_data->motion.systemMotion || pl_data->motion.inverseTime) {
+        mc_flush_merged_line();
+        return false;
+    }
+#ifdef RASTER_ENGRAVING
+    if (pl_data->raster_line) {  // The pixels are spread over exactly this line
+        mc_flush_merged_line();
+        return false;
+    }
+#endif
+#ifdef SPINDLE_SYNC
+    if (pl_data->sync_pitch != 0.0) {  // The pitch holds for exactly this line
+        mc_flush_merged_line();
+        return false;
+    }
+#endif
+    auto n_axis = number_axis->get();
+    if (merge.active) {
+        bool same_data = mc_merge_data_matches(&merge.pl_data, pl_data);
+        bool mergeable = tolerance > 0.0 && same_data && merge.n_vertices < MERGE_MAX_VERTICES &&
+                         mc_merge_point_on_chord(merge.end, merge.start, target, tolerance);
+        for (uint8_t i = 0; mergeable && i < merge.n_vertices; i++) {
+            mergeable = mc_merge_point_on_chord(merge.vertices[i], merge.start, target, tolerance);
+        }
+        if (mergeable) {
+            memcpy(merge.vertices[merge.n_vertices++], merge.end, sizeof(merge.end));
+            memcpy(merge.end, target, n_axis * sizeof(target[0]));
+#ifdef USE_LINE_NUMBERS
+            merge.pl_data.line_number = pl_data->line_number;
+#endif
+            return true;
+        }
+        if (same_data && blend > 0.0) {
+            mc_blend_corner(target, blend);
+        } else {
+            mc_flush_merged_line();
+        }
+        if (sys.abort) {
+            return false;
+        }
+    }
+    plan_get_planner_mpos(merge.start);
+    memcpy(merge.end, target, n_axis * sizeof(target[0]));
+    merge.pl_data    = *pl_data;
+    merge.n_vertices = 0;
+    merge.active     = true;
+    return true;
+}
+
+static bool mc_queue_line(float* target, plan_line_data_t* pl_data) {
+    // Runs of nearly colinear segments are merged into one planner block.
+    if (mc_merge_line(target, pl_data)) {
+        sys_pl_data_inflight = NULL;
+        return true;
+    }
+    return mc_submit_line(target, pl_data);
+}
+
+// Height map compensation. While a probed map is active, every line gets the surface height
+// under it added to Z. Lines are split into pieces no longer in XY than half the grid spacing
+// so that they follow the bilinear surface. Probe, jog and system motions are not compensated.
+static bool mc_probe_motion;     // Set while mc_probe_cycle() queues the probing motion
+static bool mc_heightmap_queued;  // The last line was compensated, so the planner position includes its offset
+
+static bool mc_heightmap_line(float* target, plan_line_data_t* pl_data) {
+    auto  n_axis = number_axis->get();
+    float start[MAX_N_AXIS];
+    if (merge.active) {
+        memcpy(start, merge.end, sizeof(start));  // The held back line ends past the planner position
+    } else {
+        plan_get_planner_mpos(start);
+    }
+    if (mc_heightmap_queued) {
+        start[Z_AXIS] -= heightmap_offset(start[X_AXIS], start[Y_AXIS]);  // Back to the uncompensated path
+    }
+    mc_heightmap_queued = true;
+
+    float    dx       = target[X_AXIS] - start[X_AXIS];
+    float    dy       = target[Y_AXIS] - start[Y_AXIS];
+    uint32_t segments = ceilf(sqrtf(dx * dx + dy * dy) / heightmap_segment_length());
+    if (segments == 0) {
+        segments = 1;
+    }
+    plan_line_data_t piece_data = *pl_data;
+    if (piece_data.motion.inverseTime) {
+        piece_data.feed_rate *= segments;  // Each piece takes its share of the programmed time
+    }
+    float piece[MAX_N_AXIS];
+    for (uint32_t segment = 1; segment <= segments; segment++) {
+        float t = (float)segment / segments;
+        for (uint8_t idx = 0; idx < n_axis; idx++) {
+            piece[idx] = segment == segments ? target[idx] : start[idx] + t * (target[idx] - start[idx]);
+        }
+        piece[Z_AXIS] += heightmap_offset(piece[X_AXIS], piece[Y_AXIS]);
+        if (!mc_queue_line(piece, &piece_data) || sys.abort) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Execute linear motion in absolute millimeter coordinates. Feed rate given in millimeters/second
+// unless invert_feed_rate is true. Then the feed_rate means that the motion should be completed in
+// (1 minute)/feed_rate time.
+// NOTE: This is the primary gateway to the grbl planner. All line motions, including arc line
+// segments, must pass through this routine before being passed to the planner. The seperation of
+// mc_line and plan_buffer_line is done primarily to place non-planner-type functions from being
+// in the planner and to let backlash compensation or canned cycle integration simple and direct.
+// returns true if line was submitted to planner, or false if intentionally dropped.
+bool mc_line(float* target, plan_line_data_t* pl_data) {
+    bool submitted_result = false;
+    mc_finish_arc();  // An arc still being queued goes first.
+    if (sys.abort) {
+        return submitted_result;
+    }
+    // store the plan data so it can be cancelled by the protocol system if needed
+    sys_pl_data_inflight = pl_data;
+    // If enabled, check for soft limit violations. Placed here all line motions are picked up
+    // from everywhere in Grbl.
+    if (soft_limits->get()) {
+        // NOTE: Block jog state. Jogging is a special case and soft limits are handled independently.
+        if (sys.state != State::Jog) {
+            limits_soft_check(target);
+        }
+    }
+    // If in check gcode mode, prevent motion by blocking planner. Soft limits still work.
+    if (sys.state == State::CheckMode) {
+        sys_pl_data_inflight = NULL;
+        return submitted_result;
+    }
+    bool exact = false;  // The line may not be split or bent
+#ifdef RASTER_ENGRAVING
+    exact = pl_data->raster_line != 0;
+#endif
+#ifdef SPINDLE_SYNC
+    mc_sync_chained = pl_data->sync_pitch != 0.0;
+    exact |= mc_sync_chained;
+#endif
+    if (heightmap_active() && !mc_probe_motion && !pl_data->is_jog && !pl_data->motion.systemMotion && !exact) {
+        sys_pl_data_inflight = NULL;
+        return mc_heightmap_line(target, pl_data);
+    }
+    mc_heightmap_queued = false;
+    return mc_queue_line(target, pl_data);
+}
+
 bool __attribute__((weak)) cartesian_to_motors(float* target, plan_line_data_t* pl_data, float* position) {
     return mc_line(target, pl_data);
 }
 
+static const int KINEMATICS_CACHE_SIZE = 16;
+
+typedef struct {
+    float    cartesian[MAX_N_AXIS];
+    float    motors[MAX_N_AXIS];
+    uint32_t used;  // Value of kinematics_cache_clock at the last hit, 0 for an empty entry
+} kinematics_cache_entry_t;
+static kinematics_cache_entry_t kinematics_cache[KINEMATICS_CACHE_SIZE];
+static uint32_t                 kinematics_cache_clock;
+
+bool mc_kinematics_cache_lookup(const float* cartesian, float* motors) {
+    float tolerance = kinematics_cache_tolerance->get();
+    if (tolerance <= 0.0) {
+        return false;
+    }
+    auto n_axis = number_axis->get();
+    for (int i = 0; i < KINEMATICS_CACHE_SIZE; i++) {
+        kinematics_cache_entry_t* entry = &kinematics_cache[i];
+        if (entry->used == 0) {
+            continue;
+        }
+        uint8_t idx;
+        for (idx = 0; idx < n_axis; idx++) {
+            if (fabsf(cartesian[idx] - entry->cartesian[idx]) > tolerance) {
+                break;
+            }
+        }
+        if (idx == n_axis) {
+            memcpy(motors, entry->motors, n_axis * sizeof(motors[0]));
+            entry->used = ++kinematics_cache_clock;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Replaces the empty or least recently used entry.
+void mc_kinematics_cache_store(const float* cartesian, const float* motors) {
+    if (kinematics_cache_tolerance->get() <= 0.0) {
+        return;
+    }
+    kinematics_cache_entry_t* victim = &kinematics_cache[0];
+    for (int i = 1; i < KINEMATICS_CACHE_SIZE && victim->used != 0; i++) {
+        if (kinematics_cache[i].used < victim->used) {
+            victim = &kinematics_cache[i];
+        }
+    }
+    auto n_axis = number_axis->get();
+    memcpy(victim->cartesian, cartesian, n_axis * sizeof(cartesian[0]));
+    memcpy(victim->motors, motors, n_axis * sizeof(motors[0]));
+    victim->used = ++kinematics_cache_clock;
+}
+
+void mc_kinematics_cache_clear() {
+    memset(kinematics_cache, 0, sizeof(kinematics_cache));
+    kinematics_cache_clock = 0;
+}
+
+uint8_t __attribute__((weak)) cartesian_to_motors_batch(float cartesian[][MAX_N_AXIS], float motors[][MAX_N_AXIS], uint8_t count) {
+    memcpy(motors, cartesian, count * sizeof(cartesian[0]));
+    return count;
+}
+
+// Straight motor-space interpolation strays from the cartesian line by roughly the square of the
+// segment length, so the deviation measured at the middle of a few probe chords tells how many
+// segments keep it within $Kinematics/Tolerance.
+uint32_t mc_kinematics_segment_count(const float* start, const float* end, float max_segment_len) {
+    auto  n_axis = number_axis->get();
+    float dist   = 0.0;
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        float delta = end[idx] - start[idx];
+        dist += delta * delta;
+    }
+    dist = sqrtf(dist);
+
+    uint32_t count     = ceilf(dist / max_segment_len);
+    float    tolerance = kinematics_tolerance->get();
+    if (tolerance <= 0.0 || count == 0) {
+        return count;
+    }
+
+    // The ends and middles of the probe chords, in order along the line
+    uint8_t probes   = MIN(count, (KINEMATICS_BATCH_SIZE - 1) / 2);
+    uint8_t n_points = 2 * probes + 1;
+    float   points[KINEMATICS_BATCH_SIZE][MAX_N_AXIS] = {};
+    float   motors[KINEMATICS_BATCH_SIZE][MAX_N_AXIS] = {};
+    for (uint8_t i = 0; i < n_points; i++) {
+        for (uint8_t idx = 0; idx < n_axis; idx++) {
+            points[i][idx] = start[idx] + (end[idx] - start[idx]) * i / (n_points - 1);
+        }
+    }
+    if (cartesian_to_motors_batch(points, motors, n_points) < n_points) {
+        return count;  // The caller reports the unreachable point
+    }
+
+    float deviation = 0.0;
+    for (uint8_t i = 1; i < n_points; i += 2) {
+        float middle[MAX_N_AXIS]    = {};
+        float cartesian[MAX_N_AXIS] = {};
+        for (uint8_t idx = 0; idx < n_axis; idx++) {
+            middle[idx] = (motors[i - 1][idx] + motors[i + 1][idx]) / 2.0;
+        }
+        motors_to_cartesian(cartesian, middle, n_axis);
+        float error = 0.0;
+        for (uint8_t idx = 0; idx < n_axis; idx++) {
+            float delta = cartesian[idx] - points[i][idx];
+            error += delta * delta;
+        }
+        deviation = MAX(deviation, error);
+    }
+    deviation = sqrtf(deviation);
+
+    uint32_t needed = ceilf(probes * sqrtf(deviation / tolerance));
+    uint32_t limit  = ceilf(dist / KINEMATICS_MIN_SEGMENT_LENGTH);
+    return MAX(count, MIN(needed, limit));
+}
+
 bool __attribute__((weak)) kinematics_pre_homing(uint8_t cycle_mask) {
     return false;  // finish normal homing cycle
 }
@@ -110,6 +500,123 @@ void __attribute__((weak)) motors_to_cartesian(float* cartesian, float* motors,
 }
 
 void __attribute__((weak)) forward_kinematics(float* position) {}
+// Arc chord generator. mc_arc() sets up the rotation and queues chords only while the planner
+// has room, then returns so the parser can go on. The rest of the chords are queued from the
+// main loop as blocks complete, by mc_continue_arc(), or all at once by mc_finish_arc() before
+// any other motion or a buffer synchronize, so motions still reach the planner in order.
+typedef struct {
+    bool             active;
+    bool             generating;  // Guards against mc_line() finishing the arc it is queuing
+    plan_line_data_t pl_data;
+    float            target[MAX_N_AXIS];
+    float            position[MAX_N_AXIS];
+    float            previous_position[MAX_N_AXIS];
+    float            center_axis0;
+    float            center_axis1;
+    float            offset_axis0;
+    float            offset_axis1;
+    float            r_axis0;  // Radius vector from center to current location
+    float            r_axis1;
+    float            cos_T;
+    float            sin_T;
+    float            theta_per_segment;
+    float            linear_per_segment;
+    float            original_feedrate;  // Kinematics may alter the feedrate, so save an original copy
+    uint16_t         segment;
+    uint16_t         segments;
+    uint8_t          count;
+    bool             single_precision;  // Float trig is within the tolerance for this arc
+    uint8_t          axis_0;
+    uint8_t          axis_1;
+    uint8_t          axis_linear;
+} arc_gen_t;
+static arc_gen_t arc;
+
+// Exact rotation for the arc correction steps. sinf() and cosf() are good to about an ulp,
+// so at angle a on radius R the correction is off by roughly R * (a + 2) * FLT_EPSILON.
+static void mc_arc_sincos(float angle, float* sin_angle, float* cos_angle) {
+#ifdef ARC_SINGLE_PRECISION_CORRECTION
+    if (arc.single_precision) {
+        *sin_angle = sinf(angle);
+        *cos_angle = cosf(angle);
+        return;
+    }
+#endif
+    *sin_angle = sin(angle);
+    *cos_angle = cos(angle);
+}
+
+// Queues the next chords of the arc. Unless wait is set, stops when the planner is full.
+static void mc_generate_arc(bool wait) {
+    arc.generating = true;
+    while (arc.active) {
+        if (!wait && plan_check_full_buffer()) {
+            break;
+        }
+        if (arc.segment < arc.segments) {
+            if (arc.count < N_ARC_CORRECTION) {
+                // Apply vector rotation matrix. ~40 usec
+                float r_axisi = arc.r_axis0 * arc.sin_T + arc.r_axis1 * arc.cos_T;
+                arc.r_axis0   = arc.r_axis0 * arc.cos_T - arc.r_axis1 * arc.sin_T;
+                arc.r_axis1   = r_axisi;
+                arc.count++;
+            } else {
+                // Arc correction to radius vector. Computed only every N_ARC_CORRECTION increments. ~375 usec
+                // Compute exact location by applying transformation matrix from initial radius vector(=-offset).
+                float cos_Ti;
+                float sin_Ti;
+                mc_arc_sincos(arc.segment * arc.theta_per_segment, &sin_Ti, &cos_Ti);
+                arc.r_axis0  = -arc.offset_axis0 * cos_Ti + arc.offset_axis1 * sin_Ti;
+                arc.r_axis1  = -arc.offset_axis0 * sin_Ti - arc.offset_axis1 * cos_Ti;
+                arc.count    = 0;
+            }
+            arc.segment++;
+            // Update arc_target location
+            arc.position[arc.axis_0] = arc.center_axis0 + arc.r_axis0;
+            arc.position[arc.axis_1] = arc.center_axis1 + arc.r_axis1;
+            arc.position[arc.axis_linear] += arc.linear_per_segment;
+            arc.pl_data.feed_rate = arc.original_feedrate;  // This restores the feedrate kinematics may have altered
+            cartesian_to_motors(arc.position, &arc.pl_data, arc.previous_position);
+            arc.previous_position[arc.axis_0]      = arc.position[arc.axis_0];
+            arc.previous_position[arc.axis_1]      = arc.position[arc.axis_1];
+            arc.previous_position[arc.axis_linear] = arc.position[arc.axis_linear];
+        } else {
+            // Ensure last segment arrives at target location.
+            arc.pl_data.feed_rate = arc.original_feedrate;
+            cartesian_to_motors(arc.target, &arc.pl_data, arc.previous_position);
+            arc.active = false;
+        }
+        // Bail mid-circle on system abort. Runtime command check already performed by mc_line.
+        if (sys.abort) {
+            arc.active = false;
+        }
+    }
+    arc.generating = false;
+}
+
+// Queues chords of the pending arc while the planner has room.
+void mc_continue_arc() {
+    if (arc.active && !arc.generating) {
+        mc_generate_arc(false);
+    }
+}
+
+// Queues the rest of the pending arc, waiting for planner space as needed, and the lines held
+// back by the arc fitting after it, which may make an arc of their own.
+void mc_finish_arc() {
+    if (arc.generating) {
+        return;
+    }
+    mc_flush_fitted_lines();
+    if (arc.active) {
+        mc_generate_arc(true);
+    }
+}
+
+void mc_discard_arc() {
+    arc.active = false;
+}
+
 // Execute an arc in offset mode format. position == current xyz, target == target xyz,
 // offset == offset from current xyz, axis_X defines circle plane in tool space, axis_linear is
 // the direction of helical travel, radius == circle radius, isclockwise boolean. Used
@@ -126,6 +633,10 @@ void mc_arc(float*            target,
             uint8_t           axis_1,
             uint8_t           axis_linear,
             uint8_t           is_clockwise_arc) {
+    mc_finish_arc();
+    if (sys.abort) {
+        return;
+    }
     float center_axis0 = position[axis_0] + offset[axis_0];
     float center_axis1 = position[axis_1] + offset[axis_1];
     float r_axis0      = -offset[axis_0];  // Radius vector from center to current location
@@ -133,13 +644,9 @@ void mc_arc(float*            target,
     float rt_axis0     = target[axis_0] - center_axis0;
     float rt_axis1     = target[axis_1] - center_axis1;
 
-    float previous_position[MAX_N_AXIS] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
-
-    uint16_t n;
-    auto     n_axis = number_axis->get();
-    for (n = 0; n < n_axis; n++) {
-        previous_position[n] = position[n];
-    }
+    memcpy(arc.position, position, sizeof(arc.position));
+    memcpy(arc.previous_position, position, sizeof(arc.previous_position));
+    memcpy(arc.target, target, sizeof(arc.target));
     // CCW angle between position and target from circle center. Only one atan2() trig computation required.
     float angular_travel = atan2(r_axis0 * rt_axis1 - r_axis1 * rt_axis0, r_axis0 * rt_axis0 + r_axis1 * rt_axis1);
     if (is_clockwise_arc) {  // Correct atan2 output per direction
@@ -164,8 +671,6 @@ void mc_arc(float*            target,
             pl_data->feed_rate *= segments;
             pl_data->motion.inverseTime = 0;  // Force as feed absolute mode over arc segments.
         }
-        float theta_per_segment  = angular_travel / segments;
-        float linear_per_segment = (target[axis_linear] - position[axis_linear]) / segments;
         /* Vector rotation by transformation matrix: r is the original vector, r_T is the rotated vector,
            and phi is the angle of rotation. Solution approach by Jens Geisler.
                r_T = [cos(phi) -sin(phi);
@@ -191,49 +696,240 @@ void mc_arc(float*            target,
            a correction, the planner should have caught up to the lag caused by the initial mc_arc overhead.
            This is important when there are successive arc motions.
         */
+        arc.theta_per_segment  = angular_travel / segments;
+        arc.linear_per_segment = (target[axis_linear] - position[axis_linear]) / segments;
         // Computes: cos_T = 1 - theta_per_segment^2/2, sin_T = theta_per_segment - theta_per_segment^3/6) in ~52usec
-        float cos_T = 2.0 - theta_per_segment * theta_per_segment;
-        float sin_T = theta_per_segment * 0.16666667 * (cos_T + 4.0);
-        cos_T *= 0.5;
-        float    sin_Ti;
-        float    cos_Ti;
-        float    r_axisi;
-        uint16_t i;
-        uint8_t  count             = 0;
-        float    original_feedrate = pl_data->feed_rate;  // Kinematics may alter the feedrate, so save an original copy
-        for (i = 1; i < segments; i++) {                  // Increment (segments-1).
-            if (count < N_ARC_CORRECTION) {
-                // Apply vector rotation matrix. ~40 usec
-                r_axisi = r_axis0 * sin_T + r_axis1 * cos_T;
-                r_axis0 = r_axis0 * cos_T - r_axis1 * sin_T;
-                r_axis1 = r_axisi;
-                count++;
-            } else {
-                // Arc correction to radius vector. Computed only every N_ARC_CORRECTION increments. ~375 usec
-                // Compute exact location by applying transformation matrix from initial radius vector(=-offset).
-                cos_Ti  = cos(i * theta_per_segment);
-                sin_Ti  = sin(i * theta_per_segment);
-                r_axis0 = -offset[axis_0] * cos_Ti + offset[axis_1] * sin_Ti;
-                r_axis1 = -offset[axis_0] * sin_Ti - offset[axis_1] * cos_Ti;
-                count   = 0;
-            }
-            // Update arc_target location
-            position[axis_0] = center_axis0 + r_axis0;
-            position[axis_1] = center_axis1 + r_axis1;
-            position[axis_linear] += linear_per_segment;
-            pl_data->feed_rate = original_feedrate;  // This restores the feedrate kinematics may have altered
-            cartesian_to_motors(position, pl_data, previous_position);
-            previous_position[axis_0]      = position[axis_0];
-            previous_position[axis_1]      = position[axis_1];
-            previous_position[axis_linear] = position[axis_linear];
-            // Bail mid-circle on system abort. Runtime command check already performed by mc_line.
-            if (sys.abort) {
-                return;
-            }
+        arc.cos_T = 2.0 - arc.theta_per_segment * arc.theta_per_segment;
+        arc.sin_T = arc.theta_per_segment * 0.16666667 * (arc.cos_T + 4.0);
+        arc.cos_T *= 0.5;
+    }
+    arc.pl_data           = *pl_data;
+    arc.original_feedrate = pl_data->feed_rate;
+    arc.center_axis0      = center_axis0;
+    arc.center_axis1      = center_axis1;
+    arc.offset_axis0      = offset[axis_0];
+    arc.offset_axis1      = offset[axis_1];
+    arc.r_axis0           = r_axis0;
+    arc.r_axis1           = r_axis1;
+    arc.segment           = 1;  // Increment (segments-1) before the final segment to the target.
+    arc.segments          = segments ? segments : 1;
+    arc.count             = 0;
+    arc.single_precision  = radius * (fabsf(angular_travel) + 2.0f) * FLT_EPSILON <= 0.1f * arc_tolerance->get();
+    arc.axis_0            = axis_0;
+    arc.axis_1            = axis_1;
+    arc.axis_linear       = axis_linear;
+    arc.active            = true;
+    mc_continue_arc();
+}
+
+// Arc fitting. CAM output often has circles as many short G1 chords, each a planner block
+// with a junction of its own. The fitting holds back up to ARC_FIT_MAX_LINES of them and
+// tries the circle through the first, middle and last vertex: every vertex must be within
+// the tolerance of it, the chords must turn one way by less than a full turn, and no chord
+// may stray further than the tolerance from the circle, so a polygon stays a polygon. When a
+// line does not continue the run, a run of ARC_FIT_MIN_LINES or more that fits is queued as
+// one arc and the lines ahead of a fit are queued as they are.
+static const int   ARC_FIT_MIN_LINES  = 4;
+static const int   ARC_FIT_MAX_LINES  = 32;
+static const float ARC_FIT_MAX_RADIUS = 5000.0;  // mm, above which the chords are taken as straight
+
+typedef struct {
+    bool             flushing;  // Guards against mc_finish_arc() flushing the lines being queued
+    uint8_t          n_lines;
+    uint8_t          axis_0;
+    uint8_t          axis_1;
+    uint8_t          axis_linear;
+    plan_line_data_t pl_data;
+    float            start[MAX_N_AXIS];          // Start of the first line, the other axes for all
+    float            ends[ARC_FIT_MAX_LINES][2];  // Line ends in the plane
+#ifdef USE_LINE_NUMBERS
+    int32_t line_numbers[ARC_FIT_MAX_LINES];
+#endif
+} arc_fit_t;
+static arc_fit_t fit;
+
+// Vertex i of the run in the plane, 0 being the start.
+static void mc_fit_vertex(uint8_t i, float* vertex) {
+    vertex[0] = i ? fit.ends[i - 1][0] : fit.start[fit.axis_0];
+    vertex[1] = i ? fit.ends[i - 1][1] : fit.start[fit.axis_1];
+}
+
+// Fits the circle to the first n lines of the run.
+static bool mc_fit_circle(uint8_t n, float* center, float* radius, bool* clockwise) {
+    if (n < 2) {
+        return false;
+    }
+    float a[2], b[2], c[2];
+    mc_fit_vertex(0, a);
+    mc_fit_vertex(n / 2, b);
+    mc_fit_vertex(n, c);
+    // Circumcenter, relative to a for precision.
+    float bx = b[0] - a[0], by = b[1] - a[1];
+    float cx = c[0] - a[0], cy = c[1] - a[1];
+    float d  = 2.0f * (bx * cy - by * cx);
+    if (d == 0.0f) {
+        return false;
+    }
+    float b_sqr = bx * bx + by * by;
+    float c_sqr = cx * cx + cy * cy;
+    float ux    = (cy * b_sqr - by * c_sqr) / d;
+    float uy    = (bx * c_sqr - cx * b_sqr) / d;
+    float r     = sqrtf(ux * ux + uy * uy);
+    if (r > ARC_FIT_MAX_RADIUS) {
+        return false;
+    }
+    center[0]       = a[0] + ux;
+    center[1]       = a[1] + uy;
+    float tolerance = planner_arc_fit_tolerance->get();
+    float turn      = 0.0f;
+    float from[2], to[2];
+    from[0] = -ux;
+    from[1] = -uy;
+    for (uint8_t i = 1; i <= n; i++) {
+        mc_fit_vertex(i, to);
+        to[0] -= center[0];
+        to[1] -= center[1];
+        if (fabsf(sqrtf(to[0] * to[0] + to[1] * to[1]) - r) > tolerance) {
+            return false;
+        }
+        float cross     = from[0] * to[1] - from[1] * to[0];
+        float dot       = from[0] * to[0] + from[1] * to[1];
+        float chord_sqr = (to[0] - from[0]) * (to[0] - from[0]) + (to[1] - from[1]) * (to[1] - from[1]);
+        if (chord_sqr == 0.0f || r - sqrtf(MAX(r * r - 0.25f * chord_sqr, 0.0f)) > tolerance) {
+            return false;  // A point of the chord is further than the tolerance from the circle.
+        }
+        if (i == 1) {
+            *clockwise = cross < 0.0f;
+        } else if ((cross < 0.0f) != *clockwise) {
+            return false;
+        }
+        turn += atan2f(fabsf(cross), dot);
+        from[0] = to[0];
+        from[1] = to[1];
+    }
+    *radius = r;
+    return turn < 2.0f * float(M_PI) - 0.01f;
+}
+
+// Queues the first n lines of the run, as one arc if as_arc is set and they fit one, and starts
+// the run after them.
+static void mc_fit_queue(uint8_t n, bool as_arc) {
+    float center[2], radius;
+    bool  clockwise;
+    as_arc = as_arc && n >= ARC_FIT_MIN_LINES && mc_fit_circle(n, center, &radius, &clockwise);
+
+    auto             n_axis = number_axis->get();
+    plan_line_data_t pl_data;
+    float            from[MAX_N_AXIS], to[MAX_N_AXIS];
+    memcpy(from, fit.start, sizeof(from));
+    memcpy(to, fit.start, sizeof(to));
+    fit.flushing = true;
+    if (as_arc) {
+        float offset[MAX_N_AXIS] = {};
+        offset[fit.axis_0]       = center[0] - from[fit.axis_0];
+        offset[fit.axis_1]       = center[1] - from[fit.axis_1];
+        to[fit.axis_0]           = fit.ends[n - 1][0];
+        to[fit.axis_1]           = fit.ends[n - 1][1];
+        pl_data                  = fit.pl_data;
+#ifdef USE_LINE_NUMBERS
+        pl_data.line_number = fit.line_numbers[n - 1];
+#endif
+        mc_arc(to, &pl_data, from, offset, radius, fit.axis_0, fit.axis_1, fit.axis_linear, clockwise);
+    } else {
+        for (uint8_t i = 0; i < n && !sys.abort; i++) {
+            to[fit.axis_0] = fit.ends[i][0];
+            to[fit.axis_1] = fit.ends[i][1];
+            pl_data        = fit.pl_data;
+#ifdef USE_LINE_NUMBERS
+            pl_data.line_number = fit.line_numbers[i];
+#endif
+            cartesian_to_motors(to, &pl_data, from);
+            memcpy(from, to, n_axis * sizeof(to[0]));
+        }
+    }
+    fit.flushing = false;
+
+    fit.start[fit.axis_0] = fit.ends[n - 1][0];
+    fit.start[fit.axis_1] = fit.ends[n - 1][1];
+    fit.n_lines -= n;
+    memmove(fit.ends, fit.ends + n, fit.n_lines * sizeof(fit.ends[0]));
+#ifdef USE_LINE_NUMBERS
+    memmove(fit.line_numbers, fit.line_numbers + n, fit.n_lines * sizeof(fit.line_numbers[0]));
+#endif
+}
+
+void mc_flush_fitted_lines() {
+    if (fit.n_lines && !fit.flushing) {
+        mc_fit_queue(fit.n_lines, true);
+    }
+}
+
+void mc_discard_fitted_lines() {
+    fit.n_lines = 0;
+}
+
+// True if the line only moves in the plane and nothing else about it asks for it as it is.
+static bool mc_fit_eligible(const float* target, const plan_line_data_t* pl_data, const float* position, uint8_t axis_0, uint8_t axis_1) {
+    if (planner_arc_fit_tolerance->get() <= 0.0 || sys.state == State::CheckMode || pl_data->motion.rapidMotion ||
+        pl_data->motion.inverseTime || pl_data->motion.systemMotion || pl_data->is_jog) {
+        return false;
+    }
+#ifdef RASTER_ENGRAVING
+    if (pl_data->raster_line) {
+        return false;
+    }
+#endif
+#ifdef SPINDLE_SYNC
+    if (pl_data->sync_pitch != 0.0) {
+        return false;
+    }
+#endif
+    auto n_axis = number_axis->get();
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        if (idx != axis_0 && idx != axis_1 && target[idx] != position[idx]) {
+            return false;
         }
     }
-    // Ensure last segment arrives at target location.
-    cartesian_to_motors(target, pl_data, previous_position);
+    return true;
+}
+
+bool mc_fit_line(float* target, plan_line_data_t* pl_data, float* position, uint8_t axis_0, uint8_t axis_1, uint8_t axis_linear) {
+    if (!mc_fit_eligible(target, pl_data, position, axis_0, axis_1)) {
+        mc_flush_fitted_lines();
+        return cartesian_to_motors(target, pl_data, position);
+    }
+    // Any other motion has flushed the run, so the line starts where the run ends.
+    if (fit.n_lines && (fit.axis_0 != axis_0 || fit.axis_1 != axis_1 || !mc_merge_data_matches(&fit.pl_data, pl_data))) {
+        mc_flush_fitted_lines();  // Another plane or feed starts a new run.
+    }
+    if (fit.n_lines == 0) {
+        memcpy(fit.start, position, sizeof(fit.start));
+        fit.axis_0      = axis_0;
+        fit.axis_1      = axis_1;
+        fit.axis_linear = axis_linear;
+        fit.pl_data     = *pl_data;
+    }
+    fit.ends[fit.n_lines][0] = target[axis_0];
+    fit.ends[fit.n_lines][1] = target[axis_1];
+#ifdef USE_LINE_NUMBERS
+    fit.line_numbers[fit.n_lines] = pl_data->line_number;
+#endif
+    fit.n_lines++;
+
+    float center[2], radius;
+    bool  clockwise;
+    while (fit.n_lines > 2 && !mc_fit_circle(fit.n_lines, center, &radius, &clockwise) && !sys.abort) {
+        // The new line does not go on along a circle with the lines before it.
+        if (fit.n_lines > ARC_FIT_MIN_LINES && mc_fit_circle(fit.n_lines - 1, center, &radius, &clockwise)) {
+            mc_fit_queue(fit.n_lines - 1, true);
+        } else {
+            mc_fit_queue(1, false);
+        }
+    }
+    if (fit.n_lines == ARC_FIT_MAX_LINES) {
+        mc_fit_queue(fit.n_lines, true);
+    }
+    return !sys.abort;
 }
 
 // Execute dwell in seconds.
@@ -245,6 +941,186 @@ bool mc_dwell(int32_t milliseconds) {
     return delay_msec(milliseconds, DwellMode::Dwell);
 }
 
+// Queues one move of a canned cycle and advances position to it.
+static bool canned_cycle_move(float* point, const plan_line_data_t* pl_data, float* position, bool rapid) {
+    plan_line_data_t move_data = *pl_data;
+    move_data.motion.rapidMotion = rapid;
+    cartesian_to_motors(point, &move_data, position);
+    memcpy(position, point, sizeof(float) * MAX_N_AXIS);
+    return !sys.abort;
+}
+
+// Drills one hole of a G73/G81/G82/G83 canned cycle at the target position, which excludes Z.
+// The tool rapids to the hole at its current height, down to the R plane, drills to the bottom
+// of the hole and rapids back up to retract_z. Returns false if the cycle was aborted.
+bool mc_canned_cycle(float*                   target,
+                     plan_line_data_t*        pl_data,
+                     float*                   position,
+                     Motion                   cycle,
+                     const gc_canned_cycle_t* params,
+                     float                    retract_z) {
+    float point[MAX_N_AXIS];
+    memcpy(point, position, sizeof(point));
+    // A cycle that starts below the R plane climbs to it before moving over to the hole.
+    if (point[Z_AXIS] < params->r_plane) {
+        point[Z_AXIS] = params->r_plane;
+        if (!canned_cycle_move(point, pl_data, position, true)) {
+            return false;
+        }
+    }
+    memcpy(point, target, sizeof(point));
+    point[Z_AXIS] = position[Z_AXIS];
+    if (!canned_cycle_move(point, pl_data, position, true)) {
+        return false;
+    }
+    point[Z_AXIS] = params->r_plane;
+    if (!canned_cycle_move(point, pl_data, position, true)) {
+        return false;
+    }
+    if (cycle == Motion::DrillChipBreak || cycle == Motion::DrillPeck) {
+        // G73 backs off a little after each peck to break the chip. G83 clears the hole to the R plane
+        // and rapids back down to just above the previous peck.
+        float bottom = params->r_plane;
+        while (bottom > params->depth) {
+            if (cycle == Motion::DrillPeck && bottom < params->r_plane) {
+                point[Z_AXIS] = MIN(bottom + CANNED_CYCLE_PECK_CLEARANCE, params->r_plane);
+                if (!canned_cycle_move(point, pl_data, position, true)) {
+                    return false;
+                }
+            }
+            bottom        = MAX(bottom - params->peck, params->depth);
+            point[Z_AXIS] = bottom;
+            if (!canned_cycle_move(point, pl_data, position, false)) {
+                return false;
+            }
+            if (bottom > params->depth) {
+                if (cycle == Motion::DrillPeck) {
+                    point[Z_AXIS] = params->r_plane;
+                } else {
+                    point[Z_AXIS] = MIN(bottom + CANNED_CYCLE_CHIP_BREAK, params->r_plane);
+                }
+                if (!canned_cycle_move(point, pl_data, position, true)) {
+                    return false;
+                }
+            }
+        }
+    } else {
+        point[Z_AXIS] = params->depth;
+        if (!canned_cycle_move(point, pl_data, position, false)) {
+            return false;
+        }
+        if (cycle == Motion::DrillDwell) {
+            mc_dwell(int32_t(params->dwell * 1000.0f));
+        }
+    }
+    point[Z_AXIS] = retract_z;
+    return canned_cycle_move(point, pl_data, position, true);
+}
+
+#ifdef SPINDLE_SYNC
+static bool mc_sync_chained = false;  // The last line queued was synchronized
+static int  mc_sync_dir     = 0;      // Sign of the encoder count along the chain
+
+static bool mc_spindle_sync_fail(const char* reason) {
+    grbl_msg_sendf(CLIENT_ALL, MsgLevel::Error, "Spindle sync failed: %s", reason);
+    mc_reset();
+    sys_rt_exec_alarm = ExecAlarm::SpindleControl;
+    return false;
+}
+
+// Waits for the encoder to reach origin, counting in direction dir, and starts a chain there.
+static bool mc_spindle_sync_begin(int64_t origin, int dir) {
+    for (int32_t waited = 0; dir * (spindle_encoder_count() - origin) < 0; waited++) {
+        if (waited >= SPINDLE_SYNC_WAIT_MS) {
+            return mc_spindle_sync_fail("spindle not turning");
+        }
+        protocol_execute_realtime();
+        if (sys.abort) {
+            return false;
+        }
+        delay(1);
+    }
+    st_spindle_sync_start(origin);
+    mc_sync_dir = dir;
+    return true;
+}
+
+// The planner gets the rate for the current spindle speed, for its junctions. The segment
+// generator follows the encoder from there.
+static bool mc_sync_line(float* target, plan_line_data_t* pl_data, float* position, float pitch) {
+    plan_line_data_t sync_data      = *pl_data;
+    sync_data.sync_pitch            = pitch * mc_sync_dir;
+    sync_data.motion.noFeedOverride = 1;
+    float length                    = 0.0;
+    for (uint8_t idx = 0; idx < number_axis->get(); idx++) {
+        length += (target[idx] - position[idx]) * (target[idx] - position[idx]);
+    }
+    sync_data.feed_rate = fabsf(spindle_encoder_rpm()) * pitch * sqrtf(length) / fabsf(target[Z_AXIS] - position[Z_AXIS]);
+    cartesian_to_motors(target, &sync_data, position);
+    return !sys.abort;
+}
+
+// A chain starts from rest, so that its start can wait for the spindle angle. Lines that join a
+// chain still in the planner carry on from where the one before ends.
+bool mc_spindle_sync(float* target, plan_line_data_t* pl_data, float* position, float pitch) {
+    if (sys.state == State::CheckMode) {
+        return true;
+    }
+    if (!mc_sync_chained || plan_get_block_buffer_count() == 0) {
+        protocol_buffer_synchronize();
+        if (sys.abort) {
+            return false;
+        }
+        float rpm = spindle_encoder_rpm();
+        if (fabsf(rpm) < SPINDLE_SYNC_MIN_RPM) {
+            return mc_spindle_sync_fail("spindle not turning");
+        }
+        int     dir    = rpm > 0 ? 1 : -1;
+        int64_t count  = spindle_encoder_count();
+        int64_t origin = count - ((count % SPINDLE_ENCODER_CPR) + SPINDLE_ENCODER_CPR) % SPINDLE_ENCODER_CPR;
+        if (dir > 0) {
+            origin += SPINDLE_ENCODER_CPR;
+        }
+        if (!mc_spindle_sync_begin(origin, dir)) {
+            return false;
+        }
+    }
+    return mc_sync_line(target, pl_data, position, pitch);
+}
+
+// The tool waits at the bottom while the spindle runs on and reverses. The way out starts where
+// the way in ended, so the tap follows its thread back from wherever the spindle turned round.
+bool mc_rigid_tap(float* target, plan_line_data_t* pl_data, float* position, float pitch) {
+    if (sys.state == State::CheckMode) {
+        return true;
+    }
+    float start[MAX_N_AXIS];
+    memcpy(start, position, sizeof(start));
+    mc_sync_chained = false;  // Always from rest
+    if (!mc_spindle_sync(target, pl_data, position, pitch)) {
+        return false;
+    }
+    memcpy(position, target, sizeof(start));
+    protocol_buffer_synchronize();
+    if (sys.abort) {
+        return false;
+    }
+    int64_t      bottom  = st_spindle_sync_end();
+    SpindleState reverse = pl_data->spindle == SpindleState::Ccw ? SpindleState::Cw : SpindleState::Ccw;
+    spindle->set_state(reverse, pl_data->spindle_speed);
+    if (!mc_spindle_sync_begin(bottom, -mc_sync_dir) || !mc_sync_line(start, pl_data, position, pitch)) {
+        return false;
+    }
+    memcpy(position, start, sizeof(start));
+    protocol_buffer_synchronize();
+    if (sys.abort) {
+        return false;
+    }
+    spindle->set_state(pl_data->spindle, pl_data->spindle_speed);
+    return true;
+}
+#endif
+
 // return true if the mask has exactly one bit set,
 // so it refers to exactly one axis
 static bool mask_is_single_axis(uint8_t axis_mask) {
@@ -272,6 +1148,28 @@ static bool axis_is_squared(uint8_t axis_mask) {
     return false;
 }
 
+// With Homing/Parallel, the parallel axes of later homing cycles are pulled forward into the
+// first cycle that homes a parallel axis, so that their seek, locate and pull-off motions are
+// shared instead of each waiting for the cycles before it. An axis is only pulled forward when
+// its switches are independent of the axes already in the cycle, and squared axes, which need a
+// cycle of their own, are never merged. merged collects the axes that have been pulled forward.
+static uint8_t homing_merge_parallel(int cycle, uint8_t homing_mask, uint8_t& merged) {
+    auto parallel = homing_parallel_axes->get() & ~homing_squared_axes->get();
+    if (bit_isfalse(homing_mask, parallel) || (homing_mask & homing_squared_axes->get())) {
+        return homing_mask;
+    }
+    for (int later = cycle + 1; later < MAX_N_AXIS; later++) {
+        auto candidates = homing_cycle[later]->get() & parallel & ~merged;
+        for (uint8_t idx = 0; idx < MAX_N_AXIS; idx++) {
+            if (bit_istrue(candidates, bit(idx)) && limits_independent(homing_mask | bit(idx))) {
+                homing_mask |= bit(idx);
+                merged |= bit(idx);
+            }
+        }
+    }
+    return homing_mask;
+}
+
 #ifdef USE_I2S_STEPS
 #    define BACKUP_STEPPER(save_stepper)                                                                                                   \
         do {                                                                                                                               \
@@ -297,6 +1195,8 @@ static bool axis_is_squared(uint8_t axis_mask) {
 void mc_homing_cycle(uint8_t cycle_mask) {
     bool no_cycles_defined = true;
 
+    mc_flush_merged_line();  // A held back line goes ahead of homing, as it would without merging.
+
     if (user_defined_homing(cycle_mask)) {
         return;
     }
@@ -343,8 +1243,9 @@ void mc_homing_cycle(uint8_t cycle_mask) {
     else
 #endif
     {
+        uint8_t merged = 0;  // Parallel axes homed ahead of their own cycle
         for (int cycle = 0; cycle < MAX_N_AXIS; cycle++) {
-            auto homing_mask = homing_cycle[cycle]->get();
+            auto homing_mask = homing_merge_parallel(cycle, homing_cycle[cycle]->get() & ~merged, merged);
             if (homing_mask) {  // if there are some axes in this cycle
                 no_cycles_defined = false;
                 if (!axis_is_squared(homing_mask)) {
@@ -375,6 +1276,8 @@ void mc_homing_cycle(uint8_t cycle_mask) {
     // Sync gcode parser and planner positions to homed position.
     gc_sync_position();
     plan_sync_position();
+    plan_forget_backlash();
+    mc_heightmap_queued = false;  // The homed position has no height offset in it
     // This give kinematics a chance to do something after normal homing
     kinematics_post_homing();
     // If hard limits feature enabled, re-enable hard limits pin change register after homing cycle.
@@ -419,7 +1322,10 @@ GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, uint8_t par
     }
     // Setup and queue probing motion. Auto cycle-start should not start the cycle.
     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Found");
+    mc_probe_motion = true;  // The probe motion must not be height compensated, held back or merged.
     cartesian_to_motors(target, pl_data, gc_state.position);
+    mc_probe_motion = false;
+    mc_flush_merged_line();
     // Activate the probing state monitor in the stepper module.
     sys_probe_state = Probe::Active;
     // Perform probing cycle. Wait here until probe is triggered or motion completes.
@@ -439,7 +1345,7 @@ GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, uint8_t par
     // Set state variables and error out, if the probe failed and cycle with error is enabled.
     if (sys_probe_state == Probe::Active) {
         if (is_no_error) {
-            memcpy(sys_probe_position, sys_position, sizeof(sys_position));
+            st_get_position(sys_probe_position);
         } else {
             sys_rt_exec_alarm = ExecAlarm::ProbeFailContact;
         }
@@ -38,6 +38,22 @@ const int PARKING_MOTION_LINE_NUMBER = 0;
 bool cartesian_to_motors(float* target, plan_line_data_t* pl_data, float* position);
 bool mc_line(float* target, plan_line_data_t* pl_data);  // returns true if line was submitted to planner
 
+// Queues the line that mc_line() holds back while merging colinear segments, or drops it on reset.
+void mc_flush_merged_line();
+void mc_discard_merged_line();
+
+// Small LRU cache of inverse kinematics results for kinematics that opt in. A lookup hits when
+// every axis of the point is within $Kinematics/CacheTolerance of a cached point, so the path
+// error stays within that tolerance. Clear it when the machine geometry changes.
+bool mc_kinematics_cache_lookup(const float* cartesian, float* motors);
+void mc_kinematics_cache_store(const float* cartesian, const float* motors);
+void mc_kinematics_cache_clear();
+
+// Number of segments for kinematics to split a line from start to end into, so that moving the
+// motors straight between the segment ends keeps within $Kinematics/Tolerance of the line.
+// Never fewer than max_segment_len gives, which is all it gives while the tolerance is 0.
+uint32_t mc_kinematics_segment_count(const float* start, const float* end, float max_segment_len);
+
 // Execute an arc in offset mode format. position == current xyz, target == target xyz,
 // offset == offset from current xyz, axis_XXX defines circle plane in tool space, axis_linear is
 // the direction of helical travel, radius == circle radius, is_clockwise_arc boolean. Used
@@ -52,9 +68,48 @@ void mc_arc(float*            target,
             uint8_t           axis_linear,
             uint8_t           is_clockwise_arc);
 
+// mc_arc() returns once the planner is full and queues the rest of the arc from these.
+// mc_continue_arc() queues chords while there is room, mc_finish_arc() queues all of them
+// and mc_discard_arc() drops them on reset.
+void mc_continue_arc();
+void mc_finish_arc();
+void mc_discard_arc();
+
+// Arc fitting. While $Planner/ArcFitTolerance is non-zero, the parser's G1 lines that only
+// move in the arc plane are held back, and runs of chords with their vertices on one circle
+// are queued as one mc_arc(). Everything else goes on to cartesian_to_motors().
+bool mc_fit_line(float* target, plan_line_data_t* pl_data, float* position, uint8_t axis_0, uint8_t axis_1, uint8_t axis_linear);
+
+// Queues the held back lines, as an arc if they fit one, or drops them on reset.
+void mc_flush_fitted_lines();
+void mc_discard_fitted_lines();
+
 // Dwell for a specific number of seconds
 bool mc_dwell(int32_t milliseconds);
 
+// Drill one hole of a canned cycle at target and retract to retract_z, leaving position at the
+// retract height. G83 rapids back down to CANNED_CYCLE_PECK_CLEARANCE above the previous peck
+// and G73 backs off by CANNED_CYCLE_CHIP_BREAK between pecks, both in mm.
+const float CANNED_CYCLE_PECK_CLEARANCE = 0.25;
+const float CANNED_CYCLE_CHIP_BREAK     = 0.25;
+bool mc_canned_cycle(float*                   target,
+                     plan_line_data_t*        pl_data,
+                     float*                   position,
+                     Motion                   cycle,
+                     const gc_canned_cycle_t* params,
+                     float                    retract_z);
+
+#ifdef SPINDLE_SYNC
+// G33 moves to target with pitch mm of Z travel per spindle revolution. G33.1 taps down to target,
+// reverses the spindle, follows it back out to the start and restores the spindle direction. A
+// chain of G33 lines starts on a whole turn of the spindle, within SPINDLE_SYNC_WAIT_MS, and needs
+// the spindle to turn at SPINDLE_SYNC_MIN_RPM or more. Return false if aborted.
+const float   SPINDLE_SYNC_MIN_RPM = 10.0;
+const int32_t SPINDLE_SYNC_WAIT_MS = 10000;
+bool          mc_spindle_sync(float* target, plan_line_data_t* pl_data, float* position, float pitch);
+bool          mc_rigid_tap(float* target, plan_line_data_t* pl_data, float* position, float pitch);
+#endif
+
 // Perform homing cycle to locate machine zero. Requires limit switches.
 void mc_homing_cycle(uint8_t cycle_mask);
 
@@ -74,6 +129,7 @@ enum class SquaringMode : uint8_t {
     Dual,  // both motors run
     A,     // A motor runs
     B,     // B motor runs
+    None,  // neither runs, for $Bench
 };
 
 extern SquaringMode ganged_mode;
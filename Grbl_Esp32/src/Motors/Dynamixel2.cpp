@@ -30,6 +30,9 @@ namespace Motors {
     bool    Motors::Dynamixel2::uart_ready         = false;
     uint8_t Motors::Dynamixel2::ids[MAX_N_AXIS][2] = { { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 } };
 
+    Dynamixel2* Dynamixel2::motors[MAX_N_AXIS][2] = {};
+    Dynamixel2* Dynamixel2::lead                  = NULL;
+
     Dynamixel2::Dynamixel2(uint8_t axis_index, uint8_t id, uint8_t tx_pin, uint8_t rx_pin, uint8_t rts_pin) :
         Servo(axis_index), _id(id), _tx_pin(tx_pin), _rx_pin(rx_pin), _rts_pin(rts_pin) {
         if (_tx_pin == UNDEFINED_PIN || _rx_pin == UNDEFINED_PIN || _rts_pin == UNDEFINED_PIN) {
@@ -54,6 +57,12 @@ namespace Motors {
 
         set_disable(true);                              // turn off torque so we can set EEPROM registers
         set_operating_mode(DXL_CONTROL_MODE_POSITION);  // set it in the right control mode
+        dxl_write(DXL_RETURN_DELAY, 1, 0);              // answer right away, the sync read waits for each servo in turn
+
+        motors[_axis_index][_dual_axis_index] = this;
+        if (lead == NULL) {
+            lead = this;
+        }
 
         // servos will blink in axis order for reference
         LED_on(true);
@@ -116,7 +125,7 @@ namespace Motors {
         _dxl_count_max = DXL_COUNT_MAX;
 
         if (bitnum_istrue(dir_invert_mask->get(), _axis_index))  // normal direction
-            swap(_dxl_count_min, _dxl_count_min);
+            swap(_dxl_count_min, _dxl_count_max);
     }
 
     // sets the PWM to zero. This allows most servos to be manually moved
@@ -136,18 +145,15 @@ namespace Motors {
         dxl_write(DXL_OPERATING_MODE, param_count, mode);
     }
 
+    // The servo task calls this for every servo, but one cycle on the bus serves them all
     void Dynamixel2::update() {
-        if (_has_errors) {
-            return;
-        }
-
-        if (_disabled) {
-            dxl_read_position();
-        } else {
-            dxl_bulk_goal_position();  // call the static method that updates all at once
+        if (this == lead) {
+            dxl_sync_cycle();
         }
     }
 
+    float Dynamixel2::following_error() { return _following_error; }
+
     /*
         Static
 
@@ -345,12 +351,15 @@ namespace Motors {
         tx_message[++msg_index] = 4;                                  // low order data length
         tx_message[++msg_index] = 0;                                  // high order data length
 
-        auto   n_axis = number_axis->get();
-        float* mpos   = system_get_mpos();
+        auto    n_axis = number_axis->get();
+        int32_t position[MAX_N_AXIS];
+        float   mpos[MAX_N_AXIS];
+        setpoint_position(position);
+        system_convert_array_steps_to_mpos(mpos, position);
         for (uint8_t axis = X_AXIS; axis < n_axis; axis++) {
             for (uint8_t gang_index = 0; gang_index < 2; gang_index++) {
-                current_id = ids[axis][gang_index];
-                if (current_id != 0) {
+                if (motors[axis][gang_index] != NULL) {
+                    current_id = motors[axis][gang_index]->_id;
                     count++;  // keep track of the count for the message length
 
                     dxl_count_min = DXL_COUNT_MIN;
@@ -374,6 +383,78 @@ namespace Motors {
         dxl_finish_message(DXL_BROADCAST_ID, tx_message, (count * 5) + 7);
     }
 
+    /*
+        Static
+
+        One bus cycle for all the servos. The Sync Write of the goal positions is not
+        answered, so the Sync Read of the present positions follows right behind it and
+        the servos answer it one after another in the order of their IDs in the request.
+
+        A disabled servo can be moved by hand, so its position becomes the machine position.
+        For the others the following error is how far they are from the steppers.
+    */
+    void Dynamixel2::dxl_sync_cycle() {
+        char    tx_message[DXL_MSG_START + 4 + MAX_N_AXIS * 2 + 2];
+        uint8_t rx_message[DXL_POSITION_RSP_LEN];
+        uint8_t count  = 0;
+        auto    n_axis = number_axis->get();
+
+        dxl_bulk_goal_position();
+
+        tx_message[DXL_MSG_INSTR]     = DXL_SYNC_READ;
+        tx_message[DXL_MSG_START]     = DXL_PRESENT_POSITION & 0xFF;           // low order address
+        tx_message[DXL_MSG_START + 1] = (DXL_PRESENT_POSITION & 0xFF00) >> 8;  // high order address
+        tx_message[DXL_MSG_START + 2] = 4;                                     // low order data length
+        tx_message[DXL_MSG_START + 3] = 0;                                     // high order data length
+        for (uint8_t axis = X_AXIS; axis < n_axis; axis++) {
+            for (uint8_t gang_index = 0; gang_index < 2; gang_index++) {
+                if (motors[axis][gang_index] != NULL) {
+                    tx_message[DXL_MSG_START + 4 + count++] = motors[axis][gang_index]->_id;
+                }
+            }
+        }
+        dxl_finish_message(DXL_BROADCAST_ID, tx_message, count + 7);
+
+        int32_t stepper_position[MAX_N_AXIS];
+        st_get_position(stepper_position);
+
+        bool moved = false;
+        for (uint8_t reply = 0; reply < count; reply++) {
+            if (uart_read_bytes(UART_NUM_2, rx_message, DXL_POSITION_RSP_LEN, DXL_RESPONSE_WAIT_TICKS) != DXL_POSITION_RSP_LEN) {
+                break;  // a servo did not answer, so the rest of the stream cannot be trusted
+            }
+            if (rx_message[DXL_MSG_INSTR] != DXL_STATUS || rx_message[DXL_MSG_START] != 0) {
+                continue;  // the servo reported an error
+            }
+
+            for (uint8_t axis = X_AXIS; axis < n_axis; axis++) {
+                for (uint8_t gang_index = 0; gang_index < 2; gang_index++) {
+                    Dynamixel2* m = motors[axis][gang_index];
+                    if (m == NULL || m->_id != rx_message[DXL_MSG_ID]) {
+                        continue;
+                    }
+
+                    uint32_t dxl_position = rx_message[9] | (rx_message[10] << 8) | (rx_message[11] << 16) | (rx_message[12] << 24);
+                    float    mpos =
+                        map_float(dxl_position, m->_dxl_count_min, m->_dxl_count_max, limitsMinPosition(axis), limitsMaxPosition(axis));
+                    float steps_per_mm = axis_settings[axis]->steps_per_mm->get();
+
+                    if (m->_disabled) {
+                        sys_position[axis]  = lroundf(mpos * steps_per_mm);
+                        m->_following_error = 0.0;
+                        moved               = true;
+                    } else {
+                        m->_following_error = stepper_position[axis] / steps_per_mm - mpos;
+                    }
+                }
+            }
+        }
+
+        if (moved) {
+            plan_sync_position();
+        }
+    }
+
     /*
     Static
 
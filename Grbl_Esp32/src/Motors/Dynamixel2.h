@@ -21,8 +21,12 @@
     along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-const int DYNAMIXEL_BUF_SIZE  = 127;
-const int DYNAMIXEL_BAUD_RATE = 1000000;
+const int DYNAMIXEL_BUF_SIZE = 127;
+
+// The servos must be set to the same baud rate with the Dynamixel software
+#ifndef DYNAMIXEL_BAUD_RATE
+#    define DYNAMIXEL_BAUD_RATE 1000000
+#endif
 
 const int DXL_RESPONSE_WAIT_TICKS = 20;  // how long to wait for a response
 
@@ -44,9 +48,14 @@ const int DXL_INSTR_PING = 0x01;
 const int PING_RSP_LEN   = 14;
 const int DXL_READ       = 0x02;
 const int DXL_WRITE      = 0x03;
+const int DXL_SYNC_READ  = 0x82;
 const int DXL_SYNC_WRITE = 0x83;
+const int DXL_STATUS     = 0x55;  // instruction byte of a status packet
+
+const int DXL_POSITION_RSP_LEN = 15;  // status packet with a 4 byte position
 
 // protocol 2 register locations
+const int DXL_RETURN_DELAY     = 9;  // in 2us units, 250 from the factory
 const int DXL_OPERATING_MODE   = 11;
 const int DXL_ADDR_TORQUE_EN   = 64;
 const int DXL_ADDR_LED_ON      = 65;
@@ -82,7 +91,8 @@ namespace Motors {
         void read_settings() override;
         bool set_homing_mode(bool isHoming) override;
         void set_disable(bool disable) override;
-        void update() override;
+        void  update() override;
+        float following_error() override;
 
         static bool    uart_ready;
         static uint8_t ids[MAX_N_AXIS][2];
@@ -110,6 +120,11 @@ namespace Motors {
         static void     dxl_finish_message(uint8_t id, char* msg, uint16_t msg_len);
         static uint16_t dxl_update_crc(uint16_t crc_accum, char* data_blk_ptr, uint8_t data_blk_size);
         static void     dxl_bulk_goal_position();  // set all motorsd init_uart(uint8_t id, uint8_t axis_index, uint8_t dual_axis_index);
+        static void     dxl_sync_cycle();          // goal positions out, present positions in
+
+        // The servos that answered the ping. The first one to init runs the bus for all of them.
+        static Dynamixel2* motors[MAX_N_AXIS][2];
+        static Dynamixel2* lead;
 
         float _homing_position;
 
@@ -121,7 +136,8 @@ namespace Motors {
         uint8_t     _rts_pin;
         uart_port_t _uart_num;
 
-        bool _disabled;
-        bool _has_errors;
+        bool  _disabled;
+        bool  _has_errors;
+        float _following_error = 0.0;  // mm from the stepper position to the present position
     };
 }
@@ -33,6 +33,14 @@
 
 #include <cstdint>
 
+// Bits to set and clear in the GPIO output registers, GPIOs 0-31 and 32-33
+struct GpioStepBits {
+    uint32_t set;
+    uint32_t clear;
+    uint32_t set1;
+    uint32_t clear1;
+};
+
 namespace Motors {
     class Motor {
     public:
@@ -83,6 +91,27 @@ namespace Motors {
         // states of the step pins are unknown.
         virtual void unstep() {}
 
+        // step_batch() loads a train of step pulses for USE_RMT_BATCH_STEPS.
+        // step_masks holds the axis step mask of each of count step events,
+        // which are tick_period RMT ticks apart. Motors that cannot time
+        // their own pulses ignore it.
+        virtual void step_batch(const uint8_t* step_masks, uint8_t count, uint32_t tick_period) {}
+
+        // gpio_step_pin() gives the step pin of a motor whose step() and
+        // unstep() do nothing but set that GPIO, or UNDEFINED_PIN for a
+        // motor that does not step at all. motors_step() then drives the
+        // pins of all such motors with one register write instead of
+        // calling them. It returns false for any other motor.
+        virtual bool gpio_step_pin(uint8_t& pin, bool& invert) { return false; }
+
+        // gpio_phases() is true for a motor that steps by switching
+        // its coil GPIOs through a pattern. motors_step() then calls
+        // step_phases() instead of step(), which advances the pattern
+        // and adds the pins that change to bits, and writes them
+        // together with the step pins of all other motors.
+        virtual bool gpio_phases() { return false; }
+        virtual void step_phases(GpioStepBits& bits) {}
+
         // test(), called from init(), checks to see if a motor is
         // responsive, returning true on failure.  Typical
         // implementations also display messages to show the result.
@@ -94,6 +123,10 @@ namespace Motors {
         // called from a periodic task.
         virtual void update() {}
 
+        // following_error() is how far, in mm, a motor with position
+        // feedback is behind the position the steppers have reached.
+        virtual float following_error() { return 0.0; }
+
     protected:
         // config_message(), called from init(), displays a message describing
         // the motor configuration - pins and other motor-specific items
@@ -43,7 +43,52 @@
 #include "TrinamicDriver.h"
 #include "TrinamicUartDriver.h"
 
+#include <soc/gpio_struct.h>
+
 Motors::Motor* myMotor[MAX_AXES][MAX_GANGED];  // number of axes (normal and ganged)
+
+static PinHandle steppers_disable;  // STEPPERS_DISABLE_PIN
+
+// The step pins of the motors that report them with gpio_step_pin(), as the bits that step()
+// sets and clears in the GPIO output registers. Motors that switch coil patterns instead are
+// in phase_motors, and the rest are in called_motors and are stepped through their methods.
+static GpioStepBits gpio_step_bits[MAX_AXES][MAX_GANGED];
+static GpioStepBits gpio_unstep_bits;
+static uint8_t      phase_motors[MAX_GANGED];   // Axis mask of each gang
+static uint8_t      called_motors[MAX_GANGED];  // Axis mask of each gang
+
+static void motors_build_step_bits() {
+    memset(gpio_step_bits, 0, sizeof(gpio_step_bits));
+    memset(&gpio_unstep_bits, 0, sizeof(gpio_unstep_bits));
+    auto n_axis = number_axis->get();
+    for (uint8_t gang_index = 0; gang_index < MAX_GANGED; gang_index++) {
+        phase_motors[gang_index]  = 0;
+        called_motors[gang_index] = 0;
+        for (uint8_t axis = X_AXIS; axis < n_axis; axis++) {
+            uint8_t pin;
+            bool    invert;
+            if (myMotor[axis][gang_index]->gpio_phases()) {
+                bitnum_true(phase_motors[gang_index], axis);
+                continue;
+            }
+            if (!myMotor[axis][gang_index]->gpio_step_pin(pin, invert)) {
+                bitnum_true(called_motors[gang_index], axis);
+                continue;
+            }
+            if (pin == UNDEFINED_PIN) {
+                continue;
+            }
+            GpioStepBits& bits = gpio_step_bits[axis][gang_index];
+            uint32_t      mask = 1u << (pin % 32);
+            uint32_t&     on   = pin < 32 ? (invert ? bits.clear : bits.set) : (invert ? bits.clear1 : bits.set1);
+            uint32_t&     off  = pin < 32 ? (invert ? gpio_unstep_bits.set : gpio_unstep_bits.clear)
+                                          : (invert ? gpio_unstep_bits.set1 : gpio_unstep_bits.clear1);
+            on |= mask;
+            off |= mask;
+        }
+    }
+}
+
 void           init_motors() {
     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Init Motors");
 
@@ -400,6 +445,7 @@ void           init_motors() {
 
     if (STEPPERS_DISABLE_PIN != UNDEFINED_PIN) {
         pinMode(STEPPERS_DISABLE_PIN, OUTPUT);  // global motor enable pin
+        steppers_disable = PinHandle(STEPPERS_DISABLE_PIN);
         grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Global stepper disable pin:%s", pinName(STEPPERS_DISABLE_PIN));
     }
 
@@ -409,6 +455,7 @@ void           init_motors() {
             myMotor[axis][gang_index]->init();
         }
     }
+    motors_build_step_bits();
 }
 
 void motors_set_disable(bool disable, uint8_t mask) {
@@ -437,7 +484,7 @@ void motors_set_disable(bool disable, uint8_t mask) {
     }
 
     // global disable.
-    digitalWrite(STEPPERS_DISABLE_PIN, disable);
+    steppers_disable.write(disable);
 
     // Add an optional delay for stepper drivers. that need time
     // Some need time after the enable before they can step.
@@ -459,6 +506,18 @@ void motors_read_settings() {
             myMotor[axis][gang_index]->read_settings();
         }
     }
+    motors_build_step_bits();  // The step invert mask may have changed
+}
+
+void motors_get_following_error(float* error) {
+    auto n_axis = number_axis->get();
+    for (uint8_t axis = X_AXIS; axis < n_axis; axis++) {
+        error[axis]  = myMotor[axis][0]->following_error();
+        float ganged = myMotor[axis][1]->following_error();
+        if (fabsf(ganged) > fabsf(error[axis])) {
+            error[axis] = ganged;
+        }
+    }
 }
 
 // use this to tell all the motors what the current homing mode is
@@ -500,26 +559,76 @@ bool motors_direction(uint8_t dir_mask) {
 }
 
 void motors_step(uint8_t step_mask) {
-    auto n_axis = number_axis->get();
-    //grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "motors_set_direction_pins:0x%02X", onMask);
+    // Turn on step pulses for motors that are supposed to step now. The GPIO step pins and
+    // the unipolar coils all change at once, in at most four register writes.
+    GpioStepBits bits = {};
+    for (uint8_t gang_index = 0; gang_index < MAX_GANGED; gang_index++) {
+        if (ganged_mode != SquaringMode::Dual && ganged_mode != (gang_index ? SquaringMode::B : SquaringMode::A)) {
+            continue;
+        }
+        for (uint8_t axes = step_mask; axes;) {
+            uint8_t axis = __builtin_ctz(axes);
+            axes &= axes - 1;
+            bits.set |= gpio_step_bits[axis][gang_index].set;
+            bits.clear |= gpio_step_bits[axis][gang_index].clear;
+            bits.set1 |= gpio_step_bits[axis][gang_index].set1;
+            bits.clear1 |= gpio_step_bits[axis][gang_index].clear1;
+        }
+        for (uint8_t axes = step_mask & phase_motors[gang_index]; axes;) {
+            uint8_t axis = __builtin_ctz(axes);
+            axes &= axes - 1;
+            myMotor[axis][gang_index]->step_phases(bits);
+        }
+        for (uint8_t axes = step_mask & called_motors[gang_index]; axes;) {
+            uint8_t axis = __builtin_ctz(axes);
+            axes &= axes - 1;
+            myMotor[axis][gang_index]->step();
+        }
+    }
+    if (bits.set) {
+        GPIO.out_w1ts = bits.set;
+    }
+    if (bits.clear) {
+        GPIO.out_w1tc = bits.clear;
+    }
+    if (bits.set1) {
+        GPIO.out1_w1ts.val = bits.set1;
+    }
+    if (bits.clear1) {
+        GPIO.out1_w1tc.val = bits.clear1;
+    }
+}
+// Load a train of step pulses into the motors of every axis that steps in it
+void motors_step_batch(const uint8_t* step_masks, uint8_t count, uint32_t tick_period) {
+    auto    n_axis     = number_axis->get();
+    uint8_t batch_mask = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        batch_mask |= step_masks[i];
+    }
 
-    // Turn on step pulses for motors that are supposed to step now
     for (uint8_t axis = X_AXIS; axis < n_axis; axis++) {
-        if (bitnum_istrue(step_mask, axis)) {
+        if (bitnum_istrue(batch_mask, axis)) {
             if ((ganged_mode == SquaringMode::Dual) || (ganged_mode == SquaringMode::A)) {
-                myMotor[axis][0]->step();
+                myMotor[axis][0]->step_batch(step_masks, count, tick_period);
             }
             if ((ganged_mode == SquaringMode::Dual) || (ganged_mode == SquaringMode::B)) {
-                myMotor[axis][1]->step();
+                myMotor[axis][1]->step_batch(step_masks, count, tick_period);
             }
         }
     }
 }
+
 // Turn all stepper pins off
 void motors_unstep() {
-    auto n_axis = number_axis->get();
-    for (uint8_t axis = X_AXIS; axis < n_axis; axis++) {
-        myMotor[axis][0]->unstep();
-        myMotor[axis][1]->unstep();
+    GPIO.out_w1tc      = gpio_unstep_bits.clear;
+    GPIO.out_w1ts      = gpio_unstep_bits.set;
+    GPIO.out1_w1tc.val = gpio_unstep_bits.clear1;
+    GPIO.out1_w1ts.val = gpio_unstep_bits.set1;
+    for (uint8_t gang_index = 0; gang_index < MAX_GANGED; gang_index++) {
+        for (uint8_t axes = called_motors[gang_index]; axes;) {
+            uint8_t axis = __builtin_ctz(axes);
+            axes &= axes - 1;
+            myMotor[axis][gang_index]->unstep();
+        }
     }
 }
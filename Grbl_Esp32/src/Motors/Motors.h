@@ -43,5 +43,7 @@ void    motors_set_disable(bool disable, uint8_t mask = B11111111);  // default
 bool    motors_direction(uint8_t dir_mask);
 void    motors_step(uint8_t step_mask);
 void    motors_unstep();
+void    motors_step_batch(const uint8_t* step_masks, uint8_t count, uint32_t tick_period);
+void    motors_get_following_error(float* error);  // per axis, the largest of its motors
 
 void servoUpdateTask(void* pvParameters);
@@ -7,5 +7,9 @@ namespace Motors {
     public:
         Nullmotor(uint8_t axis_index);
         bool set_homing_mode(bool isHoming) { return false; }
+        bool gpio_step_pin(uint8_t& pin, bool& invert) override {
+            pin = UNDEFINED_PIN;
+            return true;
+        }
     };
 }
@@ -39,16 +39,18 @@ namespace Motors {
         List = this;
     }
 
+    void Servo::setpoint_position(int32_t* position) { st_get_lookahead_position(position, uint32_t(SERVO_LOOKAHEAD_MS * 1000)); }
+
     void Servo::startUpdateTask() {
         grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Servo Update Task Started");
         if (this == List) {
-            xTaskCreatePinnedToCore(updateTask,         // task
-                                    "servoUpdateTask",  // name for task
-                                    4096,               // size of task stack
-                                    NULL,               // parameters
-                                    1,                  // priority
-                                    NULL,               // handle
-                                    SUPPORT_TASK_CORE   // core
+            heap_task_create(updateTask,         // task
+                             "servoUpdateTask",  // name for task
+                             4096,               // size of task stack
+                             NULL,               // parameters
+                             1,                  // priority
+                             NULL,               // handle
+                             SUPPORT_TASK_CORE   // core
             );
         }
     }
@@ -56,7 +58,6 @@ namespace Motors {
     void Servo::updateTask(void* pvParameters) {
         TickType_t       xLastWakeTime;
         const TickType_t xUpdate = SERVO_TIMER_INTERVAL;  // in ticks (typically ms)
-        auto             n_axis  = number_axis->get();
 
         xLastWakeTime = xTaskGetTickCount();  // Initialise the xLastWakeTime variable with the current time.
         vTaskDelay(2000);                     // initial delay
@@ -39,6 +39,11 @@ namespace Motors {
         virtual void update() = 0;  // This must be implemented by derived classes
 
     protected:
+        // The machine position in steps to command the servos to now. It is taken
+        // SERVO_LOOKAHEAD_MS ahead along the queued step segments, so the servos
+        // follow the motion instead of chasing it one update interval behind.
+        static void setpoint_position(int32_t* position);
+
         // Start the servo update task.  Each derived subclass instance calls this
         // during init(), which happens after all objects have been constructed.
         // startUpdateTask() ignores all such calls except for the last one, where
@@ -57,6 +57,8 @@ namespace Motors {
         _invert_step_pin = bitnum_istrue(step_invert_mask->get(), _axis_index);
         _invert_dir_pin  = bitnum_istrue(dir_invert_mask->get(), _axis_index);
         pinMode(_dir_pin, OUTPUT);
+        _dir_handle     = PinHandle(_dir_pin);
+        _disable_handle = PinHandle(_disable_pin);
 
 #ifdef USE_RMT_STEPS
         rmtConfig.rmt_mode                       = RMT_MODE_TX;
@@ -90,6 +92,7 @@ namespace Motors {
 
 #else
         pinMode(_step_pin, OUTPUT);
+        _step_handle = PinHandle(_step_pin);
 
 #endif  // USE_RMT_STEPS
         pinMode(_disable_pin, OUTPUT);
@@ -111,19 +114,65 @@ namespace Motors {
         RMT.conf_ch[_rmt_chan_num].conf1.mem_rd_rst = 1;
         RMT.conf_ch[_rmt_chan_num].conf1.tx_start   = 1;
 #else
-        digitalWrite(_step_pin, !_invert_step_pin);
+        _step_handle.write(!_invert_step_pin);
 #endif  // USE_RMT_STEPS
     }
 
+    // Writes one RMT item per step of this axis straight into the channel memory,
+    // then starts the transmission. The idle half of each item spans the time
+    // since the end of the previous pulse; the first pulse follows the direction
+    // delay, as with a single step.
+    void StandardStepper::step_batch(const uint8_t* step_masks, uint8_t count, uint32_t tick_period) {
+#ifdef USE_RMT_BATCH_STEPS
+        if (_rmt_chan_num == RMT_CHANNEL_MAX) {
+            return;
+        }
+        volatile rmt_item32_t* item     = &RMTMEM.chan[_rmt_chan_num].data32[0];
+        uint32_t               pulse    = rmtItem[0].duration1;
+        uint32_t               idle     = rmtItem[0].duration0;
+        uint32_t               gap      = tick_period > pulse ? tick_period - pulse : 1;
+        uint32_t               inactive = _invert_step_pin ? 1 : 0;
+        for (uint8_t i = 0; i < count; i++) {
+            if (bitnum_istrue(step_masks[i], _axis_index)) {
+                rmt_item32_t pulse_item;
+                pulse_item.level0    = inactive;
+                pulse_item.duration0 = idle;
+                pulse_item.level1    = !inactive;
+                pulse_item.duration1 = pulse;
+                (item++)->val        = pulse_item.val;
+                idle                 = gap;
+            } else {
+                idle += tick_period;
+            }
+        }
+        item->val = 0;  // End marker
+
+        RMT.conf_ch[_rmt_chan_num].conf1.mem_rd_rst = 1;
+        RMT.conf_ch[_rmt_chan_num].conf1.tx_start   = 1;
+#endif  // USE_RMT_BATCH_STEPS
+    }
+
     void StandardStepper::unstep() {
 #ifndef USE_RMT_STEPS
-        digitalWrite(_step_pin, _invert_step_pin);
+        _step_handle.write(_invert_step_pin);
 #endif  // USE_RMT_STEPS
     }
 
-    void StandardStepper::set_direction(bool dir) { digitalWrite(_dir_pin, dir ^ _invert_dir_pin); }
-
-    void StandardStepper::set_disable(bool disable) {
-        digitalWrite(_disable_pin, disable);
+    // RMT and I2S steps are not GPIO writes. GPIOs above 33 are inputs only.
+    bool StandardStepper::gpio_step_pin(uint8_t& pin, bool& invert) {
+#ifdef USE_RMT_STEPS
+        return false;
+#else
+        if (_step_pin != UNDEFINED_PIN && _step_pin > 33) {
+            return false;
+        }
+        pin    = _step_pin;
+        invert = _invert_step_pin;
+        return true;
+#endif  // USE_RMT_STEPS
     }
+
+    void StandardStepper::set_direction(bool dir) { _dir_handle.write(dir ^ _invert_dir_pin); }
+
+    void StandardStepper::set_disable(bool disable) { _disable_handle.write(disable); }
 }
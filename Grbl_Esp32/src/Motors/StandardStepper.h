@@ -15,6 +15,8 @@ namespace Motors {
         void set_direction(bool) override;
         void step() override;
         void unstep() override;
+        void step_batch(const uint8_t* step_masks, uint8_t count, uint32_t tick_period) override;
+        bool gpio_step_pin(uint8_t& pin, bool& invert) override;
         void read_settings() override;
 
         void init_step_dir_pins();
@@ -31,6 +33,11 @@ namespace Motors {
         uint8_t _dir_pin;
         uint8_t _disable_pin;
 
+        // Resolved by init_step_dir_pins()
+        PinHandle _step_handle;
+        PinHandle _dir_handle;
+        PinHandle _disable_handle;
+
     private:
         static rmt_channel_t get_next_RMT_chan_num();
         static rmt_item32_t  rmtItem[2];
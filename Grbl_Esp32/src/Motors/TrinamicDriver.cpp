@@ -31,10 +31,17 @@ void TMC2130Stepper::switchCSpin(bool state) {
 #endif
 
 namespace Motors {
+    const uint8_t TMC_REG_TSTEP      = 0x12;
+    const uint8_t TMC_REG_DRV_STATUS = 0x6F;
+    const size_t  TMC_FRAME_BYTES    = 5;  // Address or status, then 32 data bits
+
+#ifdef TRINAMIC_DAISY_CHAIN
+    uint8_t TrinamicDriver::chain_length = 0;
+#endif
+
     uint8_t TrinamicDriver::get_next_index() {
 #ifdef TRINAMIC_DAISY_CHAIN
-        static uint8_t index = 1;  // they start at 1
-        return index++;
+        return ++chain_length;  // they start at 1
 #else
         return -1;
 #endif
@@ -108,14 +115,14 @@ namespace Motors {
         // After initializing all of the TMC drivers, create a task to
         // display StallGuard data.  List == this for the final instance.
         if (List == this) {
-            xTaskCreatePinnedToCore(readSgTask,    // task
-                                    "readSgTask",  // name for task
-                                    4096,          // size of task stack
-                                    NULL,          // parameters
-                                    1,             // priority
-                                    NULL,
-                                    SUPPORT_TASK_CORE  // must run the task on same core
-                                                       // core
+            heap_task_create(readSgTask,    // task
+                             "readSgTask",  // name for task
+                             4096,          // size of task stack
+                             NULL,          // parameters
+                             1,             // priority
+                             NULL,
+                             SUPPORT_TASK_CORE  // must run the task on same core
+                                                // core
             );
         }
     }
@@ -241,6 +248,17 @@ namespace Motors {
                 //grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "StealthChop");
                 tmcstepper->en_pwm_mode(true);
                 tmcstepper->pwm_autoscale(true);
+                tmcstepper->TPWMTHRS(0);  // At all speeds, after Hybrid
+                tmcstepper->diag1_stall(false);
+                break;
+            case TrinamicMode ::Hybrid:
+                // The driver leaves StealthChop once TSTEP drops below TPWMTHRS, and goes back
+                // as it slows down. It switches by itself, with no SPI traffic during motion.
+                tmcstepper->en_pwm_mode(true);
+                tmcstepper->pwm_autoscale(true);
+                tmcstepper->TPWMTHRS(calc_tstep(TRINAMIC_HYBRID_RATE, 100.0));
+                tmcstepper->TCOOLTHRS(NORMAL_TCOOLTHRS);  // when to turn on coolstep
+                tmcstepper->THIGH(NORMAL_THIGH);
                 tmcstepper->diag1_stall(false);
                 break;
             case TrinamicMode ::CoolStep:
@@ -273,24 +291,30 @@ namespace Motors {
             return;
         }
         uint32_t tstep = tmcstepper->TSTEP();
+        report_stallguard(tstep, tstep == 0xFFFFF || tstep < 1 ? 0 : tmcstepper->DRV_STATUS());
+    }
 
+    void TrinamicDriver::report_stallguard(uint32_t tstep, uint32_t drv_status) {
+        if (_has_errors) {
+            return;
+        }
         if (tstep == 0xFFFFF || tstep < 1) {  // if axis is not moving return
             return;
         }
         float feedrate = st_get_realtime_rate();  //* settings.microsteps[axis_index] / 60.0 ; // convert mm/min to Hz
 
+        TMC2130_n ::DRV_STATUS_t status { 0 };  // a useful struct to access the bits.
+        status.sr = drv_status;
+
         grbl_msg_sendf(CLIENT_SERIAL,
                        MsgLevel::Info,
                        "%s Stallguard %d   SG_Val: %04d   Rate: %05.0f mm/min SG_Setting:%d",
                        reportAxisNameMsg(_axis_index, _dual_axis_index),
-                       tmcstepper->stallguard(),
-                       tmcstepper->sg_result(),
+                       status.stallGuard,
+                       status.sg_result,
                        feedrate,
                        constrain(axis_settings[_axis_index]->stallguard->get(), -64, 63));
 
-        TMC2130_n ::DRV_STATUS_t status { 0 };  // a useful struct to access the bits.
-        status.sr = tmcstepper->DRV_STATUS();
-
         // these only report if there is a fault condition
         report_open_load(status);
         report_short_to_ground(status);
@@ -347,26 +371,68 @@ namespace Motors {
         // This would be for individual motors, not the single pin for all motors.
     }
 
-    // Prints StallGuard data that is useful for tuning.
+    // Checks the drivers of $StallGuard/Monitor for stalls every $StallGuard/Period ms while
+    // the machine runs a cycle or jogs, and prints StallGuard data that is useful for tuning.
     void TrinamicDriver::readSgTask(void* pvParameters) {
         TickType_t       xLastWakeTime;
         const TickType_t xreadSg = 200;  // in ticks (typically ms)
-        auto             n_axis  = number_axis->get();
+        TickType_t       xLastReport;
 
         xLastWakeTime = xTaskGetTickCount();  // Initialise the xLastWakeTime variable with the current time.
-        while (true) {                        // don't ever return from this or the task dies
-            if (stallguard_debug_mask->get() != 0) {
-                if (sys.state == State::Cycle || sys.state == State::Homing || sys.state == State::Jog) {
-                    for (TrinamicDriver* p = List; p; p = p->link) {
-                        if (bitnum_istrue(stallguard_debug_mask->get(), p->_axis_index)) {
-                            //grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "SG:%d", stallguard_debug_mask->get());
-                            p->debug_message();
-                        }
+        xLastReport   = xLastWakeTime;
+        while (true) {  // don't ever return from this or the task dies
+            uint8_t monitor_mask = stallguard_monitor_mask->get();
+            bool    report       = stallguard_debug_mask->get() != 0 && xLastWakeTime - xLastReport >= xreadSg;
+            bool    running      = sys.state == State::Cycle || sys.state == State::Jog;
+            if (report) {
+                xLastReport = xLastWakeTime;
+            }
+            if ((report && (running || sys.state == State::Homing)) || (monitor_mask && running)) {
+#ifdef TRINAMIC_DAISY_CHAIN
+                // Two chain reads for all drivers, instead of up to four transactions per driver
+                uint32_t tstep[MAX_N_AXIS * MAX_GANGED], drv_status[MAX_N_AXIS * MAX_GANGED];
+                read_chain(TMC_REG_TSTEP, tstep);
+                read_chain(TMC_REG_DRV_STATUS, drv_status);
+#endif
+                for (TrinamicDriver* p = List; p; p = p->link) {
+                    bool monitored = running && bitnum_istrue(monitor_mask, p->_axis_index) && !p->_has_errors;
+                    bool reported  = report && bitnum_istrue(stallguard_debug_mask->get(), p->_axis_index);
+                    if (!monitored && !reported) {
+                        continue;
+                    }
+#ifdef TRINAMIC_DAISY_CHAIN
+                    uint32_t status = drv_status[p->_spi_index - 1];
+                    if (reported) {
+                        p->report_stallguard(tstep[p->_spi_index - 1], status);
+                    }
+#else
+                    uint32_t status = monitored ? p->tmcstepper->DRV_STATUS() : 0;
+                    if (reported) {
+                        p->debug_message();
+                    }
+#endif
+                    if (monitored && p->stalled(status)) {
+                        TMC2130_n ::DRV_STATUS_t bits { 0 };
+                        bits.sr = status;
+                        grbl_msg_sendf(CLIENT_ALL,
+                                       MsgLevel::Error,
+                                       "%s Stall detected SG_Val: %d Average: %d",
+                                       reportAxisNameMsg(p->_axis_index, p->_dual_axis_index),
+                                       bits.sg_result,
+                                       p->_sg_average / TRINAMIC_SG_AVERAGE);
+                        mc_reset();
+                        sys_rt_exec_alarm = ExecAlarm::MotorStall;
+                        break;
                     }
-                }  // sys.state
-            }      // if mask
+                }
+            }
+            if (!running) {
+                for (TrinamicDriver* p = List; p; p = p->link) {
+                    p->_sg_samples = 0;
+                }
+            }
 
-            vTaskDelayUntil(&xLastWakeTime, xreadSg);
+            vTaskDelayUntil(&xLastWakeTime, monitor_mask ? stallguard_monitor_period->get() : xreadSg);
 
             static UBaseType_t uxHighWaterMark = 0;
 #ifdef DEBUG_TASK_STACK
@@ -375,6 +441,69 @@ namespace Motors {
         }
     }
 
+    // SG_RESULT is a measure of the load, lower when it is higher, that only means something in
+    // SpreadCycle above the CoolStep threshold speed, and that changes with the speed. So the
+    // threshold comes from the readings of the motion itself, relearned after every standstill.
+    bool TrinamicDriver::stalled(uint32_t drv_status) {
+        TMC2130_n ::DRV_STATUS_t status { 0 };
+        status.sr = drv_status;
+        bool stealth = _mode == TrinamicMode::StealthChop ||
+                       (_mode == TrinamicMode::Hybrid && st_get_realtime_rate() < TRINAMIC_HYBRID_RATE);
+        if (stealth || status.stst) {
+            _sg_samples = 0;
+            return false;
+        }
+        uint32_t sg = status.sg_result * TRINAMIC_SG_AVERAGE;
+        if (_sg_samples < TRINAMIC_SG_LEARN_SAMPLES) {
+            _sg_average = _sg_samples ? (_sg_average * _sg_samples + sg) / (_sg_samples + 1) : sg;
+            _sg_samples++;
+            _sg_low = 0;
+            return false;
+        }
+        if (sg * 100 < _sg_average * stallguard_monitor_drop->get()) {
+            return ++_sg_low >= TRINAMIC_SG_LOW_SAMPLES;
+        }
+        _sg_low = 0;
+        _sg_average += (int32_t(sg) - int32_t(_sg_average)) / TRINAMIC_SG_AVERAGE;
+        return false;
+    }
+
+#ifdef TRINAMIC_DAISY_CHAIN
+    static void chain_select(uint8_t cs_pin, bool state) {
+        digitalWrite(cs_pin, state);
+#    ifdef USE_I2S_OUT
+        i2s_out_delay();  // As in switchCSpin()
+#    endif
+    }
+
+    // Each driver passes on what it holds as the next frame comes in, so the first frame sent
+    // ends up in the last driver, and the first one received comes from it. The first transfer
+    // gives every driver the address to read, and the second shifts the data of all of them out.
+    // A full chain is 60 bytes, which the SPI hardware sends from its buffer in one go.
+    void TrinamicDriver::read_chain(uint8_t reg, uint32_t* values) {
+        uint8_t frames[MAX_N_AXIS * MAX_GANGED * TMC_FRAME_BYTES];
+        size_t  length = chain_length * TMC_FRAME_BYTES;
+        uint8_t cs_pin = List->_cs_pin;  // Shared by the chain
+
+        SPI.beginTransaction(SPISettings(cs_pin >= I2S_OUT_PIN_BASE ? TRINAMIC_SPI_FREQ : TRINAMIC_CHAIN_SPI_FREQ, MSBFIRST, SPI_MODE3));
+        for (int pass = 0; pass < 2; pass++) {
+            memset(frames, 0, length);
+            for (size_t frame = 0; frame < length; frame += TMC_FRAME_BYTES) {
+                frames[frame] = reg;
+            }
+            chain_select(cs_pin, LOW);
+            SPI.transferBytes(frames, frames, length);
+            chain_select(cs_pin, HIGH);
+        }
+        SPI.endTransaction();
+
+        for (uint8_t frame = 0; frame < chain_length; frame++) {
+            const uint8_t* data              = &frames[frame * TMC_FRAME_BYTES + 1];
+            values[chain_length - frame - 1] = (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | data[3];
+        }
+    }
+#endif
+
     // =========== Reporting functions ========================
 
     bool TrinamicDriver::report_open_load(TMC2130_n ::DRV_STATUS_t status) {
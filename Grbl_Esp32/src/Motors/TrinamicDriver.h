@@ -34,7 +34,8 @@ const float TMC5160_RSENSE_DEFAULT = 0.075f;
 const int NORMAL_TCOOLTHRS = 0xFFFFF;  // 20 bit is max
 const int NORMAL_THIGH     = 0;
 
-const int TRINAMIC_SPI_FREQ = 100000;
+const int TRINAMIC_SPI_FREQ       = 100000;
+const int TRINAMIC_CHAIN_SPI_FREQ = 2000000;  // The TMCStepper default, for read_chain()
 
 const double TRINAMIC_FCLK = 12700000.0;  // Internal clock Approx (Hz) used to calculate TSTEP from homing rate
 
@@ -60,6 +61,26 @@ const double TRINAMIC_FCLK = 12700000.0;  // Internal clock Approx (Hz) used to
 #    define TRINAMIC_TOFF_COOLSTEP 3
 #endif
 
+// TrinamicMode::Hybrid runs StealthChop below this rate in mm/min and SpreadCycle with CoolStep above
+#ifndef TRINAMIC_HYBRID_RATE
+#    define TRINAMIC_HYBRID_RATE 1000.0
+#endif
+
+// The StallGuard monitor learns the SG_RESULT of each motor over the first samples of a
+// motion, then follows it with a running average of 1/TRINAMIC_SG_AVERAGE weight. A stall is
+// TRINAMIC_SG_LOW_SAMPLES samples in a row below $StallGuard/Drop percent of that average.
+#ifndef TRINAMIC_SG_LEARN_SAMPLES
+#    define TRINAMIC_SG_LEARN_SAMPLES 8
+#endif
+
+#ifndef TRINAMIC_SG_AVERAGE
+#    define TRINAMIC_SG_AVERAGE 16
+#endif
+
+#ifndef TRINAMIC_SG_LOW_SAMPLES
+#    define TRINAMIC_SG_LOW_SAMPLES 3
+#endif
+
 namespace Motors {
 
     enum class TrinamicMode : uint8_t {
@@ -67,6 +88,7 @@ namespace Motors {
         StealthChop = 1,
         CoolStep    = 2,
         StallGuard  = 3,
+        Hybrid      = 4,  // StealthChop when slow, CoolStep when fast
     };
 
     class TrinamicDriver : public StandardStepper {
@@ -122,12 +144,28 @@ namespace Motors {
 
         uint8_t get_next_index();
 
+        void report_stallguard(uint32_t tstep, uint32_t drv_status);
+        bool stalled(uint32_t drv_status);
+
+        // StallGuard monitor state, see stalled()
+        uint32_t _sg_average = 0;  // Running average of SG_RESULT, times TRINAMIC_SG_AVERAGE
+        uint8_t  _sg_samples = 0;  // Samples learned since the motor started
+        uint8_t  _sg_low     = 0;  // Samples in a row below the threshold
+
         // Linked list of Trinamic driver instances, used by the
         // StallGuard reporting task.
         static TrinamicDriver* List;
         TrinamicDriver*        link;
         static void            readSgTask(void*);
 
+#ifdef TRINAMIC_DAISY_CHAIN
+        // A register of every driver on the chain is read with one frame
+        // that is shifted through all of them, rather than a transaction
+        // per driver. values[] is indexed by _spi_index - 1.
+        static uint8_t chain_length;
+        static void    read_chain(uint8_t reg, uint32_t* values);
+#endif
+
     protected:
         void config_message() override;
     };
@@ -52,6 +52,16 @@ const double TRINAMIC_UART_FCLK = 12700000.0;  // Internal clock Approx (Hz) use
 #    define TRINAMIC_UART_TOFF_COOLSTEP 3
 #endif
 
+// TrinamicUartMode::Hybrid runs StealthChop below this rate in mm/min and SpreadCycle above
+#ifndef TRINAMIC_UART_HYBRID_RATE
+#    define TRINAMIC_UART_HYBRID_RATE 1000.0
+#endif
+
+// Depth of the queue of register transactions waiting for the UART bus task
+#ifndef TRINAMIC_UART_QUEUE_DEPTH
+#    define TRINAMIC_UART_QUEUE_DEPTH 16
+#endif
+
 #ifndef TMC_UART
 #    define TMC_UART UART_NUM_2
 #endif
@@ -73,12 +83,28 @@ namespace Motors {
         StealthChop = 1,
         CoolStep    = 2,
         StallGuard  = 3,
+        Hybrid      = 4,  // StealthChop when slow, SpreadCycle when fast
+    };
+
+    // Register transactions that are queued for the UART bus task
+    enum class TrinamicUartRequest : uint8_t {
+        Settings = 0,  // currents and microsteps
+        RunMode,
+        HomingMode,
+        Enable,
+        Disable,
     };
 
     class TrinamicUartDriver : public StandardStepper {
     private:
         static bool _uart_started;
 
+        struct Transaction {
+            TrinamicUartDriver* driver;
+            TrinamicUartRequest request;
+            TaskHandle_t        waiter;  // notified when done, NULL if nobody waits
+        };
+
     public:
         TrinamicUartDriver(uint8_t  axis_index,
                            uint8_t  step_pin,
@@ -114,6 +140,9 @@ namespace Motors {
         void             set_mode(bool isHoming);
         void             trinamic_test_response();
         void             trinamic_stepper_enable(bool enable);
+        void             write_settings();
+        void             request(TrinamicUartRequest req, bool wait);
+        void             execute(TrinamicUartRequest req);
 
         bool report_open_load(TMC2208_n ::DRV_STATUS_t status);
         bool report_short_to_ground(TMC2208_n ::DRV_STATUS_t status);
@@ -128,6 +157,10 @@ namespace Motors {
         TrinamicUartDriver*        link;
         static void                readSgTask(void*);
 
+        // After init, readSgTask owns the bus and runs the queued transactions
+        static QueueHandle_t _queue;
+        static TaskHandle_t  _task;
+
     protected:
         // void config_message() override;
     };
@@ -34,6 +34,9 @@ namespace Motors {
 
     TrinamicUartDriver* TrinamicUartDriver::List = NULL;  // a static ist of all drivers for stallguard reporting
 
+    QueueHandle_t TrinamicUartDriver::_queue = NULL;
+    TaskHandle_t  TrinamicUartDriver::_task  = NULL;
+
     /* HW Serial Constructor. */
     TrinamicUartDriver::TrinamicUartDriver(
         uint8_t axis_index, uint8_t step_pin, uint8_t dir_pin, uint8_t disable_pin, uint16_t driver_part_number, float r_sense, uint8_t addr) :
@@ -85,15 +88,17 @@ namespace Motors {
 
         // After initializing all of the TMC drivers, create a task to
         // display StallGuard data.  List == this for the final instance.
+        // From then on all bus traffic goes through the task's queue.
         if (List == this) {
-            xTaskCreatePinnedToCore(readSgTask,    // task
-                                    "readSgTask",  // name for task
-                                    4096,          // size of task stack
-                                    NULL,          // parameters
-                                    1,             // priority
-                                    NULL,
-                                    SUPPORT_TASK_CORE  // must run the task on same core
-                                                       // core
+            _queue = xQueueCreate(TRINAMIC_UART_QUEUE_DEPTH, sizeof(Transaction));
+            heap_task_create(readSgTask,    // task
+                             "readSgTask",  // name for task
+                             4096,          // size of task stack
+                             NULL,          // parameters
+                             1,             // priority
+                             &_task,
+                             SUPPORT_TASK_CORE  // must run the task on same core
+                                                // core
             );
         }
     }
@@ -166,12 +171,72 @@ namespace Motors {
     }
 
     /*
-    Read setting and send them to the driver. Called at init() and whenever related settings change
+    Queue a register transaction for the bus task. A single-wire reply must be
+    read before the next request goes out, so the task keeps only one transaction
+    on the bus, but the caller is free unless it needs the result in place.
+    Before the task exists (init) and inside the task, it runs right away.
+    */
+    void TrinamicUartDriver::request(TrinamicUartRequest req, bool wait) {
+        if (_queue == NULL) {
+            execute(req);
+            return;
+        }
+
+        Transaction t = { this, req, NULL };
+
+        if (xPortInIsrContext()) {  // st_go_idle() can disable the motors from the stepper ISR
+            BaseType_t woken = pdFALSE;
+            xQueueSendFromISR(_queue, &t, &woken);
+            if (woken) {
+                portYIELD_FROM_ISR();
+            }
+            return;
+        }
+
+        if (xTaskGetCurrentTaskHandle() == _task) {
+            execute(req);
+            return;
+        }
+
+        if (wait) {
+            t.waiter = xTaskGetCurrentTaskHandle();
+        }
+        xQueueSend(_queue, &t, portMAX_DELAY);
+        if (wait) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+    }
+
+    void TrinamicUartDriver::execute(TrinamicUartRequest req) {
+        switch (req) {
+            case TrinamicUartRequest::Settings:
+                write_settings();
+                break;
+            case TrinamicUartRequest::RunMode:
+                set_mode(false);
+                break;
+            case TrinamicUartRequest::HomingMode:
+                set_mode(true);
+                break;
+            case TrinamicUartRequest::Enable:
+                trinamic_stepper_enable(true);
+                break;
+            case TrinamicUartRequest::Disable:
+                trinamic_stepper_enable(false);
+                break;
+        }
+    }
+
+    // Called at init() and whenever related settings change
+    void TrinamicUartDriver::read_settings() { request(TrinamicUartRequest::Settings, false); }
+
+    /*
+    Read setting and send them to the driver.
     both are stored as float Amps, but TMCStepper library expects...
     uint16_t run (mA)
     float hold (as a percentage of run)
     */
-    void TrinamicUartDriver::read_settings() {
+    void TrinamicUartDriver::write_settings() {
         if (_has_errors) {
             return;
         }
@@ -195,8 +260,9 @@ namespace Motors {
         //                  reportAxisNameMsg(_axis_index, _dual_axis_index), run_i_ma, tmcstepper->rms_current(), hold_i_percent, axis_settings[_axis_index]->microsteps->get());
     }
 
+    // Homing waits for the homing mode to be in place before it moves
     bool TrinamicUartDriver::set_homing_mode(bool isHoming) {
-        set_mode(isHoming);
+        request(isHoming ? TrinamicUartRequest::HomingMode : TrinamicUartRequest::RunMode, isHoming);
         return true;
     }
 
@@ -223,6 +289,14 @@ namespace Motors {
                 grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "StealthChop");
                 tmcstepper->en_spreadCycle(false);
                 tmcstepper->pwm_autoscale(true);
+                tmcstepper->TPWMTHRS(0);  // At all speeds, after Hybrid
+                break;
+            case TrinamicUartMode ::Hybrid:
+                // The driver switches to SpreadCycle by itself once TSTEP drops below TPWMTHRS
+                grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Hybrid");
+                tmcstepper->en_spreadCycle(false);
+                tmcstepper->pwm_autoscale(true);
+                tmcstepper->TPWMTHRS(calc_tstep(TRINAMIC_UART_HYBRID_RATE, 100.0));
                 break;
             case TrinamicUartMode ::CoolStep:
                 grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Coolstep");
@@ -302,7 +376,15 @@ namespace Motors {
         digitalWrite(_disable_pin, _disabled);
 
 #ifdef USE_TRINAMIC_ENABLE
-        if (_disabled) {
+        // Motion must not start before the driver is on, but nothing waits for it to turn off
+        request(_disabled ? TrinamicUartRequest::Disable : TrinamicUartRequest::Enable, !_disabled);
+#endif
+        // the pin based enable could be added here.
+        // This would be for individual motors, not the single pin for all motors.
+    }
+
+    void TrinamicUartDriver::trinamic_stepper_enable(bool enable) {
+        if (!enable) {
             tmcstepper->toff(TRINAMIC_UART_TOFF_DISABLE);
         } else {
             if (_mode == TrinamicUartMode::StealthChop) {
@@ -311,9 +393,6 @@ namespace Motors {
                 tmcstepper->toff(TRINAMIC_UART_TOFF_COOLSTEP);
             }
         }
-#endif
-        // the pin based enable could be added here.
-        // This would be for individual motors, not the single pin for all motors.
     }
 
     // =========== Reporting functions ========================
@@ -371,14 +450,25 @@ namespace Motors {
         return false;  // no error
     }
 
-    // Prints StallGuard data that is useful for tuning.
+    // Runs the queued register transactions and, between them,
+    // prints StallGuard data that is useful for tuning.
     void TrinamicUartDriver::readSgTask(void* pvParameters) {
         TickType_t       xLastWakeTime;
         const TickType_t xreadSg = 200;  // in ticks (typically ms)
-        auto             n_axis  = number_axis->get();
+        Transaction      t;
 
         xLastWakeTime = xTaskGetTickCount();  // Initialise the xLastWakeTime variable with the current time.
         while (true) {                        // don't ever return from this or the task dies
+            TickType_t elapsed = xTaskGetTickCount() - xLastWakeTime;
+            if (xQueueReceive(_queue, &t, elapsed < xreadSg ? xreadSg - elapsed : 0) == pdTRUE) {
+                t.driver->execute(t.request);
+                if (t.waiter) {
+                    xTaskNotifyGive(t.waiter);
+                }
+                continue;
+            }
+            xLastWakeTime = xTaskGetTickCount();
+
             if (stallguard_debug_mask->get() != 0) {
                 if (sys.state == State::Cycle || sys.state == State::Homing || sys.state == State::Jog) {
                     for (TrinamicUartDriver* p = List; p; p = p->link) {
@@ -390,8 +480,6 @@ namespace Motors {
                 }  // sys.state
             }      // if mask
 
-            vTaskDelayUntil(&xLastWakeTime, xreadSg);
-
             static UBaseType_t uxHighWaterMark = 0;
 #ifdef DEBUG_TASK_STACK
             reportTaskStackSize(uxHighWaterMark);
@@ -1,6 +1,25 @@
 #include "UnipolarMotor.h"
 
 namespace Motors {
+    /*
+        8 Step : A – AB – B – BC – C – CD – D – DA
+        4 Step : AB – BC – CD – DA
+
+        Step		IN4	IN3	IN2	IN1
+        A 		0 	0 	0 	1
+        AB		0	0	1	1
+        B		0	0	1	0
+        BC		0	1	1	0
+        C		0	1	0	0
+        CD		1	1	0	0
+        D		1	0	0	0
+        DA		1	0	0	1
+
+        In internal RAM, since they are read from the stepper ISR.
+    */
+    DRAM_ATTR static const uint8_t half_step_pattern[8] = { 0b0001, 0b0011, 0b0010, 0b0110, 0b0100, 0b1100, 0b1000, 0b1001 };
+    DRAM_ATTR static const uint8_t full_step_pattern[4] = { 0b0011, 0b0110, 0b1100, 0b1001 };
+
     UnipolarMotor::UnipolarMotor(uint8_t axis_index, uint8_t pin_phase0, uint8_t pin_phase1, uint8_t pin_phase2, uint8_t pin_phase3) :
         Motor(axis_index), _pin_phase0(pin_phase0), _pin_phase1(pin_phase1), _pin_phase2(pin_phase2),
         _pin_phase3(pin_phase3),
@@ -14,6 +33,29 @@ namespace Motors {
         pinMode(_pin_phase2, OUTPUT);
         pinMode(_pin_phase3, OUTPUT);
         _current_phase = 0;
+
+        _pattern     = _half_step ? half_step_pattern : full_step_pattern;
+        _phase_count = _half_step ? 8 : 4;
+
+        // Coils on GPIOs above 33, which are input only, or not on GPIOs at all, like I2S
+        // outputs, are written one by one by step()
+        const uint8_t pins[4] = { _pin_phase0, _pin_phase1, _pin_phase2, _pin_phase3 };
+        _gpio_phases          = true;
+        for (uint8_t coil = 0; coil < 4; coil++) {
+            if (pins[coil] > 33) {
+                _gpio_phases = false;
+            }
+        }
+        for (uint8_t phase = 0; _gpio_phases && phase < _phase_count; phase++) {
+            GpioStepBits& bits = _phase_bits[phase];
+            bits               = {};
+            for (uint8_t coil = 0; coil < 4; coil++) {
+                uint32_t  mask = 1u << (pins[coil] % 32);
+                bool      on   = bitnum_istrue(_pattern[phase], coil);
+                uint32_t& out  = pins[coil] < 32 ? (on ? bits.set : bits.clear) : (on ? bits.set1 : bits.clear1);
+                out |= mask;
+            }
+        }
         config_message();
     }
 
@@ -41,88 +83,37 @@ namespace Motors {
 
     void UnipolarMotor::set_direction(bool dir) { _dir = dir; }
 
-    void UnipolarMotor::step() {
-        uint8_t _phase[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };  // temporary phase values...all start as off
-        uint8_t phase_max;
+    void UnipolarMotor::next_phase() {
+        if (_dir) {  // count up
+            _current_phase = _current_phase == _phase_count - 1 ? 0 : _current_phase + 1;
+        } else {  // count down
+            _current_phase = _current_phase == 0 ? _phase_count - 1 : _current_phase - 1;
+        }
+    }
 
+    void UnipolarMotor::step() {
         if (!_enabled)
             return;  // don't do anything, phase is not changed or lost
 
-        phase_max = _half_step ? 7 : 3;
+        next_phase();
+        uint8_t coils = _pattern[_current_phase];
+        digitalWrite(_pin_phase0, bitnum_istrue(coils, 0));
+        digitalWrite(_pin_phase1, bitnum_istrue(coils, 1));
+        digitalWrite(_pin_phase2, bitnum_istrue(coils, 2));
+        digitalWrite(_pin_phase3, bitnum_istrue(coils, 3));
+    }
 
-        if (_dir) {  // count up
-            _current_phase = _current_phase == phase_max ? 0 : _current_phase + 1;
-        } else {  // count down
-            _current_phase = _current_phase == 0 ? phase_max : _current_phase - 1;
-        }
-        /*
-			8 Step : A – AB – B – BC – C – CD – D – DA
-			4 Step : AB – BC – CD – DA
-
-			Step		IN4	IN3	IN2	IN1
-			A 		0 	0 	0 	1
-			AB		0	0	1	1
-			B		0	0	1	0
-			BC		0	1	1	0
-			C		0	1	0	0
-			CD		1	1	0	0
-			D		1	0	0	0
-			DA		1	0	0	1
-		*/
-        if (_half_step) {
-            switch (_current_phase) {
-                case 0:
-                    _phase[0] = 1;
-                    break;
-                case 1:
-                    _phase[0] = 1;
-                    _phase[1] = 1;
-                    break;
-                case 2:
-                    _phase[1] = 1;
-                    break;
-                case 3:
-                    _phase[1] = 1;
-                    _phase[2] = 1;
-                    break;
-                case 4:
-                    _phase[2] = 1;
-                    break;
-                case 5:
-                    _phase[2] = 1;
-                    _phase[3] = 1;
-                    break;
-                case 6:
-                    _phase[3] = 1;
-                    break;
-                case 7:
-                    _phase[3] = 1;
-                    _phase[0] = 1;
-                    break;
-            }
-        } else {
-            switch (_current_phase) {
-                case 0:
-                    _phase[0] = 1;
-                    _phase[1] = 1;
-                    break;
-                case 1:
-                    _phase[1] = 1;
-                    _phase[2] = 1;
-                    break;
-                case 2:
-                    _phase[2] = 1;
-                    _phase[3] = 1;
-                    break;
-                case 3:
-                    _phase[3] = 1;
-                    _phase[0] = 1;
-                    break;
-            }
-        }
-        digitalWrite(_pin_phase0, _phase[0]);
-        digitalWrite(_pin_phase1, _phase[1]);
-        digitalWrite(_pin_phase2, _phase[2]);
-        digitalWrite(_pin_phase3, _phase[3]);
+    bool UnipolarMotor::gpio_phases() { return _gpio_phases; }
+
+    void UnipolarMotor::step_phases(GpioStepBits& bits) {
+        if (!_enabled)
+            return;  // don't do anything, phase is not changed or lost
+
+        next_phase();
+        const GpioStepBits& phase = _phase_bits[_current_phase];
+        bits.set |= phase.set;
+        bits.clear |= phase.clear;
+        bits.set1 |= phase.set1;
+        bits.clear1 |= phase.clear1;
     }
 }
@@ -13,8 +13,12 @@ namespace Motors {
         void set_disable(bool disable) override;
         void set_direction(bool) override;
         void step() override;
+        bool gpio_phases() override;
+        void step_phases(GpioStepBits& bits) override;
 
     private:
+        void next_phase();
+
         uint8_t _pin_phase0;
         uint8_t _pin_phase1;
         uint8_t _pin_phase2;
@@ -24,6 +28,11 @@ namespace Motors {
         bool    _enabled;
         bool    _dir;
 
+        const uint8_t* _pattern;        // Coils on in each phase, a bit per coil
+        uint8_t        _phase_count;    // 8 half steps or 4 full steps
+        GpioStepBits   _phase_bits[8];  // The pattern as GPIO register bits
+        bool           _gpio_phases;    // All coils are on GPIOs that the registers reach
+
   protected:
         void config_message() override;
     };
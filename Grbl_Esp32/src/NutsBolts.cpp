@@ -27,6 +27,12 @@
 
 const int MAX_INT_DIGITS = 8;  // Maximum number of digits in int32 (and float)
 
+// Divisors for the digits after the decimal point, indexed by their number. A value can have
+// at most MAX_INT_DIGITS of them, so a single division converts any value whose integer part
+// did not overflow. These powers of ten are exact in single precision, so the result is
+// correctly rounded whenever the digits fit the float mantissa.
+static const float decimal_divisor[MAX_INT_DIGITS + 1] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f };
+
 // Extracts a floating point value from a string. The following code is based loosely on
 // the avr-libc strtod() function by Michael Stumpf and Dmitry Xmelkov and many freely
 // available conversion method examples, but has been highly optimized for Grbl. For known
@@ -82,20 +88,14 @@ uint8_t read_float(const char* line, uint8_t* char_counter, float* float_ptr) {
     // Convert integer into floating point.
     float fval;
     fval = (float)intval;
-    // Apply decimal. Should perform no more than two floating point multiplications for the
-    // expected range of E0 to E-4.
-    if (fval != 0) {
-        while (exp <= -2) {
-            fval *= 0.01;
-            exp += 2;
-        }
-        if (exp < 0) {
-            fval *= 0.1;
-        } else if (exp > 0) {
-            do {
-                fval *= 10.0;
-            } while (--exp > 0);
-        }
+    // Apply decimal. Integers need nothing and decimals one single precision division. Only an
+    // integer part longer than MAX_INT_DIGITS, which no CNC value has, needs the slow path.
+    if (exp < 0) {
+        fval /= decimal_divisor[-exp];
+    } else if (exp > 0) {
+        do {
+            fval *= 10.0f;
+        } while (--exp > 0);
     }
     // Assign floating point value with correct sign.
     if (isnegative) {
@@ -158,34 +158,6 @@ float convert_delta_vector_to_unit_vector(float* vector) {
     return magnitude;
 }
 
-float limit_acceleration_by_axis_maximum(float* unit_vec) {
-    uint8_t idx;
-    float   limit_value = SOME_LARGE_VALUE;
-    auto    n_axis      = number_axis->get();
-    for (idx = 0; idx < n_axis; idx++) {
-        if (unit_vec[idx] != 0) {  // Avoid divide by zero.
-            limit_value = MIN(limit_value, fabs(axis_settings[idx]->acceleration->get() / unit_vec[idx]));
-        }
-    }
-    // The acceleration setting is stored and displayed in units of mm/sec^2,
-    // but used in units of mm/min^2.  It suffices to perform the conversion once on
-    // exit, since the limit computation above is independent of units - it simply
-    // finds the smallest value.
-    return limit_value * SEC_PER_MIN_SQ;
-}
-
-float limit_rate_by_axis_maximum(float* unit_vec) {
-    uint8_t idx;
-    float   limit_value = SOME_LARGE_VALUE;
-    auto    n_axis      = number_axis->get();
-    for (idx = 0; idx < n_axis; idx++) {
-        if (unit_vec[idx] != 0) {  // Avoid divide by zero.
-            limit_value = MIN(limit_value, fabs(axis_settings[idx]->max_rate->get() / unit_vec[idx]));
-        }
-    }
-    return limit_value;
-}
-
 float map_float(float x, float in_min, float in_max, float out_min, float out_max) {  // DrawBot_Badge
     return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
 }
@@ -0,0 +1,287 @@
+/*
+  OWord.cpp - G-code subroutines and loops (O-words)
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The pool is used as a stack. Subroutines sit at the bottom and are only defined while
+  nothing is being replayed, so loop bodies, which are recorded above them and freed once
+  the loop is done, never get in their way. Only one block is recorded at a time: the lines
+  of a block nested in a loop are recorded as plain lines and only open their own block when
+  the outer body is replayed.
+*/
+
+#include "Grbl.h"
+
+enum class OBlock : uint8_t {
+    Sub,
+    Repeat,
+    While,
+};
+
+typedef struct {
+    uint16_t number;
+    uint16_t start;  // Pool offsets of the body
+    uint16_t end;
+} subroutine_t;
+
+typedef struct {
+    bool     active;
+    OBlock   kind;
+    uint16_t number;
+    uint16_t start;  // Pool offset of the body
+    float    count;  // Repeat count
+    char     condition[OWORD_CONDITION_LENGTH];
+} recording_t;
+
+static char         pool[OWORD_POOL_SIZE];
+static uint16_t     pool_used;
+static subroutine_t subs[OWORD_MAX_SUBROUTINES];
+static uint8_t      n_subs;
+static recording_t  recording;
+static uint8_t      depth;  // Bodies being replayed
+static char         replay_line[OWORD_MAX_DEPTH][LINE_BUFFER_SIZE];
+
+// Evaluates a bracketed value such as [5] or [#1 LT 10].
+static Error oword_value(const char* text, float* value) {
+    if (text[0] != '[') {
+        return Error::GcodeOWordInvalid;
+    }
+    return expr_evaluate(text, value);
+}
+
+// Sets #1, #2 and so on from the bracketed arguments of a call.
+static Error oword_arguments(const char* text) {
+    for (int number = 1; *text; number++) {
+        float value;
+        Error status = *text == '[' ? expr_read_value(&text, &value) : Error::GcodeOWordInvalid;
+        if (status == Error::Ok) {
+            status = expr_set_parameter(number, value);
+        }
+        if (status != Error::Ok) {
+            return status;
+        }
+    }
+    return Error::Ok;
+}
+
+static subroutine_t* find_sub(uint16_t number) {
+    for (uint8_t i = 0; i < n_subs; i++) {
+        if (subs[i].number == number) {
+            return &subs[i];
+        }
+    }
+    return NULL;
+}
+
+// Removes a subroutine so that it can be redefined, as when a program is run again.
+static void delete_sub(subroutine_t* sub) {
+    uint16_t length = sub->end - sub->start;
+    memmove(&pool[sub->start], &pool[sub->end], pool_used - sub->end);
+    pool_used -= length;
+    for (uint8_t i = 0; i < n_subs; i++) {
+        if (subs[i].start > sub->start) {
+            subs[i].start -= length;
+            subs[i].end -= length;
+        }
+    }
+    *sub = subs[--n_subs];
+}
+
+// Replays the lines of a body. Errors stop the body and are returned for the line that ran it.
+static Error replay(uint16_t start, uint16_t end, uint8_t client) {
+    if (depth == OWORD_MAX_DEPTH) {
+        return Error::GcodeOWordOverflow;
+    }
+    char* line = replay_line[depth++];
+    Error status = Error::Ok;
+    for (uint16_t pos = start; pos < end && status == Error::Ok; pos += strlen(&pool[pos]) + 1) {
+        strcpy(line, &pool[pos]);  // gc_execute_line() edits the line in place.
+        status = gc_execute_line(line, client);
+        protocol_execute_realtime();  // Loops without motion would otherwise never check.
+        if (sys.abort) {
+            break;
+        }
+    }
+    depth--;
+    return status;
+}
+
+static Error run_loop(uint8_t client) {
+    uint16_t start = recording.start;
+    uint16_t end   = pool_used;
+    Error    status = Error::Ok;
+    if (recording.kind == OBlock::Repeat) {
+        for (float i = 0; i < recording.count && status == Error::Ok && !sys.abort; i++) {
+            status = replay(start, end, client);
+        }
+    } else {
+        // The condition is copied, as the body may record blocks of its own.
+        char condition[OWORD_CONDITION_LENGTH];
+        strcpy(condition, recording.condition);
+        float value;
+        while ((status = oword_value(condition, &value)) == Error::Ok && value != 0.0 && !sys.abort) {
+            if ((status = replay(start, end, client)) != Error::Ok) {
+                break;
+            }
+        }
+    }
+    pool_used = start;  // Free the body.
+    return status;
+}
+
+// Appends a collapsed line to the block being recorded.
+static Error record(const char* line) {
+    size_t length = strlen(line) + 1;
+    if (length == 1) {
+        return Error::Ok;
+    }
+    if (pool_used + length > OWORD_POOL_SIZE) {
+        recording.active = false;
+        pool_used        = recording.start;
+        return Error::GcodeOWordOverflow;
+    }
+    memcpy(&pool[pool_used], line, length);
+    pool_used += length;
+    return Error::Ok;
+}
+
+// Parses O<number><keyword>[argument] from a collapsed line.
+static bool parse_oword(char* line, uint16_t* number, char** keyword) {
+    if (line[0] != 'O' || !isdigit(line[1])) {
+        return false;
+    }
+    char* s = line + 1;
+    *number = strtoul(s, &s, 10);
+    *keyword = s;
+    return true;
+}
+
+static bool keyword_is(const char* keyword, const char* name, const char** argument) {
+    size_t length = strlen(name);
+    if (strncmp(keyword, name, length) != 0) {
+        return false;
+    }
+    *argument = keyword + length;
+    return true;
+}
+
+static Error start_block(OBlock kind, uint16_t number, const char* argument) {
+    if (recording.active) {
+        return Error::GcodeOWordInvalid;
+    }
+    recording.kind   = kind;
+    recording.number = number;
+    recording.start  = pool_used;
+    if (kind == OBlock::Repeat) {
+        Error status = oword_value(argument, &recording.count);
+        if (status != Error::Ok) {
+            return status;
+        }
+    } else if (kind == OBlock::While) {
+        if (strlen(argument) >= sizeof(recording.condition)) {
+            return Error::GcodeOWordInvalid;
+        }
+        strcpy(recording.condition, argument);
+    }
+    recording.active = true;
+    return Error::Ok;
+}
+
+bool oword_intercept(char* line, uint8_t client, Error* status) {
+    if (line[0] == '$') {
+        return false;  // Jog lines are never part of a program.
+    }
+    if (!recording.active) {
+        // Only O-word lines are handled here. The rest is left to the parser untouched.
+        const char* s = line;
+        while (isspace(*s)) {
+            s++;
+        }
+        if (toupper(*s) != 'O') {
+            return false;
+        }
+    }
+    collapseGCode(line);
+    uint16_t    number;
+    char*       keyword;
+    const char* argument;
+    bool        is_oword = parse_oword(line, &number, &keyword);
+    *status              = Error::Ok;
+
+    if (recording.active) {
+        // Record until the line that closes this block. Nested blocks are recorded as lines.
+        if (is_oword && number == recording.number &&
+            ((recording.kind == OBlock::Sub && keyword_is(keyword, "ENDSUB", &argument)) ||
+             (recording.kind == OBlock::Repeat && keyword_is(keyword, "ENDREPEAT", &argument)) ||
+             (recording.kind == OBlock::While && keyword_is(keyword, "ENDWHILE", &argument)))) {
+            recording.active = false;
+            if (recording.kind == OBlock::Sub) {
+                subroutine_t* sub = &subs[n_subs++];
+                sub->number       = recording.number;
+                sub->start        = recording.start;
+                sub->end          = pool_used;
+            } else {
+                *status = run_loop(client);
+            }
+        } else {
+            *status = record(line);
+        }
+        return true;
+    }
+
+    if (!is_oword) {
+        *status = Error::GcodeOWordInvalid;
+    } else if (keyword_is(keyword, "SUB", &argument)) {
+        // Subroutines are defined from the program, never from a body being replayed.
+        if (depth) {
+            *status = Error::GcodeOWordInvalid;
+        } else {
+            subroutine_t* old = find_sub(number);
+            if (old) {
+                delete_sub(old);
+            }
+            if (n_subs == OWORD_MAX_SUBROUTINES) {
+                *status = Error::GcodeOWordOverflow;
+            } else {
+                *status = start_block(OBlock::Sub, number, argument);
+            }
+        }
+    } else if (keyword_is(keyword, "CALL", &argument)) {
+        subroutine_t* sub = find_sub(number);
+        if (!sub) {
+            *status = Error::GcodeOWordUndefined;
+        } else if ((*status = oword_arguments(argument)) == Error::Ok) {
+            *status = replay(sub->start, sub->end, client);
+        }
+    } else if (keyword_is(keyword, "REPEAT", &argument)) {
+        *status = start_block(OBlock::Repeat, number, argument);
+    } else if (keyword_is(keyword, "WHILE", &argument)) {
+        *status = start_block(OBlock::While, number, argument);
+    } else {
+        *status = Error::GcodeOWordInvalid;  // Unmatched end, or not supported
+    }
+    return true;
+}
+
+bool oword_recording() {
+    return recording.active;
+}
+
+void oword_reset() {
+    recording.active = false;
+    depth            = 0;
+    pool_used        = n_subs ? subs[0].end : 0;
+    for (uint8_t i = 1; i < n_subs; i++) {
+        pool_used = MAX(pool_used, subs[i].end);
+    }
+}
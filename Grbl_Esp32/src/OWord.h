@@ -0,0 +1,49 @@
+#pragma once
+
+/*
+  OWord.h - G-code subroutines and loops (O-words)
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Error.h"
+
+#include <cstdint>
+
+// Supported blocks, in the LinuxCNC syntax:
+//
+//   o100 sub              o101 repeat [5]       o102 while [1]
+//     ...                   ...                   ...
+//   o100 endsub           o101 endrepeat        o102 endwhile
+//   o100 call [1] [2]
+//
+// Counts and conditions may be expressions, see Expression.h. The arguments of a call are
+// assigned to #1, #2 and so on. Parameters are global, not local to the subroutine.
+//
+// The lines of a block are stored, collapsed, in a fixed pool and replayed through
+// gc_execute_line(), so blocks may nest and loop bodies may call subroutines. Comments in a
+// block are reported once, when it is recorded. Redefining a subroutine replaces it.
+const int OWORD_POOL_SIZE        = 4096;  // Bytes for all subroutine and loop bodies
+const int OWORD_MAX_SUBROUTINES  = 16;
+const int OWORD_MAX_DEPTH        = 4;   // Nesting of calls and loops being replayed
+const int OWORD_CONDITION_LENGTH = 80;  // Longest while condition, with its brackets
+
+// Called first by gc_execute_line(). Returns true if the line was an O-word or was recorded
+// into an open block, with its status in *status.
+bool oword_intercept(char* line, uint8_t client, Error* status);
+
+// Drops any block being recorded or replayed. Defined subroutines are kept.
+void oword_reset();
+
+// True while a block is being recorded, when every line must reach oword_intercept().
+bool oword_recording();
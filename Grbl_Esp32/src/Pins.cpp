@@ -12,6 +12,34 @@ String pinName(uint8_t pin) {
     }
 }
 
+uint32_t PinHandle::_none;
+
+PinHandle::PinHandle(uint8_t pin) {
+    if (pin == UNDEFINED_PIN) {
+        return;
+    }
+    if (pin >= I2S_OUT_PIN_BASE) {
+#ifdef USE_I2S_OUT
+        _pin = pin;
+        _i2s = true;
+        _bit = pin - I2S_OUT_PIN_BASE;
+#endif
+        return;  // Without the expander it writes nowhere, as digitalWrite() does
+    }
+    _pin = pin;
+    if (pin < 32) {
+        _set   = &GPIO.out_w1ts;
+        _clear = &GPIO.out_w1tc;
+        _in    = &GPIO.in;
+        _mask  = 1u << pin;
+    } else {
+        _set   = &GPIO.out1_w1ts.val;
+        _clear = &GPIO.out1_w1tc.val;
+        _in    = &GPIO.in1.val;
+        _mask  = 1u << (pin - 32);
+    }
+}
+
 // Even if USE_I2S_OUT is not defined, it is necessary to
 // override the following functions, instead of allowing
 // the weak aliases in the library to apply, because of
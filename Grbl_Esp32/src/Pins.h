@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Arduino.h>
+#include <soc/gpio_struct.h>
 
 const int UNDEFINED_PIN    = 255;  // Can be used to show a pin has no i/O assigned
 const int I2S_OUT_PIN_BASE = 128;
@@ -10,3 +11,49 @@ extern "C" void __pinMode(uint8_t pin, uint8_t mode);
 extern "C" void __digitalWrite(uint8_t pin, uint8_t val);
 
 String pinName(uint8_t pin);
+
+uint8_t i2s_out_read(uint8_t pin);
+void    i2s_out_write(uint8_t pin, uint8_t val);
+
+// A pin resolved once, at init, to what writing and reading it takes: the set and clear
+// registers and the bit of a GPIO, or the bit of the I2S output expander. An undefined pin
+// writes and reads a dummy word. write() and read() then skip the checks that digitalWrite()
+// and digitalRead() make on every call, for the pins written on the hot paths.
+class PinHandle {
+public:
+    PinHandle() = default;  // An undefined pin
+    explicit PinHandle(uint8_t pin);
+
+    inline void IRAM_ATTR write(bool high) const {
+#ifdef USE_I2S_OUT
+        if (_i2s) {
+            i2s_out_write(_bit, high);
+            return;
+        }
+#endif
+        *(high ? _set : _clear) = _mask;
+    }
+
+    inline bool IRAM_ATTR read() const {
+#ifdef USE_I2S_OUT
+        if (_i2s) {
+            return i2s_out_read(_bit);
+        }
+#endif
+        return (*_in & _mask) != 0;
+    }
+
+    uint8_t pin() const { return _pin; }
+    bool    defined() const { return _pin != UNDEFINED_PIN; }
+
+private:
+    static uint32_t _none;  // Written and read by undefined pins
+
+    volatile uint32_t* _set   = &_none;
+    volatile uint32_t* _clear = &_none;
+    volatile uint32_t* _in    = &_none;
+    uint32_t           _mask  = 0;
+    uint8_t            _pin   = UNDEFINED_PIN;
+    bool               _i2s   = false;
+    uint8_t            _bit   = 0;  // I2S output bit
+};
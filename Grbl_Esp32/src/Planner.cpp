@@ -25,39 +25,200 @@
 
 #include "Grbl.h"
 #include <stdlib.h>  // PSoc Required for labs
+#include <esp_heap_caps.h>
 
-static plan_block_t block_buffer[BLOCK_BUFFER_SIZE];  // A ring buffer for motion instructions
-static uint8_t      block_buffer_tail;                // Index of the block to process now
-static uint8_t      block_buffer_head;                // Index of the next block to be pushed
-static uint8_t      next_buffer_head;                 // Index of the next buffer head
-static uint8_t      block_buffer_planned;             // Index of the optimally planned block
+// Limits that are only needed when a block is added or its profile is recomputed for an
+// override. They sit in an array parallel to block_buffer rather than in plan_block_t.
+typedef struct {
+    float max_junction_speed_sqr;  // Junction entry speed limit based on direction vectors in (mm/min)^2
+    float rapid_rate;              // Axis-limit adjusted maximum rate for this block direction in (mm/min)
+    float time;                    // Minutes the block takes as planned, counted in plan_time_queued
+} plan_block_replan_t;
+
+static plan_block_t*          block_buffer;                           // Storage for the block ring, allocated by plan_init()
+static plan_block_replan_t*   block_replan;                           // Replanning limits, parallel to block_buffer
+static uint8_t                block_buffer_size = BLOCK_BUFFER_SIZE;  // Number of entries in block_buffer
+static bool                   block_buffer_in_psram;                  // True if block_buffer is in external RAM
+static SpscRing<plan_block_t> block_ring;                             // A ring buffer for motion instructions
+static uint8_t                block_buffer_planned;                   // Index of the optimally planned block
+static bool                   recalculate_pending;                    // A capped pass left part of the plan unoptimized
+static float                  plan_time_queued;                       // Sum of the block times, in minutes
+
+PlannerStats plan_stats;
+
+void plan_reset_stats() {
+    memset(&plan_stats, 0, sizeof(plan_stats));
+}
 
 // Define planner variables
 typedef struct {
     int32_t position[MAX_N_AXIS];  // The planner position of the tool in absolute steps. Kept separate
     // from g-code position for movements requiring multiple line motions,
     // i.e. arcs, canned cycles, and backlash compensation.
-    float previous_unit_vec[MAX_N_AXIS];  // Unit vector of previous path line segment
-    float previous_nominal_speed;         // Nominal speed of previous path line segment
+    float   previous_unit_vec[MAX_N_AXIS];  // Unit vector of previous path line segment
+    float   previous_nominal_speed;         // Nominal speed of previous path line segment
+    uint8_t backlash_direction_bits;        // Last direction of each axis, for backlash compensation
+    uint8_t backlash_known_axes;            // Axes that have moved since the planner was reset
+#ifdef SYNC_USER_OUTPUTS
+    PlOutputs outputs;  // Output changes waiting for the next block
+#endif
+#ifdef SYNC_COOLANT
+    CoolantState coolant;       // Coolant waiting for the next block
+    bool         coolant_sync;  // Set if there is one
+#endif
+#ifdef SYNC_SPINDLE_SPEED
+    SpindleState spindle;        // Spindle state and speed of an S word waiting for the next block
+    uint32_t     spindle_speed;
+    bool         spindle_sync;   // Set if there is one
+#endif
 } planner_t;
 static planner_t pl;
 
+static plan_block_replan_t* plan_replan_data(const plan_block_t* block) {
+    return &block_replan[block - block_buffer];
+}
+
+// Per-axis machine constants used for every new block, copied out of the
+// settings by plan_update_axis_limits() so that plan_buffer_line() does not
+// have to look them up. Rates are in mm/min, accelerations in mm/min^2 and
+// jerks in mm/min^3. A junction deviation of zero in the settings is resolved
+// to $11 here. For a rotary axis with a radius, these are of the path: a step
+// covers the arc of its angle at the radius, and the limits in degrees are
+// scaled the same way, so the block geometry below never sees degrees.
+typedef struct {
+    float      steps_per_mm;
+    float      mm_per_step;
+    float      path_per_step;  // mm_per_step, but mm of the surface on a rotary axis
+    float      max_rate;
+    float      acceleration;
+    float      jerk;
+    float      junction_deviation;
+    int32_t    backlash_steps;
+    RotaryMode rotary;
+} plan_axis_limits_t;
+static plan_axis_limits_t axis_limits[MAX_N_AXIS];
+static uint8_t            axis_count;
+static uint8_t            backlash_axes;  // Axes with backlash compensation
+
+void plan_update_axis_limits() {
+    axis_count    = number_axis->get();
+    backlash_axes = 0;
+    for (uint8_t idx = 0; idx < MAX_N_AXIS; idx++) {
+        plan_axis_limits_t* limits = &axis_limits[idx];
+        limits->rotary             = RotaryMode(axis_settings[idx]->rotary->get());
+        float path_scale           = 1.0f;  // mm of path per unit of the axis
+        if (limits->rotary != RotaryMode::Linear && axis_settings[idx]->radius->get() > 0.0f) {
+            path_scale = axis_settings[idx]->radius->get() * float(M_PI / 180.0);
+        }
+        limits->steps_per_mm       = axis_settings[idx]->steps_per_mm->get();
+        limits->mm_per_step        = 1.0f / limits->steps_per_mm;
+        limits->path_per_step      = limits->mm_per_step * path_scale;
+        limits->max_rate           = axis_settings[idx]->max_rate->get() * path_scale;
+        limits->acceleration       = axis_settings[idx]->acceleration->get() * SEC_PER_MIN_SQ * path_scale;
+        limits->jerk               = axis_settings[idx]->jerk->get() * SEC_PER_MIN_CUBE * path_scale;
+        limits->junction_deviation = axis_settings[idx]->junction_deviation->get();
+        if (limits->junction_deviation == 0.0f) {
+            limits->junction_deviation = junction_deviation->get();
+        }
+        limits->backlash_steps = lround(axis_settings[idx]->backlash->get() * limits->steps_per_mm);
+        if (limits->backlash_steps > 0 && idx < axis_count) {
+            backlash_axes |= bit(idx);
+        }
+    }
+}
+
+// Junction deviation for a corner whose change of direction is along unit_vec.
+// Each axis contributes its own deviation by the square of its component, so
+// the result is $11 when no axis overrides it, and a corner taken up mostly by
+// one axis gets mostly that axis's value.
+static float junction_deviation_by_axis(const float* unit_vec) {
+    float deviation = 0.0f;
+    for (uint8_t idx = 0; idx < axis_count; idx++) {
+        deviation += unit_vec[idx] * unit_vec[idx] * axis_limits[idx].junction_deviation;
+    }
+    return deviation;
+}
+
+// The three limits below scale the per-axis maxima by the line direction so
+// that no axis exceeds its own maximum. Axes that do not move are skipped.
+static float limit_acceleration_by_axis_maximum(const float* unit_vec) {
+    float limit_value = SOME_LARGE_VALUE;
+    for (uint8_t idx = 0; idx < axis_count; idx++) {
+        if (unit_vec[idx] != 0) {  // Avoid divide by zero.
+            limit_value = MIN(limit_value, fabsf(axis_limits[idx].acceleration / unit_vec[idx]));
+        }
+    }
+    return limit_value;
+}
+
+#ifdef S_CURVE_ACCELERATION
+static float limit_jerk_by_axis_maximum(const float* unit_vec) {
+    float limit_value = SOME_LARGE_VALUE;
+    for (uint8_t idx = 0; idx < axis_count; idx++) {
+        if (unit_vec[idx] != 0) {  // Avoid divide by zero.
+            limit_value = MIN(limit_value, fabsf(axis_limits[idx].jerk / unit_vec[idx]));
+        }
+    }
+    return limit_value;
+}
+#endif
+
+static float limit_rate_by_axis_maximum(const float* unit_vec) {
+    float limit_value = SOME_LARGE_VALUE;
+    for (uint8_t idx = 0; idx < axis_count; idx++) {
+        if (unit_vec[idx] != 0) {  // Avoid divide by zero.
+            limit_value = MIN(limit_value, fabsf(axis_limits[idx].max_rate / unit_vec[idx]));
+        }
+    }
+    return limit_value;
+}
+
+RotaryMode plan_rotary_mode(uint8_t axis) {
+    return axis_limits[axis].rotary;
+}
+
 // Returns the index of the next block in the ring buffer. Also called by stepper segment buffer.
 uint8_t plan_next_block_index(uint8_t block_index) {
-    block_index++;
-    if (block_index == BLOCK_BUFFER_SIZE) {
-        block_index = 0;
-    }
-    return block_index;
+    return block_ring.next(block_index);
 }
 
 // Returns the index of the previous block in the ring buffer
 static uint8_t plan_prev_block_index(uint8_t block_index) {
-    if (block_index == 0) {
-        block_index = BLOCK_BUFFER_SIZE;
+    return block_ring.prev(block_index);
+}
+
+// Minutes a block takes between the two speeds on a trapezoid profile at its nominal speed, or
+// a triangle when it is too short to reach it. An S-curve ramp takes the same time at its
+// average acceleration, which is what the planner holds.
+static float plan_compute_block_time(plan_block_t* block, float entry_speed_sqr, float exit_speed_sqr) {
+    float nominal_speed     = plan_compute_profile_nominal_speed(block);
+    float nominal_speed_sqr = nominal_speed * nominal_speed;
+    float entry_speed       = sqrtf(entry_speed_sqr);
+    float exit_speed        = sqrtf(exit_speed_sqr);
+    float inv_2_accel       = 0.5f / block->acceleration;
+    float ramps_mm          = inv_2_accel * (fabsf(nominal_speed_sqr - entry_speed_sqr) + fabsf(nominal_speed_sqr - exit_speed_sqr));
+    if (ramps_mm > block->millimeters) {
+        float peak_speed = sqrtf(0.5f * (entry_speed_sqr + exit_speed_sqr) + block->acceleration * block->millimeters);
+        return (2.0f * peak_speed - entry_speed - exit_speed) / block->acceleration;
+    }
+    return (fabsf(nominal_speed - entry_speed) + fabsf(nominal_speed - exit_speed)) / block->acceleration +
+           (block->millimeters - ramps_mm) / nominal_speed;
+}
+
+// Recomputes the times of the blocks from block_index to the head, whose speeds the last
+// pass may have changed, and keeps plan_time_queued their sum.
+static void plan_update_block_times(uint8_t block_index) {
+    uint8_t block_buffer_head = block_ring.head();
+    while (block_index != block_buffer_head) {
+        plan_block_t*        block          = &block_ring[block_index];
+        plan_block_replan_t* replan         = plan_replan_data(block);
+        uint8_t              next_index     = plan_next_block_index(block_index);
+        float                exit_speed_sqr = next_index == block_buffer_head ? 0.0f : block_ring[next_index].entry_speed_sqr;
+        float                time           = plan_compute_block_time(block, block->entry_speed_sqr, exit_speed_sqr);
+        plan_time_queued += time - replan->time;
+        replan->time = time;
+        block_index  = next_index;
     }
-    block_index--;
-    return block_index;
 }
 
 /*                            PLANNER SPEED DEFINITION
@@ -100,12 +261,12 @@ static uint8_t plan_prev_block_index(uint8_t block_index) {
   used feed holds or feedrate overrides, the stop-compute pointers will be reset and the entire plan is
   recomputed as stated in the general guidelines.
 
-  Planner buffer index mapping:
+  Planner buffer index mapping (kept by block_ring, see SpscRing.h):
   - block_buffer_tail: Points to the beginning of the planner buffer. First to be executed or being executed.
   - block_buffer_head: Points to the buffer block after the last block in the buffer. Used to indicate whether
       the buffer is full or empty. As described for standard ring buffers, this block is always empty.
   - next_buffer_head: Points to next planner buffer block after the buffer head block. When equal to the
-      buffer tail, this indicates the buffer is full.
+      buffer tail, this indicates the buffer is full. Computed by block_ring.full() rather than stored.
   - block_buffer_planned: Points to the first buffer block after the last optimally planned block for normal
       streaming operating conditions. Use for planning optimizations by avoiding recomputing parts of the
       planner buffer that don't change with the addition of a new block, as describe above. In addition,
@@ -124,20 +285,32 @@ static uint8_t plan_prev_block_index(uint8_t block_index) {
   to compute an optimal plan, so select carefully. The Arduino 328p memory is already maxed out, but future
   ARM versions should have enough memory and speed for look-ahead blocks numbering up to a hundred or more.
 
+  With a deep buffer, a run of blocks that never reach their maximum entry speed keeps the planned
+  pointer from moving, so the reverse pass gets longer with every new block. max_blocks caps how far
+  back the reverse pass goes. Stopping early is safe: appending a block can only raise entry speeds,
+  so the blocks not revisited keep speeds planned against the older, nearer end of the buffer. The
+  forward pass then starts from the first block not revisited instead of the planned pointer, and
+  the planned pointer is left alone because the blocks in between may still be improved. The full
+  pass is finished later by plan_idle_recalculate(). A max_blocks of 0 does the full pass.
+
 */
-static void planner_recalculate() {
+static void planner_recalculate(uint8_t max_blocks) {
+    uint8_t block_buffer_head = block_ring.head();
+    uint8_t block_buffer_tail = block_ring.tail();
     // Initialize block index to the last block in the planner buffer.
     uint8_t block_index = plan_prev_block_index(block_buffer_head);
     // Bail. Can't do anything with one only one plan-able block.
     if (block_index == block_buffer_planned) {
+        plan_update_block_times(block_index);
         return;
     }
+    uint8_t forward_start = block_buffer_planned;
     // Reverse Pass: Coarsely maximize all possible deceleration curves back-planning from the last
     // block in buffer. Cease planning when the last optimal planned or tail pointer is reached.
     // NOTE: Forward pass will later refine and correct the reverse pass to create an optimal plan.
     float         entry_speed_sqr;
     plan_block_t* next;
-    plan_block_t* current = &block_buffer[block_index];
+    plan_block_t* current = &block_ring[block_index];
     // Calculate maximum entry speed for last block in buffer, where the exit speed is always zero.
     current->entry_speed_sqr = MIN(current->max_entry_speed_sqr, 2 * current->acceleration * current->millimeters);
     block_index              = plan_prev_block_index(block_index);
@@ -147,9 +320,16 @@ static void planner_recalculate() {
             st_update_plan_block_parameters();
         }
     } else {  // Three or more plan-able blocks
+        uint8_t reverse_count = 1;
         while (block_index != block_buffer_planned) {
+            if (max_blocks && reverse_count++ >= max_blocks) {
+                // Work limit reached. Resume forward from the first block not revisited.
+                forward_start       = block_index;
+                recalculate_pending = true;
+                break;
+            }
             next        = current;
-            current     = &block_buffer[block_index];
+            current     = &block_ring[block_index];
             block_index = plan_prev_block_index(block_index);
             // Check if next block is the tail block(=planned block). If so, update current stepper parameters.
             if (block_index == block_buffer_tail) {
@@ -168,11 +348,11 @@ static void planner_recalculate() {
     }
     // Forward Pass: Forward plan the acceleration curve from the planned pointer onward.
     // Also scans for optimal plan breakpoints and appropriately updates the planned pointer.
-    next        = &block_buffer[block_buffer_planned];  // Begin at buffer planned pointer
-    block_index = plan_next_block_index(block_buffer_planned);
+    next        = &block_ring[forward_start];  // Begin at buffer planned pointer, unless capped
+    block_index = plan_next_block_index(forward_start);
     while (block_index != block_buffer_head) {
         current = next;
-        next    = &block_buffer[block_index];
+        next    = &block_ring[block_index];
         // Any acceleration detected in the forward pass automatically moves the optimal planned
         // pointer forward, since everything before this is all optimal. In other words, nothing
         // can improve the plan from the buffer tail to the planned pointer by logic.
@@ -181,81 +361,176 @@ static void planner_recalculate() {
             // If true, current block is full-acceleration and we can move the planned pointer forward.
             if (entry_speed_sqr < next->entry_speed_sqr) {
                 next->entry_speed_sqr = entry_speed_sqr;  // Always <= max_entry_speed_sqr. Backward pass sets this.
-                block_buffer_planned  = block_index;      // Set optimal plan pointer.
+                if (forward_start == block_buffer_planned) {
+                    block_buffer_planned = block_index;  // Set optimal plan pointer.
+                }
             }
         }
         // Any block set at its maximum entry speed also creates an optimal plan up to this
         // point in the buffer. When the plan is bracketed by either the beginning of the
         // buffer and a maximum entry speed or two maximum entry speeds, every block in between
         // cannot logically be further improved. Hence, we don't have to recompute them anymore.
-        if (next->entry_speed_sqr == next->max_entry_speed_sqr) {
+        if (next->entry_speed_sqr == next->max_entry_speed_sqr && forward_start == block_buffer_planned) {
             block_buffer_planned = block_index;
         }
         block_index = plan_next_block_index(block_index);
     }
+    // The exit of the first block passed over is the entry of the next, so its time changes too.
+    plan_update_block_times(forward_start);
+}
+
+// Completes the plan after capped recalculations. Called when the main loop has time to spare.
+void plan_idle_recalculate() {
+    if (!recalculate_pending) {
+        return;
+    }
+    st_prep_lock();
+    recalculate_pending = false;
+    planner_recalculate(0);
+    st_prep_unlock();
+}
+
+// Allocates both planner arrays for size blocks, the blocks with caps. Neither is kept unless
+// both fit.
+static bool plan_alloc(uint8_t size, uint32_t caps) {
+    block_buffer = (plan_block_t*)heap_alloc(HeapTag::Planner, size * sizeof(plan_block_t), caps);
+    if (block_buffer == NULL) {
+        return false;
+    }
+    // The replanning limits are small and always go in internal RAM.
+    block_replan =
+        (plan_block_replan_t*)heap_alloc(HeapTag::Planner, size * sizeof(plan_block_replan_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (block_replan == NULL) {
+        heap_free(HeapTag::Planner, block_buffer, size * sizeof(plan_block_t));
+        block_buffer = NULL;
+        return false;
+    }
+    block_buffer_size = size;
+    return true;
+}
+
+// Allocates the block buffer. Called once at boot, after the settings are loaded.
+// A deep lookahead does not fit comfortably in internal RAM, so on boards with
+// PSRAM it can be put there. Only the planner and the segment generator touch
+// planner blocks, never the stepper ISR, so the slower cached access is safe.
+void plan_init() {
+    plan_update_axis_limits();
+    uint8_t size          = planner_block_buffer_size->get();
+    block_buffer_in_psram = planner_use_psram->get() && psramFound() && plan_alloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!block_buffer_in_psram && !plan_alloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)) {
+        grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Error, "Planner buffer %d does not fit", size);
+        if (!plan_alloc(BLOCK_BUFFER_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)) {
+            grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Error, "No planner buffer, motion is locked out");
+            return;
+        }
+    }
+    block_ring.attach(block_buffer, block_buffer_size);
+    grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Planner buffer %d%s", block_buffer_size, block_buffer_in_psram ? " in PSRAM" : "");
+}
+
+bool plan_ready() {
+    return block_buffer != NULL;
+}
+
+uint8_t plan_get_block_buffer_size() {
+    return block_buffer_size;
 }
 
 void plan_reset() {
+    st_prep_lock();
     memset(&pl, 0, sizeof(planner_t));  // Clear planner struct
     plan_reset_buffer();
+    st_prep_unlock();
 }
 
 void plan_reset_buffer() {
-    block_buffer_tail    = 0;
-    block_buffer_head    = 0;  // Empty = tail
-    next_buffer_head     = 1;  // plan_next_block_index(block_buffer_head)
+    st_prep_lock();
+    block_ring.reset();        // Empty, head = tail = 0
     block_buffer_planned = 0;  // = block_buffer_tail;
+    recalculate_pending  = false;
+    plan_time_queued     = 0.0f;
+    st_prep_unlock();
 }
 
 void plan_discard_current_block() {
-    if (block_buffer_head != block_buffer_tail) {  // Discard non-empty buffer.
-        uint8_t block_index = plan_next_block_index(block_buffer_tail);
+    if (!block_ring.empty()) {  // Discard non-empty buffer.
+        uint8_t block_buffer_tail = block_ring.tail();
         // Push block_buffer_planned pointer, if encountered.
         if (block_buffer_tail == block_buffer_planned) {
-            block_buffer_planned = block_index;
+            block_buffer_planned = plan_next_block_index(block_buffer_tail);
+        }
+        plan_time_queued -= block_replan[block_buffer_tail].time;
+        block_ring.pop();
+        if (block_ring.empty()) {
+            plan_time_queued = 0.0f;  // Drop the rounding error gathered since the buffer last emptied
         }
-        block_buffer_tail = block_index;
     }
 }
 
+float plan_get_block_time(const plan_block_t* block) {
+    return plan_replan_data(block)->time * 60.0f;
+}
+
+float plan_get_queued_time() {
+    st_prep_lock();
+    float         time  = plan_time_queued;
+    plan_block_t* block = plan_get_current_block();
+    if (block) {
+        // The stepper has taken the start of the executing block into prepped segments, so its
+        // time is worked out again from what is left of it at the speed the segments end at.
+        // The segments themselves take about DT_SEGMENT each.
+        float speed = st_get_realtime_rate();
+        time += plan_compute_block_time(block, speed * speed, plan_get_exec_block_exit_speed_sqr()) - plan_replan_data(block)->time;
+        time += st_get_segment_buffer_count() * DT_SEGMENT;
+    }
+    st_prep_unlock();
+    return time > 0.0f ? time * 60.0f : 0.0f;
+}
+
 // Returns address of planner buffer block used by system motions. Called by segment generator.
 plan_block_t* plan_get_system_motion_block() {
-    return &block_buffer[block_buffer_head];
+    return &block_ring[block_ring.head()];
 }
 
-// Returns address of first planner block, if available. Called by various main program functions.
-plan_block_t* plan_get_current_block() {
-    if (block_buffer_head == block_buffer_tail) {
-        return NULL;  // Buffer empty
-    }
-    return &block_buffer[block_buffer_tail];
+// Returns address of first planner block, if available. Called by various main program functions,
+// and by the stepper ISR to tell an underrun from the end of a cycle.
+plan_block_t* IRAM_ATTR plan_get_current_block() {
+    return block_ring.consumer_slot();  // NULL if the buffer is empty
 }
 
 float plan_get_exec_block_exit_speed_sqr() {
-    uint8_t block_index = plan_next_block_index(block_buffer_tail);
-    if (block_index == block_buffer_head) {
+    uint8_t block_index = plan_next_block_index(block_ring.tail());
+    if (block_index == block_ring.head()) {
         return 0.0f;
     }
-    return block_buffer[block_index].entry_speed_sqr;
+    return block_ring[block_index].entry_speed_sqr;
 }
 
 // Returns the availability status of the block ring buffer. True, if full.
+// With backlash compensation a line may need a second block for the correction, so keep one in reserve.
 uint8_t plan_check_full_buffer() {
-    return block_buffer_tail == next_buffer_head;
+    if (block_buffer == NULL) {
+        return false;  // Let the line through to plan_buffer_line(), which drops it
+    }
+    return block_ring.available() <= (backlash_axes ? 1 : 0);
 }
 
 // Computes and returns block nominal speed based on running condition and override values.
 // NOTE: All system motion commands, such as homing/parking, are not subject to overrides.
 float plan_compute_profile_nominal_speed(plan_block_t* block) {
+    float rapid_rate    = plan_replan_data(block)->rapid_rate;
     float nominal_speed = block->programmed_rate;
     if (block->motion.rapidMotion) {
         nominal_speed *= (0.01 * sys.r_override);
     } else {
         if (!(block->motion.noFeedOverride)) {
             nominal_speed *= (0.01 * sys.f_override);
+            if (sys.f_adaptive != FeedOverride::Default) {
+                nominal_speed *= (0.01 * sys.f_adaptive);  // Only when active, so 100% stays bit-identical
+            }
         }
-        if (nominal_speed > block->rapid_rate) {
-            nominal_speed = block->rapid_rate;
+        if (nominal_speed > rapid_rate) {
+            nominal_speed = rapid_rate;
         }
     }
     if (nominal_speed > MINIMUM_FEED_RATE) {
@@ -264,6 +539,10 @@ float plan_compute_profile_nominal_speed(plan_block_t* block) {
     return MINIMUM_FEED_RATE;
 }
 
+float plan_get_block_rapid_rate(const plan_block_t* block) {
+    return plan_replan_data(block)->rapid_rate;
+}
+
 // Computes and updates the max entry speed (sqr) of the block, based on the minimum of the junction's
 // previous and current nominal speeds and max junction speed.
 static void plan_compute_profile_parameters(plan_block_t* block, float nominal_speed, float prev_nominal_speed) {
@@ -274,35 +553,190 @@ static void plan_compute_profile_parameters(plan_block_t* block, float nominal_s
         block->max_entry_speed_sqr = nominal_speed * nominal_speed;
     }
 
-    if (block->max_entry_speed_sqr > block->max_junction_speed_sqr) {
-        block->max_entry_speed_sqr = block->max_junction_speed_sqr;
+    float max_junction_speed_sqr = plan_replan_data(block)->max_junction_speed_sqr;
+    if (block->max_entry_speed_sqr > max_junction_speed_sqr) {
+        block->max_entry_speed_sqr = max_junction_speed_sqr;
     }
 }
 
 // Re-calculates buffered motions profile parameters upon a motion-based override change.
 void plan_update_velocity_profile_parameters() {
-    uint8_t       block_index = block_buffer_tail;
+    st_prep_lock();
+    uint8_t       block_index       = block_ring.tail();
+    uint8_t       block_buffer_head = block_ring.head();
     plan_block_t* block;
     float         nominal_speed;
     float         prev_nominal_speed = SOME_LARGE_VALUE;  // Set high for first block nominal speed calculation.
     while (block_index != block_buffer_head) {
-        block         = &block_buffer[block_index];
+        block         = &block_ring[block_index];
         nominal_speed = plan_compute_profile_nominal_speed(block);
         plan_compute_profile_parameters(block, nominal_speed, prev_nominal_speed);
         prev_nominal_speed = nominal_speed;
         block_index        = plan_next_block_index(block_index);
     }
     pl.previous_nominal_speed = prev_nominal_speed;  // Update prev nominal speed for next incoming block.
+    st_prep_unlock();
+}
+
+// Returns the entry speed limit (sqr) at the junction of the previous block with a block along unit_vec.
+static float plan_compute_max_junction_speed_sqr(const float* unit_vec) {
+    // Compute maximum allowable entry speed at junction by centripetal acceleration approximation.
+    // Let a circle be tangent to both previous and current path line segments, where the junction
+    // deviation is defined as the distance from the junction to the closest edge of the circle,
+    // colinear with the circle center. The circular segment joining the two paths represents the
+    // path of centripetal acceleration. Solve for max velocity based on max acceleration about the
+    // radius of the circle, defined indirectly by junction deviation. This may be also viewed as
+    // path width or max_jerk in the previous Grbl version. This approach does not actually deviate
+    // from path, but used as a robust way to compute cornering speeds, as it takes into account the
+    // nonlinearities of both the junction angle and junction velocity.
+    //
+    // NOTE: If the junction deviation value is finite, Grbl executes the motions in an exact path
+    // mode (G61). If the junction deviation value is zero, Grbl will execute the motion in an exact
+    // stop mode (G61.1) manner. In the future, if continuous mode (G64) is desired, the math here
+    // is exactly the same. Instead of motioning all the way to junction point, the machine will
+    // just follow the arc circle defined here. The Arduino doesn't have the CPU cycles to perform
+    // a continuous mode path, but ARM-based microcontrollers most certainly do.
+    //
+    // NOTE: The max junction speed is a fixed value, since machine acceleration limits cannot be
+    // changed dynamically during operation nor can the line move geometry. This must be kept in
+    // memory in the event of a feedrate override changing the nominal speeds of blocks, which can
+    // change the overall maximum entry speed conditions of all blocks.
+    float junction_unit_vec[MAX_N_AXIS];
+    float junction_cos_theta = 0.0;
+    for (uint8_t idx = 0; idx < axis_count; idx++) {
+        junction_cos_theta -= pl.previous_unit_vec[idx] * unit_vec[idx];
+        junction_unit_vec[idx] = unit_vec[idx] - pl.previous_unit_vec[idx];
+    }
+    // NOTE: Computed without any expensive trig, sin() or acos(), by trig half angle identity of cos(theta).
+    if (junction_cos_theta > 0.999999) {
+        //  For a 0 degree acute junction, just set minimum junction speed.
+        return MINIMUM_JUNCTION_SPEED * MINIMUM_JUNCTION_SPEED;
+    } else {
+        if (junction_cos_theta < -0.999999) {
+            // Junction is a straight line or 180 degrees. Junction speed is infinite.
+            return SOME_LARGE_VALUE;
+        } else {
+            convert_delta_vector_to_unit_vector(junction_unit_vec);
+            float junction_acceleration = limit_acceleration_by_axis_maximum(junction_unit_vec);
+            float sin_theta_d2          = sqrt(0.5 * (1.0 - junction_cos_theta));  // Trig half angle identity. Always positive.
+            return MAX(MINIMUM_JUNCTION_SPEED * MINIMUM_JUNCTION_SPEED,
+                       (junction_acceleration * junction_deviation_by_axis(junction_unit_vec) * sin_theta_d2) / (1.0 - sin_theta_d2));
+        }
+    }
 }
 
+// Backlash compensation. When a line reverses an axis with a Backlash setting, a correction
+// block that moves just the reversing axes by their backlash is queued ahead of it, at the
+// axis limits and without feed override. The stepper does not count its steps into
+// sys_position, so the machine position, the planner position and reports are unchanged.
+static void plan_buffer_backlash_locked(const float* target, const plan_line_data_t* pl_data) {
+    uint8_t moving     = 0;
+    uint8_t directions = 0;
+    for (uint8_t idx = 0; idx < axis_count; idx++) {
+        int32_t delta = lround(target[idx] * axis_limits[idx].steps_per_mm) - pl.position[idx];
+        if (delta != 0) {
+            moving |= bit(idx);
+            if (delta < 0) {
+                directions |= bit(idx);
+            }
+        }
+    }
+    uint8_t reversed = moving & pl.backlash_known_axes & backlash_axes & (directions ^ pl.backlash_direction_bits);
+    pl.backlash_direction_bits = (pl.backlash_direction_bits & ~moving) | directions;
+    pl.backlash_known_axes |= moving;
+    if (!reversed || block_ring.available() < 2) {
+        return;
+    }
+
+    plan_block_t*        block  = &block_ring[block_ring.head()];
+    plan_block_replan_t* replan = plan_replan_data(block);
+    memset(block, 0, sizeof(plan_block_t));
+    replan->time = 0.0f;
+    block->motion                = pl_data->motion;
+    block->motion.rapidMotion    = 0;
+    block->motion.inverseTime    = 0;
+    block->motion.noFeedOverride = 1;
+    block->motion.backlashMotion = 1;
+    block->coolant               = pl_data->coolant;
+    block->spindle               = pl_data->spindle;
+    block->spindle_speed         = pl_data->spindle_speed;
+#ifdef USE_LINE_NUMBERS
+    block->line_number = pl_data->line_number;
+#endif
+    block->direction_bits = directions & reversed;
+    float unit_vec[MAX_N_AXIS];
+    for (uint8_t idx = 0; idx < MAX_N_AXIS; idx++) {
+        unit_vec[idx] = 0.0;
+        if (reversed & bit(idx)) {
+            block->steps[idx]       = axis_limits[idx].backlash_steps;
+            block->step_event_count = MAX(block->step_event_count, block->steps[idx]);
+            unit_vec[idx]           = axis_limits[idx].backlash_steps * axis_limits[idx].path_per_step;
+            if (directions & bit(idx)) {
+                unit_vec[idx] = -unit_vec[idx];
+            }
+        }
+    }
+#ifdef LINEAR_KINEMATICS
+    linear_kinematics_to_cartesian(unit_vec, unit_vec, axis_count);
+#endif
+    block->millimeters     = convert_delta_vector_to_unit_vector(unit_vec);
+    block->acceleration    = limit_acceleration_by_axis_maximum(unit_vec);
+    replan->rapid_rate     = limit_rate_by_axis_maximum(unit_vec);
+    block->programmed_rate = replan->rapid_rate;
+#ifdef S_CURVE_ACCELERATION
+    block->jerk         = limit_jerk_by_axis_maximum(unit_vec);
+    block->acceleration = MIN(block->acceleration * (2.0f / 3.0f), sqrtf(block->jerk * block->programmed_rate / 6.0f));
+#endif
+    replan->max_junction_speed_sqr = block_ring.empty() ? 0.0 : plan_compute_max_junction_speed_sqr(unit_vec);
+    float nominal_speed            = plan_compute_profile_nominal_speed(block);
+    plan_compute_profile_parameters(block, nominal_speed, pl.previous_nominal_speed);
+    pl.previous_nominal_speed = nominal_speed;
+    memcpy(pl.previous_unit_vec, unit_vec, sizeof(unit_vec));
+    block_ring.push();
+}
+
+static uint8_t plan_buffer_line_locked(float* target, plan_line_data_t* pl_data);
+
+// The segment generator reads the blocks this modifies, so the whole
+// update runs under the segment prep lock.
 uint8_t plan_buffer_line(float* target, plan_line_data_t* pl_data) {
+    if (block_buffer == NULL) {
+        return PLAN_EMPTY_BLOCK;  // See plan_ready()
+    }
+    TRACE_SCOPE(PlanBufferLine, plan_get_block_buffer_count());
+    st_prep_lock();
+    uint8_t result = plan_buffer_line_locked(target, pl_data);
+    st_prep_unlock();
+    return result;
+}
+
+static uint8_t plan_buffer_line_locked(float* target, plan_line_data_t* pl_data) {
+#ifdef AXIS_ENCODERS
+    axis_encoder_correct_planner(pl.position);
+#endif
+#ifdef LINEAR_KINEMATICS
+    // Steps are counted for the motors, and the deltas taken back to the carriage for the limits.
+    const float* cartesian = target;
+    float        motors[MAX_N_AXIS];
+    linear_kinematics_to_motors(target, motors, axis_count);
+    target = motors;
+#endif
+    if (backlash_axes && !pl_data->motion.systemMotion) {
+        plan_buffer_backlash_locked(target, pl_data);
+    }
     // Prepare and initialize new block. Copy relevant pl_data for block execution.
-    plan_block_t* block = &block_buffer[block_buffer_head];
+    plan_block_t*        block  = &block_ring[block_ring.head()];
+    plan_block_replan_t* replan = plan_replan_data(block);
     memset(block, 0, sizeof(plan_block_t));  // Zero all block values.
+    replan->time = 0.0f;
     block->motion        = pl_data->motion;
     block->coolant       = pl_data->coolant;
     block->spindle       = pl_data->spindle;
     block->spindle_speed = pl_data->spindle_speed;
+#ifdef RASTER_ENGRAVING
+    block->raster_line   = pl_data->raster_line;
+    block->raster_pixels = pl_data->raster_pixels;
+#endif
 
 #ifdef USE_LINE_NUMBERS
     block->line_number = pl_data->line_number;
@@ -313,19 +747,19 @@ uint8_t plan_buffer_line(float* target, plan_line_data_t* pl_data) {
     uint8_t idx;
     // Copy position data based on type of motion being planned.
     if (block->motion.systemMotion) {
-        memcpy(position_steps, sys_position, sizeof(sys_position));
+        st_get_position(position_steps);
     } else {
         memcpy(position_steps, pl.position, sizeof(pl.position));
     }
-    auto n_axis = number_axis->get();
+    auto n_axis = axis_count;
     for (idx = 0; idx < n_axis; idx++) {
         // Calculate target position in absolute steps, number of steps for each axis, and determine max step events.
         // Also, compute individual axes distance for move and prep unit vector calculations.
         // NOTE: Computes true distance from converted step values.
-        target_steps[idx]       = lround(target[idx] * axis_settings[idx]->steps_per_mm->get());
+        target_steps[idx]       = lround(target[idx] * axis_limits[idx].steps_per_mm);
         block->steps[idx]       = labs(target_steps[idx] - position_steps[idx]);
         block->step_event_count = MAX(block->step_event_count, block->steps[idx]);
-        delta_mm                = (target_steps[idx] - position_steps[idx]) / axis_settings[idx]->steps_per_mm->get();
+        delta_mm                = (target_steps[idx] - position_steps[idx]) * axis_limits[idx].path_per_step;
         unit_vec[idx]           = delta_mm;  // Store unit vector numerator
         // Set direction bits. Bit enabled always means direction is negative.
         if (delta_mm < 0.0) {
@@ -336,127 +770,194 @@ uint8_t plan_buffer_line(float* target, plan_line_data_t* pl_data) {
     if (block->step_event_count == 0) {
         return PLAN_EMPTY_BLOCK;
     }
+#ifdef SYNC_USER_OUTPUTS
+    block->outputs = pl.outputs;
+    memset(&pl.outputs, 0, sizeof(pl.outputs));
+#endif
+#ifdef SYNC_COOLANT
+    block->coolant_sync = pl.coolant_sync;
+    pl.coolant_sync     = false;
+#endif
+#ifdef SYNC_SPINDLE_SPEED
+    pl.spindle_sync = false;  // The block carries the speed itself
+#endif
 
     // Calculate the unit vector of the line move and the block maximum feed rate and acceleration scaled
     // down such that no individual axes maximum values are exceeded with respect to the line direction.
     // NOTE: This calculation assumes all axes are orthogonal (Cartesian) and works with ABC-axes,
     // if they are also orthogonal/independent. Operates on the absolute value of the unit vector.
+#ifdef LINEAR_KINEMATICS
+    linear_kinematics_to_cartesian(unit_vec, unit_vec, n_axis);
+#endif
     block->millimeters  = convert_delta_vector_to_unit_vector(unit_vec);
     block->acceleration = limit_acceleration_by_axis_maximum(unit_vec);
-    block->rapid_rate   = limit_rate_by_axis_maximum(unit_vec);
+    replan->rapid_rate  = limit_rate_by_axis_maximum(unit_vec);
+#ifdef SPINDLE_SYNC
+    // K is along Z. The segment generator follows the spindle along the whole path, so the
+    // pitch is scaled up by the path length per mm of Z.
+    if (pl_data->sync_pitch != 0.0) {
+        float z_share     = fabs(unit_vec[Z_AXIS]);
+        block->sync_pitch = z_share > 0.0 ? pl_data->sync_pitch / z_share : pl_data->sync_pitch;
+    }
+#endif
+#ifdef CONSTANT_SURFACE_SPEED
+    // Measured back from the end, as the segment generator counts down the mm remaining.
+    if (pl_data->css_speed != 0.0) {
+        block->css_speed = pl_data->css_speed;
+#    ifdef LINEAR_KINEMATICS
+        block->css_radius = cartesian[X_AXIS] - pl_data->css_origin;
+#    else
+        block->css_radius = target_steps[X_AXIS] * axis_limits[X_AXIS].mm_per_step - pl_data->css_origin;
+#    endif
+        block->css_radius_rate = unit_vec[X_AXIS];
+    }
+#endif
     // Store programmed rate.
     if (block->motion.rapidMotion) {
-        block->programmed_rate = block->rapid_rate;
+        block->programmed_rate = replan->rapid_rate;
     } else {
         block->programmed_rate = pl_data->feed_rate;
         if (block->motion.inverseTime) {
             block->programmed_rate *= block->millimeters;
         }
     }
+#ifdef S_CURVE_ACCELERATION
+    // A smoothstep ramp peaks at 1.5 times its average acceleration, and its
+    // jerk is 6*a^2/dv at the ends, so limit the planned (average) acceleration
+    // by both. dv is taken as the programmed rate, a ramp from rest.
+    block->jerk         = limit_jerk_by_axis_maximum(unit_vec);
+    block->acceleration = MIN(block->acceleration * (2.0f / 3.0f), sqrtf(block->jerk * block->programmed_rate / 6.0f));
+#endif
     // TODO: Need to check this method handling zero junction speeds when starting from rest.
-    if ((block_buffer_head == block_buffer_tail) || (block->motion.systemMotion)) {
+    if (block_ring.empty() || (block->motion.systemMotion)) {
         // Initialize block entry speed as zero. Assume it will be starting from rest. Planner will correct this later.
         // If system motion, the system motion block always is assumed to start from rest and end at a complete stop.
-        block->entry_speed_sqr        = 0.0;
-        block->max_junction_speed_sqr = 0.0;  // Starting from rest. Enforce start from zero velocity.
+        block->entry_speed_sqr         = 0.0;
+        replan->max_junction_speed_sqr = 0.0;  // Starting from rest. Enforce start from zero velocity.
     } else {
-        // Compute maximum allowable entry speed at junction by centripetal acceleration approximation.
-        // Let a circle be tangent to both previous and current path line segments, where the junction
-        // deviation is defined as the distance from the junction to the closest edge of the circle,
-        // colinear with the circle center. The circular segment joining the two paths represents the
-        // path of centripetal acceleration. Solve for max velocity based on max acceleration about the
-        // radius of the circle, defined indirectly by junction deviation. This may be also viewed as
-        // path width or max_jerk in the previous Grbl version. This approach does not actually deviate
-        // from path, but used as a robust way to compute cornering speeds, as it takes into account the
-        // nonlinearities of both the junction angle and junction velocity.
-        //
-        // NOTE: If the junction deviation value is finite, Grbl executes the motions in an exact path
-        // mode (G61). If the junction deviation value is zero, Grbl will execute the motion in an exact
-        // stop mode (G61.1) manner. In the future, if continuous mode (G64) is desired, the math here
-        // is exactly the same. Instead of motioning all the way to junction point, the machine will
-        // just follow the arc circle defined here. The Arduino doesn't have the CPU cycles to perform
-        // a continuous mode path, but ARM-based microcontrollers most certainly do.
-        //
-        // NOTE: The max junction speed is a fixed value, since machine acceleration limits cannot be
-        // changed dynamically during operation nor can the line move geometry. This must be kept in
-        // memory in the event of a feedrate override changing the nominal speeds of blocks, which can
-        // change the overall maximum entry speed conditions of all blocks.
-        float junction_unit_vec[MAX_N_AXIS];
-        float junction_cos_theta = 0.0;
-        for (idx = 0; idx < n_axis; idx++) {
-            junction_cos_theta -= pl.previous_unit_vec[idx] * unit_vec[idx];
-            junction_unit_vec[idx] = unit_vec[idx] - pl.previous_unit_vec[idx];
-        }
-        // NOTE: Computed without any expensive trig, sin() or acos(), by trig half angle identity of cos(theta).
-        if (junction_cos_theta > 0.999999) {
-            //  For a 0 degree acute junction, just set minimum junction speed.
-            block->max_junction_speed_sqr = MINIMUM_JUNCTION_SPEED * MINIMUM_JUNCTION_SPEED;
-        } else {
-            if (junction_cos_theta < -0.999999) {
-                // Junction is a straight line or 180 degrees. Junction speed is infinite.
-                block->max_junction_speed_sqr = SOME_LARGE_VALUE;
-            } else {
-                convert_delta_vector_to_unit_vector(junction_unit_vec);
-                float junction_acceleration = limit_acceleration_by_axis_maximum(junction_unit_vec);
-                float sin_theta_d2          = sqrt(0.5 * (1.0 - junction_cos_theta));  // Trig half angle identity. Always positive.
-                block->max_junction_speed_sqr =
-                    MAX(MINIMUM_JUNCTION_SPEED * MINIMUM_JUNCTION_SPEED,
-                        (junction_acceleration * junction_deviation->get() * sin_theta_d2) / (1.0 - sin_theta_d2));
-            }
-        }
+        replan->max_junction_speed_sqr = plan_compute_max_junction_speed_sqr(unit_vec);
     }
     // Block system motion from updating this data to ensure next g-code motion is computed correctly.
     if (!(block->motion.systemMotion)) {
         float nominal_speed = plan_compute_profile_nominal_speed(block);
         plan_compute_profile_parameters(block, nominal_speed, pl.previous_nominal_speed);
+        float nominal_limit = MIN(nominal_speed, pl.previous_nominal_speed);
+        plan_stats.blocks++;
+        if (replan->max_junction_speed_sqr < nominal_limit * nominal_limit) {
+            plan_stats.junction_limited++;
+        }
+        if (!block->motion.rapidMotion && block->programmed_rate > replan->rapid_rate) {
+            plan_stats.rate_limited++;
+        }
         pl.previous_nominal_speed = nominal_speed;
         // Update previous path unit_vector and planner position.
         memcpy(pl.previous_unit_vec, unit_vec, sizeof(unit_vec));  // pl.previous_unit_vec[] = unit_vec[]
         memcpy(pl.position, target_steps, sizeof(target_steps));   // pl.position[] = target_steps[]
-        // New block is all set. Update buffer head and next buffer head indices.
-        block_buffer_head = next_buffer_head;
-        next_buffer_head  = plan_next_block_index(block_buffer_head);
+        // New block is all set. Publish it by advancing the buffer head.
+        block_ring.push();
         // Finish up by recalculating the plan with the new block.
-        planner_recalculate();
+        planner_recalculate(planner_recalculate_limit->get());
     }
     return PLAN_OK;
 }
 
+#ifdef SYNC_USER_OUTPUTS
+void plan_sync_outputs(const PlOutputs* outputs) {
+    pl.outputs.digitalOn  = (pl.outputs.digitalOn & ~outputs->digitalOff) | outputs->digitalOn;
+    pl.outputs.digitalOff = (pl.outputs.digitalOff & ~outputs->digitalOn) | outputs->digitalOff;
+    pl.outputs.analogSet |= outputs->analogSet;
+    for (uint8_t io_num = 0; io_num < MaxUserDigitalPin; io_num++) {
+        if (bitnum_istrue(outputs->analogSet, io_num)) {
+            pl.outputs.analog[io_num] = outputs->analog[io_num];
+        }
+    }
+}
+
+void plan_flush_outputs() {
+    sys_set_outputs(&pl.outputs);
+    memset(&pl.outputs, 0, sizeof(pl.outputs));
+}
+#endif
+
+#ifdef SYNC_COOLANT
+// The block takes its coolant from the line that queues it, which holds the latest state.
+void plan_sync_coolant(CoolantState state) {
+    pl.coolant      = state;
+    pl.coolant_sync = true;
+}
+
+void plan_flush_coolant() {
+    if (pl.coolant_sync) {
+        pl.coolant_sync = false;
+        coolant_set_state(pl.coolant);
+    }
+}
+#endif
+
+#ifdef SYNC_SPINDLE_SPEED
+void plan_sync_spindle(SpindleState state, uint32_t rpm) {
+    pl.spindle       = state;
+    pl.spindle_speed = rpm;
+    pl.spindle_sync  = true;
+}
+
+void plan_flush_spindle() {
+    if (pl.spindle_sync) {
+        pl.spindle_sync = false;
+        spindle->set_state(pl.spindle, pl.spindle_speed);
+    }
+}
+#endif
+
 // Reset the planner position vectors. Called by the system abort/initialization routine.
 void plan_sync_position() {
     // TODO: For motor configurations not in the same coordinate frame as the machine position,
     // this function needs to be updated to accomodate the difference.
     uint8_t idx;
     auto    n_axis = number_axis->get();
+    int32_t position[MAX_N_AXIS];
+    st_get_position(position);
     for (idx = 0; idx < n_axis; idx++) {
-        pl.position[idx] = sys_position[idx];
+        pl.position[idx] = position[idx];
+    }
+#ifdef AXIS_ENCODERS
+    axis_encoder_correct_planner(NULL);
+#endif
+}
+
+void plan_forget_backlash() {
+    pl.backlash_known_axes = 0;
+}
+
+// Returns the planner position, the end of the last queued line, in millimeters.
+void plan_get_planner_mpos(float* target) {
+    for (uint8_t idx = 0; idx < axis_count; idx++) {
+        target[idx] = pl.position[idx] * axis_limits[idx].mm_per_step;
     }
+#ifdef LINEAR_KINEMATICS
+    linear_kinematics_to_cartesian(target, target, axis_count);
+#endif
 }
 
 // Returns the number of available blocks are in the planner buffer.
 uint8_t plan_get_block_buffer_available() {
-    if (block_buffer_head >= block_buffer_tail) {
-        return (BLOCK_BUFFER_SIZE - 1) - (block_buffer_head - block_buffer_tail);
-    } else {
-        return block_buffer_tail - block_buffer_head - 1;
-    }
+    return block_buffer == NULL ? 0 : block_ring.available();
 }
 
 // Returns the number of active blocks are in the planner buffer.
 // NOTE: Deprecated. Not used unless classic status reports are enabled in config.h
 uint8_t plan_get_block_buffer_count() {
-    if (block_buffer_head >= block_buffer_tail) {
-        return block_buffer_head - block_buffer_tail;
-    } else {
-        return BLOCK_BUFFER_SIZE - (block_buffer_tail - block_buffer_head);
-    }
+    return block_ring.count();
 }
 
 // Re-initialize buffer plan with a partially completed block, assumed to exist at the buffer tail.
 // Called after a steppers have come to a complete stop for a feed hold and the cycle is stopped.
 void plan_cycle_reinitialize() {
+    st_prep_lock();
     // Re-plan from a complete stop. Reset planner entry speeds and buffer planned pointer.
     st_update_plan_block_parameters();
-    block_buffer_planned = block_buffer_tail;
-    planner_recalculate();
+    block_buffer_planned = block_ring.tail();
+    recalculate_pending  = false;
+    planner_recalculate(0);
+    st_prep_unlock();
 }
@@ -24,7 +24,8 @@
   along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-// The number of linear motions that can be in the plan at any give time
+// The default number of linear motions that can be in the plan at any give time.
+// The actual depth is the $Planner/BlockBuffer setting, applied at boot.
 #ifndef BLOCK_BUFFER_SIZE
 #    ifdef USE_LINE_NUMBERS
 #        define BLOCK_BUFFER_SIZE 15
@@ -37,17 +38,53 @@
 const int PLAN_OK          = true;
 const int PLAN_EMPTY_BLOCK = false;
 
+// $<axis>/Rotary. A rotary axis counts in degrees, and its $<axis>/Radius turns them into the
+// surface distance along the path, so F, the rate and acceleration limits and the junctions
+// of a mixed XYZ and rotary move are all in mm of the surface there.
+enum class RotaryMode : int8_t {
+    Linear   = 0,
+    Rotary   = 1,  // Degrees, absolute angles as programmed
+    Wrapped  = 2,  // Absolute angles modulo 360, within the turn the axis is on
+    Shortest = 3,  // Absolute angles modulo 360, the shorter way round
+};
+
 // Define planner data condition flags. Used to denote running conditions of a block.
 struct PlMotion {
     uint8_t rapidMotion : 1;
     uint8_t systemMotion : 1;    // Single motion. Circumvents planner state. Used by home/park.
     uint8_t noFeedOverride : 1;  // Motion does not honor feed override.
     uint8_t inverseTime : 1;     // Interprets feed rate value as inverse time when set.
+    uint8_t backlashMotion : 1;  // Takes up backlash. Its steps are not counted into the machine position.
 };
 
+#ifdef SYNC_USER_OUTPUTS
+// User output changes made as a block starts, for M62, M63 and M67. Bit n is output n.
+struct PlOutputs {
+    uint8_t  digitalOn;
+    uint8_t  digitalOff;
+    uint8_t  analogSet;
+    uint32_t analog[MaxUserDigitalPin];  // Duty numerators for the analogSet outputs
+};
+#endif
+
 // This struct stores a linear movement of a g-code block motion with its critical "nominal" values
-// are as specified in the source g-code.
+// are as specified in the source g-code. It holds what the planner passes and the segment generator
+// reads. The junction and rapid rate limits, needed only when a block is added or replanned for an
+// override, are kept apart in the planner so that a deeper buffer fits in the same RAM.
 typedef struct {
+    // Fields used by the motion planner to manage acceleration. Some of these values may be updated
+    // by the stepper module during execution of special motion cases for replanning purposes.
+    // planner_recalculate() touches only these, so they are kept together at the start.
+    float entry_speed_sqr;      // The current planned entry speed at block junction in (mm/min)^2
+    float max_entry_speed_sqr;  // Maximum allowable entry speed based on the minimum of junction limit and
+    //   neighboring nominal speeds with overrides in (mm/min)^2
+    float acceleration;  // Axis-limit adjusted line acceleration in (mm/min^2). Does not change.
+    float millimeters;   // The remaining distance for this block to be executed in (mm).
+    // NOTE: This value may be altered by stepper algorithm during execution.
+#ifdef S_CURVE_ACCELERATION
+    float jerk;  // Axis-limit adjusted line jerk in (mm/min^3). Does not change.
+#endif
+
     // Fields used by the bresenham algorithm for tracing the line
     // NOTE: Used by stepper algorithm to execute the block correctly. Do not alter these values.
     uint32_t steps[MAX_N_AXIS];     // Step count along each axis
@@ -62,23 +99,28 @@ typedef struct {
     int32_t line_number;  // Block line number for real-time reporting. Copied from pl_line_data.
 #endif
 
-    // Fields used by the motion planner to manage acceleration. Some of these values may be updated
-    // by the stepper module during execution of special motion cases for replanning purposes.
-    float entry_speed_sqr;      // The current planned entry speed at block junction in (mm/min)^2
-    float max_entry_speed_sqr;  // Maximum allowable entry speed based on the minimum of junction limit and
-    //   neighboring nominal speeds with overrides in (mm/min)^2
-    float acceleration;  // Axis-limit adjusted line acceleration in (mm/min^2). Does not change.
-    float millimeters;   // The remaining distance for this block to be executed in (mm).
-    // NOTE: This value may be altered by stepper algorithm during execution.
-
-    // Stored rate limiting data used by planner when changes occur.
-    float max_junction_speed_sqr;  // Junction entry speed limit based on direction vectors in (mm/min)^2
-    float rapid_rate;              // Axis-limit adjusted maximum rate for this block direction in (mm/min)
-    float programmed_rate;         // Programmed rate of this block (mm/min).
+    float programmed_rate;  // Programmed rate of this block (mm/min).
 
     // Stored spindle speed data used by spindle overrides and resuming methods.
     float spindle_speed;  // Block spindle speed. Copied from pl_line_data.
-    //#endif
+#ifdef RASTER_ENGRAVING
+    uint32_t raster_line;    // Raster line engraved along the block, 0 for none. Copied from pl_line_data.
+    uint16_t raster_pixels;  // Number of pixels in the line
+#endif
+#ifdef SPINDLE_SYNC
+    float sync_pitch;  // Path mm per spindle revolution, signed like the encoder count. 0 if not synchronized.
+#endif
+#ifdef CONSTANT_SURFACE_SPEED
+    float css_speed;        // G96 surface speed in mm/min, 0 for G97
+    float css_radius;       // Radius of the tool at the end of the block in mm
+    float css_radius_rate;  // Change of the radius per mm of the block
+#endif
+#ifdef SYNC_USER_OUTPUTS
+    PlOutputs outputs;  // Taken from plan_sync_outputs() by the block queued after it
+#endif
+#ifdef SYNC_COOLANT
+    bool coolant_sync;  // Set the coolant to the block coolant as the block starts. See plan_sync_coolant().
+#endif
 } plan_block_t;
 
 // Planner data prototype. Must be used when passing new motions to the planner.
@@ -91,7 +133,19 @@ typedef struct {
 #ifdef USE_LINE_NUMBERS
     int32_t line_number;  // Desired line number to report when executing.
 #endif
-    bool         is_jog;         // true if this was generated due to a jog command
+    bool         is_jog;           // true if this was generated due to a jog command
+    float        blend_tolerance;  // G64 corner blending tolerance in mm. Zero for exact path (G61).
+#ifdef RASTER_ENGRAVING
+    uint32_t raster_line;    // See raster_store(). 0 for an ordinary line.
+    uint16_t raster_pixels;  // Number of pixels in the line
+#endif
+#ifdef SPINDLE_SYNC
+    float sync_pitch;  // G33 K: Z mm per spindle revolution, signed like the encoder count. 0 for an ordinary line.
+#endif
+#ifdef CONSTANT_SURFACE_SPEED
+    float css_speed;   // G96 surface speed in mm/min, 0 for G97
+    float css_origin;  // Machine X of the spindle axis in mm
+#endif
 } plan_line_data_t;
 
 // Initialize and reset the motion plan subsystem
@@ -119,18 +173,93 @@ uint8_t plan_next_block_index(uint8_t block_index);
 // Called by step segment buffer when computing executing block velocity profile.
 float plan_get_exec_block_exit_speed_sqr();
 
+// Seconds the block takes at the speeds planned for it, kept up to date by each replan.
+float plan_get_block_time(const plan_block_t* block);
+
+// Seconds until the motion queued in the planner and the segment buffer is done, at the
+// planned speeds and the current overrides. Dwells and hold time are not counted.
+float plan_get_queued_time();
+
 // Called by main program during planner calculations and step segment buffer during initialization.
 float plan_compute_profile_nominal_speed(plan_block_t* block);
 
+// The axis limited rate along the block. A spindle synchronized block may need up to this.
+float plan_get_block_rapid_rate(const plan_block_t* block);
+
 // Re-calculates buffered motions profile parameters upon a motion-based override change.
 void plan_update_velocity_profile_parameters();
 
+#ifdef SYNC_USER_OUTPUTS
+// Holds output changes for the next queued block, merged with any already waiting.
+void plan_sync_outputs(const PlOutputs* outputs);
+
+// Makes the changes still waiting for a block. Called once the buffer has drained.
+void plan_flush_outputs();
+#endif
+
+#ifdef SYNC_COOLANT
+// Has the next queued block set the coolant to state as it starts.
+void plan_sync_coolant(CoolantState state);
+
+// Sets the coolant if no block has taken the change. Called once the buffer has drained.
+void plan_flush_coolant();
+#endif
+
+#ifdef SYNC_SPINDLE_SPEED
+// Notes a spindle speed that the next queued block will carry.
+void plan_sync_spindle(SpindleState state, uint32_t rpm);
+
+// Sets the spindle speed if no block has taken it. Called once the buffer has drained.
+void plan_flush_spindle();
+#endif
+
 // Reset the planner position vector (in steps)
 void plan_sync_position();
 
+// Forgets the last direction of every axis, so the next move of each is not compensated for
+// backlash. Called after homing, which takes up the slack against the switches.
+void plan_forget_backlash();
+
 // Reinitialize plan with a partially completed block
 void plan_cycle_reinitialize();
 
+// Counts of what kept blocks below their programmed feed, reported by $Planner/Stats.
+// The planner fills in the counts known when a block is queued and the segment
+// generator the rest when it finishes a block. Reset with $Planner/Stats=clear.
+struct PlannerStats {
+    uint32_t blocks;            // Blocks queued, not counting system motions
+    uint32_t junction_limited;  // Entry speed capped by the junction speed, $11
+    uint32_t rate_limited;      // Programmed feed above the axis maximum rates
+    uint32_t accel_limited;     // Executed blocks too short to reach their nominal speed
+    uint32_t override_limited;  // Executed blocks slowed by a feed or rapid override
+    uint32_t starved;           // Times the segment generator ran out of planner blocks mid-cycle
+    float    mm;                // Distance of the executed blocks
+    float    programmed_mm;     // Sum of programmed speed times distance, for the average
+    float    planned_mm;        // Sum of peak planned speed times distance, for the average
+};
+extern PlannerStats plan_stats;
+
+void plan_reset_stats();
+
+// Allocates the planner buffer with the configured depth. Called once at boot.
+void plan_init();
+
+// False if plan_init() could not allocate even the default buffer. The machine then stays in
+// alarm, and lines given to plan_buffer_line() are dropped.
+bool plan_ready();
+
+// Refreshes the planner's copy of the per-axis steps/mm, rate, acceleration, jerk and rotary
+// settings. Called at boot and whenever one of them changes.
+void plan_update_axis_limits();
+
+RotaryMode plan_rotary_mode(uint8_t axis);
+
+// Finishes any plan optimization deferred by the $Planner/RecalculateLimit work cap.
+void plan_idle_recalculate();
+
+// Returns the number of entries allocated for the planner buffer, one more than it can hold.
+uint8_t plan_get_block_buffer_size();
+
 // Returns the number of available blocks are in the planner buffer.
 uint8_t plan_get_block_buffer_available();
 
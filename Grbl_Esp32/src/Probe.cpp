@@ -26,6 +26,18 @@
 // Inverts the probe pin state depending on user settings and probing cycle mode.
 static bool is_probe_away;
 
+#ifdef PROBE_EDGE_CAPTURE
+// Records the position at the edge that triggers the probe, in place of the per-tick check
+// by the stepper ISR. Both edges interrupt, since G38.4 and G38.5 trigger on losing contact.
+static void IRAM_ATTR isr_probe_edge() {
+    if (sys_probe_state == Probe::Active && (probe_get_state() ^ is_probe_away)) {
+        sys_probe_state = Probe::Off;
+        st_get_probe_position(sys_probe_position);
+        sys_rt_exec_state.bit.motionCancel = true;
+    }
+}
+#endif
+
 // Probe pin initialization routine.
 void probe_init() {
     static bool show_init_msg = true;  // used to show message only once.
@@ -36,6 +48,10 @@ void probe_init() {
 #else
         pinMode(PROBE_PIN, INPUT_PULLUP);  // Enable internal pull-up resistors. Normal high operation.
 #endif
+#ifdef PROBE_EDGE_CAPTURE
+        // Attached from the same core as the stepper timer interrupt, see st_get_probe_position()
+        attachInterrupt(digitalPinToInterrupt(PROBE_PIN), isr_probe_edge, CHANGE);
+#endif
 
         if (show_init_msg) {
             grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Probe on pin %s", pinName(PROBE_PIN).c_str());
@@ -59,7 +75,7 @@ bool probe_get_state() {
 void probe_state_monitor() {
     if (probe_get_state() ^ is_probe_away) {
         sys_probe_state = Probe::Off;
-        memcpy(sys_probe_position, sys_position, sizeof(sys_position));
+        st_get_position(sys_probe_position);
         sys_rt_exec_state.bit.motionCancel = true;
     }
 }
@@ -39,5 +39,5 @@ void set_probe_direction(bool is_away);
 bool probe_get_state();
 
 // Monitors probe pin state and records the system position when detected. Called by the
-// stepper ISR per ISR tick.
+// stepper ISR per ISR tick, unless PROBE_EDGE_CAPTURE uses the pin interrupt instead.
 void probe_state_monitor();
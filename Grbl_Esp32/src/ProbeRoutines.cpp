@@ -0,0 +1,290 @@
+/*
+  ProbeRoutines.cpp - Multi-point probing cycles run by the firmware
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  Each routine runs its G38 probes and moves back to back through the parser, the same way
+  $HeightMap/Probe does, so there is no host round trip between points. The contact points are
+  kept in machine coordinates and reported together when the routine completes. Distances are
+  from contact to contact, without the stylus diameter.
+*/
+
+#include "Grbl.h"
+
+enum class ProbeRoutine : uint8_t {
+    None = 0,
+    Edge,
+    Bore,
+    Boss,
+    Flatness,
+};
+
+typedef struct {
+    ProbeRoutine routine;
+    uint8_t      count;
+    float        point[PROBE_TABLE_MAX_POINTS][3];  // Machine XYZ of each contact
+    float        result[4];                         // Depends on the routine, see probe_routine_report()
+} probe_table_t;
+
+static probe_table_t table;
+static bool          was_incremental;
+
+// Runs one line of G-code for the routine.
+static Error probe_execute(uint8_t client, const char* format, ...) {
+    char    line[LINE_BUFFER_SIZE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    Error status = gc_execute_line(line, client);
+    if (status == Error::Ok && sys.abort) {
+        status = Error::ProbeRoutineIncomplete;
+    }
+    return status;
+}
+
+static Error probe_begin() {
+    if (sys.state != State::Idle) {
+        return Error::IdleError;
+    }
+    table.routine   = ProbeRoutine::None;
+    table.count     = 0;
+    was_incremental = gc_state.modal.distance == Distance::Incremental;
+    return Error::Ok;
+}
+
+static Error probe_end(ProbeRoutine routine, Error status, uint8_t client) {
+    if (!sys.abort) {
+        probe_execute(client, was_incremental ? "G91" : "G90");
+    }
+    if (status == Error::Ok) {
+        table.routine = routine;
+        probe_routine_report(client);
+    }
+    return status;
+}
+
+static void probe_machine_position(float* position) {
+    system_convert_array_steps_to_mpos(position, sys_position);
+}
+
+// Probes along axis by distance, signed, records the contact and goes back to the start.
+static Error probe_contact(uint8_t axis, float distance, uint8_t client, float* contact) {
+    char  letter = report_get_axis_letter(axis);
+    float start[MAX_N_AXIS];
+    probe_machine_position(start);
+    Error status = probe_execute(client, "G91G38.2%c%.4fF%.1f", letter, distance, probe_feed->get());
+    if (status == Error::Ok && !sys.probe_succeeded) {
+        status = Error::ProbeRoutineIncomplete;  // G38.2 has already raised the probe alarm.
+    }
+    if (status != Error::Ok) {
+        return status;
+    }
+    float probe[MAX_N_AXIS];
+    system_convert_array_steps_to_mpos(probe, sys_probe_position);
+    if (table.count < PROBE_TABLE_MAX_POINTS) {
+        memcpy(table.point[table.count++], probe, sizeof(table.point[0]));
+    }
+    *contact = probe[axis];
+    return probe_execute(client, "G53G0%c%.4f", letter, start[axis]);
+}
+
+// Probes both ways along axis and moves to the middle. Sets the span between the contacts.
+static Error probe_center(uint8_t axis, float distance, uint8_t client, float* center, float* span) {
+    float low, high;
+    Error status = probe_contact(axis, -distance, client, &low);
+    if (status == Error::Ok) {
+        status = probe_contact(axis, distance, client, &high);
+    }
+    if (status != Error::Ok) {
+        return status;
+    }
+    *center = 0.5f * (low + high);
+    *span   = high - low;
+    return probe_execute(client, "G53G0%c%.4f", report_get_axis_letter(axis), *center);
+}
+
+Error probe_edge(uint8_t axis, bool negative, float distance, uint8_t client) {
+    if (axis >= number_axis->get() || distance <= 0.0f) {
+        return Error::InvalidValue;
+    }
+    Error status = probe_begin();
+    if (status != Error::Ok) {
+        return status;
+    }
+    status          = probe_contact(axis, negative ? -distance : distance, client, &table.result[0]);
+    table.result[1] = axis;
+    return probe_end(ProbeRoutine::Edge, status, client);
+}
+
+Error probe_bore(float distance, uint8_t client) {
+    if (distance <= 0.0f) {
+        return Error::InvalidValue;
+    }
+    Error status = probe_begin();
+    if (status != Error::Ok) {
+        return status;
+    }
+    // The first X pass is off center in Y, so X is probed again once Y is centered.
+    status = probe_center(X_AXIS, distance, client, &table.result[0], &table.result[2]);
+    if (status == Error::Ok) {
+        status = probe_center(Y_AXIS, distance, client, &table.result[1], &table.result[3]);
+    }
+    if (status == Error::Ok) {
+        status = probe_center(X_AXIS, distance, client, &table.result[0], &table.result[2]);
+    }
+    return probe_end(ProbeRoutine::Bore, status, client);
+}
+
+Error probe_boss(float radius, float depth, uint8_t client) {
+    if (radius <= 0.0f || depth <= 0.0f) {
+        return Error::InvalidValue;
+    }
+    Error status = probe_begin();
+    if (status != Error::Ok) {
+        return status;
+    }
+    float start[MAX_N_AXIS];
+    probe_machine_position(start);
+    float contact[4];
+    for (int side = 0; side < 4 && status == Error::Ok; side++) {
+        uint8_t axis   = side < 2 ? X_AXIS : Y_AXIS;
+        float   sign   = (side & 1) ? 1.0f : -1.0f;
+        char    letter = report_get_axis_letter(axis);
+        status         = probe_execute(client, "G53G0%c%.4f", letter, start[axis] + sign * radius);
+        if (status == Error::Ok) {
+            // Going down with G38.3 stops on anything in the way instead of pushing into it.
+            status = probe_execute(client, "G91G38.3Z%.4fF%.1f", -depth, probe_feed->get());
+        }
+        if (status == Error::Ok && sys.probe_succeeded) {
+            status = Error::ProbeRoutineIncomplete;
+        }
+        if (status == Error::Ok) {
+            status = probe_contact(axis, -sign * radius, client, &contact[side]);
+        }
+        if (status == Error::Ok) {
+            status = probe_execute(client, "G53G0Z%.4f", start[Z_AXIS]);
+        }
+        if (status == Error::Ok) {
+            status = probe_execute(client, "G53G0%c%.4f", letter, start[axis]);
+        }
+    }
+    if (status == Error::Ok) {
+        table.result[0] = 0.5f * (contact[0] + contact[1]);
+        table.result[1] = 0.5f * (contact[2] + contact[3]);
+        table.result[2] = contact[1] - contact[0];
+        table.result[3] = contact[3] - contact[2];
+        status          = probe_execute(client, "G53G0X%.4fY%.4f", table.result[0], table.result[1]);
+    }
+    return probe_end(ProbeRoutine::Boss, status, client);
+}
+
+// Fits z = mean + bx * (x - x_mean) + by * (y - y_mean) to the contacts by least squares and
+// keeps the spread of the points about that plane, the spread of their heights and the slopes.
+static void probe_fit_plane() {
+    float n  = table.count;
+    float xm = 0.0f, ym = 0.0f, zm = 0.0f;
+    for (int i = 0; i < table.count; i++) {
+        xm += table.point[i][X_AXIS] / n;
+        ym += table.point[i][Y_AXIS] / n;
+        zm += table.point[i][Z_AXIS] / n;
+    }
+    float sxx = 0.0f, sxy = 0.0f, syy = 0.0f, sxz = 0.0f, syz = 0.0f;
+    for (int i = 0; i < table.count; i++) {
+        float x = table.point[i][X_AXIS] - xm;
+        float y = table.point[i][Y_AXIS] - ym;
+        float z = table.point[i][Z_AXIS] - zm;
+        sxx += x * x;
+        sxy += x * y;
+        syy += y * y;
+        sxz += x * z;
+        syz += y * z;
+    }
+    float det = sxx * syy - sxy * sxy;
+    float bx  = det != 0.0f ? (sxz * syy - syz * sxy) / det : 0.0f;
+    float by  = det != 0.0f ? (syz * sxx - sxz * sxy) / det : 0.0f;
+    float low = 0.0f, high = 0.0f, z_low = 0.0f, z_high = 0.0f;
+    for (int i = 0; i < table.count; i++) {
+        float z = table.point[i][Z_AXIS];
+        float r = z - zm - bx * (table.point[i][X_AXIS] - xm) - by * (table.point[i][Y_AXIS] - ym);
+        if (i == 0 || r < low) {
+            low = r;
+        }
+        if (i == 0 || r > high) {
+            high = r;
+        }
+        if (i == 0 || z < z_low) {
+            z_low = z;
+        }
+        if (i == 0 || z > z_high) {
+            z_high = z;
+        }
+    }
+    table.result[0] = high - low;
+    table.result[1] = z_high - z_low;
+    table.result[2] = bx;
+    table.result[3] = by;
+}
+
+Error probe_flatness(float x0, float y0, float x1, float y1, uint8_t nx, uint8_t ny, uint8_t client) {
+    if (nx < 2 || ny < 2 || nx * ny > PROBE_TABLE_MAX_POINTS || x0 == x1 || y0 == y1) {
+        return Error::InvalidValue;
+    }
+    Error status = probe_begin();
+    if (status != Error::Ok) {
+        return status;
+    }
+    // Work to machine coordinates, the same way the parser applies them.
+    float ox = x0 + gc_state.coord_system[X_AXIS] + gc_state.coord_offset[X_AXIS];
+    float oy = y0 + gc_state.coord_system[Y_AXIS] + gc_state.coord_offset[Y_AXIS];
+    float dx = (x1 - x0) / (nx - 1);
+    float dy = (y1 - y0) / (ny - 1);
+    for (uint8_t j = 0; j < ny && status == Error::Ok; j++) {
+        for (uint8_t n = 0; n < nx && status == Error::Ok; n++) {
+            uint8_t i = (j & 1) ? nx - 1 - n : n;  // Serpentine order keeps the XY moves short
+            float   z;
+            status = probe_execute(client, "G53G0X%.4fY%.4f", ox + i * dx, oy + j * dy);
+            if (status == Error::Ok) {
+                status = probe_contact(Z_AXIS, -probe_depth->get(), client, &z);
+            }
+        }
+    }
+    if (status == Error::Ok) {
+        probe_fit_plane();
+    }
+    return probe_end(ProbeRoutine::Flatness, status, client);
+}
+
+void probe_routine_report(uint8_t client) {
+    const float* r = table.result;
+    switch (table.routine) {
+        case ProbeRoutine::Edge:
+            grbl_sendf(client, "[MSG: Edge %c%.3f]\r\n", report_get_axis_letter(uint8_t(r[1])), r[0]);
+            break;
+        case ProbeRoutine::Bore:
+            grbl_sendf(client, "[MSG: Bore center X%.3f Y%.3f diameter X%.3f Y%.3f]\r\n", r[0], r[1], r[2], r[3]);
+            break;
+        case ProbeRoutine::Boss:
+            grbl_sendf(client, "[MSG: Boss center X%.3f Y%.3f diameter X%.3f Y%.3f]\r\n", r[0], r[1], r[2], r[3]);
+            break;
+        case ProbeRoutine::Flatness:
+            grbl_sendf(client, "[MSG: Flatness %.4f range %.4f slope X%.5f Y%.5f]\r\n", r[0], r[1], r[2], r[3]);
+            break;
+        default:
+            grbl_sendf(client, "[MSG: No probing results]\r\n");
+            return;
+    }
+    for (int i = 0; i < table.count; i++) {
+        grbl_sendf(client, "[MSG:%d X%.3f Y%.3f Z%.3f]\r\n", i, table.point[i][X_AXIS], table.point[i][Y_AXIS], table.point[i][Z_AXIS]);
+    }
+}
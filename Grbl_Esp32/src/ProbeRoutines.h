@@ -0,0 +1,45 @@
+#pragma once
+
+/*
+  ProbeRoutines.h - Multi-point probing cycles run by the firmware
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Error.h"
+
+#include <cstdint>
+
+// Contact points kept from the last routine, which also limits the flatness grid.
+const int PROBE_TABLE_MAX_POINTS = 64;
+
+// Probes along one axis from the current position, toward negative if negative is set, for up
+// to distance, and returns to the start.
+Error probe_edge(uint8_t axis, bool negative, float distance, uint8_t client);
+
+// Finds the center of a hole from a start point inside it, at the probing depth. Probes X, then
+// centers and probes Y, then centers and probes X again, each direction up to distance. Ends at
+// the center.
+Error probe_bore(float distance, uint8_t client);
+
+// Finds the center of a boss from a start point above it. For each side, moves out by radius,
+// down by depth, probes back toward the center and returns up to the start height. Ends at the
+// center.
+Error probe_boss(float radius, float depth, uint8_t client);
+
+// Probes Z on an nx by ny grid spanning the work coordinates x0,y0 to x1,y1, like
+// $HeightMap/Probe, and reports how far the points are from their best fit plane.
+Error probe_flatness(float x0, float y0, float x1, float y1, uint8_t nx, uint8_t ny, uint8_t client);
+
+// Sends the contact points and result of the last routine to the client.
+void probe_routine_report(uint8_t client);
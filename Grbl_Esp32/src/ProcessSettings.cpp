@@ -33,6 +33,8 @@ void show_setting(const char* name, const char* value, const char* description,
 }
 
 void settings_restore(uint8_t restore_flag) {
+    // Every setting may change, so write them to NVS together.
+    Setting::beginBatch();
 #ifdef WIFI_OR_BLUETOOTH
     if (restore_flag & SettingsRestore::Wifi) {
 #    ifdef ENABLE_WIFI
@@ -55,13 +57,16 @@ void settings_restore(uint8_t restore_flag) {
                 }
             }
         }
+        plan_update_axis_limits();
         grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Settings reset done");
     }
     if (restore_flag & SettingsRestore::Parameters) {
         for (auto idx = CoordIndex::Begin; idx < CoordIndex::End; ++idx) {
             coords[idx]->setDefault();
         }
+        Coordinates::persist();
     }
+    Setting::commitBatch();
     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Position offsets reset done");
 }
 
@@ -79,11 +84,14 @@ namespace WebUI {
     extern void make_web_settings();
 }
 
+static void index_init();
+
 void settings_init() {
     make_settings();
     WebUI::make_web_settings();
     make_grbl_commands();
     load_settings();
+    index_init();
 }
 
 // TODO Settings - jog may need to be special-cased in the parser, since
@@ -206,6 +214,9 @@ Error toggle_check_mode(const char* value, WebUI::AuthenticationLevel auth_level
 }
 Error disable_alarm_lock(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
     if (sys.state == State::Alarm) {
+        if (!plan_ready()) {
+            return Error::PlannerNoMemory;
+        }
         // Block if safety door is ajar.
         if (system_check_safety_door_ajar()) {
             return Error::CheckDoor;
@@ -224,6 +235,9 @@ Error home(int cycle) {
     if (homing_enable->get() == false) {
         return Error::SettingDisabled;
     }
+    if (!plan_ready()) {
+        return Error::PlannerNoMemory;
+    }
     if (system_check_safety_door_ajar()) {
         return Error::CheckDoor;  // Block if safety door is ajar.
     }
@@ -314,6 +328,379 @@ Error restore_settings(const char* value, WebUI::AuthenticationLevel auth_level,
     return Error::Ok;
 }
 
+// Reports the segment buffer use and its underruns, the most recent last. Any value, e.g.
+// $Stepper/SegmentStats=clear, clears the underruns after reporting.
+Error report_segment_stats(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    StepperUnderrunStats underruns = st_underrun_stats;
+    grbl_sendf(out->client(),
+               "[MSG: Segment buffer size: %d High water: %d Planner buffer size: %d Underruns: %u]\r\n",
+               st_get_segment_buffer_size(),
+               st_get_segment_buffer_high_water(),
+               plan_get_block_buffer_size(),
+               underruns.count);
+    uint32_t first = underruns.count > STEPPER_UNDERRUN_HISTORY ? underruns.count - STEPPER_UNDERRUN_HISTORY : 0;
+    uint32_t now   = esp_timer_get_time() / 1000;
+    for (uint32_t n = first; n < underruns.count; n++) {
+        const StepperUnderrun& underrun = underruns.recent[n % STEPPER_UNDERRUN_HISTORY];
+        grbl_sendf(out->client(), "[MSG: Underrun %u at line %u, %u ms ago]\r\n", n + 1, underrun.line, now - underrun.time_ms);
+    }
+    if (value) {
+        st_reset_underrun_stats();
+    }
+    return Error::Ok;
+}
+
+// Reports the stepper interrupt timing. Any value, e.g. $Stepper/IsrStats=clear,
+// clears the counters after reporting.
+Error report_isr_stats(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    StepperIsrStats stats = st_isr_stats;
+    uint32_t        mhz   = getCpuFrequencyMhz();
+    int32_t         slack = stats.ticks ? stats.min_slack / ticksPerMicrosecond : 0;
+    grbl_sendf(out->client(),
+               "[MSG: Stepper ISR ticks: %u Reentered: %u Skipped: %u Max: %u cycles (%u us) Min slack: %d us]\r\n",
+               stats.ticks,
+               stats.reentered,
+               stats.skipped,
+               stats.max_cycles,
+               stats.max_cycles / mhz,
+               slack);
+    if (value) {
+        st_reset_isr_stats();
+    }
+    return Error::Ok;
+}
+
+#ifdef STEP_TRACE
+// $Stepper/Trace=on starts a step trace and $Stepper/Trace=off stops it. Without a value,
+// sends what has been recorded since the last time.
+Error step_trace_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    if (!value) {
+        step_trace_report(out->client());
+    } else if (!strcasecmp(value, "on")) {
+        if (!step_trace_start()) {
+            return Error::StepTraceNoMemory;
+        }
+    } else if (!strcasecmp(value, "off")) {
+        step_trace_stop();
+    } else {
+        return Error::InvalidValue;
+    }
+    return Error::Ok;
+}
+#endif
+
+#ifdef POSITION_CAPTURE
+// $Capture=socket starts a capture to the WebUI socket subscribers, $Capture=/name one to a
+// file on the SD card, and $Capture=off stops it. Without a value, reports the capture.
+Error capture_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    if (!value) {
+        capture_report(out->client());
+    } else if (!strcasecmp(value, "off")) {
+        capture_stop();
+    } else if (!strcasecmp(value, "socket")) {
+        if (!capture_start(CaptureSink::Socket, NULL, out->client())) {
+            return Error::CaptureFailed;
+        }
+    } else if (value[0] == '/') {
+        if (!capture_start(CaptureSink::File, value, out->client())) {
+            return Error::CaptureFailed;
+        }
+    } else {
+        return Error::InvalidValue;
+    }
+    return Error::Ok;
+}
+#endif
+
+#ifdef EVENT_TRACE
+// $Trace sends the event trace as Chrome trace JSON and starts a new one. $Trace=clear
+// starts a new one without sending.
+Error event_trace_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    if (!value) {
+        event_trace_report(out->client());
+    } else if (!strcasecmp(value, "clear")) {
+        event_trace_clear();
+    } else {
+        return Error::InvalidValue;
+    }
+    return Error::Ok;
+}
+#endif
+
+// Reports the latency of each control input that has been used. Any value, e.g.
+// $Control/Stats=clear, clears the counts after reporting.
+Error report_control_stats(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    static const char* names[ControlInputCount] = { "Door", "Reset", "Hold", "Start", "Macro0", "Macro1", "Macro2", "Macro3" };
+    for (int input = 0; input < ControlInputCount; input++) {
+        ControlLatency latency = control_latency[input];
+        if (latency.count == 0) {
+            continue;
+        }
+        char  buckets[CONTROL_LATENCY_BUCKETS * 11 + 1];
+        char* p = buckets;
+        for (int i = 0; i < CONTROL_LATENCY_BUCKETS; i++) {
+            p += sprintf(p, i ? ",%u" : "%u", latency.bucket[i]);
+        }
+        grbl_sendf(out->client(),
+                   "[MSG: Control %s Count: %u Max: %u us Buckets: %s]\r\n",
+                   names[input],
+                   latency.count,
+                   latency.max_us,
+                   buckets);
+    }
+    if (value) {
+        system_clear_control_latency();
+    }
+    return Error::Ok;
+}
+
+Error report_uart_stats(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    UartTxStats stats = Uart0.txStats();
+    grbl_sendf(out->client(),
+               "[MSG: UART TX queue size: %d High water: %u Full waits: %u Dropped: %u messages (%u bytes)]\r\n",
+               UART_TX_QUEUE_SIZE,
+               stats.high_water,
+               stats.full_waits,
+               stats.dropped_writes,
+               stats.dropped_bytes);
+    return Error::Ok;
+}
+
+// Reports why the planner kept blocks below their programmed feed. Any value, e.g.
+// $Planner/Stats=clear, clears the counters after reporting, e.g. at the start of a job.
+Error report_planner_stats(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    PlannerStats stats = plan_stats;
+    float        mm    = stats.mm > 0.0 ? stats.mm : 1.0;
+    grbl_sendf(out->client(),
+               "[MSG: Planner blocks: %u Junction limited: %u Rate limited: %u Accel limited: %u Override limited: %u Starved: %u]\r\n",
+               stats.blocks,
+               stats.junction_limited,
+               stats.rate_limited,
+               stats.accel_limited,
+               stats.override_limited,
+               stats.starved);
+    grbl_sendf(out->client(),
+               "[MSG: Planner distance: %.1f mm Avg programmed: %.0f mm/min Avg planned: %.0f mm/min]\r\n",
+               stats.mm,
+               stats.programmed_mm / mm,
+               stats.planned_mm / mm);
+    if (value) {
+        plan_reset_stats();
+    }
+    return Error::Ok;
+}
+
+// $HeightMap/Probe=<x0>,<y0>,<x1>,<y1>,<nx>,<ny> probes an nx by ny grid over that work
+// coordinate rectangle, starting from the current Z, which must clear the stock.
+Error heightmap_probe_grid(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    float    corners[4];
+    uint32_t nx, ny;
+    if (!value || sscanf(value, "%f,%f,%f,%f,%u,%u", &corners[0], &corners[1], &corners[2], &corners[3], &nx, &ny) != 6 ||
+        nx > HEIGHTMAP_MAX_POINTS || ny > HEIGHTMAP_MAX_POINTS) {
+        return Error::InvalidValue;
+    }
+    return heightmap_probe(corners[0], corners[1], corners[2], corners[3], nx, ny, out->client());
+}
+
+// $Probe/Edge=X-,<distance>, $Probe/Bore=<distance>, $Probe/Boss=<radius>,<depth> and
+// $Probe/Flatness=<x0>,<y0>,<x1>,<y1>,<nx>,<ny> run the probing routines from the current position.
+Error probe_edge_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    char  letter, sign;
+    float distance;
+    if (!value || sscanf(value, "%c%c,%f", &letter, &sign, &distance) != 3 || (sign != '+' && sign != '-')) {
+        return Error::InvalidValue;
+    }
+    const char* axis = strchr("XYZABC", toupper(letter));
+    if (!axis || !*axis) {
+        return Error::InvalidValue;
+    }
+    return probe_edge(axis - "XYZABC", sign == '-', distance, out->client());
+}
+
+Error probe_bore_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    float distance;
+    if (!value || sscanf(value, "%f", &distance) != 1) {
+        return Error::InvalidValue;
+    }
+    return probe_bore(distance, out->client());
+}
+
+Error probe_boss_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    float radius, depth;
+    if (!value || sscanf(value, "%f,%f", &radius, &depth) != 2) {
+        return Error::InvalidValue;
+    }
+    return probe_boss(radius, depth, out->client());
+}
+
+Error probe_flatness_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    float    corners[4];
+    uint32_t nx, ny;
+    if (!value || sscanf(value, "%f,%f,%f,%f,%u,%u", &corners[0], &corners[1], &corners[2], &corners[3], &nx, &ny) != 6 ||
+        nx > PROBE_TABLE_MAX_POINTS || ny > PROBE_TABLE_MAX_POINTS) {
+        return Error::InvalidValue;
+    }
+    return probe_flatness(corners[0], corners[1], corners[2], corners[3], nx, ny, out->client());
+}
+
+Error probe_results_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    probe_routine_report(out->client());
+    return Error::Ok;
+}
+
+// $Tool/Pocket=<tool>,<x>,<y>,<z> sets where a tool sits in the rack, or with only the tool,
+// takes the current machine position, to teach a pocket with the tool seated in it.
+Error tool_pocket_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    uint32_t tool;
+    float    position[3];
+    if (!value) {
+        return Error::InvalidValue;
+    }
+    int n = sscanf(value, "%u,%f,%f,%f", &tool, &position[X_AXIS], &position[Y_AXIS], &position[Z_AXIS]);
+    if (n == 1) {
+        float mpos[MAX_N_AXIS];
+        system_convert_array_steps_to_mpos(mpos, sys_position);
+        memcpy(position, mpos, sizeof(position));
+    } else if (n != 4) {
+        return Error::InvalidValue;
+    }
+    return tool > TOOL_TABLE_MAX ? Error::ToolNumberInvalid : tool_table_set_pocket(tool, position);
+}
+
+// $Tool/Loaded=<tool> tells the tool changer what is in the spindle, 0 for nothing.
+Error tool_loaded_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    if (!value) {
+        grbl_sendf(out->client(), "$Tool/Loaded=%d\r\n", tool_table_loaded());
+        return Error::Ok;
+    }
+    uint32_t tool;
+    if (sscanf(value, "%u", &tool) != 1 || tool > TOOL_TABLE_MAX) {
+        return Error::ToolNumberInvalid;
+    }
+    tool_table_set_loaded(tool);
+    return Error::Ok;
+}
+
+Error tool_list_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    tool_table_report(out->client());
+    return Error::Ok;
+}
+
+Error tool_clear_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    tool_table_clear();
+    return Error::Ok;
+}
+
+Error heightmap_show(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    heightmap_report(out->client());
+    return Error::Ok;
+}
+
+Error heightmap_forget(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    heightmap_clear();
+    return Error::Ok;
+}
+
+// $Profile/Save=<name> keeps the present machine settings under that name and
+// $Profile/Load=<name> switches to them, for example when changing tool heads.
+Error profile_save_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    return profile_save(value, out->client());
+}
+
+Error profile_load_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    return profile_load(value, out->client());
+}
+
+Error profile_delete_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    return profile_delete(value);
+}
+
+Error profile_list_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    profile_list(out->client());
+    return Error::Ok;
+}
+
+// $Bench/Parse, $Bench/Plan, $Bench/Prep and $Bench/DryRun run the built-in program, or
+// the SD file given as the value, e.g. $Bench/Plan=/job.nc, that far down the motion path.
+// $Bench/All runs the first three in turn.
+Error bench_parse_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    return bench_run(BenchStage::Parse, value, out->client());
+}
+
+Error bench_plan_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    return bench_run(BenchStage::Plan, value, out->client());
+}
+
+Error bench_prep_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    return bench_run(BenchStage::Prep, value, out->client());
+}
+
+Error bench_dry_run_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    return bench_run(BenchStage::DryRun, value, out->client());
+}
+
+Error bench_all_cmd(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    Error status = Error::Ok;
+    for (auto stage : { BenchStage::Parse, BenchStage::Plan, BenchStage::Prep }) {
+        if (status == Error::Ok && !sys.abort) {
+            status = bench_run(stage, value, out->client());
+        }
+    }
+    return status;
+}
+
+Error report_heap(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    heap_report(out->client());
+    return Error::Ok;
+}
+
+Error report_tasks(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    task_report(out->client());
+    return Error::Ok;
+}
+
+#ifdef ENABLE_ESP_NOW_SYNC
+Error report_sync(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    esp_now_sync_report(out->client());
+    return Error::Ok;
+}
+#endif
+
+Error report_boot_times(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    report_boot_stages(out->client());
+    return Error::Ok;
+}
+
+// $Report/Interval=<ms> makes the firmware push status reports to the client that sends it
+// every <ms> milliseconds, 0 turns them off. Without a value it shows the current interval.
+Error report_interval(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    if (!value) {
+        grbl_sendf(out->client(), "$Report/Interval=%u\r\n", report_get_auto_interval(out->client()));
+        return Error::Ok;
+    }
+    char*    endptr   = NULL;
+    uint32_t interval = strtoul(value, &endptr, 10);
+    if (endptr == value || *endptr != '\0') {
+        return Error::BadNumberFormat;
+    }
+    report_set_auto_interval(out->client(), interval);
+    return Error::Ok;
+}
+
+// $Report/Delta=1 switches the client that sends it to compact status reports that only carry
+// changed fields, $Report/Delta=0 back to full ones. Without a value it shows the current mode.
+Error report_delta_mode(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    if (!value) {
+        grbl_sendf(out->client(), "$Report/Delta=%d\r\n", report_get_delta(out->client()));
+        return Error::Ok;
+    }
+    if (strcmp(value, "0") && strcmp(value, "1")) {
+        return Error::InvalidValue;
+    }
+    report_set_delta(out->client(), value[0] == '1');
+    return Error::Ok;
+}
+
 Error showState(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
     grbl_sendf(out->client(), "State 0x%x\r\n", sys.state);
     return Error::Ok;
@@ -332,9 +719,11 @@ Error doJog(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESP
     return gc_execute_line(jogLine, out->client());
 }
 
-const char* alarmString(ExecAlarm alarmNumber) {
-    auto it = AlarmNames.find(alarmNumber);
-    return it == AlarmNames.end() ? NULL : it->second;
+Error doVelocityJog(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    if (!value) {
+        return Error::InvalidStatement;
+    }
+    return jog_velocity_start(value);
 }
 
 Error listAlarms(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
@@ -355,17 +744,15 @@ Error listAlarms(const char* value, WebUI::AuthenticationLevel auth_level, WebUI
         }
     }
 
-    for (auto it = AlarmNames.begin(); it != AlarmNames.end(); it++) {
-        grbl_sendf(out->client(), "%d: %s\r\n", it->first, it->second);
+    for (int alarmNumber = 0; alarmNumber <= UINT8_MAX; alarmNumber++) {
+        const char* alarmName = alarmString(static_cast<ExecAlarm>(alarmNumber));
+        if (alarmName) {
+            grbl_sendf(out->client(), "%d: %s\r\n", alarmNumber, alarmName);
+        }
     }
     return Error::Ok;
 }
 
-const char* errorString(Error errorNumber) {
-    auto it = ErrorNames.find(errorNumber);
-    return it == ErrorNames.end() ? NULL : it->second;
-}
-
 Error listErrors(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
     if (value) {
         char*   endptr      = NULL;
@@ -384,8 +771,11 @@ Error listErrors(const char* value, WebUI::AuthenticationLevel auth_level, WebUI
         }
     }
 
-    for (auto it = ErrorNames.begin(); it != ErrorNames.end(); it++) {
-        grbl_sendf(out->client(), "%d: %s\r\n", it->first, it->second);
+    for (int errorNumber = 0; errorNumber <= UINT8_MAX; errorNumber++) {
+        const char* errorName = errorString(static_cast<Error>(errorNumber));
+        if (errorName) {
+            grbl_sendf(out->client(), "%d: %s\r\n", errorNumber, errorName);
+        }
     }
     return Error::Ok;
 }
@@ -431,6 +821,7 @@ void make_grbl_commands() {
     new GrblCommand("", "Help", show_grbl_help, anyState);
     new GrblCommand("T", "State", showState, anyState);
     new GrblCommand("J", "Jog", doJog, idleOrJog);
+    new GrblCommand("JV", "Jog/Velocity", doVelocityJog, idleOrJog);
 
     new GrblCommand("$", "GrblSettings/List", report_normal_settings, notCycleOrHold);
     new GrblCommand("+", "ExtendedSettings/List", report_extended_settings, notCycleOrHold);
@@ -445,6 +836,51 @@ void make_grbl_commands() {
     new GrblCommand("X", "Alarm/Disable", disable_alarm_lock, anyState);
     new GrblCommand("NVX", "Settings/Erase", Setting::eraseNVS, idleOrAlarm, WA);
     new GrblCommand("V", "Settings/Stats", Setting::report_nvs_stats, idleOrAlarm);
+    new GrblCommand(NULL, "Settings/Begin", Setting::beginBatch, idleOrAlarm, WA);
+    new GrblCommand(NULL, "Settings/Commit", Setting::commitBatch, idleOrAlarm, WA);
+    new GrblCommand(NULL, "Stepper/SegmentStats", report_segment_stats, anyState);
+    new GrblCommand(NULL, "Stepper/IsrStats", report_isr_stats, anyState);
+#ifdef STEP_TRACE
+    new GrblCommand(NULL, "Stepper/Trace", step_trace_cmd, anyState);
+#endif
+#ifdef POSITION_CAPTURE
+    new GrblCommand(NULL, "Capture", capture_cmd, anyState);
+#endif
+#ifdef EVENT_TRACE
+    new GrblCommand(NULL, "Trace", event_trace_cmd, anyState);
+#endif
+    new GrblCommand(NULL, "Planner/Stats", report_planner_stats, anyState);
+    new GrblCommand(NULL, "Uart/Stats", report_uart_stats, anyState);
+    new GrblCommand(NULL, "Control/Stats", report_control_stats, anyState);
+    new GrblCommand("RI", "Report/Interval", report_interval, anyState);
+    new GrblCommand("RD", "Report/Delta", report_delta_mode, anyState);
+    new GrblCommand(NULL, "HeightMap/Probe", heightmap_probe_grid, idleOrAlarm);
+    new GrblCommand(NULL, "HeightMap/Show", heightmap_show, anyState);
+    new GrblCommand(NULL, "HeightMap/Clear", heightmap_forget, idleOrAlarm);
+    new GrblCommand(NULL, "Probe/Edge", probe_edge_cmd, idleOrAlarm);
+    new GrblCommand(NULL, "Probe/Bore", probe_bore_cmd, idleOrAlarm);
+    new GrblCommand(NULL, "Probe/Boss", probe_boss_cmd, idleOrAlarm);
+    new GrblCommand(NULL, "Probe/Flatness", probe_flatness_cmd, idleOrAlarm);
+    new GrblCommand(NULL, "Probe/Results", probe_results_cmd, anyState);
+    new GrblCommand(NULL, "Tool/List", tool_list_cmd, anyState);
+    new GrblCommand(NULL, "Tool/Pocket", tool_pocket_cmd, idleOrAlarm);
+    new GrblCommand(NULL, "Tool/Loaded", tool_loaded_cmd, idleOrAlarm);
+    new GrblCommand(NULL, "Tool/Clear", tool_clear_cmd, idleOrAlarm);
+    new GrblCommand(NULL, "Profile/Save", profile_save_cmd, idleOrAlarm, WA);
+    new GrblCommand(NULL, "Profile/Load", profile_load_cmd, idleOrAlarm, WA);
+    new GrblCommand(NULL, "Profile/Delete", profile_delete_cmd, idleOrAlarm, WA);
+    new GrblCommand(NULL, "Profile/List", profile_list_cmd, anyState);
+    new GrblCommand(NULL, "Bench/Parse", bench_parse_cmd, idleOrAlarm);
+    new GrblCommand(NULL, "Bench/Plan", bench_plan_cmd, idleOrAlarm);
+    new GrblCommand(NULL, "Bench/Prep", bench_prep_cmd, idleOrAlarm);
+    new GrblCommand(NULL, "Bench/DryRun", bench_dry_run_cmd, idleOrAlarm);
+    new GrblCommand(NULL, "Bench/All", bench_all_cmd, idleOrAlarm);
+    new GrblCommand(NULL, "Boot/Times", report_boot_times, anyState);
+    new GrblCommand(NULL, "Heap", report_heap, anyState);
+    new GrblCommand(NULL, "Tasks", report_tasks, anyState);
+#ifdef ENABLE_ESP_NOW_SYNC
+    new GrblCommand(NULL, "Sync", report_sync, anyState);
+#endif
     new GrblCommand("#", "GCode/Offsets", report_ngc, idleOrAlarm);
     new GrblCommand("H", "Home", home_all, idleOrAlarm);
     new GrblCommand("MD", "Motor/Disable", motor_disable, idleOrAlarm);
@@ -497,73 +933,229 @@ char* normalize_key(char* start) {
 
 // This is the handler for all forms of settings commands,
 // $..= and [..], with and without a value.
-Error do_command_or_setting(const char* key, char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
-    // If value is NULL, it means that there was no value string, i.e.
-    // $key without =, or [key] with nothing following.
-    // If value is not NULL, but the string is empty, that is the form
-    // $key= with nothing following the = .  It is important to distinguish
-    // those cases so that you can say "$N0=" to clear a startup line.
+// Settings and commands are found by name through hash tables rather than by walking the lists.
+// The tables are built by settings_init(), and built again on the next lookup if more have been
+// made since then, as some motors do. Where two items share a name, the first in the list wins,
+// as it did when the lists were walked.
+template <typename T>
+class NameIndex {
+    typedef struct {
+        const char* name;
+        T*          item;
+    } entry_t;
 
-    // First search the settings list by text name.  If found, set a new
-    // value if one is given, otherwise display the current value
-    for (Setting* s = Setting::List; s; s = s->next()) {
-        if (strcasecmp(s->getName(), key) == 0) {
-            if (auth_failed(s, value, auth_level)) {
-                return Error::AuthenticationFailed;
+    entry_t* _slots = NULL;
+    size_t   _mask  = 0;
+
+    static uint32_t hash(const char* name) {  // FNV-1a, ignoring case
+        uint32_t h = 2166136261u;
+        while (*name) {
+            h = (h ^ uint8_t(tolower(*name++))) * 16777619u;
+        }
+        return h;
+    }
+
+public:
+    // Empties the table, with room for count names at no more than half full
+    void clear(size_t count) {
+        size_t size = 16;
+        while (size < 2 * count) {
+            size *= 2;
+        }
+        free(_slots);
+        _slots = (entry_t*)calloc(size, sizeof(entry_t));
+        _mask  = _slots ? size - 1 : 0;
+    }
+
+    void add(const char* name, T* item) {
+        if (!_slots || !name) {
+            return;
+        }
+        size_t i = hash(name) & _mask;
+        for (; _slots[i].name; i = (i + 1) & _mask) {
+            if (strcasecmp(_slots[i].name, name) == 0) {
+                return;
             }
-            if (value) {
-                return s->setStringValue(value);
-            } else {
-                show_setting(s->getName(), s->getStringValue(), NULL, out);
-                return Error::Ok;
+        }
+        _slots[i].name = name;
+        _slots[i].item = item;
+    }
+
+    T* find(const char* name) const {
+        if (!_slots) {
+            return NULL;
+        }
+        for (size_t i = hash(name) & _mask; _slots[i].name; i = (i + 1) & _mask) {
+            if (strcasecmp(_slots[i].name, name) == 0) {
+                return _slots[i].item;
             }
         }
+        return NULL;
     }
+};
+
+static NameIndex<Setting> settings_by_name;
+static NameIndex<Setting> settings_by_grbl_name;
+static NameIndex<Command> commands_by_name;  // Both names of each command
+static Setting*           indexed_settings = NULL;
+static Command*           indexed_commands = NULL;
+static SemaphoreHandle_t  index_lock       = NULL;
 
-    // Then search the setting list by compatible name.  If found, set a new
-    // value if one is given, otherwise display the current value in compatible mode
+// Every setting in list order with its name in lower case, for the wildcard listing.
+typedef struct {
+    const char* lower_name;
+    Setting*    setting;
+} lower_name_t;
+static lower_name_t* settings_lower       = NULL;
+static size_t        settings_lower_count = 0;
+static char*         settings_lower_text  = NULL;
+
+// Call with index_lock held
+static void index_names() {
+    if (indexed_settings == Setting::List && indexed_commands == Command::List) {
+        return;
+    }
+    size_t count = 0;
     for (Setting* s = Setting::List; s; s = s->next()) {
-        if (s->getGrblName() && strcasecmp(s->getGrblName(), key) == 0) {
-            if (auth_failed(s, value, auth_level)) {
-                return Error::AuthenticationFailed;
-            }
-            if (value) {
-                return s->setStringValue(value);
-            } else {
-                show_setting(s->getGrblName(), s->getCompatibleValue(), NULL, out);
-                return Error::Ok;
+        count++;
+    }
+    settings_by_name.clear(count);
+    settings_by_grbl_name.clear(count);
+    for (Setting* s = Setting::List; s; s = s->next()) {
+        settings_by_name.add(s->getName(), s);
+        settings_by_grbl_name.add(s->getGrblName(), s);
+    }
+    size_t text_size = 0;
+    for (Setting* s = Setting::List; s; s = s->next()) {
+        text_size += strlen(s->getName()) + 1;
+    }
+    free(settings_lower);
+    free(settings_lower_text);
+    settings_lower       = (lower_name_t*)malloc(count * sizeof(lower_name_t));
+    settings_lower_text  = (char*)malloc(text_size);
+    settings_lower_count = 0;
+    if (settings_lower && settings_lower_text) {
+        char* text = settings_lower_text;
+        for (Setting* s = Setting::List; s; s = s->next()) {
+            settings_lower[settings_lower_count++] = { text, s };
+            for (const char* name = s->getName(); *name; name++) {
+                *text++ = tolower(*name);
             }
+            *text++ = '\0';
         }
     }
+    count = 0;
+    for (Command* cp = Command::List; cp; cp = cp->next()) {
+        count += 2;
+    }
+    commands_by_name.clear(count);
+    for (Command* cp = Command::List; cp; cp = cp->next()) {
+        commands_by_name.add(cp->getName(), cp);
+        commands_by_name.add(cp->getGrblName(), cp);
+    }
+    indexed_settings = Setting::List;
+    indexed_commands = Command::List;
+}
+
+static void index_init() {
+    index_lock = xSemaphoreCreateMutex();
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    index_names();
+    xSemaphoreGive(index_lock);
+}
+
+// Looks key up as do_command_or_setting() does: a setting by its name, then by its Grbl name,
+// then a command by either name. One of setting and command is set, or neither.
+static void find_command_or_setting(const char* key, Setting*& setting, bool& grbl_name, Command*& command) {
+    if (index_lock == NULL) {
+        index_init();
+    }
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    index_names();
+    command   = NULL;
+    grbl_name = false;
+    setting   = settings_by_name.find(key);
+    if (!setting) {
+        setting   = settings_by_grbl_name.find(key);
+        grbl_name = setting != NULL;
+    }
+    if (!setting) {
+        command = commands_by_name.find(key);
+    }
+    xSemaphoreGive(index_lock);
+}
+
+Error do_command_or_setting(const char* key, char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+    // If value is NULL, it means that there was no value string, i.e.
+    // $key without =, or [key] with nothing following.
+    // If value is not NULL, but the string is empty, that is the form
+    // $key= with nothing following the = .  It is important to distinguish
+    // those cases so that you can say "$N0=" to clear a startup line.
+
+    // First look for a setting by text name, then by compatible name.  If
+    // found, set a new value if one is given, otherwise display the current
+    // value, in compatible mode for the compatible name.
+    Setting* s;
+    bool     grbl_name;
+    Command* cp;
+    find_command_or_setting(key, s, grbl_name, cp);
+    if (s) {
+        if (auth_failed(s, value, auth_level)) {
+            return Error::AuthenticationFailed;
+        }
+        if (value) {
+            return s->setStringValue(value);
+        }
+        if (grbl_name) {
+            show_setting(s->getGrblName(), s->getCompatibleValue(), NULL, out);
+        } else {
+            show_setting(s->getName(), s->getStringValue(), NULL, out);
+        }
+        return Error::Ok;
+    }
     // If we did not find a setting, look for a command.  Commands
     // handle values internally; you cannot determine whether to set
     // or display solely based on the presence of a value.
-    for (Command* cp = Command::List; cp; cp = cp->next()) {
-        if ((strcasecmp(cp->getName(), key) == 0) || (cp->getGrblName() && strcasecmp(cp->getGrblName(), key) == 0)) {
-            if (auth_failed(cp, value, auth_level)) {
-                return Error::AuthenticationFailed;
-            }
-            return cp->action(value, auth_level, out);
+    if (cp) {
+        if (auth_failed(cp, value, auth_level)) {
+            return Error::AuthenticationFailed;
         }
+        return cp->action(value, auth_level, out);
     }
 
     // If we did not find an exact match and there is no value,
     // indicating a display operation, we allow partial matches
     // and display every possibility.  This only applies to the
     // text form of the name, not to the nnn and ESPnnn forms.
+    // The pattern is taken apart once and matched against the names lowered by index_names(),
+    // unless it is too long for WildcardPattern or the index could not be allocated.
     Error retval = Error::InvalidStatement;
     if (!value) {
-        auto lcKey = String(key);
-        lcKey.toLowerCase();
-        bool found = false;
-        for (Setting* s = Setting::List; s; s = s->next()) {
-            auto lcTest = String(s->getName());
-            lcTest.toLowerCase();
+        WildcardPattern pattern;
+        bool            found = false;
+        if (pattern.compile(key) && settings_lower_count) {
+            xSemaphoreTake(index_lock, portMAX_DELAY);
+            for (size_t i = 0; i < settings_lower_count; i++) {
+                if (pattern.matches(settings_lower[i].lower_name)) {
+                    Setting*    s            = settings_lower[i].setting;
+                    const char* displayValue = auth_failed(s, value, auth_level) ? "<Authentication required>" : s->getStringValue();
+                    show_setting(s->getName(), displayValue, NULL, out);
+                    found = true;
+                }
+            }
+            xSemaphoreGive(index_lock);
+        } else {
+            auto lcKey = String(key);
+            lcKey.toLowerCase();
+            for (Setting* s = Setting::List; s; s = s->next()) {
+                auto lcTest = String(s->getName());
+                lcTest.toLowerCase();
 
-            if (regexMatch(lcKey.c_str(), lcTest.c_str())) {
-                const char* displayValue = auth_failed(s, value, auth_level) ? "<Authentication required>" : s->getStringValue();
-                show_setting(s->getName(), displayValue, NULL, out);
-                found = true;
+                if (regexMatch(lcKey.c_str(), lcTest.c_str())) {
+                    const char* displayValue = auth_failed(s, value, auth_level) ? "<Authentication required>" : s->getStringValue();
+                    show_setting(s->getName(), displayValue, NULL, out);
+                    found = true;
+                }
             }
         }
         if (found) {
@@ -573,6 +1165,60 @@ Error do_command_or_setting(const char* key, char* value, WebUI::AuthenticationL
     return Error::InvalidStatement;
 }
 
+// Commands that only report, by full name. Along with settings shown without a value, these
+// are accepted from other clients while an SD job has the machine.
+static const char* query_commands[] = {
+    "Help", "State", "GrblSettings/List", "ExtendedSettings/List", "GrblNames/List", "Settings/List", "Settings/ListChanged",
+    "Commands/List", "Alarms/List", "Errors/List", "GCode/Modes", "GCode/Offsets", "GCode/StartupLines", "Build/Info", "Settings/Stats",
+    "Stepper/SegmentStats", "Stepper/IsrStats", "Planner/Stats", "Uart/Stats", "HeightMap/Show", "Profile/List", "SD/Status",
+    "System/Stats", "System/IP", "WebUI/List", "WebUI/Help", "Boot/Times", "Heap", "Tasks", "Sync", "Tool/List"
+};
+
+// Commands that change nothing about the running job, accepted with a value as well.
+static const char* job_commands[] = { "SD/Queue", "SD/Queue/Clear", "SD/JobLog/Stop" };
+
+bool system_line_is_query(const char* line) {
+    if (line[0] != '$' && line[0] != '[') {
+        return false;
+    }
+    char buf[LINE_BUFFER_SIZE];
+    strncpy(buf, line + 1, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    if (line[0] == '[') {
+        char* end = strrchr(buf, ']');
+        if (!end || end[1] != '\0') {
+            return false;
+        }
+        *end = '\0';
+    }
+    char* value = strchr(buf, '=');
+    if (value) {
+        *value = '\0';
+    }
+    // Same lookup order as do_command_or_setting()
+    Setting* s;
+    bool     grbl_name;
+    Command* cp;
+    find_command_or_setting(normalize_key(buf), s, grbl_name, cp);
+    if (s) {
+        return !value;
+    }
+    if (cp) {
+        for (auto name : job_commands) {
+            if (strcmp(cp->getName(), name) == 0) {
+                return true;
+            }
+        }
+        for (auto name : query_commands) {
+            if (!value && strcmp(cp->getName(), name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+    return !value;  // Partial matches only display settings
+}
+
 Error system_execute_line(char* line, WebUI::ESPResponseStream* out, WebUI::AuthenticationLevel auth_level) {
     remove_password(line, auth_level);
 
@@ -614,16 +1260,5 @@ Error system_execute_line(char* line, uint8_t client, WebUI::AuthenticationLevel
 }
 
 void system_execute_startup(char* line) {
-    Error status_code;
-    char  gcline[256];
-    strncpy(gcline, startup_line_0->get(), 255);
-    if (*gcline) {
-        status_code = gc_execute_line(gcline, CLIENT_SERIAL);
-        report_execute_startup_message(gcline, status_code, CLIENT_SERIAL);
-    }
-    strncpy(gcline, startup_line_1->get(), 255);
-    if (*gcline) {
-        status_code = gc_execute_line(gcline, CLIENT_SERIAL);
-        report_execute_startup_message(gcline, status_code, CLIENT_SERIAL);
-    }
+    stored_run_startup();
 }
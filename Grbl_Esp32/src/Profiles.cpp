@@ -0,0 +1,217 @@
+/*
+  Profiles.cpp - Named sets of machine settings
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  Each profile is one LocalFS file: a profile_header_t followed by the settings that differ
+  from their defaults, as name and value strings, each with its terminator. Values are kept
+  in the same text form as $<name>=<value>, so a profile survives settings being added or
+  renumbered, and one made by another build loads whatever settings the two share.
+*/
+
+#include "Grbl.h"
+
+#include "LocalFS.h"
+#include <vector>
+
+static const char*    PROFILE_PREFIX    = "/profile/";
+static const char*    PROFILE_EXTENSION = ".prf";
+static const uint32_t PROFILE_MAGIC     = 0x50524f46;  // "PROF"
+
+typedef struct {
+    uint32_t magic;
+    uint16_t count;   // Settings in the profile
+    uint16_t length;  // Bytes of names and values after the header
+} profile_header_t;
+
+static bool profile_mount() {
+    return localfs_mount();
+}
+
+static bool profile_path(const char* name, String& path) {
+    size_t len = strlen(name);
+    if (len == 0 || len > PROFILE_NAME_MAX) {
+        return false;
+    }
+    for (const char* p = name; *p; p++) {
+        if (!isalnum(*p) && *p != '_' && *p != '-') {
+            return false;
+        }
+    }
+    path = String(PROFILE_PREFIX) + name + PROFILE_EXTENSION;
+    return true;
+}
+
+// Settings that describe the machine. WebUI and network settings stay as they are.
+static bool profile_includes(Setting* s) {
+    return s->getType() == GRBL || s->getType() == EXTENDED;
+}
+
+Error profile_save(const char* name, uint8_t client) {
+    String path;
+    if (!name || !profile_path(name, path)) {
+        return Error::InvalidValue;
+    }
+    std::vector<char> body;
+    profile_header_t  header = { PROFILE_MAGIC, 0, 0 };
+    for (Setting* s = Setting::List; s; s = s->next()) {
+        if (!profile_includes(s)) {
+            continue;
+        }
+        const char* value = s->getStringValue();
+        if (strcmp(value, s->getDefaultString()) == 0) {
+            continue;
+        }
+        const char* setting = s->getName();
+        body.insert(body.end(), setting, setting + strlen(setting) + 1);
+        body.insert(body.end(), value, value + strlen(value) + 1);
+        header.count++;
+    }
+    if (body.size() > UINT16_MAX) {
+        return Error::ProfileSaveFailed;
+    }
+    header.length = body.size();
+    if (!profile_mount()) {
+        return Error::FsFailedMount;
+    }
+    File file = LocalFS.open(path, FILE_WRITE);
+    if (!file) {
+        return Error::FsFailedOpenFile;
+    }
+    bool ok = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+              file.write((const uint8_t*)body.data(), header.length) == header.length;
+    file.close();
+    if (!ok) {
+        LocalFS.remove(path);
+        return Error::ProfileSaveFailed;
+    }
+    grbl_msg_sendf(client, MsgLevel::Info, "Profile %s saved, %d settings", name, header.count);
+    return Error::Ok;
+}
+
+// Value of the setting named name in the profile body, or NULL.
+static char* profile_find(char* body, uint16_t count, const char* name) {
+    char* p = body;
+    for (uint16_t i = 0; i < count; i++) {
+        char* value = p + strlen(p) + 1;
+        if (strcasecmp(p, name) == 0) {
+            return value;
+        }
+        p = value + strlen(value) + 1;
+    }
+    return NULL;
+}
+
+Error profile_load(const char* name, uint8_t client) {
+    String path;
+    if (!name || !profile_path(name, path)) {
+        return Error::InvalidValue;
+    }
+    if (!profile_mount()) {
+        return Error::FsFailedMount;
+    }
+    if (!LocalFS.exists(path)) {
+        return Error::FsFileNotFound;
+    }
+    File file = LocalFS.open(path, FILE_READ);
+    if (!file) {
+        return Error::FsFailedOpenFile;
+    }
+    profile_header_t header;
+    char*            body = NULL;
+    bool             ok   = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) && header.magic == PROFILE_MAGIC;
+    if (ok) {
+        body = (char*)malloc(header.length + 1);
+        ok   = body && file.read((uint8_t*)body, header.length) == header.length;
+    }
+    file.close();
+    if (ok) {
+        // Every name and value must be terminated inside the body.
+        body[header.length] = '\0';
+        char* end           = body + header.length;
+        char* p             = body;
+        for (uint16_t i = 0; ok && i < 2 * header.count; i++) {
+            p += strlen(p) + 1;
+            ok = p <= end;
+        }
+    }
+    if (!ok) {
+        free(body);
+        return Error::ProfileInvalid;
+    }
+
+    // Only the settings whose value changes are written, together, and the spindle, motors
+    // and the rest are set up again once at the end instead of after each setting.
+    int   changed = 0;
+    Error err     = Error::Ok;
+    Setting::beginBatch();
+    Setting::deferPostChange();
+    for (Setting* s = Setting::List; s; s = s->next()) {
+        if (!profile_includes(s)) {
+            continue;
+        }
+        const char* target = profile_find(body, header.count, s->getName());
+        if (!target) {
+            target = s->getDefaultString();
+        }
+        if (strcmp(s->getStringValue(), target) == 0) {
+            continue;
+        }
+        char value[256];
+        strncpy(value, target, sizeof(value) - 1);
+        value[sizeof(value) - 1] = '\0';
+        Error e                  = s->setStringValue(value);
+        if (e != Error::Ok) {
+            grbl_msg_sendf(client, MsgLevel::Info, "Profile %s: %s not set", name, s->getName());
+            err = e;
+        } else {
+            changed++;
+        }
+    }
+    Setting::runPostChange();
+    Error committed = Setting::commitBatch();
+    free(body);
+    if (committed != Error::Ok) {
+        return committed;
+    }
+    grbl_msg_sendf(client, MsgLevel::Info, "Profile %s loaded, %d settings changed", name, changed);
+    return err;
+}
+
+Error profile_delete(const char* name) {
+    String path;
+    if (!name || !profile_path(name, path)) {
+        return Error::InvalidValue;
+    }
+    if (!profile_mount() || !LocalFS.exists(path)) {
+        return Error::FsFileNotFound;
+    }
+    return LocalFS.remove(path) ? Error::Ok : Error::FsFailedDelFile;
+}
+
+void profile_list(uint8_t client) {
+    if (!profile_mount()) {
+        return;
+    }
+    File   root    = LocalFS.open("/");
+    size_t prefix  = strlen(PROFILE_PREFIX);
+    size_t postfix = strlen(PROFILE_EXTENSION);
+    for (File file = root.openNextFile(); file; file = root.openNextFile()) {
+        String path = file.name();
+        file.close();
+        if (path.startsWith(PROFILE_PREFIX) && path.endsWith(PROFILE_EXTENSION)) {
+            grbl_sendf(client, "[PROFILE:%s]\r\n", path.substring(prefix, path.length() - postfix).c_str());
+        }
+    }
+    root.close();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+/*
+  Profiles.h - Named sets of machine settings
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Error.h"
+
+#include <cstdint>
+
+// SPIFFS names are limited to 31 characters, which leaves this many for the profile name.
+const int PROFILE_NAME_MAX = 16;
+
+// Saves the present machine settings, the Grbl and extended ones, as the profile name.
+Error profile_save(const char* name, uint8_t client);
+
+// Sets every machine setting to its value in the profile, or to its default if the profile
+// does not have it, then reinitializes each part of the machine that changed once.
+Error profile_load(const char* name, uint8_t client);
+
+Error profile_delete(const char* name);
+
+// Sends the names of the saved profiles to the client.
+void profile_list(uint8_t client);
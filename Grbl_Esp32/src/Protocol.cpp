@@ -36,6 +36,9 @@ typedef struct {
     char buffer[LINE_BUFFER_SIZE];
     int  len;
     int  line_number;
+    bool deferred;   // Complete G-code line held until the planner has room
+    int  next_line;  // N of the next checksummed line
+    bool resending;  // Resend asked for, and next_line not yet received
 } client_line_t;
 client_line_t client_lines[CLIENT_COUNT];
 
@@ -43,10 +46,13 @@ static void empty_line(uint8_t client) {
     client_line_t* cl = &client_lines[client];
     cl->len           = 0;
     cl->buffer[0]     = '\0';
+    cl->deferred      = false;
 }
 static void empty_lines() {
     for (uint8_t client = 0; client < CLIENT_COUNT; client++) {
         empty_line(client);
+        client_lines[client].next_line = 1;  // A sender starts over after a reset
+        client_lines[client].resending = false;
     }
 }
 
@@ -74,6 +80,69 @@ Error add_char_to_line(char c, uint8_t client) {
     return Error::Ok;
 }
 
+// A line sent as "N<n> <line>*<checksum>", the checksum being the XOR of the characters before
+// the '*', is run only if it is intact and is the one that comes next, so a sender can stream
+// ahead of the ok's over a link that drops or garbles characters. Otherwise the sender is asked,
+// once, to resend from the line that was expected, and the lines that follow until it comes are
+// refused, so each line still gets one answer. "N<n> M110*<checksum>" makes n+1 the next line,
+// and a line that comes again after it was run is answered without running it. Lines without a
+// checksum are run as they are.
+static Error check_numbered_line(uint8_t client) {
+    client_line_t* cl   = &client_lines[client];
+    char*          line = cl->buffer;
+    char*          p    = line;
+    while (*p == ' ') {
+        p++;
+    }
+    char* star = strrchr(line, '*');
+    if ((*p != 'N' && *p != 'n') || !isdigit(p[1]) || !star || !isdigit(star[1])) {
+        return Error::Ok;
+    }
+    char* end;
+    long  checksum = strtol(star + 1, &end, 10);
+    while (*end == ' ') {
+        end++;
+    }
+    if (*end) {
+        return Error::Ok;  // Not a checksum, but a '*' in an expression
+    }
+    uint8_t sum = 0;
+    for (char* q = line; q < star; q++) {
+        sum ^= uint8_t(*q);
+    }
+    long n      = strtol(p + 1, &end, 10);
+    bool intact = sum == checksum;
+    if (intact) {
+        *star = '\0';
+        while (*end == ' ') {
+            end++;
+        }
+        if (strncasecmp(end, "M110", 4) == 0 && !isdigit(end[4])) {
+            cl->next_line = n + 1;
+            cl->resending = false;
+            line[0]       = '\0';
+            return Error::Ok;
+        }
+        if (n < cl->next_line) {
+            line[0] = '\0';  // Resent, but it already ran
+            return Error::Ok;
+        }
+        if (n == cl->next_line) {
+            cl->next_line++;
+            cl->resending = false;
+            if (*end == '$' || *end == '[') {
+                memmove(line, end, strlen(end) + 1);  // System commands must start the line
+            }
+            return Error::Ok;
+        }
+    }
+    if (!cl->resending) {
+        cl->resending = true;
+        grbl_sendf(client, "Resend: %d\r\n", cl->next_line);
+    }
+    return intact ? Error::LineOutOfSequence : Error::LineChecksum;
+}
+
 Error execute_line(char* line, uint8_t client, WebUI::AuthenticationLevel auth_level) {
     Error result = Error::Ok;
     // Empty or comment line. For syncing purposes.
@@ -91,6 +160,19 @@ Error execute_line(char* line, uint8_t client, WebUI::AuthenticationLevel auth_l
     return gc_execute_line(line, client);
 }
 
+// G-code lines can queue motion, so while the planner is full they wait in the main loop,
+// which keeps serving other clients, instead of in mc_line(). System commands run at once.
+static bool must_defer_line(const char* line) {
+    return line[0] != 0 && line[0] != '$' && line[0] != '[' && plan_check_full_buffer();
+}
+
+static void execute_client_line(uint8_t client) {
+    char* line = client_lines[client].buffer;
+    // auth_level can be upgraded by supplying a password on the command line
+    report_status_message(execute_line(line, client, WebUI::AuthenticationLevel::LEVEL_GUEST), client);
+    empty_line(client);
+}
+
 bool can_park() {
     return
 #ifdef ENABLE_PARKING_OVERRIDE_CONTROL
@@ -138,26 +220,65 @@ void protocol_main_loop() {
     int c;
     for (;;) {
 #ifdef ENABLE_SD_CARD
-        if (SD_ready_next) {
+        if (SD_ready_next && !plan_check_full_buffer()) {
             char fileLine[255];
             if (readFileLine(fileLine, 255)) {
                 SD_ready_next = false;
-                report_status_message(execute_line(fileLine, SD_client, SD_auth_level), SD_client);
+                report_status_message(sd_execute_line(fileLine, SD_client, SD_auth_level), SD_client);
+            } else if (sd_read_failed()) {
+                report_status_message(Error::FsFailedRead, SD_client);
+                closeFile();
             } else {
                 char temp[50];
                 sd_get_current_filename(temp);
                 grbl_notifyf("SD print done", "%s print is successful", temp);
-                closeFile();  // close file and clear SD ready/running flags
+                String next;
+                if (!sd_queue_pop(next)) {
+                    closeFile();  // close file and clear SD ready/running flags
+                } else if (sd_chain_file(next.c_str())) {
+                    grbl_msg_sendf(SD_client, MsgLevel::Info, "Next job %s", next.c_str());
+                    SD_ready_next = true;
+                } else {
+                    grbl_msg_sendf(SD_client, MsgLevel::Info, "Cannot open next job %s", next.c_str());
+                    report_status_message(Error::FsFailedOpenFile, SD_client);
+                }
             }
         }
 #endif
+        stored_macro_poll();
+        command_queue_poll();
         // Receive one line of incoming serial data, as the data becomes available.
         // Filtering, if necessary, is done later in gc_execute_line(), so the
         // filtering is the same with serial and file input.
+        // Each client gets one line or binary frame per pass, round robin, so a client that is
+        // streaming a burst cannot hold the others off until its buffer runs dry.
         uint8_t client = CLIENT_SERIAL;
         char*   line;
         for (client = 0; client < CLIENT_COUNT; client++) {
-            while ((c = client_read(client)) != -1) {
+            client_line_t* cl        = &client_lines[client];
+            bool           turn_done = false;
+            if (cl->deferred) {
+                if (must_defer_line(cl->buffer)) {
+                    continue;  // Still no room. Leave the rest of this client's input unread.
+                }
+                execute_client_line(client);
+                turn_done = true;
+            }
+            if (binary_motion_ready(client)) {
+                if (plan_check_full_buffer()) {
+                    continue;  // Binary frames queue motion, so they wait like G-code lines.
+                }
+                binary_motion_execute(client);
+                turn_done = true;
+            }
+            while (!turn_done && !cl->deferred && !binary_motion_ready(client) && (c = client_read(client)) != -1) {
+                if (binary_motion_receive(client, c)) {
+                    if (binary_motion_ready(client) && !plan_check_full_buffer()) {
+                        binary_motion_execute(client);
+                        turn_done = true;
+                    }
+                    continue;
+                }
                 Error res = add_char_to_line(c, client);
                 switch (res) {
                     case Error::Ok:
@@ -167,17 +288,26 @@ void protocol_main_loop() {
                         if (sys.abort) {
                             return;  // Bail to calling function upon system abort
                         }
-                        line = client_lines[client].buffer;
+                        line = cl->buffer;
 #ifdef REPORT_ECHO_RAW_LINE_RECEIVED
                         report_echo_line_received(line, client);
 #endif
-                        // auth_level can be upgraded by supplying a password on the command line
-                        report_status_message(execute_line(line, client, WebUI::AuthenticationLevel::LEVEL_GUEST), client);
-                        empty_line(client);
+                        res = check_numbered_line(client);
+                        if (res != Error::Ok) {
+                            report_status_message(res, client);
+                            empty_line(client);
+                        } else if (must_defer_line(line)) {
+                            cl->deferred = true;
+                            gc_prepare_line(line, client);  // Use the wait to parse it
+                        } else {
+                            execute_client_line(client);
+                        }
+                        turn_done = true;
                         break;
                     case Error::Overflow:
                         report_status_message(Error::Overflow, client);
                         empty_line(client);
+                        turn_done = true;
                         break;
                     default:
                         break;
@@ -187,13 +317,21 @@ void protocol_main_loop() {
         // If there are no more characters in the serial read buffer to be processed and executed,
         // this indicates that g-code streaming has either filled the planner buffer or has
         // completed. In either case, auto-cycle start, if enabled, any queued moves.
+        mc_continue_arc();
+        jog_velocity_update();
+        plan_idle_recalculate();
+        Coordinates::persistWhenIdle();
+        if (plan_get_block_buffer_count() <= 1) {
+            mc_flush_fitted_lines();
+            mc_flush_merged_line();  // Don't let a held back merged line starve the planner.
+        }
         protocol_auto_cycle_start();
         protocol_execute_realtime();  // Runtime command check point.
         if (sys.abort) {
             return;  // Bail to main() program loop to reset system.
         }
         // check to see if we should disable the stepper drivers ... esp32 work around for disable in main loop.
-        if (stepper_idle && stepper_idle_lock_time->get() != 0xff) {
+        if (stepper_idle && st_config.idle_lock_time != 0xff) {
             if (esp_timer_get_time() > stepper_idle_counter) {
                 motors_set_disable(true);
             }
@@ -205,14 +343,26 @@ void protocol_main_loop() {
 // Block until all buffered steps are executed or in a cycle state. Works with feed hold
 // during a synchronize call, if it should happen. Also, waits for clean cycle end.
 void protocol_buffer_synchronize() {
+    mc_finish_arc();
+    mc_flush_merged_line();
     // If system is queued, ensure cycle resumes if the auto start flag is present.
     protocol_auto_cycle_start();
     do {
+        bench_drain();                // Nothing else empties the buffers while $Bench runs no steppers
         protocol_execute_realtime();  // Check and execute run-time commands
         if (sys.abort) {
             return;  // Check for system abort
         }
     } while (plan_get_current_block() || (sys.state == State::Cycle));
+#ifdef SYNC_USER_OUTPUTS
+    plan_flush_outputs();  // Changes that no motion took
+#endif
+#ifdef SYNC_COOLANT
+    plan_flush_coolant();
+#endif
+#ifdef SYNC_SPINDLE_SPEED
+    plan_flush_spindle();
+#endif
 }
 
 // Auto-cycle start triggers when there is a motion ready to execute and if the main program is not
@@ -222,6 +372,14 @@ void protocol_buffer_synchronize() {
 // is finished, single commands), a command that needs to wait for the motions in the buffer to
 // execute calls a buffer sync, or the planner buffer is full and ready to go.
 void protocol_auto_cycle_start() {
+    if (bench_drain()) {
+        return;  // $Bench takes the queued motion instead of the steppers
+    }
+#ifdef ENABLE_ESP_NOW_SYNC
+    if (esp_now_sync_hold_start()) {
+        return;  // A follower starts with its leader
+    }
+#endif
     if (plan_get_current_block() != NULL) {       // Check if there are any blocks in the buffer.
         sys_rt_exec_state.bit.cycleStart = true;  // If so, execute them!
     }
@@ -245,6 +403,51 @@ void protocol_execute_realtime() {
     }
 }
 
+#ifdef OVERRIDE_SMOOTHING
+static Percent protocol_slew_override(Percent applied, Percent requested) {
+    if (requested > applied) {
+        return MIN(requested, applied + OVERRIDE_SLEW_PERCENT);
+    }
+    return MAX(requested, applied - OVERRIDE_SLEW_PERCENT);
+}
+
+// Feed and rapid overrides, see OVERRIDE_SMOOTHING. Blocks loaded by the segment generator take
+// the applied overrides through plan_compute_profile_nominal_speed(), so after an increase only
+// the executing block needs its profile recomputed. The planned entry speeds stay below what the
+// new overrides allow until the deferred replan, which is slower but safe.
+static void protocol_exec_motion_overrides() {
+    static int64_t next_step_us = 0;
+    static int64_t replan_us    = 0;  // When the deferred replan is due, 0 for none
+    int64_t        now          = esp_timer_get_time();
+    if ((sys_rt_f_override != sys.f_override) || (sys_rt_r_override != sys.r_override) || (sys_rt_f_adaptive != sys.f_adaptive)) {
+        if (now < next_step_us) {
+            return;
+        }
+        next_step_us           = now + OVERRIDE_SLEW_MS * 1000;
+        Percent f_override     = protocol_slew_override(sys.f_override, sys_rt_f_override);
+        Percent r_override     = protocol_slew_override(sys.r_override, sys_rt_r_override);
+        Percent f_adaptive     = sys_rt_f_adaptive;  // Moves in small steps already
+        bool    reduced        = f_override < sys.f_override || r_override < sys.r_override || f_adaptive < sys.f_adaptive;
+        sys.f_override         = f_override;
+        sys.r_override         = r_override;
+        sys.f_adaptive         = f_adaptive;
+        sys.report_ovr_counter = 0;  // Set to report change immediately
+        if (reduced || sys.state != State::Cycle || sys.step_control.executeHold) {
+            plan_update_velocity_profile_parameters();
+            plan_cycle_reinitialize();
+            replan_us = 0;
+        } else {
+            st_update_plan_block_parameters();
+            replan_us = now + OVERRIDE_SETTLE_MS * 1000;
+        }
+    } else if (replan_us != 0 && now >= replan_us) {
+        replan_us = 0;
+        plan_update_velocity_profile_parameters();
+        plan_cycle_reinitialize();
+    }
+}
+#endif
+
 // Executes run-time commands, when required. This function primarily operates as Grbl's state
 // machine and controls the various real-time features Grbl has to offer.
 // NOTE: Do not alter this unless you know exactly what you are doing!
@@ -255,6 +458,7 @@ void protocol_exec_rt_system() {
         // the source of the error to the user. If critical, Grbl disables by entering an infinite
         // loop until system reset/abort.
         sys.state = State::Alarm;  // Set system alarm state
+        limits_forget_homing();    // Steps may have been lost
         report_alarm_message(alarm);
         // Halt everything upon a critical event flag. Currently hard and soft limits flag this.
         if ((alarm == ExecAlarm::HardLimit) || (alarm == ExecAlarm::SoftLimit)) {
@@ -319,6 +523,7 @@ void protocol_exec_rt_system() {
                 }
                 // Execute a feed hold with deceleration, if required. Then, suspend system.
                 if (rt_exec_state.bit.feedHold) {
+                    system_control_acted(ControlInputFeedHold);
                     // Block SAFETY_DOOR, JOG, and SLEEP states from changing to HOLD state.
                     if (!(sys.state == State::SafetyDoor || sys.state == State::Jog || sys.state == State::Sleep)) {
                         sys.state = State::Hold;
@@ -329,6 +534,7 @@ void protocol_exec_rt_system() {
                 // NOTE: Safety door differs from feed holds by stopping everything no matter state, disables powered
                 // devices (spindle/coolant), and blocks resuming until switch is re-engaged.
                 if (rt_exec_state.bit.safetyDoor) {
+                    system_control_acted(ControlInputSafetyDoor);
                     report_feedback_message(Message::SafetyDoorAjar);
                     // If jogging, block safety door methods until jog cancel is complete. Just flag that it happened.
                     if (!(sys.suspend.bit.jogCancel)) {
@@ -373,6 +579,7 @@ void protocol_exec_rt_system() {
         }
         // Execute a cycle start by starting the stepper interrupt to begin executing the blocks in queue.
         if (rt_exec_state.bit.cycleStart) {
+            system_control_acted(ControlInputCycleStart);
             // Block if called at same time as the hold commands: feed hold, motion cancel, and safety door.
             // Ensures auto-cycle-start doesn't resume a hold without an explicit user-input.
             if (!(rt_exec_state.bit.feedHold || rt_exec_state.bit.motionCancel || rt_exec_state.bit.safetyDoor)) {
@@ -399,9 +606,20 @@ void protocol_exec_rt_system() {
                         if (plan_get_current_block() && !sys.suspend.bit.motionCancel) {
                             sys.suspend.value = 0;  // Break suspend state.
                             sys.state         = State::Cycle;
-                            st_prep_buffer();  // Initialize step segment buffer before beginning cycle.
-                            st_wake_up();
-                        } else {                    // Otherwise, do nothing. Set and resume IDLE state.
+#ifdef PRIME_HOLD_RESUME
+                            if (st_take_primed_resume()) {
+                                st_wake_up();      // The first segments were prepared as the hold ended
+                                st_prep_buffer();  // Top it up
+                            } else
+#endif
+                            {
+                                st_prep_buffer();  // Initialize step segment buffer before beginning cycle.
+                                st_wake_up();
+                            }
+                        } else {  // Otherwise, do nothing. Set and resume IDLE state.
+#ifdef PRIME_HOLD_RESUME
+                            st_discard_primed_resume();
+#endif
                             sys.suspend.value = 0;  // Break suspend state.
                             sys.state         = State::Idle;
                         }
@@ -426,6 +644,11 @@ void protocol_exec_rt_system() {
                 }
                 sys.step_control.executeHold      = false;
                 sys.step_control.executeSysMotion = false;
+#ifdef PRIME_HOLD_RESUME
+                if (sys.state == State::Hold && sys.suspend.bit.holdComplete && !sys.suspend.bit.motionCancel) {
+                    st_prime_resume();
+                }
+#endif
             } else {
                 // Motion complete. Includes CYCLE/JOG/HOMING states and jog cancel/motion cancel/soft limit events.
                 // NOTE: Motion and jog cancel both immediately return to idle after the hold completes.
@@ -449,13 +672,19 @@ void protocol_exec_rt_system() {
         }
     }
     // Execute overrides.
-    if ((sys_rt_f_override != sys.f_override) || (sys_rt_r_override != sys.r_override)) {
+    adaptive_feed_poll();
+#ifdef OVERRIDE_SMOOTHING
+    protocol_exec_motion_overrides();
+#else
+    if ((sys_rt_f_override != sys.f_override) || (sys_rt_r_override != sys.r_override) || (sys_rt_f_adaptive != sys.f_adaptive)) {
         sys.f_override         = sys_rt_f_override;
         sys.r_override         = sys_rt_r_override;
+        sys.f_adaptive         = sys_rt_f_adaptive;
         sys.report_ovr_counter = 0;  // Set to report change immediately
         plan_update_velocity_profile_parameters();
         plan_cycle_reinitialize();
     }
+#endif
 
     // NOTE: Unlike motion overrides, spindle overrides do not require a planner reinitialization.
     if (sys_rt_s_override != sys.spindle_speed_ovr) {
@@ -508,7 +737,17 @@ void protocol_exec_rt_system() {
         sys_rt_exec_debug = false;
     }
 #endif
-    // Reload step segment buffer
+#ifdef ENABLE_SD_CARD
+    job_log_poll();
+#endif
+#ifdef POSITION_CAPTURE
+    capture_poll();
+#endif
+#ifdef ENABLE_ESP_NOW_SYNC
+    esp_now_sync_poll();
+#endif
+#ifndef ENABLE_DUAL_CORE_PIPELINE
+    // Reload step segment buffer. The pipeline's prep task does it from the other core.
     switch (sys.state) {
         case State::Cycle:
         case State::Hold:
@@ -521,6 +760,7 @@ void protocol_exec_rt_system() {
         default:
             break;
     }
+#endif
 }
 
 // Handles Grbl system suspend procedures, such as feed hold, safety door, and parking motion.
@@ -0,0 +1,61 @@
+/*
+  Raster.cpp - Scanlines of laser power levels for raster engraving
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The levels are kept here rather than in the planner blocks, which would need room for a
+  whole line each. A line's slot is reused once the ISR has moved on to a later line, so a
+  hold or a parking motion partway through a line does not lose it.
+*/
+
+#include "Grbl.h"
+
+#include <atomic>
+
+#ifdef RASTER_ENGRAVING
+
+static uint8_t               raster_lines[RASTER_LINES][RASTER_PIXELS_MAX];
+static uint32_t              raster_stored;    // Number of the last line stored
+static std::atomic<uint32_t> raster_released;  // Lines up to this one may be reused
+
+uint32_t raster_store(const uint8_t* levels, uint16_t count) {
+    // Waits the way mc_line() does for room in the planner
+    while (raster_stored - raster_released >= RASTER_LINES) {
+        protocol_execute_realtime();
+        if (sys.abort) {
+            return 0;
+        }
+        protocol_auto_cycle_start();
+    }
+    uint32_t line = raster_stored + 1;
+    memcpy(raster_lines[line % RASTER_LINES], levels, MIN(count, RASTER_PIXELS_MAX));
+    raster_stored = line;
+    return line;
+}
+
+void IRAM_ATTR raster_release(uint32_t line) {
+    if (line - 1 > raster_released) {
+        raster_released = line - 1;
+    }
+}
+
+const uint8_t* IRAM_ATTR raster_levels(uint32_t line) {
+    return raster_lines[line % RASTER_LINES];
+}
+
+void raster_reset() {
+    raster_stored   = 0;
+    raster_released = 0;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+
+/*
+  Raster.h - Scanlines of laser power levels for raster engraving
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdint>
+
+// A raster line is one planner block whose pixels are spread evenly over its step events. The
+// stepper ISR sets the laser to the power of the pixel under it, as a share of the block's S.
+// Lines are numbered from 1 in the order they are stored, 0 meaning none.
+const int RASTER_LINES      = 8;    // Lines waiting in the planner or being engraved
+const int RASTER_PIXELS_MAX = 245;  // What fits in a binary frame
+
+// Copies a line of count power levels, 0 to 255, waiting while all lines are in use. Returns
+// its number, or 0 if the wait ended in an abort.
+uint32_t raster_store(const uint8_t* levels, uint16_t count);
+
+// Called by the stepper ISR when it starts line. The lines before it are no longer needed.
+void raster_release(uint32_t line);
+
+// The power levels of a stored line.
+const uint8_t* raster_levels(uint32_t line);
+
+// Drops all lines. Called on reset, with the planner and stepper buffers.
+void raster_reset();
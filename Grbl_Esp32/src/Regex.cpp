@@ -16,6 +16,11 @@
 // "bare * wildcard" is similar to filename wildcarding in many shells
 // and CLIs.
 
+#include "Regex.h"
+
+#include <cctype>
+#include <cstring>
+
 static bool matchHere(const char* regexp, const char* text);
 
 // matchStar - search for *regexp at beginning of text
@@ -58,3 +63,73 @@ bool regexMatch(const char* regexp, const char* text) {
     } while (*text++ != '\0');
     return false;
 }
+
+bool WildcardPattern::compile(const char* regexp) {
+    _anchor_start = regexp[0] == '^';
+    if (_anchor_start) {
+        regexp++;
+    }
+    size_t len  = strlen(regexp);
+    _anchor_end = len && regexp[len - 1] == '$';
+    if (_anchor_end) {
+        len--;
+    }
+    if (len >= MAX_LENGTH) {
+        return false;
+    }
+    _count              = 1;
+    _segments[0]        = _text;
+    const char* segment = _text;
+    for (size_t i = 0; i < len; i++) {
+        if (regexp[i] == '*') {
+            _text[i]             = '\0';
+            _lengths[_count - 1] = _text + i - segment;
+            if (_count == MAX_SEGMENTS) {
+                return false;
+            }
+            segment             = _text + i + 1;
+            _segments[_count++] = segment;
+        } else {
+            _text[i] = tolower(regexp[i]);
+        }
+    }
+    _text[len]           = '\0';
+    _lengths[_count - 1] = _text + len - segment;
+    return true;
+}
+
+bool WildcardPattern::matches(const char* text) const {
+    int last = _count - 1;
+    if (last == 0) {
+        size_t text_len = strlen(text);
+        if (_anchor_start && _anchor_end) {
+            return strcmp(text, _segments[0]) == 0;
+        }
+        if (_anchor_start) {
+            return strncmp(text, _segments[0], _lengths[0]) == 0;
+        }
+        if (_anchor_end) {
+            return text_len >= _lengths[0] && strcmp(text + text_len - _lengths[0], _segments[0]) == 0;
+        }
+        return strstr(text, _segments[0]) != NULL;
+    }
+    const char* at = text;
+    for (int i = 0; i < last; i++) {
+        if (i == 0 && _anchor_start) {
+            if (strncmp(at, _segments[0], _lengths[0])) {
+                return false;
+            }
+        } else {
+            at = strstr(at, _segments[i]);
+            if (!at) {
+                return false;
+            }
+        }
+        at += _lengths[i];
+    }
+    if (_anchor_end) {
+        size_t rest = strlen(at);
+        return rest >= _lengths[last] && strcmp(at + rest - _lengths[last], _segments[last]) == 0;
+    }
+    return strstr(at, _segments[last]) != NULL;
+}
@@ -1,5 +1,31 @@
+#pragma once
+
 // Simple regular expression matcher.
 // See Regex.cpp for attribution, description and discussion
 
+#include <cstddef>
+
 // Returns true if text contains the regular expression regexp
 bool regexMatch(const char* regexp, const char* text);
+
+// The same expressions, taken apart once so that many names can be matched against them
+// without recursion: the literal runs between the '*'s are placed by strstr() from the left,
+// which finds a match whenever there is one.
+class WildcardPattern {
+    static const int MAX_LENGTH   = 80;
+    static const int MAX_SEGMENTS = 16;
+
+    char        _text[MAX_LENGTH];  // Lower case, with a '\0' where each '*' was
+    const char* _segments[MAX_SEGMENTS];
+    size_t      _lengths[MAX_SEGMENTS];
+    int         _count;
+    bool        _anchor_start;
+    bool        _anchor_end;
+
+public:
+    // Returns false if regexp is too long or has too many '*'s, for regexMatch() to take.
+    bool compile(const char* regexp);
+
+    // text must already be in lower case.
+    bool matches(const char* text) const;
+};
@@ -52,37 +52,83 @@
 #ifdef REPORT_HEAP
 EspClass esp;
 #endif
-const int DEFAULTBUFFERSIZE = 64;
 
 void grbl_send(uint8_t client, const char* text) {
     client_write(client, text);
 }
 
+void grbl_send(uint8_t client, const char* text, size_t length) {
+    client_write(client, text, length);
+}
+
+// Formatted output is built in a fixed buffer per client, plus one for CLIENT_ALL, so sending
+// never touches the heap. Tasks that report to the same client take turns on its buffer.
+// Longer output is truncated, keeping the line ending if the format has one.
+const int REPORT_BUFFER_SIZE = 256;
+
+typedef struct {
+    char              text[REPORT_BUFFER_SIZE];
+    SemaphoreHandle_t lock;
+    StaticSemaphore_t lock_storage;
+} report_buffer_t;
+static report_buffer_t report_buffers[CLIENT_COUNT + 1];
+
+void report_init() {
+    for (int i = 0; i <= CLIENT_COUNT; i++) {
+        report_buffers[i].lock = xSemaphoreCreateRecursiveMutexStatic(&report_buffers[i].lock_storage);
+    }
+}
+
+// Copies of the settings that shape status reports, so building one does not go through them.
+static int32_t report_status_mask;
+static bool    report_in_inches;
+
+static void report_setting_changed(Setting* setting) {
+    report_status_mask = status_mask->get();
+    report_in_inches   = report_inches->get();
+}
+
+void report_settings_init() {
+    status_mask->onChange(report_setting_changed);
+    report_inches->onChange(report_setting_changed);
+}
+
+// Messages sent before report_init() come from the only running task, so they need no lock.
+static report_buffer_t* report_buffer_take(uint8_t client) {
+    report_buffer_t* buffer = &report_buffers[client < CLIENT_COUNT ? client : CLIENT_COUNT];
+    if (buffer->lock != NULL) {
+        xSemaphoreTakeRecursive(buffer->lock, portMAX_DELAY);
+    }
+    return buffer;
+}
+
+static void report_buffer_give(report_buffer_t* buffer) {
+    if (buffer->lock != NULL) {
+        xSemaphoreGiveRecursive(buffer->lock);
+    }
+}
+
 // This is a formating version of the grbl_send(CLIENT_ALL,...) function that work like printf
 void grbl_sendf(uint8_t client, const char* format, ...) {
     if (client == CLIENT_INPUT) {
         return;
     }
-    char    loc_buf[64];
-    char*   temp = loc_buf;
-    va_list arg;
-    va_list copy;
+    report_buffer_t* buffer = report_buffer_take(client);
+    va_list          arg;
     va_start(arg, format);
-    va_copy(copy, arg);
-    size_t len = vsnprintf(NULL, 0, format, arg);
-    va_end(copy);
-    if (len >= sizeof(loc_buf)) {
-        temp = new char[len + 1];
-        if (temp == NULL) {
-            return;
+    int len = vsnprintf(buffer->text, REPORT_BUFFER_SIZE, format, arg);
+    va_end(arg);
+    if (len >= REPORT_BUFFER_SIZE) {
+        len               = REPORT_BUFFER_SIZE - 1;
+        size_t format_len = strlen(format);
+        if (format_len && format[format_len - 1] == '\n') {
+            strcpy(&buffer->text[REPORT_BUFFER_SIZE - 3], "\r\n");
         }
     }
-    len = vsnprintf(temp, len + 1, format, arg);
-    grbl_send(client, temp);
-    va_end(arg);
-    if (temp != loc_buf) {
-        delete[] temp;
+    if (len > 0) {
+        grbl_send(client, buffer->text, len);
     }
+    report_buffer_give(buffer);
 }
 // Use to send [MSG:xxxx] Type messages. The level allows messages to be easily suppressed
 void grbl_msg_sendf(uint8_t client, MsgLevel level, const char* format, ...) {
@@ -96,32 +142,30 @@ void grbl_msg_sendf(uint8_t client, MsgLevel level, const char* format, ...) {
         }
     }
 
-    char    loc_buf[100];
-    char*   temp = loc_buf;
+    // The message is formatted straight into the buffer between the [MSG: prefix and the ]\r\n
+    // suffix, which keeps its room at the end.
+    const char       prefix[] = "[MSG:";
+    const char       suffix[] = "]\r\n";
+    const int        room     = REPORT_BUFFER_SIZE - (sizeof(prefix) - 1) - (sizeof(suffix) - 1);
+    report_buffer_t* buffer   = report_buffer_take(client);
+    char*            text     = buffer->text + sizeof(prefix) - 1;
+    memcpy(buffer->text, prefix, sizeof(prefix) - 1);
     va_list arg;
-    va_list copy;
     va_start(arg, format);
-    va_copy(copy, arg);
-    size_t len = vsnprintf(NULL, 0, format, arg);
-    va_end(copy);
-    if (len >= sizeof(loc_buf)) {
-        temp = new char[len + 1];
-        if (temp == NULL) {
-            return;
-        }
-    }
-    len = vsnprintf(temp, len + 1, format, arg);
-    grbl_sendf(client, "[MSG:%s]\r\n", temp);
+    int len = vsnprintf(text, room, format, arg);
     va_end(arg);
-    if (temp != loc_buf) {
-        delete[] temp;
+    if (len >= 0) {
+        len = MIN(len, room - 1);
+        strcpy(text + len, suffix);
+        grbl_send(client, buffer->text, (text - buffer->text) + len + sizeof(suffix) - 1);
     }
+    report_buffer_give(buffer);
 }
 
 //function to notify
 void grbl_notify(const char* title, const char* msg) {
 #ifdef ENABLE_NOTIFICATIONS
-    WebUI::notificationsservice.sendMSG(title, msg);
+    WebUI::notificationsservice.queueMSG(title, msg);  // Sent by its own task
 #endif
 }
 
@@ -151,26 +195,93 @@ void grbl_notifyf(const char* title, const char* format, ...) {
 static const int coordStringLen = 20;
 static const int axesStringLen  = coordStringLen * MAX_N_AXIS;
 
-// formats axis values into a string and returns that string in rpt
-// NOTE: rpt should have at least size: axesStringLen
-static void report_util_axis_values(float* axis_value, char* rpt) {
-    uint8_t     idx;
-    char        axisVal[coordStringLen];
-    float       unit_conv = 1.0;      // unit conversion multiplier..default is mm
-    const char* format    = "%4.3f";  // Default - report mm to 3 decimal places
-    rpt[0]                = '\0';
-    if (report_inches->get()) {
+// The status report is built with these instead of sprintf and strcat. Each one appends at end,
+// keeps the string terminated and returns the new end, so a report costs one pass over its text.
+char* report_append(char* end, const char* text) {
+    while (*text) {
+        *end++ = *text++;
+    }
+    *end = '\0';
+    return end;
+}
+
+static char* report_append_int(char* end, int32_t value) {
+    char     digits[10];
+    int      n         = 0;
+    uint32_t magnitude = value;
+    if (value < 0) {
+        *end++    = '-';
+        magnitude = -magnitude;
+    }
+    do {
+        digits[n++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude);
+    while (n) {
+        *end++ = digits[--n];
+    }
+    *end = '\0';
+    return end;
+}
+
+// Fixed point equivalent of "%.<decimals>f" for up to 4 decimals. The fraction is split off
+// before scaling, which is exact in float, and scaled in double, which is exact for a float
+// fraction, so the digits match printf. A value that is rounded to zero is printed without a sign.
+static char* report_append_fixed(char* end, float value, int decimals) {
+    static const uint32_t scale[] = { 1, 10, 100, 1000, 10000 };
+    float                 mag     = fabsf(value);
+    if (!(mag < 2.0e9f)) {  // Out of uint32_t range, or not a number
+        return end + sprintf(end, "%.*f", decimals, value);
+    }
+    uint32_t whole    = uint32_t(mag);
+    double   scaled   = double(mag - whole) * scale[decimals];
+    uint32_t fraction = uint32_t(scaled + 0.5);
+    if (fraction - scaled == 0.5 && ((decimals ? fraction : whole + fraction) & 1)) {
+        fraction--;  // Ties go to even, like printf.
+    }
+    if (fraction >= scale[decimals]) {
+        whole++;
+        fraction -= scale[decimals];
+    }
+    if (value < 0 && (whole || fraction)) {
+        *end++ = '-';
+    }
+    end = report_append_int(end, whole);
+    if (decimals) {
+        *end++ = '.';
+        for (int digit = decimals - 1; digit >= 0; digit--) {
+            end[digit] = '0' + fraction % 10;
+            fraction /= 10;
+        }
+        end += decimals;
+        *end = '\0';
+    }
+    return end;
+}
+
+// Appends the axis values in the report units, 3 decimals for mm and 4 for inches.
+char* report_append_axis_values(char* end, const float* axis_value) {
+    float unit_conv = 1.0;  // unit conversion multiplier..default is mm
+    int   decimals  = 3;    // Default - report mm to 3 decimal places
+    if (report_in_inches) {
         unit_conv = 1.0 / MM_PER_INCH;
-        format    = "%4.4f";  // Report inches to 4 decimal places
+        decimals  = 4;  // Report inches to 4 decimal places
     }
     auto n_axis = number_axis->get();
-    for (idx = 0; idx < n_axis; idx++) {
-        snprintf(axisVal, coordStringLen - 1, format, axis_value[idx] * unit_conv);
-        strcat(rpt, axisVal);
-        if (idx < (number_axis->get() - 1)) {
-            strcat(rpt, ",");
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        if (idx) {
+            *end++ = ',';
         }
+        end = report_append_fixed(end, axis_value[idx] * unit_conv, decimals);
     }
+    return end;
+}
+
+// formats axis values into a string and returns that string in rpt
+// NOTE: rpt should have at least size: axesStringLen
+static void report_util_axis_values(float* axis_value, char* rpt) {
+    rpt[0] = '\0';
+    report_append_axis_values(rpt, axis_value);
 }
 
 // This version returns the axis values as a String
@@ -232,9 +343,11 @@ void report_status_message(Error status_code, uint8_t client) {
 #endif
             // With verbose errors, the message text is displayed instead of the number.
             // Grbl 0.9 used to display the text, while Grbl 1.1 switched to the number.
-            // Many senders support both formats.
-            if (verbose_errors->get()) {
-                grbl_sendf(client, "error: %s\r\n", errorString(status_code));
+            // Many senders support both formats. Senders that map the codes themselves, from
+            // $E, leave it off for the shorter responses.
+            const char* name = verbose_errors->get() ? errorString(status_code) : NULL;
+            if (name) {
+                grbl_sendf(client, "error: %s\r\n", name);
             } else {
                 grbl_sendf(client, "error:%d\r\n", static_cast<int>(status_code));
             }
@@ -243,6 +356,9 @@ void report_status_message(Error status_code, uint8_t client) {
 
 // Prints alarm messages.
 void report_alarm_message(ExecAlarm alarm_code) {
+#if defined(ENABLE_WIFI) && defined(ENABLE_HTTP) && defined(ENABLE_WEBSOCKET_EVENTS)
+    WebUI::SocketEvents.alarm(alarm_code);
+#endif
     grbl_sendf(CLIENT_ALL, "ALARM:%d\r\n", static_cast<int>(alarm_code));  // OK to send to all clients
     delay_ms(500);                                                         // Force delay to ensure message clears serial write buffer.
 }
@@ -343,7 +459,7 @@ void report_ngc_parameters(uint8_t client) {
 // Print current gcode parser mode state
 void report_gcode_modes(uint8_t client) {
     char        temp[20];
-    char        modes_rpt[75];
+    char        modes_rpt[100];
     const char* mode = "";
     strcpy(modes_rpt, "[GC:");
 
@@ -375,6 +491,24 @@ void report_gcode_modes(uint8_t client) {
         case Motion::ProbeAwayNoError:
             mode = "G38.4";
             break;
+        case Motion::DrillChipBreak:
+            mode = "G73";
+            break;
+        case Motion::Drill:
+            mode = "G81";
+            break;
+        case Motion::DrillDwell:
+            mode = "G82";
+            break;
+        case Motion::DrillPeck:
+            mode = "G83";
+            break;
+        case Motion::SpindleSync:
+            mode = "G33";
+            break;
+        case Motion::RigidTap:
+            mode = "G33.1";
+            break;
     }
     strcat(modes_rpt, mode);
 
@@ -432,6 +566,18 @@ void report_gcode_modes(uint8_t client) {
     }
     strcat(modes_rpt, mode);
 
+    if (gc_state.modal.control == ControlMode::Continuous) {
+        strcat(modes_rpt, " G64");
+    }
+
+    if (gc_state.modal.speed_mode == SpindleSpeedMode::SurfaceSpeed) {
+        strcat(modes_rpt, " G96");
+    }
+
+    if (gc_state.modal.retract == RetractMode::RPlane) {
+        strcat(modes_rpt, " G99");
+    }
+
     //report_util_gcode_modes_M();
     switch (gc_state.modal.program_flow) {
         case ProgramFlow::Running:
@@ -554,7 +700,8 @@ void report_build_info(const char* line, uint8_t client) {
 #endif
     // NOTE: Compiled values, like override increments/max/min values, may be added at some point later.
     // These will likely have a comma delimiter to separate them.
-    grbl_send(client, "]\r\n");
+    // The planner blocks and this client's receive buffer size follow, as in Grbl 1.1.
+    grbl_sendf(client, ",%d,%d]\r\n", plan_get_block_buffer_size() - 1, client_get_rx_buffer_size(client));
     report_machine_type(client);
 #if defined(ENABLE_WIFI)
     grbl_send(client, (char*)WebUI::wifi_config.info());
@@ -580,45 +727,87 @@ void report_echo_line_received(char* line, uint8_t client) {
 // specific needs, but the desired real-time data report must be as short as possible. This is
 // requires as it minimizes the computational overhead and allows grbl to keep running smoothly,
 // especially during g-code programs with fast, short line segments and high frequency reports (5-20Hz).
-void report_realtime_status(uint8_t client) {
-    char status[200];
-    char temp[MAX_N_AXIS * 20];
-
-    strcpy(status, "<");
-    strcat(status, report_state_text());
+// The report is built in three parts so that auto reports can share all of it but the buffer
+// state between the clients they go to.
+static char* report_status_head(char* end) {
+    *end++ = '<';
+    end    = report_append(end, report_state_text());
 
     // Report position
-    float* print_position = system_get_mpos();
-    if (bit_istrue(status_mask->get(), RtStatus::Position)) {
-        strcat(status, "|MPos:");
+    float print_position[MAX_N_AXIS];
+    system_read_mpos(print_position);  // Status reports are built by the client task too
+    if (bit_istrue(report_status_mask, RtStatus::Position)) {
+        end = report_append(end, "|MPos:");
     } else {
-        strcat(status, "|WPos:");
+        end = report_append(end, "|WPos:");
         mpos_to_wpos(print_position);
     }
-    report_util_axis_values(print_position, temp);
-    strcat(status, temp);
-    // Returns planner and serial read buffer states.
+    return report_append_axis_values(end, print_position);
+}
+
+// Returns planner and serial read buffer states.
+static char* report_status_buffer_state(char* end, uint8_t client) {
 #ifdef REPORT_FIELD_BUFFER_STATE
-    if (bit_istrue(status_mask->get(), RtStatus::Buffer)) {
-        int bufsize = DEFAULTBUFFERSIZE;
-#    if defined(ENABLE_WIFI) && defined(ENABLE_TELNET)
-        if (client == CLIENT_TELNET) {
-            bufsize = WebUI::telnet_server.get_rx_buffer_available();
-        }
-#    endif  //ENABLE_WIFI && ENABLE_TELNET
-#    if defined(ENABLE_BLUETOOTH)
-        if (client == CLIENT_BT) {
-            //TODO FIXME
-            bufsize = 512 - WebUI::SerialBT.available();
-        }
-#    endif  //ENABLE_BLUETOOTH
-        if (client == CLIENT_SERIAL) {
-            bufsize = client_get_rx_buffer_available(CLIENT_SERIAL);
-        }
-        sprintf(temp, "|Bf:%d,%d", plan_get_block_buffer_available(), bufsize);
-        strcat(status, temp);
+    if (bit_istrue(report_status_mask, RtStatus::Buffer)) {
+        end    = report_append(end, "|Bf:");
+        end    = report_append_int(end, plan_get_block_buffer_available());
+        *end++ = ',';
+        end    = report_append_int(end, client_get_rx_buffer_available(client));
+    }
+#endif
+    return end;
+}
+
+// WCO and overrides are only sent every few reports. These count down their refresh counters
+// and return true when the field is due. Delta reports send the fields whenever they change,
+// so they leave the counters alone.
+#ifdef REPORT_FIELD_WORK_COORD_OFFSET
+static bool report_wco_due() {
+    if (sys.report_wco_counter > 0) {
+        sys.report_wco_counter--;
+        return false;
     }
+    switch (sys.state) {
+        case State::Homing:
+        case State::Cycle:
+        case State::Hold:
+        case State::Jog:
+        case State::SafetyDoor:
+            sys.report_wco_counter = (REPORT_WCO_REFRESH_BUSY_COUNT - 1);  // Reset counter for slow refresh
+        default:
+            sys.report_wco_counter = (REPORT_WCO_REFRESH_IDLE_COUNT - 1);
+            break;
+    }
+    if (sys.report_ovr_counter == 0) {
+        sys.report_ovr_counter = 1;  // Set override on next report.
+    }
+    return true;
+}
 #endif
+
+#ifdef REPORT_FIELD_OVERRIDES
+static bool report_ovr_due() {
+    if (sys.report_ovr_counter > 0) {
+        sys.report_ovr_counter--;
+        return false;
+    }
+    switch (sys.state) {
+        case State::Homing:
+        case State::Cycle:
+        case State::Hold:
+        case State::Jog:
+        case State::SafetyDoor:
+            sys.report_ovr_counter = (REPORT_OVR_REFRESH_BUSY_COUNT - 1);  // Reset counter for slow refresh
+        default:
+            sys.report_ovr_counter = (REPORT_OVR_REFRESH_IDLE_COUNT - 1);
+            break;
+    }
+    return true;
+}
+#endif
+
+static char* report_status_tail(char* end, bool all_fields) {
+    char temp[MAX_N_AXIS * 20];
 #ifdef USE_LINE_NUMBERS
 #    ifdef REPORT_FIELD_LINE_NUMBERS
     // Report current line number
@@ -626,142 +815,112 @@ void report_realtime_status(uint8_t client) {
     if (cur_block != NULL) {
         uint32_t ln = cur_block->line_number;
         if (ln > 0) {
-            sprintf(temp, "|Ln:%d", ln);
-            strcat(status, temp);
+            end = report_append(end, "|Ln:");
+            end = report_append_int(end, ln);
         }
     }
 #    endif
 #endif
     // Report realtime feed speed
 #ifdef REPORT_FIELD_CURRENT_FEED_SPEED
-    if (report_inches->get()) {
-        sprintf(temp, "|FS:%.1f,%d", st_get_realtime_rate() / MM_PER_INCH, sys.spindle_speed);
+    end = report_append(end, "|FS:");
+    if (report_in_inches) {
+        end = report_append_fixed(end, st_get_realtime_rate() / MM_PER_INCH, 1);
     } else {
-        sprintf(temp, "|FS:%.0f,%d", st_get_realtime_rate(), sys.spindle_speed);
+        end = report_append_fixed(end, st_get_realtime_rate(), 0);
     }
-    strcat(status, temp);
+    *end++ = ',';
+    end    = report_append_int(end, sys.spindle_speed);
 #endif
 #ifdef REPORT_FIELD_PIN_STATE
     AxisMask    lim_pin_state  = limits_get_state();
     ControlPins ctrl_pin_state = system_control_get_state();
     bool        prb_pin_state  = probe_get_state();
     if (lim_pin_state || ctrl_pin_state.value || prb_pin_state) {
-        strcat(status, "|Pn:");
+        end = report_append(end, "|Pn:");
         if (prb_pin_state) {
-            strcat(status, "P");
+            *end++ = 'P';
         }
         if (lim_pin_state) {
             auto n_axis = number_axis->get();
-            if (n_axis >= 1 && bit_istrue(lim_pin_state, bit(X_AXIS))) {
-                strcat(status, "X");
-            }
-            if (n_axis >= 2 && bit_istrue(lim_pin_state, bit(Y_AXIS))) {
-                strcat(status, "Y");
-            }
-            if (n_axis >= 3 && bit_istrue(lim_pin_state, bit(Z_AXIS))) {
-                strcat(status, "Z");
-            }
-            if (n_axis >= 4 && bit_istrue(lim_pin_state, bit(A_AXIS))) {
-                strcat(status, "A");
-            }
-            if (n_axis >= 5 && bit_istrue(lim_pin_state, bit(B_AXIS))) {
-                strcat(status, "B");
-            }
-            if (n_axis >= 6 && bit_istrue(lim_pin_state, bit(C_AXIS))) {
-                strcat(status, "C");
+            for (uint8_t idx = 0; idx < n_axis; idx++) {
+                if (bit_istrue(lim_pin_state, bit(idx))) {
+                    *end++ = "XYZABC"[idx];
+                }
             }
         }
         if (ctrl_pin_state.value) {
             if (ctrl_pin_state.bit.safetyDoor) {
-                strcat(status, "D");
+                *end++ = 'D';
             }
             if (ctrl_pin_state.bit.reset) {
-                strcat(status, "R");
+                *end++ = 'R';
             }
             if (ctrl_pin_state.bit.feedHold) {
-                strcat(status, "H");
+                *end++ = 'H';
             }
             if (ctrl_pin_state.bit.cycleStart) {
-                strcat(status, "S");
+                *end++ = 'S';
             }
             if (ctrl_pin_state.bit.macro0) {
-                strcat(status, "0");
+                *end++ = '0';
             }
             if (ctrl_pin_state.bit.macro1) {
-                strcat(status, "1");
+                *end++ = '1';
             }
             if (ctrl_pin_state.bit.macro2) {
-                strcat(status, "2");
+                *end++ = '2';
             }
             if (ctrl_pin_state.bit.macro3) {
-                strcat(status, "3");
+                *end++ = '3';
             }
         }
     }
 #endif
 #ifdef REPORT_FIELD_WORK_COORD_OFFSET
-    if (sys.report_wco_counter > 0) {
-        sys.report_wco_counter--;
-    } else {
-        switch (sys.state) {
-            case State::Homing:
-            case State::Cycle:
-            case State::Hold:
-            case State::Jog:
-            case State::SafetyDoor:
-                sys.report_wco_counter = (REPORT_WCO_REFRESH_BUSY_COUNT - 1);  // Reset counter for slow refresh
-            default:
-                sys.report_wco_counter = (REPORT_WCO_REFRESH_IDLE_COUNT - 1);
-                break;
-        }
-        if (sys.report_ovr_counter == 0) {
-            sys.report_ovr_counter = 1;  // Set override on next report.
-        }
-        strcat(status, "|WCO:");
-        report_util_axis_values(get_wco(), temp);
-        strcat(status, temp);
+    if (all_fields || report_wco_due()) {
+        end = report_append(end, "|WCO:");
+        end = report_append_axis_values(end, get_wco());
     }
 #endif
 #ifdef REPORT_FIELD_OVERRIDES
-    if (sys.report_ovr_counter > 0) {
-        sys.report_ovr_counter--;
-    } else {
-        switch (sys.state) {
-            case State::Homing:
-            case State::Cycle:
-            case State::Hold:
-            case State::Jog:
-            case State::SafetyDoor:
-                sys.report_ovr_counter = (REPORT_OVR_REFRESH_BUSY_COUNT - 1);  // Reset counter for slow refresh
-            default:
-                sys.report_ovr_counter = (REPORT_OVR_REFRESH_IDLE_COUNT - 1);
-                break;
+    if (all_fields || report_ovr_due()) {
+        end    = report_append(end, "|Ov:");
+        end    = report_append_int(end, sys.f_override);
+        *end++ = ',';
+        end    = report_append_int(end, sys.r_override);
+        *end++ = ',';
+        end    = report_append_int(end, sys.spindle_speed_ovr);
+        if (spindle_adaptive_enable->get()) {
+            end = report_append(end, "|AF:");
+            end = report_append_int(end, sys.f_adaptive);
+            if (adaptive_feed_load() >= 0) {
+                *end++ = ',';
+                end    = report_append_fixed(end, adaptive_feed_load(), 1);
+            }
         }
-
-        sprintf(temp, "|Ov:%d,%d,%d", sys.f_override, sys.r_override, sys.spindle_speed_ovr);
-        strcat(status, temp);
         SpindleState sp_state      = spindle->get_state();
         CoolantState coolant_state = coolant_get_state();
         if (sp_state != SpindleState::Disable || coolant_state.Mist || coolant_state.Flood) {
-            strcat(status, "|A:");
+            end = report_append(end, "|A:");
             switch (sp_state) {
                 case SpindleState::Disable:
                     break;
                 case SpindleState::Cw:
-                    strcat(status, "S");
+                    *end++ = 'S';
                     break;
                 case SpindleState::Ccw:
-                    strcat(status, "C");
+                    *end++ = 'C';
                     break;
             }
 
             auto coolant = coolant_state;
             if (coolant.Flood) {
-                strcat(status, "F");
+                *end++ = 'F';
             }
 #    ifdef COOLANT_MIST_PIN  // TODO Deal with M8 - Flood
             if (coolant.Mist) {
-                strcat(status, "M");
+                *end++ = 'M';
             }
 #    endif
         }
@@ -769,25 +928,229 @@ void report_realtime_status(uint8_t client) {
 #endif
 #ifdef ENABLE_SD_CARD
     if (get_sd_state(false) == SDState::BusyPrinting) {
-        sprintf(temp, "|SD:%4.2f,", sd_report_perc_complete());
-        strcat(status, temp);
+        end    = report_append(end, "|SD:");
+        end    = report_append_fixed(end, sd_report_perc_complete(), 2);
+        *end++ = ',';
         sd_get_current_filename(temp);
-        strcat(status, temp);
+        end = report_append(end, temp);
+        if (sd_estimate_valid()) {
+            end = report_append(end, "|ETA:");
+            end = report_append_int(end, sd_estimate_remaining(sd_get_current_line_number()));
+        }
+    }
+#endif
+#ifdef REPORT_FIELD_QUEUED_TIME
+    if (plan_get_current_block() != NULL) {
+        end = report_append(end, "|Qt:");
+        end = report_append_fixed(end, plan_get_queued_time(), 1);
     }
 #endif
+#ifdef REPORT_FIELD_STEPPER_ISR
+    end    = report_append(end, "|Isr:");
+    end    = report_append_int(end, st_isr_stats.reentered + st_isr_stats.skipped);
+    *end++ = ',';
+    end    = report_append_int(end, st_isr_stats.max_cycles / getCpuFrequencyMhz());
+    *end++ = ',';
+    end    = report_append_int(end, st_isr_stats.ticks ? st_isr_stats.min_slack / ticksPerMicrosecond : 0);
+#endif
+#if defined(REPORT_FIELD_FOLLOWING_ERROR) || defined(AXIS_ENCODERS)
+    float following_error[MAX_N_AXIS];
+#    ifdef AXIS_ENCODERS
+    axis_encoder_following_error(following_error);
+#    else
+    motors_get_following_error(following_error);
+#    endif
+    end = report_append(end, "|FE:");
+    end = report_append_axis_values(end, following_error);
+#endif
 #ifdef REPORT_HEAP
-    sprintf(temp, "|Heap:%d", esp.getHeapSize());
-    strcat(status, temp);
+    end = report_append(end, "|Heap:");
+    end = report_append_int(end, esp.getHeapSize());
 #endif
-    strcat(status, ">\r\n");
-    grbl_send(client, status);
+    return report_append(end, ">\r\n");
+}
+
+// Compact status reports. A client that opts in with $Report/Delta gets the state and only the
+// fields that changed since its last report, and a field that went away is sent empty. The
+// first report after opting in and every REPORT_DELTA_KEYFRAME-th one after carry all fields.
+static const char* const report_field_names[] = {
+    "MPos", "WPos", "Bf", "Ln", "FS", "Pn", "WCO", "Ov", "A", "SD", "Qt", "Isr", "FE", "Heap",
+};
+static const int         REPORT_FIELD_COUNT   = sizeof(report_field_names) / sizeof(report_field_names[0]);
+
+typedef struct {
+    bool     enabled;
+    uint8_t  reports;                         // Reports since the last keyframe
+    uint16_t present;                         // Fields in the last report, a bit per name
+    uint32_t field_hash[REPORT_FIELD_COUNT];  // FNV-1a hashes of the fields in the last report
+} report_delta_t;
+static report_delta_t report_delta[CLIENT_COUNT];
+
+void report_set_delta(uint8_t client, bool enabled) {
+    if (client >= CLIENT_COUNT) {
+        return;
+    }
+    report_delta[client].reports = 0;
+    report_delta[client].enabled = enabled;
+}
+
+bool report_get_delta(uint8_t client) {
+    return client < CLIENT_COUNT && report_delta[client].enabled;
+}
+
+// Drops the fields of a full report, which ends at end, that the client already has and
+// returns the new end. Works in place since the output never gets ahead of the input, apart
+// from the empty fields added at the end.
+static char* report_delta_filter(uint8_t client, char* status, char* end) {
+    report_delta_t* delta    = &report_delta[client];
+    bool            keyframe = delta->reports == 0;
+    delta->reports           = (delta->reports + 1) % REPORT_DELTA_KEYFRAME;
+
+    char* in = strchr(status, '|');
+    if (in == NULL) {
+        return end;  // Only the state, which is always sent
+    }
+    char*    out     = in;
+    uint16_t present = 0;
+    while (*in == '|') {
+        char* field    = in++;
+        char* name     = in;
+        char* name_end = NULL;
+        while (*in && *in != '|' && *in != '>') {
+            if (*in == ':' && name_end == NULL) {
+                name_end = in;
+            }
+            in++;
+        }
+        uint32_t hash = 2166136261u;
+        for (char* c = field; c < in; c++) {
+            hash = (hash ^ uint8_t(*c)) * 16777619u;
+        }
+        bool send = true;  // Fields without a known name are always sent
+        if (name_end) {
+            for (int i = 0; i < REPORT_FIELD_COUNT; i++) {
+                const char* known = report_field_names[i];
+                if (strlen(known) == size_t(name_end - name) && strncmp(known, name, name_end - name) == 0) {
+                    send = keyframe || bit_isfalse(delta->present, bit(i)) || delta->field_hash[i] != hash;
+                    present |= bit(i);
+                    delta->field_hash[i] = hash;
+                    break;
+                }
+            }
+        }
+        if (send) {
+            memmove(out, field, in - field);
+            out += in - field;
+        }
+    }
+    uint16_t gone  = keyframe ? 0 : delta->present & ~present;
+    delta->present = present;
+    for (int i = 0; i < REPORT_FIELD_COUNT; i++) {
+        if (bit_istrue(gone, bit(i))) {
+            *out++ = '|';
+            out    = report_append(out, report_field_names[i]);
+            *out++ = ':';
+        }
+    }
+    return report_append(out, ">\r\n");
+}
+
+void report_realtime_status(uint8_t client) {
+    char  status[320];
+    bool  delta = report_get_delta(client);
+    char* end   = report_status_head(status);
+    end         = report_status_buffer_state(end, client);
+    end         = report_status_tail(end, delta);
+    if (delta) {
+        end = report_delta_filter(client, status, end);
+    }
+    grbl_send(client, status, end - status);
+}
+
+// Auto report intervals in milliseconds per client, 0 when off, and when each is due next.
+// Due times are aligned to multiples of the interval, so clients on the same or related
+// intervals come due together and share one report.
+static uint32_t report_auto_interval[CLIENT_COUNT];
+static uint32_t report_auto_next[CLIENT_COUNT];
+
+void report_set_auto_interval(uint8_t client, uint32_t interval_ms) {
+    if (client >= CLIENT_COUNT || client == CLIENT_INPUT) {
+        return;
+    }
+    if (interval_ms && interval_ms < REPORT_AUTO_MIN_INTERVAL) {
+        interval_ms = REPORT_AUTO_MIN_INTERVAL;
+    }
+    report_auto_next[client]     = millis();
+    report_auto_interval[client] = interval_ms;
+    client_wake();  // The client task may be sleeping until the old due time
+}
+
+uint32_t report_get_auto_interval(uint8_t client) {
+    return client < CLIENT_COUNT ? report_auto_interval[client] : 0;
+}
+
+// Called from the client task, which is the only caller, so the buffers are static to keep
+// them off its small stack.
+uint32_t report_auto_status() {
+    static char head[120];
+    static char tail[240];
+    static char delta_tail[240];
+    static char status[360];
+    uint32_t    now       = millis();
+    uint32_t    wait      = UINT32_MAX;
+    uint8_t     due       = 0;
+    uint8_t     delta_due = 0;
+    for (uint8_t client = 0; client < CLIENT_COUNT; client++) {
+        uint32_t interval = report_auto_interval[client];
+        if (!interval) {
+            continue;
+        }
+        if (int32_t(now - report_auto_next[client]) >= 0) {
+            report_auto_next[client] = now - now % interval + interval;
+            if (report_get_delta(client)) {
+                delta_due |= bit(client);
+            } else {
+                due |= bit(client);
+            }
+        }
+        wait = MIN(wait, report_auto_next[client] - now);
+    }
+    if (!(due | delta_due)) {
+        return wait;
+    }
+    size_t head_len       = report_status_head(head) - head;
+    size_t tail_len       = 0;
+    size_t delta_tail_len = 0;
+    if (due) {
+        tail_len = report_status_tail(tail, false) - tail;
+    }
+    if (delta_due) {
+        delta_tail_len = report_status_tail(delta_tail, true) - delta_tail;
+    }
+    for (uint8_t client = 0; client < CLIENT_COUNT; client++) {
+        if (bit_istrue(due | delta_due, bit(client))) {
+            memcpy(status, head, head_len);
+            char* end = report_status_buffer_state(status + head_len, client);
+            if (bit_istrue(delta_due, bit(client))) {
+                memcpy(end, delta_tail, delta_tail_len + 1);
+                end = report_delta_filter(client, status, end + delta_tail_len);
+            } else {
+                memcpy(end, tail, tail_len + 1);
+                end += tail_len;
+            }
+            grbl_send(client, status, end - status);
+        }
+    }
+    return wait;
 }
 
 void report_realtime_steps() {
     uint8_t idx;
     auto    n_axis = number_axis->get();
+    int32_t position[MAX_N_AXIS];
+    st_get_position(position);
     for (idx = 0; idx < n_axis; idx++) {
-        grbl_sendf(CLIENT_ALL, "%ld\n", sys_position[idx]);  // OK to send to all ... debug stuff
+        grbl_sendf(CLIENT_ALL, "%ld\n", position[idx]);  // OK to send to all ... debug stuff
     }
 }
 
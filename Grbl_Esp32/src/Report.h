@@ -26,8 +26,6 @@ enum RtStatus {
     Buffer   = bit(1),
 };
 
-const char* errorString(Error errorNumber);
-
 // Define Grbl feedback message codes. Valid values (0-255).
 enum class Message : uint8_t {
     CriticalEvent   = 1,
@@ -49,8 +47,11 @@ enum class Message : uint8_t {
 #define CLIENT_WEBUI 2
 #define CLIENT_TELNET 3
 #define CLIENT_INPUT 4
+#define CLIENT_WEBSOCKET 5
+#define CLIENT_TCP 6
+#define CLIENT_USB 7
 #define CLIENT_ALL 0xFF
-#define CLIENT_COUNT 5  // total number of client types regardless if they are used
+#define CLIENT_COUNT 8  // total number of client types regardless if they are used
 
 enum class MsgLevel : int8_t {  // Use $Message/Level
     None    = 0,
@@ -61,8 +62,15 @@ enum class MsgLevel : int8_t {  // Use $Message/Level
     Verbose = 5,
 };
 
+// Sets up the formatting buffers of grbl_sendf() and grbl_msg_sendf().
+void report_init();
+
+// Starts keeping copies of the report settings; needs them to be loaded.
+void report_settings_init();
+
 // functions to send data to the user.
 void grbl_send(uint8_t client, const char* text);
+void grbl_send(uint8_t client, const char* text, size_t length);
 void grbl_sendf(uint8_t client, const char* format, ...);
 void grbl_msg_sendf(uint8_t client, MsgLevel level, const char* format, ...);
 
@@ -95,6 +103,22 @@ void report_echo_line_received(char* line, uint8_t client);
 // Prints realtime status report
 void report_realtime_status(uint8_t client);
 
+// Status reports pushed at a fixed interval, set per client with $Report/Interval. Clients that
+// come due together share one formatted report, apart from the buffer state field.
+// report_auto_status() sends the reports that are due and returns the milliseconds until the
+// next one, or UINT32_MAX when none are on.
+const uint32_t REPORT_AUTO_MIN_INTERVAL = 20;  // ms
+void           report_set_auto_interval(uint8_t client, uint32_t interval_ms);
+uint32_t       report_get_auto_interval(uint8_t client);
+uint32_t       report_auto_status();
+
+// Compact status reports, set per client with $Report/Delta. They carry the state and only the
+// fields that changed since the last report to the client, with all fields in every
+// REPORT_DELTA_KEYFRAME-th report.
+const uint8_t REPORT_DELTA_KEYFRAME = 20;
+void          report_set_delta(uint8_t client, bool enabled);
+bool          report_get_delta(uint8_t client);
+
 // Prints recorded probe position
 void report_probe_parameters(uint8_t client);
 
@@ -130,5 +154,10 @@ char* reportAxisNameMsg(uint8_t axis, uint8_t dual_axis);
 void reportTaskStackSize(UBaseType_t& saved);
 
 char*  report_state_text();
+
+// Append text, or the axis values in the report units, at end, keep the string terminated and
+// return the new end.
+char* report_append(char* end, const char* text);
+char* report_append_axis_values(char* end, const float* axis_value);
 float* get_wco();
 void   mpos_to_wpos(float* position);
@@ -0,0 +1,395 @@
+/*
+  SDCache.cpp - Compiled copies of SD card G-code files
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  A compiled copy is the file with each plain G0 to G3 move replaced by a binary motion frame
+  (see BinaryMotion.h), which runs without going through the parser. Every other line is copied
+  as it is, so the copy runs through the same SD job path, line for line, and reports the same
+  line numbers.
+
+  A move can only be compiled when everything it depends on is known from the file itself, so
+  each mode starts out unknown and the compiler tracks it as the file sets it: the motion mode,
+  plane, units, distance and feed rate modes, and the feed rate. A move is compiled only in G90
+  and G94 with the units known, and, unless it is a rapid, with a known feed rate. Lines that
+  could change the modes in ways that cannot be followed here, like parameters, expressions and
+  most M codes, make all of them unknown again, and files with O-word flow control, where lines
+  do not run in file order, are not compiled at all.
+
+  The first line of the copy is a comment holding the size and modification time of the source
+  and the axis count. A copy that does not match the source is ignored and made again.
+*/
+
+#include "Config.h"
+#ifdef ENABLE_SD_CARD
+#    include "Grbl.h"
+
+// Modes the file has set, -1 until then.
+typedef struct {
+    int8_t motion;      // 0 to 3 for G0 to G3, -1 for any other motion mode
+    int8_t plane;       // Plane
+    int8_t inches;      // 1 for G20, 0 for G21
+    int8_t absolute;    // 1 for G90, 0 for G91
+    int8_t per_minute;  // 1 for G94, 0 for G93
+    float  feed;        // mm/min
+} sd_cache_modes_t;
+
+// Arc center offset words, 0 to 2 for I to K, along the two axes of each plane
+static const uint8_t plane_offsets[3][2] = { { 0, 1 }, { 2, 0 }, { 1, 2 } };
+
+static const char axis_letters[] = "XYZABC";
+
+static void sd_cache_forget(sd_cache_modes_t* m) {
+    m->motion     = -1;
+    m->plane      = -1;
+    m->inches     = -1;
+    m->absolute   = -1;
+    m->per_minute = -1;
+    m->feed       = -1.0;
+}
+
+static void sd_cache_header(File& source, char* header, size_t size) {
+    snprintf(header, size, "(GBC1,%u,%ld,%d)", (unsigned)source.size(), (long)source.getLastWrite(), number_axis->get());
+}
+
+bool sd_cache_strip(const char* line, char* words, size_t size) {
+    size_t n         = 0;
+    bool   commented = false;
+    bool   in_paren  = false;
+    for (const char* p = line; *p && n < size - 1; p++) {
+        char c = *p;
+        if (in_paren) {
+            in_paren = c != ')';
+        } else if (c == '(') {
+            in_paren = commented = true;
+        } else if (c == ';') {
+            commented = true;
+            break;
+        } else if (!isspace(c) && c != '%') {
+            words[n++] = toupper(c);
+        }
+    }
+    words[n] = '\0';
+    return commented;
+}
+
+static uint8_t* put_int32(uint8_t* p, int32_t value) {
+    for (int i = 0; i < 4; i++) {
+        *p++ = value >> (8 * i);
+    }
+    return p;
+}
+
+// Tracks the modes set by a line and, if it is a move that can be compiled, builds its frame
+// in frame. Returns the length of the frame, 0 to keep the line as text, or -1 if the file
+// cannot be compiled.
+static int sd_cache_compile_line(const char* line, sd_cache_modes_t* m, uint8_t* frame) {
+    char words[LINE_BUFFER_SIZE];
+    bool commented = sd_cache_strip(line, words, sizeof(words));
+    if (words[0] == '\0' || words[0] == '$') {
+        return 0;  // Blank lines, comments and system commands leave the modes alone
+    }
+    if (strpbrk(words, "#[")) {
+        sd_cache_forget(m);
+        return 0;
+    }
+
+    auto    n_axis       = number_axis->get();
+    float   axis_values[MAX_N_AXIS];
+    float   offsets[3];
+    uint8_t axis_words   = 0;
+    uint8_t offset_words = 0;
+    int8_t  motion       = -1;
+    bool    has_feed     = false;
+    float   feed         = 0.0;
+    bool    text         = commented;
+    bool    forget       = false;
+    uint8_t counter      = 0;
+    while (words[counter]) {
+        char  letter = words[counter++];
+        float value;
+        if (letter < 'A' || letter > 'Z' || !read_float(words, &counter, &value)) {
+            sd_cache_forget(m);  // The parser will report it
+            return 0;
+        }
+        int         code     = int(value);
+        int         mantissa = lroundf(100 * (value - code));
+        const char* axis     = strchr(axis_letters, letter);
+        if (axis && axis - axis_letters < n_axis) {
+            uint8_t idx = axis - axis_letters;
+            text |= bit_istrue(axis_words, bit(idx));
+            axis_words |= bit(idx);
+            axis_values[idx] = value;
+            continue;
+        }
+        switch (letter) {
+            case 'G':
+                // Only G0 to G3 go into frames. Other modal G codes are tracked but keep the line as text.
+                text |= code > 3 || mantissa != 0 || motion >= 0;
+                if (mantissa != 0) {
+                    if (code == 38) {
+                        m->motion = -1;  // G38.x probes
+                    }
+                    break;
+                }
+                switch (code) {
+                    case 0:
+                    case 1:
+                    case 2:
+                    case 3:
+                        motion = code;
+                        break;
+                    case 17:
+                    case 18:
+                    case 19:
+                        m->plane = code - 17;
+                        break;
+                    case 20:
+                    case 21:
+                        m->inches = code == 20;
+                        break;
+                    case 90:
+                    case 91:
+                        m->absolute = code == 90;
+                        break;
+                    case 93:
+                        m->per_minute = 0;
+                        m->feed       = -1.0;
+                        break;
+                    case 94:
+                        if (m->per_minute != 1) {
+                            m->feed = -1.0;  // The parser clears the feed rate when leaving G93
+                        }
+                        m->per_minute = 1;
+                        break;
+                    case 73:
+                    case 80:
+                    case 81:
+                    case 82:
+                    case 83:
+                    case 84:
+                    case 85:
+                    case 86:
+                    case 87:
+                    case 88:
+                    case 89:
+                        m->motion = -1;  // Canned cycles and G80
+                        break;
+                }
+                break;
+            case 'M':
+                // Spindle and coolant changes are safe. Anything else might stop the program, run a
+                // macro or wait for the user, any of which can change the modes.
+                text = true;
+                forget |= mantissa != 0 || !(code == 3 || code == 4 || code == 5 || code == 7 || code == 8 || code == 9);
+                break;
+            case 'F':
+                text |= has_feed;
+                has_feed = true;
+                feed     = value;
+                break;
+            case 'I':
+            case 'J':
+            case 'K':
+                text |= bit_istrue(offset_words, bit(letter - 'I'));
+                offset_words |= bit(letter - 'I');
+                offsets[letter - 'I'] = value;
+                break;
+            case 'O':
+                return -1;
+#ifndef USE_LINE_NUMBERS
+            case 'N':
+                break;  // Only used for status reports
+#endif
+            default:
+                text = true;
+                break;
+        }
+    }
+
+    if (motion >= 0) {
+        m->motion = motion;
+    }
+    if (has_feed) {
+        if (m->inches < 0 || m->per_minute != 1) {
+            m->feed = -1.0;
+        } else {
+            m->feed = m->inches ? feed * MM_PER_INCH : feed;
+        }
+    }
+    if (forget) {
+        sd_cache_forget(m);
+        return 0;
+    }
+    if (text || !axis_words || m->motion < 0 || m->absolute != 1 || m->inches < 0) {
+        return 0;
+    }
+    if (m->motion != 0 && (m->per_minute != 1 || m->feed <= 0.0)) {
+        return 0;
+    }
+    bool is_arc = m->motion >= 2;
+    if (is_arc) {
+        if (m->plane < 0) {
+            return 0;
+        }
+        uint8_t plane_words = bit(plane_offsets[m->plane][0]) | bit(plane_offsets[m->plane][1]);
+        if (!offset_words || (offset_words & ~plane_words)) {
+            return 0;  // Radius arcs, or words the parser will complain about
+        }
+    } else if (offset_words) {
+        return 0;
+    }
+
+    float    scale   = m->inches ? MM_PER_INCH * BINARY_POSITION_SCALE : BINARY_POSITION_SCALE;
+    uint8_t* payload = frame + 2;
+    uint8_t* p       = payload;
+    *p++             = m->motion;
+    *p++             = axis_words;
+    p                = put_int32(p, m->feed > 0.0 ? lroundf(m->feed * BINARY_FEED_SCALE) : 0);
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        if (bit_istrue(axis_words, bit(idx))) {
+            float value = axis_values[idx] * scale;
+            if (fabsf(value) > INT32_MAX / 2) {
+                return 0;
+            }
+            p = put_int32(p, lroundf(value));
+        }
+    }
+    if (is_arc) {
+        for (int i = 0; i < 2; i++) {
+            uint8_t word = plane_offsets[m->plane][i];
+            // A missing offset is zero, as in the parser
+            float value = bit_istrue(offset_words, bit(word)) ? offsets[word] * scale : 0.0;
+            if (fabsf(value) > INT32_MAX / 2) {
+                return 0;
+            }
+            p = put_int32(p, lroundf(value));
+        }
+    }
+    uint8_t length = p - payload;
+    uint8_t sum    = 0;
+    for (int i = 0; i < length; i++) {
+        sum += payload[i];
+    }
+    *p++     = ~sum;
+    frame[0] = BINARY_FRAME_START;
+    frame[1] = length;
+    return p - frame;
+}
+
+bool sd_cache_current(fs::FS& fs, const char* path, String& cache_path) {
+    cache_path  = String(path) + SD_CACHE_EXTENSION;
+    File source = fs.open(path);
+    if (!source) {
+        return false;
+    }
+    char expected[48];
+    sd_cache_header(source, expected, sizeof(expected));
+    source.close();
+    File cache = fs.open(cache_path);
+    if (!cache) {
+        return false;
+    }
+    char   header[48];
+    size_t len  = cache.readBytesUntil('\n', header, sizeof(header) - 1);
+    header[len] = '\0';
+    cache.close();
+    return strcmp(header, expected) == 0;
+}
+
+// Copies a line to the compiled file, as a frame if it can be compiled.
+static Error sd_cache_line(File& out, const char* line, size_t len, sd_cache_modes_t* modes, uint32_t* frames) {
+    uint8_t frame[BINARY_FRAME_MAX + 3];
+    int     frame_len = sd_cache_compile_line(line, modes, frame);
+    if (frame_len < 0) {
+        return Error::FsFailedCompile;
+    }
+    if (frame_len) {
+        (*frames)++;
+        return out.write(frame, frame_len) == size_t(frame_len) ? Error::Ok : Error::FsFailedCompile;
+    }
+    if (out.write((const uint8_t*)line, len) != len || out.write('\n') != 1) {
+        return Error::FsFailedCompile;
+    }
+    return Error::Ok;
+}
+
+Error sd_cache_compile(fs::FS& fs, const char* path, const String& cache_path, uint8_t client) {
+    File source = fs.open(path);
+    if (!source) {
+        return Error::FsFailedOpenFile;
+    }
+    // Writing to another name first keeps a partial copy from ever looking current.
+    String   temp_path = cache_path + ".tmp";
+    File     out       = fs.open(temp_path, FILE_WRITE);
+    uint8_t* block     = (uint8_t*)heap_alloc_large(HeapTag::SD, SD_READ_BLOCK_SIZE);
+    if (!out || !block) {
+        heap_free(HeapTag::SD, block, SD_READ_BLOCK_SIZE);
+        source.close();
+        return Error::FsFailedCompile;
+    }
+    char header[48];
+    sd_cache_header(source, header, sizeof(header));
+    out.printf("%s\n", header);
+
+    // Lines are limited to what readFileLine() will read back.
+    char             line[255];
+    size_t           len    = 0;
+    uint32_t         lines  = 0;
+    uint32_t         frames = 0;
+    Error            status = Error::Ok;
+    sd_cache_modes_t modes;
+    sd_cache_forget(&modes);
+    int count;
+    while (status == Error::Ok && (count = source.read(block, SD_READ_BLOCK_SIZE)) > 0) {
+        for (int i = 0; i < count && status == Error::Ok; i++) {
+            if (block[i] != '\n') {
+                if (len < sizeof(line) - 1) {
+                    line[len++] = block[i];
+                } else {
+                    lines++;
+                    status = Error::FsFailedCompile;
+                }
+                continue;
+            }
+            line[len] = '\0';
+            lines++;
+            status = sd_cache_line(out, line, len, &modes, &frames);
+            len    = 0;
+        }
+    }
+    if (status == Error::Ok && len) {
+        line[len] = '\0';
+        lines++;
+        status = sd_cache_line(out, line, len, &modes, &frames);
+    }
+    heap_free(HeapTag::SD, block, SD_READ_BLOCK_SIZE);
+    source.close();
+    out.close();
+
+    sd_dir_index_invalidate();
+    if (status == Error::Ok) {
+        fs.remove(cache_path);
+        if (!fs.rename(temp_path, cache_path)) {
+            status = Error::FsFailedCompile;
+        }
+    }
+    if (status != Error::Ok) {
+        fs.remove(temp_path);
+        grbl_msg_sendf(client, MsgLevel::Info, "%s not compiled, stopped at line %d", path, lines);
+        return status;
+    }
+    grbl_msg_sendf(client, MsgLevel::Info, "Compiled %s, %d of %d lines to binary", path, frames, lines);
+    return Error::Ok;
+}
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+
+/*
+  SDCache.h - Compiled copies of SD card G-code files
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Error.h"
+
+#include <FS.h>
+#include <cstdint>
+
+// The compiled copy of a file is kept next to it, with this appended to the name.
+const char* const SD_CACHE_EXTENSION = ".gbc";
+
+// Sets cache_path to the name of the compiled copy of path and returns true if that copy
+// exists and was made from the current contents of path.
+bool sd_cache_current(fs::FS& fs, const char* path, String& cache_path);
+
+// Copies the words of a G-code line to words, upper case and without spaces, and returns true
+// if it had comments. Unlike the parser, it does not report the comments.
+bool sd_cache_strip(const char* line, char* words, size_t size);
+
+// Compiles path into cache_path, replacing any older copy.
+Error sd_cache_compile(fs::FS& fs, const char* path, const String& cache_path, uint8_t client);
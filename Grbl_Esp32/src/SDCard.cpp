@@ -29,6 +29,471 @@ WebUI::AuthenticationLevel SD_auth_level = WebUI::AuthenticationLevel::LEVEL_GUE
 uint32_t                   sd_current_line_number;     // stores the most recent line number read from the SD
 static char                comment[LINE_BUFFER_SIZE];  // Line to be executed. Zero-terminated.
 
+// Read-ahead. Indices of the buffers to fill go to sdReadTask through sd_free_blocks, and
+// come back with the number of bytes read through sd_full_blocks, in order. A block of 0
+// bytes marks the end of the file. The reader holds sd_read_lock while it uses the buffers.
+typedef struct {
+    uint8_t index;
+    size_t  length;
+} sd_block_t;
+static uint8_t*          sd_buffers[SD_READ_BUFFERS];
+static QueueHandle_t     sd_free_blocks = NULL;
+static QueueHandle_t     sd_full_blocks = NULL;
+static SemaphoreHandle_t sd_read_lock   = NULL;
+static sd_block_t        sd_block;        // The block lines are being split from
+static size_t            sd_block_pos;    // Next byte in sd_block
+static int               sd_outstanding;  // Blocks with sdReadTask
+static bool              sd_eof;          // sd_block is the end marker
+static uint32_t          sd_consumed;     // Bytes of the file split into lines so far
+static uint32_t          sd_file_size;
+static bool              sd_compiled;     // Lines may be binary motion frames, see SDCache.h
+static bool              sd_short_read;   // The file ended before its size, so a read failed
+
+// Directory index for the web file browser, see SDCard.h. Both arrays grow as it is built.
+typedef struct {
+    uint32_t size;
+    uint16_t name;  // Offset in dir_names
+    bool     dir;
+} sd_dir_entry_t;
+static sd_dir_entry_t* dir_entries     = NULL;
+static char*           dir_names       = NULL;
+static int             dir_count       = -1;  // -1 when there is no index
+static int             dir_entries_cap = 0;
+static size_t          dir_names_len   = 0;
+static size_t          dir_names_cap   = 0;
+static String          dir_path;
+static uint64_t        dir_used;  // sd_used_bytes() when it was built
+
+static bool sd_on_mmc    = false;  // Mounted with SD_MMC rather than SD
+static int  sd_slow_down = 0;      // Steps down from the configured bus speed after errors
+
+// Inflating .gz files. sdReadTask inflates into the read-ahead buffers instead of reading the
+// file into them. Deflate refers back up to 32 KB, so that much of the output is kept in dict.
+typedef struct {
+    tinfl_decompressor inflator;
+    uint8_t            dict[TINFL_LZ_DICT_SIZE];
+    uint8_t            in[SD_GZ_INPUT_SIZE];
+    size_t             in_pos;
+    size_t             in_len;
+    size_t             dict_pos;  // Where inflating continues in dict
+    size_t             out_pos;   // Inflated bytes in dict not yet copied out
+    size_t             out_len;
+    bool               in_eof;
+    bool               done;
+    uint32_t           size;  // Inflated size, from the gzip trailer
+} sd_gz_t;
+static sd_gz_t* sd_gz = NULL;
+
+bool sd_is_compressed(const char* path) {
+    size_t len = strlen(path);
+    return len > 3 && strcasecmp(path + len - 3, ".gz") == 0;
+}
+
+static int gz_byte() {
+    uint8_t c;
+    return myFile.read(&c, 1) == 1 ? c : -1;
+}
+
+// Reads the gzip header and trailer of myFile and leaves it at the start of the deflate data.
+static bool sd_gz_begin() {
+    uint8_t header[10];
+    if (myFile.read(header, sizeof(header)) != sizeof(header) || header[0] != 0x1f || header[1] != 0x8b || header[2] != 8) {
+        return false;
+    }
+    uint8_t flags = header[3];
+    if (flags & 0x04) {  // FEXTRA
+        int lo = gz_byte();
+        int hi = gz_byte();
+        if (hi < 0 || !myFile.seek(myFile.position() + (lo | (hi << 8)))) {
+            return false;
+        }
+    }
+    for (uint8_t flag = 0x08; flag <= 0x10; flag <<= 1) {  // FNAME, FCOMMENT
+        if (flags & flag) {
+            int c;
+            while ((c = gz_byte()) > 0) {}
+            if (c < 0) {
+                return false;
+            }
+        }
+    }
+    if ((flags & 0x02) && !myFile.seek(myFile.position() + 2)) {  // FHCRC
+        return false;
+    }
+    size_t  start = myFile.position();
+    uint8_t trailer[4];
+    if (!myFile.seek(myFile.size() - 4) || myFile.read(trailer, 4) != 4 || !myFile.seek(start)) {
+        return false;
+    }
+    sd_gz = (sd_gz_t*)heap_alloc_large(HeapTag::SD, sizeof(sd_gz_t));
+    if (sd_gz == NULL) {
+        return false;
+    }
+    tinfl_init(&sd_gz->inflator);
+    sd_gz->in_pos   = 0;
+    sd_gz->in_len   = 0;
+    sd_gz->dict_pos = 0;
+    sd_gz->out_pos  = 0;
+    sd_gz->out_len  = 0;
+    sd_gz->in_eof   = false;
+    sd_gz->done     = false;
+    sd_gz->size     = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | ((uint32_t)trailer[3] << 24);
+    return true;
+}
+
+static void sd_gz_end() {
+    heap_free(HeapTag::SD, sd_gz, sizeof(sd_gz_t));
+    sd_gz = NULL;
+}
+
+// Fills buf with inflated data. Returns less than size only at the end of the data, or where
+// it is corrupt.
+static size_t sd_gz_read(uint8_t* buf, size_t size) {
+    sd_gz_t* gz = sd_gz;
+    size_t   n  = 0;
+    while (n < size) {
+        if (gz->out_len) {
+            size_t count = MIN(gz->out_len, size - n);
+            memcpy(buf + n, gz->dict + gz->out_pos, count);
+            gz->out_pos += count;
+            gz->out_len -= count;
+            n += count;
+            continue;
+        }
+        if (gz->done) {
+            break;
+        }
+        if (gz->in_pos == gz->in_len && !gz->in_eof) {
+            gz->in_len = myFile.read(gz->in, sizeof(gz->in));
+            gz->in_pos = 0;
+            gz->in_eof = gz->in_len == 0;
+        }
+        size_t       in_bytes  = gz->in_len - gz->in_pos;
+        size_t       out_bytes = TINFL_LZ_DICT_SIZE - gz->dict_pos;
+        tinfl_status status    = tinfl_decompress(&gz->inflator,
+                                               gz->in + gz->in_pos,
+                                               &in_bytes,
+                                               gz->dict,
+                                               gz->dict + gz->dict_pos,
+                                               &out_bytes,
+                                               gz->in_eof ? 0 : TINFL_FLAG_HAS_MORE_INPUT);
+        gz->in_pos += in_bytes;
+        gz->out_pos  = gz->dict_pos;
+        gz->out_len  = out_bytes;
+        gz->dict_pos = (gz->dict_pos + out_bytes) & (TINFL_LZ_DICT_SIZE - 1);
+        gz->done     = status <= TINFL_STATUS_DONE;  // Finished, or failed
+    }
+    return n;
+}
+
+static void sdReadTask(void* pvParameters) {
+    uint8_t index;
+    while (true) {
+        xQueueReceive(sd_free_blocks, &index, portMAX_DELAY);
+        uint8_t*   buf   = sd_buffers[index];
+        sd_block_t block = { index, sd_gz ? sd_gz_read(buf, SD_READ_BLOCK_SIZE) : myFile.read(buf, SD_READ_BLOCK_SIZE) };
+        xQueueSend(sd_full_blocks, &block, portMAX_DELAY);
+    }
+}
+
+static bool sd_read_begin() {
+    if (sd_read_lock == NULL) {
+        sd_read_lock   = xSemaphoreCreateMutex();
+        sd_free_blocks = xQueueCreate(SD_READ_BUFFERS, sizeof(uint8_t));
+        sd_full_blocks = xQueueCreate(SD_READ_BUFFERS, sizeof(sd_block_t));
+        heap_task_create(sdReadTask,    // task
+                         "sdReadTask",  // name for task
+                         4096,          // size of task stack
+                         NULL,          // parameters
+                         1,             // priority
+                         NULL,          // handle
+                         0              // core, away from the main loop
+        );
+    }
+    for (uint8_t i = 0; i < SD_READ_BUFFERS; i++) {
+        sd_buffers[i] = (uint8_t*)heap_alloc_large(HeapTag::SD, SD_READ_BLOCK_SIZE);
+        if (sd_buffers[i] == NULL) {
+            while (i--) {
+                heap_free(HeapTag::SD, sd_buffers[i], SD_READ_BLOCK_SIZE);
+            }
+            return false;
+        }
+    }
+    sd_block       = { 0, 0 };
+    sd_block_pos   = 0;
+    sd_eof         = false;
+    sd_short_read  = false;
+    sd_consumed    = 0;
+    sd_file_size   = sd_gz ? sd_gz->size : myFile.size();
+    sd_outstanding = SD_READ_BUFFERS;
+    for (uint8_t i = 0; i < SD_READ_BUFFERS; i++) {
+        xQueueSend(sd_free_blocks, &i, portMAX_DELAY);
+    }
+    return true;
+}
+
+// Waits for the blocks that are still being read, so the file can be closed.
+static void sd_read_end() {
+    sd_block_t block;
+    while (sd_outstanding) {
+        xQueueReceive(sd_full_blocks, &block, portMAX_DELAY);
+        sd_outstanding--;
+    }
+    for (uint8_t i = 0; i < SD_READ_BUFFERS; i++) {
+        heap_free(HeapTag::SD, sd_buffers[i], SD_READ_BLOCK_SIZE);
+        sd_buffers[i] = NULL;
+    }
+}
+
+// Makes sure sd_block has a byte to read, moving on to the next block if needed. Returns
+// false at the end of the file.
+static bool sd_read_ready() {
+    while (sd_block_pos == sd_block.length) {
+        if (sd_eof) {
+            return false;
+        }
+        if (sd_outstanding < SD_READ_BUFFERS) {
+            xQueueSend(sd_free_blocks, &sd_block.index, portMAX_DELAY);  // Read into it again
+            sd_outstanding++;
+        }
+        xQueueReceive(sd_full_blocks, &sd_block, portMAX_DELAY);
+        sd_outstanding--;
+        sd_block_pos = 0;
+        sd_eof       = sd_block.length == 0;
+        if (sd_eof && sd_consumed < sd_file_size) {
+            sd_short_read = true;
+        }
+    }
+    return true;
+}
+
+// Write-behind for uploads. Full buffers go to sdWriteTask through sd_write_full and come
+// back through sd_write_free once written, so the next chunk is received while one is written.
+static uint8_t*      sd_write_buffers[SD_WRITE_BUFFERS];
+static QueueHandle_t sd_write_free  = NULL;
+static QueueHandle_t sd_write_full  = NULL;
+static File*         sd_write_file  = NULL;  // NULL when no upload is being written
+static sd_block_t    sd_write_block;         // The buffer being filled
+static bool          sd_write_filling;       // sd_write_block holds a buffer
+static volatile bool sd_write_error;
+
+static void sdWriteTask(void* pvParameters) {
+    sd_block_t block;
+    while (true) {
+        xQueueReceive(sd_write_full, &block, portMAX_DELAY);
+        if (!sd_write_error && sd_write_file->write(sd_write_buffers[block.index], block.length) != block.length) {
+            sd_write_error = true;
+        }
+        xQueueSend(sd_write_free, &block.index, portMAX_DELAY);
+    }
+}
+
+bool sd_write_begin(File& file) {
+    if (sd_write_free == NULL) {
+        sd_write_free = xQueueCreate(SD_WRITE_BUFFERS, sizeof(uint8_t));
+        sd_write_full = xQueueCreate(SD_WRITE_BUFFERS, sizeof(sd_block_t));
+        heap_task_create(sdWriteTask,    // task
+                         "sdWriteTask",  // name for task
+                         4096,           // size of task stack
+                         NULL,           // parameters
+                         1,              // priority
+                         NULL,           // handle
+                         0               // core, away from the main loop
+        );
+    }
+    for (uint8_t i = 0; i < SD_WRITE_BUFFERS; i++) {
+        sd_write_buffers[i] = (uint8_t*)heap_alloc_large(HeapTag::SD, SD_WRITE_BLOCK_SIZE);
+        if (sd_write_buffers[i] == NULL) {
+            while (i--) {
+                heap_free(HeapTag::SD, sd_write_buffers[i], SD_WRITE_BLOCK_SIZE);
+                sd_write_buffers[i] = NULL;
+            }
+            return false;
+        }
+    }
+    for (uint8_t i = 0; i < SD_WRITE_BUFFERS; i++) {
+        xQueueSend(sd_write_free, &i, portMAX_DELAY);
+    }
+    sd_write_file    = &file;
+    sd_write_filling = false;
+    sd_write_error   = false;
+    return true;
+}
+
+bool sd_write(const uint8_t* data, size_t length) {
+    while (length && !sd_write_error) {
+        if (!sd_write_filling) {
+            xQueueReceive(sd_write_free, &sd_write_block.index, portMAX_DELAY);  // Waits while the card catches up
+            sd_write_block.length = 0;
+            sd_write_filling      = true;
+        }
+        size_t count = MIN(length, SD_WRITE_BLOCK_SIZE - sd_write_block.length);
+        memcpy(sd_write_buffers[sd_write_block.index] + sd_write_block.length, data, count);
+        sd_write_block.length += count;
+        data += count;
+        length -= count;
+        if (sd_write_block.length == SD_WRITE_BLOCK_SIZE) {
+            xQueueSend(sd_write_full, &sd_write_block, portMAX_DELAY);
+            sd_write_filling = false;
+        }
+    }
+    return !sd_write_error;
+}
+
+bool sd_write_end() {
+    if (sd_write_file == NULL) {
+        return false;
+    }
+    if (sd_write_filling) {
+        if (sd_write_block.length) {
+            xQueueSend(sd_write_full, &sd_write_block, portMAX_DELAY);
+        } else {
+            xQueueSend(sd_write_free, &sd_write_block.index, portMAX_DELAY);
+        }
+    }
+    uint8_t index;
+    for (uint8_t i = 0; i < SD_WRITE_BUFFERS; i++) {  // All written once all are back
+        xQueueReceive(sd_write_free, &index, portMAX_DELAY);
+    }
+    for (uint8_t i = 0; i < SD_WRITE_BUFFERS; i++) {
+        heap_free(HeapTag::SD, sd_write_buffers[i], SD_WRITE_BLOCK_SIZE);
+        sd_write_buffers[i] = NULL;
+    }
+    sd_write_file = NULL;
+    return !sd_write_error;
+}
+
+static bool sd_mount(int slow_down) {
+    if (SDBus(sd_bus->get()) == SDBus::SPI) {
+        uint32_t freq = max(uint32_t(sd_spi_frequency->get()) * 1000 >> slow_down, SD_MIN_SPI_FREQ);
+        sd_on_mmc     = false;
+        return SD.begin((GRBL_SPI_SS == -1) ? SS : GRBL_SPI_SS, SPI, freq, "/sd", 2) && SD.cardSize() > 0;
+    }
+    sd_on_mmc = true;
+    return SD_MMC.begin("/sd", SDBus(sd_bus->get()) == SDBus::Mmc1Bit || slow_down > 0) && SD_MMC.cardSize() > 0;
+}
+
+fs::FS& sd_fs() {
+    if (sd_on_mmc) {
+        return SD_MMC;
+    }
+    return SD;
+}
+
+uint64_t sd_total_bytes() {
+    return sd_on_mmc ? SD_MMC.totalBytes() : SD.totalBytes();
+}
+
+uint64_t sd_used_bytes() {
+    return sd_on_mmc ? SD_MMC.usedBytes() : SD.usedBytes();
+}
+
+void sd_unmount() {
+    if (sd_on_mmc) {
+        SD_MMC.end();
+    } else {
+        SD.end();
+    }
+}
+
+void sd_reset_bus() {
+    sd_slow_down = 0;
+}
+
+bool sd_read_failed() {
+    if (!sd_short_read) {
+        return false;
+    }
+    // Likely CRC errors from a marginal bus, so the next mount is slower
+    if (sd_slow_down < SD_MAX_SLOW_DOWN) {
+        sd_slow_down++;
+    }
+    sd_short_read = false;
+    return true;
+}
+
+void sd_dir_index_invalidate() {
+    free(dir_entries);
+    free(dir_names);
+    dir_entries     = NULL;
+    dir_names       = NULL;
+    dir_count       = -1;
+    dir_entries_cap = 0;
+    dir_names_len   = 0;
+    dir_names_cap   = 0;
+}
+
+static bool dir_index_add(const char* name, uint32_t size, bool dir) {
+    size_t len = strlen(name) + 1;
+    if (dir_count == SD_DIR_INDEX_ENTRIES || dir_names_len + len > SD_DIR_INDEX_NAMES) {
+        return false;
+    }
+    if (dir_count == dir_entries_cap) {
+        int   cap  = MIN(MAX(2 * dir_entries_cap, 32), SD_DIR_INDEX_ENTRIES);
+        void* grow = realloc(dir_entries, cap * sizeof(sd_dir_entry_t));
+        if (grow == NULL) {
+            return false;
+        }
+        dir_entries     = (sd_dir_entry_t*)grow;
+        dir_entries_cap = cap;
+    }
+    if (dir_names_len + len > dir_names_cap) {
+        size_t cap  = MIN(MAX(2 * dir_names_cap, dir_names_len + len), SD_DIR_INDEX_NAMES);
+        void*  grow = realloc(dir_names, cap);
+        if (grow == NULL) {
+            return false;
+        }
+        dir_names     = (char*)grow;
+        dir_names_cap = cap;
+    }
+    dir_entries[dir_count++] = { size, uint16_t(dir_names_len), dir };
+    memcpy(dir_names + dir_names_len, name, len);
+    dir_names_len += len;
+    return true;
+}
+
+int sd_dir_index(const char* path) {
+    uint64_t used = sd_used_bytes();
+    if (dir_count >= 0 && used == dir_used && dir_path == path) {
+        return dir_count;
+    }
+    sd_dir_index_invalidate();
+    File dir = sd_fs().open(path);
+    if (!dir || !dir.isDirectory()) {
+        return -1;
+    }
+    dir_count  = 0;
+    bool added = true;
+    File entry = dir.openNextFile();
+    while (entry && added) {
+        const char* name = strrchr(entry.name(), '/');  // Names come with the path in front
+        name             = name ? name + 1 : entry.name();
+        added            = dir_index_add(name, entry.isDirectory() ? 0 : entry.size(), entry.isDirectory());
+        entry.close();
+        entry = dir.openNextFile();
+    }
+    dir.close();
+    if (!added) {
+        sd_dir_index_invalidate();
+        return -1;
+    }
+    dir_path = path;
+    dir_used = used;
+    return dir_count;
+}
+
+const char* sd_dir_index_name(int i) {
+    return dir_names + dir_entries[i].name;
+}
+
+uint32_t sd_dir_index_size(int i) {
+    return dir_entries[i].size;
+}
+
+bool sd_dir_index_is_dir(int i) {
+    return dir_entries[i].dir;
+}
+
 // attempt to mount the SD card
 /*bool sd_mount()
 {
@@ -63,30 +528,73 @@ void listDir(fs::FS& fs, const char* dirname, uint8_t levels, uint8_t client) {
     }
 }
 
-boolean openFile(fs::FS& fs, const char* path) {
+boolean openFile(fs::FS& fs, const char* path, bool compiled) {
     myFile = fs.open(path);
     if (!myFile) {
         //report_status_message(Error::FsFailedRead, CLIENT_SERIAL);
         return false;
     }
+    if (sd_is_compressed(path) && !sd_gz_begin()) {
+        myFile.close();
+        return false;
+    }
+    if (!sd_read_begin()) {
+        sd_gz_end();
+        myFile.close();
+        return false;
+    }
     set_sd_state(SDState::BusyPrinting);
-    SD_ready_next          = false;  // this will get set to true when Grbl issues "ok" message
+    SD_ready_next = false;  // this will get set to true when Grbl issues "ok" message
+    sd_compiled   = false;
+    sd_estimate_start(0);
+    if (compiled) {
+        // Skip the header, so line numbers are those of the source
+        readFileLine(comment, sizeof(comment));
+        sd_compiled = true;
+    }
     sd_current_line_number = 0;
     return true;
 }
 
+// Can be called from another task by a reset, so it waits for readFileLine() to finish.
 boolean closeFile() {
     if (!myFile) {
         return false;
     }
+    job_log_stop();
+    xSemaphoreTake(sd_read_lock, portMAX_DELAY);
     set_sd_state(SDState::Idle);
     SD_ready_next          = false;
     sd_current_line_number = 0;
+    sd_read_end();
+    sd_gz_end();
     myFile.close();
-    SD.end();
+    sd_estimate_clear();
+    xSemaphoreGive(sd_read_lock);
+    sd_unmount();
     return true;
 }
 
+boolean sd_chain_file(const char* path) {
+    job_log_stop();
+    xSemaphoreTake(sd_read_lock, portMAX_DELAY);
+    sd_read_end();
+    sd_gz_end();
+    myFile.close();
+    sd_estimate_clear();
+    xSemaphoreGive(sd_read_lock);
+    // A compiled copy is used if it is current. Compiling or scanning now would stall the machine.
+    String cache_path;
+    bool   compiled = sd_binary_cache->get() && !sd_is_compressed(path) && sd_cache_current(sd_fs(), path, cache_path);
+    if (openFile(sd_fs(), compiled ? cache_path.c_str() : path, compiled)) {
+        job_log_start_job(path, SD_client);
+        return true;
+    }
+    set_sd_state(SDState::Idle);
+    sd_unmount();
+    return false;
+}
+
 /*
   read a line from the SD card
   strip whitespace
@@ -99,28 +607,120 @@ boolean readFileLine(char* line, int maxlen) {
         report_status_message(Error::FsFailedRead, SD_client);
         return false;
     }
+    xSemaphoreTake(sd_read_lock, portMAX_DELAY);
+    if (!myFile) {
+        xSemaphoreGive(sd_read_lock);  // Closed by a reset while this waited
+        return false;
+    }
     sd_current_line_number += 1;
-    int len = 0;
-    while (myFile.available()) {
+    int  len   = 0;
+    bool more  = true;
+    int  frame = 0;  // Length of a binary frame being copied, which has no line ending
+    while ((more = sd_read_ready())) {
         if (len >= maxlen) {
+            xSemaphoreGive(sd_read_lock);
             return false;
         }
-        char c = myFile.read();
-        if (c == '\n') {
+        // Copy up to the end of the line or of the block in one go.
+        const uint8_t* start = sd_buffers[sd_block.index] + sd_block_pos;
+        size_t         avail = MIN(sd_block.length - sd_block_pos, size_t(maxlen - len));
+        if (len == 0 && sd_compiled && *start == BINARY_FRAME_START) {
+            frame = 2;  // Until the length byte is in
+        }
+        if (frame) {
+            size_t count = MIN(avail, size_t(frame - len));
+            memcpy(line + len, start, count);
+            len += count;
+            sd_block_pos += count;
+            sd_consumed += count;
+            if (len >= 2) {
+                frame = 3 + (uint8_t)line[1];
+            }
+            if (len == frame) {
+                more = sd_read_ready();
+                break;
+            }
+            continue;
+        }
+        const uint8_t* eol   = (const uint8_t*)memchr(start, '\n', avail);
+        size_t         count = eol ? eol - start : avail;
+        memcpy(line + len, start, count);
+        len += count;
+        sd_block_pos += count + (eol != NULL);
+        sd_consumed += count + (eol != NULL);
+        if (eol) {
+            more = sd_read_ready();
             break;
         }
-        line[len++] = c;
     }
     line[len] = '\0';
-    return len || myFile.available();
+    xSemaphoreGive(sd_read_lock);
+    return len || more;
+}
+
+Error sd_execute_line(char* line, uint8_t client, WebUI::AuthenticationLevel auth_level) {
+    if (sd_compiled && (uint8_t)line[0] == BINARY_FRAME_START) {
+        return binary_motion_run_frame((const uint8_t*)line + 1, true);
+    }
+    return execute_line(line, client, auth_level);
+}
+
+Error sd_resume_at_line(uint32_t line, uint8_t client) {
+    char  fileLine[255];
+    Error status = Error::Ok;
+    sys.state    = State::CheckMode;
+    while (sd_current_line_number + 1 < line) {
+        if (!readFileLine(fileLine, sizeof(fileLine))) {
+            status = Error::FsFileEmpty;
+            break;
+        }
+        // System commands are not part of the modal state and may act on the machine.
+        if (fileLine[0] == '$' || fileLine[0] == '[') {
+            continue;
+        }
+        status = sd_execute_line(fileLine, client, SD_auth_level);
+        if (status == Error::GcodeUnsupportedCommand) {
+            status = Error::Ok;  // The job does not stop for these either
+        }
+        if (status != Error::Ok || sys.abort) {
+            break;
+        }
+    }
+    sys.state = State::Idle;
+    if (status != Error::Ok) {
+        grbl_msg_sendf(client, MsgLevel::Info, "Cannot resume, line %d failed", sd_current_line_number);
+        return status;
+    }
+
+    // The parser was left where the job would be. Report that, then start from the real position.
+    char  msg[100];
+    char* p      = msg;
+    auto  n_axis = number_axis->get();
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        float wpos = gc_state.position[idx] - gc_state.coord_system[idx] - gc_state.coord_offset[idx];
+        if (idx == TOOL_LENGTH_OFFSET_AXIS) {
+            wpos -= gc_state.tool_length_offset;
+        }
+        p += sprintf(p, " %c%.3f", "XYZABC"[idx], wpos);
+    }
+    grbl_msg_sendf(client, MsgLevel::Info, "Resuming at line %d, job position%s", line, msg);
+    gc_sync_position();
+    system_flag_wco_change();
+    spindle->set_state(gc_state.modal.spindle, gc_state.spindle_speed);
+    coolant_set_state(gc_state.modal.coolant);
+    sd_estimate_start(line);
+    return Error::Ok;
 }
 
 // return a percentage complete 50.5 = 50.5%
 float sd_report_perc_complete() {
-    if (!myFile) {
+    if (!myFile || sd_file_size == 0) {
         return 0.0;
     }
-    return (float)myFile.position() / (float)myFile.size() * 100.0f;
+    if (sd_estimate_valid()) {
+        return sd_estimate_percent(sd_current_line_number);
+    }
+    return (float)sd_consumed / (float)sd_file_size * 100.0f;
 }
 
 uint32_t sd_get_current_line_number() {
@@ -147,14 +747,16 @@ SDState get_sd_state(bool refresh) {
     }
 
     //SD is idle or not detected, let see if still the case
-    SD.end();
+    sd_unmount();
     sd_state = SDState::NotPresent;
-    //using default value for speed ? should be parameter
     //refresh content if card was removed
-    if (SD.begin((GRBL_SPI_SS == -1) ? SS : GRBL_SPI_SS, SPI, GRBL_SPI_FREQ, "/sd", 2)) {
-        if (SD.cardSize() > 0) {
-            sd_state = SDState::Idle;
-        }
+    // A card that will not mount is tried once more one step slower, and that speed is kept if it works.
+    if (sd_mount(sd_slow_down)) {
+        sd_state = SDState::Idle;
+    } else if (sd_slow_down < SD_MAX_SLOW_DOWN && sd_mount(sd_slow_down + 1)) {
+        sd_slow_down++;
+        sd_state = SDState::Idle;
+        grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "SD card mounted at reduced speed");
     }
     return sd_state;
 }
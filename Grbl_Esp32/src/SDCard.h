@@ -18,11 +18,45 @@
 #include "Grbl.h"
 #include <FS.h>
 #include <SD.h>
+#include <SD_MMC.h>
+#include <rom/miniz.h>
 #include <SPI.h>
 
 //#define SDCARD_DET_PIN -1
 const int SDCARD_DET_VAL = 0;  // for now, CD is close to ground
 
+// Files being run are read ahead in blocks of this size by a task on core 0, into two
+// buffers, so lines are split from RAM while the next block is read.
+const size_t SD_READ_BLOCK_SIZE = 4096;
+const int    SD_READ_BUFFERS    = 2;
+
+// Uploads are written behind by a task on core 0, in blocks of this size, a multiple of the
+// card's 512 byte sectors, so the next chunk is received while the last is written.
+const size_t SD_WRITE_BLOCK_SIZE = 8192;
+const int    SD_WRITE_BUFFERS    = 3;
+
+// The web file browser lists a directory on every refresh. The last directory listed is kept
+// in RAM and listed again from there while the card's used space is unchanged and nothing has
+// been written or removed through Grbl. Directories larger than this are walked every time.
+const int    SD_DIR_INDEX_ENTRIES = 2048;
+const size_t SD_DIR_INDEX_NAMES   = 32768;  // Bytes of names, each zero-terminated
+
+// Files ending in .gz are inflated as they are read, taking this much compressed data at a time.
+const size_t SD_GZ_INPUT_SIZE = 1024;
+
+// The card can be on the SPI bus, or on the SDMMC peripheral with its fixed pins, in 1-bit
+// mode on CLK, CMD and D0 or in 4-bit mode, which also takes D1 to D3.
+enum class SDBus : int8_t {
+    SPI     = 0,
+    Mmc1Bit = 1,
+    Mmc4Bit = 2,
+};
+
+// After read errors the card is remounted at half the SPI clock, or in 1-bit mode on SDMMC,
+// at most SD_MAX_SLOW_DOWN times and not below SD_MIN_SPI_FREQ.
+const int      SD_MAX_SLOW_DOWN = 4;
+const uint32_t SD_MIN_SPI_FREQ  = 400000;
+
 enum class SDState : uint8_t {
     Idle          = 0,
     NotPresent    = 1,
@@ -38,12 +72,44 @@ extern WebUI::AuthenticationLevel SD_auth_level;
 
 //bool sd_mount();
 SDState  get_sd_state(bool refresh);
+fs::FS&  sd_fs();  // The card, on whichever bus it was mounted
+uint64_t sd_total_bytes();
+uint64_t sd_used_bytes();
+void     sd_unmount();
+void     sd_reset_bus();    // Goes back to the configured bus speed when the settings change
+bool     sd_read_failed();  // The last file ended early because of a read error
 SDState  set_sd_state(SDState state);
 void     listDir(fs::FS& fs, const char* dirname, uint8_t levels, uint8_t client);
-boolean  openFile(fs::FS& fs, const char* path);
+boolean  openFile(fs::FS& fs, const char* path, bool compiled = false);  // compiled for copies made by SDCache
+bool     sd_is_compressed(const char* path);
 boolean  closeFile();
+
+// Opens path in place of the file that just ended, staying mounted and busy, so the motion
+// still in the planner runs on into the new job. On failure the card is left idle.
+boolean sd_chain_file(const char* path);
 boolean  readFileLine(char* line, int len);
+Error    sd_execute_line(char* line, uint8_t client, WebUI::AuthenticationLevel auth_level);  // Also runs binary frames
+
+// Brings the modes, offsets, tool, spindle and coolant to what they are at line of the open file,
+// by running the lines before it in check mode, so nothing moves. The next line read is line.
+// Called while idle.
+Error sd_resume_at_line(uint32_t line, uint8_t client);
 void     readFile(fs::FS& fs, const char* path);
-float    sd_report_perc_complete();
+
+// Number of entries in the directory at path, from the index, or -1 if it could not be indexed.
+// The index holds until sd_dir_index_invalidate(), called after anything is written or removed.
+int         sd_dir_index(const char* path);
+const char* sd_dir_index_name(int i);
+uint32_t    sd_dir_index_size(int i);
+bool        sd_dir_index_is_dir(int i);
+void        sd_dir_index_invalidate();
+
+// Write-behind for file, which must stay open until sd_write_end(). sd_write() returns false
+// once a write has failed, and sd_write_end() returns whether all of them succeeded.
+bool sd_write_begin(File& file);
+bool sd_write(const uint8_t* data, size_t length);
+bool sd_write_end();
+
+float    sd_report_perc_complete();  // By estimated time if the job was scanned, else by bytes
 uint32_t sd_get_current_line_number();
 void     sd_get_current_filename(char* name);
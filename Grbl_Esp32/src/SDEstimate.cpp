@@ -0,0 +1,397 @@
+/*
+  SDEstimate.cpp - Run time estimates for SD card jobs
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The scan follows the moves of the file from the current position and modes, without the
+  planner, and adds up the time of each at its feed rate, or at the axis rate limits for rapids
+  and moves the limits slow down. Dwells are counted, acceleration is not, and moves the scan
+  cannot follow, like canned cycles, probes, G28/G30, G10 and anything with parameters or
+  expressions, count as no time.
+
+  The running total is sampled every so many lines. When the samples run out, every other one
+  is dropped and the spacing doubles, so the whole file fits in SD_ESTIMATE_POINTS samples
+  however long it is. During the job the time through the current line is interpolated from
+  them, so the progress and ETA in status reports take constant time. The ETA is scaled by
+  the time the job has actually taken against the estimate so far, which makes up for the
+  acceleration the scan leaves out.
+*/
+
+#include "Config.h"
+#ifdef ENABLE_SD_CARD
+#    include "Grbl.h"
+
+static float    estimate_points[SD_ESTIMATE_POINTS];  // Seconds to the end of each span of lines
+static int      estimate_count = 0;                  // Points filled
+static uint32_t estimate_span;                       // Lines per point
+static uint32_t estimate_lines;                      // Lines in the file
+static float    estimate_total = 0.0;                // Seconds for the whole file, 0 for no estimate
+static uint32_t estimate_start_ms;
+static uint32_t estimate_start_line;
+
+static const char axis_letters[] = "XYZABC";
+
+// Length of an arc from start to target in the plane of axis_0 and axis_1, with the center
+// given by the IJK offsets or the radius. Sets center to the center in the plane and sweep to
+// the angle swept, negative clockwise, or 0 if the radius cannot reach and it is taken as a line.
+static float arc_length(const float* start, const float* target, float* offset, float radius, bool use_radius, bool clockwise,
+                        uint8_t axis_0, uint8_t axis_1, float* center, float* sweep) {
+    float x = target[axis_0] - start[axis_0];
+    float y = target[axis_1] - start[axis_1];
+    *sweep  = 0.0;
+    if (use_radius) {
+        // The center is on the perpendicular bisector of the chord, as the parser finds it.
+        float chord = hypot_f(x, y);
+        if (chord == 0.0 || chord > 2 * fabsf(radius)) {
+            return chord;
+        }
+        float h = -sqrtf(4.0 * radius * radius - x * x - y * y) / chord;
+        if (!clockwise) {
+            h = -h;
+        }
+        if (radius < 0) {
+            h = -h;  // Negative R is the long way round
+        }
+        offset[axis_0] = 0.5 * (x - (y * h));
+        offset[axis_1] = 0.5 * (y + (x * h));
+    }
+    radius    = hypot_f(offset[axis_0], offset[axis_1]);
+    float a0  = atan2f(-offset[axis_1], -offset[axis_0]);
+    float a1  = atan2f(y - offset[axis_1], x - offset[axis_0]);
+    float arc = a1 - a0;
+    if (clockwise) {
+        if (arc >= 0) {
+            arc -= 2 * M_PI;
+        }
+    } else if (arc <= 0) {
+        arc += 2 * M_PI;
+    }
+    center[0] = start[axis_0] + offset[axis_0];
+    center[1] = start[axis_1] + offset[axis_1];
+    *sweep    = arc;
+    return radius * fabsf(arc);
+}
+
+void sd_scan_begin(sd_scan_t* st, bool from_parser) {
+    memset(st, 0, sizeof(*st));
+    if (!from_parser) {
+        st->motion   = 0;  // Power up modes at the work origin
+        st->plane    = Plane::XY;
+        st->absolute = true;
+        return;
+    }
+    for (uint8_t idx = 0; idx < MAX_N_AXIS; idx++) {
+        st->position[idx] = gc_state.position[idx] - gc_state.coord_system[idx] - gc_state.coord_offset[idx];
+    }
+    st->motion       = gc_state.modal.motion <= Motion::CcwArc ? int8_t(gc_state.modal.motion) : -1;
+    st->plane        = gc_state.modal.plane_select;
+    st->inches       = gc_state.modal.units == Units::Inches;
+    st->absolute     = gc_state.modal.distance == Distance::Absolute;
+    st->inverse_time = gc_state.modal.feed_rate == FeedRate::InverseTime;
+    st->feed         = gc_state.feed_rate;
+}
+
+float sd_scan_line(sd_scan_t* st, const char* line) {
+    st->moved     = false;
+    st->arc_sweep = 0.0;
+    char words[LINE_BUFFER_SIZE];
+    sd_cache_strip(line, words, sizeof(words));
+    if (words[0] == '\0' || words[0] == '$' || strpbrk(words, "#[")) {
+        return 0.0;
+    }
+
+    auto    n_axis = number_axis->get();
+    float   values[MAX_N_AXIS];
+    float   offset[3] = {};
+    uint8_t axis_words = 0;
+    bool    has_feed   = false;
+    bool    use_radius = false;
+    bool    skip_move  = false;  // Moves the scan does not follow
+    bool    set_origin = false;  // G92
+    float   feed       = 0.0;
+    float   radius     = 0.0;
+    float   dwell      = 0.0;
+    bool    is_dwell   = false;
+    uint8_t counter    = 0;
+    while (words[counter]) {
+        char  letter = words[counter++];
+        float value;
+        if (letter < 'A' || letter > 'Z' || !read_float(words, &counter, &value)) {
+            return 0.0;
+        }
+        int         code = int(value);
+        const char* axis = strchr(axis_letters, letter);
+        if (axis && axis - axis_letters < n_axis) {
+            axis_words |= bit(axis - axis_letters);
+            values[axis - axis_letters] = value;
+            continue;
+        }
+        switch (letter) {
+            case 'G':
+                if (value != code) {
+                    skip_move |= code == 38;  // Probes
+                    break;
+                }
+                switch (code) {
+                    case 0:
+                    case 1:
+                    case 2:
+                    case 3:
+                        st->motion = code;
+                        break;
+                    case 4:
+                        is_dwell = true;
+                        break;
+                    case 17:
+                        st->plane = Plane::XY;
+                        break;
+                    case 18:
+                        st->plane = Plane::ZX;
+                        break;
+                    case 19:
+                        st->plane = Plane::YZ;
+                        break;
+                    case 20:
+                    case 21:
+                        st->inches = code == 20;
+                        break;
+                    case 10:
+                    case 28:
+                    case 30:
+                        skip_move = true;
+                        break;
+                    case 90:
+                    case 91:
+                        st->absolute = code == 90;
+                        break;
+                    case 92:
+                        set_origin = true;
+                        break;
+                    case 93:
+                    case 94:
+                        st->inverse_time = code == 93;
+                        break;
+                    case 73:
+                    case 80:
+                    case 81:
+                    case 82:
+                    case 83:
+                    case 84:
+                    case 85:
+                    case 86:
+                    case 87:
+                    case 88:
+                    case 89:
+                        st->motion = -1;
+                        break;
+                }
+                break;
+            case 'F':
+                has_feed = true;
+                feed     = value;
+                break;
+            case 'I':
+            case 'J':
+            case 'K':
+                offset[letter - 'I'] = value;
+                break;
+            case 'R':
+                use_radius = true;
+                radius     = value;
+                break;
+            case 'P':
+                dwell = value;
+                break;
+        }
+    }
+
+    float scale = st->inches ? MM_PER_INCH : 1.0;
+    if (has_feed && !st->inverse_time) {
+        st->feed = feed * scale;
+    }
+    if (is_dwell) {
+        return dwell;
+    }
+    if (set_origin) {
+        // The position stays where it is in machine terms, so it becomes the given values.
+        for (uint8_t idx = 0; idx < n_axis; idx++) {
+            if (bit_istrue(axis_words, bit(idx))) {
+                st->position[idx] = values[idx] * scale;
+            }
+        }
+        return 0.0;
+    }
+    if (skip_move || !axis_words || st->motion < 0) {
+        return 0.0;
+    }
+
+    float target[MAX_N_AXIS];
+    float limit_time = 0.0;  // Minutes at the axis rate limits
+    float distance   = 0.0;
+    for (uint8_t idx = 0; idx < n_axis; idx++) {
+        target[idx] = st->position[idx];
+        if (bit_istrue(axis_words, bit(idx))) {
+            target[idx] = (st->absolute ? 0.0 : target[idx]) + values[idx] * scale;
+        }
+        float delta = target[idx] - st->position[idx];
+        distance += delta * delta;
+        limit_time = MAX(limit_time, fabsf(delta) / axis_settings[idx]->max_rate->get());
+    }
+    distance = sqrtf(distance);
+    if (st->motion >= 2) {
+        uint8_t axis_0, axis_1, axis_linear;
+        switch (st->plane) {
+            case Plane::XY:
+                axis_0      = X_AXIS;
+                axis_1      = Y_AXIS;
+                axis_linear = Z_AXIS;
+                break;
+            case Plane::ZX:
+                axis_0      = Z_AXIS;
+                axis_1      = X_AXIS;
+                axis_linear = Y_AXIS;
+                break;
+            default:  // case Plane::YZ:
+                axis_0      = Y_AXIS;
+                axis_1      = Z_AXIS;
+                axis_linear = X_AXIS;
+        }
+        for (int i = 0; i < 3; i++) {
+            offset[i] *= scale;
+        }
+        float arc = arc_length(
+            st->position, target, offset, radius * scale, use_radius, st->motion == 2, axis_0, axis_1, st->arc_center, &st->arc_sweep);
+        distance            = hypot_f(arc, target[axis_linear] - st->position[axis_linear]);
+        st->arc_axis_0      = axis_0;
+        st->arc_axis_1      = axis_1;
+        st->arc_axis_linear = axis_linear;
+    }
+    memcpy(st->position, target, sizeof(target));
+    st->moved = true;
+
+    float minutes = limit_time;
+    if (st->motion != 0) {
+        if (st->inverse_time) {
+            minutes = MAX(minutes, has_feed && feed > 0.0 ? 1.0 / feed : 0.0);
+        } else if (st->feed > 0.0) {
+            minutes = MAX(minutes, distance / st->feed);
+        }
+    }
+    return minutes * 60.0;
+}
+
+static void add_point(uint32_t line, float total) {
+    if (line % estimate_span) {
+        return;
+    }
+    if (estimate_count == SD_ESTIMATE_POINTS) {
+        for (int i = 0; i < SD_ESTIMATE_POINTS / 2; i++) {
+            estimate_points[i] = estimate_points[2 * i + 1];
+        }
+        estimate_count = SD_ESTIMATE_POINTS / 2;
+        estimate_span *= 2;
+        if (line % estimate_span) {
+            return;
+        }
+    }
+    estimate_points[estimate_count++] = total;
+}
+
+Error sd_estimate_scan(fs::FS& fs, const char* path, uint8_t client) {
+    sd_estimate_clear();
+    File     source = fs.open(path);
+    uint8_t* block  = (uint8_t*)heap_alloc_large(HeapTag::SD, SD_READ_BLOCK_SIZE);
+    if (!source || !block) {
+        heap_free(HeapTag::SD, block, SD_READ_BLOCK_SIZE);
+        return Error::FsFailedRead;
+    }
+
+    sd_scan_t st;
+    sd_scan_begin(&st, true);
+
+    char     line[255];
+    size_t   len   = 0;
+    uint32_t lines = 0;
+    float    total = 0.0;
+    estimate_span  = 1;
+    int count;
+    while ((count = source.read(block, SD_READ_BLOCK_SIZE)) > 0) {
+        for (int i = 0; i < count; i++) {
+            if (block[i] != '\n') {
+                if (len < sizeof(line) - 1) {
+                    line[len++] = block[i];
+                }
+                continue;
+            }
+            line[len] = '\0';
+            total += sd_scan_line(&st, line);
+            add_point(++lines, total);
+            len = 0;
+        }
+    }
+    if (len) {
+        line[len] = '\0';
+        total += sd_scan_line(&st, line);
+        add_point(++lines, total);
+    }
+    heap_free(HeapTag::SD, block, SD_READ_BLOCK_SIZE);
+    source.close();
+
+    estimate_lines = lines;
+    estimate_total = total;
+    uint32_t seconds = total;
+    grbl_msg_sendf(client, MsgLevel::Info, "Estimated run time %d:%02d:%02d", seconds / 3600, seconds / 60 % 60, seconds % 60);
+    return Error::Ok;
+}
+
+void sd_estimate_start(uint32_t line) {
+    estimate_start_ms   = millis();
+    estimate_start_line = line;
+}
+
+void sd_estimate_clear() {
+    estimate_total = 0.0;
+    estimate_count = 0;
+}
+
+bool sd_estimate_valid() {
+    return estimate_total > 0.0;
+}
+
+// Estimated seconds for the lines before line.
+static float estimate_through(uint32_t line) {
+    line          = line ? MIN(line - 1, estimate_lines) : 0;
+    uint32_t span = line / estimate_span;  // Points passed
+    float    from = span ? estimate_points[MIN(span, uint32_t(estimate_count)) - 1] : 0.0;
+    if (span >= uint32_t(estimate_count)) {
+        // Past the last point, spread the rest evenly over the remaining lines.
+        uint32_t first = estimate_count * estimate_span;
+        return estimate_lines > first ? from + (estimate_total - from) * (line - first) / (estimate_lines - first) : estimate_total;
+    }
+    return from + (estimate_points[span] - from) * (line - span * estimate_span) / estimate_span;
+}
+
+float sd_estimate_percent(uint32_t line) {
+    return estimate_through(line) / estimate_total * 100.0f;
+}
+
+uint32_t sd_estimate_remaining(uint32_t line) {
+    float done  = estimate_through(line);
+    float run   = done - estimate_through(estimate_start_line);  // Since the job started or resumed
+    float scale = 1.0;
+    if (run > 10.0) {
+        scale = constrain((millis() - estimate_start_ms) / 1000.0f / run, 0.25f, 4.0f);
+    }
+    return (estimate_total - done) * scale;
+}
+#endif
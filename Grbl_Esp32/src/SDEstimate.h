@@ -0,0 +1,69 @@
+#pragma once
+
+/*
+  SDEstimate.h - Run time estimates for SD card jobs
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Error.h"
+
+#include <FS.h>
+#include <cstdint>
+
+// The estimated time through the file is kept at this many points, spread evenly over its lines.
+const int SD_ESTIMATE_POINTS = 128;
+
+// Where the moves of a file have taken the machine, followed a line at a time without the
+// planner. Also used by the upload preview, see SDPreview.h.
+typedef struct {
+    float  position[MAX_N_AXIS];  // Work coordinates, mm
+    int8_t motion;                // 0 to 3 for G0 to G3, -1 for moves that are not followed
+    Plane  plane;
+    bool   inches;
+    bool   absolute;
+    bool   inverse_time;
+    float  feed;  // mm/min
+
+    // Of the last line
+    bool    moved;          // Along a path to position, not set there by G92
+    float   arc_center[2];  // On arc_axis_0 and arc_axis_1
+    float   arc_sweep;      // Radians, negative clockwise, 0 when it was not an arc
+    uint8_t arc_axis_0;
+    uint8_t arc_axis_1;
+    uint8_t arc_axis_linear;
+} sd_scan_t;
+
+// Starts from the parser's position and modes, or with from_parser false from the power up
+// modes at the work origin.
+void sd_scan_begin(sd_scan_t* st, bool from_parser);
+
+// Seconds the line takes to run. Updates the position and modes.
+float sd_scan_line(sd_scan_t* st, const char* line);
+
+// Reads the whole file and estimates how long it takes to run, for the job about to start.
+Error sd_estimate_scan(fs::FS& fs, const char* path, uint8_t client);
+
+// Called when the job starts, at line when it resumes part way through, and when it ends.
+void sd_estimate_start(uint32_t line);
+void sd_estimate_clear();
+
+// True if the running job was scanned.
+bool sd_estimate_valid();
+
+// Share of the estimated run time, in percent, used up by the lines before line.
+float sd_estimate_percent(uint32_t line);
+
+// Seconds left from line to the end of the file, corrected by how the job has kept to the
+// estimate so far.
+uint32_t sd_estimate_remaining(uint32_t line);
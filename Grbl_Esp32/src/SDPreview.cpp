@@ -0,0 +1,243 @@
+/*
+  SDPreview.cpp - Toolpath previews of SD files, made while they are uploaded
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The upload is followed with the run time scan, so a preview covers the same moves as the
+  estimate, from the power up modes at the work origin. Arcs are split into chords no longer
+  than the tolerance allows.
+
+  A point is kept when it is the tolerance or more from the last kept one, or when the move
+  to it is of another kind than the move to the last. When the points run out the tolerance
+  doubles and the kept points are thinned by the same rule, so a file of any length ends up
+  within SD_PREVIEW_POINTS points, as the estimate keeps its samples.
+*/
+
+#include "Config.h"
+#ifdef ENABLE_SD_CARD
+#    include "Grbl.h"
+
+typedef struct {
+    float position[3];
+    bool  rapid;
+} preview_point_t;
+
+static preview_point_t* preview_points = NULL;  // Allocated while an upload is previewed
+static int              preview_count;
+static preview_point_t  preview_pending;  // The last position, when it was not kept
+static bool             preview_has_pending;
+static float            preview_tolerance;
+static uint8_t          preview_flags;
+static float            preview_min[3];
+static float            preview_max[3];
+static sd_scan_t        preview_scan;
+static float            preview_seconds;
+static uint32_t         preview_lines;
+static uint32_t         preview_size;
+static String           preview_path;
+static char             preview_line[255];
+static size_t           preview_len;
+
+static float preview_distance(const float* a, const float* b) {
+    float x = a[0] - b[0];
+    float y = a[1] - b[1];
+    float z = a[2] - b[2];
+    return sqrtf(x * x + y * y + z * z);
+}
+
+static void preview_thin() {
+    preview_tolerance *= 2;
+    int kept = 1;
+    for (int i = 1; i < preview_count; i++) {
+        preview_point_t& last     = preview_points[kept - 1];
+        preview_point_t& point    = preview_points[i];
+        bool             boundary = i + 1 == preview_count || preview_points[i + 1].rapid != point.rapid;
+        if (boundary || point.rapid != last.rapid || preview_distance(point.position, last.position) >= preview_tolerance) {
+            preview_points[kept++] = point;
+        }
+    }
+    preview_count = kept;
+}
+
+static void preview_keep(const preview_point_t& point) {
+    if (preview_count == SD_PREVIEW_POINTS) {
+        // Points at the ends of each run of one kind are always kept, so once the tolerance
+        // is past the whole span nothing more can be thinned.
+        float span = MAX(preview_distance(preview_min, preview_max), SD_PREVIEW_TOLERANCE);
+        while (preview_count == SD_PREVIEW_POINTS && preview_tolerance <= 2 * span) {
+            preview_thin();
+        }
+        if (preview_count == SD_PREVIEW_POINTS) {
+            preview_flags |= SD_PREVIEW_TRUNCATED;
+            return;
+        }
+    }
+    preview_points[preview_count++] = point;
+}
+
+static void preview_add(const float* position, bool rapid) {
+    for (int i = 0; i < 3; i++) {
+        preview_min[i] = MIN(preview_min[i], position[i]);
+        preview_max[i] = MAX(preview_max[i], position[i]);
+    }
+    preview_point_t point = { { position[0], position[1], position[2] }, rapid };
+    if (preview_count) {
+        if (preview_has_pending && preview_pending.rapid != rapid) {
+            preview_keep(preview_pending);  // The end of the run of the other kind
+        }
+        preview_point_t& last = preview_points[preview_count - 1];
+        if (last.rapid == rapid && preview_distance(position, last.position) < preview_tolerance) {
+            preview_pending     = point;
+            preview_has_pending = true;
+            return;
+        }
+    }
+    preview_has_pending = false;
+    preview_keep(point);
+}
+
+static void preview_follow(const char* line) {
+    float from[MAX_N_AXIS];
+    memcpy(from, preview_scan.position, sizeof(from));
+    preview_seconds += sd_scan_line(&preview_scan, line);
+    preview_lines++;
+    float* to = preview_scan.position;
+    if (memcmp(from, to, sizeof(from)) == 0) {
+        return;
+    }
+    bool rapid = !preview_scan.moved || preview_scan.motion == 0;
+    if (preview_scan.arc_sweep != 0.0) {
+        uint8_t axis_0   = preview_scan.arc_axis_0;
+        uint8_t axis_1   = preview_scan.arc_axis_1;
+        uint8_t linear   = preview_scan.arc_axis_linear;
+        float*  center   = preview_scan.arc_center;
+        float   radius   = hypot_f(from[axis_0] - center[0], from[axis_1] - center[1]);
+        float   angle    = atan2f(from[axis_1] - center[1], from[axis_0] - center[0]);
+        float   sweep    = preview_scan.arc_sweep;
+        float   step     = radius > preview_tolerance ? 2 * acosf(1 - preview_tolerance / radius) : M_PI;  // Chord angle
+        int     segments = constrain(int(fabsf(sweep) / step) + 1, 1, 64);
+        float   point[MAX_N_AXIS];
+        memcpy(point, from, sizeof(point));
+        for (int i = 1; i < segments; i++) {
+            float a       = angle + sweep * i / segments;
+            point[axis_0] = center[0] + radius * cosf(a);
+            point[axis_1] = center[1] + radius * sinf(a);
+            point[linear] = from[linear] + (to[linear] - from[linear]) * i / segments;
+            preview_add(point, false);
+        }
+    }
+    preview_add(to, rapid);
+}
+
+void sd_preview_begin(const char* path) {
+    sd_preview_end(false);
+    preview_path = String(path) + SD_PREVIEW_EXTENSION;
+    if (sd_fs().exists(preview_path)) {
+        sd_fs().remove(preview_path);
+    }
+    if (!sd_preview->get() || sd_is_compressed(path)) {
+        return;
+    }
+    preview_points = (preview_point_t*)heap_alloc_large(HeapTag::SD, SD_PREVIEW_POINTS * sizeof(preview_point_t));
+    if (!preview_points) {
+        return;
+    }
+    sd_scan_begin(&preview_scan, false);
+    preview_count       = 0;
+    preview_has_pending = false;
+    preview_tolerance   = SD_PREVIEW_TOLERANCE;
+    preview_flags       = 0;
+    preview_seconds     = 0.0;
+    preview_lines       = 0;
+    preview_size        = 0;
+    preview_len         = 0;
+    for (int i = 0; i < 3; i++) {
+        preview_min[i] = preview_max[i] = preview_scan.position[i];
+    }
+    preview_add(preview_scan.position, true);
+}
+
+void sd_preview_feed(const uint8_t* data, size_t length) {
+    if (!preview_points) {
+        return;
+    }
+    preview_size += length;
+    for (size_t i = 0; i < length; i++) {
+        if (data[i] != '\n') {
+            if (preview_len < sizeof(preview_line) - 1) {
+                preview_line[preview_len++] = data[i];
+            }
+            continue;
+        }
+        preview_line[preview_len] = '\0';
+        preview_follow(preview_line);
+        preview_len = 0;
+    }
+}
+
+static uint16_t preview_scale(float value, int axis) {
+    float range = preview_max[axis] - preview_min[axis];
+    return range > 0.0 ? uint16_t((value - preview_min[axis]) / range * UINT16_MAX + 0.5) : 0;
+}
+
+void sd_preview_end(bool ok) {
+    if (!preview_points) {
+        return;
+    }
+    if (ok) {
+        if (preview_len) {
+            preview_line[preview_len] = '\0';
+            preview_follow(preview_line);
+            preview_len = 0;
+        }
+        if (preview_has_pending) {
+            preview_keep(preview_pending);
+            preview_has_pending = false;
+        }
+        SDPreviewHeader header = {};
+        memcpy(header.magic, "GPVW", sizeof(header.magic));
+        header.version     = 1;
+        header.point_size  = sizeof(SDPreviewPoint);
+        header.flags       = preview_flags;
+        header.points      = preview_count;
+        header.source_size = preview_size;
+        header.lines       = preview_lines;
+        header.seconds     = preview_seconds;
+        header.tolerance   = preview_tolerance;
+        memcpy(header.min, preview_min, sizeof(header.min));
+        memcpy(header.max, preview_max, sizeof(header.max));
+        File file    = sd_fs().open(preview_path, FILE_WRITE);
+        bool written = file && file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header);
+        for (int i = 0; written && i < preview_count;) {
+            SDPreviewPoint points[64];
+            int            n = 0;
+            for (; n < 64 && i < preview_count; n++, i++) {
+                for (int axis = 0; axis < 3; axis++) {
+                    points[n].position[axis] = preview_scale(preview_points[i].position[axis], axis);
+                }
+                points[n].rapid = preview_points[i].rapid;
+            }
+            written = file.write((const uint8_t*)points, n * sizeof(SDPreviewPoint)) == n * sizeof(SDPreviewPoint);
+        }
+        if (file) {
+            file.close();
+        }
+        if (!written) {
+            sd_fs().remove(preview_path);
+            grbl_sendf(CLIENT_ALL, "[MSG:Preview not written]\r\n");
+        }
+    }
+    heap_free(HeapTag::SD, preview_points, SD_PREVIEW_POINTS * sizeof(preview_point_t));
+    preview_points = NULL;
+}
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+
+/*
+  SDPreview.h - Toolpath previews of SD files, made while they are uploaded
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+// The preview of a file is its path with this added, and is fetched as any SD file is, from
+// /SD/<path>.pvw.
+const char* const SD_PREVIEW_EXTENSION = ".pvw";
+
+// Most points in a preview. The polyline is thinned to fit, however long the file.
+const int SD_PREVIEW_POINTS = 1024;
+
+// Starting distance in mm the polyline may stray from the moves. It doubles each time the
+// points run out.
+const float SD_PREVIEW_TOLERANCE = 0.05;
+
+const uint8_t SD_PREVIEW_TRUNCATED = bit(0);  // The points ran out before the end of the file
+
+// The file is this header, then the points, little endian.
+struct __attribute__((packed)) SDPreviewHeader {
+    char     magic[4];    // "GPVW"
+    uint8_t  version;     // 1
+    uint8_t  point_size;  // sizeof(SDPreviewPoint), so older readers can skip new fields
+    uint8_t  flags;       // SD_PREVIEW_TRUNCATED
+    uint8_t  reserved;    // 0
+    uint16_t points;
+    uint32_t source_size;  // Bytes in the file it was made from, to tell when it is stale
+    uint32_t lines;
+    float    seconds;    // Estimated run time, worked out as for $SD/EstimateTime
+    float    tolerance;  // mm the polyline may stray from the moves
+    float    min[3];     // Bounding box of the moves in work coordinates, mm, X Y Z
+    float    max[3];
+};
+
+struct __attribute__((packed)) SDPreviewPoint {
+    uint16_t position[3];  // X Y Z, 0 at min to 65535 at max
+    uint8_t  rapid;        // 1 if the move to this point is a rapid, or a jump made by G92
+};
+
+// Called as an upload to the card starts, with the card mounted. Removes the old preview of
+// path, and starts a new one if $SD/Preview is on and the file is not compressed.
+void sd_preview_begin(const char* path);
+
+// Follows the moves in the next part of the upload.
+void sd_preview_feed(const uint8_t* data, size_t length);
+
+// Writes the preview beside the file, if ok and the upload was previewed, and frees the points.
+void sd_preview_end(bool ok);
@@ -0,0 +1,117 @@
+/*
+  SDQueue.cpp - Queue of SD card jobs run one after another
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  When a job ends without error, the protocol loop takes the next path from the queue and
+  SDCard opens it in place of the last one, so the planner runs on from one file into the
+  next. A job that fails or is stopped leaves the rest of the queue alone.
+*/
+
+#include "Config.h"
+#ifdef ENABLE_SD_CARD
+#    include "Grbl.h"
+#    include "LocalFS.h"
+
+static String queue[SD_QUEUE_MAX];
+static int    queue_count  = 0;
+static bool   queue_loaded = false;
+
+static bool queue_mount() {
+    return localfs_mount();
+}
+
+static void queue_load() {
+    if (queue_loaded) {
+        return;
+    }
+    queue_loaded = true;
+    queue_count  = 0;
+    if (!queue_mount() || !LocalFS.exists(SD_QUEUE_FILE)) {
+        return;
+    }
+    File file = LocalFS.open(SD_QUEUE_FILE, FILE_READ);
+    while (file.available() && queue_count < SD_QUEUE_MAX) {
+        String path = file.readStringUntil('\n');
+        path.trim();
+        if (path.length()) {
+            queue[queue_count++] = path;
+        }
+    }
+    file.close();
+}
+
+static void queue_save() {
+    if (!queue_mount()) {
+        return;
+    }
+    if (queue_count == 0) {
+        LocalFS.remove(SD_QUEUE_FILE);
+        return;
+    }
+    File file = LocalFS.open(SD_QUEUE_FILE, FILE_WRITE);
+    if (file) {
+        for (int i = 0; i < queue_count; i++) {
+            file.print(queue[i]);
+            file.print('\n');
+        }
+        file.close();
+    }
+}
+
+bool sd_queue_add(const char* path) {
+    queue_load();
+    if (queue_count == SD_QUEUE_MAX) {
+        return false;
+    }
+    queue[queue_count] = path;
+    if (path[0] != '/') {
+        queue[queue_count] = "/" + queue[queue_count];
+    }
+    queue_count++;
+    queue_save();
+    return true;
+}
+
+bool sd_queue_pop(String& path) {
+    queue_load();
+    if (queue_count == 0) {
+        return false;
+    }
+    path = queue[0];
+    for (int i = 1; i < queue_count; i++) {
+        queue[i - 1] = queue[i];
+    }
+    queue[--queue_count] = "";
+    queue_save();
+    return true;
+}
+
+void sd_queue_clear() {
+    queue_load();
+    for (int i = 0; i < queue_count; i++) {
+        queue[i] = "";
+    }
+    queue_count = 0;
+    queue_save();
+}
+
+int sd_queue_count() {
+    queue_load();
+    return queue_count;
+}
+
+const char* sd_queue_path(int i) {
+    return queue[i].c_str();
+}
+#endif
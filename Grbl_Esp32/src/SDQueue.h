@@ -0,0 +1,30 @@
+#pragma once
+
+/*
+  SDQueue.h - Queue of SD card jobs run one after another
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <WString.h>
+#include <cstdint>
+
+// The queue is kept in SPIFFS, one path per line, so it survives a restart.
+const char* const SD_QUEUE_FILE = "/sdqueue.txt";
+const int         SD_QUEUE_MAX  = 16;
+
+bool        sd_queue_add(const char* path);  // false if the queue is full
+bool        sd_queue_pop(String& path);      // Takes the first job, false if there is none
+void        sd_queue_clear();
+int         sd_queue_count();
+const char* sd_queue_path(int i);
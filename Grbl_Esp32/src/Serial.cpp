@@ -56,6 +56,9 @@
 */
 
 #include "Grbl.h"
+#if defined(ENABLE_WIFI) && defined(ENABLE_HTTP)
+#    include "WebUI/WebServer.h"
+#endif
 
 // Define this to use the Arduino serial (UART) driver instead
 // of the one in Uart.cpp, which uses the ESP-IDF UART driver.
@@ -63,20 +66,119 @@
 // testing is complete.
 // #define REVERT_TO_ARDUINO_SERIAL
 
-portMUX_TYPE myMutex = portMUX_INITIALIZER_UNLOCKED;
-
 static TaskHandle_t clientCheckTaskHandle = 0;
 
+// Given to wake the client task from its idle sleep.
+static SemaphoreHandle_t client_wake_semaphore = NULL;
+
 WebUI::InputBuffer client_buffer[CLIENT_COUNT];  // create a buffer for each client
 
-// Returns the number of bytes available in a client buffer.
-uint8_t client_get_rx_buffer_available(uint8_t client) {
+// Line buffer sizes, indexed by client.
+static const size_t client_buffer_size[CLIENT_COUNT] = {
+    SERIAL_RX_BUFFER_SIZE,  // CLIENT_SERIAL
+    RX_BUFFER_SIZE,         // CLIENT_BT
+    RX_BUFFER_SIZE,         // CLIENT_WEBUI
+    TELNET_RX_BUFFER_SIZE,  // CLIENT_TELNET
+    RX_BUFFER_SIZE,         // CLIENT_INPUT
+    RX_BUFFER_SIZE,         // CLIENT_WEBSOCKET
+    TELNET_RX_BUFFER_SIZE,  // CLIENT_TCP
+    SERIAL_RX_BUFFER_SIZE,  // CLIENT_USB
+};
+
+// Number of bytes the UART read pulls at a time, the size of the hardware FIFO.
+const size_t UART_RX_CHUNK = 128;
+
+// The UART driver's event queue depth. Its receive events wake the serial receive task.
+const int UART_RX_EVENTS = 20;
+
+// Character times of silence after which the UART hands a partial FIFO to the driver. The
+// IDF default of 10 holds a lone realtime byte back for almost a millisecond at 115200 baud.
+const uint8_t UART_RX_TIMEOUT = 2;
+
+// Receive FIFO fill at which the UART interrupts. Above UART_FAST_BAUD it interrupts earlier,
+// since the 128 byte FIFO leaves only a few microseconds of slack at those rates.
+const uint8_t  UART_RX_FULL      = 120;
+const uint8_t  UART_RX_FULL_FAST = 64;
+const uint32_t UART_FAST_BAUD    = 460800;
+
+// Receive FIFO fill at which RTS pauses the sender, with $Serial/FlowControl on. It is above
+// the interrupt threshold so the sender only pauses when the reader falls behind.
+const uint8_t UART_RTS_THRESHOLD = 100;
+
+// Longest the client task sleeps with nothing to do, so restart requests and stack checks
+// still run.
+const uint32_t CLIENT_IDLE_MS = 100;
+
+// The web server and telnet are polled from the client task, so while WiFi is on it wakes
+// at least this often, and every tick while a telnet session is open.
+const uint32_t CLIENT_NETWORK_POLL_MS = 10;
+
+// Longest line accepted from a client while an SD job runs. Longer ones are rejected.
+const size_t SD_QUERY_LINE_SIZE = 80;
+
+// Bytes serialRxTask is holding back while the serial line buffer is full.
+static volatile size_t serial_rx_held = 0;
+
+#ifdef ENABLE_BLUETOOTH
+// Bluetooth input is read as it arrives, so realtime commands are acted on at once, and the
+// rest is held here while the BT line buffer is full. SerialBT's own queue fills behind it.
+const size_t   BT_RX_HOLD_SIZE = 256;
+static uint8_t bt_rx[BT_RX_HOLD_SIZE];
+static size_t  bt_rx_start = 0;
+static size_t  bt_rx_held  = 0;
+#endif
+
+int client_get_rx_buffer_size(uint8_t client) {
+    return client < CLIENT_COUNT ? client_buffer_size[client] : 0;
+}
+
+int client_get_rx_buffer_available(uint8_t client) {
+    if (client >= CLIENT_COUNT) {
+        return 0;
+    }
+    int pending = client_buffer[client].available();
+    switch (client) {
+        case CLIENT_SERIAL:
 #ifdef REVERT_TO_ARDUINO_SERIAL
-    return 128 - Serial.available();
+            pending += Serial.available();
 #else
-    return 128 - Uart0.available();
+            pending += Uart0.available() + serial_rx_held;
 #endif
-    //    return client_buffer[client].availableforwrite();
+            break;
+#ifdef ENABLE_BLUETOOTH
+        case CLIENT_BT:
+            pending += WebUI::SerialBT.available() + bt_rx_held;
+            break;
+#endif
+#if defined(ENABLE_WIFI) && defined(ENABLE_HTTP) && defined(ENABLE_SERIAL2SOCKET_IN)
+        case CLIENT_WEBUI:
+            pending += WebUI::Serial2Socket.available();
+            break;
+#endif
+#if defined(ENABLE_WIFI) && defined(ENABLE_TELNET)
+        case CLIENT_TELNET:
+            pending += WebUI::telnet_server.available();
+            break;
+#endif
+#if defined(ENABLE_WIFI) && defined(ENABLE_HTTP) && defined(ENABLE_WEBSOCKET_STREAM)
+        case CLIENT_WEBSOCKET:
+            pending += WebUI::SocketStream.available();
+            break;
+#endif
+#if defined(ENABLE_WIFI) && defined(ENABLE_TCP_STREAM)
+        case CLIENT_TCP:
+            pending += WebUI::TcpStream.available();
+            break;
+#endif
+#ifdef ENABLE_USB_CDC
+        case CLIENT_USB:
+            pending += UsbCdc.available();
+            break;
+#endif
+        default:
+            break;
+    }
+    return MAX(client_get_rx_buffer_size(client) - pending, 0);
 }
 
 void heapCheckTask(void* pvParameters) {
@@ -85,7 +187,8 @@ void heapCheckTask(void* pvParameters) {
         uint32_t newHeapSize = xPortGetFreeHeapSize();
         if (newHeapSize != heapSize) {
             heapSize = newHeapSize;
-            grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "heap %d", heapSize);
+            grbl_msg_sendf(
+                CLIENT_SERIAL, MsgLevel::Info, "heap %d largest %d", heapSize, heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
         }
         vTaskDelay(3000 / portTICK_RATE_MS);  // Yield to other tasks
 
@@ -99,7 +202,7 @@ void heapCheckTask(void* pvParameters) {
 void client_init() {
 #ifdef DEBUG_REPORT_HEAP_SIZE
     // For a 2000-word stack, uxTaskGetStackHighWaterMark reports 288 words available
-    xTaskCreatePinnedToCore(heapCheckTask, "heapTask", 2000, NULL, 1, NULL, 1);
+    heap_task_create(heapCheckTask, "heapTask", 2000, NULL, 1, NULL, 1);
 #endif
 
 #ifdef REVERT_TO_ARDUINO_SERIAL
@@ -108,49 +211,76 @@ void client_init() {
     Serial.write("\r\n");  // create some white space after ESP32 boot info
 #else
     Uart0.setPins(1, 3);  // Tx 1, Rx 3 - standard hardware pins
-    Uart0.begin(BAUD_RATE, Uart::Data::Bits8, Uart::Stop::Bits1, Uart::Parity::None);
+    Uart0.begin(BAUD_RATE, Uart::Data::Bits8, Uart::Stop::Bits1, Uart::Parity::None, UART_RX_EVENTS);
+    Uart0.setRxTimeout(UART_RX_TIMEOUT);
+    Uart0.setTxQueue(UART_TX_QUEUE_SIZE);
 
     client_reset_read_buffer(CLIENT_ALL);
     Uart0.write("\r\n");  // create some white space after ESP32 boot info
+#endif
+    for (uint8_t client = 0; client < CLIENT_COUNT; client++) {
+        if (!client_buffer[client].setSize(client_buffer_size[client])) {
+            grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Error, "No memory for a %d byte input buffer", int(client_buffer_size[client]));
+        }
+    }
+    client_wake_semaphore = xSemaphoreCreateBinary();
+#ifdef ENABLE_USB_CDC
+    UsbCdc.begin();
+#endif
+#ifndef REVERT_TO_ARDUINO_SERIAL
+    heap_task_create(serialRxTask,             // task
+                     "serialRxTask",           // name for task
+                     4096,                     // size of task stack
+                     NULL,                     // parameters
+                     SERIAL_RX_TASK_PRIORITY,  // priority
+                     NULL,                     // handle
+                     SUPPORT_TASK_CORE         // core
+    );
 #endif
     clientCheckTaskHandle = 0;
     // create a task to check for incoming data
     // For a 4096-word stack, uxTaskGetStackHighWaterMark reports 244 words available
     // after WebUI attaches.
-    xTaskCreatePinnedToCore(clientCheckTask,    // task
-                            "clientCheckTask",  // name for task
-                            4096,               // size of task stack
-                            NULL,               // parameters
-                            1,                  // priority
-                            &clientCheckTaskHandle,
-                            SUPPORT_TASK_CORE  // must run the task on same core
-                                               // core
+    heap_task_create(clientCheckTask,    // task
+                     "clientCheckTask",  // name for task
+                     4096,               // size of task stack
+                     NULL,               // parameters
+                     1,                  // priority
+                     &clientCheckTaskHandle,
+                     CLIENT_TASK_CORE    // core
     );
 }
 
+void client_apply_serial_settings() {
+#ifndef REVERT_TO_ARDUINO_SERIAL
+    uint32_t baud = serial_baud->get();
+    bool     flow = serial_flow_control->get();
+    if (flow && (SERIAL_RTS_PIN == UNDEFINED_PIN || SERIAL_CTS_PIN == UNDEFINED_PIN)) {
+        grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Error, "Serial flow control needs SERIAL_RTS_PIN and SERIAL_CTS_PIN");
+        flow = false;
+    }
+    if (baud != BAUD_RATE) {
+        grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Serial switching to %d baud", baud);
+        Uart0.flushTxTimed(pdMS_TO_TICKS(100));
+        Uart0.setBaudRate(baud);
+    }
+    Uart0.setRxTimeout(UART_RX_TIMEOUT, baud > UART_FAST_BAUD ? UART_RX_FULL_FAST : UART_RX_FULL);
+    if (flow) {
+        Uart0.setPins(1, 3, SERIAL_RTS_PIN, SERIAL_CTS_PIN);
+        Uart0.setHwFlowControl(true, UART_RTS_THRESHOLD);
+    }
+#endif
+}
+
 static uint8_t getClientChar(uint8_t* data) {
     int res;
 #ifdef REVERT_TO_ARDUINO_SERIAL
     if (client_buffer[CLIENT_SERIAL].availableforwrite() && (res = Serial.read()) != -1) {
-#else
-    if (client_buffer[CLIENT_SERIAL].availableforwrite() && (res = Uart0.read()) != -1) {
-#endif
         *data = res;
         return CLIENT_SERIAL;
     }
-    if (WebUI::inputBuffer.available()) {
-        *data = WebUI::inputBuffer.read();
-        return CLIENT_INPUT;
-    }
-    //currently is wifi or BT but better to prepare both can be live
-#ifdef ENABLE_BLUETOOTH
-    if (WebUI::SerialBT.hasClient()) {
-        if ((res = WebUI::SerialBT.read()) != -1) {
-            *data = res;
-            return CLIENT_BT;
-        }
-    }
 #endif
+    //currently is wifi or BT but better to prepare both can be live
 #if defined(ENABLE_WIFI) && defined(ENABLE_HTTP) && defined(ENABLE_SERIAL2SOCKET_IN)
     if (WebUI::Serial2Socket.available()) {
         *data = WebUI::Serial2Socket.read();
@@ -166,46 +296,256 @@ static uint8_t getClientChar(uint8_t* data) {
     return CLIENT_ALL;
 }
 
+#if defined(ENABLE_SD_CARD)
+// While an SD job runs, lines are collected here and only those that just report, like status
+// and setting queries, go on to the client's buffer. The main loop serves them between the lines
+// of the job.
+typedef struct {
+    char   line[SD_QUERY_LINE_SIZE];
+    size_t len;
+    bool   overflow;
+} query_line_t;
+static query_line_t query_lines[CLIENT_COUNT];
+
+static void client_store_query(uint8_t client, uint8_t data) {
+    query_line_t* q = &query_lines[client];
+    if (data != '\r' && data != '\n') {
+        if (q->len < sizeof(q->line) - 1) {
+            q->line[q->len++] = data;
+        } else {
+            q->overflow = true;
+        }
+        return;
+    }
+    q->line[q->len] = '\0';
+    if (q->len == 0 || (!q->overflow && system_line_is_query(q->line))) {
+        for (size_t i = 0; i < q->len; i++) {
+            client_buffer[client].write(q->line[i]);
+        }
+        client_buffer[client].write(data);
+    } else {
+        grbl_sendf(client, "error %d\r\n", Error::AnotherInterfaceBusy);
+        grbl_msg_sendf(client, MsgLevel::Info, "SD card job running");
+    }
+    q->len      = 0;
+    q->overflow = false;
+}
+
+// Passes on the start of a line that was being collected when the job ended.
+static void client_flush_query(uint8_t client) {
+    query_line_t* q = &query_lines[client];
+    if (q->len && !q->overflow) {
+        for (size_t i = 0; i < q->len; i++) {
+            client_buffer[client].write(q->line[i]);
+        }
+    }
+    q->len      = 0;
+    q->overflow = false;
+}
+#endif  //ENABLE_SD_CARD
+
+// Adds a character that is not a realtime command to the client's buffer
+static void client_store(uint8_t client, uint8_t data) {
+#if defined(ENABLE_SD_CARD)
+    if (get_sd_state(false) >= SDState::Busy) {
+        client_store_query(client, data);
+        return;
+    }
+    client_flush_query(client);
+#endif  //ENABLE_SD_CARD
+    client_buffer[client].write(data);
+}
+
+// Realtime stuff is acted upon, then characters are added to the client's buffer
+static void client_accept(uint8_t client, uint8_t data) {
+    // Pick off realtime command characters directly from the serial stream. These characters are
+    // not passed into the main buffer, but these set system state flag bits for realtime execution.
+    if (!binary_motion_in_frame(client, data) && is_realtime_command(data)) {
+        execute_realtime_command(static_cast<Cmd>(data), client);
+    } else {
+        client_store(client, data);
+    }
+}
+
+size_t client_pick_realtime(uint8_t client, uint8_t* data, size_t length) {
+    size_t kept = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (!binary_motion_in_frame(client, data[i]) && is_realtime_command(data[i])) {
+            execute_realtime_command(static_cast<Cmd>(data[i]), client);
+        } else {
+            data[kept++] = data[i];
+        }
+    }
+    return kept;
+}
+
+size_t client_store_bytes(uint8_t client, const uint8_t* data, size_t length) {
+    size_t taken = 0;
+    while (taken < length && client_buffer[client].availableforwrite()) {
+        client_store(client, data[taken++]);
+    }
+    return taken;
+}
+
+#ifdef ENABLE_BLUETOOTH
+// Called from the client task, which SerialBT wakes when data arrives.
+static void bt_rx_poll() {
+    if (!WebUI::SerialBT.hasClient()) {
+        bt_rx_start = 0;
+        bt_rx_held  = 0;
+        return;
+    }
+    int res;
+    while (bt_rx_held < BT_RX_HOLD_SIZE && (res = WebUI::SerialBT.read()) != -1) {
+        uint8_t c = res;
+        if (!binary_motion_in_frame(CLIENT_BT, c) && is_realtime_command(c)) {
+            execute_realtime_command(static_cast<Cmd>(c), CLIENT_BT);
+        } else {
+            bt_rx[(bt_rx_start + bt_rx_held++) % BT_RX_HOLD_SIZE] = c;
+        }
+    }
+    while (bt_rx_held && client_buffer[CLIENT_BT].availableforwrite()) {
+        client_store(CLIENT_BT, bt_rx[bt_rx_start]);
+        bt_rx_start = (bt_rx_start + 1) % BT_RX_HOLD_SIZE;
+        bt_rx_held--;
+    }
+}
+#endif
+
+#ifndef REVERT_TO_ARDUINO_SERIAL
+// Reads the serial port as soon as the UART reports data. Realtime commands are acted on as
+// they are read; the other bytes are held here while the serial line buffer is full, so a
+// feed hold is not stuck behind them. Only this task writes the serial line buffer.
+void serialRxTask(void* pvParameters) {
+    static uint8_t rx[UART_RX_CHUNK];
+    static uint8_t held[UART_RX_CHUNK];
+    size_t         held_start = 0;
+    while (true) {
+        size_t length = MIN(size_t(Uart0.available()), UART_RX_CHUNK - serial_rx_held);
+        if (length) {
+            length = Uart0.readBytes(rx, length, 0);
+        }
+        for (size_t i = 0; i < length; i++) {
+            if (!binary_motion_in_frame(CLIENT_SERIAL, rx[i]) && is_realtime_command(rx[i])) {
+                execute_realtime_command(static_cast<Cmd>(rx[i]), CLIENT_SERIAL);
+            } else {
+                held[(held_start + serial_rx_held++) % UART_RX_CHUNK] = rx[i];
+            }
+        }
+        while (serial_rx_held && client_buffer[CLIENT_SERIAL].availableforwrite()) {
+            client_store(CLIENT_SERIAL, held[held_start]);
+            held_start = (held_start + 1) % UART_RX_CHUNK;
+            serial_rx_held--;
+        }
+        if (length == 0) {
+            // Wait for the receive interrupt, or for the protocol loop to make room.
+            uart_event_t event;
+            xQueueReceive(Uart0.rxEvents(), &event, serial_rx_held ? 1 : portMAX_DELAY);
+        }
+    }
+}
+#endif
+
+void client_wake() {
+    if (client_wake_semaphore != NULL) {
+        xSemaphoreGive(client_wake_semaphore);
+    }
+}
+
+#ifndef REVERT_TO_ARDUINO_SERIAL
+// Milliseconds the client task can sleep before something it polls needs it again.
+static uint32_t client_idle_ms(uint32_t report_wait) {
+    // Input left over while its line buffer is full, and queued output, are picked up next tick.
+    if (Uart0.txPending()) {
+        return 1;
+    }
+    uint32_t wait = MIN(report_wait, CLIENT_IDLE_MS);
+#    ifdef ENABLE_BLUETOOTH
+    if (WebUI::BTConfig::TXpending() || (bt_rx_held && client_buffer[CLIENT_BT].availableforwrite())) {
+        return 1;
+    }
+#    endif
+#    if defined(ENABLE_WIFI) && defined(ENABLE_HTTP) && defined(ENABLE_SERIAL2SOCKET_IN)
+    if (WebUI::Serial2Socket.available()) {
+        return 1;
+    }
+#    endif
+#    if defined(ENABLE_WIFI) && defined(ENABLE_HTTP) && defined(ENABLE_WEBSOCKET_STREAM)
+    if (WebUI::SocketStream.available() && client_buffer[CLIENT_WEBSOCKET].availableforwrite()) {
+        return 1;
+    }
+#    endif
+#    ifdef ENABLE_WIFI
+    if (WebUI::WiFiConfig::Is_Network_on()) {
+        wait = MIN(wait, CLIENT_NETWORK_POLL_MS);
+#        ifdef ENABLE_HTTP
+        if (WebUI::Web_Server::transferring()) {
+            return 1;
+        }
+#        endif
+#        ifdef ENABLE_TELNET
+        if (WebUI::telnet_server.available() || WebUI::telnet_server.hasClient()) {
+            return 1;
+        }
+#        endif
+    }
+#    endif
+    return wait;
+}
+
+// Sleeps until client_wake() is called or ms have passed, but always for at least a tick so
+// the idle task gets to run.
+static void client_sleep(uint32_t ms) {
+    xSemaphoreTake(client_wake_semaphore, MAX(pdMS_TO_TICKS(ms), TickType_t(1)));
+}
+#endif
+
 // this task runs and checks for data on all interfaces
-// REaltime stuff is acted upon, then characters are added to the appropriate buffer
 void clientCheckTask(void* pvParameters) {
     uint8_t            data = 0;
     uint8_t            client;  // who sent the data
     static UBaseType_t uxHighWaterMark = 0;
     while (true) {  // run continuously
+        TRACE_BEGIN(ClientCheck, 0);
         while ((client = getClientChar(&data)) != CLIENT_ALL) {
-            // Pick off realtime command characters directly from the serial stream. These characters are
-            // not passed into the main buffer, but these set system state flag bits for realtime execution.
-            if (is_realtime_command(data)) {
-                execute_realtime_command(static_cast<Cmd>(data), client);
-            } else {
-#if defined(ENABLE_SD_CARD)
-                if (get_sd_state(false) < SDState::Busy) {
-#endif  //ENABLE_SD_CARD
-                    vTaskEnterCritical(&myMutex);
-                    client_buffer[client].write(data);
-                    vTaskExitCritical(&myMutex);
-#if defined(ENABLE_SD_CARD)
-                } else {
-                    if (data == '\r' || data == '\n') {
-                        grbl_sendf(client, "error %d\r\n", Error::AnotherInterfaceBusy);
-                        grbl_msg_sendf(client, MsgLevel::Info, "SD card job running");
-                    }
-                }
-#endif  //ENABLE_SD_CARD
-            }
+            client_accept(client, data);
         }  // if something available
+#ifdef ENABLE_BLUETOOTH
+        bt_rx_poll();
+#endif
+#if defined(ENABLE_WIFI) && defined(ENABLE_HTTP) && defined(ENABLE_WEBSOCKET_STREAM)
+        // Realtime commands were picked off as the messages arrived. The rest waits in the
+        // stream's own buffer, uncredited, while the line buffer is full.
+        int c;
+        while (client_buffer[CLIENT_WEBSOCKET].availableforwrite() && (c = WebUI::SocketStream.read()) != -1) {
+            client_store(CLIENT_WEBSOCKET, c);
+        }
+#endif
         WebUI::COMMANDS::handle();
+        uint32_t report_wait = report_auto_status();
+#ifndef REVERT_TO_ARDUINO_SERIAL
+        Uart0.drainTx();
+#endif
+        if (network_ready()) {
 #ifdef ENABLE_WIFI
-        WebUI::wifi_config.handle();
+            WebUI::wifi_config.handle();
 #endif
 #ifdef ENABLE_BLUETOOTH
-        WebUI::bt_config.handle();
+            WebUI::bt_config.handle();
 #endif
+        }
 #if defined(ENABLE_WIFI) && defined(ENABLE_HTTP) && defined(ENABLE_SERIAL2SOCKET_IN)
         WebUI::Serial2Socket.handle_flush();
 #endif
+#if defined(ENABLE_WIFI) && defined(ENABLE_HTTP) && defined(ENABLE_WEBSOCKET_STREAM)
+        WebUI::SocketStream.handle_flush();
+#endif
+        TRACE_END(ClientCheck, 0);
+#ifdef REVERT_TO_ARDUINO_SERIAL
         vTaskDelay(1 / portTICK_RATE_MS);  // Yield to other tasks
+#else
+        client_sleep(client_idle_ms(report_wait));  // Yield to other tasks until there is work
+#endif
 
         static UBaseType_t uxHighWaterMark = 0;
 #ifdef DEBUG_TASK_STACK
@@ -224,10 +564,7 @@ void client_reset_read_buffer(uint8_t client) {
 
 // Fetches the first byte in the client read buffer. Called by protocol loop.
 int client_read(uint8_t client) {
-    vTaskEnterCritical(&myMutex);
-    int data = client_buffer[client].read();
-    vTaskExitCritical(&myMutex);
-    return data;
+    return client_buffer[client].read();
 }
 
 // checks to see if a character is a realtime character
@@ -343,34 +680,55 @@ void execute_realtime_command(Cmd command, uint8_t client) {
         case Cmd::CoolantMistOvrToggle:
             sys_rt_exec_accessory_override.bit.coolantMistOvrToggle = 1;
             break;
+        case Cmd::BinaryMotionOn:
+            binary_motion_enable(client, true);
+            break;
+        case Cmd::BinaryMotionOff:
+            binary_motion_enable(client, false);
+            break;
     }
 }
 
-void client_write(uint8_t client, const char* text) {
-    if (client == CLIENT_INPUT) {
+void client_write(uint8_t client, const char* text, size_t length) {
+    if (client == CLIENT_INPUT || length == 0) {
         return;
     }
 #ifdef ENABLE_BLUETOOTH
-    if (WebUI::SerialBT.hasClient() && (client == CLIENT_BT || client == CLIENT_ALL)) {
-        WebUI::SerialBT.print(text);
-        //delay(10); // possible fix for dropped characters
+    if (client == CLIENT_BT || client == CLIENT_ALL) {
+        WebUI::bt_config.write((const uint8_t*)text, length);
     }
 #endif
 #if defined(ENABLE_WIFI) && defined(ENABLE_HTTP) && defined(ENABLE_SERIAL2SOCKET_OUT)
     if (client == CLIENT_WEBUI || client == CLIENT_ALL) {
-        WebUI::Serial2Socket.write((const uint8_t*)text, strlen(text));
+        WebUI::Serial2Socket.write((const uint8_t*)text, length);
     }
 #endif
 #if defined(ENABLE_WIFI) && defined(ENABLE_TELNET)
     if (client == CLIENT_TELNET || client == CLIENT_ALL) {
-        WebUI::telnet_server.write((const uint8_t*)text, strlen(text));
+        WebUI::telnet_server.write((const uint8_t*)text, length);
+    }
+#endif
+#if defined(ENABLE_WIFI) && defined(ENABLE_HTTP) && defined(ENABLE_WEBSOCKET_STREAM)
+    if (client == CLIENT_WEBSOCKET || client == CLIENT_ALL) {
+        WebUI::SocketStream.write((const uint8_t*)text, length);
+    }
+#endif
+#if defined(ENABLE_WIFI) && defined(ENABLE_TCP_STREAM)
+    if (client == CLIENT_TCP || client == CLIENT_ALL) {
+        WebUI::TcpStream.write((const uint8_t*)text, length);
+    }
+#endif
+#ifdef ENABLE_USB_CDC
+    if (client == CLIENT_USB || client == CLIENT_ALL) {
+        UsbCdc.write((const uint8_t*)text, length);
     }
 #endif
     if (client == CLIENT_SERIAL || client == CLIENT_ALL) {
 #ifdef REVERT_TO_ARDUINO_SERIAL
-        Serial.write(text);
+        Serial.write((const uint8_t*)text, length);
 #else
-        Uart0.write(text);
+        // [MSG:] lines give way to responses when the serial output backs up.
+        Uart0.write((const uint8_t*)text, length, length > 5 && strncmp(text, "[MSG:", 5) == 0);
 #endif
     }
 }
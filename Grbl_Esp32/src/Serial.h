@@ -21,10 +21,20 @@
 */
 
 #include "stdint.h"
+#include <cstring>
 
 #ifndef RX_BUFFER_SIZE
 #    define RX_BUFFER_SIZE 256
 #endif
+// Line buffers between the client task and the protocol loop, by client. Character counting
+// senders can keep this many bytes in flight, so the streaming clients get more. The size is
+// advertised in the [OPT:] line of $I and free space is reported in the Bf: status field.
+#ifndef SERIAL_RX_BUFFER_SIZE
+#    define SERIAL_RX_BUFFER_SIZE 1024
+#endif
+#ifndef TELNET_RX_BUFFER_SIZE
+#    define TELNET_RX_BUFFER_SIZE 1024
+#endif
 #ifndef TX_BUFFER_SIZE
 #    ifdef USE_LINE_NUMBERS
 #        define TX_BUFFER_SIZE 112
@@ -32,11 +42,22 @@
 #        define TX_BUFFER_SIZE 104
 #    endif
 #endif
+#ifndef UART_TX_QUEUE_SIZE
+#    define UART_TX_QUEUE_SIZE 4096
+#endif
 
 // a task to read for incoming data from serial port
 void clientCheckTask(void* pvParameters);
 
-void client_write(uint8_t client, const char* text);
+// a higher priority task that reads the serial port as soon as data arrives
+void serialRxTask(void* pvParameters);
+
+// Sends length bytes of text to the client, or to every connected client for CLIENT_ALL. All
+// of them are handed the same bytes, so text is formatted and measured once for a broadcast.
+void        client_write(uint8_t client, const char* text, size_t length);
+inline void client_write(uint8_t client, const char* text) {
+    client_write(client, text, strlen(text));
+}
 
 // Fetches the first byte in the serial read buffer. Called by main program.
 int client_read(uint8_t client);
@@ -45,10 +66,26 @@ int client_read(uint8_t client);
 uint8_t check_action_command(uint8_t data);
 
 void client_init();
+
+// Switches the serial port to $Serial/Baud and $Serial/FlowControl once the settings are loaded.
+void client_apply_serial_settings();
+
+// Wakes the client task to look for input. Sources that the task does not poll call this
+// from their own task once they have queued data.
+void client_wake();
 void client_reset_read_buffer(uint8_t client);
 
-// Returns the number of bytes available in the RX serial buffer.
-uint8_t client_get_rx_buffer_available(uint8_t client);
+// For sources that read in blocks from their own task, as the only writer of the client's line
+// buffer. The first acts on the realtime commands in data and closes it up over them,
+// returning how many bytes are left; the second stores as many of those as the line buffer
+// has room for and returns how many it took.
+size_t client_pick_realtime(uint8_t client, uint8_t* data, size_t length);
+size_t client_store_bytes(uint8_t client, const uint8_t* data, size_t length);
+
+// The receive buffer size a character counting sender can assume for the client, and how much
+// of it is free. Bytes still waiting in the transport count as used.
+int client_get_rx_buffer_size(uint8_t client);
+int client_get_rx_buffer_available(uint8_t client);
 
 void execute_realtime_command(Cmd command, uint8_t client);
 bool is_realtime_command(uint8_t data);
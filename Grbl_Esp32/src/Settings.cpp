@@ -1,6 +1,8 @@
 #include "Grbl.h"
 #include "WebUI/JSONEncoder.h"
+#include <algorithm>
 #include <map>
+#include <vector>
 #include <nvs.h>
 
 bool anyState() {
@@ -55,6 +57,10 @@ Setting::Setting(
     }
 }
 
+// Post-change actions held back by deferPostChange(), each once.
+static std::vector<bool (*)(char*)> post_deferred;
+static bool                         post_deferring = false;
+
 Error Setting::check(char* s) {
     if (sys.state != State::Idle && sys.state != State::Alarm) {
         return Error::IdleError;
@@ -62,17 +68,180 @@ Error Setting::check(char* s) {
     if (!_checker) {
         return Error::Ok;
     }
+    if (!s && post_deferring) {
+        if (std::find(post_deferred.begin(), post_deferred.end(), _checker) == post_deferred.end()) {
+            post_deferred.push_back(_checker);
+        }
+        return Error::Ok;
+    }
     return _checker(s) ? Error::Ok : Error::InvalidValue;
 }
 
+void Setting::onChange(listener_t listener) {
+    _listeners = new listener_node_t { listener, _listeners };
+    listener(this);
+}
+
+volatile uint32_t Setting::changes = 0;
+
+void Setting::notify() {
+    changes++;
+    for (listener_node_t* node = _listeners; node; node = node->next) {
+        node->listener(this);
+    }
+}
+
+void Setting::deferPostChange() {
+    post_deferring = true;
+}
+
+void Setting::runPostChange() {
+    post_deferring = false;
+    for (auto checker : post_deferred) {
+        checker(NULL);
+    }
+    post_deferred.clear();
+}
+
 nvs_handle Setting::_handle = 0;
 
+// NVS writes staged by a batch, by key. A later write to the same key replaces the earlier one,
+// so only the last value of each is written.
+typedef struct {
+    enum { Erase, I8, I32, Str, Blob } type;
+    int32_t              value;
+    std::vector<uint8_t> data;  // For Str, with the terminator, and Blob
+} nvs_write_t;
+
+static std::map<String, nvs_write_t> nvs_staged;
+static int                           nvs_batches = 0;
+static SemaphoreHandle_t             nvs_lock    = NULL;
+
 void Setting::init() {
     if (!_handle) {
         if (esp_err_t err = nvs_open("Grbl_ESP32", NVS_READWRITE, &_handle)) {
             grbl_sendf(CLIENT_SERIAL, "nvs_open failed with error %d\r\n", err);
         }
     }
+    if (!nvs_lock) {
+        nvs_lock = xSemaphoreCreateMutex();
+    }
+}
+
+void Setting::beginBatch() {
+    xSemaphoreTake(nvs_lock, portMAX_DELAY);
+    nvs_batches++;
+    xSemaphoreGive(nvs_lock);
+}
+
+Error Setting::commitBatch() {
+    xSemaphoreTake(nvs_lock, portMAX_DELAY);
+    if (nvs_batches == 0 || --nvs_batches) {
+        xSemaphoreGive(nvs_lock);
+        return Error::Ok;
+    }
+#ifdef FORCE_BUFFER_SYNC_DURING_NVS_WRITE
+    if (!nvs_staged.empty()) {
+        protocol_buffer_synchronize();
+    }
+#endif
+    Error err = Error::Ok;
+    for (auto& staged : nvs_staged) {
+        const char*        key = staged.first.c_str();
+        const nvs_write_t& w   = staged.second;
+        esp_err_t          e   = ESP_OK;
+        switch (w.type) {
+            case nvs_write_t::Erase:
+                nvs_erase_key(_handle, key);
+                break;
+            case nvs_write_t::I8:
+                e = nvs_set_i8(_handle, key, int8_t(w.value));
+                break;
+            case nvs_write_t::I32:
+                e = nvs_set_i32(_handle, key, w.value);
+                break;
+            case nvs_write_t::Str:
+                e = nvs_set_str(_handle, key, (const char*)w.data.data());
+                break;
+            case nvs_write_t::Blob:
+                e = nvs_set_blob(_handle, key, w.data.data(), w.data.size());
+                break;
+        }
+        if (e != ESP_OK) {
+            err = Error::NvsSetFailed;
+        }
+    }
+    nvs_staged.clear();
+    nvs_commit(_handle);
+    xSemaphoreGive(nvs_lock);
+    return err;
+}
+
+// Writes now, or stages the write if a batch is open.
+static esp_err_t nvs_write(const char* key, const nvs_write_t& w) {
+    if (nvs_lock) {
+        xSemaphoreTake(nvs_lock, portMAX_DELAY);
+    }
+    if (nvs_batches) {
+        nvs_staged[String(key)] = w;
+        xSemaphoreGive(nvs_lock);
+        return ESP_OK;
+    }
+    esp_err_t e = ESP_OK;
+    switch (w.type) {
+        case nvs_write_t::Erase:
+            nvs_erase_key(Setting::_handle, key);
+            break;
+        case nvs_write_t::I8:
+            e = nvs_set_i8(Setting::_handle, key, int8_t(w.value));
+            break;
+        case nvs_write_t::I32:
+            e = nvs_set_i32(Setting::_handle, key, w.value);
+            break;
+        case nvs_write_t::Str:
+            e = nvs_set_str(Setting::_handle, key, (const char*)w.data.data());
+            break;
+        case nvs_write_t::Blob:
+            e = nvs_set_blob(Setting::_handle, key, w.data.data(), w.data.size());
+            break;
+    }
+    if (nvs_lock) {
+        xSemaphoreGive(nvs_lock);
+    }
+    return e;
+}
+
+void Setting::eraseKey(const char* key) {
+    nvs_write_t w = { nvs_write_t::Erase, 0, {} };
+    nvs_write(key, w);
+}
+
+esp_err_t Setting::storeI8(const char* key, int8_t value) {
+    nvs_write_t w = { nvs_write_t::I8, value, {} };
+    return nvs_write(key, w);
+}
+
+esp_err_t Setting::storeI32(const char* key, int32_t value) {
+    nvs_write_t w = { nvs_write_t::I32, value, {} };
+    return nvs_write(key, w);
+}
+
+esp_err_t Setting::storeStr(const char* key, const char* value) {
+    nvs_write_t w = { nvs_write_t::Str, 0, std::vector<uint8_t>(value, value + strlen(value) + 1) };
+    return nvs_write(key, w);
+}
+
+esp_err_t Setting::storeBlob(const char* key, const void* value, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(value);
+    nvs_write_t    w     = { nvs_write_t::Blob, 0, std::vector<uint8_t>(bytes, bytes + length) };
+    return nvs_write(key, w);
+}
+
+void Setting::eraseAll() {
+    xSemaphoreTake(nvs_lock, portMAX_DELAY);
+    nvs_staged.clear();
+    nvs_erase_all(_handle);
+    xSemaphoreGive(nvs_lock);
 }
 
 IntSetting::IntSetting(const char*   description,
@@ -102,13 +271,14 @@ void IntSetting::load() {
 
 void IntSetting::setDefault() {
     if (_currentIsNvm) {
-        nvs_erase_key(_handle, _keyName);
+        eraseKey(_keyName);
     } else {
         _currentValue = _defaultValue;
         if (_storedValue != _currentValue) {
-            nvs_erase_key(_handle, _keyName);
+            eraseKey(_keyName);
         }
     }
+    notify();
 }
 
 Error IntSetting::setStringValue(char* s) {
@@ -133,15 +303,16 @@ Error IntSetting::setStringValue(char* s) {
 
     if (_storedValue != convertedValue) {
         if (convertedValue == _defaultValue) {
-            nvs_erase_key(_handle, _keyName);
+            eraseKey(_keyName);
         } else {
-            if (nvs_set_i32(_handle, _keyName, convertedValue)) {
+            if (storeI32(_keyName, convertedValue)) {
                 return Error::NvsSetFailed;
             }
             _storedValue = convertedValue;
         }
     }
     check(NULL);
+    notify();
     return Error::Ok;
 }
 
@@ -199,8 +370,9 @@ void AxisMaskSetting::load() {
 void AxisMaskSetting::setDefault() {
     _currentValue = _defaultValue;
     if (_storedValue != _currentValue) {
-        nvs_erase_key(_handle, _keyName);
+        eraseKey(_keyName);
     }
+    notify();
 }
 
 Error AxisMaskSetting::setStringValue(char* s) {
@@ -231,15 +403,16 @@ Error AxisMaskSetting::setStringValue(char* s) {
     _currentValue = convertedValue;
     if (_storedValue != _currentValue) {
         if (_currentValue == _defaultValue) {
-            nvs_erase_key(_handle, _keyName);
+            eraseKey(_keyName);
         } else {
-            if (nvs_set_i32(_handle, _keyName, _currentValue)) {
+            if (storeI32(_keyName, _currentValue)) {
                 return Error::NvsSetFailed;
             }
             _storedValue = _currentValue;
         }
     }
     check(NULL);
+    notify();
     return Error::Ok;
 }
 
@@ -304,8 +477,9 @@ void FloatSetting::load() {
 void FloatSetting::setDefault() {
     _currentValue = _defaultValue;
     if (_storedValue != _currentValue) {
-        nvs_erase_key(_handle, _keyName);
+        eraseKey(_keyName);
     }
+    notify();
 }
 
 Error FloatSetting::setStringValue(char* s) {
@@ -327,20 +501,21 @@ Error FloatSetting::setStringValue(char* s) {
     _currentValue = convertedValue;
     if (_storedValue != _currentValue) {
         if (_currentValue == _defaultValue) {
-            nvs_erase_key(_handle, _keyName);
+            eraseKey(_keyName);
         } else {
             union {
                 int32_t ival;
                 float   fval;
             } v;
             v.fval = _currentValue;
-            if (nvs_set_i32(_handle, _keyName, v.ival)) {
+            if (storeI32(_keyName, v.ival)) {
                 return Error::NvsSetFailed;
             }
             _storedValue = _currentValue;
         }
     }
     check(NULL);
+    notify();
     return Error::Ok;
 }
 
@@ -406,8 +581,9 @@ void StringSetting::load() {
 void StringSetting::setDefault() {
     _currentValue = _defaultValue;
     if (_storedValue != _currentValue) {
-        nvs_erase_key(_handle, _keyName);
+        eraseKey(_keyName);
     }
+    notify();
 }
 
 Error StringSetting::setStringValue(char* s) {
@@ -421,16 +597,17 @@ Error StringSetting::setStringValue(char* s) {
     _currentValue = s;
     if (_storedValue != _currentValue) {
         if (_currentValue == _defaultValue) {
-            nvs_erase_key(_handle, _keyName);
+            eraseKey(_keyName);
             _storedValue = _defaultValue;
         } else {
-            if (nvs_set_str(_handle, _keyName, _currentValue.c_str())) {
+            if (storeStr(_keyName, _currentValue.c_str())) {
                 return Error::NvsSetFailed;
             }
             _storedValue = _currentValue;
         }
     }
     check(NULL);
+    notify();
     return Error::Ok;
 }
 
@@ -485,8 +662,9 @@ void EnumSetting::load() {
 void EnumSetting::setDefault() {
     _currentValue = _defaultValue;
     if (_storedValue != _currentValue) {
-        nvs_erase_key(_handle, _keyName);
+        eraseKey(_keyName);
     }
+    notify();
 }
 
 // For enumerations, we allow the value to be set
@@ -525,15 +703,16 @@ Error EnumSetting::setStringValue(char* s) {
     _currentValue = it->second;
     if (_storedValue != _currentValue) {
         if (_currentValue == _defaultValue) {
-            nvs_erase_key(_handle, _keyName);
+            eraseKey(_keyName);
         } else {
-            if (nvs_set_i8(_handle, _keyName, _currentValue)) {
+            if (storeI8(_keyName, _currentValue)) {
                 return Error::NvsSetFailed;
             }
             _storedValue = _currentValue;
         }
     }
     check(NULL);
+    notify();
     return Error::Ok;
 }
 
@@ -589,8 +768,9 @@ void FlagSetting::load() {
 void FlagSetting::setDefault() {
     _currentValue = _defaultValue;
     if (_storedValue != _currentValue) {
-        nvs_erase_key(_handle, _keyName);
+        eraseKey(_keyName);
     }
+    notify();
 }
 
 Error FlagSetting::setStringValue(char* s) {
@@ -605,15 +785,16 @@ Error FlagSetting::setStringValue(char* s) {
     // _currentValue is 0 or 1
     if (_storedValue != (int8_t)_currentValue) {
         if (_currentValue == _defaultValue) {
-            nvs_erase_key(_handle, _keyName);
+            eraseKey(_keyName);
         } else {
-            if (nvs_set_i8(_handle, _keyName, _currentValue)) {
+            if (storeI8(_keyName, _currentValue)) {
                 return Error::NvsSetFailed;
             }
             _storedValue = _currentValue;
         }
     }
     check(NULL);
+    notify();
     return Error::Ok;
 }
 const char* FlagSetting::getDefaultString() {
@@ -669,8 +850,9 @@ void IPaddrSetting::load() {
 void IPaddrSetting::setDefault() {
     _currentValue = _defaultValue;
     if (_storedValue != _currentValue) {
-        nvs_erase_key(_handle, _keyName);
+        eraseKey(_keyName);
     }
+    notify();
 }
 
 Error IPaddrSetting::setStringValue(char* s) {
@@ -686,15 +868,16 @@ Error IPaddrSetting::setStringValue(char* s) {
     _currentValue = ipaddr;
     if (_storedValue != _currentValue) {
         if (_currentValue == _defaultValue) {
-            nvs_erase_key(_handle, _keyName);
+            eraseKey(_keyName);
         } else {
-            if (nvs_set_i32(_handle, _keyName, (int32_t)_currentValue)) {
+            if (storeI32(_keyName, (int32_t)_currentValue)) {
                 return Error::NvsSetFailed;
             }
             _storedValue = _currentValue;
         }
     }
     check(NULL);
+    notify();
     return Error::Ok;
 }
 
@@ -746,10 +929,45 @@ bool Coordinates::load() {
     }
 };
 
+int64_t Coordinates::_changed_us = 0;
+
 void Coordinates::set(float value[MAX_N_AXIS]) {
+    if (!memcmp(_currentValue, value, sizeof(_currentValue))) {
+        return;
+    }
     memcpy(&_currentValue, value, sizeof(_currentValue));
-#ifdef FORCE_BUFFER_SYNC_DURING_NVS_WRITE
-    protocol_buffer_synchronize();
+    _dirty      = true;
+    _changed_us = esp_timer_get_time();
+}
+
+void Coordinates::persist() {
+    if (!_changed_us) {
+        return;
+    }
+    // One commit for all of them. NVS writes each blob whole or not at all, so a power loss
+    // part way through leaves every coordinate system either old or new.
+    Setting::beginBatch();
+    for (auto idx = CoordIndex::Begin; idx < CoordIndex::End; ++idx) {
+        Coordinates* c = coords[idx];
+        if (c->_dirty) {
+            Setting::storeBlob(c->_name, c->_currentValue, sizeof(c->_currentValue));
+            c->_dirty = false;
+        }
+    }
+    _changed_us = 0;
+    Setting::commitBatch();
+}
+
+void Coordinates::persistWhenIdle() {
+    if (!_changed_us || (sys.state != State::Idle && sys.state != State::Alarm) || plan_get_current_block()) {
+        return;
+    }
+#ifdef ENABLE_SD_CARD
+    if (get_sd_state(false) == SDState::BusyPrinting) {
+        return;  // Between motions of a job still running
+    }
 #endif
-    nvs_set_blob(Setting::_handle, _name, _currentValue, sizeof(_currentValue));
+    if (esp_timer_get_time() - _changed_us >= int64_t(COORDS_PERSIST_DELAY_MS) * 1000) {
+        persist();
+    }
 }
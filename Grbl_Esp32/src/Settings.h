@@ -101,14 +101,56 @@ protected:
     bool (*_checker)(char*);
     const char* _keyName;
 
+public:
+    typedef void (*listener_t)(Setting* setting);
+
+private:
+    typedef struct listener_node {
+        listener_t            listener;
+        struct listener_node* next;
+    } listener_node_t;
+    listener_node_t* _listeners = NULL;
+
+protected:
+    // Tells the listeners, after the value has changed.
+    void notify();
+
 public:
     static nvs_handle _handle;
     static void       init();
+
+    // Counts the changes of all settings, so caches of values computed from them can tell
+    // when they are stale.
+    static volatile uint32_t changes;
     static Setting*   List;
     Setting*          next() { return link; }
 
+    // Writes to NVS between beginBatch() and commitBatch() take effect at once in memory but
+    // are held in RAM, and commitBatch() writes them in one pass, only the last value of each.
+    // Batches nest; the outermost commit writes. Writes still held at a reset are lost.
+    static void  beginBatch();
+    static Error commitBatch();
+
+    // All NVS writes go through these, so a batch can hold them back.
+    static void      eraseKey(const char* key);
+    static esp_err_t storeI8(const char* key, int8_t value);
+    static esp_err_t storeI32(const char* key, int32_t value);
+    static esp_err_t storeStr(const char* key, const char* value);
+    static esp_err_t storeBlob(const char* key, const void* value, size_t length);
+    static void      eraseAll();
+
+    // Between these, settings that change hold back their post-change actions, such as
+    // reselecting the spindle, and runPostChange() runs each distinct one once.
+    static void deferPostChange();
+    static void runPostChange();
+
     Error check(char* s);
 
+    // Code that reads a setting on a hot path registers a listener to keep a plain copy of
+    // it instead. The listener is called once now, to fill the copy, and again each time the
+    // setting is set or reset to its default, from the task that changed it.
+    void onChange(listener_t listener);
+
     static Error report_nvs_stats(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
         nvs_stats_t stats;
         if (esp_err_t err = nvs_get_stats(NULL, &stats)) {
@@ -128,10 +170,19 @@ public:
     }
 
     static Error eraseNVS(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
-        nvs_erase_all(_handle);
+        eraseAll();
         return Error::Ok;
     }
 
+    static Error beginBatch(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+        beginBatch();
+        return Error::Ok;
+    }
+
+    static Error commitBatch(const char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* out) {
+        return commitBatch();
+    }
+
     ~Setting() {}
     // Setting(const char *description, group_t group, const char * grblName, const char* fullName, bool (*checker)(char *));
     Setting(const char* description, type_t type, permissions_t permissions, const char* grblName, const char* fullName, bool (*checker)(char*));
@@ -227,10 +278,15 @@ public:
     int32_t get() { return _currentValue; }
 };
 
+// Served from RAM. set() only marks the coordinate system changed, and persist() writes all
+// the changed ones to NVS in one batch, which the main loop does once the machine is idle.
 class Coordinates {
 private:
     float       _currentValue[MAX_N_AXIS];
     const char* _name;
+    bool        _dirty = false;  // Changed since it was written to NVS
+
+    static int64_t _changed_us;  // When the last change was made, 0 when all are written
 
 public:
     Coordinates(const char* name) : _name(name) {}
@@ -248,6 +304,11 @@ public:
     // Return a pointer to the array
     const float* get() { return _currentValue; }
     void         set(float* value);
+
+    // Writes the changed coordinate systems now.
+    static void persist();
+    // Writes them if the machine has been idle long enough since the last change.
+    static void persistWhenIdle();
 };
 
 extern Coordinates* coords[CoordIndex::End];
@@ -429,18 +490,43 @@ public:
     uint32_t get() { return _currentValue; }
 };
 
+// A constant that reads like a setting, for values fixed when the firmware is built. It is
+// not stored in NVS or listed by $$, and cannot be changed.
+template <typename T>
+class FakeSetting {
+private:
+    const T _value;
+
+public:
+    constexpr FakeSetting(T value) : _value(value) {}
+
+    constexpr T get() const { return _value; }
+};
+
+#ifdef LOCKED_AXIS_SETTINGS
+typedef FakeSetting<float> AxisGeometrySetting;
+#else
+typedef FloatSetting AxisGeometrySetting;
+#endif
+
 class AxisSettings {
 public:
-    const char*   name;
-    FloatSetting* steps_per_mm;
-    FloatSetting* max_rate;
-    FloatSetting* acceleration;
-    FloatSetting* max_travel;
-    FloatSetting* run_current;
-    FloatSetting* hold_current;
-    FloatSetting* home_mpos;
-    IntSetting*   microsteps;
-    IntSetting*   stallguard;
+    const char*          name;
+    AxisGeometrySetting* steps_per_mm;
+    AxisGeometrySetting* max_rate;
+    AxisGeometrySetting* acceleration;
+    FloatSetting*        jerk;
+    FloatSetting*        junction_deviation;
+    FloatSetting*        backlash;
+    AxisGeometrySetting* max_travel;
+    FloatSetting*        run_current;
+    FloatSetting*        hold_current;
+    FloatSetting*        home_mpos;
+    IntSetting*          microsteps;
+    IntSetting*          stallguard;
+    FloatSetting*        encoder_counts_per_mm;  // Only with AXIS_ENCODERS
+    EnumSetting*         rotary;
+    FloatSetting*        radius;
 
     AxisSettings(const char* axisName);
 };
@@ -497,14 +583,3 @@ public:
         GrblCommand(grblName, name, action, cmdChecker, WG) {}
     Error action(char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream* response);
 };
-
-template <typename T>
-class FakeSetting {
-private:
-    T _value;
-
-public:
-    FakeSetting(T value) : _value(value) {}
-
-    T get() { return _value; }
-};
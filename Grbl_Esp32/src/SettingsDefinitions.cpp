@@ -1,4 +1,5 @@
 #include "Grbl.h"
+#include "Spindles/PWMSpindle.h"
 
 FlagSetting* verbose_errors;
 
@@ -12,13 +13,115 @@ IntSetting* pulse_microseconds;
 IntSetting* stepper_idle_lock_time;
 IntSetting* direction_delay_microseconds;
 IntSetting* enable_delay_microseconds;
+IntSetting* stepper_segment_buffer_size;
+
+IntSetting*   planner_block_buffer_size;
+FlagSetting*  planner_use_psram;
+IntSetting*   planner_recalculate_limit;
+FloatSetting* planner_merge_tolerance;
+FloatSetting* planner_arc_fit_tolerance;
+FloatSetting* kinematics_cache_tolerance;
+FloatSetting* kinematics_tolerance;
+
+IntSetting*  serial_baud;
+FlagSetting* serial_flow_control;
+
+StringSetting* task_placement_list;
+
+FlagSetting*  heightmap_enable;
+FloatSetting* heightmap_probe_feed;
+FloatSetting* heightmap_probe_depth;
+
+FloatSetting* probe_feed;
+FloatSetting* probe_depth;
+
+FlagSetting*  atc_enable;
+FloatSetting* atc_safe_z;
+FloatSetting* atc_clearance;
+FloatSetting* atc_feed;
+IntSetting*   atc_drawbar;
+FloatSetting* atc_drawbar_delay;
+FlagSetting*  atc_measure_length;
+FloatSetting* atc_setter_x;
+FloatSetting* atc_setter_y;
+FloatSetting* atc_setter_z;
+FloatSetting* atc_setter_depth;
+FloatSetting* atc_setter_feed;
+FloatSetting* atc_setter_reference;
+
+#ifdef ENABLE_SD_CARD
+FlagSetting* sd_binary_cache;
+FlagSetting* sd_estimate_time;
+FlagSetting* sd_preview;
+IntSetting*  sd_job_log_period;
+EnumSetting* sd_bus;
+IntSetting*  sd_spi_frequency;
+#endif
+
+#ifdef USE_I2S_STEPS
+IntSetting*  i2s_dmabuf_count;
+IntSetting*  i2s_dmabuf_len;
+FlagSetting* i2s_adaptive_latency;
+FlagSetting* i2s_unified;
+#endif
+
+#ifdef POSITION_CAPTURE
+IntSetting* capture_rate;
+#endif
 
 AxisMaskSetting* step_invert_mask;
 AxisMaskSetting* dir_invert_mask;
 // TODO Settings - need to call st_generate_step_invert_masks;
 AxisMaskSetting* homing_dir_mask;
 AxisMaskSetting* homing_squared_axes;
+AxisMaskSetting* homing_parallel_axes;
+FlagSetting*     homing_fast_ref;
 AxisMaskSetting* stallguard_debug_mask;
+AxisMaskSetting* stallguard_monitor_mask;
+IntSetting*      stallguard_monitor_period;
+IntSetting*      stallguard_monitor_drop;
+
+#ifdef AXIS_ENCODERS
+FloatSetting* encoder_tolerance;
+EnumSetting*  encoder_action;
+
+enum_opt_t encoderActions = {
+    // clang-format off
+    { "Report", int8_t(EncoderAction::Report) },
+    { "Hold", int8_t(EncoderAction::Hold) },
+    { "Alarm", int8_t(EncoderAction::Alarm) },
+    { "Correct", int8_t(EncoderAction::Correct) },
+    // clang-format on
+};
+#endif
+
+#ifdef ENABLE_ESP_NOW_SYNC
+EnumSetting* sync_role_setting;
+IntSetting*  sync_group;
+
+enum_opt_t syncRoles = {
+    // clang-format off
+    { "Off", int8_t(SyncRole::Off) },
+    { "Leader", int8_t(SyncRole::Leader) },
+    { "Follower", int8_t(SyncRole::Follower) },
+    // clang-format on
+};
+#endif
+
+#ifdef INPUT_SHAPING
+EnumSetting*  shaper_type;
+FloatSetting* shaper_frequency;
+FloatSetting* shaper_damping;
+
+enum_opt_t inputShapers = {
+    // clang-format off
+    { "None", int8_t(InputShaper::None) },
+    { "ZV", int8_t(InputShaper::ZV) },
+    { "ZVD", int8_t(InputShaper::ZVD) },
+    { "EI", int8_t(InputShaper::EI) },
+    // clang-format on
+};
+#endif
 
 FlagSetting* step_enable_invert;
 FlagSetting* limit_invert;
@@ -53,12 +156,22 @@ FlagSetting*     spindle_enbl_off_with_zero_speed;
 FlagSetting*     spindle_enable_invert;
 FlagSetting*     spindle_output_invert;
 
-FloatSetting* spindle_pwm_off_value;
-FloatSetting* spindle_pwm_min_value;
-FloatSetting* spindle_pwm_max_value;
-IntSetting*   spindle_pwm_bit_precision;
+FlagSetting*  spindle_adaptive_enable;
+FloatSetting* spindle_adaptive_target;
+FloatSetting* spindle_adaptive_idle;
+IntSetting*   spindle_adaptive_min;
+IntSetting*   spindle_adaptive_max;
+FloatSetting* spindle_adaptive_gain;
+
+FloatSetting*  spindle_pwm_off_value;
+StringSetting* spindle_pwm_curve;
+FloatSetting*  spindle_pwm_ramp;
+FloatSetting*  spindle_pwm_min_value;
+FloatSetting*  spindle_pwm_max_value;
+IntSetting*    spindle_pwm_bit_precision;
 
 EnumSetting* spindle_type;
+EnumSetting* spindle_alt_type;
 
 EnumSetting* message_level;
 
@@ -76,6 +189,25 @@ enum_opt_t spindleTypes = {
     // clang-format on
 };
 
+enum_opt_t rotaryModes = {
+    // clang-format off
+    { "Linear", int8_t(RotaryMode::Linear) },
+    { "Rotary", int8_t(RotaryMode::Rotary) },
+    { "Wrapped", int8_t(RotaryMode::Wrapped) },
+    { "Shortest", int8_t(RotaryMode::Shortest) },
+    // clang-format on
+};
+
+#ifdef ENABLE_SD_CARD
+enum_opt_t sdBuses = {
+    // clang-format off
+    { "SPI", int8_t(SDBus::SPI) },
+    { "MMC1", int8_t(SDBus::Mmc1Bit) },
+    { "MMC4", int8_t(SDBus::Mmc4Bit) },
+    // clang-format on
+};
+#endif
+
 enum_opt_t messageLevels = {
     // clang-format off
     { "None", int8_t(MsgLevel::None) },
@@ -106,73 +238,115 @@ typedef struct {
     float       steps_per_mm;
     float       max_rate;
     float       acceleration;
+    float       jerk;
+    float       junction_deviation;
+    float       backlash;
     float       max_travel;
     float       home_mpos;
     float       run_current;
     float       hold_current;
     uint16_t    microsteps;
     uint16_t    stallguard;
+    float       encoder_counts_per_mm;
+    int8_t      rotary;
+    float       radius;
 } axis_defaults_t;
 axis_defaults_t axis_defaults[] = { { "X",
                                       DEFAULT_X_STEPS_PER_MM,
                                       DEFAULT_X_MAX_RATE,
                                       DEFAULT_X_ACCELERATION,
+                                      DEFAULT_X_JERK,
+                                      DEFAULT_X_JUNCTION_DEVIATION,
+                                      DEFAULT_X_BACKLASH,
                                       DEFAULT_X_MAX_TRAVEL,
                                       DEFAULT_X_HOMING_MPOS,
                                       DEFAULT_X_CURRENT,
                                       DEFAULT_X_HOLD_CURRENT,
                                       DEFAULT_X_MICROSTEPS,
-                                      DEFAULT_X_STALLGUARD },
+                                      DEFAULT_X_STALLGUARD,
+                                      DEFAULT_X_ENCODER_COUNTS_PER_MM,
+                                      DEFAULT_X_ROTARY,
+                                      DEFAULT_X_RADIUS },
                                     { "Y",
                                       DEFAULT_Y_STEPS_PER_MM,
                                       DEFAULT_Y_MAX_RATE,
                                       DEFAULT_Y_ACCELERATION,
+                                      DEFAULT_Y_JERK,
+                                      DEFAULT_Y_JUNCTION_DEVIATION,
+                                      DEFAULT_Y_BACKLASH,
                                       DEFAULT_Y_MAX_TRAVEL,
                                       DEFAULT_Y_HOMING_MPOS,
                                       DEFAULT_Y_CURRENT,
                                       DEFAULT_Y_HOLD_CURRENT,
                                       DEFAULT_Y_MICROSTEPS,
-                                      DEFAULT_Y_STALLGUARD },
+                                      DEFAULT_Y_STALLGUARD,
+                                      DEFAULT_Y_ENCODER_COUNTS_PER_MM,
+                                      DEFAULT_Y_ROTARY,
+                                      DEFAULT_Y_RADIUS },
                                     { "Z",
                                       DEFAULT_Z_STEPS_PER_MM,
                                       DEFAULT_Z_MAX_RATE,
                                       DEFAULT_Z_ACCELERATION,
+                                      DEFAULT_Z_JERK,
+                                      DEFAULT_Z_JUNCTION_DEVIATION,
+                                      DEFAULT_Z_BACKLASH,
                                       DEFAULT_Z_MAX_TRAVEL,
                                       DEFAULT_Z_HOMING_MPOS,
                                       DEFAULT_Z_CURRENT,
                                       DEFAULT_Z_HOLD_CURRENT,
                                       DEFAULT_Z_MICROSTEPS,
-                                      DEFAULT_Z_STALLGUARD },
+                                      DEFAULT_Z_STALLGUARD,
+                                      DEFAULT_Z_ENCODER_COUNTS_PER_MM,
+                                      DEFAULT_Z_ROTARY,
+                                      DEFAULT_Z_RADIUS },
                                     { "A",
                                       DEFAULT_A_STEPS_PER_MM,
                                       DEFAULT_A_MAX_RATE,
                                       DEFAULT_A_ACCELERATION,
+                                      DEFAULT_A_JERK,
+                                      DEFAULT_A_JUNCTION_DEVIATION,
+                                      DEFAULT_A_BACKLASH,
                                       DEFAULT_A_MAX_TRAVEL,
                                       DEFAULT_A_HOMING_MPOS,
                                       DEFAULT_A_CURRENT,
                                       DEFAULT_A_HOLD_CURRENT,
                                       DEFAULT_A_MICROSTEPS,
-                                      DEFAULT_A_STALLGUARD },
+                                      DEFAULT_A_STALLGUARD,
+                                      DEFAULT_A_ENCODER_COUNTS_PER_MM,
+                                      DEFAULT_A_ROTARY,
+                                      DEFAULT_A_RADIUS },
                                     { "B",
                                       DEFAULT_B_STEPS_PER_MM,
                                       DEFAULT_B_MAX_RATE,
                                       DEFAULT_B_ACCELERATION,
+                                      DEFAULT_B_JERK,
+                                      DEFAULT_B_JUNCTION_DEVIATION,
+                                      DEFAULT_B_BACKLASH,
                                       DEFAULT_B_MAX_TRAVEL,
                                       DEFAULT_B_HOMING_MPOS,
                                       DEFAULT_B_CURRENT,
                                       DEFAULT_B_HOLD_CURRENT,
                                       DEFAULT_B_MICROSTEPS,
-                                      DEFAULT_B_STALLGUARD },
+                                      DEFAULT_B_STALLGUARD,
+                                      DEFAULT_B_ENCODER_COUNTS_PER_MM,
+                                      DEFAULT_B_ROTARY,
+                                      DEFAULT_B_RADIUS },
                                     { "C",
                                       DEFAULT_C_STEPS_PER_MM,
                                       DEFAULT_C_MAX_RATE,
                                       DEFAULT_C_ACCELERATION,
+                                      DEFAULT_C_JERK,
+                                      DEFAULT_C_JUNCTION_DEVIATION,
+                                      DEFAULT_C_BACKLASH,
                                       DEFAULT_C_MAX_TRAVEL,
                                       DEFAULT_C_HOMING_MPOS,
                                       DEFAULT_C_CURRENT,
                                       DEFAULT_C_HOLD_CURRENT,
                                       DEFAULT_C_MICROSTEPS,
-                                      DEFAULT_C_STALLGUARD } };
+                                      DEFAULT_C_STALLGUARD,
+                                      DEFAULT_C_ENCODER_COUNTS_PER_MM,
+                                      DEFAULT_C_ROTARY,
+                                      DEFAULT_C_RADIUS } };
 
 // Construct e.g. X_MAX_RATE from axisName "X" and tail "_MAX_RATE"
 // in dynamically allocated memory that will not be freed.
@@ -192,7 +366,11 @@ static bool checkStartupLine(char* value) {
     if (sys.state != State::Idle) {
         return false;
     }
-    return gc_execute_line(value, CLIENT_SERIAL) == Error::Ok;
+    // The parser splits the line in place, so it is given a copy to leave the value as typed.
+    char line[256];
+    strncpy(line, value, sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\0';
+    return gc_execute_line(line, CLIENT_SERIAL) == Error::Ok;
 }
 
 static bool postMotorSetting(char* value) {
@@ -213,20 +391,74 @@ static bool checkSpindleChange(char* val) {
             grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "Spindle turned off with setting change");
         }
         gc_state.spindle_speed = 0;   // Set S value to 0
-        spindle->deinit();            // old spindle
         Spindles::Spindle::select();  // get new spindle
         return true;
     }
     return true;
 }
 
+static bool checkSpindleCurve(char* val) {
+    if (val) {
+        float power[Spindles::PWM::CURVE_MAX_POINTS], duty[Spindles::PWM::CURVE_MAX_POINTS];
+        return Spindles::PWM::parse_curve(val, power, duty) >= 0;
+    }
+    return checkSpindleChange(val);
+}
+
+static bool postStepperSetting(char* value) {
+    if (!value) {
+        st_update_runtime_config();
+    }
+    return true;
+}
+
+static bool postPlannerSetting(char* value) {
+    if (!value) {
+        plan_update_axis_limits();
+    }
+    return true;
+}
+
+static bool postKinematicsCacheSetting(char* value) {
+    if (!value) {
+        mc_kinematics_cache_clear();
+    }
+    return true;
+}
+
+static bool checkTaskPlacement(char* value) {
+    if (value) {
+        return task_placement_valid(value);
+    }
+    task_apply_placement();
+    return true;
+}
+
+#ifdef ENABLE_SD_CARD
+static bool postSDSetting(char* value) {
+    if (!value) {
+        sd_reset_bus();
+    }
+    return true;
+}
+#endif
+
+#ifdef USE_I2S_STEPS
+static bool postI2SSetting(char* value) {
+    if (!value) {
+        st_update_i2s_config();
+    }
+    return true;
+}
+#endif
+
 // Generates a string like "122" from axisNum 2 and base 120
 static const char* makeGrblName(int axisNum, int base) {
     // To omit A,B,C axes:
     // if (axisNum > 2) return NULL;
     char buf[4];
     snprintf(buf, 4, "%d", axisNum + base);
-    char* retval = (char*)malloc(strlen(buf));
+    char* retval = (char*)malloc(strlen(buf) + 1);
     return strcpy(retval, buf);
 }
 
@@ -299,12 +531,31 @@ void make_settings() {
         setting->setAxis(axis);
         axis_settings[axis]->run_current = setting;
     }
+#ifdef AXIS_ENCODERS
+    for (axis = MAX_N_AXIS - 1; axis >= 0; axis--) {
+        def          = &axis_defaults[axis];
+        auto setting = new FloatSetting(
+            EXTENDED, WG, NULL, makename(def->name, "Encoder/CountsPerMm"), def->encoder_counts_per_mm, -100000.0, 100000.0);  // 0 is off
+        setting->setAxis(axis);
+        axis_settings[axis]->encoder_counts_per_mm = setting;
+    }
+#endif
+#ifdef LOCKED_AXIS_SETTINGS
+    for (axis = 0; axis < MAX_N_AXIS; axis++) {
+        def                               = &axis_defaults[axis];
+        axis_settings[axis]->max_travel   = new AxisGeometrySetting(def->max_travel);
+        axis_settings[axis]->acceleration = new AxisGeometrySetting(def->acceleration);
+        axis_settings[axis]->max_rate     = new AxisGeometrySetting(def->max_rate);
+        axis_settings[axis]->steps_per_mm = new AxisGeometrySetting(def->steps_per_mm);
+    }
+#else
     for (axis = MAX_N_AXIS - 1; axis >= 0; axis--) {
         def          = &axis_defaults[axis];
         auto setting = new FloatSetting(GRBL, WG, makeGrblName(axis, 130), makename(def->name, "MaxTravel"), def->max_travel, 0, 100000.0);
         setting->setAxis(axis);
         axis_settings[axis]->max_travel = setting;
     }
+#endif
 
     for (axis = MAX_N_AXIS - 1; axis >= 0; axis--) {
         def          = &axis_defaults[axis];
@@ -314,29 +565,71 @@ void make_settings() {
     }
 
     for (axis = MAX_N_AXIS - 1; axis >= 0; axis--) {
-        def = &axis_defaults[axis];
-        auto setting =
-            new FloatSetting(GRBL, WG, makeGrblName(axis, 120), makename(def->name, "Acceleration"), def->acceleration, 1.0, 100000.0);
+        def          = &axis_defaults[axis];
+        auto setting = new FloatSetting(EXTENDED, WG, NULL, makename(def->name, "Backlash"), def->backlash, 0.0, 10.0, postPlannerSetting);
+        setting->setAxis(axis);
+        axis_settings[axis]->backlash = setting;
+    }
+
+    for (axis = MAX_N_AXIS - 1; axis >= 0; axis--) {
+        def          = &axis_defaults[axis];
+        auto setting = new FloatSetting(
+            EXTENDED, WG, NULL, makename(def->name, "JunctionDeviation"), def->junction_deviation, 0.0, 10.0, postPlannerSetting);
+        setting->setAxis(axis);
+        axis_settings[axis]->junction_deviation = setting;
+    }
+
+    for (axis = MAX_N_AXIS - 1; axis >= 0; axis--) {
+        def          = &axis_defaults[axis];
+        auto setting = new FloatSetting(
+            EXTENDED, WG, NULL, makename(def->name, "Jerk"), def->jerk, 1.0, 10000000.0, postPlannerSetting);  // Used by S-curves
+        setting->setAxis(axis);
+        axis_settings[axis]->jerk = setting;
+    }
+
+    for (axis = MAX_N_AXIS - 1; axis >= 0; axis--) {
+        def          = &axis_defaults[axis];
+        auto setting = new EnumSetting(EXTENDED, WG, NULL, makename(def->name, "Rotary"), def->rotary, &rotaryModes, postPlannerSetting);
+        setting->setAxis(axis);
+        axis_settings[axis]->rotary = setting;
+    }
+
+    for (axis = MAX_N_AXIS - 1; axis >= 0; axis--) {
+        def          = &axis_defaults[axis];
+        auto setting = new FloatSetting(EXTENDED, WG, NULL, makename(def->name, "Radius"), def->radius, 0.0, 10000.0, postPlannerSetting);
+        setting->setAxis(axis);
+        axis_settings[axis]->radius = setting;
+    }
+
+#ifndef LOCKED_AXIS_SETTINGS
+    for (axis = MAX_N_AXIS - 1; axis >= 0; axis--) {
+        def          = &axis_defaults[axis];
+        auto setting = new FloatSetting(
+            GRBL, WG, makeGrblName(axis, 120), makename(def->name, "Acceleration"), def->acceleration, 1.0, 100000.0, postPlannerSetting);
         setting->setAxis(axis);
         axis_settings[axis]->acceleration = setting;
     }
     for (axis = MAX_N_AXIS - 1; axis >= 0; axis--) {
         def          = &axis_defaults[axis];
-        auto setting = new FloatSetting(GRBL, WG, makeGrblName(axis, 110), makename(def->name, "MaxRate"), def->max_rate, 1.0, 100000.0);
+        auto setting = new FloatSetting(
+            GRBL, WG, makeGrblName(axis, 110), makename(def->name, "MaxRate"), def->max_rate, 1.0, 100000.0, postPlannerSetting);
         setting->setAxis(axis);
         axis_settings[axis]->max_rate = setting;
     }
     for (axis = MAX_N_AXIS - 1; axis >= 0; axis--) {
-        def = &axis_defaults[axis];
-        auto setting =
-            new FloatSetting(GRBL, WG, makeGrblName(axis, 100), makename(def->name, "StepsPerMm"), def->steps_per_mm, 1.0, 100000.0);
+        def          = &axis_defaults[axis];
+        auto setting = new FloatSetting(
+            GRBL, WG, makeGrblName(axis, 100), makename(def->name, "StepsPerMm"), def->steps_per_mm, 1.0, 100000.0, postPlannerSetting);
         setting->setAxis(axis);
         axis_settings[axis]->steps_per_mm = setting;
     }
+#endif
 
     // Spindle Settings
     spindle_type =
         new EnumSetting(NULL, EXTENDED, WG, NULL, "Spindle/Type", static_cast<int8_t>(SPINDLE_TYPE), &spindleTypes, checkSpindleChange);
+    spindle_alt_type = new EnumSetting(
+        NULL, EXTENDED, WG, NULL, "Spindle/Alt/Type", static_cast<int8_t>(SPINDLE_ALT_TYPE), &spindleTypes, checkSpindleChange);
 
     spindle_pwm_max_value =
         new FloatSetting(EXTENDED, WG, "36", "Spindle/PWM/Max", DEFAULT_SPINDLE_MAX_VALUE, 0.0, 100.0, checkSpindleChange);
@@ -344,6 +637,9 @@ void make_settings() {
         new FloatSetting(EXTENDED, WG, "35", "Spindle/PWM/Min", DEFAULT_SPINDLE_MIN_VALUE, 0.0, 100.0, checkSpindleChange);
     spindle_pwm_off_value = new FloatSetting(
         EXTENDED, WG, "34", "Spindle/PWM/Off", DEFAULT_SPINDLE_OFF_VALUE, 0.0, 100.0, checkSpindleChange);  // these are percentages
+    spindle_pwm_curve =
+        new StringSetting(EXTENDED, WG, NULL, "Spindle/PWM/Curve", DEFAULT_SPINDLE_PWM_CURVE, checkSpindleCurve);
+    spindle_pwm_ramp = new FloatSetting(EXTENDED, WG, NULL, "Spindle/PWM/Ramp", DEFAULT_SPINDLE_PWM_RAMP, 0, 30, checkSpindleChange);
     // IntSetting spindle_pwm_bit_precision(EXTENDED, WG, "Spindle/PWM/Precision", DEFAULT_SPINDLE_BIT_PRECISION, 1, 16);
     spindle_pwm_freq = new FloatSetting(EXTENDED, WG, "33", "Spindle/PWM/Frequency", DEFAULT_SPINDLE_FREQ, 0, 100000, checkSpindleChange);
     spindle_output_invert = new FlagSetting(GRBL, WG, NULL, "Spindle/PWM/Invert", DEFAULT_INVERT_SPINDLE_OUTPUT_PIN, checkSpindleChange);
@@ -359,6 +655,15 @@ void make_settings() {
 
     spindle_enable_invert = new FlagSetting(GRBL, WG, NULL, "Spindle/Enable/Invert", DEFAULT_INVERT_SPINDLE_ENABLE_PIN, checkSpindleChange);
 
+    spindle_adaptive_enable = new FlagSetting(EXTENDED, WG, NULL, "Spindle/Adaptive/Enable", DEFAULT_SPINDLE_ADAPTIVE_ENABLE);
+    spindle_adaptive_target = new FloatSetting(EXTENDED, WG, NULL, "Spindle/Adaptive/Target", DEFAULT_SPINDLE_ADAPTIVE_TARGET, 0.1, 200.0);
+    spindle_adaptive_idle   = new FloatSetting(EXTENDED, WG, NULL, "Spindle/Adaptive/Idle", DEFAULT_SPINDLE_ADAPTIVE_IDLE, 0.0, 200.0);
+    spindle_adaptive_min    = new IntSetting(
+        EXTENDED, WG, NULL, "Spindle/Adaptive/Min", DEFAULT_SPINDLE_ADAPTIVE_MIN, FeedOverride::Min, FeedOverride::Default);
+    spindle_adaptive_max = new IntSetting(
+        EXTENDED, WG, NULL, "Spindle/Adaptive/Max", DEFAULT_SPINDLE_ADAPTIVE_MAX, FeedOverride::Default, FeedOverride::Max);
+    spindle_adaptive_gain = new FloatSetting(EXTENDED, WG, NULL, "Spindle/Adaptive/Gain", DEFAULT_SPINDLE_ADAPTIVE_GAIN, 0.0, 1.0);
+
     // GRBL Non-numbered settings
     startup_line_0 = new StringSetting(EXTENDED, WG, "N0", "GCode/Line0", "", checkStartupLine);
     startup_line_1 = new StringSetting(EXTENDED, WG, "N1", "GCode/Line1", "", checkStartupLine);
@@ -371,11 +676,13 @@ void make_settings() {
     rpm_min = new FloatSetting(GRBL, WG, "31", "GCode/MinS", DEFAULT_SPINDLE_RPM_MIN, 0, 100000, checkSpindleChange);
     rpm_max = new FloatSetting(GRBL, WG, "30", "GCode/MaxS", DEFAULT_SPINDLE_RPM_MAX, 0, 100000, checkSpindleChange);
 
-    homing_pulloff      = new FloatSetting(GRBL, WG, "27", "Homing/Pulloff", DEFAULT_HOMING_PULLOFF, 0, 1000);
-    homing_debounce     = new FloatSetting(GRBL, WG, "26", "Homing/Debounce", DEFAULT_HOMING_DEBOUNCE_DELAY, 0, 10000);
-    homing_seek_rate    = new FloatSetting(GRBL, WG, "25", "Homing/Seek", DEFAULT_HOMING_SEEK_RATE, 0, 10000);
-    homing_feed_rate    = new FloatSetting(GRBL, WG, "24", "Homing/Feed", DEFAULT_HOMING_FEED_RATE, 0, 10000);
-    homing_squared_axes = new AxisMaskSetting(EXTENDED, WG, NULL, "Homing/Squared", DEFAULT_HOMING_SQUARED_AXES);
+    homing_pulloff       = new FloatSetting(GRBL, WG, "27", "Homing/Pulloff", DEFAULT_HOMING_PULLOFF, 0, 1000);
+    homing_debounce      = new FloatSetting(GRBL, WG, "26", "Homing/Debounce", DEFAULT_HOMING_DEBOUNCE_DELAY, 0, 10000);
+    homing_seek_rate     = new FloatSetting(GRBL, WG, "25", "Homing/Seek", DEFAULT_HOMING_SEEK_RATE, 0, 10000);
+    homing_feed_rate     = new FloatSetting(GRBL, WG, "24", "Homing/Feed", DEFAULT_HOMING_FEED_RATE, 0, 10000);
+    homing_squared_axes  = new AxisMaskSetting(EXTENDED, WG, NULL, "Homing/Squared", DEFAULT_HOMING_SQUARED_AXES);
+    homing_parallel_axes = new AxisMaskSetting(EXTENDED, WG, NULL, "Homing/Parallel", DEFAULT_HOMING_PARALLEL_AXES);
+    homing_fast_ref      = new FlagSetting(EXTENDED, WG, NULL, "Homing/FastRef", DEFAULT_HOMING_FAST_REF);
 
     // TODO Settings - need to call st_generate_step_invert_masks()
     homing_dir_mask = new AxisMaskSetting(GRBL, WG, "23", "Homing/DirInvert", DEFAULT_HOMING_DIR_MASK);
@@ -390,7 +697,7 @@ void make_settings() {
     report_inches = new FlagSetting(GRBL, WG, "13", "Report/Inches", DEFAULT_REPORT_INCHES);
     // TODO Settings - also need to clear, but not set, soft_limits
     arc_tolerance      = new FloatSetting(GRBL, WG, "12", "GCode/ArcTolerance", DEFAULT_ARC_TOLERANCE, 0, 1);
-    junction_deviation = new FloatSetting(GRBL, WG, "11", "GCode/JunctionDeviation", DEFAULT_JUNCTION_DEVIATION, 0, 10);
+    junction_deviation = new FloatSetting(GRBL, WG, "11", "GCode/JunctionDeviation", DEFAULT_JUNCTION_DEVIATION, 0, 10, postPlannerSetting);
     status_mask        = new IntSetting(GRBL, WG, "10", "Report/Status", DEFAULT_STATUS_REPORT_MASK, 0, 3);
 
     probe_invert                 = new FlagSetting(GRBL, WG, "6", "Probe/Invert", DEFAULT_INVERT_PROBE_PIN);
@@ -399,11 +706,106 @@ void make_settings() {
     dir_invert_mask              = new AxisMaskSetting(GRBL, WG, "3", "Stepper/DirInvert", DEFAULT_DIRECTION_INVERT_MASK, postMotorSetting);
     step_invert_mask             = new AxisMaskSetting(GRBL, WG, "2", "Stepper/StepInvert", DEFAULT_STEPPING_INVERT_MASK, postMotorSetting);
     stepper_idle_lock_time       = new IntSetting(GRBL, WG, "1", "Stepper/IdleTime", DEFAULT_STEPPER_IDLE_LOCK_TIME, 0, 255);
-    pulse_microseconds           = new IntSetting(GRBL, WG, "0", "Stepper/Pulse", DEFAULT_STEP_PULSE_MICROSECONDS, 3, 1000);
-    direction_delay_microseconds = new IntSetting(EXTENDED, WG, NULL, "Stepper/Direction/Delay", STEP_PULSE_DELAY, 0, 1000);
+    pulse_microseconds           = new IntSetting(GRBL, WG, "0", "Stepper/Pulse", DEFAULT_STEP_PULSE_MICROSECONDS, 3, 1000, postStepperSetting);
+    direction_delay_microseconds = new IntSetting(EXTENDED, WG, NULL, "Stepper/Direction/Delay", STEP_PULSE_DELAY, 0, 1000, postStepperSetting);
     enable_delay_microseconds = new IntSetting(EXTENDED, WG, NULL, "Stepper/Enable/Delay", DEFAULT_STEP_ENABLE_DELAY, 0, 1000);  // microseconds
+    // Take effect after a restart. Boot messages are always sent at BAUD_RATE.
+    serial_baud         = new IntSetting(EXTENDED, WG, NULL, "Serial/Baud", DEFAULT_SERIAL_BAUD, 9600, 2000000);
+    serial_flow_control = new FlagSetting(EXTENDED, WG, NULL, "Serial/FlowControl", DEFAULT_SERIAL_FLOW_CONTROL);
+    // Takes effect after a restart because the buffers are allocated at boot
+    stepper_segment_buffer_size = new IntSetting(EXTENDED, WG, NULL, "Stepper/SegmentBuffer", SEGMENT_BUFFER_SIZE, 3, 128);
+    planner_block_buffer_size   = new IntSetting(EXTENDED, WG, NULL, "Planner/BlockBuffer", BLOCK_BUFFER_SIZE, 8, 255);
+    planner_use_psram           = new FlagSetting(EXTENDED, WG, NULL, "Planner/BlockBuffer/PSRAM", true);
+    // Blocks revisited per new block before the rest of the pass is deferred to idle time, 0 for no limit
+    planner_recalculate_limit = new IntSetting(EXTENDED, WG, NULL, "Planner/RecalculateLimit", DEFAULT_PLANNER_RECALCULATE_LIMIT, 0, 255);
+    // Chord tolerance for merging colinear segments into one block, 0 to disable
+    planner_merge_tolerance = new FloatSetting(EXTENDED, WG, NULL, "Planner/MergeTolerance", DEFAULT_PLANNER_MERGE_TOLERANCE, 0.0, 1.0);
+    // Deviation within which runs of G1 chords are replaced by one arc, 0 to disable
+    planner_arc_fit_tolerance = new FloatSetting(
+        EXTENDED, WG, NULL, "Planner/ArcFitTolerance", DEFAULT_PLANNER_ARC_FIT_TOLERANCE, 0.0, 1.0);
+    // Distance within which a cached inverse kinematics result is reused, 0 to disable
+    kinematics_cache_tolerance = new FloatSetting(
+        EXTENDED, WG, NULL, "Kinematics/CacheTolerance", DEFAULT_KINEMATICS_CACHE_TOLERANCE, 0.0, 1.0, postKinematicsCacheSetting);
+    // Deviation from the line allowed when kinematics choose how many segments to split it into, 0 to disable
+    kinematics_tolerance = new FloatSetting(EXTENDED, WG, NULL, "Kinematics/Tolerance", DEFAULT_KINEMATICS_TOLERANCE, 0.0, 1.0);
+    heightmap_enable      = new FlagSetting(EXTENDED, WG, NULL, "HeightMap/Enable", DEFAULT_HEIGHTMAP_ENABLE);
+    heightmap_probe_feed  = new FloatSetting(EXTENDED, WG, NULL, "HeightMap/ProbeFeed", DEFAULT_HEIGHTMAP_PROBE_FEED, 1.0, 10000.0);
+    heightmap_probe_depth = new FloatSetting(EXTENDED, WG, NULL, "HeightMap/ProbeDepth", DEFAULT_HEIGHTMAP_PROBE_DEPTH, 0.1, 100.0);
+
+    // Used by the $Probe/ routines. Bore, boss and edge distances are given with each command.
+    probe_feed  = new FloatSetting(EXTENDED, WG, NULL, "Probe/Feed", DEFAULT_PROBE_FEED, 1.0, 10000.0);
+    probe_depth = new FloatSetting(EXTENDED, WG, NULL, "Probe/Depth", DEFAULT_PROBE_DEPTH, 0.1, 100.0);
+
+    // The M6 tool changer, see ToolTable.cpp. Positions are machine coordinates. The slow touch
+    // on the tool setter is at $Probe/Feed.
+    atc_enable           = new FlagSetting(EXTENDED, WG, NULL, "ATC/Enable", DEFAULT_ATC_ENABLE);
+    atc_safe_z           = new FloatSetting(EXTENDED, WG, NULL, "ATC/SafeZ", DEFAULT_ATC_SAFE_Z, -10000.0, 10000.0);
+    atc_clearance        = new FloatSetting(EXTENDED, WG, NULL, "ATC/Clearance", DEFAULT_ATC_CLEARANCE, 0.0, 1000.0);
+    atc_feed             = new FloatSetting(EXTENDED, WG, NULL, "ATC/Feed", DEFAULT_ATC_FEED, 1.0, 100000.0);
+    atc_drawbar          = new IntSetting(EXTENDED, WG, NULL, "ATC/Drawbar", DEFAULT_ATC_DRAWBAR, -1, MaxUserDigitalPin - 1);
+    atc_drawbar_delay    = new FloatSetting(EXTENDED, WG, NULL, "ATC/DrawbarDelay", DEFAULT_ATC_DRAWBAR_DELAY, 0.0, 10.0);
+    atc_measure_length   = new FlagSetting(EXTENDED, WG, NULL, "ATC/Measure", DEFAULT_ATC_MEASURE);
+    atc_setter_x         = new FloatSetting(EXTENDED, WG, NULL, "ATC/Setter/X", DEFAULT_ATC_SETTER_X, -10000.0, 10000.0);
+    atc_setter_y         = new FloatSetting(EXTENDED, WG, NULL, "ATC/Setter/Y", DEFAULT_ATC_SETTER_Y, -10000.0, 10000.0);
+    atc_setter_z         = new FloatSetting(EXTENDED, WG, NULL, "ATC/Setter/Z", DEFAULT_ATC_SETTER_Z, -10000.0, 10000.0);
+    atc_setter_depth     = new FloatSetting(EXTENDED, WG, NULL, "ATC/Setter/Depth", DEFAULT_ATC_SETTER_DEPTH, 0.1, 1000.0);
+    atc_setter_feed      = new FloatSetting(EXTENDED, WG, NULL, "ATC/Setter/Feed", DEFAULT_ATC_SETTER_FEED, 1.0, 10000.0);
+    atc_setter_reference = new FloatSetting(EXTENDED, WG, NULL, "ATC/Setter/Reference", DEFAULT_ATC_SETTER_REFERENCE, -10000.0, 10000.0);
+    // name:core:priority entries for the tasks that may be moved, see TaskStats.h. Priorities
+    // change at once, cores at the next restart.
+    task_placement_list = new StringSetting(EXTENDED, WG, NULL, "Tasks/Placement", "", checkTaskPlacement);
+#ifdef ENABLE_SD_CARD
+    // Run SD files from compiled copies, made the first time a file is run
+    sd_binary_cache = new FlagSetting(EXTENDED, WG, NULL, "SD/BinaryCache", DEFAULT_SD_BINARY_CACHE);
+    // Scan SD files before running them, for progress and ETA by time in status reports
+    sd_estimate_time = new FlagSetting(EXTENDED, WG, NULL, "SD/EstimateTime", DEFAULT_SD_ESTIMATE_TIME);
+    // Write a toolpath preview beside each file uploaded to the card over HTTP
+    sd_preview = new FlagSetting(EXTENDED, WG, NULL, "SD/Preview", DEFAULT_SD_PREVIEW);
+    // Milliseconds between the records of the performance log written beside each SD job, 0 for none
+    sd_job_log_period = new IntSetting(EXTENDED, WG, NULL, "SD/JobLog", DEFAULT_SD_JOB_LOG_PERIOD, 0, 10000);
+    // Used from the next mount, normally the next SD command
+    sd_bus           = new EnumSetting(NULL, EXTENDED, WG, NULL, "SD/Bus", DEFAULT_SD_BUS, &sdBuses, postSDSetting);
+    sd_spi_frequency = new IntSetting(EXTENDED, WG, NULL, "SD/SPI/Frequency", DEFAULT_SD_SPI_FREQUENCY, 400, 40000, postSDSetting);  // kHz
+#endif
+#ifdef USE_I2S_STEPS
+    // The DMA buffers are reallocated only while not streaming steps, or else at the next restart
+    i2s_dmabuf_count = new IntSetting(
+        EXTENDED, WG, NULL, "Stepper/I2S/DMABufferCount", I2S_OUT_DMABUF_COUNT, I2S_OUT_DMABUF_COUNT_MIN, I2S_OUT_DMABUF_COUNT_MAX, postI2SSetting);
+    i2s_dmabuf_len = new IntSetting(
+        EXTENDED, WG, NULL, "Stepper/I2S/DMABufferLength", I2S_OUT_DMABUF_LEN, I2S_OUT_DMABUF_LEN_MIN, I2S_OUT_DMABUF_LEN_MAX, postI2SSetting);
+    i2s_adaptive_latency = new FlagSetting(EXTENDED, WG, NULL, "Stepper/I2S/AdaptiveLatency", false, postI2SSetting);
+    // Keep the DMA stream running between motions instead of switching to the static mode
+    i2s_unified = new FlagSetting(EXTENDED, WG, NULL, "Stepper/I2S/Unified", false, postI2SSetting);
+#endif
+#ifdef POSITION_CAPTURE
+    // Samples a second of motion, used from the next $Capture
+    capture_rate = new IntSetting(EXTENDED, WG, NULL, "Capture/Rate", DEFAULT_CAPTURE_RATE, 10, 20000);
+#endif
 
     stallguard_debug_mask = new AxisMaskSetting(EXTENDED, WG, NULL, "Report/StallGuard", 0, postMotorSetting);
+    stallguard_monitor_mask =
+        new AxisMaskSetting(EXTENDED, WG, NULL, "StallGuard/Monitor", DEFAULT_STALLGUARD_MONITOR_MASK, postMotorSetting);
+    stallguard_monitor_period = new IntSetting(EXTENDED, WG, NULL, "StallGuard/Period", DEFAULT_STALLGUARD_MONITOR_PERIOD, 1, 200);
+    stallguard_monitor_drop   = new IntSetting(EXTENDED, WG, NULL, "StallGuard/Drop", DEFAULT_STALLGUARD_MONITOR_DROP, 10, 90);
+
+#ifdef AXIS_ENCODERS
+    // The encoders are read at boot, but these take effect right away
+    encoder_tolerance = new FloatSetting(EXTENDED, WG, NULL, "Encoder/Tolerance", DEFAULT_ENCODER_TOLERANCE, 0.0, 100.0);  // mm, 0 is off
+    encoder_action    = new EnumSetting(NULL, EXTENDED, WG, NULL, "Encoder/Action", DEFAULT_ENCODER_ACTION, &encoderActions, NULL);
+#endif
+
+#ifdef ENABLE_ESP_NOW_SYNC
+    // Take effect at once; ESP-NOW starts when WiFi is up
+    sync_role_setting = new EnumSetting(NULL, EXTENDED, WG, NULL, "Sync/Role", DEFAULT_SYNC_ROLE, &syncRoles, NULL);
+    sync_group        = new IntSetting(EXTENDED, WG, NULL, "Sync/Group", DEFAULT_SYNC_GROUP, 0, 255);
+#endif
+
+#ifdef INPUT_SHAPING
+    // Read at the start of every acceleration and deceleration ramp
+    shaper_type      = new EnumSetting(NULL, EXTENDED, WG, NULL, "Shaper/Type", DEFAULT_SHAPER_TYPE, &inputShapers, NULL);
+    shaper_frequency = new FloatSetting(EXTENDED, WG, NULL, "Shaper/Frequency", DEFAULT_SHAPER_FREQUENCY, 1.0, 500.0);  // Hz
+    shaper_damping   = new FloatSetting(EXTENDED, WG, NULL, "Shaper/Damping", DEFAULT_SHAPER_DAMPING, 0.0, 0.9);        // damping ratio
+#endif
 
     homing_cycle[5] = new AxisMaskSetting(EXTENDED, WG, NULL, "Homing/Cycle5", DEFAULT_HOMING_CYCLE_5);
     homing_cycle[4] = new AxisMaskSetting(EXTENDED, WG, NULL, "Homing/Cycle4", DEFAULT_HOMING_CYCLE_4);
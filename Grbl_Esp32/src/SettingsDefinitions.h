@@ -20,11 +20,66 @@ extern IntSetting* pulse_microseconds;
 extern IntSetting* stepper_idle_lock_time;
 extern IntSetting* direction_delay_microseconds;
 extern IntSetting* enable_delay_microseconds;
+extern IntSetting* stepper_segment_buffer_size;
+
+extern IntSetting*   planner_block_buffer_size;
+extern FlagSetting*  planner_use_psram;
+extern IntSetting*   planner_recalculate_limit;
+extern FloatSetting* planner_merge_tolerance;
+extern FloatSetting* planner_arc_fit_tolerance;
+extern FloatSetting* kinematics_cache_tolerance;
+extern FloatSetting* kinematics_tolerance;
+
+extern IntSetting*  serial_baud;
+extern FlagSetting* serial_flow_control;
+
+extern StringSetting* task_placement_list;
+
+extern FlagSetting*  heightmap_enable;
+extern FloatSetting* heightmap_probe_feed;
+extern FloatSetting* heightmap_probe_depth;
+
+extern FloatSetting* probe_feed;
+extern FloatSetting* probe_depth;
+
+extern FlagSetting*  atc_enable;
+extern FloatSetting* atc_safe_z;
+extern FloatSetting* atc_clearance;
+extern FloatSetting* atc_feed;
+extern IntSetting*   atc_drawbar;
+extern FloatSetting* atc_drawbar_delay;
+extern FlagSetting*  atc_measure_length;
+extern FloatSetting* atc_setter_x;
+extern FloatSetting* atc_setter_y;
+extern FloatSetting* atc_setter_z;
+extern FloatSetting* atc_setter_depth;
+extern FloatSetting* atc_setter_feed;
+extern FloatSetting* atc_setter_reference;
+
+extern FlagSetting* sd_binary_cache;
+extern FlagSetting* sd_estimate_time;
+extern FlagSetting* sd_preview;
+extern IntSetting*  sd_job_log_period;
+extern EnumSetting* sd_bus;
+extern IntSetting*  sd_spi_frequency;
+
+#ifdef USE_I2S_STEPS
+extern IntSetting*  i2s_dmabuf_count;
+extern IntSetting*  i2s_dmabuf_len;
+extern FlagSetting* i2s_adaptive_latency;
+extern FlagSetting* i2s_unified;
+#endif
+
+#ifdef POSITION_CAPTURE
+extern IntSetting* capture_rate;
+#endif
 
 extern AxisMaskSetting* step_invert_mask;
 extern AxisMaskSetting* dir_invert_mask;
 extern AxisMaskSetting* homing_dir_mask;
 extern AxisMaskSetting* homing_squared_axes;
+extern AxisMaskSetting* homing_parallel_axes;
+extern FlagSetting*     homing_fast_ref;
 extern AxisMaskSetting* homing_cycle[MAX_N_AXIS];
 
 extern FlagSetting* step_enable_invert;
@@ -55,14 +110,43 @@ extern FlagSetting*  spindle_enbl_off_with_zero_speed;
 extern FlagSetting*  spindle_enable_invert;
 extern FlagSetting*  spindle_output_invert;
 
-extern FloatSetting* spindle_pwm_off_value;
-extern FloatSetting* spindle_pwm_min_value;
-extern FloatSetting* spindle_pwm_max_value;
-extern IntSetting*   spindle_pwm_bit_precision;
+extern FlagSetting*  spindle_adaptive_enable;
+extern FloatSetting* spindle_adaptive_target;
+extern FloatSetting* spindle_adaptive_idle;
+extern IntSetting*   spindle_adaptive_min;
+extern IntSetting*   spindle_adaptive_max;
+extern FloatSetting* spindle_adaptive_gain;
+
+extern FloatSetting*  spindle_pwm_off_value;
+extern StringSetting* spindle_pwm_curve;
+extern FloatSetting*  spindle_pwm_ramp;
+extern FloatSetting*  spindle_pwm_min_value;
+extern FloatSetting*  spindle_pwm_max_value;
+extern IntSetting*    spindle_pwm_bit_precision;
 
 extern EnumSetting* spindle_type;
+extern EnumSetting* spindle_alt_type;
 
 extern AxisMaskSetting* stallguard_debug_mask;
+extern AxisMaskSetting* stallguard_monitor_mask;
+extern IntSetting*      stallguard_monitor_period;
+extern IntSetting*      stallguard_monitor_drop;
+
+#ifdef AXIS_ENCODERS
+extern FloatSetting* encoder_tolerance;
+extern EnumSetting*  encoder_action;
+#endif
+
+#ifdef ENABLE_ESP_NOW_SYNC
+extern EnumSetting* sync_role_setting;
+extern IntSetting*  sync_group;
+#endif
+
+#ifdef INPUT_SHAPING
+extern EnumSetting*  shaper_type;
+extern FloatSetting* shaper_frequency;
+extern FloatSetting* shaper_damping;
+#endif
 
 extern StringSetting* user_macro0;
 extern StringSetting* user_macro1;
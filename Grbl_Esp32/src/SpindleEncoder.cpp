@@ -0,0 +1,127 @@
+/*
+  SpindleEncoder.cpp - Spindle position from a quadrature encoder, for G33 and G33.1
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The PCNT counter is 16 bits. It is cleared at +/-SPINDLE_ENCODER_LIMIT and the interrupt
+  keeps the number of wraps, so a count is wraps * SPINDLE_ENCODER_LIMIT plus the counter.
+*/
+
+#include "Grbl.h"
+
+#ifdef SPINDLE_SYNC
+
+#    include <driver/pcnt.h>
+#    include <soc/pcnt_struct.h>
+#    include <esp_timer.h>
+
+static const pcnt_unit_t SPINDLE_ENCODER_UNIT      = PCNT_UNIT_0;
+static const int16_t     SPINDLE_ENCODER_LIMIT     = 30000;
+static const uint16_t    SPINDLE_ENCODER_FILTER    = 100;   // APB clock cycles, glitches shorter than this are ignored
+static const int         SPINDLE_ENCODER_SAMPLE_US = 5000;  // Speed sample period
+static const int         SPINDLE_ENCODER_SAMPLES   = 4;     // The speed is taken over this many periods
+
+static volatile int32_t encoder_wraps = 0;
+static volatile float   encoder_rpm   = 0.0f;
+
+static void IRAM_ATTR spindle_encoder_isr(void* arg) {
+    if (PCNT.int_st.val & BIT(SPINDLE_ENCODER_UNIT)) {
+        uint32_t status = PCNT.status_unit[SPINDLE_ENCODER_UNIT].val;
+        if (status & PCNT_STATUS_H_LIM_M) {
+            encoder_wraps = encoder_wraps + 1;
+        } else if (status & PCNT_STATUS_L_LIM_M) {
+            encoder_wraps = encoder_wraps - 1;
+        }
+        PCNT.int_clr.val = BIT(SPINDLE_ENCODER_UNIT);
+    }
+}
+
+int64_t spindle_encoder_count() {
+    int32_t wraps;
+    int16_t counter;
+    // A wrap that the interrupt has not counted yet would be off by a whole limit, so
+    // read again until there is none pending.
+    do {
+        wraps = encoder_wraps;
+        pcnt_get_counter_value(SPINDLE_ENCODER_UNIT, &counter);
+    } while (wraps != encoder_wraps || (PCNT.int_raw.val & BIT(SPINDLE_ENCODER_UNIT)));
+    return int64_t(wraps) * SPINDLE_ENCODER_LIMIT + counter;
+}
+
+float spindle_encoder_rpm() {
+    return encoder_rpm;
+}
+
+static void spindle_encoder_sample(void* arg) {
+    static int64_t counts[SPINDLE_ENCODER_SAMPLES];
+    static int64_t times[SPINDLE_ENCODER_SAMPLES];
+    static int     oldest = 0;
+
+    int64_t count = spindle_encoder_count();
+    int64_t now   = esp_timer_get_time();
+    if (now > times[oldest]) {
+        encoder_rpm = float(count - counts[oldest]) * (60e6f / SPINDLE_ENCODER_CPR) / float(now - times[oldest]);
+    }
+    counts[oldest] = count;
+    times[oldest]  = now;
+    oldest         = (oldest + 1) % SPINDLE_ENCODER_SAMPLES;
+}
+
+void spindle_encoder_init() {
+    // Both edges of both channels: A counts with B as its direction and the other way round.
+    pcnt_config_t config = {};
+    config.pulse_gpio_num = SPINDLE_ENCODER_A_PIN;
+    config.ctrl_gpio_num  = SPINDLE_ENCODER_B_PIN;
+    config.channel        = PCNT_CHANNEL_0;
+    config.unit           = SPINDLE_ENCODER_UNIT;
+    config.pos_mode       = PCNT_COUNT_DEC;
+    config.neg_mode       = PCNT_COUNT_INC;
+    config.lctrl_mode     = PCNT_MODE_KEEP;
+    config.hctrl_mode     = PCNT_MODE_REVERSE;
+    config.counter_h_lim  = SPINDLE_ENCODER_LIMIT;
+    config.counter_l_lim  = -SPINDLE_ENCODER_LIMIT;
+    pcnt_unit_config(&config);
+
+    config.pulse_gpio_num = SPINDLE_ENCODER_B_PIN;
+    config.ctrl_gpio_num  = SPINDLE_ENCODER_A_PIN;
+    config.channel        = PCNT_CHANNEL_1;
+    config.pos_mode       = PCNT_COUNT_INC;
+    config.neg_mode       = PCNT_COUNT_DEC;
+    pcnt_unit_config(&config);
+
+    pcnt_set_filter_value(SPINDLE_ENCODER_UNIT, SPINDLE_ENCODER_FILTER);
+    pcnt_filter_enable(SPINDLE_ENCODER_UNIT);
+    pcnt_event_enable(SPINDLE_ENCODER_UNIT, PCNT_EVT_H_LIM);
+    pcnt_event_enable(SPINDLE_ENCODER_UNIT, PCNT_EVT_L_LIM);
+    pcnt_counter_pause(SPINDLE_ENCODER_UNIT);
+    pcnt_counter_clear(SPINDLE_ENCODER_UNIT);
+    pcnt_isr_register(spindle_encoder_isr, NULL, 0, NULL);
+    pcnt_intr_enable(SPINDLE_ENCODER_UNIT);
+    pcnt_counter_resume(SPINDLE_ENCODER_UNIT);
+
+    esp_timer_create_args_t sampler = {};
+    sampler.callback                = spindle_encoder_sample;
+    sampler.name                    = "spindle_encoder";
+    esp_timer_handle_t handle;
+    esp_timer_create(&sampler, &handle);
+    esp_timer_start_periodic(handle, SPINDLE_ENCODER_SAMPLE_US);
+
+    grbl_msg_sendf(CLIENT_SERIAL,
+                   MsgLevel::Info,
+                   "Spindle encoder A:%s B:%s %d lines",
+                   pinName(SPINDLE_ENCODER_A_PIN).c_str(),
+                   pinName(SPINDLE_ENCODER_B_PIN).c_str(),
+                   SPINDLE_ENCODER_PPR);
+}
+
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+
+/*
+  SpindleEncoder.h - Spindle position from a quadrature encoder, for G33 and G33.1
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdint>
+
+#ifdef SPINDLE_SYNC
+
+// Lines per revolution of the encoder. It is counted on both edges of both channels.
+#    ifndef SPINDLE_ENCODER_PPR
+#        define SPINDLE_ENCODER_PPR 1024
+#    endif
+const int32_t SPINDLE_ENCODER_CPR = 4 * SPINDLE_ENCODER_PPR;
+
+// Starts counting on a PCNT unit and sampling the speed.
+void spindle_encoder_init();
+
+// Counts since power up. Signed; which way is positive depends on the wiring, and nothing
+// relies on it.
+int64_t spindle_encoder_count();
+
+// Signed speed in the same sense, over the last few milliseconds.
+float spindle_encoder_rpm();
+
+#endif
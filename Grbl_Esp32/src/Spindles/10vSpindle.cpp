@@ -42,6 +42,8 @@ namespace Spindles {
 #else
         _reverse_pin = UNDEFINED_PIN;
 #endif
+        _forward_handle = PinHandle(_forward_pin);
+        _reverse_handle = PinHandle(_reverse_pin);
 
         if (_output_pin == UNDEFINED_PIN) {
             grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "Warning: Spindle output pin not defined");
@@ -103,7 +105,7 @@ namespace Spindles {
             pwm_value = map_uint32_t(rpm, _min_rpm, _max_rpm, _pwm_min_value, _pwm_max_value);
         }
 
-        set_output(pwm_value);
+        ramp_output(pwm_value);
         return rpm;
     }
 
@@ -132,7 +134,7 @@ namespace Spindles {
             return SpindleState::Disable;
         }
         if (_direction_pin != UNDEFINED_PIN) {
-            return digitalRead(_direction_pin) ? SpindleState::Cw : SpindleState::Ccw;
+            return _direction_handle.read() ? SpindleState::Cw : SpindleState::Ccw;
         }
         return SpindleState::Cw;
     }
@@ -152,20 +154,20 @@ namespace Spindles {
             enable = !enable;
         }
 
-        digitalWrite(_enable_pin, enable);
+        _enable_handle.write(enable);
 
         // turn off anything that acts like an enable
         if (!enable) {
-            digitalWrite(_direction_pin, enable);
-            digitalWrite(_forward_pin, enable);
-            digitalWrite(_reverse_pin, enable);
+            _direction_handle.write(enable);
+            _forward_handle.write(enable);
+            _reverse_handle.write(enable);
         }
     }
 
     void _10v::set_dir_pin(bool Clockwise) {
-        digitalWrite(_direction_pin, Clockwise);
-        digitalWrite(_forward_pin, Clockwise);
-        digitalWrite(_reverse_pin, !Clockwise);
+        _direction_handle.write(Clockwise);
+        _forward_handle.write(Clockwise);
+        _reverse_handle.write(!Clockwise);
     }
 
     void _10v::deinit() {
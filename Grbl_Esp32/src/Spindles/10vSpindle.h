@@ -52,6 +52,10 @@ namespace Spindles {
         uint8_t _forward_pin;
         uint8_t _reverse_pin;
 
+    private:
+        PinHandle _forward_handle;
+        PinHandle _reverse_handle;
+
     protected:
         void set_enable_pin(bool enable_pin) override;
         void set_dir_pin(bool Clockwise) override;
@@ -62,6 +62,8 @@ namespace Spindles {
         // override some settings to what is required for a BESC
         _pwm_freq      = (uint32_t)BESC_PWM_FREQ;
         _pwm_precision = 16;
+        _pwm_period    = 1 << _pwm_precision;
+        _ramp_cycles   = spindle_pwm_ramp->get() * _pwm_freq;
 
         // override these settings
         _pwm_off_value = BESC_MIN_PULSE_CNT;
@@ -117,7 +119,7 @@ namespace Spindles {
             pwm_value = map_uint32_t(rpm, _min_rpm, _max_rpm, _pwm_min_value, _pwm_max_value);
         }
 
-        set_output(pwm_value);
+        ramp_output(pwm_value);
         return rpm;
     }
 }
@@ -384,4 +384,26 @@ namespace Spindles {
             return true;
         };
     }
+
+    VFD::response_parser Huanyang::get_current_load(ModbusCommand& data) {
+        // NOTE: data length is excluding the CRC16 checksum.
+        data.tx_length = 6;
+        data.rx_length = 6;
+
+        // data.msg[0] is omitted (modbus address is filled in later)
+        data.msg[1] = 0x04;
+        data.msg[2] = 0x03;
+        data.msg[3] = 0x02;  // Output current
+        data.msg[4] = 0x00;
+        data.msg[5] = 0x00;
+
+        // Recv: 01 04 03 02 00 2A = 4.2 A
+        return [](const uint8_t* response, Spindles::VFD* vfd) -> bool {
+            uint16_t current = (response[4] << 8) | response[5];
+
+            vfd->_load = current * 0.1f;
+            ++vfd->_load_count;
+            return true;
+        };
+    }
 }
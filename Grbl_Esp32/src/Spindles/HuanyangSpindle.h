@@ -41,6 +41,7 @@ namespace Spindles {
         response_parser initialization_sequence(int index, ModbusCommand& data) override;
         response_parser get_status_ok(ModbusCommand& data) override;
         response_parser get_current_rpm(ModbusCommand& data) override;
+        response_parser get_current_load(ModbusCommand& data) override;
 
         bool supports_actual_rpm() const override { return true; }
 
@@ -83,6 +83,8 @@ namespace Spindles {
 
         _piecewide_linear = false;
 
+        build_curve();
+
         _pwm_chan_num = 0;  // Channel 0 is reserved for spindle use
     }
 
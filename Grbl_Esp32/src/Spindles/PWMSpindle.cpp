@@ -80,6 +80,8 @@ namespace Spindles {
 #else
         _direction_pin    = UNDEFINED_PIN;
 #endif
+        _enable_handle    = PinHandle(_enable_pin);
+        _direction_handle = PinHandle(_direction_pin);
 
         if (_output_pin == UNDEFINED_PIN) {
             grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "Warning: SPINDLE_OUTPUT_PIN not defined");
@@ -113,10 +115,13 @@ namespace Spindles {
         // The pwm_gradient is the pwm duty cycle units per rpm
         // _pwm_gradient = (_pwm_max_value - _pwm_min_value) / (_max_rpm - _min_rpm);
 
+        build_curve();
+
         _pwm_chan_num = 0;  // Channel 0 is reserved for spindle use
 
         _spinup_delay   = spindle_delay_spinup->get() * 1000.0;
         _spindown_delay = spindle_delay_spindown->get() * 1000.0;
+        _ramp_cycles    = spindle_pwm_ramp->get() * _pwm_freq;
     }
 
     uint32_t PWM::set_rpm(uint32_t rpm) {
@@ -146,34 +151,109 @@ namespace Spindles {
         } else {
             if (rpm == 0) {
                 pwm_value = _pwm_off_value;
+            } else if (_curve_rate) {
+                pwm_value = curve_pwm(rpm);
             } else {
                 pwm_value = map_uint32_t(rpm, _min_rpm, _max_rpm, _pwm_min_value, _pwm_max_value);
             }
         }
 
         set_enable_pin(gc_state.modal.spindle != SpindleState::Disable);
-        set_output(pwm_value);
+        ramp_output(pwm_value);
 
         return 0;
     }
 
+    int PWM::parse_curve(const char* text, float* power, float* duty) {
+        int count = 0;
+        while (*text) {
+            char* end;
+            if (count == CURVE_MAX_POINTS) {
+                return -1;
+            }
+            power[count] = strtof(text, &end);
+            if (end == text || *end != ':') {
+                return -1;
+            }
+            text        = end + 1;
+            duty[count] = strtof(text, &end);
+            if (end == text || (*end && *end != ',')) {
+                return -1;
+            }
+            text = *end ? end + 1 : end;
+            if (power[count] < 0.0 || power[count] > 100.0 || duty[count] < 0.0 || duty[count] > 100.0) {
+                return -1;
+            }
+            if (count && power[count] <= power[count - 1]) {
+                return -1;
+            }
+            count++;
+        }
+        return count;
+    }
+
+    void PWM::build_curve() {
+        float power[CURVE_MAX_POINTS], duty[CURVE_MAX_POINTS];
+        int   count = parse_curve(spindle_pwm_curve->get(), power, duty);
+        _curve_rate = 0;
+        if (count <= 0 || _min_rpm >= _max_rpm) {
+            return;  // Linear
+        }
+        int point = 0;
+        for (int i = 0; i <= CURVE_STEPS; i++) {
+            float x = 100.0 * i / CURVE_STEPS;
+            while (point < count - 1 && power[point + 1] <= x) {
+                point++;
+            }
+            float y;
+            if (x <= power[0]) {
+                y = duty[0];
+            } else if (point == count - 1) {
+                y = duty[count - 1];
+            } else {
+                y = duty[point] + (duty[point + 1] - duty[point]) * (x - power[point]) / (power[point + 1] - power[point]);
+            }
+            _pwm_curve[i] = _pwm_min_value + (_pwm_max_value - float(_pwm_min_value)) * y / 100.0;
+        }
+        _curve_rate = (uint32_t(CURVE_STEPS) << 24) / (_max_rpm - _min_rpm);
+    }
+
+    // rpm is within the limits
+    uint32_t PWM::curve_pwm(uint32_t rpm) {
+        uint32_t position = ((rpm - _min_rpm) * _curve_rate) >> 16;
+        uint32_t i        = position >> 8;
+        if (i >= CURVE_STEPS) {
+            return _pwm_curve[CURVE_STEPS];
+        }
+        int32_t low  = _pwm_curve[i];
+        int32_t high = _pwm_curve[i + 1];
+        return low + (((high - low) * int32_t(position & 0xff)) >> 8);
+    }
+
     void PWM::set_state(SpindleState state, uint32_t rpm) {
         if (sys.abort) {
             return;  // Block during abort.
         }
 
+        // A ramped spindle needs at least the time of the fade to get there.
         if (state == SpindleState::Disable) {  // Halt or set spindle direction and rpm.
             sys.spindle_speed = 0;
+            _ramp_ms          = 0;
+            if (_ramp_cycles && _current_state != state) {
+                ramp_output(_pwm_off_value);  // Spin down gently, then switch off
+                delay(_ramp_ms);
+            }
             stop();
             if (use_delays && (_current_state != state)) {
-                delay(_spinup_delay);
+                delay(_ramp_ms < _spindown_delay ? _spindown_delay - _ramp_ms : 0);
             }
         } else {
             set_dir_pin(state == SpindleState::Cw);
+            _ramp_ms = 0;
             set_rpm(rpm);
             set_enable_pin(state != SpindleState::Disable);  // must be done after setting rpm for enable features to work
             if (use_delays && (_current_state != state)) {
-                delay(_spindown_delay);
+                delay(MAX(_spinup_delay, _ramp_ms));
             }
         }
 
@@ -187,7 +267,7 @@ namespace Spindles {
             return SpindleState::Disable;
         }
         if (_direction_pin != UNDEFINED_PIN) {
-            return digitalRead(_direction_pin) ? SpindleState::Cw : SpindleState::Ccw;
+            return _direction_handle.read() ? SpindleState::Cw : SpindleState::Ccw;
         }
         return SpindleState::Cw;
     }
@@ -232,11 +312,58 @@ namespace Spindles {
         // and ledcWrite uses RTOS features not compatible with ISRs
         LEDC.channel_group[0].channel[0].duty.duty        = duty << 4;
         bool on                                           = !!duty;
+        LEDC.channel_group[0].channel[0].conf1.duty_scale = 0;  // Cancels a fade from ramp_output()
+        LEDC.channel_group[0].channel[0].conf1.duty_num   = 1;
+        LEDC.channel_group[0].channel[0].conf1.duty_cycle = 1;
         LEDC.channel_group[0].channel[0].conf0.sig_out_en = on;
         LEDC.channel_group[0].channel[0].conf1.duty_start = on;
         LEDC.channel_group[0].channel[0].conf0.clk_en     = on;
     }
 
+    // The fade adds duty_scale to the duty every duty_cycle PWM periods, duty_num times. Those
+    // fields have 10 bits, so a large change takes bigger steps. The remainder of the steps is
+    // jumped at the start. It is all register writes, like set_output(), so it is safe in an ISR.
+    void PWM::ramp_output(uint32_t duty) {
+        const uint32_t LEDC_FADE_MAX = 1023;
+
+        if (_output_pin == UNDEFINED_PIN) {
+            return;
+        }
+        if (_ramp_cycles == 0 || inLaserMode()) {
+            set_output(duty);
+            return;
+        }
+        if (duty == _current_pwm_duty) {
+            return;
+        }
+        _current_pwm_duty = duty;
+
+        if (_invert_pwm) {
+            duty = (1 << _pwm_precision) - duty;
+        }
+        uint32_t from  = LEDC.channel_group[0].channel[0].duty_rd.duty_read >> 4;  // Where a fade in progress got to
+        bool     up    = duty > from;
+        uint32_t delta = up ? duty - from : from - duty;
+        if (delta == 0) {
+            return;
+        }
+        uint32_t scale  = delta / LEDC_FADE_MAX + 1;
+        uint32_t steps  = delta / scale;
+        uint64_t total  = uint64_t(_ramp_cycles) * delta / _pwm_period;
+        uint32_t cycles = total / steps;
+        cycles          = cycles < 1 ? 1 : (cycles > LEDC_FADE_MAX ? LEDC_FADE_MAX : cycles);
+        _ramp_ms        = uint64_t(cycles) * steps * 1000 / _pwm_freq;
+
+        LEDC.channel_group[0].channel[0].duty.duty        = (up ? duty - steps * scale : duty + steps * scale) << 4;
+        LEDC.channel_group[0].channel[0].conf1.duty_inc   = up;
+        LEDC.channel_group[0].channel[0].conf1.duty_scale = scale;
+        LEDC.channel_group[0].channel[0].conf1.duty_num   = steps;
+        LEDC.channel_group[0].channel[0].conf1.duty_cycle = cycles;
+        LEDC.channel_group[0].channel[0].conf0.sig_out_en = 1;
+        LEDC.channel_group[0].channel[0].conf0.clk_en     = 1;
+        LEDC.channel_group[0].channel[0].conf1.duty_start = 1;
+    }
+
     void PWM::set_enable_pin(bool enable) {
         // static bool prev_enable = false;
 
@@ -258,10 +385,10 @@ namespace Spindles {
             enable = !enable;
         }
 
-        digitalWrite(_enable_pin, enable);
+        _enable_handle.write(enable);
     }
 
-    void PWM::set_dir_pin(bool Clockwise) { digitalWrite(_direction_pin, Clockwise); }
+    void PWM::set_dir_pin(bool Clockwise) { _direction_handle.write(Clockwise); }
 
     /*
 		Calculate the highest precision of a PWM based on the frequency in bits
@@ -43,6 +43,16 @@ namespace Spindles {
 
         virtual ~PWM() {}
 
+        // $Spindle/PWM/Curve corrects a nonlinear response with a list of power:duty points in
+        // percent, such as "0:0,20:45,60:80,100:100". Power is a share of the speed range, $31
+        // to $30 or up to $Laser/FullPower, and duty a share of the PWM range, $35 to $36 or the
+        // full period for a laser. The power values must rise. The duty is interpolated between
+        // the points and held past the first and last.
+        static const int CURVE_MAX_POINTS = 16;
+
+        // Returns the number of points, 0 for an empty list or -1 if it is malformed.
+        static int parse_curve(const char* text, float* power, float* duty);
+
     protected:
         int32_t  _current_pwm_duty;
         uint32_t _min_rpm;
@@ -62,6 +72,26 @@ namespace Spindles {
         bool     _invert_pwm;
         //uint32_t _pwm_gradient; // Precalulated value to speed up rpm to PWM conversions.
 
+        // The enable and direction pins, resolved by get_pins_and_settings()
+        PinHandle _enable_handle;
+        PinHandle _direction_handle;
+
+        // The curve is precomputed into duty values at even steps over the rpm range, so a
+        // lookup is integer math only and fast enough for the stepper ISR.
+        static const int CURVE_STEPS = 64;
+        uint32_t         _pwm_curve[CURVE_STEPS + 1];
+        uint32_t         _curve_rate = 0;  // Table position per rpm, 8 fraction bits, times 2^16. 0 for linear.
+
+        void     build_curve();
+        uint32_t curve_pwm(uint32_t rpm);
+
+        // $Spindle/PWM/Ramp is the time from off to full duty. Changes are faded by the LEDC
+        // hardware at that rate, so the spindle accelerates gently at no CPU cost.
+        uint32_t _ramp_cycles = 0;  // PWM periods for a full range fade, 0 for none
+        uint32_t _ramp_ms     = 0;  // Length of the last fade
+
+        void ramp_output(uint32_t duty);
+
         virtual void set_dir_pin(bool Clockwise);
         virtual void set_output(uint32_t duty);
         virtual void set_enable_pin(bool enable_pin);
@@ -37,6 +37,7 @@ namespace Spindles {
         pinMode(_output_pin, OUTPUT);
         pinMode(_enable_pin, OUTPUT);
         pinMode(_direction_pin, OUTPUT);
+        _output_handle = PinHandle(_output_pin);
 
         is_reversable = (_direction_pin != UNDEFINED_PIN);
         use_delays    = true;
@@ -69,6 +70,6 @@ namespace Spindles {
 #ifdef INVERT_SPINDLE_PWM
         duty = (duty == 0);  // flip duty
 #endif
-        digitalWrite(_output_pin, duty > 0);  // anything greater
+        _output_handle.write(duty > 0);  // anything greater
     }
 }
@@ -42,5 +42,7 @@ namespace Spindles {
 
     protected:
         void set_output(uint32_t duty);
+
+        PinHandle _output_handle;
     };
 }
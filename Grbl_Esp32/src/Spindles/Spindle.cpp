@@ -41,57 +41,104 @@
 #include "YL620Spindle.h"
 
 namespace Spindles {
-    // An instance of each type of spindle is created here.
+    // An instance of each type of spindle is made here, the first time it is selected.
     // This allows the spindle to be dynamicly switched
-    Null     null;
-    PWM      pwm;
-    Relay    relay;
-    Laser    laser;
-    Dac      dac;
-    Huanyang huanyang;
-    H2A      h2a;
-    BESC     besc;
-    _10v     _10v;
-    YL620   yl620;
+    Null null;
+
+    Spindle* heads[Spindle::MAX_HEADS] = { &null, &null };
+
+    // A TINY_BUILD only has the types the machine definition names. The others are never
+    // made, so the linker leaves their code out.
+    static constexpr bool built_in(SpindleType type) {
+#ifdef TINY_BUILD
+        return type == SPINDLE_TYPE || type == SPINDLE_ALT_TYPE;
+#else
+        return true;
+#endif
+    }
 
-    void Spindle::select() {
-        switch (static_cast<SpindleType>(spindle_type->get())) {
+    template <typename T>
+    static Spindle* instance() {
+        static T spindle;
+        return &spindle;
+    }
+
+    static Spindle* of_type(SpindleType type) {
+        switch (type) {
             case SpindleType::PWM:
-                spindle = &pwm;
-                break;
+                return built_in(SpindleType::PWM) ? instance<PWM>() : nullptr;
             case SpindleType::RELAY:
-                spindle = &relay;
-                break;
+                return built_in(SpindleType::RELAY) ? instance<Relay>() : nullptr;
             case SpindleType::LASER:
-                spindle = &laser;
-                break;
+                return built_in(SpindleType::LASER) ? instance<Laser>() : nullptr;
             case SpindleType::DAC:
-                spindle = &dac;
-                break;
+                return built_in(SpindleType::DAC) ? instance<Dac>() : nullptr;
             case SpindleType::HUANYANG:
-                spindle = &huanyang;
-                break;
+                return built_in(SpindleType::HUANYANG) ? instance<Huanyang>() : nullptr;
             case SpindleType::BESC:
-                spindle = &besc;
-                break;
+                return built_in(SpindleType::BESC) ? instance<BESC>() : nullptr;
             case SpindleType::_10V:
-                spindle = &_10v;
-                break;
+                return built_in(SpindleType::_10V) ? instance<_10v>() : nullptr;
             case SpindleType::H2A:
-                spindle = &h2a;
-                break;
+                return built_in(SpindleType::H2A) ? instance<H2A>() : nullptr;
             case SpindleType::YL620:
-                spindle = &yl620;
-                break;
+                return built_in(SpindleType::YL620) ? instance<YL620>() : nullptr;
             case SpindleType::NONE:
             default:
-                spindle = &null;
-                break;
+                return &null;
+        }
+    }
+
+    static Spindle* of_setting(EnumSetting* setting) {
+        Spindle* head = of_type(static_cast<SpindleType>(setting->get()));
+        if (head == nullptr) {
+            grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "%s is not in this build", setting->getName());
+            head = &null;
+        }
+        return head;
+    }
+
+    // The VFDs share the RS485 port, the others the spindle output pin and PWM channel.
+    static bool on_rs485(SpindleType type) {
+        return type == SpindleType::HUANYANG || type == SpindleType::H2A || type == SpindleType::YL620;
+    }
+
+    void Spindle::select() {
+        for (auto head : heads) {
+            head->deinit();
+        }
+
+        SpindleType type     = static_cast<SpindleType>(spindle_type->get());
+        SpindleType alt_type = static_cast<SpindleType>(spindle_alt_type->get());
+        if (alt_type != SpindleType::NONE && type != SpindleType::NONE && on_rs485(type) == on_rs485(alt_type)) {
+            grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "Spindle/Alt/Type shares pins with Spindle/Type and is not used");
+            alt_type = SpindleType::NONE;
         }
+        heads[0] = of_setting(spindle_type);
+        heads[1] = alt_type == SpindleType::NONE ? &null : of_setting(spindle_alt_type);
 
+        spindle = heads[0];
+        if (heads[1] != &null) {
+            heads[1]->init();
+        }
         spindle->init();
     }
 
+    bool Spindle::has_head(uint8_t head) { return head == 0 || (head < MAX_HEADS && heads[head] != &null); }
+
+    Spindle* Spindle::get_head(uint8_t head) { return has_head(head) ? heads[head] : spindle; }
+
+    // Returns true when the head changed. The old one is stopped, the caller starts the new one.
+    bool Spindle::select_head(uint8_t head) {
+        if (!has_head(head) || heads[head] == spindle || sys.state == State::CheckMode) {
+            return false;
+        }
+        protocol_buffer_synchronize();
+        spindle->set_state(SpindleState::Disable, 0);
+        spindle = heads[head];
+        return true;
+    }
+
     // ========================= Spindle ==================================
 
     bool Spindle::inLaserMode() {
@@ -106,6 +153,24 @@ namespace Spindles {
         set_state(state, rpm);
     }
 
+#ifdef SYNC_SPINDLE_SPEED
+    // A new speed for a running spindle. The blocks queued after it carry the speed and the
+    // segment generator sets it as the first of them starts, so the planner need not drain.
+    void Spindle::sync_rpm(SpindleState state, uint32_t rpm) {
+        if (sys.state == State::CheckMode) {
+            return;
+        }
+        // The rest of an arc and a held back line keep the old speed.
+        mc_finish_arc();
+        mc_flush_merged_line();
+        if (plan_get_current_block() != NULL || sys.state == State::Cycle) {
+            plan_sync_spindle(state, rpm);
+            return;
+        }
+        set_state(state, rpm);
+    }
+#endif
+
     void Spindle::deinit() { stop(); }
 }
 
@@ -67,8 +67,15 @@ namespace Spindles {
         virtual void         config_message()                            = 0;
         virtual bool         inLaserMode();
         virtual void         sync(SpindleState state, uint32_t rpm);
+#ifdef SYNC_SPINDLE_SPEED
+        void sync_rpm(SpindleState state, uint32_t rpm);
+#endif
         virtual void         deinit();
 
+        // The output current of the drive in amps, for the adaptive feed. readings counts the
+        // readings, so a new one can be told from the last. Returns false if there is none.
+        virtual bool get_load(float& amps, uint32_t& readings) { return false; }
+
         virtual ~Spindle() {}
 
         bool                  is_reversable;
@@ -76,8 +83,17 @@ namespace Spindles {
         volatile SpindleState _current_state = SpindleState::Disable;
         uint32_t              _spinup_delay;
         uint32_t              _spindown_delay;
+        uint32_t              rpm_update_ms = 0;  // Least time between the rpm changes of G96, 0 for every segment
+
+        // A machine can have a second head, like a laser next to the router, selected with
+        // M3/M4/M5 P1. Both are initialized, so a change of head only stops one and starts
+        // the other. They share the spindle settings, so the two must not use the same pins.
+        static const uint8_t MAX_HEADS = 2;
 
-        static void select();
+        static void     select();
+        static bool     has_head(uint8_t head);
+        static Spindle* get_head(uint8_t head);
+        static bool     select_head(uint8_t head);
     };
 
 }
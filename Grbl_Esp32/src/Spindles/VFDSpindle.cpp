@@ -38,16 +38,31 @@
 
 // Timing and modbus... The manual states that between communications, we should respect a
 // silent interval of 3,5 characters. If we received communications between these times, we
-// have to assume that the message is broken. We use a poll rate of 250 ms here, which should
-// be plenty: assuming 9600 8N1, that's roughly 250 chars. A message of 2x16 chars with 4x4
-// chars buffering is just 40 chars.
-
-const int        VFD_RS485_UART_PORT  = 2;  // hard coded for this port right now
-const int        VFD_RS485_BUF_SIZE   = 127;
-const int        VFD_RS485_QUEUE_SIZE = 10;                                         // numv\ber of commands that can be queued up.
-const int        RESPONSE_WAIT_MILLIS = 1000;                                       // how long to wait for a response in milliseconds
-const int        VFD_RS485_POLL_RATE  = 250;                                        // in milliseconds between commands
-const TickType_t response_ticks       = RESPONSE_WAIT_MILLIS / portTICK_PERIOD_MS;  // in milliseconds between commands
+// have to assume that the message is broken. At 9600 8N1 that is under 4 ms, so a gap of
+// VFD_RS485_FRAME_GAP between transactions is plenty.
+//
+// The task sends, in order of priority: the initialization sequence, speed commands,
+// other commands such as direction, the safety status poll and the telemetry polls of
+// rpm and direction. It sleeps until a command is queued or the next poll is due, so a
+// command waits at most for the transaction in flight. Telemetry backs off while a job runs,
+// when nothing looks at it but the status report, and speeds up while waiting for the
+// spindle to reach its speed. While the adaptive feed is cutting, the telemetry is the
+// output current, as often as the feed control wants it. A VFD that implements
+// get_telemetry_batch() answers all telemetry in one read of a register block; if the VFD
+// rejects that read, the task falls back to the single polls.
+
+const int        VFD_RS485_UART_PORT    = 2;  // hard coded for this port right now
+const int        VFD_RS485_BUF_SIZE     = 127;
+const int        VFD_RS485_QUEUE_SIZE   = 10;                                         // numv\ber of commands that can be queued up.
+const int        RESPONSE_WAIT_MILLIS   = 1000;                                       // how long to wait for a response in milliseconds
+const int        VFD_RS485_POLL_RATE    = 250;                                        // in milliseconds between retries
+const int        VFD_RS485_FRAME_GAP    = 5;                                          // in milliseconds between transactions
+const int        VFD_STATUS_POLL_MS     = 500;                                        // safety status poll period
+const int        VFD_TELEMETRY_IDLE_MS  = 500;                                        // rpm and direction poll period when idle
+const int        VFD_TELEMETRY_CYCLE_MS = 2000;                                       // ... while a job runs
+const int        VFD_TELEMETRY_SYNC_MS  = 100;                                        // ... while waiting for the speed
+const int        VFD_TELEMETRY_LOAD_MS  = 100;                                        // ... while the adaptive feed wants the load
+const TickType_t response_ticks         = RESPONSE_WAIT_MILLIS / portTICK_PERIOD_MS;  // in milliseconds between commands
 
 // OK to change these
 // #define them in your machine definition file if you want different values
@@ -55,9 +70,28 @@ const TickType_t response_ticks       = RESPONSE_WAIT_MILLIS / portTICK_PERIOD_M
 #    define VFD_RS485_ADDR 0x01
 #endif
 
+// With actual rpm feedback, motion resumes once that many fresh readings in a row are
+// within tolerance of the requested speed. The spindle gets VFD_SYNC_TIMEOUT ms to get
+// there, and may not sit at the same reading for VFD_SYNC_STALL ms on the way.
+#ifndef VFD_SYNC_SAMPLES
+#    define VFD_SYNC_SAMPLES 2
+#endif
+#ifndef VFD_SYNC_TIMEOUT
+#    define VFD_SYNC_TIMEOUT 30000
+#endif
+#ifndef VFD_SYNC_STALL
+#    define VFD_SYNC_STALL 10000
+#endif
+
+// A G96 rpm that follows the tool is sent at most this often, so it does not crowd the RS485 bus.
+#ifndef VFD_RPM_UPDATE_MS
+#    define VFD_RPM_UPDATE_MS 250
+#endif
+
 namespace Spindles {
     Uart          _uart(VFD_RS485_UART_PORT);
     QueueHandle_t VFD::vfd_cmd_queue     = nullptr;
+    QueueHandle_t VFD::vfd_speed_queue   = nullptr;
     TaskHandle_t  VFD::vfd_cmdTaskHandle = nullptr;
 
     VFD::VFD() :
@@ -103,13 +137,23 @@ namespace Spindles {
         static bool unresponsive = false;  // to pop off a message once each time it becomes unresponsive
         static int  pollidx      = -1;     // -1 starts the VFD initialization sequence
 
+        TickType_t next_status    = 0;
+        TickType_t next_telemetry = 0;
+        int        telemetry_idx  = 0;  // Alternates between rpm and direction
+
+        response_parser batch[MAX_BATCH_PARSERS];
+        int             batch_count = 0;
+        bool            batch_ok    = true;
+
         VFD*          instance = static_cast<VFD*>(pvParameters);
         ModbusCommand next_cmd;
-        uint8_t       rx_message[VFD_RS485_MAX_MSG_SIZE];
+        uint8_t       rx_message[VFD_RS485_MAX_RX_SIZE];
         bool          safetyPollingEnabled = instance->safety_polling();
 
         while (true) {
-            response_parser parser = nullptr;
+            response_parser parser   = nullptr;
+            bool            rpm_poll = false;
+            batch_count              = 0;
 
             next_cmd.msg[0] = VFD_RS485_ADDR;  // Always default to this
 
@@ -122,43 +166,59 @@ namespace Spindles {
                 next_cmd.critical = false;
             }
 
-            // If we don't have a parser, the queue goes first. During idle, we can grab a parser.
-            if (parser == nullptr && xQueueReceive(vfd_cmd_queue, &next_cmd, 0) != pdTRUE) {
-                // We poll in a cycle. Note that the switch will fall through unless we encounter a hit.
-                // The weakest form here is 'get_status_ok' which should be implemented if the rest fails.
-                if (instance->_syncing) {
-                    parser = instance->get_current_rpm(next_cmd);
-                } else if (safetyPollingEnabled) {
-                    switch (pollidx) {
-                        case 1:
-                            parser = instance->get_current_rpm(next_cmd);
-                            if (parser) {
-                                pollidx = 2;
-                                break;
-                            }
-                            // fall through intentionally:
-                        case 2:
+            // If we don't have a parser, the queues go first. During idle, we can grab a parser.
+            if (parser == nullptr && xQueueReceive(vfd_speed_queue, &next_cmd, 0) != pdTRUE &&
+                xQueueReceive(vfd_cmd_queue, &next_cmd, 0) != pdTRUE) {
+                // Polls that are due, safety status first. The weakest form here is 'get_status_ok'
+                // which should be implemented if the rest fails.
+                TickType_t now = xTaskGetTickCount();
+                if (safetyPollingEnabled && int32_t(now - next_status) >= 0) {
+                    parser      = instance->get_status_ok(next_cmd);
+                    next_status = now + VFD_STATUS_POLL_MS / portTICK_PERIOD_MS;
+                }
+                bool load_poll = !instance->_syncing && adaptive_feed_wants_load();
+                if (parser == nullptr && (safetyPollingEnabled || instance->_syncing || load_poll) && int32_t(now - next_telemetry) >= 0) {
+                    if (batch_ok && (batch_count = instance->get_telemetry_batch(next_cmd, batch)) > 0) {
+                        parser   = batch[0];
+                        rpm_poll = true;
+                    } else {
+                        batch_count = 0;
+                        if (load_poll) {
+                            parser = instance->get_current_load(next_cmd);
+                        }
+                        if (parser == nullptr && (instance->_syncing || telemetry_idx == 0)) {
+                            parser   = instance->get_current_rpm(next_cmd);
+                            rpm_poll = parser != nullptr;
+                        }
+                        if (parser == nullptr) {
                             parser = instance->get_current_direction(next_cmd);
-                            if (parser) {
-                                pollidx = 3;
-                                break;
-                            }
-                            // fall through intentionally:
-                        case 3:
-                        default:
-                            parser  = instance->get_status_ok(next_cmd);
-                            pollidx = 1;
-
-                            // we could complete this in case parser == nullptr with some ifs, but let's
-                            // just keep it easy and wait an iteration.
-                            break;
+                        }
+                        telemetry_idx = 1 - telemetry_idx;
+                    }
+
+                    int period = VFD_TELEMETRY_IDLE_MS;
+                    if (instance->_syncing) {
+                        period = VFD_TELEMETRY_SYNC_MS;
+                    } else if (load_poll) {
+                        period = VFD_TELEMETRY_LOAD_MS;
+                    } else if (sys.state == State::Cycle) {
+                        period = VFD_TELEMETRY_CYCLE_MS;
                     }
+                    next_telemetry = now + period / portTICK_PERIOD_MS;
                 }
 
-                // If we have no parser, that means get_status_ok is not implemented (and we have
-                // nothing resting in our queue). Let's fall back on a simple continue.
+                // Nothing due, or nothing implemented. Sleep until a command is queued or the
+                // next poll is due.
                 if (parser == nullptr) {
-                    vTaskDelay(VFD_RS485_POLL_RATE / portTICK_PERIOD_MS);
+                    TickType_t due  = next_status;
+                    TickType_t wait = VFD_STATUS_POLL_MS / portTICK_PERIOD_MS;
+                    if (!safetyPollingEnabled || int32_t(next_telemetry - next_status) < 0) {
+                        due = next_telemetry;
+                    }
+                    if (int32_t(due - now) > 0 && due - now < wait) {
+                        wait = due - now;
+                    }
+                    ulTaskNotifyTake(pdTRUE, wait);
                     continue;  // main while loop
                 }
             }
@@ -182,6 +242,7 @@ namespace Spindles {
             }
 
             // Assume for the worst, and retry...
+            TRACE_BEGIN(VfdCommand, next_cmd.msg[1]);
             int retry_count = 0;
             for (; retry_count < MAX_RETRIES; ++retry_count) {
                 // Flush the UART:
@@ -225,7 +286,14 @@ namespace Spindles {
 
                     // Should we parse this?
                     if (parser != nullptr) {
-                        if (parser(rx_message, instance)) {
+                        bool parsed = parser(rx_message, instance);
+                        for (int i = 1; parsed && i < batch_count; ++i) {
+                            parsed = batch[i](rx_message, instance);
+                        }
+                        if (parsed) {
+                            if (rpm_poll) {
+                                ++instance->_sync_count;  // A fresh _sync_rpm for set_state()
+                            }
                             // If we're initializing, move to the next initialization command:
                             if (pollidx < 0) {
                                 --pollidx;
@@ -274,8 +342,13 @@ namespace Spindles {
                     reportTaskStackSize(uxHighWaterMark);
                 }
             }
+            TRACE_END(VfdCommand, retry_count);
 
-            if (retry_count == MAX_RETRIES) {
+            if (retry_count == MAX_RETRIES && batch_count > 0) {
+                // The VFD answers, but not to the block read. Stick to the single polls.
+                batch_ok = false;
+                grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Spindle RS485 batched read failed, polling registers one by one");
+            } else if (retry_count == MAX_RETRIES) {
                 if (!unresponsive) {
                     grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "Spindle RS485 Unresponsive %d", next_cmd.rx_length);
                     unresponsive = true;
@@ -288,8 +361,45 @@ namespace Spindles {
                 }
             }
 
-            vTaskDelay(VFD_RS485_POLL_RATE / portTICK_PERIOD_MS);
+            vTaskDelay(VFD_RS485_FRAME_GAP / portTICK_PERIOD_MS);
+        }
+    }
+
+    void VFD::read_registers(ModbusCommand& data, uint16_t first, uint8_t count) {
+        if (count > VFD_RS485_MAX_READ_REGS) {
+            count = VFD_RS485_MAX_READ_REGS;
+        }
+
+        // NOTE: data length is excluding the CRC16 checksum.
+        data.tx_length = 6;
+        data.rx_length = 3 + 2 * count;
+
+        // Send: 01 03 <first> <count>
+        // Recv: 01 03 <bytes> <count registers>
+        data.msg[1] = 0x03;
+        data.msg[2] = first >> 8;
+        data.msg[3] = first & 0xFF;
+        data.msg[4] = 0x00;
+        data.msg[5] = count;
+    }
+
+    void VFD::queue_command(ModbusCommand& cmd, bool speed) {
+        // set_rpm() is also called by the stepper ISR when a segment changes the speed
+        if (xPortInIsrContext()) {
+            if (speed) {
+                xQueueOverwriteFromISR(vfd_speed_queue, &cmd, NULL);
+            } else {
+                xQueueSendFromISR(vfd_cmd_queue, &cmd, NULL);
+            }
+            vTaskNotifyGiveFromISR(vfd_cmdTaskHandle, NULL);
+            return;
+        }
+        if (speed) {
+            xQueueOverwrite(vfd_speed_queue, &cmd);
+        } else if (xQueueSend(vfd_cmd_queue, &cmd, 0) != pdTRUE) {
+            grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "VFD Queue Full");
         }
+        xTaskNotifyGive(vfd_cmdTaskHandle);
     }
 
     // ================== Class methods ==================================
@@ -327,6 +437,7 @@ namespace Spindles {
         // We have to initialize the constants before starting the task:
         is_reversable = true;  // these VFDs are always reversable
         use_delays    = true;
+        rpm_update_ms = VFD_RPM_UPDATE_MS;
         vfd_ok        = true;
 
         // Initially we initialize this to 0; over time, we might poll better information from the VFD.
@@ -335,14 +446,15 @@ namespace Spindles {
 
         // Initialization is complete, so now it's okay to run the queue task:
         if (!_task_running) {  // init can happen many times, we only want to start one task
-            vfd_cmd_queue = xQueueCreate(VFD_RS485_QUEUE_SIZE, sizeof(ModbusCommand));
-            xTaskCreatePinnedToCore(vfd_cmd_task,         // task
-                                    "vfd_cmdTaskHandle",  // name for task
-                                    2048,                 // size of task stack
-                                    this,                 // parameters
-                                    1,                    // priority
-                                    &vfd_cmdTaskHandle,
-                                    SUPPORT_TASK_CORE  // core
+            vfd_cmd_queue   = xQueueCreate(VFD_RS485_QUEUE_SIZE, sizeof(ModbusCommand));
+            vfd_speed_queue = xQueueCreate(1, sizeof(ModbusCommand));
+            heap_task_create(vfd_cmd_task,         // task
+                             "vfd_cmdTaskHandle",  // name for task
+                             2048,                 // size of task stack
+                             this,                 // parameters
+                             1,                    // priority
+                             &vfd_cmdTaskHandle,
+                             SUPPORT_TASK_CORE  // core
             );
             _task_running = true;
         }
@@ -404,9 +516,11 @@ namespace Spindles {
         bool critical   = (sys.state == State::Cycle || state != SpindleState::Disable);
 
         int32_t delayMillis = 1000;
+        bool    changed     = false;  // Sent a new state or speed to the VFD
 
         if (_current_state != state) {  // already at the desired state. This function gets called a lot.
             set_mode(state, critical);  // critical if we are in a job
+            changed = true;
 
             if (rpm != 0 && (rpm < _min_rpm || rpm > _max_rpm)) {
                 grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "VFD: Requested speed %d outside range:(%d,%d)", rpm, _min_rpm, _max_rpm);
@@ -422,12 +536,9 @@ namespace Spindles {
             } else {
                 delayMillis = _spinup_delay;
             }
-
-            if (_current_state != state && !supports_actual_rpm()) {
-                delay(delayMillis);
-            }
         } else {
             if (_current_rpm != rpm) {
+                changed = true;
                 if (rpm != 0 && (rpm < _min_rpm || rpm > _max_rpm)) {
                     grbl_msg_sendf(CLIENT_ALL, MsgLevel::Info, "VFD: Requested speed %d outside range:(%d,%d)", rpm, _min_rpm, _max_rpm);
                 }
@@ -444,7 +555,14 @@ namespace Spindles {
 
         if (shouldWait) {
             if (supports_actual_rpm()) {
+                // A reading taken before the command went out says nothing, and when the motor
+                // reverses at the same speed even the first few after it don't. So only fresh
+                // readings count, and a reversal has to leave the tolerance band first.
+                bool reversing = _current_state != state && _current_state != SpindleState::Disable && state != SpindleState::Disable;
+                bool left      = !reversing;
+
                 _syncing = true;
+                xTaskNotifyGive(vfd_cmdTaskHandle);  // Poll the rpm now
 
                 // Allow 2.5% difference from what we asked for. Should be fine.
                 uint32_t drpm = (_max_rpm - _min_rpm) / 40;
@@ -455,30 +573,52 @@ namespace Spindles {
                 auto minRpmAllowed = _current_rpm > drpm ? (_current_rpm - drpm) : 0;
                 auto maxRpmAllowed = _current_rpm + drpm;
 
-                int       unchanged = 0;
-                const int limit     = 20;  // 20 * 0.5s = 10 sec
-                auto      last      = _sync_rpm;
+                TickType_t start   = xTaskGetTickCount();
+                TickType_t moved   = start;
+                uint32_t   seen    = _sync_count;
+                auto       last    = _sync_rpm;
+                int        good    = 0;
+                bool       reached = false;
+
+                // Nothing new commanded and already at speed: no need to wait for fresh readings.
+                if (!changed && _sync_rpm >= minRpmAllowed && _sync_rpm <= maxRpmAllowed) {
+                    reached = true;
+                }
+
+                while (!reached) {
+                    TickType_t now = xTaskGetTickCount();
+                    if (now - start >= VFD_SYNC_TIMEOUT / portTICK_PERIOD_MS || now - moved >= VFD_SYNC_STALL / portTICK_PERIOD_MS) {
+                        break;
+                    }
+
+                    if (!mc_dwell(VFD_TELEMETRY_SYNC_MS / 2)) {
+                        // Something happened while we were dwelling, like a safety door.
+                        break;
+                    }
+
+                    uint32_t count = _sync_count;
+                    if (count == seen) {
+                        continue;
+                    }
+                    seen = count;
 
-                while ((_sync_rpm < minRpmAllowed || _sync_rpm > maxRpmAllowed) && unchanged < limit) {
 #ifdef VFD_DEBUG_MODE
                     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Syncing RPM. Requested %d, current %d", int(rpm), int(_sync_rpm));
 #endif
-                    if (!mc_dwell(500)) {
-                        // Something happened while we were dwelling, like a safety door.
-                        unchanged = limit;
-                        last      = _sync_rpm;
-                        break;
+                    if (_sync_rpm != last) {
+                        moved = xTaskGetTickCount();
+                        last  = _sync_rpm;
                     }
 
-                    if (_sync_rpm == last) {
-                        ++unchanged;
-                    } else {
-                        unchanged = 0;
+                    if (_sync_rpm < minRpmAllowed || _sync_rpm > maxRpmAllowed) {
+                        left = true;
+                        good = 0;
+                    } else if (left && ++good >= VFD_SYNC_SAMPLES) {
+                        reached = true;
                     }
-                    last = _sync_rpm;
                 }
 
-                if (unchanged == limit) {
+                if (!reached) {
                     grbl_msg_sendf(CLIENT_ALL,
                                    MsgLevel::Error,
                                    "Critical Spindle RS485 did not reach speed %d. Reported speed is %d rpm.",
@@ -489,7 +629,8 @@ namespace Spindles {
                 }
 
                 _syncing = false;
-            } else {
+            } else if (changed) {
+                // No feedback; all we can do is give it the configured time.
                 delay(delayMillis);
             }
         }
@@ -511,7 +652,7 @@ namespace Spindles {
         direction_command(mode, mode_cmd);
 
         if (mode == SpindleState::Disable) {
-            if (!xQueueReset(vfd_cmd_queue)) {
+            if (!xQueueReset(vfd_cmd_queue) || !xQueueReset(vfd_speed_queue)) {
                 grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "VFD spindle off, queue could not be reset");
             }
         }
@@ -519,9 +660,7 @@ namespace Spindles {
         mode_cmd.critical = critical;
         _current_state    = mode;
 
-        if (xQueueSend(vfd_cmd_queue, &mode_cmd, 0) != pdTRUE) {
-            grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "VFD Queue Full");
-        }
+        queue_command(mode_cmd, false);
 
         return true;
     }
@@ -573,9 +712,7 @@ namespace Spindles {
 
         rpm_cmd.critical = (rpm == 0);
 
-        if (xQueueSend(vfd_cmd_queue, &rpm_cmd, 0) != pdTRUE) {
-            grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "VFD Queue Full");
-        }
+        queue_command(rpm_cmd, true);
 
         return rpm;
     }
@@ -590,6 +727,12 @@ namespace Spindles {
     // state is cached rather than read right now to prevent delays
     SpindleState VFD::get_state() { return _current_state; }
 
+    bool VFD::get_load(float& amps, uint32_t& readings) {
+        readings = _load_count;
+        amps     = _load;
+        return readings != 0;
+    }
+
     // Calculate the CRC on all of the byte except the last 2
     // It then added the CRC to those last 2 bytes
     // full_msg_len This is the length of the message including the 2 crc bytes
@@ -29,8 +29,10 @@ namespace Spindles {
 
     class VFD : public Spindle {
     private:
-        static const int VFD_RS485_MAX_MSG_SIZE = 16;  // more than enough for a modbus message
-        static const int MAX_RETRIES            = 5;   // otherwise the spindle is marked 'unresponsive'
+        static const int VFD_RS485_MAX_MSG_SIZE  = 16;                              // more than enough for a modbus message
+        static const int VFD_RS485_MAX_READ_REGS = 16;                              // largest block read_registers() asks for
+        static const int VFD_RS485_MAX_RX_SIZE   = 5 + 2 * VFD_RS485_MAX_READ_REGS;  // response to such a read, with CRC
+        static const int MAX_RETRIES             = 5;                               // otherwise the spindle is marked 'unresponsive'
 
         bool set_mode(SpindleState mode, bool critical);
         bool get_pins_and_settings();
@@ -44,6 +46,7 @@ namespace Spindles {
         bool     vfd_ok        = true;
 
         static QueueHandle_t vfd_cmd_queue;
+        static QueueHandle_t vfd_speed_queue;  // Holds only the latest speed command
         static TaskHandle_t  vfd_cmdTaskHandle;
         static void          vfd_cmd_task(void* pvParameters);
 
@@ -58,6 +61,9 @@ namespace Spindles {
             uint8_t msg[VFD_RS485_MAX_MSG_SIZE];
         };
 
+        // Queues a command and wakes the task. Speed commands replace one that has not been sent.
+        void queue_command(ModbusCommand& cmd, bool speed);
+
         // Commands:
         virtual void direction_command(SpindleState mode, ModbusCommand& data) = 0;
         virtual void set_speed_command(uint32_t rpm, ModbusCommand& data)      = 0;
@@ -68,10 +74,24 @@ namespace Spindles {
         virtual response_parser initialization_sequence(int index, ModbusCommand& data) { return nullptr; }
         virtual response_parser get_current_rpm(ModbusCommand& data) { return nullptr; }
         virtual response_parser get_current_direction(ModbusCommand& data) { return nullptr; }
+        virtual response_parser get_current_load(ModbusCommand& data) { return nullptr; }  // Sets _load
         virtual response_parser get_status_ok(ModbusCommand& data) = 0;
         virtual bool            supports_actual_rpm() const { return false; }
         virtual bool            safety_polling() const { return true; }
 
+        // Batched telemetry: a single read of a contiguous register block that answers several
+        // polls at once. Fills in the command and up to MAX_BATCH_PARSERS parsers, which all get
+        // the whole response, and returns how many. 0 (default) uses the single polls above.
+        static const int MAX_BATCH_PARSERS = 4;
+        virtual int      get_telemetry_batch(ModbusCommand& data, response_parser* parsers) { return 0; }
+
+        // Builds a 'read holding registers' (0x03) command for `count` registers from `first`,
+        // and picks register `index` of such a block out of the response.
+        static void     read_registers(ModbusCommand& data, uint16_t first, uint8_t count);
+        static uint16_t register_value(const uint8_t* response, int index) {
+            return (uint16_t(response[3 + 2 * index]) << 8) | uint16_t(response[4 + 2 * index]);
+        }
+
         // The constructor sets these
         int          _baudrate;
         Uart::Data   _dataBits;
@@ -90,7 +110,10 @@ namespace Spindles {
         volatile uint32_t _min_rpm;
         volatile uint32_t _max_rpm;
         volatile uint32_t _sync_rpm;
+        volatile uint32_t _sync_count = 0;  // Bumped by the task for each rpm reading
         volatile bool     _syncing;
+        volatile float    _load       = 0;  // Output current in amps
+        volatile uint32_t _load_count = 0;  // Bumped by the parsers for each _load reading
 
         void         init();
         void         config_message();
@@ -98,6 +121,7 @@ namespace Spindles {
         SpindleState get_state();
         uint32_t     set_rpm(uint32_t rpm);
         void         stop();
+        bool         get_load(float& amps, uint32_t& readings) override;
 
         virtual ~VFD() {}
     };
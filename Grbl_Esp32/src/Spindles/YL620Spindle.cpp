@@ -229,4 +229,30 @@ namespace Spindles {
         // TODO: What are we going to do with this? Update sys.spindle_speed? Update vfd state?
         return [](const uint8_t* response, Spindles::VFD* vfd) -> bool { return true; };
     }
+
+    int YL620::get_telemetry_batch(ModbusCommand& data, response_parser* parsers) {
+        // Send: 01 03 200B 0002
+        read_registers(data, 0x200B, 2);
+
+        //  Recv: 01 03 04 05 DC 00 2A xx xx
+        //                 ----- ----- output current (0x200C) = 4.2 A
+        //                 output frequency (0x200B) = 1500
+        parsers[0] = [](const uint8_t* response, Spindles::VFD* vfd) -> bool {
+            uint16_t freq = register_value(response, 0);
+
+            auto yl620 = static_cast<YL620*>(vfd);
+
+            uint16_t rpm = freq * uint16_t(vfd->_max_rpm) / uint16_t(yl620->_maxFrequency);
+
+            vfd->_sync_rpm = rpm;
+            return true;
+        };
+
+        parsers[1] = [](const uint8_t* response, Spindles::VFD* vfd) -> bool {
+            vfd->_load = register_value(response, 1) * 0.1f;
+            ++vfd->_load_count;
+            return true;
+        };
+        return 2;
+    }
 }
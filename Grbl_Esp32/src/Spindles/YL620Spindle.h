@@ -34,6 +34,7 @@ namespace Spindles {
         response_parser get_current_rpm(ModbusCommand& data) override;
         response_parser get_current_direction(ModbusCommand& data) override;
         response_parser get_status_ok(ModbusCommand& data) override { return nullptr; }
+        int             get_telemetry_batch(ModbusCommand& data, response_parser* parsers) override;
 
         bool supports_actual_rpm() const override { return true; }
         bool safety_polling() const override { return false; }
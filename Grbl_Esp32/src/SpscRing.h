@@ -0,0 +1,120 @@
+#pragma once
+
+/*
+  SpscRing.h - Single-producer, single-consumer ring buffer
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The ring index arithmetic shared by the planner buffer, the step segment
+  buffer and the client input buffers.
+
+  One task or ISR produces, one consumes, and they may run on different cores.
+  The producer only writes the head index and the consumer only writes the
+  tail index. The producer fills the head slot in place and then publishes it
+  with push(), a release store, so the consumer, which loads the head with
+  acquire, never sees the index before the slot contents. In the other
+  direction pop() releases the tail only after the consumer is done with the
+  slot, so the producer cannot overwrite a slot that is still being read.
+  That makes a critical section unnecessary for either side.
+
+  One slot is always left unused so that a full ring can be told from an
+  empty one; a ring of size N holds N - 1 entries.
+
+  The storage is supplied by the owner, so rings can be sized at run time.
+  The ESP32 does not cache internal RAM, where the indices live, so they are
+  not padded out to separate cache lines.
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+template <typename T, typename Index = uint8_t>
+class SpscRing {
+public:
+    SpscRing() : _slots(nullptr), _size(0), _head(0), _tail(0) {}
+    SpscRing(T* slots, Index size) : _slots(slots), _size(size), _head(0), _tail(0) {}
+
+    // Use size slots of storage. Neither side may be running.
+    void attach(T* slots, Index size) {
+        _slots = slots;
+        _size  = size;
+        reset();
+    }
+
+    // Empty the ring. Neither side may be running.
+    void reset() {
+        _head.store(0, std::memory_order_relaxed);
+        _tail.store(0, std::memory_order_relaxed);
+    }
+
+    Index size() const { return _size; }
+    Index capacity() const { return _size - 1; }
+
+    Index next(Index index) const { return (index + 1 == _size) ? 0 : index + 1; }
+    Index prev(Index index) const { return (index == 0 ? _size : index) - 1; }
+
+    T&       operator[](Index index) { return _slots[index]; }
+    const T& operator[](Index index) const { return _slots[index]; }
+
+    // Index of the slot the producer fills next, and of the oldest entry.
+    Index head() const { return _head.load(std::memory_order_acquire); }
+    Index tail() const { return _tail.load(std::memory_order_acquire); }
+
+    bool  empty() const { return head() == tail(); }
+    bool  full() const { return next(head()) == tail(); }
+    Index count() const {
+        Index h = head();
+        Index t = tail();
+        return h >= t ? h - t : _size - (t - h);
+    }
+    Index available() const { return capacity() - count(); }
+
+    // Producer side. Fill producer_slot() in place, then push() to publish it.
+    T* producer_slot() { return full() ? nullptr : &_slots[_head.load(std::memory_order_relaxed)]; }
+    void push() { _head.store(next(_head.load(std::memory_order_relaxed)), std::memory_order_release); }
+    bool push(const T& value) {
+        T* slot = producer_slot();
+        if (slot == nullptr) {
+            return false;
+        }
+        *slot = value;
+        push();
+        return true;
+    }
+    // Take back the entries pushed since head was the head. Only while the consumer is stopped,
+    // as it could already be reading them.
+    void rewind(Index head) { _head.store(head, std::memory_order_release); }
+
+    // Consumer side. Use consumer_slot() in place, then pop() to release it.
+    T* consumer_slot() { return empty() ? nullptr : &_slots[_tail.load(std::memory_order_relaxed)]; }
+    void pop() { _tail.store(next(_tail.load(std::memory_order_relaxed)), std::memory_order_release); }
+    bool pop(T& value) {
+        T* slot = consumer_slot();
+        if (slot == nullptr) {
+            return false;
+        }
+        value = *slot;
+        pop();
+        return true;
+    }
+
+    // Consumer side. Discard everything the producer has published so far.
+    void discard() { _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release); }
+
+private:
+    T*                 _slots;
+    Index              _size;
+    std::atomic<Index> _head;
+    std::atomic<Index> _tail;
+};
@@ -0,0 +1,118 @@
+/*
+  StepTrace.cpp - Record of the step events the stepper interrupt puts out
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  Time is counted in step timer ticks from the periods of the segments, not read from a clock,
+  so two builds that plan and step the same motion give the same trace however long their
+  interrupts take. Idle time between cycles is not counted.
+
+  Each step event is a varint, 7 bits a byte low bits first with the top bit set on all but the
+  last byte, of the ticks since the previous event shifted left by one, with bit 0 set if the
+  direction mask changed. The step mask byte follows, then the direction mask byte if it
+  changed. The first event after a start always carries the direction mask.
+
+  When the buffer fills, recording stops for the rest of the trace, since a gap would make
+  everything after it look moved. Read it more often, over $Stepper/Trace or step_trace_read().
+*/
+
+#include "Config.h"
+#ifdef STEP_TRACE
+#    include "Grbl.h"
+
+static const int TRACE_EVENT_MAX = 7;  // Bytes of the longest event, a 5 byte varint and two masks
+
+static uint8_t*                    trace_bytes;
+static SpscRing<uint8_t, uint16_t> trace_ring;
+static volatile bool               trace_on;
+static bool                        trace_first;    // The next event carries the direction mask
+static uint32_t                    trace_ticks;    // Since the last recorded event
+static uint8_t                     trace_dir;      // Direction mask of the last recorded event
+static uint32_t                    trace_events;   // Recorded since the start
+static uint32_t                    trace_dropped;  // Events after the buffer filled
+
+bool step_trace_start() {
+    trace_on = false;
+    if (!trace_bytes) {
+        trace_bytes = (uint8_t*)heap_alloc(HeapTag::Stepper, STEP_TRACE_BYTES, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!trace_bytes) {
+            return false;
+        }
+        trace_ring.attach(trace_bytes, STEP_TRACE_BYTES);
+    }
+    trace_ring.reset();
+    trace_first   = true;
+    trace_ticks   = 0;
+    trace_events  = 0;
+    trace_dropped = 0;
+    trace_on      = true;
+    return true;
+}
+
+void step_trace_stop() {
+    trace_on = false;
+}
+
+void IRAM_ATTR step_trace_record(uint32_t period, uint8_t step_mask, uint8_t dir_mask) {
+    if (!trace_on) {
+        return;
+    }
+    trace_ticks += period;
+    if (!step_mask) {
+        return;
+    }
+    if (trace_dropped || trace_ring.available() < TRACE_EVENT_MAX) {
+        trace_dropped++;
+        return;
+    }
+    bool     dir_changed = trace_first || dir_mask != trace_dir;
+    uint64_t word        = (uint64_t(trace_ticks) << 1) | dir_changed;
+    while (word >= 0x80) {
+        trace_ring.push(uint8_t(word) | 0x80);
+        word >>= 7;
+    }
+    trace_ring.push(uint8_t(word));
+    trace_ring.push(step_mask);
+    if (dir_changed) {
+        trace_ring.push(dir_mask);
+    }
+    trace_first = false;
+    trace_dir   = dir_mask;
+    trace_ticks = 0;
+    trace_events++;
+}
+
+size_t step_trace_read(uint8_t* out, size_t size) {
+    size_t count = 0;
+    while (count < size && trace_ring.pop(out[count])) {
+        count++;
+    }
+    return count;
+}
+
+void step_trace_report(uint8_t client) {
+    static const char hex[] = "0123456789abcdef";
+    uint8_t           bytes[64];
+    char              line[sizeof(bytes) * 2 + 1];
+    size_t            count;
+    while (trace_bytes && (count = step_trace_read(bytes, sizeof(bytes))) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            line[2 * i]     = hex[bytes[i] >> 4];
+            line[2 * i + 1] = hex[bytes[i] & 0xf];
+        }
+        line[2 * count] = '\0';
+        grbl_sendf(client, "[TRACE:%s]\r\n", line);
+    }
+    grbl_sendf(client, "[MSG: Step trace %s Events: %u Dropped: %u]\r\n", trace_on ? "on" : "off", trace_events, trace_dropped);
+}
+#endif
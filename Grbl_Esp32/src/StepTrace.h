@@ -0,0 +1,38 @@
+#pragma once
+
+/*
+  StepTrace.h - Record of the step events the stepper interrupt puts out
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+// Bytes of recorded events held until they are read. At two to three bytes an event this is
+// enough for a few seconds at full step rate between reads.
+const size_t STEP_TRACE_BYTES = 32768;
+
+// Starts a new trace from an empty buffer, allocating it the first time. False without memory.
+bool step_trace_start();
+void step_trace_stop();
+
+// Called by the stepper interrupt on every tick with the period of the tick in step timer ticks.
+// Ticks without steps only add to the time of the next event.
+void step_trace_record(uint32_t period, uint8_t step_mask, uint8_t dir_mask);
+
+// Moves up to size recorded bytes to out and returns how many there were.
+size_t step_trace_read(uint8_t* out, size_t size);
+
+// Sends what has been recorded since the last read as [TRACE:<hex>] lines, then a summary.
+void step_trace_report(uint8_t client);
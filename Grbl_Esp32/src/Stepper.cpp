@@ -26,10 +26,11 @@
 #include "Grbl.h"
 
 #include <atomic>
+#include <esp_heap_caps.h>
 
 // Stores the planner block Bresenham algorithm execution data for the segments in the segment
 // buffer. Normally, this buffer is partially in-use, but, for the worst case scenario, it will
-// never exceed the number of accessible stepper buffer segments (SEGMENT_BUFFER_SIZE-1).
+// never exceed the number of accessible stepper buffer segments (segment_buffer_size-1).
 // NOTE: This data is copied from the prepped planner blocks so that the planner blocks may be
 // discarded when entirely consumed and completed by the segment buffer. Also, AMASS alters this
 // data for its own use.
@@ -38,8 +39,24 @@ typedef struct {
     uint32_t step_event_count;
     uint8_t  direction_bits;
     uint8_t  is_pwm_rate_adjusted;  // Tracks motions that require constant laser power/rate
+    uint8_t  is_backlash_motion;    // Steps take up backlash and do not move the machine position
+#ifdef RASTER_ENGRAVING
+    uint32_t raster_line;      // Raster line engraved along the block, 0 for none
+    uint32_t raster_rate;      // Pixels per step event of step_event_count, 0.32 fixed point
+    uint32_t raster_rpm;       // rpm per power level, 16.16 fixed point
+    uint32_t raster_progress;  // Step events done, kept here so that it survives parking
+    uint16_t raster_pixels;
+    uint16_t raster_pixel;  // Pixel whose power is set, RASTER_NO_PIXEL after a segment load
+#endif
+#ifdef SYNC_USER_OUTPUTS
+    PlOutputs outputs;  // Made as the first segment of the block loads
+#endif
+#ifdef SYNC_COOLANT
+    CoolantState coolant;
+    bool         coolant_sync;  // Set coolant as the first segment of the block loads
+#endif
 } st_block_t;
-static st_block_t st_block_buffer[SEGMENT_BUFFER_SIZE - 1];
+static st_block_t* st_block_buffer;
 
 // Primary stepper segment ring buffer. Contains small, short line segments for the stepper
 // algorithm to execute, which are "checked-out" incrementally from the first block in the
@@ -51,8 +68,19 @@ typedef struct {
     uint8_t  st_block_index;  // Stepper block data index. Uses this information to execute this segment.
     uint8_t  amass_level;     // AMASS level for the ISR to execute this segment
     uint16_t spindle_rpm;     // TODO get rid of this.
+#ifdef LASER_STEP_POWER
+    int32_t spindle_rpm_step;  // Change of spindle_rpm per step event, 16.16 fixed point
+#endif
 } segment_t;
-static segment_t segment_buffer[SEGMENT_BUFFER_SIZE];
+static segment_t*           segment_buffer;
+static SpscRing<segment_t> segment_ring;  // Produced by the segment generator, consumed by the stepper ISR
+
+// Number of entries in segment_buffer, from $Stepper/SegmentBuffer at boot.
+// st_block_buffer has one entry less.
+static uint8_t segment_buffer_size = SEGMENT_BUFFER_SIZE;
+
+// Largest number of prepped segments seen waiting in the buffer since boot.
+static uint8_t segment_buffer_high_water;
 
 // Stepper ISR data struct. Contains the running data for the main stepper ISR.
 typedef struct {
@@ -71,22 +99,99 @@ typedef struct {
     uint8_t     exec_block_index;  // Tracks the current st_block index. Change indicates new block.
     st_block_t* exec_block;        // Pointer to the block data for the segment being executed
     segment_t*  exec_segment;      // Pointer to the segment being executed
+    int32_t*    position_counter;  // Where the steps of the executing block are counted
+#ifdef LASER_STEP_POWER
+    uint32_t spindle_rpm_fixed;  // Ramped spindle_rpm, 16.16 fixed point
+    uint16_t spindle_rpm;        // Last value given to the spindle
+#endif
 } stepper_t;
 static stepper_t st;
 
-// Step segment ring buffer indices
-static volatile uint8_t segment_buffer_tail;
-static uint8_t          segment_buffer_head;
-static uint8_t          segment_next_head;
+#ifdef DEFER_STEP_POSITION_UPDATES
+// Signed steps taken so far in the executing segment. Folded into sys_position by the ISR
+// when the segment completes. position_sequence is odd while a fold is in progress, so
+// readers on the other core can detect a torn read and retry.
+static int32_t               segment_position_delta[MAX_N_AXIS];
+static std::atomic<uint32_t> position_sequence;
+static int32_t* const        step_position_counter = segment_position_delta;
+#else
+static int32_t* const step_position_counter = sys_position;
+#endif
+static int32_t backlash_position_counter[MAX_N_AXIS];  // Absorbs the steps of backlash motions
+
+#ifdef PROBE_EDGE_CAPTURE
+// Step events the ISR has already counted into the position but not yet output, recorded on
+// every tick while probing. Event i goes out first + i * period timer ticks after the tick.
+typedef struct {
+    uint8_t  count;
+    uint8_t  direction_bits;
+    uint8_t  masks[PROBE_PENDING_MAX];
+    uint32_t first;
+    uint32_t period;
+} probe_pending_t;
+static probe_pending_t probe_pending;
+
+static void IRAM_ATTR st_probe_pending(const uint8_t* masks, uint32_t count, uint32_t first, uint32_t period) {
+    // Backlash steps are not counted into the machine position
+    probe_pending.count = st.position_counter == step_position_counter ? count : 0;
+    for (uint32_t i = 0; i < probe_pending.count; i++) {
+        probe_pending.masks[i] = masks[i];
+    }
+    probe_pending.direction_bits = st.exec_block->direction_bits;
+    probe_pending.first          = first;
+    probe_pending.period         = period;
+}
+
+// The probe pin interrupt is attached from the core the stepper timer interrupt runs on, so
+// the two never run at the same time and the position and pending events are consistent.
+void IRAM_ATTR st_get_probe_position(int32_t* position) {
+    st_get_position(position);
+    TIMERG0.hw_timer[STEP_TIMER_INDEX].update = 1;
+    uint32_t edge = TIMERG0.hw_timer[STEP_TIMER_INDEX].cnt_low + probe_pending.period / 2;
+    uint32_t time = probe_pending.first;
+    for (int i = 0; i < probe_pending.count; i++, time += probe_pending.period) {
+        if (time <= edge) {
+            continue;  // Out, or nearer to the edge than the step before it
+        }
+        for (int axis = 0; axis < st_config.n_axis; axis++) {
+            if (bitnum_istrue(probe_pending.masks[i], axis)) {
+                position[axis] -= 1 - (int32_t((probe_pending.direction_bits >> axis) & 1) << 1);
+            }
+        }
+    }
+}
+#endif
+
+// Counts the segments the ISR has finished, so that st_get_lookahead_position() can tell
+// when a slot it read may have been refilled under it.
+static std::atomic<uint32_t> segment_pops;
 
 // Used to avoid ISR nesting of the "Stepper Driver Interrupt". Should never occur though.
 static std::atomic<bool> busy;
 
+#ifdef USE_STEP_PULSE_TIMER
+// The next edge the pulse timer will produce. Both timer interrupts are registered on the
+// same core at the same level, so they never preempt each other.
+enum class PulsePhase : uint8_t {
+    Idle,
+    Step,    // Raise pulse_step_bits after the direction delay
+    Unstep,  // Clear the step pins at the end of the pulse
+};
+static volatile PulsePhase pulse_phase = PulsePhase::Idle;
+static uint8_t             pulse_step_bits;
+static uint64_t            pulse_step_time;  // esp_timer time the step pins were raised
+#endif
+
 // Pointers for the step segment being prepped from the planner buffer. Accessed only by the
 // main program. Pointers may be planning segments or planner blocks ahead of what being executed.
 static plan_block_t* pl_block;       // Pointer to the planner block being prepped
 static st_block_t*   st_prep_block;  // Pointer to the stepper block data being prepped
 
+#ifdef ENABLE_SEGMENT_PREP_TASK
+static SemaphoreHandle_t st_prep_mutex = NULL;
+static void              segmentPrepTask(void* pvParameters);
+#endif
+
 // esp32 work around for disable in main loop
 uint64_t stepper_idle_counter;  // used to count down until time to disable stepper drivers
 bool     stepper_idle;
@@ -118,13 +223,57 @@ typedef struct {
     float accelerate_until;  // Acceleration ramp end measured from end of block (mm)
     float decelerate_after;  // Deceleration ramp start measured from end of block (mm)
 
+#ifdef SHAPED_RAMPS
+    bool  scurve_ramp;    // The current ramp follows the S-curve or shaped velocity curve
+    float ramp_start_mm;  // Ramp start measured from end of block (mm)
+    float ramp_v0;        // Speed at the start of the ramp (mm/min)
+    float ramp_dv;        // Speed change over the ramp (mm/min)
+    float ramp_time;      // Duration of the ramp (min)
+    float ramp_elapsed;   // Time into the ramp at the end of the segment buffer (min)
+#endif
+#ifdef INPUT_SHAPING
+    float ramp_width;  // Duration of each of the shaper's partial ramps (min)
+#endif
+
+    // Profile of the executing block, added to plan_stats when it completes.
+    float stat_mm;             // Block length when loaded (mm)
+    float stat_nominal_speed;  // Nominal speed after overrides and axis limits (mm/min)
+    float stat_peak_speed;     // Highest speed the profile reaches (mm/min)
+    bool  stat_override;       // A feed or rapid override lowered the nominal speed
+    bool  stat_loaded;         // A block was loaded since the planner was last found empty
+
+#ifdef SPINDLE_SYNC
+    int64_t sync_start;  // Encoder count at which the synchronized block starts
+    int64_t sync_end;    // ... and ends, where the next block of a G33 chain starts
+#endif
+
     float inv_rate;  // Used by PWM laser mode to speed up segment calculations.
     //uint16_t current_spindle_pwm;  // todo remove
     float current_spindle_rpm;
+#ifdef CONSTANT_SURFACE_SPEED
+    float css_dt;  // Minutes prepared since the last G96 rpm change
+#endif
 
 } st_prep_t;
 static st_prep_t prep;
 
+#ifdef PRIME_HOLD_RESUME
+// The segments prepared for the resume from a feed hold, and the prep state from before them,
+// to put back if anything else comes first.
+static struct {
+    bool          primed;
+    uint8_t       head;  // Segment ring head before them
+    st_prep_t     prep;
+    plan_block_t* pl_block;
+    st_block_t*   st_prep_block;
+    plan_block_t* block;  // The held planner block, which prepping shortens ...
+    float         millimeters;
+    float         entry_speed_sqr;  // ... and gives the speed it was prepared from
+} hold_resume;
+#endif
+
+static void st_prep_buffer_locked();
+
 const char* stepper_names[] = {
     "Timed Steps",
     "RMT Steps",
@@ -134,6 +283,10 @@ const char* stepper_names[] = {
 
 stepper_id_t current_stepper = DEFAULT_STEPPER;
 
+DRAM_ATTR StepperRuntimeConfig st_config;
+
+DRAM_ATTR StepperIsrStats st_isr_stats = { 0, 0, 0, 0, INT32_MAX, 0, 0 };
+
 /* "The Stepper Driver Interrupt" - This timer interrupt is the workhorse of Grbl. Grbl employs
    the venerable Bresenham line algorithm to manage and exactly synchronize multi-axis moves.
    Unlike the popular DDA algorithm, the Bresenham algorithm is not susceptible to numerical
@@ -191,6 +344,99 @@ stepper_id_t current_stepper = DEFAULT_STEPPER;
 */
 
 static void stepper_pulse_func();
+#ifdef USE_RMT_BATCH_STEPS
+static void stepper_pulse_batch_func();
+#endif
+
+// Bresenham kernels, one per axis count. The axis count is a template parameter
+// so the compiler can fully unroll the loop; the position update uses the
+// direction bit arithmetically instead of branching on it. The kernel for the
+// configured number of axes is selected by st_update_runtime_config().
+template <int N>
+static uint8_t IRAM_ATTR bresenham_step() {
+    uint8_t  outbits          = 0;
+    uint32_t step_event_count = st.exec_block->step_event_count;
+    uint8_t  dir_bits         = st.exec_block->direction_bits;
+    for (int axis = 0; axis < N; axis++) {
+        st.counter[axis] += st.steps[axis];
+        if (st.counter[axis] > step_event_count) {
+            outbits |= bit(axis);
+            st.counter[axis] -= step_event_count;
+            // +1 when the direction bit is clear, -1 when it is set
+            st.position_counter[axis] += 1 - (int32_t((dir_bits >> axis) & 1) << 1);
+        }
+    }
+    return outbits;
+}
+
+#ifdef DEFER_STEP_POSITION_UPDATES
+// Moves the steps of the completed segment into sys_position.
+static void IRAM_ATTR st_commit_position() {
+    position_sequence++;
+    for (int axis = 0; axis < MAX_N_AXIS; axis++) {
+        sys_position[axis] += segment_position_delta[axis];
+        segment_position_delta[axis] = 0;
+    }
+    position_sequence++;
+}
+#endif
+
+void st_get_position(int32_t* position) {
+#ifdef DEFER_STEP_POSITION_UPDATES
+    uint32_t sequence;
+    do {
+        sequence = position_sequence;
+        for (int axis = 0; axis < MAX_N_AXIS; axis++) {
+            position[axis] = sys_position[axis] + segment_position_delta[axis];
+        }
+    } while ((sequence & 1) || sequence != position_sequence);
+#else
+    memcpy(position, sys_position, sizeof(sys_position));
+#endif
+}
+
+void st_get_lookahead_position(int32_t* position, uint32_t lead_us) {
+    uint32_t pops;
+    do {
+        pops = segment_pops;
+        st_get_position(position);
+
+        float   lead  = float(lead_us) * ticksPerMicrosecond;  // Timer ticks still to look ahead
+        uint8_t tail  = segment_ring.tail();
+        uint8_t head  = segment_ring.head();
+        uint8_t index = tail;
+        while (index != head && lead > 0) {
+            const segment_t&  segment = segment_ring[index];
+            const st_block_t& block   = st_block_buffer[segment.st_block_index];
+
+            // Only the rest of the executing segment is still ahead
+            uint32_t n_tick = (index == tail && st.exec_segment == &segment) ? st.step_count : segment.n_step;
+            float    ticks  = float(n_tick) * segment.isrPeriod;
+            float    events = n_tick;
+            if (ticks > lead) {
+                events *= lead / ticks;
+            }
+            lead -= ticks;
+
+            if (!block.is_backlash_motion && block.step_event_count) {
+                for (int axis = 0; axis < st_config.n_axis; axis++) {
+                    float steps = events * (block.steps[axis] >> segment.amass_level) / block.step_event_count;
+                    position[axis] += lroundf(bitnum_istrue(block.direction_bits, axis) ? -steps : steps);
+                }
+            }
+            index = segment_ring.next(index);
+        }
+    } while (pops != segment_pops);
+}
+
+typedef uint8_t (*bresenham_kernel_t)();
+
+static const bresenham_kernel_t bresenham_kernels[MAX_N_AXIS + 1] = {
+    bresenham_step<0>, bresenham_step<1>, bresenham_step<2>, bresenham_step<3>,
+    bresenham_step<4>, bresenham_step<5>, bresenham_step<6>,
+};
+
+static bresenham_kernel_t bresenham_kernel = bresenham_step<MAX_N_AXIS>;
 
 // TODO: Replace direct updating of the int32 position counters in the ISR somehow. Perhaps use smaller
 // int8 variables and update position counters only when a segment completes. This can get complicated
@@ -202,14 +448,248 @@ void IRAM_ATTR onStepperDriverTimer(void* para) {
     // needs to be explicitly cleared.
     TIMERG0.int_clr_timers.t0 = 1;
 
-    bool expected = false;
+    uint32_t start_cycles = xthal_get_ccount();
+    bool     expected     = false;
     if (busy.compare_exchange_strong(expected, true)) {
+#ifdef USE_RMT_BATCH_STEPS
+        if (current_stepper == ST_RMT) {
+            stepper_pulse_batch_func();
+        } else {
+            stepper_pulse_func();
+        }
+#else
         stepper_pulse_func();
+#endif
 
         TIMERG0.hw_timer[STEP_TIMER_INDEX].config.alarm_en = TIMER_ALARM_EN;
 
+        // The counter restarts from zero at each alarm, so the slack is what is
+        // left of the (possibly just rewritten) alarm value.
+        TIMERG0.hw_timer[STEP_TIMER_INDEX].update = 1;
+        int32_t  slack  = int32_t(TIMERG0.hw_timer[STEP_TIMER_INDEX].alarm_low - TIMERG0.hw_timer[STEP_TIMER_INDEX].cnt_low);
+        uint32_t cycles = xthal_get_ccount() - start_cycles;
+        st_isr_stats.ticks++;
+        st_isr_stats.cycles += cycles;
+        if (cycles > st_isr_stats.max_cycles) {
+            st_isr_stats.max_cycles = cycles;
+        }
+        if (cycles > st_isr_stats.recent_max_cycles) {
+            st_isr_stats.recent_max_cycles = cycles;
+        }
+        if (slack < st_isr_stats.min_slack) {
+            st_isr_stats.min_slack = slack;
+        }
+        if (slack < 0) {
+            st_isr_stats.skipped++;
+        }
+
         busy.store(false);
+    } else {
+        st_isr_stats.reentered++;
+    }
+}
+
+void st_reset_isr_stats() {
+    st_isr_stats = { 0, 0, 0, 0, INT32_MAX, 0, 0 };
+}
+
+DRAM_ATTR StepperUnderrunStats st_underrun_stats;
+
+void st_reset_underrun_stats() {
+    st_underrun_stats = {};
+}
+
+// Called with the segment buffer empty. The end of a cycle leaves the planner empty too, since
+// the last block is discarded once its segments are all prepped, and a hold ends its motion.
+static void IRAM_ATTR st_count_underrun() {
+    if (sys.state != State::Cycle || sys.step_control.endMotion) {
+        return;
     }
+    plan_block_t* block = plan_get_current_block();
+    if (block == NULL) {
+        return;
+    }
+    StepperUnderrun* underrun = &st_underrun_stats.recent[st_underrun_stats.count % STEPPER_UNDERRUN_HISTORY];
+    underrun->time_ms         = esp_timer_get_time() / 1000;
+#ifdef USE_LINE_NUMBERS
+    underrun->line = uint32_t(block->line_number);
+#else
+    underrun->line = 0;
+#endif
+    st_underrun_stats.count++;
+}
+
+#ifdef RASTER_ENGRAVING
+static const uint16_t RASTER_NO_PIXEL = 0xffff;
+
+// Sets the laser to the power of the pixel under it, if that pixel has changed.
+static void IRAM_ATTR st_raster_power() {
+    st_block_t* block = st.exec_block;
+    uint32_t    pixel = (uint64_t(block->raster_progress) * block->raster_rate) >> 32;
+    if (pixel >= block->raster_pixels) {
+        pixel = block->raster_pixels - 1;
+    }
+    if (pixel != block->raster_pixel) {
+        block->raster_pixel = pixel;
+        spindle->set_rpm((raster_levels(block->raster_line)[pixel] * block->raster_rpm) >> 16);
+    }
+}
+
+// Advances the raster line by count ISR ticks of the executing segment.
+static inline void IRAM_ATTR st_raster_step(uint32_t count) {
+    if (st.exec_block->raster_line) {
+        st.exec_block->raster_progress += count << (maxAmassLevel - st.exec_segment->amass_level);
+        st_raster_power();
+    }
+}
+#endif
+
+// Pops the next step segment from the stepper buffer and initializes the ISR state for it.
+// Returns false, after shutting the steppers down, if the buffer is empty.
+static bool IRAM_ATTR st_load_segment() {
+    auto n_axis = st_config.n_axis;
+
+    // Anything in the buffer? If so, load and initialize next step segment.
+    st.exec_segment = segment_ring.consumer_slot();
+    if (st.exec_segment != NULL) {
+        // Initialize new step segment and load number of steps to execute
+        // Initialize step segment timing per step and load number of steps to execute.
+        Stepper_Timer_WritePeriod(st.exec_segment->isrPeriod);
+        st.step_count = st.exec_segment->n_step;  // NOTE: Can sometimes be zero when moving slow.
+        // If the new segment starts a new planner block, initialize stepper variables and counters.
+        // NOTE: When the segment data index changes, this indicates a new planner block.
+        if (st.exec_block_index != st.exec_segment->st_block_index) {
+            st.exec_block_index = st.exec_segment->st_block_index;
+            st.exec_block       = &st_block_buffer[st.exec_block_index];
+            st.position_counter = st.exec_block->is_backlash_motion ? backlash_position_counter : step_position_counter;
+#ifdef AXIS_ENCODERS
+            axis_encoder_correct_steps(step_position_counter);
+#endif
+            // Initialize Bresenham line and distance counters
+            for (int axis = 0; axis < n_axis; axis++) {
+                st.counter[axis] = (st.exec_block->step_event_count >> 1);
+            }
+#ifdef RASTER_ENGRAVING
+            if (st.exec_block->raster_line) {
+                raster_release(st.exec_block->raster_line);
+            }
+#endif
+#ifdef SYNC_USER_OUTPUTS
+            sys_set_outputs(&st.exec_block->outputs);
+#endif
+#ifdef SYNC_COOLANT
+            if (st.exec_block->coolant_sync) {
+                coolant_set_state(st.exec_block->coolant);
+            }
+#endif
+        }
+        st.dir_outbits = st.exec_block->direction_bits;
+        // Adjust Bresenham axis increment counters according to AMASS level.
+        for (int axis = 0; axis < n_axis; axis++) {
+            st.steps[axis] = st.exec_block->steps[axis] >> st.exec_segment->amass_level;
+        }
+        // Set real-time spindle output as segment is loaded, just prior to the first step.
+#ifdef RASTER_ENGRAVING
+        if (st.exec_block->raster_line) {
+            st.exec_block->raster_pixel = RASTER_NO_PIXEL;
+            st_raster_power();
+        } else {
+            spindle->set_rpm(st.exec_segment->spindle_rpm);
+        }
+#else
+        spindle->set_rpm(st.exec_segment->spindle_rpm);
+#endif
+#ifdef LASER_STEP_POWER
+        st.spindle_rpm       = st.exec_segment->spindle_rpm;
+        st.spindle_rpm_fixed = uint32_t(st.spindle_rpm) << 16;
+#endif
+        return true;
+    }
+
+    // Segment buffer empty. Shutdown.
+    st_count_underrun();
+    st_go_idle();
+    if (sys.state != State::Jog) {  // added to prevent ... jog after probing crash
+        // Ensure pwm is set properly upon completion of rate-controlled motion.
+        if (st.exec_block != NULL && st.exec_block->is_pwm_rate_adjusted) {
+            spindle->set_rpm(0);
+        }
+#ifdef RASTER_ENGRAVING
+        if (st.exec_block != NULL && st.exec_block->raster_line) {
+            spindle->set_rpm(0);  // Or the last pixel would keep burning
+        }
+#endif
+    }
+    cycle_stop = true;
+    return false;
+}
+
+#ifdef USE_STEP_PULSE_TIMER
+static void IRAM_ATTR pulse_timer_arm(uint32_t microseconds) {
+    timer_set_counter_value(STEP_TIMER_GROUP, PULSE_TIMER_INDEX, 0x00000000ULL);
+    timer_set_alarm_value(STEP_TIMER_GROUP, PULSE_TIMER_INDEX, (uint64_t)microseconds * ticksPerMicrosecond);
+    TIMERG0.hw_timer[PULSE_TIMER_INDEX].config.alarm_en = TIMER_ALARM_EN;
+    timer_start(STEP_TIMER_GROUP, PULSE_TIMER_INDEX);
+}
+
+// One-shot pulse timer interrupt. Produces the step edge armed by stepper_pulse_func().
+static void IRAM_ATTR onStepPulseTimer(void* para) {
+    TIMERG0.int_clr_timers.t1 = 1;
+    timer_pause(STEP_TIMER_GROUP, PULSE_TIMER_INDEX);
+
+    if (pulse_phase == PulsePhase::Step) {
+        motors_step(pulse_step_bits);
+        pulse_step_time = esp_timer_get_time();
+        pulse_phase     = PulsePhase::Unstep;
+        pulse_timer_arm(st_config.pulse_microseconds);
+    } else {
+        motors_unstep();
+        pulse_phase = PulsePhase::Idle;
+    }
+}
+
+// Completes a pulse that is still in progress when the next step tick arrives, the way
+// the spin waits would have. Only happens if the step period is shorter than the direction
+// delay plus the pulse width.
+static void IRAM_ATTR pulse_timer_flush() {
+    timer_pause(STEP_TIMER_GROUP, PULSE_TIMER_INDEX);
+    if (pulse_phase == PulsePhase::Step) {
+        motors_step(pulse_step_bits);
+        pulse_step_time = esp_timer_get_time();
+    }
+    while (esp_timer_get_time() - pulse_step_time < st_config.pulse_microseconds) {
+        NOP();  // spin here until time to turn off step
+    }
+    motors_unstep();
+    pulse_phase = PulsePhase::Idle;
+}
+#endif
+
+#ifdef LASER_STEP_POWER
+// Moves the laser power along the segment's ramp by count step events.
+static inline void IRAM_ATTR st_ramp_spindle(uint32_t count) {
+    int32_t step = st.exec_segment->spindle_rpm_step;
+    if (step == 0) {
+        return;
+    }
+    // Wraps in between, but the sum over a segment stays within 16 bits of rpm.
+    st.spindle_rpm_fixed += uint32_t(step * int32_t(count));
+    uint16_t rpm = st.spindle_rpm_fixed >> 16;
+    if (rpm != st.spindle_rpm) {
+        st.spindle_rpm = rpm;
+        spindle->set_rpm(rpm);
+    }
+}
+#endif
+
+// Discards the completed segment and advances the segment indexing.
+static void IRAM_ATTR st_finish_segment() {
+#ifdef DEFER_STEP_POSITION_UPDATES
+    st_commit_position();
+#endif
+    st.exec_segment = NULL;
+    segment_ring.pop();
+    segment_pops++;
 }
 
 /**
@@ -220,10 +700,15 @@ void IRAM_ATTR onStepperDriverTimer(void* para) {
  * is to keep pulse timing as regular as possible.
  */
 static void stepper_pulse_func() {
-    auto n_axis = number_axis->get();
+#ifdef USE_STEP_PULSE_TIMER
+    if (pulse_phase != PulsePhase::Idle) {
+        pulse_timer_flush();
+    }
+    uint32_t step_delay = 0;  // Direction delay the pulse timer inserts ahead of the step
+#endif
 
     if (motors_direction(st.dir_outbits)) {
-        auto wait_direction = direction_delay_microseconds->get();
+        auto wait_direction = st_config.direction_delay_microseconds;
         if (wait_direction > 0) {
             // Stepper drivers need some time between changing direction and doing a pulse.
             switch (current_stepper) {
@@ -232,6 +717,9 @@ static void stepper_pulse_func() {
                     break;
                 case ST_I2S_STATIC:
                 case ST_TIMED: {
+#ifdef USE_STEP_PULSE_TIMER
+                    step_delay = wait_direction;
+#else
                     // wait for step pulse time to complete...some time expired during code above
                     //
                     // If we are using GPIO stepping as opposed to RMT, record the
@@ -241,6 +729,7 @@ static void stepper_pulse_func() {
                     while ((esp_timer_get_time() - direction_pulse_start_time) < 0) {
                         NOP();  // spin here until time to turn off step
                     }
+#endif
                     break;
                 }
                 case ST_RMT:
@@ -257,107 +746,215 @@ static void stepper_pulse_func() {
     //
     // NOTE: We could use direction_pulse_start_time + wait_direction, but let's play it safe
     uint64_t step_pulse_start_time = esp_timer_get_time();
+#ifdef USE_STEP_PULSE_TIMER
+    uint8_t step_bits = st.step_outbits;
+    if (step_delay > 0 && step_bits) {
+        // Let the pulse timer raise the step pins once the direction delay has passed.
+        pulse_step_bits = step_bits;
+        pulse_phase     = PulsePhase::Step;
+        pulse_timer_arm(step_delay);
+    } else {
+        motors_step(step_bits);
+    }
+#else
     motors_step(st.step_outbits);
+#endif
 
     // If there is no step segment, attempt to pop one from the stepper buffer
-    if (st.exec_segment == NULL) {
-        // Anything in the buffer? If so, load and initialize next step segment.
-        if (segment_buffer_head != segment_buffer_tail) {
-            // Initialize new step segment and load number of steps to execute
-            st.exec_segment = &segment_buffer[segment_buffer_tail];
-            // Initialize step segment timing per step and load number of steps to execute.
-            Stepper_Timer_WritePeriod(st.exec_segment->isrPeriod);
-            st.step_count = st.exec_segment->n_step;  // NOTE: Can sometimes be zero when moving slow.
-            // If the new segment starts a new planner block, initialize stepper variables and counters.
-            // NOTE: When the segment data index changes, this indicates a new planner block.
-            if (st.exec_block_index != st.exec_segment->st_block_index) {
-                st.exec_block_index = st.exec_segment->st_block_index;
-                st.exec_block       = &st_block_buffer[st.exec_block_index];
-                // Initialize Bresenham line and distance counters
-                for (int axis = 0; axis < n_axis; axis++) {
-                    st.counter[axis] = (st.exec_block->step_event_count >> 1);
-                }
-            }
-            st.dir_outbits = st.exec_block->direction_bits;
-            // Adjust Bresenham axis increment counters according to AMASS level.
-            for (int axis = 0; axis < n_axis; axis++) {
-                st.steps[axis] = st.exec_block->steps[axis] >> st.exec_segment->amass_level;
-            }
-            // Set real-time spindle output as segment is loaded, just prior to the first step.
-            spindle->set_rpm(st.exec_segment->spindle_rpm);
-        } else {
-            // Segment buffer empty. Shutdown.
-            st_go_idle();
-            if (sys.state != State::Jog) {  // added to prevent ... jog after probing crash
-                // Ensure pwm is set properly upon completion of rate-controlled motion.
-                if (st.exec_block != NULL && st.exec_block->is_pwm_rate_adjusted) {
-                    spindle->set_rpm(0);
-                }
-            }
-            cycle_stop = true;
-            return;  // Nothing to do but exit.
-        }
+    if (st.exec_segment == NULL && !st_load_segment()) {
+        return;  // Nothing to do but exit.
     }
+#ifndef PROBE_EDGE_CAPTURE
     // Check probing state.
     if (sys_probe_state == Probe::Active) {
         probe_state_monitor();
     }
-    // Reset step out bits.
-    st.step_outbits = 0;
-
-    for (int axis = 0; axis < n_axis; axis++) {
-        // Execute step displacement profile by Bresenham line algorithm
-        st.counter[axis] += st.steps[axis];
-        if (st.counter[axis] > st.exec_block->step_event_count) {
-            st.step_outbits |= bit(axis);
-            st.counter[axis] -= st.exec_block->step_event_count;
-            if (st.exec_block->direction_bits & bit(axis)) {
-                sys_position[axis]--;
-            } else {
-                sys_position[axis]++;
-            }
-        }
+#endif
+    // Execute step displacement profile by Bresenham line algorithm
+    st.step_outbits = bresenham_kernel();
+#ifdef PROBE_EDGE_CAPTURE
+    if (sys_probe_state == Probe::Active) {
+        // The step goes out at the next tick, one period from now.
+        TIMERG0.hw_timer[STEP_TIMER_INDEX].update = 1;
+        uint32_t period = TIMERG0.hw_timer[STEP_TIMER_INDEX].alarm_low;
+        st_probe_pending(&st.step_outbits, 1, period, period);
     }
+#endif
 
     // During a homing cycle, lock out and prevent desired axes from moving.
     if (sys.state == State::Homing) {
         st.step_outbits &= sys.homing_axis_lock;
     }
+#ifdef STEP_TRACE
+    step_trace_record(st.exec_segment->isrPeriod, st.step_outbits, st.dir_outbits);
+#endif
+#ifdef POSITION_CAPTURE
+    capture_sample(st.exec_segment->isrPeriod);
+#endif
+#ifdef LASER_STEP_POWER
+    st_ramp_spindle(1);
+#endif
+#ifdef RASTER_ENGRAVING
+    st_raster_step(1);
+#endif
     st.step_count--;  // Decrement step events count
     if (st.step_count == 0) {
         // Segment is complete. Discard current segment and advance segment indexing.
-        st.exec_segment = NULL;
-        if (++segment_buffer_tail == SEGMENT_BUFFER_SIZE) {
-            segment_buffer_tail = 0;
-        }
+        st_finish_segment();
     }
 
     switch (current_stepper) {
         case ST_I2S_STREAM:
             // Generate the number of pulses needed to span pulse_microseconds
-            i2s_out_push_sample(pulse_microseconds->get());
+            i2s_out_push_sample(st_config.pulse_microseconds);
             motors_unstep();
             break;
         case ST_I2S_STATIC:
         case ST_TIMED:
+#ifdef USE_STEP_PULSE_TIMER
+            // Let the pulse timer end the pulse, unless it is already raising it.
+            if (pulse_phase == PulsePhase::Idle && step_bits) {
+                uint64_t elapsed = esp_timer_get_time() - step_pulse_start_time;
+                if (elapsed < st_config.pulse_microseconds) {
+                    pulse_step_time = step_pulse_start_time;
+                    pulse_phase     = PulsePhase::Unstep;
+                    pulse_timer_arm(st_config.pulse_microseconds - elapsed);
+                } else {
+                    motors_unstep();
+                }
+            }
+#else
             // wait for step pulse time to complete...some time expired during code above
-            while (esp_timer_get_time() - step_pulse_start_time < pulse_microseconds->get()) {
+            while (esp_timer_get_time() - step_pulse_start_time < st_config.pulse_microseconds) {
                 NOP();  // spin here until time to turn off step
             }
             motors_unstep();
+#endif
             break;
         case ST_RMT:
             break;
     }
 }
 
+#ifdef USE_RMT_BATCH_STEPS
+// Batched RMT variant of stepper_pulse_func(). Each interrupt traces up to RMT_BATCH_MAX_STEPS
+// step events of the current segment, hands the step masks to the RMT channels, and sets the
+// timer to fire where the last of those step events ends. The pulses of one batch are placed
+// isrPeriod apart, exactly where the per-step interrupts would have put them, so the motion is
+// unchanged. Homing and probing run one step event per interrupt, like the normal ISR.
+static void IRAM_ATTR stepper_pulse_batch_func() {
+    if (st.exec_segment == NULL && !st_load_segment()) {
+        return;  // Nothing to do but exit.
+    }
+    // The RMT channels put the direction delay ahead of the first pulse, so no wait is needed here.
+    motors_direction(st.dir_outbits);
+
+    uint32_t isr_period = st.exec_segment->isrPeriod;
+    uint32_t rmt_period = isr_period * rmtTicksPerMicrosecond / ticksPerMicrosecond;
+    uint32_t rmt_delay  = st_config.direction_delay_microseconds * rmtTicksPerMicrosecond;
+    uint32_t count      = st.step_count < RMT_BATCH_MAX_STEPS ? st.step_count : RMT_BATCH_MAX_STEPS;
+    // An item's idle half can span the whole batch, and item durations are 15 bits.
+    const uint32_t max_duration = 0x7fff;
+    if (rmt_period > 0 && rmt_delay < max_duration) {
+        uint32_t fit = 1 + (max_duration - rmt_delay) / rmt_period;
+        if (count > fit) {
+            count = fit;
+        }
+    }
+#ifdef PROBE_EDGE_CAPTURE
+    if (sys.state == State::Homing) {
+        count = 1;
+    }
+#else
+    if (sys_probe_state == Probe::Active || sys.state == State::Homing) {
+        count = 1;
+    }
+#endif
+#ifdef RASTER_ENGRAVING
+    if (st.exec_block->raster_line) {
+        count = 1;  // The power can change at any step
+    }
+#endif
+    if (count == 0) {
+        count = 1;  // Same as the normal ISR for a segment with no step events.
+    }
+
+    uint8_t step_masks[RMT_BATCH_MAX_STEPS];
+    for (uint32_t i = 0; i < count; i++) {
+#ifndef PROBE_EDGE_CAPTURE
+        // Check probing state.
+        if (sys_probe_state == Probe::Active) {
+            probe_state_monitor();
+        }
+#endif
+        // Execute step displacement profile by Bresenham line algorithm
+        uint8_t outbits = bresenham_kernel();
+        // During a homing cycle, lock out and prevent desired axes from moving.
+        if (sys.state == State::Homing) {
+            outbits &= sys.homing_axis_lock;
+        }
+        step_masks[i] = outbits;
+#ifdef STEP_TRACE
+        step_trace_record(isr_period, outbits, st.dir_outbits);
+#endif
+#ifdef POSITION_CAPTURE
+        capture_sample(isr_period);
+#endif
+    }
+#ifdef PROBE_EDGE_CAPTURE
+    if (sys_probe_state == Probe::Active) {
+        st_probe_pending(step_masks, count, st_config.direction_delay_microseconds * ticksPerMicrosecond, isr_period);
+    }
+#endif
+    motors_step_batch(step_masks, count, rmt_period);
+    timer_set_alarm_value(STEP_TIMER_GROUP, STEP_TIMER_INDEX, (uint64_t)isr_period * count);
+
+#ifdef LASER_STEP_POWER
+    st_ramp_spindle(count);
+#endif
+    st.step_count -= count;
+    if (st.step_count == 0) {
+        st_finish_segment();
+    }
+}
+#endif
+
+static void st_idle_time_changed(Setting* setting) {
+    st_config.idle_lock_time = stepper_idle_lock_time->get();
+}
+
 void stepper_init() {
-    busy.store(false); 
-    
+    busy.store(false);
+    st_update_runtime_config();
+    stepper_idle_lock_time->onChange(st_idle_time_changed);
+
+    // The ring buffers are sized once at boot, so a change to the setting needs a restart.
+    segment_buffer_size = stepper_segment_buffer_size->get();
+    segment_buffer =
+        (segment_t*)heap_alloc(HeapTag::Stepper, segment_buffer_size * sizeof(segment_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    segment_ring.attach(segment_buffer, segment_buffer_size);
+    st_block_buffer =
+        (st_block_t*)heap_alloc(HeapTag::Stepper, (segment_buffer_size - 1) * sizeof(st_block_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Segment buffer %d", segment_buffer_size);
+
+#ifdef ENABLE_SEGMENT_PREP_TASK
+    st_prep_mutex = xSemaphoreCreateRecursiveMutex();
+    heap_task_create(segmentPrepTask,             // task
+                     "segmentPrepTask",           // name for task
+                     4096,                        // size of task stack
+                     NULL,                        // parameters
+                     SEGMENT_PREP_TASK_PRIORITY,  // priority
+                     NULL,                        // handle
+                     SEGMENT_PREP_TASK_CORE       // core
+    );
+#endif
+
     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Axis count %d", number_axis->get());
     grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "%s", stepper_names[current_stepper]);
 
 #ifdef USE_I2S_STEPS
+    st_update_i2s_config();
+    grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "I2S DMA %d x %d bytes", i2s_dmabuf_count->get(), i2s_dmabuf_len->get());
     // I2S stepper stream mode use callback but timer interrupt
     i2s_out_set_pulse_callback(stepper_pulse_func);
 #endif
@@ -373,6 +970,7 @@ void stepper_switch(stepper_id_t new_stepper) {
     }
 #ifdef USE_I2S_STEPS
     if (current_stepper == ST_I2S_STREAM) {
+        i2s_out_set_unified(false);  // The other steppers write the pins in the passthrough mode
         if (i2s_out_get_pulser_status() != PASSTHROUGH) {
             // Called during streaming. Stop streaming.
             grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Debug, "Stop the I2S streaming and switch to the passthrough mode.");
@@ -382,7 +980,33 @@ void stepper_switch(stepper_id_t new_stepper) {
     }
 #endif
     current_stepper = new_stepper;
+#ifdef USE_I2S_STEPS
+    if (current_stepper == ST_I2S_STREAM) {
+        i2s_out_set_unified(i2s_unified->get());
+    }
+#endif
+}
+
+void st_update_runtime_config() {
+    st_config.n_axis                       = number_axis->get();
+    st_config.pulse_microseconds           = pulse_microseconds->get();
+    st_config.direction_delay_microseconds = direction_delay_microseconds->get();
+
+    bresenham_kernel = bresenham_kernels[st_config.n_axis > MAX_N_AXIS ? MAX_N_AXIS : st_config.n_axis];
+}
+
+#ifdef USE_I2S_STEPS
+void st_update_i2s_config() {
+    if (i2s_dmabuf_count == NULL || i2s_dmabuf_len == NULL || i2s_adaptive_latency == NULL || i2s_unified == NULL) {
+        return;  // Settings are still being created
+    }
+    if (i2s_out_set_dma_geometry(i2s_dmabuf_count->get(), i2s_dmabuf_len->get()) != 0) {
+        grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "I2S DMA buffers unchanged until restart");
+    }
+    i2s_out_set_adaptive_latency(i2s_adaptive_latency->get());
+    i2s_out_set_unified(current_stepper == ST_I2S_STREAM && i2s_unified->get());
 }
+#endif
 
 // enabled. Startup init and limits call this function but shouldn't start the cycle.
 void st_wake_up() {
@@ -392,6 +1016,7 @@ void st_wake_up() {
     stepper_idle = false;
 
     // Initialize step pulse timing from settings. Here to ensure updating after re-writing.
+    st_update_runtime_config();
 #ifdef USE_RMT_STEPS
     // Step pulse delay handling is not require with ESP32...the RMT function does it.
     if (direction_delay_microseconds->get() < 1)
@@ -413,6 +1038,7 @@ void st_reset() {
 #ifdef ESP_DEBUG
     //Serial.println("st_reset()");
 #endif
+    st_prep_lock();
     // Initialize stepper driver idle state.
 #ifdef USE_I2S_STEPS
     if (current_stepper == ST_I2S_STREAM) {
@@ -420,17 +1046,27 @@ void st_reset() {
     }
 #endif
     st_go_idle();
+#ifdef DEFER_STEP_POSITION_UPDATES
+    // Keep the steps of a segment that was cut short.
+    st_commit_position();
+#endif
     // Initialize stepper algorithm variables.
     memset(&prep, 0, sizeof(st_prep_t));
+#ifdef PRIME_HOLD_RESUME
+    hold_resume.primed = false;
+#endif
     memset(&st, 0, sizeof(stepper_t));
+#ifdef RASTER_ENGRAVING
+    raster_reset();
+#endif
     st.exec_segment     = NULL;
+    st.position_counter = step_position_counter;
     pl_block            = NULL;  // Planner block pointer used by segment buffer
-    segment_buffer_tail = 0;
-    segment_buffer_head = 0;  // empty = tail
-    segment_next_head   = 1;
+    segment_ring.reset();  // empty, head = tail
     st.step_outbits     = 0;
     st.dir_outbits      = 0;  // Initialize direction bits to default.
     // TODO do we need to turn step pins off?
+    st_prep_unlock();
 }
 
 // Stepper shutdown
@@ -439,7 +1075,7 @@ void st_go_idle() {
     Stepper_Timer_Stop();
 
     // Set stepper driver idle state, disabled or enabled, depending on settings and circumstances.
-    if (((stepper_idle_lock_time->get() != 0xff) || sys_rt_exec_alarm != ExecAlarm::None || sys.state == State::Sleep) &&
+    if (((st_config.idle_lock_time != 0xff) || sys_rt_exec_alarm != ExecAlarm::None || sys.state == State::Sleep) &&
         sys.state != State::Homing) {
         // Force stepper dwell to lock axes for a defined amount of time to ensure the axes come to a complete
         // stop and not drift from residual inertial forces at the end of the last movement.
@@ -448,7 +1084,7 @@ void st_go_idle() {
             motors_set_disable(true);
         } else {
             stepper_idle         = true;  // esp32 work around for disable in main loop
-            stepper_idle_counter = esp_timer_get_time() + (stepper_idle_lock_time->get() * 1000);  // * 1000 because the time is in uSecs
+            stepper_idle_counter = esp_timer_get_time() + (st_config.idle_lock_time * 1000);  // * 1000 because the time is in uSecs
             // after idle countdown will be disabled in protocol loop
         }
     } else {
@@ -459,18 +1095,77 @@ void st_go_idle() {
     st.step_outbits = 0;
 }
 
+#ifdef PRIME_HOLD_RESUME
+static void st_discard_primed_resume_locked() {
+    if (!hold_resume.primed) {
+        return;
+    }
+    hold_resume.primed = false;
+    segment_ring.rewind(hold_resume.head);
+    prep                               = hold_resume.prep;
+    pl_block                           = hold_resume.pl_block;
+    st_prep_block                      = hold_resume.st_prep_block;
+    hold_resume.block->millimeters     = hold_resume.millimeters;
+    hold_resume.block->entry_speed_sqr = hold_resume.entry_speed_sqr;
+}
+
+void st_discard_primed_resume() {
+    st_prep_lock();
+    st_discard_primed_resume_locked();
+    st_prep_unlock();
+}
+
+// Called once a feed hold has stopped the steppers and the plan has been reinitialized from the
+// stop. The segments go no further than the held block, since a block that is fully prepared
+// leaves the planner and could not be taken back.
+void st_prime_resume() {
+    st_prep_lock();
+    plan_block_t* block = plan_get_current_block();
+#    ifdef ADAPTIVE_SEGMENT_DURATION
+    float dt_max = MAX(DT_SEGMENT_RAMP, DT_SEGMENT_CRUISE);
+#    else
+    float dt_max = DT_SEGMENT;
+#    endif
+    if (!hold_resume.primed && segment_ring.empty() && block != NULL &&
+        block->millimeters > plan_get_block_rapid_rate(block) * dt_max * segment_ring.capacity()) {
+        hold_resume = { true, segment_ring.head(), prep, pl_block, st_prep_block, block, block->millimeters, block->entry_speed_sqr };
+        sys.step_control.endMotion = false;
+        st_prep_buffer_locked();
+        sys.step_control.endMotion = true;  // Nothing more until cycle start
+    }
+    st_prep_unlock();
+}
+
+bool st_take_primed_resume() {
+    st_prep_lock();
+    bool primed        = hold_resume.primed;
+    hold_resume.primed = false;
+    st_prep_unlock();
+    return primed;
+}
+#endif
+
 // Called by planner_recalculate() when the executing block is updated by the new plan.
 void st_update_plan_block_parameters() {
+    st_prep_lock();
+#ifdef PRIME_HOLD_RESUME
+    st_discard_primed_resume_locked();  // They were prepared from the old plan
+#endif
     if (pl_block != NULL) {  // Ignore if at start of a new block.
         prep.recalculate_flag.recalculate = 1;
         pl_block->entry_speed_sqr         = prep.current_speed * prep.current_speed;  // Update entry speed.
         pl_block                          = NULL;  // Flag st_prep_segment() to load and check active velocity profile.
     }
+    st_prep_unlock();
 }
 
 #ifdef PARKING_ENABLE
 // Changes the run state of the step segment buffer to execute the special parking motion.
 void st_parking_setup_buffer() {
+    st_prep_lock();
+#    ifdef PRIME_HOLD_RESUME
+    st_discard_primed_resume_locked();
+#    endif
     // Store step execution data of partially completed block, if necessary.
     if (prep.recalculate_flag.holdPartialBlock) {
         prep.last_st_block_index  = prep.st_block_index;
@@ -482,10 +1177,12 @@ void st_parking_setup_buffer() {
     prep.recalculate_flag.parking     = 1;
     prep.recalculate_flag.recalculate = 0;
     pl_block                          = NULL;  // Always reset parking motion to reload new block.
+    st_prep_unlock();
 }
 
 // Restores the step segment buffer to the normal run state after a parking motion.
 void st_parking_restore_buffer() {
+    st_prep_lock();
     // Restore step execution data and flags of partially completed block, if necessary.
     if (prep.recalculate_flag.holdPartialBlock) {
         st_prep_block                          = &st_block_buffer[prep.last_st_block_index];
@@ -501,13 +1198,135 @@ void st_parking_restore_buffer() {
     }
 
     pl_block = NULL;  // Set to reload next block.
+    st_prep_unlock();
+}
+#endif
+
+#ifdef S_CURVE_ACCELERATION
+// Sets up a jerk-limited ramp from speed v0 at start_mm to speed v1 at end_mm, both measured
+// from the end of the block. The speed follows v0 + dv * s(u), where s(u) = 3u^2 - 2u^3 and u
+// is the fraction of the ramp time elapsed. s(u) averages 1/2, so the ramp takes the same time
+// and covers the same distance as the linear ramp the planner computed.
+static void st_scurve_begin(float v0, float v1, float start_mm, float end_mm) {
+    float v_sum      = v0 + v1;
+    prep.scurve_ramp = (v_sum > 0.0f) && (start_mm > end_mm);
+    if (prep.scurve_ramp) {
+        prep.ramp_start_mm = start_mm;
+        prep.ramp_v0       = v0;
+        prep.ramp_dv       = v1 - v0;
+        prep.ramp_time     = 2.0f * (start_mm - end_mm) / v_sum;
+        prep.ramp_elapsed  = 0.0f;
+    }
+}
+
+// Moves along the ramp to time t. Sets the current speed and returns the distance from the end
+// of the block. The distance along the ramp is the integral of the speed: v0*t + dv*T*(u^3 - u^4/2).
+static float st_scurve_advance(float t) {
+    float u            = t / prep.ramp_time;
+    float u2           = u * u;
+    prep.ramp_elapsed  = t;
+    prep.current_speed = prep.ramp_v0 + prep.ramp_dv * u2 * (3.0f - 2.0f * u);
+    return prep.ramp_start_mm - (prep.ramp_v0 * t + prep.ramp_dv * prep.ramp_time * u2 * u * (1.0f - 0.5f * u));
+}
+#endif
+
+#ifdef INPUT_SHAPING
+// Impulses of the shaper, with ascending times. Reloaded from the settings at the start of
+// every ramp, so a change takes effect at the next ramp and never part way through one.
+typedef struct {
+    uint8_t count;
+    float   amplitude[3];  // Shares of the speed change, adding up to 1
+    float   time[3];       // Delay of each impulse from the start of the ramp (min)
+} shaper_t;
+static shaper_t shaper;
+
+static void st_shaper_load() {
+    float zeta = shaper_damping->get();
+    float root = sqrtf(1.0f - zeta * zeta);
+    float K    = expf(-zeta * 3.14159265f / root);
+    float half = 0.5f / (shaper_frequency->get() * root * 60.0f);  // Half the damped period (min)
+    float V    = 0.05f;                                             // Vibration the EI shaper allows
+
+    switch (static_cast<InputShaper>(shaper_type->get())) {
+        case InputShaper::ZV:
+            shaper = { 2, { 1.0f, K }, { 0.0f, half } };
+            break;
+        case InputShaper::ZVD:
+            shaper = { 3, { 1.0f, 2.0f * K, K * K }, { 0.0f, half, 2.0f * half } };
+            break;
+        case InputShaper::EI:
+            shaper = { 3, { 0.25f * (1.0f + V), 0.5f * (1.0f - V) * K, 0.25f * (1.0f + V) * K * K }, { 0.0f, half, 2.0f * half } };
+            break;
+        default:
+            shaper = { 1, { 1.0f }, { 0.0f } };
+            break;
+    }
+    float sum = 0.0f;
+    for (int i = 0; i < shaper.count; i++) {
+        sum += shaper.amplitude[i];
+    }
+    for (int i = 0; i < shaper.count; i++) {
+        shaper.amplitude[i] /= sum;
+    }
+}
+
+// Sets up a shaped ramp from speed v0 at start_mm to speed v1 at end_mm, both measured from the
+// end of the block. The speed change is split into the shaper's impulses, each one a linear ramp
+// of ramp_width that starts at the impulse time, and the last one ends with the ramp. The delayed
+// shares cover less distance than the planner's linear ramp, so the ramp time is recomputed to
+// cover start_mm - end_mm exactly. Ramps too short for the shaper are left linear.
+static void st_scurve_begin(float v0, float v1, float start_mm, float end_mm) {
+    st_shaper_load();
+    float v_sum  = v0 + v1;
+    float dv     = v1 - v0;
+    float span   = shaper.time[shaper.count - 1];
+    float center = 0.0f;  // Amplitude-weighted mean delay of the impulses
+    for (int i = 0; i < shaper.count; i++) {
+        center += shaper.amplitude[i] * shaper.time[i];
+    }
+    prep.scurve_ramp = false;
+    if (shaper.count > 1 && v_sum > 0.0f && start_mm > end_mm) {
+        float ramp_time = 2.0f * (start_mm - end_mm - dv * (0.5f * span - center)) / v_sum;
+        if (ramp_time > span) {
+            prep.scurve_ramp   = true;
+            prep.ramp_start_mm = start_mm;
+            prep.ramp_v0       = v0;
+            prep.ramp_dv       = dv;
+            prep.ramp_time     = ramp_time;
+            prep.ramp_width    = ramp_time - span;
+            prep.ramp_elapsed  = 0.0f;
+        }
+    }
+}
+
+// Moves along the ramp to time t. Sets the current speed and returns the distance from the end
+// of the block. Each impulse adds its share of the speed change once its own ramp has started.
+static float st_scurve_advance(float t) {
+    float share = 0.0f;  // Share of the speed change reached
+    float area  = 0.0f;  // Integral of share over time, in units of ramp_width
+    for (int i = 0; i < shaper.count; i++) {
+        float u = (t - shaper.time[i]) / prep.ramp_width;
+        if (u <= 0.0f) {
+            break;
+        }
+        if (u < 1.0f) {
+            share += shaper.amplitude[i] * u;
+            area += shaper.amplitude[i] * 0.5f * u * u;
+        } else {
+            share += shaper.amplitude[i];
+            area += shaper.amplitude[i] * (u - 0.5f);
+        }
+    }
+    prep.ramp_elapsed  = t;
+    prep.current_speed = prep.ramp_v0 + prep.ramp_dv * share;
+    return prep.ramp_start_mm - (prep.ramp_v0 * t + prep.ramp_dv * prep.ramp_width * area);
 }
 #endif
 
 // Increments the step segment buffer block data ring buffer.
 static uint8_t st_next_block_index(uint8_t block_index) {
     block_index++;
-    return block_index == (SEGMENT_BUFFER_SIZE - 1) ? 0 : block_index;
+    return block_index == (segment_buffer_size - 1) ? 0 : block_index;
 }
 
 /* Prepares step segment buffer. Continuously called from main program.
@@ -523,13 +1342,78 @@ static uint8_t st_next_block_index(uint8_t block_index) {
    Currently, the segment buffer conservatively holds roughly up to 40-50 msec of steps.
    NOTE: Computation units are in steps, millimeters, and minutes.
 */
+static void st_prep_buffer_locked();
+
 void st_prep_buffer() {
+    TRACE_SCOPE(PrepBuffer, segment_ring.count());
+    st_prep_lock();
+    st_prep_buffer_locked();
+    st_prep_unlock();
+}
+
+// Adds the profile of the planner block that just finished to plan_stats.
+static void st_record_block_stats() {
+    if (pl_block->motion.systemMotion || pl_block->motion.backlashMotion) {
+        return;
+    }
+    float programmed = pl_block->programmed_rate;
+    plan_stats.mm += prep.stat_mm;
+    plan_stats.programmed_mm += programmed * prep.stat_mm;
+    plan_stats.planned_mm += prep.stat_peak_speed * prep.stat_mm;
+    if (prep.stat_peak_speed < 0.99f * prep.stat_nominal_speed) {
+        plan_stats.accel_limited++;
+    }
+    if (prep.stat_override && prep.stat_nominal_speed < programmed) {
+        plan_stats.override_limited++;
+    }
+}
+
+#ifdef SPINDLE_SYNC
+// Time over which a synchronized block closes its position error to the spindle (min).
+const float SPINDLE_SYNC_RESPONSE = 0.05f / 60.0f;
+
+void st_spindle_sync_start(int64_t origin) {
+    st_prep_lock();
+    prep.sync_end = origin;
+    st_prep_unlock();
+}
+
+int64_t st_spindle_sync_end() {
+    return prep.sync_end;
+}
+
+// A synchronized block follows the spindle instead of its velocity profile. Each segment cruises
+// at the speed that brings the block to where the encoder says it should be. The segment runs
+// after the ones already queued, so it aims for where the spindle will be by then. Acceleration
+// and the stop at the end of the block stay limited; where the spindle changes speed faster
+// than the axes can follow, the tool lags and catches up.
+static void st_spindle_sync_speed(float dt_segment) {
+    float rpm      = spindle_encoder_rpm();
+    float lead     = segment_ring.count() * dt_segment;
+    float turns    = float(spindle_encoder_count() - prep.sync_start) / SPINDLE_ENCODER_CPR + rpm * lead;
+    float position = prep.stat_mm - pl_block->millimeters;
+    float speed    = rpm * pl_block->sync_pitch + (turns * pl_block->sync_pitch - position) / SPINDLE_SYNC_RESPONSE;
+
+    float dv   = pl_block->acceleration * dt_segment;
+    float stop = sqrtf(prep.exit_speed * prep.exit_speed + 2.0f * pl_block->acceleration * pl_block->millimeters);
+    speed      = constrain(speed, prep.current_speed - dv, prep.current_speed + dv);
+    speed      = MIN(speed, MIN(stop, plan_get_block_rapid_rate(pl_block)));
+    speed      = MAX(speed, float(MINIMUM_FEED_RATE));  // A segment needs a step to end
+
+    prep.ramp_type        = RAMP_CRUISE;
+    prep.current_speed    = speed;
+    prep.maximum_speed    = speed;
+    prep.decelerate_after = 0.0f;
+}
+#endif
+
+static void st_prep_buffer_locked() {
     // Block step prep buffer, while in a suspend state and there is no suspend motion to execute.
     if (sys.step_control.endMotion) {
         return;
     }
 
-    while (segment_buffer_tail != segment_next_head) {  // Check if we need to fill the buffer.
+    while (!segment_ring.full()) {  // Check if we need to fill the buffer.
         // Determine if we need to load a new planner block or if the block needs to be recomputed.
         if (pl_block == NULL) {
             // Query planner for a queued block
@@ -540,8 +1424,13 @@ void st_prep_buffer() {
             }
 
             if (pl_block == NULL) {
+                if (prep.stat_loaded && sys.state == State::Cycle) {
+                    plan_stats.starved++;
+                }
+                prep.stat_loaded = false;
                 return;  // No planner blocks. Exit.
             }
+            prep.stat_loaded = true;
 
             // Check if we need to only recompute the velocity profile or load a new block.
             if (prep.recalculate_flag.recalculate) {
@@ -561,7 +1450,15 @@ void st_prep_buffer() {
                 // when the segment buffer completes the planner block, it may be discarded when the
                 // segment buffer finishes the prepped block, but the stepper ISR is still executing it.
                 st_prep_block                 = &st_block_buffer[prep.st_block_index];
-                st_prep_block->direction_bits = pl_block->direction_bits;
+                st_prep_block->direction_bits     = pl_block->direction_bits;
+                st_prep_block->is_backlash_motion = pl_block->motion.backlashMotion;
+#ifdef SYNC_USER_OUTPUTS
+                st_prep_block->outputs = pl_block->outputs;
+#endif
+#ifdef SYNC_COOLANT
+                st_prep_block->coolant      = pl_block->coolant;
+                st_prep_block->coolant_sync = pl_block->coolant_sync;
+#endif
                 uint8_t idx;
                 auto    n_axis = number_axis->get();
 
@@ -577,14 +1474,17 @@ void st_prep_buffer() {
                 prep.steps_remaining  = (float)pl_block->step_event_count;
                 prep.step_per_mm      = prep.steps_remaining / pl_block->millimeters;
                 prep.req_mm_increment = REQ_MM_INCREMENT_SCALAR / prep.step_per_mm;
-                prep.dt_remainder     = 0.0;  // Reset for new segment block
+                prep.dt_remainder     = 0.0f;  // Reset for new segment block
+                prep.stat_mm          = pl_block->millimeters;
+                prep.stat_peak_speed  = prep.stat_nominal_speed = 0.0f;  // Stays zero if a hold takes over the profile
+                prep.stat_override    = false;
                 if ((sys.step_control.executeHold) || prep.recalculate_flag.decelOverride) {
                     // New block loaded mid-hold. Override planner block entry speed to enforce deceleration.
                     prep.current_speed                  = prep.exit_speed;
                     pl_block->entry_speed_sqr           = prep.exit_speed * prep.exit_speed;
                     prep.recalculate_flag.decelOverride = 0;
                 } else {
-                    prep.current_speed = sqrt(pl_block->entry_speed_sqr);
+                    prep.current_speed = sqrtf(pl_block->entry_speed_sqr);
                 }
 
                 st_prep_block->is_pwm_rate_adjusted = false;  // set default value
@@ -592,10 +1492,30 @@ void st_prep_buffer() {
                 if (spindle->inLaserMode()) {  //
                     if (pl_block->spindle == SpindleState::Ccw) {
                         // Pre-compute inverse programmed rate to speed up PWM updating per step segment.
-                        prep.inv_rate                       = 1.0 / pl_block->programmed_rate;
+                        prep.inv_rate                       = 1.0f / pl_block->programmed_rate;
                         st_prep_block->is_pwm_rate_adjusted = true;
                     }
                 }
+#ifdef RASTER_ENGRAVING
+                st_prep_block->raster_line = pl_block->raster_line;
+                if (pl_block->raster_line) {
+                    // The power follows the pixels, as a share of S, not the speed.
+                    st_prep_block->is_pwm_rate_adjusted = false;
+                    uint64_t rate = (uint64_t(pl_block->raster_pixels) << 32) / st_prep_block->step_event_count;
+                    st_prep_block->raster_rate     = rate > UINT32_MAX ? UINT32_MAX : rate;
+                    st_prep_block->raster_rpm      = pl_block->spindle == SpindleState::Disable
+                                                         ? 0
+                                                         : uint32_t(MIN(pl_block->spindle_speed, 65535.0f) * 65536.0f / 255.0f);
+                    st_prep_block->raster_progress = 0;
+                    st_prep_block->raster_pixels   = pl_block->raster_pixels;
+                }
+#endif
+#ifdef SPINDLE_SYNC
+                if (pl_block->sync_pitch != 0.0f) {
+                    prep.sync_start = prep.sync_end;
+                    prep.sync_end += lroundf(pl_block->millimeters / pl_block->sync_pitch * SPINDLE_ENCODER_CPR);
+                }
+#endif
             }
             /* ---------------------------------------------------------------------------------
              Compute the velocity profile of a new planner block based on its entry and exit
@@ -603,20 +1523,23 @@ void st_prep_buffer() {
              planner has updated it. For a commanded forced-deceleration, such as from a feed
              hold, override the planner velocities and decelerate to the target exit speed.
             */
-            prep.mm_complete  = 0.0;  // Default velocity profile complete at 0.0mm from end of block.
-            float inv_2_accel = 0.5 / pl_block->acceleration;
+            prep.mm_complete  = 0.0f;  // Default velocity profile complete at 0.0mm from end of block.
+            float inv_2_accel = 0.5f / pl_block->acceleration;
             if (sys.step_control.executeHold) {  // [Forced Deceleration to Zero Velocity]
                 // Compute velocity profile parameters for a feed hold in-progress. This profile overrides
                 // the planner block profile, enforcing a deceleration to zero speed.
                 prep.ramp_type = RAMP_DECEL;
+#ifdef SHAPED_RAMPS
+                prep.scurve_ramp = false;  // Feed holds decelerate linearly
+#endif
                 // Compute decelerate distance relative to end of block.
                 float decel_dist = pl_block->millimeters - inv_2_accel * pl_block->entry_speed_sqr;
-                if (decel_dist < 0.0) {
+                if (decel_dist < 0.0f) {
                     // Deceleration through entire planner block. End of feed hold is not in this block.
-                    prep.exit_speed = sqrt(pl_block->entry_speed_sqr - 2 * pl_block->acceleration * pl_block->millimeters);
+                    prep.exit_speed = sqrtf(pl_block->entry_speed_sqr - 2 * pl_block->acceleration * pl_block->millimeters);
                 } else {
                     prep.mm_complete = decel_dist;  // End of feed hold.
-                    prep.exit_speed  = 0.0;
+                    prep.exit_speed  = 0.0f;
                 }
             } else {  // [Normal Operation]
                 // Compute or recompute velocity profile parameters of the prepped planner block.
@@ -625,23 +1548,23 @@ void st_prep_buffer() {
                 float exit_speed_sqr;
                 float nominal_speed;
                 if (sys.step_control.executeSysMotion) {
-                    prep.exit_speed = exit_speed_sqr = 0.0;  // Enforce stop at end of system motion.
+                    prep.exit_speed = exit_speed_sqr = 0.0f;  // Enforce stop at end of system motion.
                 } else {
                     exit_speed_sqr  = plan_get_exec_block_exit_speed_sqr();
-                    prep.exit_speed = sqrt(exit_speed_sqr);
+                    prep.exit_speed = sqrtf(exit_speed_sqr);
                 }
 
                 nominal_speed            = plan_compute_profile_nominal_speed(pl_block);
                 float nominal_speed_sqr  = nominal_speed * nominal_speed;
-                float intersect_distance = 0.5 * (pl_block->millimeters + inv_2_accel * (pl_block->entry_speed_sqr - exit_speed_sqr));
+                float intersect_distance = 0.5f * (pl_block->millimeters + inv_2_accel * (pl_block->entry_speed_sqr - exit_speed_sqr));
                 if (pl_block->entry_speed_sqr > nominal_speed_sqr) {  // Only occurs during override reductions.
                     prep.accelerate_until = pl_block->millimeters - inv_2_accel * (pl_block->entry_speed_sqr - nominal_speed_sqr);
-                    if (prep.accelerate_until <= 0.0) {  // Deceleration-only.
+                    if (prep.accelerate_until <= 0.0f) {  // Deceleration-only.
                         prep.ramp_type = RAMP_DECEL;
                         // prep.decelerate_after = pl_block->millimeters;
                         // prep.maximum_speed = prep.current_speed;
                         // Compute override block exit speed since it doesn't match the planner exit speed.
-                        prep.exit_speed = sqrt(pl_block->entry_speed_sqr - 2 * pl_block->acceleration * pl_block->millimeters);
+                        prep.exit_speed = sqrtf(pl_block->entry_speed_sqr - 2 * pl_block->acceleration * pl_block->millimeters);
                         prep.recalculate_flag.decelOverride = 1;  // Flag to load next block as deceleration override.
                         // TODO: Determine correct handling of parameters in deceleration-only.
                         // Can be tricky since entry speed will be current speed, as in feed holds.
@@ -652,7 +1575,7 @@ void st_prep_buffer() {
                         prep.maximum_speed    = nominal_speed;
                         prep.ramp_type        = RAMP_DECEL_OVERRIDE;
                     }
-                } else if (intersect_distance > 0.0) {
+                } else if (intersect_distance > 0.0f) {
                     if (intersect_distance < pl_block->millimeters) {  // Either trapezoid or triangle types
                         // NOTE: For acceleration-cruise and cruise-only types, following calculation will be 0.0.
                         prep.decelerate_after = inv_2_accel * (nominal_speed_sqr - exit_speed_sqr);
@@ -668,7 +1591,7 @@ void st_prep_buffer() {
                         } else {  // Triangle type
                             prep.accelerate_until = intersect_distance;
                             prep.decelerate_after = intersect_distance;
-                            prep.maximum_speed    = sqrt(2.0 * pl_block->acceleration * intersect_distance + exit_speed_sqr);
+                            prep.maximum_speed    = sqrtf(2.0f * pl_block->acceleration * intersect_distance + exit_speed_sqr);
                         }
                     } else {  // Deceleration-only type
                         prep.ramp_type = RAMP_DECEL;
@@ -676,17 +1599,32 @@ void st_prep_buffer() {
                         // prep.maximum_speed = prep.current_speed;
                     }
                 } else {  // Acceleration-only type
-                    prep.accelerate_until = 0.0;
+                    prep.accelerate_until = 0.0f;
                     // prep.decelerate_after = 0.0;
                     prep.maximum_speed = prep.exit_speed;
                 }
+                prep.stat_nominal_speed = nominal_speed;
+                prep.stat_peak_speed    = prep.ramp_type == RAMP_DECEL ? prep.current_speed : prep.maximum_speed;
+                bool feed_reduced       = sys.f_override < FeedOverride::Default || sys.f_adaptive < FeedOverride::Default;
+                prep.stat_override      = pl_block->motion.rapidMotion ? sys.r_override < RapidOverride::Default
+                                                                       : (!pl_block->motion.noFeedOverride && feed_reduced);
+#ifdef SHAPED_RAMPS
+                // Override decelerations stay linear. Ramps that start later are set up at the
+                // ramp state change in the segment loop.
+                prep.scurve_ramp = false;
+                if (prep.ramp_type == RAMP_ACCEL) {
+                    st_scurve_begin(prep.current_speed, prep.maximum_speed, pl_block->millimeters, prep.accelerate_until);
+                } else if (prep.ramp_type == RAMP_DECEL && !prep.recalculate_flag.decelOverride) {
+                    st_scurve_begin(prep.current_speed, prep.exit_speed, pl_block->millimeters, prep.mm_complete);
+                }
+#endif
             }
 
             sys.step_control.updateSpindleRpm = true;  // Force update whenever updating block.
         }
 
         // Initialize new segment
-        segment_t* prep_segment = &segment_buffer[segment_buffer_head];
+        segment_t* prep_segment = segment_ring.producer_slot();
 
         // Set new segment to point to the current segment data block.
         prep_segment->st_block_index = prep.st_block_index;
@@ -704,29 +1642,44 @@ void st_prep_buffer() {
           may range from zero to the length of the block. Velocity profiles can end either at
           the end of planner block (typical) or mid-block at the end of a forced deceleration,
           such as from a feed hold.
+            With ADAPTIVE_SEGMENT_DURATION, the segment time depends on the ramp state the segment
+          starts in: shorter in acceleration and deceleration ramps, longer while cruising.
         */
-        float dt_max   = DT_SEGMENT;                                // Maximum segment time
-        float dt       = 0.0;                                       // Initialize segment time
+#ifdef ADAPTIVE_SEGMENT_DURATION
+        float dt_segment = (prep.ramp_type == RAMP_CRUISE) ? DT_SEGMENT_CRUISE : DT_SEGMENT_RAMP;
+#else
+        float dt_segment = DT_SEGMENT;
+#endif
+        float dt_max   = dt_segment;                                // Maximum segment time
+        float dt       = 0.0f;                                      // Initialize segment time
         float time_var = dt_max;                                    // Time worker variable
         float mm_var;                                               // mm-Distance worker variable
         float speed_var;                                            // Speed worker variable
         float mm_remaining = pl_block->millimeters;                 // New segment distance from end of block.
         float minimum_mm   = mm_remaining - prep.req_mm_increment;  // Guarantee at least one step.
+#ifdef LASER_STEP_POWER
+        float segment_start_speed = prep.current_speed;
+#endif
 
-        if (minimum_mm < 0.0) {
-            minimum_mm = 0.0;
+        if (minimum_mm < 0.0f) {
+            minimum_mm = 0.0f;
         }
+#ifdef SPINDLE_SYNC
+        if (pl_block->sync_pitch != 0.0f && !sys.step_control.executeHold) {
+            st_spindle_sync_speed(dt_segment);
+        }
+#endif
 
         do {
             switch (prep.ramp_type) {
                 case RAMP_DECEL_OVERRIDE:
                     speed_var = pl_block->acceleration * time_var;
-                    mm_var    = time_var * (prep.current_speed - 0.5 * speed_var);
+                    mm_var    = time_var * (prep.current_speed - 0.5f * speed_var);
                     mm_remaining -= mm_var;
                     if ((mm_remaining < prep.accelerate_until) || (mm_var <= 0)) {
                         // Cruise or cruise-deceleration types only for deceleration override.
                         mm_remaining       = prep.accelerate_until;  // NOTE: 0.0 at EOB
-                        time_var           = 2.0 * (pl_block->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
+                        time_var           = 2.0f * (pl_block->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
                         prep.ramp_type     = RAMP_CRUISE;
                         prep.current_speed = prep.maximum_speed;
                     } else {  // Mid-deceleration override ramp.
@@ -735,12 +1688,34 @@ void st_prep_buffer() {
                     break;
                 case RAMP_ACCEL:
                     // NOTE: Acceleration ramp only computes during first do-while loop.
+#ifdef SHAPED_RAMPS
+                    if (prep.scurve_ramp) {
+                        if (prep.ramp_elapsed + time_var < prep.ramp_time) {  // Mid-ramp.
+                            mm_remaining = st_scurve_advance(prep.ramp_elapsed + time_var);
+                            if (mm_remaining < prep.accelerate_until) {  // Guard against round-off
+                                mm_remaining = prep.accelerate_until;
+                            }
+                            break;
+                        }
+                        // End of the ramp. Same junction handling as the linear ramp below.
+                        time_var     = prep.ramp_time - prep.ramp_elapsed;
+                        mm_remaining = prep.accelerate_until;
+                        if (mm_remaining == prep.decelerate_after) {
+                            prep.ramp_type = RAMP_DECEL;
+                            st_scurve_begin(prep.maximum_speed, prep.exit_speed, prep.decelerate_after, prep.mm_complete);
+                        } else {
+                            prep.ramp_type = RAMP_CRUISE;
+                        }
+                        prep.current_speed = prep.maximum_speed;
+                        break;
+                    }
+#endif
                     speed_var = pl_block->acceleration * time_var;
-                    mm_remaining -= time_var * (prep.current_speed + 0.5 * speed_var);
+                    mm_remaining -= time_var * (prep.current_speed + 0.5f * speed_var);
                     if (mm_remaining < prep.accelerate_until) {  // End of acceleration ramp.
                         // Acceleration-cruise, acceleration-deceleration ramp junction, or end of block.
                         mm_remaining = prep.accelerate_until;  // NOTE: 0.0 at EOB
-                        time_var     = 2.0 * (pl_block->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
+                        time_var     = 2.0f * (pl_block->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
                         if (mm_remaining == prep.decelerate_after) {
                             prep.ramp_type = RAMP_DECEL;
                         } else {
@@ -761,16 +1736,36 @@ void st_prep_buffer() {
                         time_var       = (mm_remaining - prep.decelerate_after) / prep.maximum_speed;
                         mm_remaining   = prep.decelerate_after;  // NOTE: 0.0 at EOB
                         prep.ramp_type = RAMP_DECEL;
+#ifdef SHAPED_RAMPS
+                        st_scurve_begin(prep.maximum_speed, prep.exit_speed, prep.decelerate_after, prep.mm_complete);
+#endif
                     } else {  // Cruising only.
                         mm_remaining = mm_var;
                     }
                     break;
                 default:  // case RAMP_DECEL:
+#ifdef SHAPED_RAMPS
+                    if (prep.scurve_ramp) {
+                        float ramp_elapsed = prep.ramp_elapsed;  // Advancing moves it, even past the end of the block
+                        if (ramp_elapsed + time_var < prep.ramp_time) {
+                            mm_var = st_scurve_advance(ramp_elapsed + time_var);
+                            if (mm_var > prep.mm_complete) {  // Typical case. In deceleration ramp.
+                                mm_remaining = mm_var;
+                                break;
+                            }
+                        }
+                        // End of block.
+                        time_var           = prep.ramp_time - ramp_elapsed;
+                        mm_remaining       = prep.mm_complete;
+                        prep.current_speed = prep.exit_speed;
+                        break;
+                    }
+#endif
                     // NOTE: mm_var used as a misc worker variable to prevent errors when near zero speed.
                     speed_var = pl_block->acceleration * time_var;  // Used as delta speed (mm/min)
                     if (prep.current_speed > speed_var) {           // Check if at or below zero speed.
                         // Compute distance from end of segment to end of block.
-                        mm_var = mm_remaining - time_var * (prep.current_speed - 0.5 * speed_var);  // (mm)
+                        mm_var = mm_remaining - time_var * (prep.current_speed - 0.5f * speed_var);  // (mm)
                         if (mm_var > prep.mm_complete) {                                            // Typical case. In deceleration ramp.
                             mm_remaining = mm_var;
                             prep.current_speed -= speed_var;
@@ -778,7 +1773,7 @@ void st_prep_buffer() {
                         }
                     }
                     // Otherwise, at end of block or end of forced-deceleration.
-                    time_var           = 2.0 * (mm_remaining - prep.mm_complete) / (prep.current_speed + prep.exit_speed);
+                    time_var           = 2.0f * (mm_remaining - prep.mm_complete) / (prep.current_speed + prep.exit_speed);
                     mm_remaining       = prep.mm_complete;
                     prep.current_speed = prep.exit_speed;
             }
@@ -790,7 +1785,7 @@ void st_prep_buffer() {
                 if (mm_remaining > minimum_mm) {  // Check for very slow segments with zero steps.
                     // Increase segment time to ensure at least one step in segment. Override and loop
                     // through distance calculations until minimum_mm or mm_complete.
-                    dt_max += DT_SEGMENT;
+                    dt_max += dt_segment;
                     time_var = dt_max - dt;
                 } else {
                     break;  // **Complete** Exit loop. Segment execution time maxed.
@@ -815,12 +1810,30 @@ void st_prep_buffer() {
 
                 prep.current_spindle_rpm = rpm;
             } else {
-                sys.spindle_speed        = 0.0;
-                prep.current_spindle_rpm = 0.0;
+                sys.spindle_speed        = 0.0f;
+                prep.current_spindle_rpm = 0.0f;
             }
             sys.step_control.updateSpindleRpm = false;
         }
+#ifdef CONSTANT_SURFACE_SPEED
+        // G96 follows the radius at the end of the segment. A spindle that is slow to command
+        // gets a new rpm only once rpm_update_ms of segments have been prepared since the last.
+        if (pl_block->css_speed != 0.0f && pl_block->spindle != SpindleState::Disable) {
+            prep.css_dt += dt;
+            if (prep.css_dt * 60000.0f >= spindle->rpm_update_ms) {
+                prep.css_dt              = 0.0f;
+                prep.current_spindle_rpm = st_css_rpm(pl_block->css_speed, pl_block->css_radius - pl_block->css_radius_rate * mm_remaining);
+            }
+        }
+#endif
         prep_segment->spindle_rpm = prep.current_spindle_rpm;  // Reload segment PWM value
+#ifdef LASER_STEP_POWER
+        // The segment starts at the power for the speed it starts at and is ramped by the ISR
+        // to current_spindle_rpm, once the step count is known.
+        if (st_prep_block->is_pwm_rate_adjusted && pl_block->spindle != SpindleState::Disable) {
+            prep_segment->spindle_rpm = pl_block->spindle_speed * segment_start_speed * prep.inv_rate;
+        }
+#endif
 
         /* -----------------------------------------------------------------------------------
            Compute segment step rate, steps to execute, and apply necessary rate corrections.
@@ -833,8 +1846,8 @@ void st_prep_buffer() {
            supported by Grbl (i.e. exceeding 10 meters axis travel at 200 step/mm).
         */
         float step_dist_remaining    = prep.step_per_mm * mm_remaining;             // Convert mm_remaining to steps
-        float n_steps_remaining      = ceil(step_dist_remaining);                   // Round-up current steps remaining
-        float last_n_steps_remaining = ceil(prep.steps_remaining);                  // Round-up last steps remaining
+        float n_steps_remaining      = ceilf(step_dist_remaining);                  // Round-up current steps remaining
+        float last_n_steps_remaining = ceilf(prep.steps_remaining);                 // Round-up last steps remaining
         prep_segment->n_step         = last_n_steps_remaining - n_steps_remaining;  // Compute number of steps to execute.
 
         // Bail if we are at the end of a feed hold and don't have a step to execute.
@@ -868,7 +1881,7 @@ void st_prep_buffer() {
         // Compute CPU cycles per step for the prepped segment.
         // fStepperTimer is in units of timerTicks/sec, so the dimensional analysis is
         // timerTicks/sec * 60 sec/minute * minutes = timerTicks
-        uint32_t timerTicks = ceil((fStepperTimer * 60) * inv_rate);  // (timerTicks/step)
+        uint32_t timerTicks = ceilf((fStepperTimer * 60) * inv_rate);  // (timerTicks/step)
         int      level;
 
         // Compute step timing and multi-axis smoothing level.
@@ -883,11 +1896,21 @@ void st_prep_buffer() {
         // isrPeriod is stored as 16 bits, so limit timerTicks to the
         // largest value that will fit in a uint16_t.
         prep_segment->isrPeriod = timerTicks > 0xffff ? 0xffff : timerTicks;
+#ifdef LASER_STEP_POWER
+        prep_segment->spindle_rpm_step = 0;
+        if (prep_segment->n_step == 0) {
+            prep_segment->spindle_rpm = prep.current_spindle_rpm;  // Nothing to ramp over
+        } else {
+            int32_t rpm_change             = int32_t(uint16_t(prep.current_spindle_rpm)) - prep_segment->spindle_rpm;
+            prep_segment->spindle_rpm_step = int32_t((int64_t(rpm_change) << 16) / prep_segment->n_step);
+        }
+#endif
 
         // Segment complete! Increment segment buffer indices, so stepper ISR can immediately execute it.
-        segment_buffer_head = segment_next_head;
-        if (++segment_next_head == SEGMENT_BUFFER_SIZE) {
-            segment_next_head = 0;
+        segment_ring.push();
+        uint8_t segments_queued = segment_ring.count();
+        if (segments_queued > segment_buffer_high_water) {
+            segment_buffer_high_water = segments_queued;
         }
         // Update the appropriate planner and segment data.
         pl_block->millimeters = mm_remaining;
@@ -896,7 +1919,7 @@ void st_prep_buffer() {
         // Check for exit conditions and flag to load next planner block.
         if (mm_remaining == prep.mm_complete) {
             // End of planner block or forced-termination. No more distance to be executed.
-            if (mm_remaining > 0.0) {  // At end of forced-termination.
+            if (mm_remaining > 0.0f) {  // At end of forced-termination.
                 // Reset prep parameters for resuming and then bail. Allow the stepper ISR to complete
                 // the segment queue, where realtime protocol will set new state upon receiving the
                 // cycle stop flag from the ISR. Prep_segment is blocked until then.
@@ -913,6 +1936,7 @@ void st_prep_buffer() {
                     sys.step_control.endMotion = true;
                     return;
                 }
+                st_record_block_stats();
                 pl_block = NULL;  // Set pointer to indicate check and load next planner block.
                 plan_discard_current_block();
             }
@@ -920,6 +1944,65 @@ void st_prep_buffer() {
     }
 }
 
+#ifdef ENABLE_SEGMENT_PREP_TASK
+void st_prep_lock() {
+    if (st_prep_mutex) {
+        xSemaphoreTakeRecursive(st_prep_mutex, portMAX_DELAY);
+    }
+}
+
+void st_prep_unlock() {
+    if (st_prep_mutex) {
+        xSemaphoreGiveRecursive(st_prep_mutex);
+    }
+}
+
+// Refills the segment buffer on a fixed period, independent of how long the
+// main loop spends parsing or reading input. The states are the same ones in
+// which protocol_execute_realtime() reloads the buffer.
+static void segmentPrepTask(void* pvParameters) {
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+    while (true) {
+        switch (sys.state) {
+            case State::Cycle:
+            case State::Hold:
+            case State::SafetyDoor:
+            case State::Homing:
+            case State::Sleep:
+            case State::Jog:
+                st_prep_buffer();
+                break;
+            default:
+                break;
+        }
+        vTaskDelayUntil(&xLastWakeTime, SEGMENT_PREP_TASK_PERIOD);
+    }
+}
+#endif
+
+uint8_t st_get_segment_buffer_size() {
+    return segment_buffer_size;
+}
+
+uint8_t st_get_segment_buffer_high_water() {
+    return segment_buffer_high_water;
+}
+
+uint8_t st_get_segment_buffer_count() {
+    return segment_ring.count();
+}
+
+uint32_t st_get_segment_count() {
+    return segment_pops;
+}
+
+void st_discard_segments() {
+    while (segment_ring.consumer_slot() != NULL) {
+        segment_ring.pop();
+        segment_pops++;
+    }
+}
+
 // Called by realtime status reporting to fetch the current speed being executed. This value
 // however is not exactly the current speed, but the speed computed in the last step segment
 // in the segment buffer. It will always be behind by up to the number of segment blocks (-1)
@@ -937,6 +2020,14 @@ float st_get_realtime_rate() {
     }
 }
 
+#ifdef CONSTANT_SURFACE_SPEED
+float st_css_rpm(float css_speed, float radius) {
+    float max_rpm = rpm_max->get();
+    float length  = 2.0f * float(M_PI) * fabsf(radius);  // Of the circumference
+    return css_speed >= max_rpm * length ? max_rpm : css_speed / length;
+}
+#endif
+
 // The argument is in units of ticks of the timer that generates ISRs
 void IRAM_ATTR Stepper_Timer_WritePeriod(uint16_t timerTicks) {
     if (current_stepper == ST_I2S_STREAM) {
@@ -963,6 +2054,14 @@ void IRAM_ATTR Stepper_Timer_Init() {
     timer_set_counter_value(STEP_TIMER_GROUP, STEP_TIMER_INDEX, 0x00000000ULL);
     timer_enable_intr(STEP_TIMER_GROUP, STEP_TIMER_INDEX);
     timer_isr_register(STEP_TIMER_GROUP, STEP_TIMER_INDEX, onStepperDriverTimer, NULL, 0, NULL);
+
+#ifdef USE_STEP_PULSE_TIMER
+    // One-shot: the interrupt pauses the timer, the next pulse re-arms it.
+    timer_init(STEP_TIMER_GROUP, PULSE_TIMER_INDEX, &config);
+    timer_set_counter_value(STEP_TIMER_GROUP, PULSE_TIMER_INDEX, 0x00000000ULL);
+    timer_enable_intr(STEP_TIMER_GROUP, PULSE_TIMER_INDEX);
+    timer_isr_register(STEP_TIMER_GROUP, PULSE_TIMER_INDEX, onStepPulseTimer, NULL, 0, NULL);
+#endif
 }
 
 void IRAM_ATTR Stepper_Timer_Start() {
@@ -24,6 +24,7 @@
   along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+// Default for $Stepper/SegmentBuffer. The actual size is allocated at boot from that setting.
 #ifndef SEGMENT_BUFFER_SIZE
 #    define SEGMENT_BUFFER_SIZE 6
 #endif
@@ -31,14 +32,33 @@
 #include "Grbl.h"
 #include "Config.h"
 
-// Some useful constants.
-const double DT_SEGMENT              = (1.0 / (ACCELERATION_TICKS_PER_SECOND * 60.0));  // min/segment
-const double REQ_MM_INCREMENT_SCALAR = 1.25;
+// Some useful constants. These are float rather than double because the segment
+// generator runs in single precision, which the ESP32 FPU does in hardware.
+const float DT_SEGMENT              = (1.0f / (ACCELERATION_TICKS_PER_SECOND * 60.0f));  // min/segment
+const float REQ_MM_INCREMENT_SCALAR = 1.25f;
+const float DT_SEGMENT_RAMP         = DT_SEGMENT / ADAPTIVE_RAMP_SEGMENT_DIVISOR;       // Used with ADAPTIVE_SEGMENT_DURATION
+const float DT_SEGMENT_CRUISE       = DT_SEGMENT * ADAPTIVE_CRUISE_SEGMENT_MULTIPLIER;  // Used with ADAPTIVE_SEGMENT_DURATION
 const int    RAMP_ACCEL              = 0;
 const int    RAMP_CRUISE             = 1;
 const int    RAMP_DECEL              = 2;
 const int    RAMP_DECEL_OVERRIDE     = 3;
 
+#if defined(S_CURVE_ACCELERATION) && defined(INPUT_SHAPING)
+#    error "S_CURVE_ACCELERATION and INPUT_SHAPING cannot be used together"
+#endif
+#if defined(S_CURVE_ACCELERATION) || defined(INPUT_SHAPING)
+#    define SHAPED_RAMPS  // The segment generator follows its own curve through the planner's ramps
+#endif
+
+#ifdef INPUT_SHAPING
+enum class InputShaper : int8_t {
+    None = 0,
+    ZV,   // Zero vibration, two impulses
+    ZVD,  // Zero vibration and derivative, three impulses, more tolerant of a mistuned frequency
+    EI,   // Extra insensitive, three impulses, allows 5% vibration for the widest tolerance
+};
+#endif
+
 struct PrepFlag {
     uint8_t recalculate : 1;
     uint8_t holdPartialBlock : 1;
@@ -66,6 +86,9 @@ const int maxAmassLevel = 3;  // Each level increase doubles the threshold
 
 const timer_group_t STEP_TIMER_GROUP = TIMER_GROUP_0;
 const timer_idx_t   STEP_TIMER_INDEX = TIMER_0;
+#ifdef USE_STEP_PULSE_TIMER
+const timer_idx_t PULSE_TIMER_INDEX = TIMER_1;  // One-shot timer for the step pulse edges
+#endif
 
 // esp32 work around for diable in main loop
 extern uint64_t stepper_idle_counter;
@@ -90,9 +113,71 @@ enum stepper_id_t {
 #    endif
 #endif
 
+#ifdef USE_RMT_BATCH_STEPS
+// Step events per batched RMT transaction. One RMT memory block holds 64 items,
+// one pulse per item plus the end marker.
+const int RMT_BATCH_MAX_STEPS = 63;
+// The RMT channels are clocked at 80MHz / 20.
+const uint32_t rmtTicksPerMicrosecond = 4;
+#endif
+
+#ifdef PROBE_EDGE_CAPTURE
+// Step events per interrupt that can still be waiting to go out when the probe triggers.
+#    ifdef USE_RMT_BATCH_STEPS
+const int PROBE_PENDING_MAX = RMT_BATCH_MAX_STEPS;
+#    else
+const int PROBE_PENDING_MAX = 1;
+#    endif
+#endif
+
 extern const char*  stepper_names[];
 extern stepper_id_t current_stepper;
 
+// Snapshot of the settings the stepper ISR depends on. The ISR reads only this
+// struct, so it never has to go through the settings objects at interrupt time.
+// It is rebuilt by st_update_runtime_config() at init, in st_wake_up() and
+// whenever one of the underlying settings is changed.
+struct StepperRuntimeConfig {
+    uint8_t  n_axis;
+    uint32_t pulse_microseconds;
+    uint32_t direction_delay_microseconds;
+    int32_t  idle_lock_time;  // $Stepper/IdleTime, kept by a settings listener; 255 never disables
+};
+extern StepperRuntimeConfig st_config;
+
+// Stepper interrupt timing, collected by onStepperDriverTimer() to show how much
+// headroom is left before the step rate can be raised.
+struct StepperIsrStats {
+    uint32_t ticks;              // Interrupts taken
+    uint32_t reentered;          // Interrupts dropped because the previous one was still running
+    uint32_t skipped;            // Interrupts that finished after the next alarm was due, delaying that tick
+    uint32_t max_cycles;         // Longest interrupt in CPU cycles
+    int32_t  min_slack;          // Least time left before the next alarm, in timer ticks
+    uint64_t cycles;             // All the interrupts together, for the share of the core in $Tasks
+    uint32_t recent_max_cycles;  // Longest since the job log last read and cleared it
+};
+extern StepperIsrStats st_isr_stats;
+
+void st_reset_isr_stats();
+
+// Segment buffer underruns: the buffer ran dry mid-cycle while the planner still had blocks,
+// so the steppers stopped until the main loop prepped more. Counted by st_load_segment().
+// Any of them means the main loop was held up, by a slow client, SD read or line.
+const int STEPPER_UNDERRUN_HISTORY = 4;
+
+struct StepperUnderrun {
+    uint32_t time_ms;  // esp_timer time
+    uint32_t line;     // Line number of the block that was running, 0 without USE_LINE_NUMBERS
+};
+
+struct StepperUnderrunStats {
+    uint32_t        count;
+    StepperUnderrun recent[STEPPER_UNDERRUN_HISTORY];  // Underrun n is in recent[n % STEPPER_UNDERRUN_HISTORY]
+};
+extern StepperUnderrunStats st_underrun_stats;
+
+void st_reset_underrun_stats();
+
 // -- Task handles for use in the notifications
 void IRAM_ATTR onSteppertimer();
 void IRAM_ATTR onStepperOffTimer();
@@ -100,6 +185,14 @@ void IRAM_ATTR onStepperOffTimer();
 void stepper_init();
 void stepper_switch(stepper_id_t new_stepper);
 
+// Reload st_config from the current settings values.
+void st_update_runtime_config();
+
+#ifdef USE_I2S_STEPS
+// Apply the I2S DMA buffer and stream mode settings. The geometry can only change while not streaming steps.
+void st_update_i2s_config();
+#endif
+
 // Enable steppers, but cycle does not start unless called by motion control or realtime command.
 void st_wake_up();
 
@@ -118,12 +211,68 @@ void st_parking_restore_buffer();
 // Reloads step segment buffer. Called continuously by realtime execution system.
 void st_prep_buffer();
 
+#ifdef PRIME_HOLD_RESUME
+// Prepares the segments that resume a completed feed hold, leaving the steppers stopped.
+void st_prime_resume();
+// True, once, if the segment buffer holds them, so the steppers can be woken before a refill.
+bool st_take_primed_resume();
+// Takes them back, for anything but a resume.
+void st_discard_primed_resume();
+#endif
+
+// Serialize access to the planner and segment buffer against the segment prep task.
+// The lock is recursive, so nested calls from the same task are fine.
+#ifdef ENABLE_SEGMENT_PREP_TASK
+void st_prep_lock();
+void st_prep_unlock();
+#else
+inline void st_prep_lock() {}
+inline void st_prep_unlock() {}
+#endif
+
 // Called by planner_recalculate() when the executing block is updated by the new plan.
 void st_update_plan_block_parameters();
 
+#ifdef SPINDLE_SYNC
+// Starts a chain of synchronized blocks at the given encoder count. Each block of the chain
+// starts where the one before ended, and st_spindle_sync_end() is where the last one queued
+// ends. Only call with an empty segment buffer.
+void    st_spindle_sync_start(int64_t origin);
+int64_t st_spindle_sync_end();
+#endif
+
+// Copies the real-time machine position in steps, including the steps of the segment that the
+// ISR is executing when DEFER_STEP_POSITION_UPDATES is enabled.
+void st_get_position(int32_t* position);
+
+// Like st_get_position(), but where the queued step segments will have taken the machine lead_us
+// microseconds from now. Looks no further than the end of the segment buffer.
+void st_get_lookahead_position(int32_t* position, uint32_t lead_us);
+
+#ifdef PROBE_EDGE_CAPTURE
+// Like st_get_position(), but at the step event nearest to now. Called by the probe pin interrupt.
+void st_get_probe_position(int32_t* position);
+#endif
+
+// Allocated size of the step segment buffer and the most segments that have been queued in it.
+uint8_t st_get_segment_buffer_size();
+uint8_t st_get_segment_buffer_high_water();
+uint8_t st_get_segment_buffer_count();  // Segments prepped and not yet executed
+
+// Segments finished since boot, by the stepper or by st_discard_segments().
+uint32_t st_get_segment_count();
+
+// Drops the prepped segments without stepping them, for $Bench. Only while the stepper is stopped.
+void st_discard_segments();
+
 // Called by realtime status reporting if realtime rate reporting is enabled in config.h.
 float st_get_realtime_rate();
 
+#ifdef CONSTANT_SURFACE_SPEED
+// The G96 spindle rpm for a surface speed in mm/min at a radius in mm, capped by $30.
+float st_css_rpm(float css_speed, float radius);
+#endif
+
 // disable (or enable) steppers via STEPPERS_DISABLE_PIN
 bool get_stepper_disable();  // returns the state of the pin
 
@@ -0,0 +1,186 @@
+/*
+  StoredLines.cpp - Startup lines and macros, kept split into words between runs
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The words of all the lines of a setting are kept in one allocation, sized to what they take,
+  so a short macro costs tens of bytes rather than a MAX_GCODE_WORDS array per line.
+*/
+
+#include "Grbl.h"
+
+typedef struct {
+    uint16_t start;       // Of the line's text in the source
+    uint16_t length;
+    uint16_t first_word;  // Index of its first word in the words of the setting
+    uint8_t  n_words;
+} stored_line_t;
+
+class StoredLines {
+    String         _source;  // Text the lines were split from
+    stored_line_t* _lines   = NULL;
+    gc_word_t*     _words   = NULL;
+    uint8_t        _n_lines = 0;
+    bool           _split   = false;  // False if a line must be read as text
+
+    void clear() {
+        free(_lines);
+        free(_words);
+        _lines   = NULL;
+        _words   = NULL;
+        _n_lines = 0;
+        _split   = false;
+    }
+
+public:
+    // Splits text into lines at separator, and the lines into words, unless it is the text they
+    // were split from last time. Returns false if some line must be read as text.
+    bool split(const char* text, char separator) {
+        if (_source == text) {
+            return _split;
+        }
+        clear();
+        _source = text;
+
+        size_t n_lines = 1;
+        for (const char* s = text; *s; s++) {
+            n_lines += *s == separator;
+        }
+        if (n_lines > UINT8_MAX) {
+            return false;
+        }
+        _lines = (stored_line_t*)malloc(n_lines * sizeof(stored_line_t));
+        if (!_lines) {
+            return false;
+        }
+        gc_word_t words[MAX_GCODE_WORDS];
+        char      line[256];
+        size_t    start         = 0;
+        size_t    total_words   = 0;
+        size_t    source_length = _source.length();
+        for (size_t n = 0; n < n_lines; n++) {
+            const char* end    = strchr(text + start, separator);
+            size_t      length = end ? end - (text + start) : source_length - start;
+            if (length >= sizeof(line)) {
+                clear();
+                return false;
+            }
+            memcpy(line, text + start, length);
+            line[length] = '\0';
+            uint8_t n_words;
+            if (!gc_tokenize_stored(line, words, &n_words)) {
+                clear();
+                return false;
+            }
+            gc_word_t* more = (gc_word_t*)realloc(_words, (total_words + n_words + 1) * sizeof(gc_word_t));
+            if (!more) {
+                clear();
+                return false;
+            }
+            _words = more;
+            memcpy(_words + total_words, words, n_words * sizeof(gc_word_t));
+            _lines[n] = { uint16_t(start), uint16_t(length), uint16_t(total_words), n_words };
+            total_words += n_words;
+            start       += length + 1;
+        }
+        _n_lines = n_lines;
+        _split   = true;
+        return true;
+    }
+
+    uint8_t lines() { return _n_lines; }
+
+    // Runs one line of a split setting. A line that may be recorded into an O-word block goes
+    // through the text path, which does the recording.
+    Error execute(uint8_t n, uint8_t client) {
+        stored_line_t* line = &_lines[n];
+        if (oword_recording()) {
+            char text[256];
+            memcpy(text, _source.c_str() + line->start, line->length);
+            text[line->length] = '\0';
+            return gc_execute_line(text, client);
+        }
+        return gc_execute_words(_words + line->first_word, line->n_words, client);
+    }
+};
+
+static StoredLines     startup[2];
+static StoredLines     macros[4];
+static StoredLines*    macro_running = NULL;
+static uint8_t         macro_line;
+static volatile int8_t macro_pending = -1;
+
+void stored_run_startup() {
+    StringSetting* settings[] = { startup_line_0, startup_line_1 };
+    for (int i = 0; i < 2; i++) {
+        const char* text = settings[i]->get();
+        if (*text == '\0') {
+            continue;
+        }
+        Error status_code;
+        if (startup[i].split(text, '\0')) {
+            status_code = startup[i].execute(0, CLIENT_SERIAL);
+        } else {
+            char gcline[256];
+            strncpy(gcline, text, 255);
+            gcline[255] = '\0';
+            status_code = gc_execute_line(gcline, CLIENT_SERIAL);
+        }
+        report_execute_startup_message(text, status_code, CLIENT_SERIAL);
+    }
+}
+
+void stored_macro_start(uint8_t index) {
+    if (index < 4) {
+        macro_pending = index;
+    }
+}
+
+void stored_macro_poll() {
+    if (macro_pending >= 0) {
+        StringSetting* settings[] = { user_macro0, user_macro1, user_macro2, user_macro3 };
+        uint8_t        index      = macro_pending;
+        macro_pending             = -1;
+        if (macros[index].split(settings[index]->get(), '&')) {
+            macro_running = &macros[index];
+            macro_line    = 0;
+        } else {
+            // Submitted line by line, as if typed, for the lines only the text path can run.
+            String user_macro = settings[index]->get();
+            for (int start = 0, end; start < user_macro.length(); start = end + 1) {
+                end = user_macro.indexOf('&', start);
+                if (end < 0) {
+                    end = user_macro.length();
+                }
+                if (!command_submit(user_macro.substring(start, end).c_str(), CLIENT_INPUT)) {
+                    grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Error, "Macro %d does not fit the command queue", index);
+                    break;
+                }
+            }
+        }
+    }
+    if (!macro_running || plan_check_full_buffer()) {
+        return;
+    }
+    StoredLines* macro = macro_running;
+    uint8_t      n     = macro_line++;
+    if (macro_line == macro->lines()) {
+        macro_running = NULL;
+    }
+    report_status_message(macro->execute(n, CLIENT_SERIAL), CLIENT_SERIAL);
+}
+
+void stored_macro_reset() {
+    macro_running = NULL;
+    macro_pending = -1;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+/*
+  StoredLines.h - Startup lines and macros, kept split into words between runs
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdint>
+
+// $N0 and $N1, and $User/Macro0 to $User/Macro3 with their lines separated by '&', are split
+// into words by gc_tokenize_stored() the first time they run and again only after their text
+// changes, so each run goes straight to the parser. A line that must be read as text each time,
+// such as a $ command, sends the whole setting through the text path as before.
+
+// Runs the startup lines, reporting each with report_execute_startup_message().
+void stored_run_startup();
+
+// Queues a macro for stored_macro_poll(). Safe to call from an interrupt.
+void stored_macro_start(uint8_t index);
+
+// Runs the next line of the queued macro when the planner has room, reporting its status to
+// the serial client as if the line had been typed there. Called from the main loop.
+void stored_macro_poll();
+
+// Drops the macro being run.
+void stored_macro_reset();
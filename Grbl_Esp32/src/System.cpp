@@ -36,6 +36,7 @@ volatile bool sys_rt_exec_debug;
 #endif
 volatile Percent sys_rt_f_override;  // Global realtime executor feedrate override percentage
 volatile Percent sys_rt_r_override;  // Global realtime executor rapid override percentage
+volatile Percent sys_rt_f_adaptive;  // Global realtime executor adaptive feed percentage
 volatile Percent sys_rt_s_override;  // Global realtime executor spindle override percentage
 
 UserOutput::AnalogOutput*  myAnalogOutputs[MaxUserDigitalPin];
@@ -44,6 +45,85 @@ UserOutput::DigitalOutput* myDigitalOutputs[MaxUserDigitalPin];
 xQueueHandle control_sw_queue;    // used by control switch debouncing
 bool         debouncing = false;  // debouncing in process
 
+#if defined(ENABLE_CONTROL_SW_DEBOUNCE) && defined(ENABLE_CONTROL_INPUT_FILTER)
+#    error "ENABLE_CONTROL_SW_DEBOUNCE and ENABLE_CONTROL_INPUT_FILTER cannot be used together"
+#endif
+
+ControlLatency control_latency[ControlInputCount];
+
+static volatile uint64_t control_edge_time;                       // First control pin edge not yet acted on
+static volatile uint64_t control_pending_edge[ControlInputCount];  // Edges of the bits still waiting for the main loop
+
+static void IRAM_ATTR system_record_latency(ControlInput input, uint64_t edge) {
+    uint32_t        us      = esp_timer_get_time() - edge;
+    ControlLatency& latency = control_latency[input];
+    int             bucket  = us ? 32 - __builtin_clz(us) : 0;
+    latency.bucket[bucket < CONTROL_LATENCY_BUCKETS ? bucket : CONTROL_LATENCY_BUCKETS - 1]++;
+    latency.count++;
+    if (us > latency.max_us) {
+        latency.max_us = us;
+    }
+}
+
+void system_control_acted(ControlInput input) {
+    uint64_t edge = control_pending_edge[input];
+    if (edge) {
+        control_pending_edge[input] = 0;
+        system_record_latency(input, edge);
+    }
+}
+
+void system_clear_control_latency() {
+    memset(control_latency, 0, sizeof(control_latency));
+}
+
+#ifdef ENABLE_CONTROL_INPUT_FILTER
+const timer_group_t CONTROL_TIMER_GROUP = TIMER_GROUP_1;
+const timer_idx_t   CONTROL_TIMER_INDEX = TIMER_1;
+const uint32_t      fControlTimer       = 1000000;  // Counts microseconds
+
+static bool control_filter_pending;  // Edges have been seen since the pins were last read
+
+// Restarts the quiet period, unless the first edge is already one period old.
+static void IRAM_ATTR system_control_filter_restart() {
+    if (!control_filter_pending) {
+        control_filter_pending = true;
+    } else if (esp_timer_get_time() - control_edge_time >= CONTROL_INPUT_FILTER_US) {
+        return;
+    }
+    timer_pause(CONTROL_TIMER_GROUP, CONTROL_TIMER_INDEX);
+    timer_set_counter_value(CONTROL_TIMER_GROUP, CONTROL_TIMER_INDEX, 0x00000000ULL);
+    timer_set_alarm(CONTROL_TIMER_GROUP, CONTROL_TIMER_INDEX, TIMER_ALARM_EN);
+    timer_start(CONTROL_TIMER_GROUP, CONTROL_TIMER_INDEX);
+}
+
+// The pins have settled. Anything that is still active is acted on.
+static void IRAM_ATTR isr_control_filter(void* arg) {
+    TIMERG1.int_clr_timers.t1 = 1;
+    timer_pause(CONTROL_TIMER_GROUP, CONTROL_TIMER_INDEX);
+    control_filter_pending = false;
+    ControlPins pins       = system_control_get_state();
+    if (pins.value) {
+        system_exec_control_pin(pins);
+    }
+    control_edge_time = 0;
+}
+
+static void system_control_filter_init() {
+    timer_config_t config;
+    config.divider     = fTimers / fControlTimer;
+    config.counter_dir = TIMER_COUNT_UP;
+    config.counter_en  = TIMER_PAUSE;
+    config.alarm_en    = TIMER_ALARM_EN;
+    config.intr_type   = TIMER_INTR_LEVEL;
+    config.auto_reload = false;
+    timer_init(CONTROL_TIMER_GROUP, CONTROL_TIMER_INDEX, &config);
+    timer_set_alarm_value(CONTROL_TIMER_GROUP, CONTROL_TIMER_INDEX, CONTROL_INPUT_FILTER_US * (fControlTimer / 1000000));
+    timer_enable_intr(CONTROL_TIMER_GROUP, CONTROL_TIMER_INDEX);
+    timer_isr_register(CONTROL_TIMER_GROUP, CONTROL_TIMER_INDEX, isr_control_filter, NULL, 0, NULL);
+}
+#endif
+
 void system_ini() {  // Renamed from system_init() due to conflict with esp32 files
     // setup control inputs
 
@@ -87,15 +167,19 @@ void system_ini() {  // Renamed from system_init() due to conflict with esp32 fi
     pinMode(MACRO_BUTTON_3_PIN, INPUT_PULLUP);
     attachInterrupt(digitalPinToInterrupt(MACRO_BUTTON_3_PIN), isr_control_inputs, CHANGE);
 #endif
+#ifdef ENABLE_CONTROL_INPUT_FILTER
+    system_control_filter_init();
+#endif
 #ifdef ENABLE_CONTROL_SW_DEBOUNCE
     // setup task used for debouncing
     control_sw_queue = xQueueCreate(10, sizeof(int));
-    xTaskCreate(controlCheckTask,
-                "controlCheckTask",
-                3096,
-                NULL,
-                5,  // priority
-                NULL);
+    heap_task_create(controlCheckTask,
+                     "controlCheckTask",
+                     3096,
+                     NULL,
+                     5,  // priority
+                     NULL,
+                     tskNO_AFFINITY);
 #endif
 
     //customize pin definition if needed
@@ -127,7 +211,8 @@ void controlCheckTask(void* pvParameters) {
         if (pins.value) {
             system_exec_control_pin(pins);
         }
-        debouncing = false;
+        control_edge_time = 0;
+        debouncing        = false;
 
         static UBaseType_t uxHighWaterMark = 0;
 #    ifdef DEBUG_TASK_STACK
@@ -138,7 +223,12 @@ void controlCheckTask(void* pvParameters) {
 #endif
 
 void IRAM_ATTR isr_control_inputs() {
-#ifdef ENABLE_CONTROL_SW_DEBOUNCE
+    if (!control_edge_time) {
+        control_edge_time = esp_timer_get_time();
+    }
+#ifdef ENABLE_CONTROL_INPUT_FILTER
+    system_control_filter_restart();
+#elif defined(ENABLE_CONTROL_SW_DEBOUNCE)
     // we will start a task that will recheck the switches after a small delay
     int evt;
     if (!debouncing) {  // prevent resending until debounce is done
@@ -148,6 +238,7 @@ void IRAM_ATTR isr_control_inputs() {
 #else
     ControlPins pins = system_control_get_state();
     system_exec_control_pin(pins);
+    control_edge_time = 0;
 #endif
 }
 
@@ -185,9 +276,43 @@ void system_convert_array_steps_to_mpos(float* position, int32_t* steps) {
     }
     motors_to_cartesian(position, motors, n_axis);
 }
+// The machine position of the steps it was last computed for, with the setting changes it was
+// computed under. Status reports polled by several clients, and WebUI position events, mostly
+// find the machine where it was, and skip the conversion, which runs the forward kinematics.
+static struct {
+    uint32_t changes;
+    bool     valid;
+    int32_t  steps[MAX_N_AXIS];
+    float    mpos[MAX_N_AXIS];
+} mpos_cache;
+static portMUX_TYPE mpos_cache_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void system_read_mpos(float* position) {
+    int32_t steps[MAX_N_AXIS];
+    st_get_position(steps);
+    uint32_t changes = Setting::changes;
+    portENTER_CRITICAL(&mpos_cache_mux);
+    bool hit = mpos_cache.valid && mpos_cache.changes == changes && !memcmp(mpos_cache.steps, steps, sizeof(steps));
+    if (hit) {
+        memcpy(position, mpos_cache.mpos, sizeof(mpos_cache.mpos));
+    }
+    portEXIT_CRITICAL(&mpos_cache_mux);
+    if (hit) {
+        return;
+    }
+    memset(position, 0, MAX_N_AXIS * sizeof(float));
+    system_convert_array_steps_to_mpos(position, steps);
+    portENTER_CRITICAL(&mpos_cache_mux);
+    mpos_cache.changes = changes;
+    mpos_cache.valid   = true;
+    memcpy(mpos_cache.steps, steps, sizeof(steps));
+    memcpy(mpos_cache.mpos, position, sizeof(mpos_cache.mpos));
+    portEXIT_CRITICAL(&mpos_cache_mux);
+}
+
 float* system_get_mpos() {
     static float position[MAX_N_AXIS];
-    system_convert_array_steps_to_mpos(position, sys_position);
+    system_read_mpos(position);
     return position;
 };
 
@@ -257,23 +382,32 @@ ControlPins system_control_get_state() {
 
 // execute the function of the control pin
 void system_exec_control_pin(ControlPins pins) {
+    uint64_t edge = control_edge_time;
     if (pins.bit.reset) {
-        grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Reset via control pin");
         mc_reset();
+        if (edge) {
+            system_record_latency(ControlInputReset, edge);
+        }
+        grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Reset via control pin");
     } else if (pins.bit.cycleStart) {
-        sys_rt_exec_state.bit.cycleStart = true;
+        control_pending_edge[ControlInputCycleStart] = edge;
+        sys_rt_exec_state.bit.cycleStart             = true;
     } else if (pins.bit.feedHold) {
-        sys_rt_exec_state.bit.feedHold = true;
+        control_pending_edge[ControlInputFeedHold] = edge;
+        sys_rt_exec_state.bit.feedHold             = true;
     } else if (pins.bit.safetyDoor) {
-        sys_rt_exec_state.bit.safetyDoor = true;
-    } else if (pins.bit.macro0) {
-        user_defined_macro(0);  // function must be implemented by user
-    } else if (pins.bit.macro1) {
-        user_defined_macro(1);  // function must be implemented by user
-    } else if (pins.bit.macro2) {
-        user_defined_macro(2);  // function must be implemented by user
-    } else if (pins.bit.macro3) {
-        user_defined_macro(3);  // function must be implemented by user
+        control_pending_edge[ControlInputSafetyDoor] = edge;
+        sys_rt_exec_state.bit.safetyDoor             = true;
+    } else {
+        for (int macro = 0; macro < 4; macro++) {
+            if (bitnum_istrue(pins.value, ControlInputMacro0 + macro)) {
+                user_defined_macro(macro);  // function must be implemented by user
+                if (edge) {
+                    system_record_latency(ControlInput(ControlInputMacro0 + macro), edge);
+                }
+                break;
+            }
+        }
     }
 }
 
@@ -302,6 +436,30 @@ bool sys_set_analog(uint8_t io_num, float percent) {
     return analog->set_level(numerator);
 }
 
+#ifdef SYNC_USER_OUTPUTS
+int32_t sys_analog_numerator(uint8_t io_num, float percent) {
+    auto analog = myAnalogOutputs[io_num];
+    if (!analog->ready()) {
+        return -1;
+    }
+    return percent / 100.0 * analog->denominator();
+}
+
+// No floats or messages here, as the stepper ISR calls it.
+void IRAM_ATTR sys_set_outputs(const PlOutputs* outputs) {
+    for (uint8_t io_num = 0; io_num < MaxUserDigitalPin; io_num++) {
+        if (bitnum_istrue(outputs->digitalOn, io_num)) {
+            myDigitalOutputs[io_num]->set_level(true);
+        } else if (bitnum_istrue(outputs->digitalOff, io_num)) {
+            myDigitalOutputs[io_num]->set_level(false);
+        }
+        if (bitnum_istrue(outputs->analogSet, io_num)) {
+            myAnalogOutputs[io_num]->set_level(outputs->analog[io_num]);
+        }
+    }
+}
+#endif
+
 /*
     This returns an unused pwm channel.
     The 8 channels share 4 timers, so pairs 0,1 & 2,3 , etc
@@ -344,8 +502,7 @@ void __attribute__((weak)) user_defined_macro(uint8_t index) {
         return;
     }
 
-    String user_macro;
-    char   line[255];
+    const char* user_macro;
     switch (index) {
         case 0:
             user_macro = user_macro0->get();
@@ -363,13 +520,10 @@ void __attribute__((weak)) user_defined_macro(uint8_t index) {
             return;
     }
 
-    if (user_macro == "") {
+    if (*user_macro == '\0') {
         grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Macro User/Macro%d empty", index);
         return;
     }
 
-    user_macro.replace('&', '\n');
-    user_macro.toCharArray(line, 255, 0);
-    strcat(line, "\r");
-    WebUI::inputBuffer.push(line);
+    stored_macro_start(index);  // Run by the main loop
 }
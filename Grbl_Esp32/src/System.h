@@ -99,6 +99,7 @@ typedef struct {
     AxisMask       homing_axis_lock;    // Locks axes when limits engage. Used as an axis motion mask in the stepper ISR.
     Percent        f_override;          // Feed rate override value in percent
     Percent        r_override;          // Rapids override value in percent
+    Percent        f_adaptive;          // Feed scale of the adaptive feed in percent, applied with f_override
     Percent        spindle_speed_ovr;   // Spindle speed value in percent
     SpindleStop    spindle_stop_ovr;    // Tracks spindle stop override states
     Counter        report_ovr_counter;  // Tracks when to add override data to status reports.
@@ -126,6 +127,28 @@ union ControlPins {
     ControlPinBits bit;
 };
 
+// Bit positions of the inputs in ControlPins, which index control_latency.
+enum ControlInput : uint8_t {
+    ControlInputSafetyDoor = 0,
+    ControlInputReset,
+    ControlInputFeedHold,
+    ControlInputCycleStart,
+    ControlInputMacro0,
+    ControlInputCount = 8,
+};
+
+// Time from a control pin edge to Grbl acting on it. Reset and the macros are acted on when the
+// pin is read. Feed hold, cycle start and the safety door are acted on when the main loop takes
+// them from sys_rt_exec_state. Bucket 0 counts latencies under 1us and bucket k those from 2^(k-1)
+// to 2^k us, with the last bucket open ended.
+const int CONTROL_LATENCY_BUCKETS = 16;
+struct ControlLatency {
+    uint32_t count;
+    uint32_t max_us;
+    uint32_t bucket[CONTROL_LATENCY_BUCKETS];
+};
+extern ControlLatency control_latency[ControlInputCount];
+
 // NOTE: These position variables may need to be declared as volatiles, if problems arise.
 extern int32_t sys_position[MAX_N_AXIS];        // Real-time machine (aka home) position vector in steps.
 extern int32_t sys_probe_position[MAX_N_AXIS];  // Last probe position in machine coordinates and steps.
@@ -136,6 +159,7 @@ extern volatile ExecAlarm     sys_rt_exec_alarm;  // Global realtime executor bi
 extern volatile ExecAccessory sys_rt_exec_accessory_override;  // Global realtime executor bitflag variable for spindle/coolant overrides.
 extern volatile Percent       sys_rt_f_override;               // Feed override value in percent
 extern volatile Percent       sys_rt_r_override;               // Rapid feed override value in percent
+extern volatile Percent       sys_rt_f_adaptive;               // Adaptive feed scale in percent
 extern volatile Percent       sys_rt_s_override;               // Spindle override value in percent
 extern volatile bool          cycle_stop;
 extern volatile void* sys_pl_data_inflight;  // holds a plan_line_data_t while cartesian_to_motors has taken ownership of a line motion
@@ -158,6 +182,7 @@ void  system_execute_startup(char* line);
 Error execute_line(char* line, uint8_t client, WebUI::AuthenticationLevel auth_level);
 Error system_execute_line(char* line, WebUI::ESPResponseStream*, WebUI::AuthenticationLevel);
 Error system_execute_line(char* line, uint8_t client, WebUI::AuthenticationLevel);
+bool  system_line_is_query(const char* line);  // Only reports, so it cannot disturb a running job
 Error do_command_or_setting(const char* key, char* value, WebUI::AuthenticationLevel auth_level, WebUI::ESPResponseStream*);
 void  system_flag_wco_change();
 
@@ -165,16 +190,36 @@ void  system_flag_wco_change();
 float system_convert_axis_steps_to_mpos(int32_t* steps, uint8_t idx);
 
 // Updates a machine 'position' array based on the 'step' array sent.
-void   system_convert_array_steps_to_mpos(float* position, int32_t* steps);
+void system_convert_array_steps_to_mpos(float* position, int32_t* steps);
+
+// Copies the current machine position into position, which holds MAX_N_AXIS values. It is only
+// converted from the steps again when they, or a setting, changed since the last call. Safe
+// from any task.
+void system_read_mpos(float* position);
+
+// The same, in a buffer of its own that the caller may change. For the main loop only.
 float* system_get_mpos();
 
 // A task that runs after a control switch interrupt for debouncing.
 void controlCheckTask(void* pvParameters);
 void system_exec_control_pin(ControlPins pins);
 
+// Called by the main loop as it acts on a realtime bit, to time it if a control pin set it.
+void system_control_acted(ControlInput input);
+void system_clear_control_latency();
+
 bool sys_set_digital(uint8_t io_num, bool turnOn);
 void sys_digital_all_off();
 bool sys_set_analog(uint8_t io_num, float percent);
 void sys_analog_all_off();
 
+#ifdef SYNC_USER_OUTPUTS
+// Duty numerator of the analog output for percent, or -1 if the output is not set up.
+int32_t sys_analog_numerator(uint8_t io_num, float percent);
+
+// Makes the output changes of a block, see PlOutputs. Safe to call from the stepper ISR.
+struct PlOutputs;
+void sys_set_outputs(const PlOutputs* outputs);
+#endif
+
 int8_t sys_get_next_PWM_chan_num();
@@ -0,0 +1,194 @@
+/*
+  TaskStats.cpp - CPU use and placement of the FreeRTOS tasks, for $Tasks
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The CPU shares come from the FreeRTOS run-time counters, where the SDK has them, and are
+  each of one core, so the tasks of a core add up to 100% with its idle task. Without them
+  only the tasks Grbl made, with heap_task_create() or heap_watch_task(), are listed.
+*/
+
+#include "Grbl.h"
+
+// The tasks $Tasks/Placement may move. The others time the motion or the control inputs.
+static const char* const movable_tasks[] = {
+    "clientCheckTask", "heapTask", "sdReadTask", "sdWriteTask", "otaWriteTask", "notifyTask", "tcpStreamTask", "vfd_cmdTaskHandle",
+    "readSgTask", "servoUpdateTask",
+};
+
+static const int TASKS_MAX = 32;
+
+static bool task_movable(const char* name) {
+    for (auto movable : movable_tasks) {
+        if (!strcmp(name, movable)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Reads a core or priority field, which may be empty to leave it alone.
+static bool placement_field(const char* field, int max, int* value) {
+    if (*field == '\0') {
+        *value = -1;
+        return true;
+    }
+    char* end;
+    long  n = strtol(field, &end, 10);
+    if (*end != '\0' || n < 0 || n > max) {
+        return false;
+    }
+    *value = n;
+    return true;
+}
+
+// Checks each entry of list and, if name is not NULL, sets core and priority from the entry
+// for it, -1 when it has none. Returns false if the list is malformed.
+static bool placement_parse(const char* list, const char* name, int* core, int* priority) {
+    if (name) {
+        *core     = -1;
+        *priority = -1;
+    }
+    while (*list) {
+        const char* end = strchr(list, ',');
+        if (!end) {
+            end = list + strlen(list);
+        }
+        char   entry[40];
+        size_t len = end - list;
+        if (len == 0 || len >= sizeof(entry)) {
+            return false;
+        }
+        memcpy(entry, list, len);
+        entry[len]   = '\0';
+        char* first  = strchr(entry, ':');
+        char* second = first ? strchr(first + 1, ':') : NULL;
+        if (!second) {
+            return false;
+        }
+        *first  = '\0';
+        *second = '\0';
+        int entry_core, entry_priority;
+        if (!task_movable(entry) || !placement_field(first + 1, portNUM_PROCESSORS - 1, &entry_core) ||
+            !placement_field(second + 1, configMAX_PRIORITIES - 1, &entry_priority) || entry_priority == 0) {
+            return false;
+        }
+        if (name && !strcmp(entry, name)) {
+            *core     = entry_core;
+            *priority = entry_priority;
+        }
+        list = *end ? end + 1 : end;
+    }
+    return true;
+}
+
+bool task_placement_valid(const char* list) {
+    return placement_parse(list, NULL, NULL, NULL);
+}
+
+void task_placement(const char* name, UBaseType_t* priority, BaseType_t* core) {
+    if (!task_placement_list) {
+        return;  // Made before the settings were loaded
+    }
+    int new_core, new_priority;
+    if (!placement_parse(task_placement_list->get(), name, &new_core, &new_priority)) {
+        return;
+    }
+    if (new_core >= 0) {
+        *core = new_core;
+    }
+    if (new_priority >= 0) {
+        *priority = new_priority;
+    }
+}
+
+void task_apply_placement() {
+    TaskHandle_t tasks[TASKS_MAX];
+    int          count = heap_watched_tasks(tasks, TASKS_MAX);
+    for (int i = 0; i < count; i++) {
+        UBaseType_t priority = uxTaskPriorityGet(tasks[i]);
+        BaseType_t  core     = xTaskGetAffinity(tasks[i]);
+        task_placement(pcTaskGetTaskName(tasks[i]), &priority, &core);
+        if (priority != uxTaskPriorityGet(tasks[i])) {
+            vTaskPrioritySet(tasks[i], priority);
+        }
+    }
+}
+
+static void task_report_line(uint8_t client, TaskHandle_t task, const char* name, UBaseType_t priority, uint32_t unused, float cpu) {
+    char       core[8];
+    BaseType_t affinity = xTaskGetAffinity(task);
+    if (affinity == tskNO_AFFINITY) {
+        strcpy(core, "any");
+    } else {
+        snprintf(core, sizeof(core), "%d", affinity);
+    }
+    if (cpu < 0) {
+        grbl_sendf(client, "[TASK:%s,Core %s,Priority %u,Unused %u]\r\n", name, core, priority, unused);
+    } else {
+        grbl_sendf(client, "[TASK:%s,Core %s,Priority %u,Unused %u,CPU %.1f%%]\r\n", name, core, priority, unused, cpu);
+    }
+}
+
+void task_report(uint8_t client) {
+    // The shares are since the last report, or since boot for the first.
+    static int64_t  last_us;
+    static uint64_t last_isr_cycles;
+    int64_t         now_us = esp_timer_get_time();
+
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+    static TaskStatus_t status[TASKS_MAX];
+    static TaskHandle_t last_tasks[TASKS_MAX];
+    static uint32_t     last_runtime[TASKS_MAX];
+    static int          last_count;
+    static uint32_t     last_total;
+
+    uint32_t total;
+    int      count    = uxTaskGetSystemState(status, TASKS_MAX, &total);
+    uint32_t interval = total - last_total;
+    for (int i = 0; i < count; i++) {
+        uint32_t runtime = status[i].ulRunTimeCounter;
+        for (int j = 0; j < last_count; j++) {
+            if (last_tasks[j] == status[i].xHandle) {
+                runtime -= last_runtime[j];
+                break;
+            }
+        }
+        float cpu = interval ? 100.0f * runtime / interval : 0.0f;
+        task_report_line(client, status[i].xHandle, status[i].pcTaskName, status[i].uxCurrentPriority, status[i].usStackHighWaterMark, cpu);
+    }
+    for (int i = 0; i < count; i++) {
+        last_tasks[i]   = status[i].xHandle;
+        last_runtime[i] = status[i].ulRunTimeCounter;
+    }
+    last_count = count;
+    last_total = total;
+#else
+    TaskHandle_t tasks[TASKS_MAX];
+    int          count = heap_watched_tasks(tasks, TASKS_MAX);
+    for (int i = 0; i < count; i++) {
+        task_report_line(
+            client, tasks[i], pcTaskGetTaskName(tasks[i]), uxTaskPriorityGet(tasks[i]), uxTaskGetStackHighWaterMark(tasks[i]), -1);
+    }
+#endif
+
+    uint64_t isr_cycles = st_isr_stats.cycles;
+    if (isr_cycles < last_isr_cycles) {
+        last_isr_cycles = 0;  // Cleared by $Stepper/IsrStats
+    }
+    float seconds = (now_us - last_us) / 1e6;
+    float share   = seconds > 0 ? 100.0f * (isr_cycles - last_isr_cycles) / (seconds * getCpuFrequencyMhz() * 1e6) : 0.0f;
+    grbl_sendf(client, "[TASKS:Interval %.1f s,Stepper ISR %.2f%%]\r\n", seconds, share);
+    last_us         = now_us;
+    last_isr_cycles = isr_cycles;
+}
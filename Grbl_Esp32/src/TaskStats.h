@@ -0,0 +1,39 @@
+#pragma once
+
+/*
+  TaskStats.h - CPU use and placement of the FreeRTOS tasks, for $Tasks
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <cstdint>
+
+// Sends the core, priority and unused stack of each task and, when the SDK was built with
+// FreeRTOS run-time stats, its share of its core since the last report. The stepper
+// interrupt's share of its core over the same time follows.
+void task_report(uint8_t client);
+
+// Checks a $Tasks/Placement list: comma separated name:core:priority entries, where either
+// the core or the priority may be left empty to keep the task's own. Only tasks that do not
+// time the motion may be moved.
+bool task_placement_valid(const char* list);
+
+// Replaces priority and core with those $Tasks/Placement gives the task called name, if any.
+void task_placement(const char* name, UBaseType_t* priority, BaseType_t* core);
+
+// Sets the priorities $Tasks/Placement gives the running tasks. A task's core can only be
+// chosen when it is made, so cores take effect at the next boot, and not at all for the
+// tasks started before the settings are loaded.
+void task_apply_placement();
@@ -0,0 +1,300 @@
+/*
+  ToolTable.cpp - Tool lengths, diameters and rack pockets, and the M6 tool change
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The table lives in RAM, so G43 H reads it while parsing, and is written to LocalFS as a raw
+  image of tool_table_t whenever it changes. The rack is loaded from above: each pocket is
+  where the spindle nose is with the tool seated, and the spindle approaches it from
+  $ATC/Clearance above. A tool length is how much higher the tool setter is touched than
+  $ATC/Setter/Reference, the machine Z at which a tool of zero length would touch it.
+*/
+
+#include "Grbl.h"
+
+#include "LocalFS.h"
+
+static const char*    TOOL_TABLE_FILE   = "/tooltable.bin";
+static const uint32_t TOOL_TABLE_MAGIC  = 0x544f4f4c;  // "TOOL"
+static const float    ATC_PROBE_BACKOFF = 2.0;         // mm up from the fast touch before the slow one
+
+typedef struct {
+    uint32_t     magic;
+    uint8_t      loaded;  // Tool in the spindle
+    tool_entry_t tool[TOOL_TABLE_MAX];
+} tool_table_t;
+
+static tool_table_t       table;
+static const tool_entry_t no_tool = {};
+
+static bool tool_table_mount() {
+    return localfs_mount();
+}
+
+static void tool_table_save() {
+    if (!tool_table_mount()) {
+        return;
+    }
+    File file = LocalFS.open(TOOL_TABLE_FILE, FILE_WRITE);
+    if (file) {
+        file.write((const uint8_t*)&table, sizeof(table));
+        file.close();
+    }
+}
+
+void tool_table_init() {
+    memset(&table, 0, sizeof(table));
+    table.magic = TOOL_TABLE_MAGIC;
+    if (!tool_table_mount() || !LocalFS.exists(TOOL_TABLE_FILE)) {
+        return;
+    }
+    File file = LocalFS.open(TOOL_TABLE_FILE, FILE_READ);
+    if (!file) {
+        return;
+    }
+    bool valid = file.read((uint8_t*)&table, sizeof(table)) == sizeof(table) && table.magic == TOOL_TABLE_MAGIC &&
+                 table.loaded <= TOOL_TABLE_MAX;
+    file.close();
+    if (!valid) {
+        memset(&table, 0, sizeof(table));
+        table.magic = TOOL_TABLE_MAGIC;
+    }
+}
+
+const tool_entry_t* tool_table_get(uint8_t tool) {
+    if (tool == 0) {
+        return &no_tool;
+    }
+    return tool <= TOOL_TABLE_MAX ? &table.tool[tool - 1] : NULL;
+}
+
+Error tool_table_set_offsets(uint8_t tool, float length, float diameter) {
+    if (tool == 0 || tool > TOOL_TABLE_MAX) {
+        return Error::ToolNumberInvalid;
+    }
+    table.tool[tool - 1].length = length;
+    if (diameter >= 0.0f) {
+        table.tool[tool - 1].diameter = diameter;
+    }
+    tool_table_save();
+    return Error::Ok;
+}
+
+Error tool_table_set_pocket(uint8_t tool, const float* position) {
+    if (tool == 0 || tool > TOOL_TABLE_MAX) {
+        return Error::ToolNumberInvalid;
+    }
+    memcpy(table.tool[tool - 1].pocket, position, sizeof(table.tool[0].pocket));
+    table.tool[tool - 1].has_pocket = true;
+    tool_table_save();
+    return Error::Ok;
+}
+
+void tool_table_clear() {
+    memset(&table, 0, sizeof(table));
+    table.magic = TOOL_TABLE_MAGIC;
+    if (tool_table_mount() && LocalFS.exists(TOOL_TABLE_FILE)) {
+        LocalFS.remove(TOOL_TABLE_FILE);
+    }
+}
+
+uint8_t tool_table_loaded() {
+    return table.loaded;
+}
+
+void tool_table_set_loaded(uint8_t tool) {
+    if (tool <= TOOL_TABLE_MAX && tool != table.loaded) {
+        table.loaded = tool;
+        tool_table_save();
+    }
+}
+
+void tool_table_report(uint8_t client) {
+    grbl_sendf(client, "[MSG: Tool in spindle %d%s]\r\n", table.loaded, atc_enable->get() ? "" : ", tool changer disabled");
+    for (int i = 0; i < TOOL_TABLE_MAX; i++) {
+        const tool_entry_t* entry = &table.tool[i];
+        if (!entry->has_pocket && entry->length == 0.0f && entry->diameter == 0.0f) {
+            continue;
+        }
+        if (entry->has_pocket) {
+            grbl_sendf(client,
+                       "[TOOL:%d,L%.3f,D%.3f,X%.3f,Y%.3f,Z%.3f]\r\n",
+                       i + 1,
+                       entry->length,
+                       entry->diameter,
+                       entry->pocket[X_AXIS],
+                       entry->pocket[Y_AXIS],
+                       entry->pocket[Z_AXIS]);
+        } else {
+            grbl_sendf(client, "[TOOL:%d,L%.3f,D%.3f]\r\n", i + 1, entry->length, entry->diameter);
+        }
+    }
+}
+
+// Runs one line of G-code for the tool change.
+static Error atc_execute(uint8_t client, const char* format, ...) {
+    char    line[LINE_BUFFER_SIZE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    Error status = gc_execute_line(line, client);
+    if (status == Error::Ok && sys.abort) {
+        status = Error::ToolChangeFailed;
+    }
+    return status;
+}
+
+// Opens or closes the drawbar once the spindle has arrived, then waits for it to act.
+static Error atc_release(bool release, uint8_t client) {
+    int32_t output = atc_drawbar->get();
+    if (output < 0) {
+        return Error::Ok;
+    }
+    protocol_buffer_synchronize();
+    if (sys.abort) {
+        return Error::ToolChangeFailed;
+    }
+    if (!sys_set_digital(output, release)) {
+        return Error::PParamMaxExceeded;
+    }
+    return atc_execute(client, "G4P%.3f", atc_drawbar_delay->get());
+}
+
+// Leaves the tool in the spindle in its pocket and goes back up to $ATC/SafeZ empty.
+static Error atc_put_back(const tool_entry_t* entry, uint8_t client) {
+    float above  = entry->pocket[Z_AXIS] + atc_clearance->get();
+    Error status = atc_execute(client, "G53G0X%.4fY%.4f", entry->pocket[X_AXIS], entry->pocket[Y_AXIS]);
+    if (status == Error::Ok) {
+        status = atc_execute(client, "G53G0Z%.4f", above);
+    }
+    if (status == Error::Ok) {
+        status = atc_execute(client, "G53G1Z%.4fF%.1f", entry->pocket[Z_AXIS], atc_feed->get());
+    }
+    if (status == Error::Ok) {
+        status = atc_release(true, client);
+    }
+    if (status == Error::Ok) {
+        status = atc_execute(client, "G53G0Z%.4f", above);
+    }
+    if (status == Error::Ok) {
+        status = atc_release(false, client);
+    }
+    if (status == Error::Ok) {
+        status = atc_execute(client, "G53G0Z%.4f", atc_safe_z->get());
+    }
+    return status;
+}
+
+// Takes a tool from its pocket and lifts it to $ATC/SafeZ.
+static Error atc_pick_up(const tool_entry_t* entry, uint8_t client) {
+    float above  = entry->pocket[Z_AXIS] + atc_clearance->get();
+    Error status = atc_execute(client, "G53G0X%.4fY%.4f", entry->pocket[X_AXIS], entry->pocket[Y_AXIS]);
+    if (status == Error::Ok) {
+        status = atc_execute(client, "G53G0Z%.4f", above);
+    }
+    if (status == Error::Ok) {
+        status = atc_release(true, client);
+    }
+    if (status == Error::Ok) {
+        status = atc_execute(client, "G53G1Z%.4fF%.1f", entry->pocket[Z_AXIS], atc_feed->get());
+    }
+    if (status == Error::Ok) {
+        status = atc_release(false, client);
+    }
+    if (status == Error::Ok) {
+        status = atc_execute(client, "G53G1Z%.4fF%.1f", above, atc_feed->get());
+    }
+    if (status == Error::Ok) {
+        status = atc_execute(client, "G53G0Z%.4f", atc_safe_z->get());
+    }
+    return status;
+}
+
+// Touches the tool setter, quickly and then again slowly from just above, and returns the
+// tool length.
+static Error atc_measure(uint8_t client, float* length) {
+    Error status = atc_execute(client, "G53G0X%.4fY%.4f", atc_setter_x->get(), atc_setter_y->get());
+    if (status == Error::Ok) {
+        status = atc_execute(client, "G53G0Z%.4f", atc_setter_z->get());
+    }
+    if (status == Error::Ok) {
+        status = atc_execute(client, "G91G38.2Z%.4fF%.1f", -atc_setter_depth->get(), atc_setter_feed->get());
+    }
+    if (status == Error::Ok && sys.probe_succeeded) {
+        status = atc_execute(client, "G91G0Z%.4f", ATC_PROBE_BACKOFF);
+    }
+    if (status == Error::Ok && sys.probe_succeeded) {
+        status = atc_execute(client, "G91G38.2Z%.4fF%.1f", -2.0f * ATC_PROBE_BACKOFF, probe_feed->get());
+    }
+    if (status == Error::Ok && !sys.probe_succeeded) {
+        status = Error::ToolChangeFailed;  // G38.2 has already raised the probe alarm.
+    }
+    if (status != Error::Ok) {
+        return status;
+    }
+    float probe[MAX_N_AXIS];
+    system_convert_array_steps_to_mpos(probe, sys_probe_position);
+    *length = probe[Z_AXIS] - atc_setter_reference->get();
+    return atc_execute(client, "G53G0Z%.4f", atc_safe_z->get());
+}
+
+Error tool_change(uint8_t tool, uint8_t client) {
+    if (tool > TOOL_TABLE_MAX) {
+        return Error::ToolNumberInvalid;
+    }
+    if (tool == table.loaded) {
+        return Error::Ok;
+    }
+    const tool_entry_t* current = tool_table_get(table.loaded);
+    const tool_entry_t* next    = tool_table_get(tool);
+    if ((table.loaded && !current->has_pocket) || (tool && !next->has_pocket)) {
+        return Error::ToolNoPocket;
+    }
+    if (sys.state == State::CheckMode) {
+        return Error::Ok;
+    }
+    // The changer's moves change the modes they use, so the program's are put back afterwards.
+    gc_modal_t modal     = gc_state.modal;
+    float      feed_rate = gc_state.feed_rate;
+    Error      status    = atc_execute(client, "M5");
+    if (status == Error::Ok) {
+        status = atc_execute(client, "G53G0Z%.4f", atc_safe_z->get());
+    }
+    if (status == Error::Ok && table.loaded) {
+        status = atc_put_back(current, client);
+    }
+    if (status == Error::Ok) {
+        table.loaded = 0;
+    }
+    if (status == Error::Ok && tool) {
+        status = atc_pick_up(next, client);
+    }
+    if (status == Error::Ok) {
+        table.loaded = tool;
+    }
+    if (status == Error::Ok && tool && atc_measure_length->get()) {
+        status = atc_measure(client, &table.tool[tool - 1].length);
+    }
+    if (!sys.abort) {
+        protocol_buffer_synchronize();  // At rest, so that the table can be written to flash
+    }
+    tool_table_save();
+    modal.spindle      = gc_state.modal.spindle;
+    gc_state.modal     = modal;
+    gc_state.feed_rate = feed_rate;
+    if (status == Error::Ok) {
+        grbl_msg_sendf(client, MsgLevel::Info, "Tool %d loaded", tool);
+    }
+    return status;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+/*
+  ToolTable.h - Tool lengths, diameters and rack pockets, and the M6 tool change
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Error.h"
+
+#include <cstdint>
+
+// Tools 1 to TOOL_TABLE_MAX have entries. T0 is the empty spindle and always has zero offsets.
+const int TOOL_TABLE_MAX = 32;
+
+typedef struct {
+    float   length;     // Offset along TOOL_LENGTH_OFFSET_AXIS applied by G43, mm
+    float   diameter;   // mm, kept for the host, Grbl has no cutter compensation
+    float   pocket[3];  // Machine XYZ of the tool seated in its rack pocket
+    uint8_t has_pocket;
+} tool_entry_t;
+
+// Loads the table saved on SPIFFS, if any.
+void tool_table_init();
+
+// The entry of a tool, or NULL if the number is past the table. Tool 0 reads as all zero.
+const tool_entry_t* tool_table_get(uint8_t tool);
+
+// G10 L1: sets the length and, if diameter is not negative, the diameter of a tool, and saves the table.
+Error tool_table_set_offsets(uint8_t tool, float length, float diameter);
+
+// Sets where a tool sits in the rack, and saves the table.
+Error tool_table_set_pocket(uint8_t tool, const float* position);
+
+// Forgets every entry and removes the saved copy.
+void tool_table_clear();
+
+// The tool in the spindle, as left by the last M6 or $Tool/Loaded. Kept across restarts.
+uint8_t tool_table_loaded();
+void    tool_table_set_loaded(uint8_t tool);
+
+// Sends the table to the client.
+void tool_table_report(uint8_t client);
+
+// M6 with $ATC/Enable on: puts the tool in the spindle back in its pocket, picks up tool from
+// its pocket and, with $ATC/Measure on, measures its length on the tool setter. Runs its moves
+// through the parser like the probing routines, so the whole change needs no host round trip.
+// The parser modes are the same afterwards, except that the spindle is stopped.
+Error tool_change(uint8_t tool, uint8_t client);
@@ -11,9 +11,13 @@
 #include "soc/dport_reg.h"
 #include "soc/rtc.h"
 
-Uart::Uart(int uart_num) : _uart_num(uart_port_t(uart_num)), _pushback(-1) {}
+Uart::Uart(int uart_num) :
+    _uart_num(uart_port_t(uart_num)), _pushback(-1), _rx_events(NULL), _tx_queue(NULL), _tx_size(0), _tx_head(0), _tx_tail(0), _tx_lock(NULL),
+    _tx_stats({}) {}
 
-void Uart::begin(unsigned long baudrate, Data dataBits, Stop stopBits, Parity parity) {
+// rx_events is the depth of the driver's event queue, 0 for none. The driver posts to it
+// from the receive interrupt, so a reader can block on rxEvents() instead of polling.
+void Uart::begin(unsigned long baudrate, Data dataBits, Stop stopBits, Parity parity, int rx_events) {
     //    uart_driver_delete(_uart_num);
     uart_config_t conf;
     conf.baud_rate           = baudrate;
@@ -26,7 +30,20 @@ void Uart::begin(unsigned long baudrate, Data dataBits, Stop stopBits, Parity pa
     if (uart_param_config(_uart_num, &conf) != ESP_OK) {
         return;
     };
-    uart_driver_install(_uart_num, 256, 0, 0, NULL, 0);
+    uart_driver_install(_uart_num, 256, 0, rx_events, rx_events ? &_rx_events : NULL, 0);
+}
+
+// Sets how many character times of silence make the UART interrupt with a partly full FIFO,
+// and how full the FIFO gets before it interrupts anyway. The other interrupt settings are the
+// ones uart_driver_install() uses.
+bool Uart::setRxTimeout(uint8_t symbols, uint8_t full_threshold) {
+    uart_intr_config_t config;
+    config.intr_enable_mask = UART_RXFIFO_FULL_INT_ENA_M | UART_RXFIFO_TOUT_INT_ENA_M | UART_FRM_ERR_INT_ENA_M |
+                              UART_RXFIFO_OVF_INT_ENA_M | UART_BRK_DET_INT_ENA_M | UART_PARITY_ERR_INT_ENA_M;
+    config.rxfifo_full_thresh       = full_threshold;
+    config.rx_timeout_thresh        = symbols;
+    config.txfifo_empty_intr_thresh = 10;
+    return uart_intr_config(_uart_num, &config) != ESP_OK;
 }
 
 int Uart::available() {
@@ -70,15 +87,94 @@ size_t Uart::readBytes(char* buffer, size_t length) {
     return readBytes(buffer, length, (TickType_t)0);
 }
 size_t Uart::write(uint8_t c) {
-    return uart_write_bytes(_uart_num, (char*)&c, 1);
+    return write(&c, 1, false);
 }
 
 size_t Uart::write(const uint8_t* buffer, size_t length) {
-    return uart_write_bytes(_uart_num, (const char*)buffer, length);
+    return write(buffer, length, false);
 }
 
 size_t Uart::write(const char* text) {
-    return uart_write_bytes(_uart_num, text, strlen(text));
+    return write((const uint8_t*)text, strlen(text), false);
+}
+
+bool Uart::setTxQueue(size_t size) {
+    _tx_queue = (uint8_t*)heap_alloc(HeapTag::Serial, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    _tx_lock  = xSemaphoreCreateMutex();
+    if (_tx_queue == NULL || _tx_lock == NULL) {
+        _tx_queue = NULL;
+        return false;
+    }
+    _tx_head = 0;
+    _tx_tail = 0;
+    _tx_size = size;
+    return true;
+}
+
+// Moves as much of the queue as fits into the hardware FIFO, without waiting.
+void Uart::txDrainLocked() {
+    while (_tx_head != _tx_tail) {
+        size_t contiguous = (_tx_head > _tx_tail ? _tx_head : _tx_size) - _tx_tail;
+        int    sent       = uart_tx_chars(_uart_num, (const char*)&_tx_queue[_tx_tail], contiguous);
+        if (sent <= 0) {
+            return;
+        }
+        _tx_tail = (_tx_tail + sent) % _tx_size;
+    }
+}
+
+void Uart::drainTx() {
+    if (_tx_queue == NULL || _tx_head == _tx_tail) {
+        return;
+    }
+    xSemaphoreTake(_tx_lock, portMAX_DELAY);
+    txDrainLocked();
+    xSemaphoreGive(_tx_lock);
+}
+
+size_t Uart::write(const uint8_t* buffer, size_t length, bool low_priority) {
+    if (_tx_queue == NULL) {
+        return uart_write_bytes(_uart_num, (const char*)buffer, length);
+    }
+    xSemaphoreTake(_tx_lock, portMAX_DELAY);
+    txDrainLocked();
+    if (low_priority && txQueued() + length + _tx_size / 4 >= _tx_size) {
+        _tx_stats.dropped_writes++;
+        _tx_stats.dropped_bytes += length;
+        xSemaphoreGive(_tx_lock);
+        return 0;
+    }
+    size_t written = 0;
+    while (written < length) {
+        size_t room = _tx_size - 1 - txQueued();
+        if (room == 0) {
+            // Let the FIFO empty. Other writers may add to the queue meanwhile.
+            _tx_stats.full_waits++;
+            xSemaphoreGive(_tx_lock);
+            vTaskDelay(1);
+            xSemaphoreTake(_tx_lock, portMAX_DELAY);
+            txDrainLocked();
+            continue;
+        }
+        size_t chunk = MIN(length - written, MIN(room, _tx_size - _tx_head));
+        memcpy(&_tx_queue[_tx_head], buffer + written, chunk);
+        _tx_head = (_tx_head + chunk) % _tx_size;
+        written += chunk;
+        _tx_stats.high_water = MAX(_tx_stats.high_water, txQueued());
+    }
+    txDrainLocked();
+    xSemaphoreGive(_tx_lock);
+    return length;
+}
+
+bool Uart::setBaudRate(uint32_t baud) {
+    return uart_set_baudrate(_uart_num, baud) != ESP_OK;
+}
+
+// RTS/CTS handshake on the pins given to setPins(). RTS tells the sender to pause once
+// rts_threshold bytes are waiting in the receive FIFO.
+bool Uart::setHwFlowControl(bool enable, uint8_t rts_threshold) {
+    return uart_set_hw_flow_ctrl(_uart_num, enable ? UART_HW_FLOWCTRL_CTS_RTS : UART_HW_FLOWCTRL_DISABLE, rts_threshold) != ESP_OK;
 }
 
 bool Uart::setHalfDuplex() {
@@ -88,6 +184,11 @@ bool Uart::setPins(int tx_pin, int rx_pin, int rts_pin, int cts_pin) {
     return uart_set_pin(_uart_num, tx_pin, rx_pin, rts_pin, cts_pin) != ESP_OK;
 }
 bool Uart::flushTxTimed(TickType_t ticks) {
+    TickType_t start = xTaskGetTickCount();
+    while (_tx_queue != NULL && _tx_head != _tx_tail && xTaskGetTickCount() - start < ticks) {
+        drainTx();
+        vTaskDelay(1);
+    }
     return uart_wait_tx_done(_uart_num, ticks) != ESP_OK;
 }
 
@@ -2,10 +2,29 @@
 
 #include <driver/uart.h>
 
+// Counters of the optional transmit queue.
+struct UartTxStats {
+    uint32_t dropped_writes;  // Low priority writes dropped because the queue was backed up
+    uint32_t dropped_bytes;   // Bytes in those writes
+    uint32_t full_waits;      // Times a write had to wait for room in the queue
+    uint32_t high_water;      // Most bytes waiting in the queue
+};
+
 class Uart : public Stream {
 private:
-    uart_port_t _uart_num;
-    int         _pushback;
+    uart_port_t   _uart_num;
+    int           _pushback;
+    QueueHandle_t _rx_events;
+
+    uint8_t*          _tx_queue;
+    size_t            _tx_size;
+    size_t            _tx_head;
+    size_t            _tx_tail;
+    SemaphoreHandle_t _tx_lock;
+    UartTxStats       _tx_stats;
+
+    size_t txQueued() const { return (_tx_head + _tx_size - _tx_tail) % _tx_size; }
+    void   txDrainLocked();
 
 public:
     enum class Data : int {
@@ -30,7 +49,11 @@ public:
     Uart(int uart_num);
     bool          setHalfDuplex();
     bool          setPins(int tx_pin, int rx_pin, int rts_pin = -1, int cts_pin = -1);
-    void          begin(unsigned long baud, Data dataBits, Stop stopBits, Parity parity);
+    void          begin(unsigned long baud, Data dataBits, Stop stopBits, Parity parity, int rx_events = 0);
+    QueueHandle_t rxEvents() const { return _rx_events; }
+    bool          setRxTimeout(uint8_t symbols, uint8_t full_threshold = 120);
+    bool          setBaudRate(uint32_t baud);
+    bool          setHwFlowControl(bool enable, uint8_t rts_threshold);
     int           available(void) override;
     int           read(void) override;
     int           read(TickType_t timeout);
@@ -44,6 +67,16 @@ public:
     size_t        write(const char* text);
     void          flush() { uart_flush(_uart_num); }
     bool          flushTxTimed(TickType_t ticks);
+
+    // Optional transmit queue. Once it is set up, writes are copied into it and moved to the
+    // hardware FIFO by drainTx() and by later writes, so they only block when the queue is full.
+    // Low priority writes are dropped instead when they would leave less than a quarter of the
+    // queue free, which keeps room for the writes that must not be lost.
+    bool        setTxQueue(size_t size);
+    size_t      write(const uint8_t* buffer, size_t length, bool low_priority);
+    void        drainTx();
+    bool        txPending() const { return _tx_head != _tx_tail; }
+    UartTxStats txStats() const { return _tx_stats; }
 };
 
 extern Uart Uart0;
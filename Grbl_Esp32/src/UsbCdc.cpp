@@ -0,0 +1,106 @@
+/*
+  UsbCdc.cpp - G-code streaming over the native USB port of the ESP32-S2 and ESP32-S3
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The task is the only writer of the CLIENT_USB line buffer, as serialRxTask is for the
+  serial port. TinyUSB's events only wake it, since they run in the USB event task, which
+  must not wait on the line buffer. The build sets ARDUINO_USB_MODE=0 so that TinyUSB, not
+  the USB-Serial-JTAG peripheral, owns the port.
+*/
+
+#include "Grbl.h"
+
+#ifdef ENABLE_USB_CDC
+
+#    include <USB.h>
+#    include <USBCDC.h>
+
+static USBCDC cdc;
+
+Usb_Cdc UsbCdc;
+
+Usb_Cdc::Usb_Cdc() : _task(NULL), _held(0) {}
+
+bool Usb_Cdc::begin() {
+    cdc.setRxBufferSize(RX_FIFO_SIZE);
+    cdc.onEvent(event);
+    cdc.begin();
+    USB.begin();
+    if (_task == NULL) {
+        heap_task_create(task,                     // task
+                         "usbCdcTask",             // name for task
+                         STACK_SIZE,               // size of task stack
+                         this,                     // parameters
+                         SERIAL_RX_TASK_PRIORITY,  // priority
+                         &_task,                   // handle
+                         SUPPORT_TASK_CORE         // core
+        );
+    }
+    return _task != NULL;
+}
+
+bool Usb_Cdc::hasClient() const {
+    return bool(cdc);
+}
+
+// Connects, disconnects and received data all just wake the task.
+void Usb_Cdc::event(void* arg, esp_event_base_t base, int32_t id, void* data) {
+    if (UsbCdc._task != NULL) {
+        xTaskNotifyGive(UsbCdc._task);
+    }
+}
+
+void Usb_Cdc::task(void* pvParameters) {
+    Usb_Cdc* usb = static_cast<Usb_Cdc*>(pvParameters);
+    uint8_t  rx[RX_CHUNK];
+    size_t   start     = 0;
+    bool     connected = false;
+    while (true) {
+        // While bytes are held, look again each tick for room in the line buffer.
+        ulTaskNotifyTake(pdTRUE, usb->_held ? 1 : pdMS_TO_TICKS(IDLE_MS));
+        if (usb->hasClient() != connected) {
+            connected  = !connected;
+            usb->_held = 0;
+            if (connected) {
+                client_reset_read_buffer(CLIENT_USB);
+                report_init_message(CLIENT_USB);
+            }
+        }
+        while (connected) {
+            if (usb->_held == 0) {
+                int length = cdc.read(rx, RX_CHUNK);
+                if (length <= 0) {
+                    break;
+                }
+                start      = 0;
+                usb->_held = client_pick_realtime(CLIENT_USB, rx, length);
+            }
+            size_t taken = client_store_bytes(CLIENT_USB, rx + start, usb->_held);
+            start += taken;
+            usb->_held -= taken;
+            if (usb->_held) {
+                break;  // The line buffer is full
+            }
+        }
+    }
+}
+
+size_t Usb_Cdc::write(const uint8_t* buffer, size_t size) {
+    if (!hasClient()) {
+        return 0;  // Nobody would read it, so do not wait for TinyUSB to take it
+    }
+    return cdc.write(buffer, size);
+}
+
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+
+/*
+  UsbCdc.h - G-code streaming over the native USB port of the ESP32-S2 and ESP32-S3
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <esp_event.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <cstddef>
+#include <cstdint>
+
+// The chip's own USB port, as a CDC ACM device, is a client of its own, CLIENT_USB, that
+// behaves like the serial port without a baud rate or a USB-UART bridge in the way. TinyUSB
+// moves the data in 64 byte bulk packets. The task takes each packet as it arrives: realtime
+// commands are acted on and the rest goes straight to the line buffer. What does not fit is
+// held, and once TinyUSB's receive FIFO fills behind it the host is NAKed, so a sender that
+// outruns the protocol loop is held back rather than dropped.
+class Usb_Cdc {
+    static const size_t   RX_CHUNK     = 64;   // One full speed bulk packet
+    static const size_t   RX_FIFO_SIZE = 1024;
+    static const uint32_t IDLE_MS      = 100;  // How often the idle task looks for a host
+    static const uint32_t STACK_SIZE   = 4096;
+
+public:
+    Usb_Cdc();
+
+    bool   begin();
+    bool   hasClient() const;                   // A host has the port open
+    int    available() const { return _held; }  // Bytes waiting for room in the line buffer
+    size_t write(const uint8_t* buffer, size_t size);
+
+private:
+    static void task(void* pvParameters);
+    static void event(void* arg, esp_event_base_t base, int32_t id, void* data);
+
+    TaskHandle_t    _task;
+    volatile size_t _held;
+};
+
+extern Usb_Cdc UsbCdc;
@@ -18,6 +18,7 @@
 */
 
 #include "Grbl.h"
+#include "soc/ledc_struct.h"
 
 namespace UserOutput {
     DigitalOutput::DigitalOutput() {}
@@ -115,7 +116,20 @@ namespace UserOutput {
 
         _current_value = numerator;
 
-        ledcWrite(_pwm_channel, numerator);
+        // This was ledcWrite, but a synchronized M67 sets the level from the stepper ISR
+        // and ledcWrite uses RTOS features not compatible with ISRs
+        uint8_t group   = _pwm_channel / 8;
+        uint8_t channel = _pwm_channel % 8;
+        bool    on      = !!numerator;
+
+        LEDC.channel_group[group].channel[channel].duty.duty        = numerator << 4;
+        LEDC.channel_group[group].channel[channel].conf0.sig_out_en = on;
+        LEDC.channel_group[group].channel[channel].conf1.duty_start = on;
+        if (group) {
+            LEDC.channel_group[group].channel[channel].conf0.low_speed_update = 1;
+        } else {
+            LEDC.channel_group[group].channel[channel].conf0.clk_en = on;
+        }
 
         return true;
     }
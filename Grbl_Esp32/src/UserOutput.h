@@ -43,6 +43,7 @@ namespace UserOutput {
         AnalogOutput(uint8_t number, uint8_t pin, float pwm_frequency);
         bool     set_level(uint32_t numerator);
         uint32_t denominator() { return 1UL << _resolution_bits; };
+        bool     ready() { return _pin != UNDEFINED_PIN && _pwm_channel != uint8_t(-1); }
 
     protected:
         void init();
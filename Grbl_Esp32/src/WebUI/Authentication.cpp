@@ -7,11 +7,11 @@ namespace WebUI {
     StringSetting* admin_password;
 
     void remove_password(char* str, AuthenticationLevel& auth_level) {
-        String paramStr = String((const char*)str);
-        int    pos      = paramStr.indexOf("pwd=");
-        if (pos == -1) {
+        char* pwd = strstr(str, "pwd=");
+        if (pwd == NULL) {
             return;
         }
+        int pos = pwd - str;
 
         // Truncate the str string at the pwd= .
         // If the pwd= is preceded by a space, take off that space too.
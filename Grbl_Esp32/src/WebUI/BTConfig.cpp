@@ -35,8 +35,12 @@ namespace WebUI {
     }
 #    endif
 
-    String BTConfig::_btname   = "";
-    String BTConfig::_btclient = "";
+    String            BTConfig::_btname       = "";
+    String            BTConfig::_btclient     = "";
+    uint8_t           BTConfig::_TXbuffer[BTTXBUFFERSIZE];
+    size_t            BTConfig::_TXbufferSize = 0;
+    uint32_t          BTConfig::_TXfirst      = 0;
+    SemaphoreHandle_t BTConfig::_TXlock       = NULL;
 
     BTConfig::BTConfig() {}
 
@@ -51,8 +55,11 @@ namespace WebUI {
                 grbl_sendf(CLIENT_ALL, "[MSG:BT Connected with %s]\r\n", str);
             } break;
             case ESP_SPP_CLOSE_EVT:  //Client connection closed
-                grbl_send(CLIENT_ALL, "[MSG:BT Disconnected]\r\n");
                 BTConfig::_btclient = "";
+                grbl_send(CLIENT_ALL, "[MSG:BT Disconnected]\r\n");
+                break;
+            case ESP_SPP_DATA_IND_EVT:  //Data received, already queued by SerialBT
+                client_wake();
                 break;
             default:
                 break;
@@ -117,6 +124,9 @@ namespace WebUI {
         //stop active services
         end();
         _btname = bt_name->get();
+        if (_TXlock == NULL) {
+            _TXlock = xSemaphoreCreateMutex();
+        }
         if (wifi_radio_mode->get() == ESP_BT) {
             if (!SerialBT.begin(_btname)) {
                 report_status_message(Error::BtFailBegin, CLIENT_ALL);
@@ -132,7 +142,44 @@ namespace WebUI {
     /**
      * End WiFi
      */
-    void BTConfig::end() { SerialBT.end(); }
+    void BTConfig::end() {
+        if (_TXlock) {
+            xSemaphoreTake(_TXlock, portMAX_DELAY);
+            _TXbufferSize = 0;
+            xSemaphoreGive(_TXlock);
+        }
+        SerialBT.end();
+    }
+
+    size_t BTConfig::write(const uint8_t* buffer, size_t size) {
+        if (_TXlock == NULL || !SerialBT.hasClient()) {
+            return 0;
+        }
+        xSemaphoreTake(_TXlock, portMAX_DELAY);
+        size_t done = 0;
+        while (done < size) {
+            if (_TXbufferSize == BTTXBUFFERSIZE) {
+                flush();
+            }
+            if (_TXbufferSize == 0) {
+                _TXfirst = millis();
+            }
+            size_t count = MIN(size - done, BTTXBUFFERSIZE - _TXbufferSize);
+            memcpy(_TXbuffer + _TXbufferSize, buffer + done, count);
+            _TXbufferSize += count;
+            done += count;
+        }
+        xSemaphoreGive(_TXlock);
+        return size;
+    }
+
+    // SerialBT queues the packet for its own task, and only blocks once that queue is full.
+    void BTConfig::flush() {
+        if (_TXbufferSize) {
+            SerialBT.write(_TXbuffer, _TXbufferSize);
+            _TXbufferSize = 0;
+        }
+    }
 
     /**
      * Reset ESP
@@ -154,6 +201,13 @@ namespace WebUI {
     void BTConfig::handle() {
         //If needed
         COMMANDS::wait(0);
+        if (_TXbufferSize && _TXlock) {
+            xSemaphoreTake(_TXlock, portMAX_DELAY);
+            if (_TXbufferSize && (millis() - _TXfirst >= TXFLUSHMS || _TXbufferSize == BTTXBUFFERSIZE)) {
+                flush();
+            }
+            xSemaphoreGive(_TXlock);
+        }
     }
 
     BTConfig::~BTConfig() { end(); }
@@ -27,6 +27,8 @@
 const char* const DEFAULT_BT_NAME = "btgrblesp";
 
 #include <BluetoothSerial.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 namespace WebUI {
     extern BluetoothSerial SerialBT;
@@ -37,6 +39,11 @@ namespace WebUI {
         static const int MAX_BTNAME_LENGTH = 32;
         static const int MIN_BTNAME_LENGTH = 1;
 
+        // Output is gathered and handed to SerialBT, which sends each write as its own SPP
+        // packet, when the largest SPP payload is waiting or TXFLUSHMS after the first byte.
+        static const int      BTTXBUFFERSIZE = 990;  // ESP_SPP_MAX_MTU
+        static const uint32_t TXFLUSHMS      = 2;
+
         BTConfig();
 
         static const char* info();
@@ -48,12 +55,20 @@ namespace WebUI {
         static void        handle();
         static void        reset_settings();
         static bool        Is_BT_on();
+        static size_t      write(const uint8_t* buffer, size_t size);
+        static bool        TXpending() { return _TXbufferSize != 0; }
         static String      _btclient;
 
         ~BTConfig();
 
     private:
-        static String _btname;
+        static void flush();  // Call with _TXlock held
+
+        static String            _btname;
+        static uint8_t           _TXbuffer[BTTXBUFFERSIZE];
+        static size_t            _TXbufferSize;
+        static uint32_t          _TXfirst;  // millis() of the oldest byte not sent
+        static SemaphoreHandle_t _TXlock;
     };
 
     extern BTConfig bt_config;
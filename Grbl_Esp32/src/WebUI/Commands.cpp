@@ -74,6 +74,8 @@ namespace WebUI {
         COMMANDS::wait(0);
         //in case of restart requested
         if (restart_ESP_module) {
+            Coordinates::persist();
+            limits_save_position();
             ESP.restart();
             while (1) {}
         }
@@ -30,6 +30,8 @@ namespace WebUI {
         _header_sent = false;
         _webserver   = webserver;
         _client      = CLIENT_WEBUI;
+        _buffer      = NULL;
+        _buffered    = 0;
     }
 #endif
 
@@ -38,6 +40,8 @@ namespace WebUI {
 #if defined(ENABLE_HTTP) && defined(ENABLE_WIFI)
         _header_sent = false;
         _webserver   = NULL;
+        _buffer      = NULL;
+        _buffered    = 0;
 #endif
     }
 
@@ -47,6 +51,14 @@ namespace WebUI {
 #if defined(ENABLE_HTTP) && defined(ENABLE_WIFI)
         _header_sent = false;
         _webserver   = NULL;
+        _buffer      = NULL;
+        _buffered    = 0;
+#endif
+    }
+
+    ESPResponseStream::~ESPResponseStream() {
+#if defined(ENABLE_HTTP) && defined(ENABLE_WIFI)
+        pool_free(_buffer);
 #endif
     }
 
@@ -84,14 +96,24 @@ namespace WebUI {
                 _webserver->sendHeader("Cache-Control", "no-cache");
                 _webserver->send(200);
                 _header_sent = true;
+                if (!_buffer) {
+                    _buffer = (char*)pool_alloc(RESPONSE_BUFFER_SIZE);
+                }
+                _buffered = 0;
             }
 
-            _buffer += data;
-            if (_buffer.length() > 1200) {
-                //send data
-                _webserver->sendContent(_buffer);
-                //reset buffer
-                _buffer = "";
+            size_t len = strlen(data);
+            if (_buffered + len > RESPONSE_BUFFER_SIZE) {
+                sendBuffer();
+            }
+            if (!_buffer || len > RESPONSE_BUFFER_SIZE) {
+                _webserver->sendContent_P(data, len);
+                return;
+            }
+            memcpy(_buffer + _buffered, data, len);
+            _buffered += len;
+            if (_buffered > RESPONSE_CHUNK_SIZE) {
+                sendBuffer();
             }
             return;
         }
@@ -99,20 +121,26 @@ namespace WebUI {
         grbl_send(_client, data);
     }
 
+#if defined(ENABLE_HTTP) && defined(ENABLE_WIFI)
+    void ESPResponseStream::sendBuffer() {
+        if (_buffered) {
+            _webserver->sendContent_P(_buffer, _buffered);
+            _buffered = 0;
+        }
+    }
+#endif
+
     void ESPResponseStream::flush() {
 #if defined(ENABLE_HTTP) && defined(ENABLE_WIFI)
         if (_webserver) {
             if (_header_sent) {
-                //send data
-                if (_buffer.length() > 0) {
-                    _webserver->sendContent(_buffer);
-                }
+                sendBuffer();
 
                 //close connection
                 _webserver->sendContent("");
             }
             _header_sent = false;
-            _buffer      = "";
+            _buffered    = 0;
         }
 #endif
     }
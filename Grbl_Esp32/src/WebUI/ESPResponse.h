@@ -26,12 +26,20 @@ class WebServer;
 
 namespace WebUI {
     class ESPResponseStream {
+        // Web responses are sent in chunks of about this size, from a buffer taken from the
+        // block pool for the length of the response.
+        static const size_t RESPONSE_CHUNK_SIZE  = 1200;
+        static const size_t RESPONSE_BUFFER_SIZE = 1536;
+
     public:
 #if defined(ENABLE_HTTP) && defined(ENABLE_WIFI)
         ESPResponseStream(WebServer* webserver);
 #endif
         ESPResponseStream(uint8_t client, bool byid = true);
         ESPResponseStream();
+        ESPResponseStream(const ESPResponseStream&) = delete;
+        ESPResponseStream& operator=(const ESPResponseStream&) = delete;
+        ~ESPResponseStream();
 
         void          print(const char* data);
         void          println(const char* data);
@@ -46,7 +54,10 @@ namespace WebUI {
 
 #if defined(ENABLE_HTTP) && defined(ENABLE_WIFI)
         WebServer* _webserver;
-        String     _buffer;
+        char*      _buffer;
+        size_t     _buffered;
+
+        void sendBuffer();
 #endif
     };
 }
@@ -0,0 +1,118 @@
+/*
+  FlashAssets.cpp - WebUI files served from a flash partition mapped into memory
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The partition stays mapped from the first request on, so a file is sent straight out of
+  the flash cache, with no file system lookup, open or read, and no SPIFFS lock to wait for
+  while a job writes its log.
+*/
+
+#include "../Grbl.h"
+
+#if defined(ENABLE_WIFI) && defined(ENABLE_HTTP)
+
+#    include "FlashAssets.h"
+#    include <esp_partition.h>
+
+namespace WebUI {
+    static const char*    ASSETS_PARTITION = "webui";
+    static const uint32_t ASSETS_MAGIC     = 0x41495557;  // "WUIA"
+    static const uint16_t ASSETS_VERSION   = 1;
+
+    typedef struct {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t count;
+    } assets_header_t;
+
+    typedef struct {
+        char     path[ASSET_PATH_MAX];
+        uint32_t offset;
+        uint32_t size;
+        uint32_t crc;
+    } asset_entry_t;
+
+    static bool                    assets_tried = false;
+    static const uint8_t*          assets_base  = nullptr;
+    static const asset_entry_t*    assets_index;
+    static uint16_t                assets_count = 0;
+    static spi_flash_mmap_handle_t assets_handle;
+
+    static bool assets_valid(const uint8_t* base, size_t size) {
+        const assets_header_t* header = (const assets_header_t*)base;
+        if (header->magic != ASSETS_MAGIC || header->version != ASSETS_VERSION ||
+            sizeof(assets_header_t) + header->count * sizeof(asset_entry_t) > size) {
+            return false;
+        }
+        const asset_entry_t* index = (const asset_entry_t*)(base + sizeof(assets_header_t));
+        for (int i = 0; i < header->count; i++) {
+            const asset_entry_t* entry = &index[i];
+            if (entry->path[ASSET_PATH_MAX - 1] != '\0' || entry->offset > size || entry->size > size - entry->offset) {
+                return false;
+            }
+            if (i > 0 && strcmp(index[i - 1].path, entry->path) >= 0) {
+                return false;  // Not sorted, so it could not be searched
+            }
+        }
+        return true;
+    }
+
+    uint16_t flash_assets_begin() {
+        if (assets_tried) {
+            return assets_count;
+        }
+        assets_tried                     = true;
+        const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, ASSETS_PARTITION);
+        if (!partition) {
+            return 0;
+        }
+        const void* map;
+        if (esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &map, &assets_handle) != ESP_OK) {
+            return 0;
+        }
+        const uint8_t* base = (const uint8_t*)map;
+        if (!assets_valid(base, partition->size)) {
+            spi_flash_munmap(assets_handle);  // Erased, or written by another version of the script
+            return 0;
+        }
+        assets_base  = base;
+        assets_index = (const asset_entry_t*)(base + sizeof(assets_header_t));
+        assets_count = ((const assets_header_t*)base)->count;
+        return assets_count;
+    }
+
+    bool flash_asset_find(const char* path, flash_asset_t* asset) {
+        int low  = 0;
+        int high = int(assets_count) - 1;
+        while (low <= high) {
+            int                  mid   = (low + high) / 2;
+            const asset_entry_t* entry = &assets_index[mid];
+            int                  order = strcmp(path, entry->path);
+            if (order == 0) {
+                asset->data = assets_base + entry->offset;
+                asset->size = entry->size;
+                asset->crc  = entry->crc;
+                return true;
+            }
+            if (order < 0) {
+                high = mid - 1;
+            } else {
+                low = mid + 1;
+            }
+        }
+        return false;
+    }
+}
+
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+
+/*
+  FlashAssets.h - WebUI files served from a flash partition mapped into memory
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The partition is named "webui", see webui_assets.csv, and holds an image made by
+  doc/script/webui_assets.py. The image starts with a header and an index sorted by path,
+  and the gzip'd files follow:
+
+    uint32_t magic    "WUIA"
+    uint16_t version  1
+    uint16_t count
+    count entries of
+      char     path[56]  "/index.html", NUL padded
+      uint32_t offset    of the file from the start of the partition
+      uint32_t size
+      uint32_t crc       of the gzip'd file, for the ETag
+
+  A file found here is sent in place of the one of the same path on SPIFFS. Without the
+  partition, or with no valid image in it, the files come from SPIFFS as before.
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+namespace WebUI {
+    const int ASSET_PATH_MAX = 56;
+
+    typedef struct {
+        const uint8_t* data;  // In mapped flash, gzip'd
+        uint32_t       size;
+        uint32_t       crc;
+    } flash_asset_t;
+
+    // Maps the partition, once. Returns the number of files, 0 if there are none.
+    uint16_t flash_assets_begin();
+
+    // Looks path up in the index. Returns false if the image has no such file.
+    bool flash_asset_find(const char* path, flash_asset_t* asset);
+}
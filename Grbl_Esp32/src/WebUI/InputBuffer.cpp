@@ -22,45 +22,37 @@
 #include "InputBuffer.h"
 
 namespace WebUI {
-    InputBuffer inputBuffer;
+    InputBuffer::InputBuffer() : _RXheap(NULL), _RXring(_RXbuffer, RXBUFFERSIZE + 1) {}
 
-    InputBuffer::InputBuffer() {
-        _RXbufferSize = 0;
-        _RXbufferpos  = 0;
+    // Resizes the buffer to hold size bytes, dropping its contents. Neither
+    // side may be running. Sizes up to the built in one use the built in storage.
+    bool InputBuffer::setSize(size_t size) {
+        if (size == 0 || size > 0xfffe) {
+            return false;
+        }
+        uint8_t* storage = _RXbuffer;
+        if (size > RXBUFFERSIZE && (storage = (uint8_t*)malloc(size + 1)) == NULL) {
+            return false;
+        }
+        free(_RXheap);
+        _RXheap = storage == _RXbuffer ? NULL : storage;
+        _RXring.attach(storage, size + 1);
+        return true;
     }
 
-    void InputBuffer::begin() {
-        _RXbufferSize = 0;
-        _RXbufferpos  = 0;
-    }
+    // begin() and end() are called from the reading side, so they drop what
+    // has been received rather than resetting the producer's index.
+    void InputBuffer::begin() { _RXring.discard(); }
 
-    void InputBuffer::end() {
-        _RXbufferSize = 0;
-        _RXbufferpos  = 0;
-    }
+    void InputBuffer::end() { _RXring.discard(); }
 
     InputBuffer::operator bool() const { return true; }
 
-    int InputBuffer::available() { return _RXbufferSize; }
-
-    int InputBuffer::availableforwrite() { return RXBUFFERSIZE - _RXbufferSize; }
-
-    size_t InputBuffer::write(uint8_t c) {
-        if ((1 + _RXbufferSize) <= RXBUFFERSIZE) {
-            int current = _RXbufferpos + _RXbufferSize;
-            if (current > RXBUFFERSIZE) {
-                current = current - RXBUFFERSIZE;
-            }
-            if (current > (RXBUFFERSIZE - 1)) {
-                current = 0;
-            }
-            _RXbuffer[current] = c;
-            current++;
-            _RXbufferSize += 1;
-            return 1;
-        }
-        return 0;
-    }
+    int InputBuffer::available() { return _RXring.count(); }
+
+    int InputBuffer::availableforwrite() { return _RXring.available(); }
+
+    size_t InputBuffer::write(uint8_t c) { return _RXring.push(c) ? 1 : 0; }
 
     size_t InputBuffer::write(const uint8_t* buffer, size_t size) {
         //No need currently
@@ -69,45 +61,24 @@ namespace WebUI {
     }
 
     int InputBuffer::peek(void) {
-        if (_RXbufferSize > 0) {
-            return _RXbuffer[_RXbufferpos];
-        } else {
-            return -1;
-        }
+        uint8_t* c = _RXring.consumer_slot();
+        return c ? *c : -1;
     }
 
     bool InputBuffer::push(const char* data) {
-        int data_size = strlen(data);
-        if ((data_size + _RXbufferSize) <= RXBUFFERSIZE) {
-            int current = _RXbufferpos + _RXbufferSize;
-            if (current > RXBUFFERSIZE) {
-                current = current - RXBUFFERSIZE;
-            }
-            for (int i = 0; i < data_size; i++) {
-                if (current > (RXBUFFERSIZE - 1)) {
-                    current = 0;
-                }
-                _RXbuffer[current] = data[i];
-                current++;
-            }
-            _RXbufferSize += strlen(data);
-            return true;
+        size_t data_size = strlen(data);
+        if (data_size > size_t(_RXring.available())) {
+            return false;
         }
-        return false;
+        for (size_t i = 0; i < data_size; i++) {
+            _RXring.push(uint8_t(data[i]));
+        }
+        return true;
     }
 
     int InputBuffer::read(void) {
-        if (_RXbufferSize > 0) {
-            int v = _RXbuffer[_RXbufferpos];
-            _RXbufferpos++;
-            if (_RXbufferpos > (RXBUFFERSIZE - 1)) {
-                _RXbufferpos = 0;
-            }
-            _RXbufferSize--;
-            return v;
-        } else {
-            return -1;
-        }
+        uint8_t c;
+        return _RXring.pop(c) ? c : -1;
     }
 
     void InputBuffer::flush(void) {
@@ -115,8 +86,5 @@ namespace WebUI {
         //keep for compatibility
     }
 
-    InputBuffer::~InputBuffer() {
-        _RXbufferSize = 0;
-        _RXbufferpos  = 0;
-    }
+    InputBuffer::~InputBuffer() { free(_RXheap); }
 }
@@ -23,6 +23,8 @@
 #include <Print.h>
 #include <cstring>
 
+#include "../SpscRing.h"
+
 namespace WebUI {
     class InputBuffer : public Print {
     public:
@@ -36,6 +38,7 @@ namespace WebUI {
         inline size_t write(unsigned int n) { return write((uint8_t)n); }
         inline size_t write(int n) { return write((uint8_t)n); }
         void          begin();
+        bool          setSize(size_t size);
         void          end();
         int           available();
         int           availableforwrite();
@@ -51,10 +54,11 @@ namespace WebUI {
     private:
         static const int RXBUFFERSIZE = 256;
 
-        uint8_t  _RXbuffer[RXBUFFERSIZE];
-        uint16_t _RXbufferSize;
-        uint16_t _RXbufferpos;
+        // One producer (the client check task) and one consumer (the protocol
+        // loop), so the ring needs no lock. It keeps one slot free. setSize()
+        // can move it to a larger buffer on the heap.
+        uint8_t                     _RXbuffer[RXBUFFERSIZE + 1];
+        uint8_t*                    _RXheap;
+        SpscRing<uint8_t, uint16_t> _RXring;
     };
-
-    extern InputBuffer inputBuffer;
 }
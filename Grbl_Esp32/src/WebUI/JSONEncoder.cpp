@@ -10,7 +10,44 @@ namespace WebUI {
 
     // Constructor.  If _pretty is true, newlines are
     // inserted into the JSON string for easy reading.
-    JSONencoder::JSONencoder(bool pretty) : pretty(pretty), level(0), str("") { count[level] = 0; }
+    JSONencoder::JSONencoder(bool pretty) : JSONencoder(pretty, NULL) {}
+
+    // Constructor for encoding straight to a response stream.
+    JSONencoder::JSONencoder(bool pretty, ESPResponseStream* stream) :
+        pretty(pretty), level(0), str(""), stream(stream), buffered(0) {
+        count[level] = 0;
+    }
+
+    // Private functions to add text to the string, or to the stream buffer
+    void JSONencoder::add(char c) {
+        if (!stream) {
+            str += c;
+            return;
+        }
+        buffer[buffered++] = c;
+        if (buffered == STREAM_BUFFER_SIZE - 1) {
+            flush();
+        }
+    }
+
+    void JSONencoder::add(const char* s) {
+        if (!stream) {
+            str.concat(s);
+            return;
+        }
+        while (*s) {
+            add(*s++);
+        }
+    }
+
+    // Private function to print what the stream buffer holds
+    void JSONencoder::flush() {
+        if (stream && buffered) {
+            buffer[buffered] = '\0';
+            stream->print(buffer);
+            buffered = 0;
+        }
+    }
 
     // Private function to add commas between
     // elements as needed, omitting the comma
@@ -38,7 +75,7 @@ namespace WebUI {
     // Private function to add a name enclosed with quotes.
     void JSONencoder::quoted(const char* s) {
         add('"');
-        str.concat(s);
+        add(s);
         add('"');
     }
 
@@ -73,6 +110,7 @@ namespace WebUI {
     // and returning the encoded string
     String JSONencoder::end() {
         end_object();
+        flush();
         return str;
     }
 
@@ -128,7 +166,11 @@ namespace WebUI {
     }
 
     // Creates a "tag":"value" member from an integer
-    void JSONencoder::member(const char* tag, int value) { member(tag, String(value)); }
+    void JSONencoder::member(const char* tag, int value) {
+        char s[12];
+        snprintf(s, sizeof(s), "%d", value);
+        member(tag, s);
+    }
 
     // Creates an Esp32_WebUI configuration item specification from
     // a value passed in as a C-style string.
@@ -144,7 +186,9 @@ namespace WebUI {
     // Creates an Esp32_WebUI configuration item specification from
     // an integer value.
     void JSONencoder::begin_webui(const char* p, const char* help, const char* type, int val) {
-        begin_webui(p, help, type, String(val).c_str());
+        char s[12];
+        snprintf(s, sizeof(s), "%d", val);
+        begin_webui(p, help, type, s);
     }
 
     // Creates an Esp32_WebUI configuration item specification from
@@ -3,16 +3,24 @@
 // Class for creating JSON-encoded strings.
 
 namespace WebUI {
+    class ESPResponseStream;
+
     class JSONencoder {
     private:
-        static const int MAX_JSON_LEVEL = 16;
-
-        bool   pretty;
-        int    level;
-        String str;
-        int    count[MAX_JSON_LEVEL];
-        void   add(char c) { str += c; }
-        void   comma_line();
+        static const int MAX_JSON_LEVEL     = 16;
+        static const int STREAM_BUFFER_SIZE = 256;
+
+        bool               pretty;
+        int                level;
+        String             str;
+        int                count[MAX_JSON_LEVEL];
+        ESPResponseStream* stream;
+        char               buffer[STREAM_BUFFER_SIZE];
+        int                buffered;
+        void               add(char c);
+        void               add(const char* s);
+        void               flush();
+        void               comma_line();
         void   comma();
         void   quoted(const char* s);
         void   inc_level();
@@ -26,10 +34,17 @@ namespace WebUI {
         // Constructor; set _pretty true for pretty printing
         JSONencoder(bool pretty);
 
+        // Constructor for output that is too big to build in memory, like
+        // the settings list. The encoded text is printed to the stream
+        // as it is made, through a small fixed buffer, instead of being
+        // collected in the string.
+        JSONencoder(bool pretty, ESPResponseStream* stream);
+
         // begin() starts the encoding process.
         void begin();
 
-        // end() returns the encoded string
+        // end() returns the encoded string, or an empty string when
+        // it was printed to a stream
         String end();
 
         // member() creates a "tag":"value" element
@@ -54,6 +54,10 @@ namespace WebUI {
         _token1           = "";
         _token1           = "";
         _settings         = "";
+        _queue            = NULL;
+        _lock             = NULL;
+        _task             = NULL;
+        _dropped          = 0;
     }
 
     bool Wait4Answer(WiFiClientSecure& client, const char* linetrigger, const char* expected_answer, uint32_t timeout) {
@@ -100,6 +104,55 @@ namespace WebUI {
     }
 
     bool NotificationsService::sendMSG(const char* title, const char* message) {
+        if (_lock == NULL) {
+            return false;  // Never begun
+        }
+        xSemaphoreTake(_lock, portMAX_DELAY);
+        bool res = send(title, message);
+        xSemaphoreGive(_lock);
+        return res;
+    }
+
+    bool NotificationsService::queueMSG(const char* title, const char* message) {
+        if (!_started || _queue == NULL) {
+            return false;
+        }
+        queued_t queued;
+        strncpy(queued.title, title, TITLE_LENGTH - 1);
+        queued.title[TITLE_LENGTH - 1] = '\0';
+        strncpy(queued.message, message, MESSAGE_LENGTH - 1);
+        queued.message[MESSAGE_LENGTH - 1] = '\0';
+        if (xQueueSend(_queue, &queued, 0) != pdTRUE) {
+            _dropped++;
+            return false;
+        }
+        return true;
+    }
+
+    void NotificationsService::sendTask(void* pvParameters) {
+        NotificationsService* service = static_cast<NotificationsService*>(pvParameters);
+        queued_t              queued;
+        while (true) {
+            xQueueReceive(service->_queue, &queued, portMAX_DELAY);
+            for (int attempt = 0; attempt <= RETRIES; attempt++) {
+                if (attempt) {
+                    vTaskDelay(RETRY_MS / portTICK_PERIOD_MS);
+                }
+                if (!service->_started) {
+                    break;  // Turned off; what is queued goes with it
+                }
+                if (service->sendMSG(queued.title, queued.message)) {
+                    break;
+                }
+                if (attempt == RETRIES) {
+                    service->_dropped++;
+                }
+            }
+        }
+    }
+
+    // Called with _lock held.
+    bool NotificationsService::send(const char* title, const char* message) {
         if (!_started) {
             return false;
         }
@@ -312,6 +365,28 @@ namespace WebUI {
 
     bool NotificationsService::begin() {
         end();
+        if (_lock == NULL) {
+            _lock  = xSemaphoreCreateMutex();
+            _queue = xQueueCreate(QUEUE_LENGTH, sizeof(queued_t));
+        }
+        xSemaphoreTake(_lock, portMAX_DELAY);
+        bool res = start();
+        xSemaphoreGive(_lock);
+        if (_started && _task == NULL) {
+            heap_task_create(sendTask,          // task
+                             "notifyTask",      // name for task
+                             STACK_SIZE,        // size of task stack
+                             this,              // parameters
+                             1,                 // priority
+                             &_task,            // handle
+                             0                  // core, away from the main loop
+            );
+        }
+        return res;
+    }
+
+    // Called with _lock held.
+    bool NotificationsService::start() {
         _notificationType = notification_type->get();
         switch (_notificationType) {
             case 0:  //no notification = no error but no start
@@ -353,14 +428,16 @@ namespace WebUI {
         if (!_started) {
             return;
         }
-
-        _started          = false;
+        _started = false;  // Before the lock, so that the task gives up on what it is retrying
+        xSemaphoreTake(_lock, portMAX_DELAY);
         _notificationType = 0;
         _token1           = "";
         _token1           = "";
         _settings         = "";
         _serveraddress    = "";
         _port             = 0;
+        xQueueReset(_queue);
+        xSemaphoreGive(_lock);
     }
 
     void NotificationsService::handle() {
@@ -20,28 +20,64 @@
   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
 namespace WebUI {
     class NotificationsService {
+        // queueMSG() copies messages into a queue of this many, read by _task. A full queue
+        // drops the new message. A message that fails is tried again RETRIES times, RETRY_MS
+        // apart, before it is dropped.
+        static const int      QUEUE_LENGTH   = 4;
+        static const int      TITLE_LENGTH   = 32;
+        static const int      MESSAGE_LENGTH = 128;
+        static const int      RETRIES        = 2;
+        static const int      RETRY_MS       = 10000;
+        static const uint32_t STACK_SIZE     = 8192;  // The TLS handshake needs most of it
+
+        typedef struct {
+            char title[TITLE_LENGTH];
+            char message[MESSAGE_LENGTH];
+        } queued_t;
+
     public:
         NotificationsService();
 
-        bool        begin();
-        void        end();
-        void        handle();
-        bool        sendMSG(const char* title, const char* message);
+        bool begin();
+        void end();
+        void handle();
+
+        // Sends now, waiting for the server. For $ESP600, which reports the result.
+        bool sendMSG(const char* title, const char* message);
+
+        // Queues the message for _task, so the caller never waits on the network. Long
+        // messages are truncated. Returns false if the service is off or the queue is full.
+        bool queueMSG(const char* title, const char* message);
+
         const char* getTypeString();
         bool        started();
+        uint32_t    dropped() { return _dropped; }
 
         ~NotificationsService();
 
     private:
-        bool     _started;
-        uint8_t  _notificationType;
-        String   _token1;
-        String   _token2;
-        String   _settings;
-        String   _serveraddress;
-        uint16_t _port;
+        bool              _started;
+        uint8_t           _notificationType;
+        String            _token1;
+        String            _token2;
+        String            _settings;
+        String            _serveraddress;
+        uint16_t          _port;
+        QueueHandle_t     _queue;
+        SemaphoreHandle_t _lock;  // Held while sending, and by begin() and end(), which change the strings
+        TaskHandle_t      _task;
+        uint32_t          _dropped;
+
+        static void sendTask(void* pvParameters);
+        bool        start();
+        bool        send(const char* title, const char* message);
 
         bool sendPushoverMSG(const char* title, const char* message);
         bool sendEmailMSG(const char* title, const char* message);
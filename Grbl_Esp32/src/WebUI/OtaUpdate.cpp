@@ -0,0 +1,286 @@
+/*
+  OtaUpdate.cpp - Firmware uploads, written to flash behind the web server
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The buffers go round as those of the SD write-behind do: full ones to otaWriteTask through
+  ota_full, and back through ota_free once written. Only the task touches Update, the digest
+  and the inflater between ota_begin() and ota_end(), which waits for every buffer to come back.
+*/
+
+#include "../Grbl.h"
+
+#if defined(ENABLE_WIFI) && defined(ENABLE_HTTP)
+
+#    include "OtaUpdate.h"
+#    include <Update.h>
+#    include <mbedtls/sha256.h>
+#    include <rom/miniz.h>
+
+namespace WebUI {
+    typedef struct {
+        uint8_t index;
+        size_t  length;
+    } ota_block_t;
+
+    // Deflate refers back up to 32 KB, so that much of the output is kept in dict.
+    typedef struct {
+        tinfl_decompressor inflator;
+        uint8_t            dict[TINFL_LZ_DICT_SIZE];
+        size_t             dict_pos;  // Where inflating continues in dict
+        bool               header;    // The gzip header has been skipped
+        bool               done;
+    } ota_gz_t;
+
+    static uint8_t*               ota_buffers[OTA_BUFFERS];
+    static QueueHandle_t          ota_free = NULL;
+    static QueueHandle_t          ota_full = NULL;
+    static ota_block_t            ota_block;  // The buffer being filled
+    static bool                   ota_filling;
+    static bool                   ota_active = false;
+    static volatile bool          ota_error;
+    static ota_gz_t*              ota_gz = NULL;
+    static mbedtls_sha256_context ota_sha;
+    static uint8_t                ota_expected[32];
+    static bool                   ota_check;  // ota_expected was given
+
+    static bool ota_flash(const uint8_t* data, size_t length) {
+        mbedtls_sha256_update_ret(&ota_sha, data, length);
+        return Update.write((uint8_t*)data, length) == length;
+    }
+
+    // The length of the gzip header at the start of data, or 0 if it is not one or does not
+    // fit in the first block.
+    static size_t gz_header_length(const uint8_t* data, size_t length) {
+        if (length < 10 || data[0] != 0x1f || data[1] != 0x8b || data[2] != 8) {
+            return 0;
+        }
+        uint8_t flags = data[3];
+        size_t  pos   = 10;
+        if (flags & 0x04) {  // FEXTRA
+            if (pos + 2 > length) {
+                return 0;
+            }
+            pos += 2 + (data[pos] | (data[pos + 1] << 8));
+        }
+        for (uint8_t flag = 0x08; flag <= 0x10; flag <<= 1) {  // FNAME, FCOMMENT
+            if (flags & flag) {
+                while (pos < length && data[pos]) {
+                    pos++;
+                }
+                pos++;
+            }
+        }
+        if (flags & 0x02) {  // FHCRC
+            pos += 2;
+        }
+        return pos < length ? pos : 0;
+    }
+
+    static bool ota_inflate(const uint8_t* data, size_t length) {
+        ota_gz_t* gz = ota_gz;
+        if (!gz->header) {
+            size_t skip = gz_header_length(data, length);
+            if (skip == 0) {
+                return false;
+            }
+            gz->header = true;
+            data += skip;
+            length -= skip;
+        }
+        tinfl_status status = TINFL_STATUS_NEEDS_MORE_INPUT;
+        while (!gz->done && (length || status == TINFL_STATUS_HAS_MORE_OUTPUT)) {
+            size_t in_bytes  = length;
+            size_t out_bytes = TINFL_LZ_DICT_SIZE - gz->dict_pos;
+            status           = tinfl_decompress(
+                &gz->inflator, data, &in_bytes, gz->dict, gz->dict + gz->dict_pos, &out_bytes, TINFL_FLAG_HAS_MORE_INPUT);
+            if (status < TINFL_STATUS_DONE || (out_bytes && !ota_flash(gz->dict + gz->dict_pos, out_bytes))) {
+                return false;
+            }
+            gz->dict_pos = (gz->dict_pos + out_bytes) & (TINFL_LZ_DICT_SIZE - 1);
+            gz->done     = status == TINFL_STATUS_DONE;
+            data += in_bytes;
+            length -= in_bytes;
+        }
+        return true;  // What follows the deflate data, the gzip trailer, is ignored.
+    }
+
+    static void otaWriteTask(void* pvParameters) {
+        ota_block_t block;
+        while (true) {
+            xQueueReceive(ota_full, &block, portMAX_DELAY);
+            if (!ota_error) {
+                uint8_t* data = ota_buffers[block.index];
+                if (!(ota_gz ? ota_inflate(data, block.length) : ota_flash(data, block.length))) {
+                    ota_error = true;
+                }
+            }
+            xQueueSend(ota_free, &block.index, portMAX_DELAY);
+        }
+    }
+
+    static bool hex_digest(const char* hex, uint8_t* digest) {
+        if (strlen(hex) != 64) {
+            return false;
+        }
+        for (int i = 0; i < 32; i++) {
+            char byte[3] = { hex[2 * i], hex[2 * i + 1], '\0' };
+            if (!isxdigit(byte[0]) || !isxdigit(byte[1])) {
+                return false;
+            }
+            digest[i] = strtoul(byte, NULL, 16);
+        }
+        return true;
+    }
+
+    static void ota_free_buffers() {
+        for (uint8_t i = 0; i < OTA_BUFFERS; i++) {
+            if (ota_buffers[i]) {
+                heap_free(HeapTag::Web, ota_buffers[i], OTA_BLOCK_SIZE);
+                ota_buffers[i] = NULL;
+            }
+        }
+        if (ota_gz) {
+            heap_free(HeapTag::Web, ota_gz, sizeof(ota_gz_t));
+            ota_gz = NULL;
+        }
+    }
+
+    // Waits for otaWriteTask to finish with what is queued. Called with ota_error set, the
+    // task drops it instead.
+    static void ota_drain() {
+        if (ota_filling) {
+            if (ota_block.length && !ota_error) {
+                xQueueSend(ota_full, &ota_block, portMAX_DELAY);
+            } else {
+                xQueueSend(ota_free, &ota_block.index, portMAX_DELAY);
+            }
+            ota_filling = false;
+        }
+        uint8_t index;
+        for (uint8_t i = 0; i < OTA_BUFFERS; i++) {  // All written once all are back
+            xQueueReceive(ota_free, &index, portMAX_DELAY);
+        }
+    }
+
+    bool ota_begin(bool compressed, const char* sha256) {
+        if (ota_active) {
+            ota_abort();
+        }
+        ota_check = sha256 != NULL;
+        if (ota_check && !hex_digest(sha256, ota_expected)) {
+            return false;
+        }
+        if (ota_free == NULL) {
+            ota_free = xQueueCreate(OTA_BUFFERS, sizeof(uint8_t));
+            ota_full = xQueueCreate(OTA_BUFFERS, sizeof(ota_block_t));
+            heap_task_create(otaWriteTask,    // task
+                             "otaWriteTask",  // name for task
+                             4096,            // size of task stack
+                             NULL,            // parameters
+                             1,               // priority
+                             NULL,            // handle
+                             0                // core, away from the main loop
+            );
+        }
+        for (uint8_t i = 0; i < OTA_BUFFERS; i++) {
+            ota_buffers[i] = (uint8_t*)heap_alloc_large(HeapTag::Web, OTA_BLOCK_SIZE);
+            if (ota_buffers[i] == NULL) {
+                ota_free_buffers();
+                return false;
+            }
+        }
+        if (compressed) {
+            ota_gz = (ota_gz_t*)heap_alloc_large(HeapTag::Web, sizeof(ota_gz_t));
+            if (ota_gz == NULL) {
+                ota_free_buffers();
+                return false;
+            }
+            tinfl_init(&ota_gz->inflator);
+            ota_gz->dict_pos = 0;
+            ota_gz->header   = false;
+            ota_gz->done     = false;
+        }
+        if (!Update.begin()) {  // With the whole of the next OTA partition
+            ota_free_buffers();
+            return false;
+        }
+        mbedtls_sha256_init(&ota_sha);
+        mbedtls_sha256_starts_ret(&ota_sha, 0);
+        for (uint8_t i = 0; i < OTA_BUFFERS; i++) {
+            xQueueSend(ota_free, &i, portMAX_DELAY);
+        }
+        ota_filling = false;
+        ota_error   = false;
+        ota_active  = true;
+        return true;
+    }
+
+    bool ota_write(const uint8_t* data, size_t length) {
+        while (length && !ota_error) {
+            if (!ota_filling) {
+                xQueueReceive(ota_free, &ota_block.index, portMAX_DELAY);  // Waits while the flash catches up
+                ota_block.length = 0;
+                ota_filling      = true;
+            }
+            size_t count = MIN(length, OTA_BLOCK_SIZE - ota_block.length);
+            memcpy(ota_buffers[ota_block.index] + ota_block.length, data, count);
+            ota_block.length += count;
+            data += count;
+            length -= count;
+            if (ota_block.length == OTA_BLOCK_SIZE) {
+                xQueueSend(ota_full, &ota_block, portMAX_DELAY);
+                ota_filling = false;
+            }
+        }
+        return !ota_error;
+    }
+
+    bool ota_end(char* digest) {
+        *digest = '\0';
+        if (!ota_active) {
+            return false;
+        }
+        ota_drain();
+        bool    ok = !ota_error && (!ota_gz || ota_gz->done);
+        uint8_t sum[32];
+        mbedtls_sha256_finish_ret(&ota_sha, sum);
+        mbedtls_sha256_free(&ota_sha);
+        ota_free_buffers();
+        ota_active = false;
+        for (int i = 0; i < 32; i++) {
+            sprintf(digest + 2 * i, "%02x", sum[i]);
+        }
+        if (ok && ota_check && memcmp(sum, ota_expected, sizeof(sum))) {
+            ok = false;
+        }
+        if (!ok) {
+            Update.abort();
+            return false;
+        }
+        return Update.end(true);  // true to set the size to what was written
+    }
+
+    void ota_abort() {
+        if (!ota_active) {
+            return;
+        }
+        ota_error = true;
+        ota_drain();
+        mbedtls_sha256_free(&ota_sha);
+        ota_free_buffers();
+        ota_active = false;
+        Update.abort();
+    }
+}
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+/*
+  OtaUpdate.h - Firmware uploads, written to flash behind the web server
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+namespace WebUI {
+    // The upload is handed to otaWriteTask, on core 0, in blocks of this size, so the next
+    // chunk is received while the last is inflated, hashed and written to flash.
+    const size_t OTA_BLOCK_SIZE = 8192;
+    const int    OTA_BUFFERS    = 3;
+
+    // Starts an update. A gzip image, compressed is true, is inflated as it is written. sha256,
+    // if not NULL, is the digest in hex of the image as it is written, so of the .bin and not
+    // the .gz, which ota_end() checks before the image is made bootable.
+    bool ota_begin(bool compressed, const char* sha256);
+
+    // Queues data for otaWriteTask. Returns false once a write has failed.
+    bool ota_write(const uint8_t* data, size_t length);
+
+    // Waits for the writes, checks the digest and sets the new image to boot. The digest of
+    // what was written is left in digest, 65 bytes of hex, to be reported.
+    bool ota_end(char* digest);
+
+    // Drops an update that was begun, leaving the running image to boot.
+    void ota_abort();
+}
@@ -167,7 +167,16 @@ namespace WebUI {
     void Serial_2_Socket::flush(void) {
         if (_TXbufferSize > 0) {
             log_i("[SOCKET]flush data, buffer size %d", _TXbufferSize);
+#    ifdef ENABLE_WEBSOCKET_STREAM
+            // Not to the G-code stream, which gets output for its own client
+            for (uint8_t num = 0; num < WEBSOCKETS_SERVER_CLIENT_MAX; num++) {
+                if (!SocketStream.connected(num)) {
+                    _web_socket->sendBIN(num, _TXbuffer, _TXbufferSize);
+                }
+            }
+#    else
             _web_socket->broadcastBIN(_TXbuffer, _TXbufferSize);
+#    endif
 
             //refresh timout
             _lastflush = millis();
@@ -0,0 +1,223 @@
+/*
+  SocketEvents.cpp - Machine state events pushed over the WebUI WebSocket
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The socket library runs in the client task, so subscriptions change and events go out there,
+  compared against what was last sent each time the web server is handled. Only alarms come
+  from another task; the alarm is noted and sent from here.
+*/
+
+#include "../Grbl.h"
+
+#if defined(ENABLE_WIFI) && defined(ENABLE_HTTP) && defined(ENABLE_WEBSOCKET_EVENTS)
+
+#    include "SocketEvents.h"
+#    include <WebSocketsServer.h>
+
+namespace WebUI {
+    Socket_Events SocketEvents;
+
+    Socket_Events::Socket_Events() : _web_socket(NULL), _topics(0), _sd(-1), _alarm(-1) {
+        memset(_subscribers, 0, sizeof(_subscribers));
+        memset(_override, 0, sizeof(_override));
+        _state[0] = '\0';
+    }
+
+    void Socket_Events::attachWS(WebSocketsServer* web_socket) {
+        _web_socket = web_socket;
+        memset(_subscribers, 0, sizeof(_subscribers));
+        _topics = 0;
+    }
+
+    void Socket_Events::detachWS() {
+        _web_socket = NULL;
+        _topics     = 0;
+    }
+
+    bool Socket_Events::subscribe(uint8_t num, const char* message) {
+        const char* prefix = "SUBSCRIBE:";
+        if (strncmp(message, prefix, strlen(prefix)) != 0) {
+            return false;
+        }
+        if (num >= MAX_SUBSCRIBERS) {
+            return true;
+        }
+        subscriber_t* s = &_subscribers[num];
+        s->topics       = 0;
+        s->position_ms  = DEFAULT_POSITION_MS;
+        for (const char* topic = message + strlen(prefix); *topic;) {
+            const char* end = strchr(topic, ',');
+            size_t      len = end ? end - topic : strlen(topic);
+            if (len >= 5 && strncasecmp(topic, "state", 5) == 0) {
+                s->topics |= TOPIC_STATE;
+            } else if (len >= 5 && strncasecmp(topic, "alarm", 5) == 0) {
+                s->topics |= TOPIC_ALARM;
+            } else if (len >= 3 && strncasecmp(topic, "pos", 3) == 0) {
+                s->topics |= TOPIC_POSITION;
+                if (topic[3] == '=') {
+                    s->position_ms = MAX(uint32_t(atoi(topic + 4)), MIN_POSITION_MS);
+                }
+            } else if (len == 2 && strncasecmp(topic, "sd", 2) == 0) {
+                s->topics |= TOPIC_SD;
+            } else if (len == 2 && strncasecmp(topic, "ov", 2) == 0) {
+                s->topics |= TOPIC_OVERRIDE;
+#    ifdef POSITION_CAPTURE
+            } else if (len == 7 && strncasecmp(topic, "capture", 7) == 0) {
+                s->topics |= TOPIC_CAPTURE;
+#    endif
+            }
+            topic += end ? len + 1 : len;
+        }
+        s->snapshot      = true;
+        s->position_next = millis();
+        memset(s->position, 0xFF, sizeof(s->position));  // NaN, never equal to a position
+        _topics          = 0;
+        for (int i = 0; i < MAX_SUBSCRIBERS; i++) {
+            _topics |= _subscribers[i].topics;
+        }
+        return true;
+    }
+
+    void Socket_Events::disconnect(uint8_t num) {
+        if (num < MAX_SUBSCRIBERS && _subscribers[num].topics) {
+            _subscribers[num].topics = 0;
+            _topics                  = 0;
+            for (int i = 0; i < MAX_SUBSCRIBERS; i++) {
+                _topics |= _subscribers[i].topics;
+            }
+        }
+    }
+
+    void Socket_Events::alarm(ExecAlarm alarm_code) { _alarm = static_cast<int>(alarm_code); }
+
+    // Sends text to the subscribers to topic, leaving out the ones about to get a snapshot.
+    void Socket_Events::send(uint8_t topic, const char* text) {
+        for (uint8_t num = 0; num < MAX_SUBSCRIBERS; num++) {
+            if ((_subscribers[num].topics & topic) && !_subscribers[num].snapshot) {
+                _web_socket->sendTXT(num, text);
+            }
+        }
+    }
+
+#    ifdef POSITION_CAPTURE
+    // Sends everything captured so far, a header and up to CAPTURE_MESSAGE_RECORDS records to a
+    // message. With no subscriber the records stay in the ring until it fills.
+    void Socket_Events::send_capture() {
+        static uint8_t message[sizeof(CaptureHeader) + CAPTURE_MESSAGE_RECORDS * sizeof(CaptureRecord)];
+        if (!(_topics & TOPIC_CAPTURE) || capture_sink() != CaptureSink::Socket) {
+            return;
+        }
+        capture_header((CaptureHeader*)message);
+        size_t count;
+        while ((count = capture_read((CaptureRecord*)(message + sizeof(CaptureHeader)), CAPTURE_MESSAGE_RECORDS)) > 0) {
+            size_t length = sizeof(CaptureHeader) + count * sizeof(CaptureRecord);
+            for (uint8_t num = 0; num < MAX_SUBSCRIBERS; num++) {
+                if (_subscribers[num].topics & TOPIC_CAPTURE) {
+                    _web_socket->sendBIN(num, message, length);
+                }
+            }
+        }
+    }
+#    endif
+
+    void Socket_Events::handle() {
+        if (!_web_socket || !_topics) {
+            _alarm = -1;
+            return;
+        }
+#    ifdef POSITION_CAPTURE
+        send_capture();
+#    endif
+        // Topics whose value changed since they were last sent
+        uint8_t changed = 0;
+        char    state[sizeof(_state)];
+        strncpy(state, report_state_text(), sizeof(state));
+        state[sizeof(state) - 1] = '\0';
+        if (strcmp(state, _state) != 0) {
+            strcpy(_state, state);
+            changed |= TOPIC_STATE;
+        }
+        int sd = -1;
+#    ifdef ENABLE_SD_CARD
+        if (get_sd_state(false) == SDState::BusyPrinting) {
+            sd = int(sd_report_perc_complete() * 10);
+        }
+#    endif
+        if (sd != _sd) {
+            _sd = sd;
+            changed |= TOPIC_SD;
+        }
+        Percent ov[3] = { sys.f_override, sys.r_override, sys.spindle_speed_ovr };
+        if (memcmp(ov, _override, sizeof(ov)) != 0) {
+            memcpy(_override, ov, sizeof(ov));
+            changed |= TOPIC_OVERRIDE;
+        }
+
+        char text[80];
+        int  alarm = _alarm;
+        if (alarm >= 0) {
+            _alarm = -1;
+            snprintf(text, sizeof(text), "ALARM:%d", alarm);
+            send(TOPIC_ALARM, text);
+        }
+        for (uint8_t num = 0; num < MAX_SUBSCRIBERS; num++) {
+            subscriber_t* s      = &_subscribers[num];
+            uint8_t       topics = s->topics & (s->snapshot ? 0xFF : changed);
+            if (topics & TOPIC_STATE) {
+                snprintf(text, sizeof(text), "STATE:%s", _state);
+                _web_socket->sendTXT(num, text);
+            }
+            if (topics & TOPIC_SD) {
+                if (_sd < 0) {
+                    _web_socket->sendTXT(num, "SD:");
+                } else {
+                    snprintf(text, sizeof(text), "SD:%d.%d", _sd / 10, _sd % 10);
+                    _web_socket->sendTXT(num, text);
+                }
+            }
+            if (topics & TOPIC_OVERRIDE) {
+                snprintf(text, sizeof(text), "OV:%d,%d,%d", _override[0], _override[1], _override[2]);
+                _web_socket->sendTXT(num, text);
+            }
+            s->snapshot = false;
+        }
+
+        if (!(_topics & TOPIC_POSITION)) {
+            return;
+        }
+        uint32_t now = millis();
+        float    position[MAX_N_AXIS];
+        bool     have_position = false;
+        for (uint8_t num = 0; num < MAX_SUBSCRIBERS; num++) {
+            subscriber_t* s = &_subscribers[num];
+            if (!(s->topics & TOPIC_POSITION) || int32_t(now - s->position_next) < 0) {
+                continue;
+            }
+            if (!have_position) {
+                system_read_mpos(position);
+                have_position = true;
+            }
+            s->position_next = now + s->position_ms;
+            if (memcmp(position, s->position, sizeof(position)) == 0) {
+                continue;
+            }
+            memcpy(s->position, position, sizeof(position));
+            char* end = report_append_axis_values(report_append(text, "POS:"), position);
+            *end      = '\0';
+            _web_socket->sendTXT(num, text);
+        }
+    }
+}
+
+#endif  // ENABLE_WIFI && ENABLE_HTTP && ENABLE_WEBSOCKET_EVENTS
@@ -0,0 +1,84 @@
+#pragma once
+
+/*
+  SocketEvents.h - Machine state events pushed over the WebUI WebSocket
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+class WebSocketsServer;
+
+namespace WebUI {
+    // A WebUI socket connection subscribes by sending a text message such as
+    //   SUBSCRIBE:state,alarm,pos=200,sd,ov
+    // and then gets the current value of each topic and a text message each time one changes:
+    //   STATE:Run            the state as in status reports
+    //   ALARM:9              an alarm as it is raised
+    //   POS:1.000,2.000,0.0  machine position in report units, at most every pos=ms (default
+    //                        DEFAULT_POSITION_MS, at least MIN_POSITION_MS) and only if moved
+    //   SD:12.5              percent through the running SD job, "SD:" when none runs
+    //   OV:100,100,100       feed, rapid and spindle overrides
+    //   capture              binary messages of position capture records while $Capture=socket
+    //                        runs, each a CaptureHeader and the records, see Capture.h
+    // "SUBSCRIBE:" alone ends the subscription. Any number of connections can subscribe.
+    class Socket_Events {
+        static const int      MAX_SUBSCRIBERS     = 5;  // WEBSOCKETS_SERVER_CLIENT_MAX
+        static const uint32_t MIN_POSITION_MS     = 50;
+        static const uint32_t DEFAULT_POSITION_MS = 250;
+
+    public:
+        Socket_Events();
+
+        void attachWS(WebSocketsServer* web_socket);
+        void detachWS();
+        bool subscribe(uint8_t num, const char* message);  // false if message is not a SUBSCRIBE
+        void disconnect(uint8_t num);
+        void alarm(ExecAlarm alarm_code);  // Called as the alarm is reported
+        void handle();                     // Called from the client task
+
+    private:
+        static const uint8_t TOPIC_STATE    = bit(0);
+        static const uint8_t TOPIC_ALARM    = bit(1);
+        static const uint8_t TOPIC_POSITION = bit(2);
+        static const uint8_t TOPIC_SD       = bit(3);
+        static const uint8_t TOPIC_OVERRIDE = bit(4);
+        static const uint8_t TOPIC_CAPTURE  = bit(5);
+
+        typedef struct {
+            uint8_t  topics;
+            bool     snapshot;  // Send every topic, not only the ones that changed
+            uint32_t position_ms;
+            uint32_t position_next;
+            float    position[MAX_N_AXIS];  // As last sent
+        } subscriber_t;
+
+        void send(uint8_t topic, const char* text);
+        void send_capture();
+
+        WebSocketsServer* _web_socket;
+        subscriber_t      _subscribers[MAX_SUBSCRIBERS];
+        uint8_t           _topics;  // Of all the subscribers
+
+        // As last sent
+        char    _state[10];
+        int     _sd;  // Tenths of a percent, -1 for no job
+        Percent _override[3];
+
+        volatile int _alarm;  // Raised and not yet sent, -1 for none
+    };
+
+    extern Socket_Events SocketEvents;
+}
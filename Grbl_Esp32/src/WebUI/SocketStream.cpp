@@ -0,0 +1,159 @@
+/*
+  SocketStream.cpp - G-code streaming over a WebSocket
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The socket library runs in the client task, so push(), read() and the grants all happen
+  there. Output can come from any task, so only the transmit buffer is locked; it is sent from
+  the client task, or by a writer that finds it full while running in that task.
+*/
+
+#include "../Grbl.h"
+
+#if defined(ENABLE_WIFI) && defined(ENABLE_HTTP) && defined(ENABLE_WEBSOCKET_STREAM)
+
+#    include "SocketStream.h"
+#    include <WebSocketsServer.h>
+
+namespace WebUI {
+    Socket_Stream SocketStream;
+
+    Socket_Stream::Socket_Stream() :
+        _web_socket(NULL), _num(-1), _flush_task(NULL), _RXbuffer(NULL), _RXbufferSize(0), _RXbufferpos(0), _credit(0),
+        _TXbufferSize(0), _TXmux(portMUX_INITIALIZER_UNLOCKED) {}
+
+    bool Socket_Stream::attachWS(WebSocketsServer* web_socket) {
+        if (_RXbuffer == NULL) {
+            _RXbuffer = (uint8_t*)heap_alloc_large(HeapTag::Web, RXBUFFERSIZE);
+        }
+        if (_RXbuffer == NULL) {
+            web_socket = NULL;  // Streaming is refused rather than the rest of the WebUI
+        }
+        _web_socket = web_socket;
+        _num        = -1;
+        return web_socket != NULL;
+    }
+
+    void Socket_Stream::detachWS() {
+        _num        = -1;
+        _web_socket = NULL;
+    }
+
+    bool Socket_Stream::connect(uint8_t num) {
+        if (_num >= 0 || !_web_socket) {
+            return false;
+        }
+        _RXbufferSize = 0;
+        _RXbufferpos  = 0;
+        _credit       = 0;
+        _TXbufferSize = 0;
+        _num          = num;
+        client_reset_read_buffer(CLIENT_WEBSOCKET);
+        char s[20];
+        snprintf(s, sizeof(s), "CREDIT:%d", RXBUFFERSIZE);
+        _web_socket->sendTXT(num, s);
+        report_init_message(CLIENT_WEBSOCKET);
+        return true;
+    }
+
+    void Socket_Stream::disconnect(uint8_t num) {
+        if (_num == num) {
+            _num          = -1;
+            _RXbufferSize = 0;
+        }
+    }
+
+    void Socket_Stream::push(const uint8_t* data, size_t length, bool text) {
+        size_t dropped = 0;
+        for (size_t i = 0; i < length; i++) {
+            uint8_t c = data[i];
+            // Text messages are UTF-8, so extended realtime commands only work in binary ones
+            if ((!text || c < 0x80) && !binary_motion_in_frame(CLIENT_WEBSOCKET, c) && is_realtime_command(c)) {
+                execute_realtime_command(static_cast<Cmd>(c), CLIENT_WEBSOCKET);
+                _credit++;
+            } else if (_RXbufferSize < RXBUFFERSIZE) {
+                _RXbuffer[(_RXbufferpos + _RXbufferSize++) % RXBUFFERSIZE] = c;
+            } else {
+                dropped++;  // Sent beyond its credit
+            }
+        }
+        if (dropped) {
+            char s[24];
+            snprintf(s, sizeof(s), "OVERFLOW:%u", (unsigned)dropped);
+            _web_socket->sendTXT(_num, s);
+        }
+    }
+
+    int Socket_Stream::read() {
+        if (_RXbufferSize == 0) {
+            return -1;
+        }
+        int c        = _RXbuffer[_RXbufferpos];
+        _RXbufferpos = (_RXbufferpos + 1) % RXBUFFERSIZE;
+        _RXbufferSize--;
+        _credit++;
+        return c;
+    }
+
+    size_t Socket_Stream::write(const uint8_t* buffer, size_t size) {
+        size_t done = 0;
+        while (done < size && _num >= 0) {
+            portENTER_CRITICAL(&_TXmux);
+            size_t count = MIN(size - done, size_t(TXBUFFERSIZE - _TXbufferSize));
+            memcpy(_TXbuffer + _TXbufferSize, buffer + done, count);
+            _TXbufferSize += count;
+            portEXIT_CRITICAL(&_TXmux);
+            done += count;
+            if (done < size) {
+                if (xTaskGetCurrentTaskHandle() == _flush_task) {
+                    flush();
+                } else {
+                    client_wake();
+                    vTaskDelay(1);  // Until the client task has sent it
+                }
+            }
+        }
+        client_wake();
+        return done;
+    }
+
+    void Socket_Stream::flush() {
+        uint8_t  out[TXBUFFERSIZE];
+        uint16_t length;
+        portENTER_CRITICAL(&_TXmux);
+        length = _TXbufferSize;
+        memcpy(out, _TXbuffer, length);
+        _TXbufferSize = 0;
+        portEXIT_CRITICAL(&_TXmux);
+        if (length && _num >= 0) {
+            _web_socket->sendBIN(_num, out, length);
+        }
+    }
+
+    void Socket_Stream::handle_flush() {
+        _flush_task = xTaskGetCurrentTaskHandle();
+        if (_num < 0) {
+            return;
+        }
+        if (_TXbufferSize) {
+            flush();  // Every pass, since responses are what the sender is waiting for
+        }
+        if (_credit >= CREDIT_STEP || (_credit && _RXbufferSize == 0)) {
+            char s[20];
+            snprintf(s, sizeof(s), "CREDIT:%u", (unsigned)_credit);
+            _web_socket->sendTXT(_num, s);
+            _credit = 0;
+        }
+    }
+}
+#endif
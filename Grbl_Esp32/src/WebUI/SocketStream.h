@@ -0,0 +1,71 @@
+#pragma once
+
+/*
+  SocketStream.h - G-code streaming over a WebSocket
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <cstddef>
+#include <cstdint>
+
+class WebSocketsServer;
+
+namespace WebUI {
+    // One WebSocket connection to /stream on the WebUI socket port is a client of its own,
+    // CLIENT_WEBSOCKET. It sends G-code in text or binary messages and gets Grbl's output, for
+    // it alone, in binary messages. Flow control is by credit: the sender may have at most as
+    // many bytes outstanding as it has been granted in "CREDIT:n" text messages, starting with
+    // the whole receive buffer. Credit comes back as the protocol loop takes the bytes, which
+    // it only does while there is room in the planner. Realtime commands are acted on when
+    // they arrive and credited at once.
+    class Socket_Stream {
+        static const int RXBUFFERSIZE = 4096;
+        static const int TXBUFFERSIZE = 1200;
+        static const int CREDIT_STEP  = RXBUFFERSIZE / 4;  // Smallest grant while bytes are buffered
+
+    public:
+        Socket_Stream();
+
+        bool   attachWS(WebSocketsServer* web_socket);
+        void   detachWS();
+        bool   connect(uint8_t num);  // false if another connection is streaming
+        void   disconnect(uint8_t num);
+        bool   connected(uint8_t num) const { return _num == num; }
+        void   push(const uint8_t* data, size_t length, bool text);
+        int    available() const { return _RXbufferSize; }
+        int    read();
+        size_t write(const uint8_t* buffer, size_t size);
+        void   handle_flush();  // Called from the client task
+
+    private:
+        void flush();
+
+        WebSocketsServer* _web_socket;
+        int               _num;  // The streaming connection, -1 for none
+        TaskHandle_t      _flush_task;
+
+        uint8_t* _RXbuffer;  // Allocated by the first attachWS(), after PSRAM is set up
+        uint16_t _RXbufferSize;
+        uint16_t _RXbufferpos;
+        uint32_t _credit;  // Bytes taken or acted on since the last grant
+
+        uint8_t      _TXbuffer[TXBUFFERSIZE];
+        uint16_t     _TXbufferSize;
+        portMUX_TYPE _TXmux;
+    };
+
+    extern Socket_Stream SocketStream;
+}
@@ -0,0 +1,299 @@
+/*
+  Ssdp.cpp - UPnP discovery, answered as the packets arrive
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The M-SEARCH packets come to ssdp_packet() in the async_udp task as lwIP receives them, so
+  nothing polls for them. The answer and the announcement are made once for each address
+  the device has and sent as they are. The searches that are not for the root device, or
+  that come too often, cost a look at the first line and the ST header and nothing more.
+*/
+
+#include "../Grbl.h"
+
+#if defined(ENABLE_WIFI) && defined(ENABLE_HTTP) && defined(ENABLE_SSDP)
+
+#    include "Ssdp.h"
+#    include <AsyncUDP.h>
+#    include <WiFi.h>
+#    include <esp_timer.h>
+#    ifdef ENABLE_ETHERNET
+#        include <ETH.h>
+#    endif
+
+namespace WebUI {
+    static const IPAddress SSDP_GROUP(239, 255, 255, 250);
+    static const uint16_t  SSDP_PORT        = 1900;
+    static const uint32_t  SSDP_MAX_AGE     = 1200;                      // s, CACHE-CONTROL of the announcements
+    static const uint64_t  SSDP_NOTIFY_US   = SSDP_MAX_AGE * 500000ULL;  // Announced again at half the age
+    static const int       SSDP_SEARCHERS   = 4;                         // Recent searchers kept for SSDP_REPEAT_MS
+    static const size_t    SSDP_PACKET_SIZE = 384;
+    static const char*     SSDP_ALIVE       = "NOTIFY * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nNTS: ssdp:alive\r\n";
+    static const char*     SSDP_BYEBYE      = "NOTIFY * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nNTS: ssdp:byebye\r\n";
+
+    typedef struct {
+        uint32_t ip;
+        uint16_t port;
+        uint32_t time;
+    } ssdp_searcher_t;
+
+    static AsyncUDP           ssdp_socket;         // Never deleted, as the async_udp task may still hold a packet for it
+    static AsyncUDP*          ssdp_udp = nullptr;  // &ssdp_socket while it is open
+    static esp_timer_handle_t ssdp_timer;
+    static SemaphoreHandle_t  ssdp_lock;  // The packets are made by the async_udp and esp_timer tasks
+    static char               ssdp_name[64];
+    static char               ssdp_uuid[37];
+    static char               ssdp_serial[12];
+    static uint16_t           ssdp_http_port;
+
+    // Made again when the address changes
+    static uint32_t ssdp_ip = 0;
+    static char     ssdp_response[SSDP_PACKET_SIZE];
+    static size_t   ssdp_response_len;
+    static char     ssdp_notify[SSDP_PACKET_SIZE];
+    static size_t   ssdp_notify_len;
+    static uint32_t ssdp_description_ip = 0;
+    static char     ssdp_description_xml[1024];
+
+    static int             ssdp_tokens;
+    static uint32_t        ssdp_refill_time;
+    static ssdp_searcher_t ssdp_searchers[SSDP_SEARCHERS];
+    static int             ssdp_searcher_next;
+    static uint32_t        ssdp_answered_count;
+    static uint32_t        ssdp_dropped_count;
+
+    static size_t ssdp_make(char* packet, const char* head, const char* type_header, const IPAddress& ip) {
+        int len = snprintf(packet,
+                           SSDP_PACKET_SIZE,
+                           "%s"
+                           "CACHE-CONTROL: max-age=%u\r\n"
+                           "SERVER: Arduino/1.0 UPNP/1.1 ESP32/Marlin\r\n"
+                           "USN: uuid:%s\r\n"
+                           "%s: upnp:rootdevice\r\n"
+                           "LOCATION: http://%s:%u/description.xml\r\n"
+                           "\r\n",
+                           head,
+                           SSDP_MAX_AGE,
+                           ssdp_uuid,
+                           type_header,
+                           ip.toString().c_str(),
+                           ssdp_http_port);
+        return len > 0 && len < SSDP_PACKET_SIZE ? len : 0;
+    }
+
+    // Call with ssdp_lock taken.
+    static void ssdp_make_packets(const IPAddress& ip) {
+        if (uint32_t(ip) == ssdp_ip) {
+            return;
+        }
+        ssdp_ip           = ip;
+        ssdp_response_len = ssdp_make(ssdp_response, "HTTP/1.1 200 OK\r\nEXT:\r\n", "ST", ip);
+        ssdp_notify_len   = ssdp_make(ssdp_notify, SSDP_ALIVE, "NT", ip);
+    }
+
+    // A token bucket, so a storm of searches from many hosts costs a few answers a second.
+    static bool ssdp_take_token(uint32_t now) {
+        uint32_t refills = (now - ssdp_refill_time) / SSDP_REFILL_MS;
+        if (refills) {
+            ssdp_tokens      = MIN(SSDP_BURST, ssdp_tokens + int(refills));
+            ssdp_refill_time = now;
+        }
+        if (ssdp_tokens == 0) {
+            return false;
+        }
+        ssdp_tokens--;
+        return true;
+    }
+
+    // Control points send each search two or three times. Answers the first.
+    static bool ssdp_repeated(uint32_t ip, uint16_t port, uint32_t now) {
+        for (auto& s : ssdp_searchers) {
+            if (s.ip == ip && s.port == port && now - s.time < SSDP_REPEAT_MS) {
+                return true;
+            }
+        }
+        ssdp_searchers[ssdp_searcher_next] = { ip, port, now };
+        ssdp_searcher_next                 = (ssdp_searcher_next + 1) % SSDP_SEARCHERS;
+        return false;
+    }
+
+    // The value of header in the packet, trimmed, or NULL.
+    static const char* ssdp_header(char* packet, const char* header, size_t* len) {
+        size_t header_len = strlen(header);
+        for (char* line = strstr(packet, "\r\n"); line; line = strstr(line, "\r\n")) {
+            line += 2;
+            if (strncasecmp(line, header, header_len) == 0 && line[header_len] == ':') {
+                char* value = line + header_len + 1;
+                while (*value == ' ') {
+                    value++;
+                }
+                char* end = strstr(value, "\r\n");
+                *len      = end ? end - value : strlen(value);
+                return value;
+            }
+        }
+        return NULL;
+    }
+
+    static bool ssdp_wanted(const char* st, size_t len) {
+        return (len == 8 && strncasecmp(st, "ssdp:all", 8) == 0) || (len == 15 && strncasecmp(st, "upnp:rootdevice", 15) == 0) ||
+               (len == 5 + strlen(ssdp_uuid) && strncasecmp(st, "uuid:", 5) == 0 && strncasecmp(st + 5, ssdp_uuid, len - 5) == 0);
+    }
+
+    static void ssdp_packet(AsyncUDPPacket& packet) {
+        static const char search[] = "M-SEARCH * HTTP/1.1\r\n";
+        if (packet.length() < sizeof(search) - 1 || memcmp(packet.data(), search, sizeof(search) - 1) != 0) {
+            return;  // NOTIFY from the other devices, mostly
+        }
+        char   text[512];
+        size_t length = MIN(packet.length(), sizeof(text) - 1);
+        memcpy(text, packet.data(), length);
+        text[length] = '\0';
+        size_t      st_len;
+        const char* st = ssdp_header(text, "ST", &st_len);
+        if (!st || !ssdp_wanted(st, st_len)) {
+            return;
+        }
+        uint32_t now = millis();
+        if (ssdp_repeated(packet.remoteIP(), packet.remotePort(), now) || !ssdp_take_token(now)) {
+            ssdp_dropped_count++;
+            return;
+        }
+        xSemaphoreTake(ssdp_lock, portMAX_DELAY);
+        ssdp_make_packets(packet.localIP());
+        if (ssdp_udp && ssdp_response_len) {
+            // MX allows a random delay, which only matters to many devices answering a
+            // multicast search at once. The rate limit already bounds this one.
+            ssdp_udp->writeTo((const uint8_t*)ssdp_response, ssdp_response_len, packet.remoteIP(), packet.remotePort());
+            ssdp_answered_count++;
+        }
+        xSemaphoreGive(ssdp_lock);
+    }
+
+    // The address the web server is reached at, as handle_SSDP() has it.
+    static IPAddress ssdp_local_ip() {
+#    ifdef ENABLE_ETHERNET
+        if (WiFi.getMode() != WIFI_STA && WiFiConfig::Is_Ethernet_on()) {
+            return ETH.localIP();
+        }
+#    endif
+        return WiFi.localIP();
+    }
+
+    static void ssdp_announce(void* arg) {
+        xSemaphoreTake(ssdp_lock, portMAX_DELAY);
+        if (ssdp_udp) {
+            ssdp_make_packets(ssdp_local_ip());
+            if (ssdp_notify_len) {
+                ssdp_udp->writeTo((const uint8_t*)ssdp_notify, ssdp_notify_len, SSDP_GROUP, SSDP_PORT);
+            }
+        }
+        xSemaphoreGive(ssdp_lock);
+    }
+
+    bool ssdp_begin(const char* name, uint16_t port) {
+        ssdp_end();
+        if (!ssdp_lock) {
+            ssdp_lock = xSemaphoreCreateMutex();
+
+            esp_timer_create_args_t announcer = {};
+            announcer.callback                = ssdp_announce;
+            announcer.name                    = "ssdp";
+            esp_timer_create(&announcer, &ssdp_timer);
+        }
+        uint32_t chipId = (uint16_t)(ESP.getEfuseMac() >> 32);
+        snprintf(ssdp_uuid,
+                 sizeof(ssdp_uuid),
+                 "38323636-4558-4dda-9188-cda0e6%02x%02x%02x",
+                 (uint16_t)((chipId >> 16) & 0xff),
+                 (uint16_t)((chipId >> 8) & 0xff),
+                 (uint16_t)chipId & 0xff);
+        snprintf(ssdp_serial, sizeof(ssdp_serial), "%u", chipId);
+        strlcpy(ssdp_name, name, sizeof(ssdp_name));
+        ssdp_http_port      = port;
+        ssdp_ip             = 0;
+        ssdp_description_ip = 0;
+        ssdp_tokens         = SSDP_BURST;
+        ssdp_refill_time    = millis();
+        ssdp_answered_count = 0;
+        ssdp_dropped_count  = 0;
+        memset(ssdp_searchers, 0, sizeof(ssdp_searchers));
+
+        if (!ssdp_socket.listenMulticast(SSDP_GROUP, SSDP_PORT)) {
+            return false;
+        }
+        ssdp_socket.onPacket(ssdp_packet);
+        xSemaphoreTake(ssdp_lock, portMAX_DELAY);
+        ssdp_udp = &ssdp_socket;
+        xSemaphoreGive(ssdp_lock);
+        ssdp_announce(NULL);
+        esp_timer_start_periodic(ssdp_timer, SSDP_NOTIFY_US);
+        return true;
+    }
+
+    void ssdp_end() {
+        if (!ssdp_udp) {
+            return;
+        }
+        esp_timer_stop(ssdp_timer);
+        xSemaphoreTake(ssdp_lock, portMAX_DELAY);
+        if (ssdp_notify_len) {
+            char byebye[SSDP_PACKET_SIZE];
+            int  len = snprintf(byebye, sizeof(byebye), "%sUSN: uuid:%s\r\nNT: upnp:rootdevice\r\n\r\n", SSDP_BYEBYE, ssdp_uuid);
+            ssdp_udp->writeTo((const uint8_t*)byebye, len, SSDP_GROUP, SSDP_PORT);
+        }
+        ssdp_udp = nullptr;
+        xSemaphoreGive(ssdp_lock);
+        ssdp_socket.close();
+    }
+
+    const char* ssdp_description(const IPAddress& ip) {
+        if (uint32_t(ip) != ssdp_description_ip) {
+            snprintf(ssdp_description_xml,
+                     sizeof(ssdp_description_xml),
+                     "<?xml version=\"1.0\"?>"
+                     "<root xmlns=\"urn:schemas-upnp-org:device-1-0\">"
+                     "<specVersion>"
+                     "<major>1</major>"
+                     "<minor>0</minor>"
+                     "</specVersion>"
+                     "<URLBase>http://%s:%u/</URLBase>"
+                     "<device>"
+                     "<deviceType>upnp:rootdevice</deviceType>"
+                     "<friendlyName>%s</friendlyName>"
+                     "<presentationURL>/</presentationURL>"
+                     "<serialNumber>%s</serialNumber>"
+                     "<modelName>ESP32</modelName>"
+                     "<modelNumber>Marlin</modelNumber>"
+                     "<modelURL>http://espressif.com/en/products/hardware/esp-wroom-32/overview</modelURL>"
+                     "<manufacturer>Espressif Systems</manufacturer>"
+                     "<manufacturerURL>http://espressif.com</manufacturerURL>"
+                     "<UDN>uuid:%s</UDN>"
+                     "</device>"
+                     "</root>\r\n"
+                     "\r\n",
+                     ip.toString().c_str(),
+                     ssdp_http_port,
+                     ssdp_name,
+                     ssdp_serial,
+                     ssdp_uuid);
+            ssdp_description_ip = ip;
+        }
+        return ssdp_description_xml;
+    }
+
+    uint32_t ssdp_answered() { return ssdp_answered_count; }
+    uint32_t ssdp_dropped() { return ssdp_dropped_count; }
+}
+
+#endif
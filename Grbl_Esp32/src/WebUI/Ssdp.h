@@ -0,0 +1,43 @@
+#pragma once
+
+/*
+  Ssdp.h - UPnP discovery, answered as the packets arrive
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdint>
+
+class IPAddress;
+
+namespace WebUI {
+    // At most SSDP_BURST answers at once, and one more every SSDP_REFILL_MS after that. A
+    // searcher that repeats its M-SEARCH within SSDP_REPEAT_MS is answered once.
+    const int      SSDP_BURST     = 4;
+    const uint32_t SSDP_REFILL_MS = 250;
+    const uint32_t SSDP_REPEAT_MS = 1000;
+
+    // Joins the SSDP group and announces the device, whose description is served on port at
+    // /description.xml. Returns false if the socket cannot be opened.
+    bool ssdp_begin(const char* name, uint16_t port);
+
+    // Says goodbye and leaves the group.
+    void ssdp_end();
+
+    // The description for a device at ip, made once for each address.
+    const char* ssdp_description(const IPAddress& ip);
+
+    // Searches answered, and those dropped by the rate limit, since ssdp_begin().
+    uint32_t ssdp_answered();
+    uint32_t ssdp_dropped();
+}
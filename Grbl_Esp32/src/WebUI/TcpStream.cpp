@@ -0,0 +1,161 @@
+/*
+  TcpStream.cpp - G-code streaming over a plain TCP socket
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The task owns the listener and the connection and is the only writer of the CLIENT_TCP line
+  buffer, as serialRxTask is for the serial port. Output can come from any task, so writers
+  take _TXlock, and the task takes it too before it lets go of the connection. Nagle is left
+  on: lwIP then sends the first ok at once and merges the ones that follow while it is
+  waiting for the ack.
+*/
+
+#include "../Grbl.h"
+
+#if defined(ENABLE_WIFI) && defined(ENABLE_TCP_STREAM)
+
+#    include "TcpStream.h"
+#    include <lwip/api.h>
+
+namespace WebUI {
+    Tcp_Stream TcpStream;
+
+    Tcp_Stream::Tcp_Stream() : _task(NULL), _TXlock(NULL), _enabled(false), _listener(NULL), _conn(NULL), _held(0) {}
+
+    bool Tcp_Stream::begin() {
+        if (_TXlock == NULL) {
+            _TXlock = xSemaphoreCreateMutex();
+        }
+        _enabled = true;
+        if (_task == NULL) {
+            heap_task_create(task,                     // task
+                             "tcpStreamTask",          // name for task
+                             STACK_SIZE,               // size of task stack
+                             this,                     // parameters
+                             SERIAL_RX_TASK_PRIORITY,  // priority
+                             &_task,                   // handle
+                             SUPPORT_TASK_CORE         // core
+            );
+        }
+        grbl_sendf(CLIENT_ALL, "[MSG:TCP stream Started %d]\r\n", TCP_STREAM_PORT);
+        return _task != NULL;
+    }
+
+    // The task closes the listener and any connection within a timeout of this.
+    void Tcp_Stream::end() { _enabled = false; }
+
+    void Tcp_Stream::task(void* pvParameters) {
+        Tcp_Stream* stream = static_cast<Tcp_Stream*>(pvParameters);
+        while (true) {
+            if (!stream->_enabled) {
+                if (stream->_listener) {
+                    netconn_close(stream->_listener);
+                    netconn_delete(stream->_listener);
+                    stream->_listener = NULL;
+                }
+                vTaskDelay(pdMS_TO_TICKS(ACCEPT_TIMEOUT_MS));
+                continue;
+            }
+            if (stream->_listener == NULL) {
+                struct netconn* listener = netconn_new(NETCONN_TCP);
+                if (listener == NULL || netconn_bind(listener, IP_ADDR_ANY, TCP_STREAM_PORT) != ERR_OK ||
+                    netconn_listen(listener) != ERR_OK) {
+                    if (listener) {
+                        netconn_delete(listener);
+                    }
+                    grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Error, "TCP stream cannot listen on port %d", TCP_STREAM_PORT);
+                    stream->_enabled = false;
+                    continue;
+                }
+                netconn_set_recvtimeout(listener, ACCEPT_TIMEOUT_MS);
+                stream->_listener = listener;
+            }
+            // One connection at a time. Others wait in the listen backlog until it closes.
+            struct netconn* conn;
+            if (netconn_accept(stream->_listener, &conn) == ERR_OK) {
+                stream->serve(conn);
+            }
+        }
+    }
+
+    void Tcp_Stream::serve(struct netconn* conn) {
+        netconn_set_recvtimeout(conn, RECV_TIMEOUT_MS);
+        netconn_set_sendtimeout(conn, SEND_TIMEOUT_MS);
+        client_reset_read_buffer(CLIENT_TCP);
+        xSemaphoreTake(_TXlock, portMAX_DELAY);
+        _conn = conn;
+        xSemaphoreGive(_TXlock);
+        report_init_message(CLIENT_TCP);
+
+        struct netbuf* buf;
+        err_t          err;
+        while (_enabled && ((err = netconn_recv(conn, &buf)) == ERR_OK || err == ERR_TIMEOUT)) {
+            if (err == ERR_OK) {
+                bool open = take(buf);
+                netbuf_delete(buf);
+                if (!open) {
+                    break;
+                }
+            }
+        }
+
+        xSemaphoreTake(_TXlock, portMAX_DELAY);
+        _conn = NULL;
+        xSemaphoreGive(_TXlock);
+        _held = 0;
+        netconn_close(conn);
+        netconn_delete(conn);
+    }
+
+    // Hands one receive buffer to Grbl, a segment at a time, reading the pbufs in place. The
+    // realtime commands in a segment are acted on before waiting for room for the rest of it.
+    // Returns false if the stream was ended while waiting.
+    bool Tcp_Stream::take(struct netbuf* buf) {
+        netbuf_first(buf);
+        do {
+            void* data;
+            u16_t length;
+            netbuf_data(buf, &data, &length);
+            uint8_t* bytes = static_cast<uint8_t*>(data);
+            size_t   left  = client_pick_realtime(CLIENT_TCP, bytes, length);
+            while (left) {
+                size_t taken = client_store_bytes(CLIENT_TCP, bytes, left);
+                bytes += taken;
+                left -= taken;
+                _held = left;
+                if (left) {
+                    if (!_enabled) {
+                        return false;
+                    }
+                    vTaskDelay(1);  // Wait for the protocol loop to make room
+                }
+            }
+        } while (netbuf_next(buf) >= 0);
+        return true;
+    }
+
+    size_t Tcp_Stream::write(const uint8_t* buffer, size_t size) {
+        if (_conn == NULL || _TXlock == NULL) {
+            return 0;
+        }
+        size_t written = 0;
+        xSemaphoreTake(_TXlock, portMAX_DELAY);
+        if (_conn != NULL) {
+            netconn_write_partly(_conn, buffer, size, NETCONN_COPY, &written);
+        }
+        xSemaphoreGive(_TXlock);
+        return written;
+    }
+}
+
+#endif  // ENABLE_WIFI && ENABLE_TCP_STREAM
@@ -0,0 +1,63 @@
+#pragma once
+
+/*
+  TcpStream.h - G-code streaming over a plain TCP socket
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <cstddef>
+#include <cstdint>
+
+struct netconn;
+struct netbuf;
+
+namespace WebUI {
+    // One connection to TCP_STREAM_PORT is a client of its own, CLIENT_TCP, that behaves like
+    // the serial port: no telnet negotiation, bytes in and Grbl's output out. Its task reads
+    // the lwIP receive buffers in place. Realtime commands are acted on as each buffer arrives
+    // and the rest goes straight to the line buffer; what does not fit stays in lwIP, so
+    // a sender that outruns the protocol loop is held back by the TCP window, not dropped.
+    class Tcp_Stream {
+        static const int      ACCEPT_TIMEOUT_MS = 100;  // How often the idle task looks at _enabled
+        static const int      RECV_TIMEOUT_MS   = 100;
+        static const int      SEND_TIMEOUT_MS   = 100;  // A writer gives up on a peer that stopped reading
+        static const uint32_t STACK_SIZE        = 4096;
+
+    public:
+        Tcp_Stream();
+
+        bool   begin();
+        void   end();
+        bool   hasClient() const { return _conn != NULL; }
+        int    available() const { return _held; }  // Bytes waiting for room in the line buffer
+        size_t write(const uint8_t* buffer, size_t size);
+
+    private:
+        static void task(void* pvParameters);
+        void        serve(struct netconn* conn);
+        bool        take(struct netbuf* buf);
+
+        TaskHandle_t             _task;
+        SemaphoreHandle_t        _TXlock;
+        volatile bool            _enabled;
+        struct netconn*          _listener;  // Owned by the task
+        struct netconn* volatile _conn;      // Set by the task, used by writers under _TXlock
+        volatile size_t          _held;
+    };
+
+    extern Tcp_Stream TcpStream;
+}
@@ -42,6 +42,12 @@ namespace WebUI {
     Telnet_Server::Telnet_Server() {
         _RXbufferSize = 0;
         _RXbufferpos  = 0;
+        _TXlock       = NULL;
+        _RXbuffer     = NULL;
+        for (uint8_t i = 0; i < MAX_TLNT_CLIENTS; i++) {
+            _TXbuffer[i]     = NULL;
+            _TXbufferSize[i] = 0;
+        }
     }
 
     bool Telnet_Server::begin() {
@@ -54,6 +60,23 @@ namespace WebUI {
             return false;
         }
         _port = telnet_port->get();
+        if (_TXlock == NULL) {
+            _TXlock = xSemaphoreCreateMutex();
+        }
+        if (_RXbuffer == NULL) {
+            _RXbuffer = (uint8_t*)heap_alloc_large(HeapTag::Web, TELNETRXBUFFERSIZE);
+        }
+        for (uint8_t i = 0; i < MAX_TLNT_CLIENTS; i++) {
+            if (_TXbuffer[i] == NULL) {
+                _TXbuffer[i] = (uint8_t*)heap_alloc_large(HeapTag::Web, TELNETTXBUFFERSIZE);
+            }
+            if (_TXbuffer[i] == NULL) {
+                return false;
+            }
+        }
+        if (_RXbuffer == NULL) {
+            return false;
+        }
 
         //create instance
         _telnetserver = new WiFiServer(_port, MAX_TLNT_CLIENTS);
@@ -89,6 +112,7 @@ namespace WebUI {
                     if (_telnetClients[i]) {
                         _telnetClients[i].stop();
                     }
+                    _TXbufferSize[i]  = 0;
                     _telnetClients[i] = _telnetserver->available();
                     break;
                 }
@@ -111,16 +135,48 @@ namespace WebUI {
 
         //log_d("[TELNET out]");
         //push UART data to all connected telnet clients
+        xSemaphoreTake(_TXlock, portMAX_DELAY);
         for (uint8_t i = 0; i < MAX_TLNT_CLIENTS; i++) {
             if (_telnetClients[i] && _telnetClients[i].connected()) {
                 //log_d("[TELNET out connected]");
-                wsize = _telnetClients[i].write(buffer, size);
-                COMMANDS::wait(0);
+                for (size_t done = 0; done < size;) {
+                    if (_TXbufferSize[i] == TELNETTXBUFFERSIZE) {
+                        flush(i);
+                    }
+                    if (_TXbufferSize[i] == 0) {
+                        _TXfirst[i] = millis();
+                    }
+                    size_t count = MIN(size - done, size_t(TELNETTXBUFFERSIZE - _TXbufferSize[i]));
+                    memcpy(_TXbuffer[i] + _TXbufferSize[i], buffer + done, count);
+                    _TXbufferSize[i] += count;
+                    done += count;
+                }
+                wsize = size;
             }
         }
+        xSemaphoreGive(_TXlock);
         return wsize;
     }
 
+    void Telnet_Server::flush(uint8_t i) {
+        if (_TXbufferSize[i]) {
+            _telnetClients[i].write(_TXbuffer[i], _TXbufferSize[i]);
+            _TXbufferSize[i] = 0;
+        }
+    }
+
+    bool Telnet_Server::hasClient() {
+        if (!_setupdone || _telnetserver == NULL) {
+            return false;
+        }
+        for (uint8_t i = 0; i < MAX_TLNT_CLIENTS; i++) {
+            if (_telnetClients[i] && _telnetClients[i].connected()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     void Telnet_Server::handle() {
         COMMANDS::wait(0);
         //check if can read
@@ -128,6 +184,13 @@ namespace WebUI {
             return;
         }
         clearClients();
+        xSemaphoreTake(_TXlock, portMAX_DELAY);
+        for (uint8_t i = 0; i < MAX_TLNT_CLIENTS; i++) {
+            if (_TXbufferSize[i] && (millis() - _TXfirst[i] >= TXFLUSHMS || _TXbufferSize[i] == TELNETTXBUFFERSIZE)) {
+                flush(i);
+            }
+        }
+        xSemaphoreGive(_TXlock);
         //check clients for data
         //uint8_t c;
         for (uint8_t i = 0; i < MAX_TLNT_CLIENTS; i++) {
@@ -162,6 +225,7 @@ namespace WebUI {
 #    endif
                     _telnetClients[i].stop();
                 }
+                _TXbufferSize[i] = 0;
             }
             COMMANDS::wait(0);
         }
@@ -199,24 +263,12 @@ namespace WebUI {
 
     bool Telnet_Server::push(const uint8_t* data, int data_size) {
         if ((data_size + _RXbufferSize) <= TELNETRXBUFFERSIZE) {
-            int data_processed = 0;
-            int current        = _RXbufferpos + _RXbufferSize;
-            if (current > TELNETRXBUFFERSIZE) {
-                current = current - TELNETRXBUFFERSIZE;
-            }
-            for (int i = 0; i < data_size; i++) {
-                if (current > (TELNETRXBUFFERSIZE - 1)) {
-                    current = 0;
-                }
-
-                _RXbuffer[current] = data[i];
-                current++;
-                data_processed++;
-
-                COMMANDS::wait(0);
-                //vTaskDelay(1 / portTICK_RATE_MS);  // Yield to other tasks
-            }
-            _RXbufferSize += data_processed;
+            // Copied in at most two runs, around the end of the ring
+            int current = (_RXbufferpos + _RXbufferSize) % TELNETRXBUFFERSIZE;
+            int first   = MIN(data_size, TELNETRXBUFFERSIZE - current);
+            memcpy(_RXbuffer + current, data, first);
+            memcpy(_RXbuffer, data + first, data_size - first);
+            _RXbufferSize += data_size;
             return true;
         }
         return false;
@@ -21,6 +21,8 @@
 */
 
 #include "../Config.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 class WiFiServer;
 class WiFiClient;
@@ -31,7 +33,12 @@ namespace WebUI {
         static const int MAX_TLNT_CLIENTS = 1;
 
         static const int TELNETRXBUFFERSIZE = 1200;
-        static const int FLUSHTIMEOUT       = 500;
+
+        // Output is gathered per connection and sent when a segment's worth is waiting or
+        // TXFLUSHMS after the first byte, instead of one TCP write per ok. The sockets have
+        // Nagle off, so this is the only coalescing there is.
+        static const int      TELNETTXBUFFERSIZE = 1460;
+        static const uint32_t TXFLUSHMS          = 2;
 
     public:
         Telnet_Server();
@@ -44,6 +51,7 @@ namespace WebUI {
         int    peek(void);
         int    available();
         int    get_rx_buffer_available();
+        bool   hasClient();
         bool   push(uint8_t data);
         bool   push(const uint8_t* data, int datasize);
 
@@ -61,11 +69,18 @@ namespace WebUI {
         static uint16_t _port;
 
         void clearClients();
+        void flush(uint8_t i);  // Call with _TXlock held
 
-        uint32_t _lastflush;
-        uint8_t  _RXbuffer[TELNETRXBUFFERSIZE];
+        // All connections are the one CLIENT_TELNET, so they share the receive buffer. The
+        // buffers are allocated by the first begin(), after PSRAM is set up, and kept.
+        uint8_t* _RXbuffer;
         uint16_t _RXbufferSize;
         uint16_t _RXbufferpos;
+
+        uint8_t*          _TXbuffer[MAX_TLNT_CLIENTS];
+        uint16_t          _TXbufferSize[MAX_TLNT_CLIENTS];
+        uint32_t          _TXfirst[MAX_TLNT_CLIENTS];  // millis() of the oldest byte not sent
+        SemaphoreHandle_t _TXlock;
     };
 
     extern Telnet_Server telnet_server;
@@ -27,24 +27,29 @@
 #    include "ESPResponse.h"
 #    include "Serial2Socket.h"
 #    include "WebServer.h"
+#    include "OtaUpdate.h"
+#    include "FlashAssets.h"
 #    include <WebSocketsServer.h>
 #    include <WiFi.h>
 #    include <FS.h>
-#    include <SPIFFS.h>
+#    include "../LocalFS.h"
 #    ifdef ENABLE_SD_CARD
 #        include <SD.h>
 #        include "../SDCard.h"
 #    endif
 #    include <WebServer.h>
-#    include <ESP32SSDP.h>
 #    include <StreamString.h>
 #    include <Update.h>
 #    include <esp_wifi_types.h>
+#    include <rom/crc.h>
 #    ifdef ENABLE_MDNS
 #        include <ESPmDNS.h>
 #    endif
 #    ifdef ENABLE_SSDP
-#        include <ESP32SSDP.h>
+#        include "Ssdp.h"
+#    endif
+#    ifdef ENABLE_ETHERNET
+#        include <ETH.h>
 #    endif
 #    ifdef ENABLE_CAPTIVE_PORTAL
 #        include <DNSServer.h>
@@ -92,9 +97,7 @@ namespace WebUI {
     WebServer*        Web_Server::_webserver     = NULL;
     WebSocketsServer* Web_Server::_socket_server = NULL;
 #    ifdef ENABLE_AUTHENTICATION
-    AuthenticationIP* Web_Server::_head  = NULL;
-    uint8_t           Web_Server::_nb_ip = 0;
-    const int         MAX_AUTH_IP        = 10;
+    AuthenticationIP Web_Server::_sessions[MAX_AUTH_IP];
 #    endif
     Web_Server::Web_Server() {}
     Web_Server::~Web_Server() { end(); }
@@ -111,19 +114,28 @@ namespace WebUI {
 
         //create instance
         _webserver = new WebServer(_port);
-#    ifdef ENABLE_AUTHENTICATION
         //here the list of headers to be recorded
-        const char* headerkeys[]   = { "Cookie" };
-        size_t      headerkeyssize = sizeof(headerkeys) / sizeof(char*);
+        const char* headerkeys[] = {
+            "If-None-Match",
+#    ifdef ENABLE_AUTHENTICATION
+            "Cookie",
+#    endif
+        };
+        size_t headerkeyssize = sizeof(headerkeys) / sizeof(char*);
         //ask server to track these headers
         _webserver->collectHeaders(headerkeys, headerkeyssize);
-#    endif
         _socket_server = new WebSocketsServer(_port + 1);
         _socket_server->begin();
         _socket_server->onEvent(handle_Websocket_Event);
 
         //Websocket output
         Serial2Socket.attachWS(_socket_server);
+#    ifdef ENABLE_WEBSOCKET_STREAM
+        SocketStream.attachWS(_socket_server);
+#    endif
+#    ifdef ENABLE_WEBSOCKET_EVENTS
+        SocketEvents.attachWS(_socket_server);
+#    endif
 
         //events functions
         //_web_events->onConnect(handle_onevent_connect);
@@ -148,6 +160,7 @@ namespace WebUI {
         //web commands
         _webserver->on("/command", HTTP_ANY, handle_web_command);
         _webserver->on("/command_silent", HTTP_ANY, handle_web_command_silent);
+        _webserver->on("/commands", HTTP_ANY, handle_web_commands);
 
         //SPIFFS
         _webserver->on("/files", HTTP_ANY, handleFileList, SPIFFSFileupload);
@@ -176,33 +189,24 @@ namespace WebUI {
 
 #    ifdef ENABLE_SSDP
         //SSDP service presentation
-        if (WiFi.getMode() == WIFI_STA) {
+        if (WiFi.getMode() == WIFI_STA || WiFiConfig::Is_Ethernet_on()) {
             _webserver->on("/description.xml", HTTP_GET, handle_SSDP);
-            //Add specific for SSDP
-            SSDP.setSchemaURL("description.xml");
-            SSDP.setHTTPPort(_port);
-            SSDP.setName(wifi_config.Hostname());
-            SSDP.setURL("/");
-            SSDP.setDeviceType("upnp:rootdevice");
-            /*Any customization could be here
-        SSDP.setModelName (ESP32_MODEL_NAME);
-        SSDP.setModelURL (ESP32_MODEL_URL);
-        SSDP.setModelNumber (ESP_MODEL_NUMBER);
-        SSDP.setManufacturer (ESP_MANUFACTURER_NAME);
-        SSDP.setManufacturerURL (ESP_MANUFACTURER_URL);
-        */
-
-            //Start SSDP
-            grbl_send(CLIENT_ALL, "[MSG:SSDP Started]\r\n");
-            SSDP.begin();
+            //Start SSDP, answered from the async_udp task, see Ssdp.h
+            if (ssdp_begin(wifi_config.Hostname().c_str(), _port)) {
+                grbl_send(CLIENT_ALL, "[MSG:SSDP Started]\r\n");
+            }
         }
 #    endif
         grbl_send(CLIENT_ALL, "[MSG:HTTP Started]\r\n");
+        uint16_t assets = flash_assets_begin();
+        if (assets) {
+            grbl_sendf(CLIENT_ALL, "[MSG:WebUI %d files in flash]\r\n", assets);
+        }
         //start webserver
         _webserver->begin();
 #    ifdef ENABLE_MDNS
         //add mDNS
-        if (WiFi.getMode() == WIFI_STA) {
+        if (WiFi.getMode() == WIFI_STA || WiFiConfig::Is_Ethernet_on()) {
             MDNS.addService("http", "tcp", _port);
         }
 #    endif
@@ -212,14 +216,21 @@ namespace WebUI {
 
     void Web_Server::end() {
         _setupdone = false;
+        end_transfers();
 #    ifdef ENABLE_SSDP
-        SSDP.end();
+        ssdp_end();
 #    endif  //ENABLE_SSDP
 #    ifdef ENABLE_MDNS
         //remove mDNS
         mdns_service_remove("_http", "_tcp");
 #    endif
         if (_socket_server) {
+#    ifdef ENABLE_WEBSOCKET_STREAM
+            SocketStream.detachWS();
+#    endif
+#    ifdef ENABLE_WEBSOCKET_EVENTS
+            SocketEvents.detachWS();
+#    endif
             delete _socket_server;
             _socket_server = NULL;
         }
@@ -230,35 +241,150 @@ namespace WebUI {
         }
 
 #    ifdef ENABLE_AUTHENTICATION
-        while (_head) {
-            AuthenticationIP* current = _head;
-            _head                     = _head->_next;
-            delete current;
+        for (int i = 0; i < MAX_AUTH_IP; i++) {
+            _sessions[i].level = AuthenticationLevel::LEVEL_GUEST;
+        }
+#    endif
+    }
+
+    //Static files////////////////////////////////////////////////////////////
+
+    // Downloads are sent from handle() a buffer at a time, for up to TRANSFER_SLICE_MS per pass,
+    // so other requests are served while they run. The buffer is shared by all of them.
+    static const int      TRANSFERS         = 2;
+    static const uint32_t TRANSFER_SLICE_MS = 5;
+    static const int      ETAG_CACHE        = 8;
+    static uint8_t        send_buf[4096];
+
+    // SPIFFS keeps no modification times, so its files are tagged by a CRC of their contents,
+    // worked out once and kept here until a SPIFFS upload or delete.
+    typedef struct {
+        String   path;
+        size_t   size;
+        uint32_t crc;
+    } etag_crc_t;
+    static etag_crc_t etag_crcs[ETAG_CACHE];
+    static int        etag_next = 0;
+
+    static void etag_clear() {
+        for (auto& e : etag_crcs) {
+            e.path = "";
+        }
+    }
+
+    static String etag_for(File& file, const String& path) {
+        time_t written = file.getLastWrite();
+        if (written) {
+            return "\"" + String(file.size(), HEX) + "-" + String(uint32_t(written), HEX) + "\"";
+        }
+        for (auto& e : etag_crcs) {
+            if (e.path == path && e.size == file.size()) {
+                return "\"" + String(e.crc, HEX) + "\"";
+            }
+        }
+        uint32_t crc = 0;
+        size_t   length;
+        while ((length = file.read(send_buf, sizeof(send_buf))) > 0) {
+            crc = crc32_le(crc, send_buf, length);
+        }
+        file.seek(0);
+        etag_crc_t& e = etag_crcs[etag_next];
+        etag_next     = (etag_next + 1) % ETAG_CACHE;
+        e             = { path, file.size(), crc };
+        return "\"" + String(crc, HEX) + "\"";
+    }
+
+    // Answers 304 if the browser's copy has etag. Either way the response carries etag, and
+    // no-cache, so the browser asks again each time instead of guessing how long it is good for.
+    bool Web_Server::not_modified(const String& etag) {
+        _webserver->sendHeader("ETag", etag);
+        _webserver->sendHeader("Cache-Control", "no-cache");
+        if (_webserver->header("If-None-Match") == etag) {
+            _webserver->send(304);
+            return true;
+        }
+        return false;
+    }
+
+    // Sends path, or path.gz with Content-Encoding: gzip if there is one, as the browser takes
+    // it either way. Large bodies are sent in the background, see handle_transfers(). Returns
+    // false if the file cannot be opened. For the card, sd is true and the card is set idle
+    // once the file has been sent.
+    bool Web_Server::send_file(fs::FS& fs, String path, bool sd) {
+        String contentType = getContentType(path);
+        bool   gzipped     = fs.exists(path + ".gz");
+        if (gzipped) {
+            path += ".gz";
+        }
+        File file = fs.open(path, FILE_READ);
+        if (!file) {
+            return false;
+        }
+        if (not_modified(etag_for(file, path))) {
+            file.close();
+#    ifdef ENABLE_SD_CARD
+            if (sd) {
+                set_sd_state(SDState::Idle);
+            }
+#    endif
+            return true;
+        }
+        if (gzipped) {
+            _webserver->sendHeader("Content-Encoding", "gzip");
         }
-        _nb_ip = 0;
+        _webserver->setContentLength(file.size());
+        _webserver->send(200, contentType, "");
+        if (!start_transfer(file, sd)) {
+            _webserver->client().write(file);  // Both slots are busy
+            file.close();
+#    ifdef ENABLE_SD_CARD
+            if (sd) {
+                set_sd_state(SDState::Idle);
+            }
 #    endif
+        }
+        return true;
+    }
+
+    // Sends path from the asset partition, if it has it, straight out of the mapped flash.
+    bool Web_Server::send_asset(const String& path) {
+        flash_asset_t asset;
+        if (!flash_asset_find(path.c_str(), &asset)) {
+            return false;
+        }
+        if (not_modified("\"" + String(asset.crc, HEX) + "\"")) {
+            return true;
+        }
+        _webserver->sendHeader("Content-Encoding", "gzip");
+        _webserver->setContentLength(asset.size);
+        _webserver->send(200, getContentType(path), "");
+        if (!start_transfer(asset.data, asset.size)) {
+            _webserver->client().write(asset.data, asset.size);  // Both slots are busy
+        }
+        return true;
     }
 
     //Root of Webserver/////////////////////////////////////////////////////
 
     void Web_Server::handle_root() {
-        String path        = "/index.html";
-        String contentType = getContentType(path);
-        String pathWithGz  = path + ".gz";
+        String path       = "/index.html";
+        String pathWithGz = path + ".gz";
+        bool   fallback   = _webserver->hasArg("forcefallback") || _webserver->arg("forcefallback") == "yes";
+        if (!fallback && send_asset(path)) {
+            return;
+        }
         //if have a index.html or gzip version this is default root page
-        if ((SPIFFS.exists(pathWithGz) || SPIFFS.exists(path)) && !_webserver->hasArg("forcefallback") &&
+        if ((LocalFS.exists(pathWithGz) || LocalFS.exists(path)) && !_webserver->hasArg("forcefallback") &&
             _webserver->arg("forcefallback") != "yes") {
-            if (SPIFFS.exists(pathWithGz)) {
-                path = pathWithGz;
-            }
-
-            File file = SPIFFS.open(path, FILE_READ);
-            _webserver->streamFile(file, contentType);
-            file.close();
+            send_file(LocalFS, path, false);
             return;
         }
 
-        //if no lets launch the default content
+        //if no lets launch the default content, which only changes with the firmware
+        String etag = String("\"nofiles-") + GRBL_VERSION_BUILD + "\"";
+        if (not_modified(etag)) {
+            return;
+        }
         _webserver->sendHeader("Content-Encoding", "gzip");
         _webserver->send_P(200, "text/html", PAGE_NOFILES, PAGE_NOFILES_SIZE);
     }
@@ -285,41 +411,13 @@ namespace WebUI {
                 content += path + ", SD is not available.";
 
                 _webserver->send(500, "text/plain", content);
+                return;
             }
-            if (SD.exists(pathWithGz) || SD.exists(path)) {
+            pathWithGz = path + ".gz";
+            if (sd_fs().exists(pathWithGz) || sd_fs().exists(path)) {
                 set_sd_state(SDState::BusyUploading);
-                if (SD.exists(pathWithGz)) {
-                    path = pathWithGz;
-                }
-                File datafile = SD.open(path);
-                if (datafile) {
-                    vTaskDelay(1 / portTICK_RATE_MS);
-                    size_t totalFileSize = datafile.size();
-                    size_t i             = 0;
-                    bool   done          = false;
-                    _webserver->setContentLength(totalFileSize);
-                    _webserver->send(200, contentType, "");
-                    uint8_t buf[1024];
-                    while (!done) {
-                        vTaskDelay(1 / portTICK_RATE_MS);
-                        int v = datafile.read(buf, 1024);
-                        if ((v == -1) || (v == 0)) {
-                            done = true;
-                        } else {
-                            _webserver->client().write(buf, 1024);
-                            i += v;
-                        }
-
-                        if (i >= totalFileSize) {
-                            done = true;
-                        }
-                    }
-                    datafile.close();
-                    if (i != totalFileSize) {
-                        //error: TBD
-                    }
-                    set_sd_state(SDState::Idle);
-                    return;
+                if (send_file(sd_fs(), path, true)) {
+                    return;  // The card goes back to idle when it has been sent
                 }
                 set_sd_state(SDState::Idle);
             }
@@ -329,13 +427,10 @@ namespace WebUI {
             return;
         } else
 #    endif
-            if (SPIFFS.exists(pathWithGz) || SPIFFS.exists(path)) {
-            if (SPIFFS.exists(pathWithGz)) {
-                path = pathWithGz;
-            }
-            File file = SPIFFS.open(path, FILE_READ);
-            _webserver->streamFile(file, contentType);
-            file.close();
+            if (send_asset(path)) {
+            return;
+        } else if (LocalFS.exists(pathWithGz) || LocalFS.exists(path)) {
+            send_file(LocalFS, path, false);
             return;
         } else {
             page_not_found = true;
@@ -365,14 +460,10 @@ namespace WebUI {
             path        = "/404.htm";
             contentType = getContentType(path);
             pathWithGz  = path + ".gz";
-            if (SPIFFS.exists(pathWithGz) || SPIFFS.exists(path)) {
-                if (SPIFFS.exists(pathWithGz)) {
-                    path = pathWithGz;
-                }
-                File file = SPIFFS.open(path, FILE_READ);
-                _webserver->streamFile(file, contentType);
-                file.close();
-
+            if (send_asset(path)) {
+                return;
+            } else if (LocalFS.exists(pathWithGz) || LocalFS.exists(path)) {
+                send_file(LocalFS, path, false);
             } else {
                 //if not template use default page
                 contentType = PAGE_404;
@@ -397,45 +488,15 @@ namespace WebUI {
     }
 
 #    ifdef ENABLE_SSDP
-    //http SSDP xml presentation
+    //http SSDP xml presentation, made once for each address
     void Web_Server::handle_SSDP() {
-        StreamString sschema;
-        if (sschema.reserve(1024)) {
-            String templ = "<?xml version=\"1.0\"?>"
-                           "<root xmlns=\"urn:schemas-upnp-org:device-1-0\">"
-                           "<specVersion>"
-                           "<major>1</major>"
-                           "<minor>0</minor>"
-                           "</specVersion>"
-                           "<URLBase>http://%s:%u/</URLBase>"
-                           "<device>"
-                           "<deviceType>upnp:rootdevice</deviceType>"
-                           "<friendlyName>%s</friendlyName>"
-                           "<presentationURL>/</presentationURL>"
-                           "<serialNumber>%s</serialNumber>"
-                           "<modelName>ESP32</modelName>"
-                           "<modelNumber>Marlin</modelNumber>"
-                           "<modelURL>http://espressif.com/en/products/hardware/esp-wroom-32/overview</modelURL>"
-                           "<manufacturer>Espressif Systems</manufacturer>"
-                           "<manufacturerURL>http://espressif.com</manufacturerURL>"
-                           "<UDN>uuid:%s</UDN>"
-                           "</device>"
-                           "</root>\r\n"
-                           "\r\n";
-            char     uuid[37];
-            String   sip    = WiFi.localIP().toString();
-            uint32_t chipId = (uint16_t)(ESP.getEfuseMac() >> 32);
-            sprintf(uuid,
-                    "38323636-4558-4dda-9188-cda0e6%02x%02x%02x",
-                    (uint16_t)((chipId >> 16) & 0xff),
-                    (uint16_t)((chipId >> 8) & 0xff),
-                    (uint16_t)chipId & 0xff);
-            String serialNumber = String(chipId);
-            sschema.printf(templ.c_str(), sip.c_str(), _port, wifi_config.Hostname().c_str(), serialNumber.c_str(), uuid);
-            _webserver->send(200, "text/xml", (String)sschema);
-        } else {
-            _webserver->send(500);
+        IPAddress ip = WiFi.localIP();
+#        ifdef ENABLE_ETHERNET
+        if (WiFi.getMode() != WIFI_STA && WiFiConfig::Is_Ethernet_on()) {
+            ip = ETH.localIP();
         }
+#        endif
+        _webserver->send(200, "text/xml", ssdp_description(ip));
     }
 #    endif
 
@@ -507,11 +568,12 @@ namespace WebUI {
                     scmd[0] = scmd[1];
                     scmd.remove(1, 1);
                 }
-                if (scmd.length() > 1) {
-                    scmd += "\n";
-                } else if (!is_realtime_command(scmd[0])) {
-                    scmd += "\n";
+                if (scmd.length() == 1 && is_realtime_command(scmd[0])) {
+                    // Act on it now instead of queueing it behind lines that are still buffered
+                    execute_realtime_command(static_cast<Cmd>(scmd[0]), CLIENT_WEBUI);
+                    continue;
                 }
+                scmd += "\n";
                 if (!Serial2Socket.push(scmd.c_str())) {
                     hasError = true;
                 }
@@ -520,6 +582,55 @@ namespace WebUI {
         }
     }
 
+    // Several commands in one request, one per line, so a page refresh does not cost a connection
+    // for each. [ESP] commands run here and their output comes back in the response, each followed
+    // by ok or error:n as on the serial port. Other lines are queued for CLIENT_WEBUI as /command
+    // does and answered ok once queued; Grbl's own response to them comes through the WebSocket.
+    void Web_Server::handle_web_commands() {
+        AuthenticationLevel auth_level = is_authenticated();
+        String              cmds;
+        if (_webserver->hasArg("plain")) {
+            cmds = _webserver->arg("plain");
+        } else if (_webserver->hasArg("commandText")) {
+            cmds = _webserver->arg("commandText");
+        } else {
+            _webserver->send(200, "text/plain", "Invalid command");
+            return;
+        }
+        ESPResponseStream espresponse(_webserver);
+        for (int start = 0, end; start < cmds.length(); start = end + 1) {
+            end = cmds.indexOf('\n', start);
+            if (end < 0) {
+                end = cmds.length();
+            }
+            String scmd = cmds.substring(start, end);
+            scmd.trim();
+            if (scmd.length() == 0) {
+                continue;
+            }
+            Error err = Error::Ok;
+            if (scmd.length() == 1 && is_realtime_command(scmd[0])) {
+                execute_realtime_command(static_cast<Cmd>(scmd[0]), CLIENT_WEBUI);
+            } else if (scmd.startsWith("[ESP")) {
+                char line[256];
+                strncpy(line, scmd.c_str(), sizeof(line) - 1);
+                line[sizeof(line) - 1] = '\0';
+                err                    = system_execute_line(line, &espresponse, auth_level);
+            } else if (auth_level == AuthenticationLevel::LEVEL_GUEST) {
+                err = Error::AuthenticationFailed;
+            } else if (!Serial2Socket.push((scmd + "\n").c_str())) {
+                err = Error::Overflow;
+            }
+            if (err == Error::Ok) {
+                espresponse.println("ok");
+            } else {
+                espresponse.println(("error:" + String(static_cast<int>(err))).c_str());
+            }
+        }
+        espresponse.println("");  // Sends the headers even for an empty batch
+        espresponse.flush();
+    }
+
     //login status check
     void Web_Server::handle_login() {
 #    ifdef ENABLE_AUTHENTICATION
@@ -530,14 +641,10 @@ namespace WebUI {
         bool   msg_alert_error = false;
         //disconnect can be done anytime no need to check credential
         if (_webserver->hasArg("DISCONNECT")) {
-            String cookie = _webserver->header("Cookie");
-            int    pos    = cookie.indexOf("ESPSESSIONID=");
-            String sessionID;
-            if (pos != -1) {
-                int pos2  = cookie.indexOf(";", pos);
-                sessionID = cookie.substring(pos + strlen("ESPSESSIONID="), pos2);
+            char sessionID[SESSION_ID_LENGTH + 1];
+            if (getSessionID(sessionID)) {
+                ClearAuthIP(_webserver->client().remoteIP(), sessionID);
             }
-            ClearAuthIP(_webserver->client().remoteIP(), sessionID.c_str());
             _webserver->sendHeader("Set-Cookie", "ESPSESSIONID=0");
             _webserver->sendHeader("Cache-Control", "no-cache");
             String buffer2send = "{\"status\":\"Ok\",\"authentication_lvl\":\"guest\"}";
@@ -575,8 +682,8 @@ namespace WebUI {
                     String sadminPassword = admin_password->get();
                     String suserPassword  = user_password->get();
 
-                    if (!(sUser == DEFAULT_ADMIN_LOGIN && sPassword == sadminPassword) ||
-                        (sUser == DEFAULT_USER_LOGIN && sPassword == suserPassword)) {
+                    if (!((sUser == DEFAULT_ADMIN_LOGIN && sPassword == sadminPassword) ||
+                          (sUser == DEFAULT_USER_LOGIN && sPassword == suserPassword))) {
                         msg_alert_error = true;
                         smsg            = "Error: Incorrect password";
                         code            = 401;
@@ -625,13 +732,8 @@ namespace WebUI {
                 }
                 //create Session
                 if ((current_auth_level != auth_level) || (auth_level == AuthenticationLevel::LEVEL_GUEST)) {
-                    AuthenticationIP* current_auth = new AuthenticationIP;
-                    current_auth->level            = current_auth_level;
-                    current_auth->ip               = _webserver->client().remoteIP();
-                    strcpy(current_auth->sessionID, create_session_ID());
-                    strcpy(current_auth->userID, sUser.c_str());
-                    current_auth->last_time = millis();
-                    if (AddAuthIP(current_auth)) {
+                    AuthenticationIP* current_auth = AddAuthIP(_webserver->client().remoteIP(), current_auth_level, sUser.c_str());
+                    if (current_auth) {
                         String tmps = "ESPSESSIONID=";
                         tmps += current_auth->sessionID;
                         _webserver->sendHeader("Set-Cookie", tmps);
@@ -648,7 +750,6 @@ namespace WebUI {
                                 break;
                         }
                     } else {
-                        delete current_auth;
                         msg_alert_error = true;
                         code            = 500;
                         smsg            = "Error: Too many connections";
@@ -665,17 +766,11 @@ namespace WebUI {
             buffer2send += "\"}";
             _webserver->send(code, "application/json", buffer2send);
         } else {
-            if (auth_level != AuthenticationLevel::LEVEL_GUEST) {
-                String cookie = _webserver->header("Cookie");
-                int    pos    = cookie.indexOf("ESPSESSIONID=");
-                String sessionID;
-                if (pos != -1) {
-                    int pos2                            = cookie.indexOf(";", pos);
-                    sessionID                           = cookie.substring(pos + strlen("ESPSESSIONID="), pos2);
-                    AuthenticationIP* current_auth_info = GetAuth(_webserver->client().remoteIP(), sessionID.c_str());
-                    if (current_auth_info != NULL) {
-                        sUser = current_auth_info->userID;
-                    }
+            char sessionID[SESSION_ID_LENGTH + 1];
+            if (auth_level != AuthenticationLevel::LEVEL_GUEST && getSessionID(sessionID)) {
+                AuthenticationIP* current_auth_info = GetAuth(_webserver->client().remoteIP(), sessionID);
+                if (current_auth_info != NULL) {
+                    sUser = current_auth_info->userID;
                 }
             }
             String buffer2send = "{\"status\":\"200\",\"authentication_lvl\":\"";
@@ -729,6 +824,7 @@ namespace WebUI {
 
         //check if query need some action
         if (_webserver->hasArg("action")) {
+            etag_clear();
             //delete a file
             if (_webserver->arg("action") == "delete" && _webserver->hasArg("filename")) {
                 String filename;
@@ -736,10 +832,10 @@ namespace WebUI {
                 shortname.replace("/", "");
                 filename = path + _webserver->arg("filename");
                 filename.replace("//", "/");
-                if (!SPIFFS.exists(filename)) {
+                if (!LocalFS.exists(filename)) {
                     status = shortname + " does not exists!";
                 } else {
-                    if (SPIFFS.remove(filename)) {
+                    if (LocalFS.remove(filename)) {
                         status = shortname + " deleted";
                         //what happen if no "/." and no other subfiles ?
                         String ptmp = path;
@@ -747,14 +843,11 @@ namespace WebUI {
                             ptmp = path.substring(0, path.length() - 1);
                         }
 
-                        File dir        = SPIFFS.open(ptmp);
+                        File dir        = LocalFS.open(ptmp);
                         File dircontent = dir.openNextFile();
                         if (!dircontent) {
                             //keep directory alive even empty
-                            File r = SPIFFS.open(path + "/.", FILE_WRITE);
-                            if (r) {
-                                r.close();
-                            }
+                            localfs_mkdir(ptmp);
                         }
                     } else {
                         status = "Cannot deleted ";
@@ -771,23 +864,12 @@ namespace WebUI {
                 filename += "/";
                 filename.replace("//", "/");
                 if (filename != "/") {
-                    bool delete_error = false;
-                    File dir          = SPIFFS.open(path + shortname);
-                    {
-                        File file2deleted = dir.openNextFile();
-                        while (file2deleted) {
-                            String fullpath = file2deleted.name();
-                            if (!SPIFFS.remove(fullpath)) {
-                                delete_error = true;
-                                status       = "Cannot deleted ";
-                                status += fullpath;
-                            }
-                            file2deleted = dir.openNextFile();
-                        }
-                    }
-                    if (!delete_error) {
+                    if (localfs_remove_dir(path + shortname)) {
                         status = shortname;
                         status += " deleted";
+                    } else {
+                        status = "Cannot deleted ";
+                        status += shortname;
                     }
                 }
             }
@@ -795,21 +877,17 @@ namespace WebUI {
             //create a directory
             if (_webserver->arg("action") == "createdir" && _webserver->hasArg("filename")) {
                 String filename;
-                filename         = path + _webserver->arg("filename") + "/.";
+                filename         = path + _webserver->arg("filename");
                 String shortname = _webserver->arg("filename");
                 shortname.replace("/", "");
                 filename.replace("//", "/");
-                if (SPIFFS.exists(filename)) {
+                if (LocalFS.exists(filename) || LocalFS.exists(filename + "/.")) {
                     status = shortname + " already exists!";
+                } else if (!localfs_mkdir(filename)) {
+                    status = "Cannot create ";
+                    status += shortname;
                 } else {
-                    File r = SPIFFS.open(filename, FILE_WRITE);
-                    if (!r) {
-                        status = "Cannot create ";
-                        status += shortname;
-                    } else {
-                        r.close();
-                        status = shortname + " created";
-                    }
+                    status = shortname + " created";
                 }
             }
         }
@@ -820,7 +898,7 @@ namespace WebUI {
             ptmp = path.substring(0, path.length() - 1);
         }
 
-        File dir = SPIFFS.open(ptmp);
+        File dir = LocalFS.open(ptmp);
         jsonfile += "\"files\":[";
         bool   firstentry = true;
         String subdirlist = "";
@@ -832,7 +910,9 @@ namespace WebUI {
             //remove path from name
             filename = filename.substring(path.length(), filename.length());
             //check if file or subfile
-            if (filename.indexOf("/") > -1) {
+            if (fileparsed.isDirectory()) {
+                size = "-1";  //LittleFS lists its directories as entries of their own
+            } else if (filename.indexOf("/") > -1) {
                 //Do not rely on "/." to define directory as SPIFFS upload won't create it but directly files
                 //and no need to overload SPIFFS if not necessary to create "/." if no need
                 //it will reduce SPIFFS available space so limit it to creation
@@ -877,8 +957,8 @@ namespace WebUI {
         jsonfile += "\"status\":\"" + status + "\",";
         size_t totalBytes;
         size_t usedBytes;
-        totalBytes = SPIFFS.totalBytes();
-        usedBytes  = SPIFFS.usedBytes();
+        totalBytes = LocalFS.totalBytes();
+        usedBytes  = LocalFS.usedBytes();
         jsonfile += "\"total\":\"" + ESPResponseStream::formatBytes(totalBytes) + "\",";
         jsonfile += "\"used\":\"" + ESPResponseStream::formatBytes(usedBytes) + "\",";
         jsonfile.concat(F("\"occupation\":\""));
@@ -937,6 +1017,7 @@ namespace WebUI {
                 //Upload start
                 //**************
                 if (upload.status == UPLOAD_FILE_START) {
+                    etag_clear();
                     _upload_status         = UploadStatusType::ONGOING;
                     String upload_filename = upload.filename;
                     if (upload_filename[0] != '/') {
@@ -951,8 +1032,8 @@ namespace WebUI {
                         filename        = "/user" + upload_filename;
                     }
 
-                    if (SPIFFS.exists(filename)) {
-                        SPIFFS.remove(filename);
+                    if (LocalFS.exists(filename)) {
+                        LocalFS.remove(filename);
                     }
                     if (fsUploadFile) {
                         fsUploadFile.close();
@@ -960,7 +1041,7 @@ namespace WebUI {
                     String sizeargname = upload.filename + "S";
                     if (_webserver->hasArg(sizeargname)) {
                         uint32_t filesize  = _webserver->arg(sizeargname).toInt();
-                        uint32_t freespace = SPIFFS.totalBytes() - SPIFFS.usedBytes();
+                        uint32_t freespace = LocalFS.totalBytes() - LocalFS.usedBytes();
                         if (filesize > freespace) {
                             _upload_status = UploadStatusType::FAILED;
                             grbl_send(CLIENT_ALL, "[MSG:Upload error]\r\n");
@@ -969,8 +1050,9 @@ namespace WebUI {
                     }
 
                     if (_upload_status != UploadStatusType::FAILED) {
-                        //create file
-                        fsUploadFile = SPIFFS.open(filename, FILE_WRITE);
+                        //create file, and on LittleFS the directories it goes in
+                        localfs_make_parents(filename);
+                        fsUploadFile = LocalFS.open(filename, FILE_WRITE);
                         //check If creation succeed
                         if (fsUploadFile) {
                             //if yes upload is started
@@ -1009,7 +1091,7 @@ namespace WebUI {
                         fsUploadFile.close();
                         //check size
                         String sizeargname = upload.filename + "S";
-                        fsUploadFile       = SPIFFS.open(filename, FILE_READ);
+                        fsUploadFile       = LocalFS.open(filename, FILE_READ);
                         uint32_t filesize  = fsUploadFile.size();
                         fsUploadFile.close();
 
@@ -1041,8 +1123,8 @@ namespace WebUI {
 
         if (_upload_status == UploadStatusType::FAILED) {
             cancelUpload();
-            if (SPIFFS.exists(filename)) {
-                SPIFFS.remove(filename);
+            if (LocalFS.exists(filename)) {
+                LocalFS.remove(filename);
             }
         }
         COMMANDS::wait(0);
@@ -1112,10 +1194,14 @@ namespace WebUI {
                     }
                     if (_upload_status != UploadStatusType::FAILED) {
                         last_upload_update = 0;
-                        if (!Update.begin()) {  //start with max available size
+                        // A .gz image is inflated as it is written. The digest, if given, is
+                        // that of the image as written, the .bin.
+                        bool   compressed = upload.filename.endsWith(".gz");
+                        String sha256     = _webserver->hasArg("sha256") ? _webserver->arg("sha256") : String();
+                        if (!ota_begin(compressed, sha256.length() ? sha256.c_str() : NULL)) {
                             _upload_status = UploadStatusType::FAILED;
                             grbl_send(CLIENT_ALL, "[MSG:Update cancelled]\r\n");
-                            pushError(ESP_ERROR_NOT_ENOUGH_SPACE, "Upload rejected, not enough space");
+                            pushError(ESP_ERROR_NOT_ENOUGH_SPACE, "Upload rejected, not enough space or bad digest");
                         } else {
                             grbl_send(CLIENT_ALL, "\n[MSG:Update 0%]\r\n");
                         }
@@ -1123,22 +1209,23 @@ namespace WebUI {
                     //Upload write
                     //**************
                 } else if (upload.status == UPLOAD_FILE_WRITE) {
-                    vTaskDelay(1 / portTICK_RATE_MS);
                     //check if no error
                     if (_upload_status == UploadStatusType::ONGOING) {
-                        if (((100 * upload.totalSize) / maxSketchSpace) != last_upload_update) {
+                        // Every 10%, or every 100 kB when the size is not known.
+                        size_t progress = upload.totalSize / 102400 * 100;
+                        if (maxSketchSpace > 0) {
+                            progress = (100 * upload.totalSize) / maxSketchSpace / 10 * 10;
+                        }
+                        if (progress != last_upload_update) {
+                            last_upload_update = progress;
                             if (maxSketchSpace > 0) {
-                                last_upload_update = (100 * upload.totalSize) / maxSketchSpace;
+                                grbl_sendf(CLIENT_ALL, "[MSG:Update %u%%]\r\n", progress);
                             } else {
-                                last_upload_update = upload.totalSize;
+                                grbl_sendf(CLIENT_ALL, "[MSG:Update %u kB]\r\n", progress);
                             }
-
-                            String s = "Update ";
-                            s += String(last_upload_update);
-                            s += "%";
-                            grbl_sendf(CLIENT_ALL, "[MSG:%s]\r\n", s.c_str());
                         }
-                        if (Update.write(upload.buf, upload.currentSize) != upload.currentSize) {
+                        // Queued for otaWriteTask, which writes it while the next chunk comes in.
+                        if (!ota_write(upload.buf, upload.currentSize)) {
                             _upload_status = UploadStatusType::FAILED;
                             grbl_send(CLIENT_ALL, "[MSG:Update write failed]\r\n");
                             pushError(ESP_ERROR_FILE_WRITE, "File write failed");
@@ -1147,18 +1234,24 @@ namespace WebUI {
                     //Upload end
                     //**************
                 } else if (upload.status == UPLOAD_FILE_END) {
-                    if (Update.end(true)) {  //true to set the size to the current progress
+                    char digest[65];
+                    if (ota_end(digest)) {
                         //Now Reboot
-                        grbl_send(CLIENT_ALL, "[MSG:Update 100%]\r\n");
+                        grbl_sendf(CLIENT_ALL, "[MSG:Update 100%%, SHA-256 %s]\r\n", digest);
                         _upload_status = UploadStatusType::SUCCESSFUL;
                     } else {
                         _upload_status = UploadStatusType::FAILED;
-                        grbl_send(CLIENT_ALL, "[MSG:Update failed]\r\n");
+                        if (*digest) {
+                            grbl_sendf(CLIENT_ALL, "[MSG:Update failed, SHA-256 %s]\r\n", digest);
+                        } else {
+                            grbl_send(CLIENT_ALL, "[MSG:Update failed]\r\n");
+                        }
                         pushError(ESP_ERROR_UPLOAD, "Update upload failed");
                     }
                 } else if (upload.status == UPLOAD_FILE_ABORTED) {
                     grbl_send(CLIENT_ALL, "[MSG:Update failed]\r\n");
                     _upload_status = UploadStatusType::FAILED;
+                    ota_abort();
                     return;
                 }
             }
@@ -1166,7 +1259,7 @@ namespace WebUI {
 
         if (_upload_status == UploadStatusType::FAILED) {
             cancelUpload();
-            Update.end();
+            ota_abort();
         }
 
         COMMANDS::wait(0);
@@ -1177,7 +1270,7 @@ namespace WebUI {
     //Function to delete not empty directory on SD card
     bool Web_Server::deleteRecursive(String path) {
         bool result = true;
-        File file   = SD.open(path);
+        File file   = sd_fs().open(path);
         //failed
         if (!file) {
             return false;
@@ -1185,7 +1278,7 @@ namespace WebUI {
         if (!file.isDirectory()) {
             file.close();
             //return if success or not
-            return SD.remove(path);
+            return sd_fs().remove(path);
         }
         file.rewindDirectory();
         while (true) {
@@ -1201,7 +1294,7 @@ namespace WebUI {
                 }
             } else {
                 entry.close();
-                if (!SD.remove(entryPath)) {
+                if (!sd_fs().remove(entryPath)) {
                     result = false;
                     break;
                 }
@@ -1209,10 +1302,30 @@ namespace WebUI {
             COMMANDS::wait(0);  //wdtFeed
         }
         file.close();
-        return result ? SD.rmdir(path) : false;
+        return result ? sd_fs().rmdir(path) : false;
     }
 
     //direct SD files list//////////////////////////////////////////////////
+    static void addFileJSON(String& jsonfile, bool comma, const char* name, bool directory, uint32_t size) {
+        if (comma) {
+            jsonfile += ",";
+        }
+        jsonfile += "{\"name\":\"";
+        jsonfile += name;
+        jsonfile += "\",\"shortname\":\"";  //No need here
+        jsonfile += name;
+        jsonfile += "\",\"size\":\"";
+        if (directory) {
+            jsonfile += "-1";
+        } else {
+            // files have sizes, directories do not
+            jsonfile += ESPResponseStream::formatBytes(size);
+        }
+        jsonfile += "\",\"datetime\":\"";
+        //TODO - can be done later
+        jsonfile += "\"}";
+    }
+
     void Web_Server::handle_direct_SDFileList() {
         //this is only for admin and user
         if (is_authenticated() == AuthenticationLevel::LEVEL_GUEST) {
@@ -1253,6 +1366,7 @@ namespace WebUI {
         }
         //check if query need some action
         if (_webserver->hasArg("action")) {
+            sd_dir_index_invalidate();
             //delete a file
             if (_webserver->arg("action") == "delete" && _webserver->hasArg("filename")) {
                 String filename;
@@ -1260,10 +1374,10 @@ namespace WebUI {
                 filename         = path + shortname;
                 shortname.replace("/", "");
                 filename.replace("//", "/");
-                if (!SD.exists(filename)) {
+                if (!sd_fs().exists(filename)) {
                     sstatus = shortname + " does not exist!";
                 } else {
-                    if (SD.remove(filename)) {
+                    if (sd_fs().remove(filename)) {
                         sstatus = shortname + " deleted";
                     } else {
                         sstatus = "Cannot deleted ";
@@ -1279,7 +1393,7 @@ namespace WebUI {
                 filename = path + "/" + shortname;
                 filename.replace("//", "/");
                 if (filename != "/") {
-                    if (!SD.exists(filename)) {
+                    if (!sd_fs().exists(filename)) {
                         sstatus = shortname + " does not exist!";
                     } else {
                         if (!deleteRecursive(filename)) {
@@ -1301,10 +1415,10 @@ namespace WebUI {
                 filename         = path + shortname;
                 shortname.replace("/", "");
                 filename.replace("//", "/");
-                if (SD.exists(filename)) {
+                if (sd_fs().exists(filename)) {
                     sstatus = shortname + " already exists!";
                 } else {
-                    if (!SD.mkdir(filename)) {
+                    if (!sd_fs().mkdir(filename)) {
                         sstatus = "Cannot create ";
                         sstatus += shortname;
                     } else {
@@ -1325,58 +1439,53 @@ namespace WebUI {
         if (path != "/") {
             path = path.substring(0, path.length() - 1);
         }
-        if (path != "/" && !SD.exists(path)) {
+        if (path != "/" && !sd_fs().exists(path)) {
             String s = "{\"status\":\" ";
             s += path;
             s += " does not exist on SD Card\"}";
             _webserver->send(200, "application/json", s);
-            SD.end();
+            sd_unmount();
             set_sd_state(SDState::Idle);
             return;
         }
+        // offset and count select part of a large directory, count is the number of entries
+        int listed = 0;
         if (list_files) {
-            File dir = SD.open(path);
-            if (!dir.isDirectory()) {
-                dir.close();
-            }
-            dir.rewindDirectory();
-            File entry = dir.openNextFile();
-            int  i     = 0;
-            while (entry) {
-                COMMANDS::wait(1);
-                if (i > 0) {
-                    jsonfile += ",";
+            int first = _webserver->hasArg("offset") ? max(int(_webserver->arg("offset").toInt()), 0) : 0;
+            int count = _webserver->hasArg("count") ? _webserver->arg("count").toInt() : 0;
+            int last  = count > 0 ? first + count : INT32_MAX;
+            listed    = sd_dir_index(path.c_str());
+            if (listed >= 0) {
+                for (int i = first; i < min(listed, last); i++) {
+                    addFileJSON(jsonfile, i > first, sd_dir_index_name(i), sd_dir_index_is_dir(i), sd_dir_index_size(i));
                 }
-                jsonfile += "{\"name\":\"";
-                String tmpname = entry.name();
-                int    pos     = tmpname.lastIndexOf("/");
-                tmpname        = tmpname.substring(pos + 1);
-                jsonfile += tmpname;
-                jsonfile += "\",\"shortname\":\"";  //No need here
-                jsonfile += tmpname;
-                jsonfile += "\",\"size\":\"";
-                if (entry.isDirectory()) {
-                    jsonfile += "-1";
-                } else {
-                    // files have sizes, directories do not
-                    jsonfile += ESPResponseStream::formatBytes(entry.size());
+            } else {
+                // Too large to index
+                listed     = 0;
+                File dir   = sd_fs().open(path);
+                File entry = dir.openNextFile();
+                while (entry) {
+                    COMMANDS::wait(1);
+                    if (listed >= first && listed < last) {
+                        String tmpname = entry.name();
+                        tmpname        = tmpname.substring(tmpname.lastIndexOf("/") + 1);
+                        addFileJSON(jsonfile, listed > first, tmpname.c_str(), entry.isDirectory(), entry.size());
+                    }
+                    listed++;
+                    entry.close();
+                    entry = dir.openNextFile();
                 }
-                jsonfile += "\",\"datetime\":\"";
-                //TODO - can be done later
-                jsonfile += "\"}";
-                i++;
-                entry.close();
-                entry = dir.openNextFile();
+                dir.close();
             }
-            dir.close();
         }
         jsonfile += "],\"path\":\"";
         jsonfile += path + "\",";
+        jsonfile += "\"count\":\"" + String(listed) + "\",";
         jsonfile += "\"total\":\"";
         String stotalspace, susedspace;
         //SDCard are in GB or MB but no less
-        totalspace  = SD.totalBytes();
-        usedspace   = SD.usedBytes();
+        totalspace  = sd_total_bytes();
+        usedspace   = sd_used_bytes();
         stotalspace = ESPResponseStream::formatBytes(totalspace);
         susedspace  = ESPResponseStream::formatBytes(usedspace + 1);
 
@@ -1409,7 +1518,7 @@ namespace WebUI {
         _webserver->sendHeader("Cache-Control", "no-cache");
         _webserver->send(200, "application/json", jsonfile);
         set_sd_state(SDState::Idle);
-        SD.end();
+        sd_unmount();
     }
 
     //SD File upload with direct access to SD///////////////////////////////
@@ -1442,14 +1551,15 @@ namespace WebUI {
 
                     } else {
                         set_sd_state(SDState::BusyUploading);
+                        sd_dir_index_invalidate();
                         //delete file on SD Card if already present
-                        if (SD.exists(filename)) {
-                            SD.remove(filename);
+                        if (sd_fs().exists(filename)) {
+                            sd_fs().remove(filename);
                         }
                         String sizeargname = upload.filename + "S";
                         if (_webserver->hasArg(sizeargname)) {
                             uint32_t filesize  = _webserver->arg(sizeargname).toInt();
-                            uint64_t freespace = SD.totalBytes() - SD.usedBytes();
+                            uint64_t freespace = sd_total_bytes() - sd_used_bytes();
                             if (filesize > freespace) {
                                 _upload_status = UploadStatusType::FAILED;
                                 grbl_send(CLIENT_ALL, "[MSG:Upload error]\r\n");
@@ -1458,7 +1568,7 @@ namespace WebUI {
                         }
                         if (_upload_status != UploadStatusType::FAILED) {
                             //Create file for writing
-                            sdUploadFile = SD.open(filename, FILE_WRITE);
+                            sdUploadFile = sd_fs().open(filename, FILE_WRITE);
                             //check if creation succeed
                             if (!sdUploadFile) {
                                 //if creation failed
@@ -1467,21 +1577,27 @@ namespace WebUI {
                                 pushError(ESP_ERROR_FILE_CREATION, "File creation failed");
                             }
                             //if creation succeed set flag UploadStatusType::ONGOING
-                            else {
+                            else if (sd_write_begin(sdUploadFile)) {
                                 _upload_status = UploadStatusType::ONGOING;
+                                sd_preview_begin(filename.c_str());
+                            } else {
+                                _upload_status = UploadStatusType::FAILED;
+                                grbl_send(CLIENT_ALL, "[MSG:Upload failed]\r\n");
+                                pushError(ESP_ERROR_FILE_CREATION, "Upload buffer allocation failed");
                             }
                         }
                     }
                     //Upload write
                     //**************
                 } else if (upload.status == UPLOAD_FILE_WRITE) {
-                    vTaskDelay(1 / portTICK_RATE_MS);
                     if (sdUploadFile && (_upload_status == UploadStatusType::ONGOING) && (get_sd_state(false) == SDState::BusyUploading)) {
-                        //no error write post data
-                        if (upload.currentSize != sdUploadFile.write(upload.buf, upload.currentSize)) {
+                        //no error queue post data, sdWriteTask writes it
+                        if (!sd_write(upload.buf, upload.currentSize)) {
                             _upload_status = UploadStatusType::FAILED;
                             grbl_send(CLIENT_ALL, "[MSG:Upload failed]\r\n");
                             pushError(ESP_ERROR_FILE_WRITE, "File write failed");
+                        } else {
+                            sd_preview_feed(upload.buf, upload.currentSize);  // While sdWriteTask writes it
                         }
                     } else {  //if error set flag UploadStatusType::FAILED
                         _upload_status = UploadStatusType::FAILED;
@@ -1493,12 +1609,16 @@ namespace WebUI {
                 } else if (upload.status == UPLOAD_FILE_END) {
                     //if file is open close it
                     if (sdUploadFile) {
+                        if (!sd_write_end()) {
+                            _upload_status = UploadStatusType::FAILED;
+                            pushError(ESP_ERROR_FILE_WRITE, "File write failed");
+                        }
                         sdUploadFile.close();
                         //TODO Check size
                         String sizeargname = upload.filename + "S";
                         if (_webserver->hasArg(sizeargname)) {
                             uint32_t filesize = 0;
-                            sdUploadFile      = SD.open(filename, FILE_READ);
+                            sdUploadFile      = sd_fs().open(filename, FILE_READ);
                             filesize          = sdUploadFile.size();
                             sdUploadFile.close();
                             if (_webserver->arg(sizeargname) != String(filesize)) {
@@ -1512,6 +1632,7 @@ namespace WebUI {
                         grbl_send(CLIENT_ALL, "[MSG:Upload failed]\r\n");
                         pushError(ESP_ERROR_FILE_CLOSE, "File close failed");
                     }
+                    sd_preview_end(_upload_status == UploadStatusType::ONGOING);
                     if (_upload_status == UploadStatusType::ONGOING) {
                         _upload_status = UploadStatusType::SUCCESSFUL;
                         set_sd_state(SDState::Idle);
@@ -1525,9 +1646,11 @@ namespace WebUI {
                     set_sd_state(SDState::Idle);
                     grbl_send(CLIENT_ALL, "[MSG:Upload failed]\r\n");
                     if (sdUploadFile) {
+                        sd_write_end();
                         sdUploadFile.close();
                     }
-                    SD.end();
+                    sd_preview_end(false);
+                    sd_unmount();
                     return;
                 }
             }
@@ -1535,10 +1658,12 @@ namespace WebUI {
         if (_upload_status == UploadStatusType::FAILED) {
             cancelUpload();
             if (sdUploadFile) {
+                sd_write_end();
                 sdUploadFile.close();
             }
-            if (SD.exists(filename)) {
-                SD.remove(filename);
+            sd_preview_end(false);
+            if (sd_fs().exists(filename)) {
+                sd_fs().remove(filename);
             }
             set_sd_state(SDState::Idle);
         }
@@ -1557,23 +1682,165 @@ namespace WebUI {
         if (_webserver) {
             _webserver->handleClient();
         }
+        handle_transfers();
         if (_socket_server && _setupdone) {
             _socket_server->loop();
+#    ifdef ENABLE_WEBSOCKET_EVENTS
+            SocketEvents.handle();
+#    endif
         }
         if ((millis() - timeout) > 10000 && _socket_server) {
-            String s = "PING:";
-            s += String(_id_connection);
+            char s[16];
+            snprintf(s, sizeof(s), "PING:%ld", _id_connection);
             _socket_server->broadcastTXT(s);
             timeout = millis();
         }
     }
 
+    typedef struct {
+        WiFiClient     client;  // Holds the connection open after the server has moved on
+        File           file;
+        const uint8_t* data;  // Or the rest of a file in mapped flash
+        size_t         left;
+        bool           sd;  // The card is busy until it is done
+    } transfer_t;
+    static transfer_t transfers[TRANSFERS];
+
+    static bool transfer_busy(const transfer_t& t) {
+        return t.file || t.data;
+    }
+
+    static transfer_t* free_transfer() {
+        for (auto& t : transfers) {
+            if (!transfer_busy(t)) {
+                return &t;
+            }
+        }
+        return nullptr;
+    }
+
+    // Call after the headers are sent. The server keeps the client for HTTP_MAX_CLOSE_WAIT once
+    // the handler returns, then lets it go, and the transfer carries on with its own reference.
+    bool Web_Server::start_transfer(File& file, bool sd) {
+        transfer_t* t = free_transfer();
+        if (!t) {
+            return false;
+        }
+        t->client = _webserver->client();
+        t->file   = file;
+        t->left   = file.size();
+        t->sd     = sd;
+        return true;
+    }
+
+    // As above, for size bytes at data, which stay where they are until they have been sent.
+    bool Web_Server::start_transfer(const uint8_t* data, size_t size) {
+        transfer_t* t = free_transfer();
+        if (!t) {
+            return false;
+        }
+        t->client = _webserver->client();
+        t->data   = data;
+        t->left   = size;
+        t->sd     = false;
+        return true;
+    }
+
+    static void end_transfer(transfer_t& t) {
+        if (t.file) {
+            t.file.close();
+        }
+        t.data = nullptr;
+        t.client.stop();
+#    ifdef ENABLE_SD_CARD
+        if (t.sd) {
+            set_sd_state(SDState::Idle);
+        }
+#    endif
+    }
+
+    bool Web_Server::transferring() {
+        for (auto& t : transfers) {
+            if (transfer_busy(t)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Web_Server::handle_transfers() {
+        static bool busy = false;  // Handlers reenter handle() through COMMANDS::wait()
+        if (busy) {
+            return;
+        }
+        busy           = true;
+        uint32_t start = millis();
+        bool     more  = true;
+        while (more && millis() - start < TRANSFER_SLICE_MS) {
+            more = false;
+            for (auto& t : transfers) {
+                if (!transfer_busy(t)) {
+                    continue;
+                }
+                size_t length = 0;
+                if (t.client.connected() && t.data) {
+                    // Straight from the flash cache, with no copy
+                    length = MIN(t.left, sizeof(send_buf));
+                    if (t.client.write(t.data, length) != length) {
+                        length = 0;
+                    }
+                    t.data += length;
+                } else if (t.client.connected()) {
+                    length = t.file.read(send_buf, MIN(t.left, sizeof(send_buf)));
+                    if (length && t.client.write(send_buf, length) != length) {
+                        length = 0;
+                    }
+                }
+                if (length == 0) {
+                    t.left = 0;  // Gone, or failed
+                } else {
+                    t.left -= length;
+                }
+                if (t.left == 0) {
+                    end_transfer(t);
+                } else {
+                    more = true;
+                }
+            }
+        }
+        busy = false;
+    }
+
+    void Web_Server::end_transfers() {
+        for (auto& t : transfers) {
+            if (transfer_busy(t)) {
+                end_transfer(t);
+            }
+        }
+    }
+
     void Web_Server::handle_Websocket_Event(uint8_t num, uint8_t type, uint8_t* payload, size_t length) {
         switch (type) {
             case WStype_DISCONNECTED:
                 //USE_SERIAL.printf("[%u] Disconnected!\n", num);
+#    ifdef ENABLE_WEBSOCKET_STREAM
+                SocketStream.disconnect(num);
+#    endif
+#    ifdef ENABLE_WEBSOCKET_EVENTS
+                SocketEvents.disconnect(num);
+#    endif
                 break;
             case WStype_CONNECTED: {
+#    ifdef ENABLE_WEBSOCKET_STREAM
+                // payload is the URL; /stream is the G-code stream, which takes no part in the WebUI ids
+                if (strcmp((const char*)payload, "/stream") == 0) {
+                    if (!SocketStream.connect(num)) {
+                        _socket_server->sendTXT(num, "BUSY");
+                        _socket_server->disconnect(num);
+                    }
+                    break;
+                }
+#    endif
                 IPAddress ip = _socket_server->remoteIP(num);
                 //USE_SERIAL.printf("[%u] Connected from %d.%d.%d.%d url: %s\n", num, ip[0], ip[1], ip[2], ip[3], payload);
                 String s = "CURRENT_ID:" + String(num);
@@ -1585,6 +1852,15 @@ namespace WebUI {
             } break;
             case WStype_TEXT:
                 //USE_SERIAL.printf("[%u] get Text: %s\n", num, payload);
+#    ifdef ENABLE_WEBSOCKET_STREAM
+                if (SocketStream.connected(num)) {
+                    SocketStream.push(payload, length, true);
+                    break;
+                }
+#    endif
+#    ifdef ENABLE_WEBSOCKET_EVENTS
+                SocketEvents.subscribe(num, (const char*)payload);  // payload is terminated by the library
+#    endif
 
                 // send message to client
                 // webSocket.sendTXT(num, "message here");
@@ -1595,6 +1871,11 @@ namespace WebUI {
             case WStype_BIN:
                 //USE_SERIAL.printf("[%u] get binary length: %u\n", num, length);
                 //hexdump(payload, length);
+#    ifdef ENABLE_WEBSOCKET_STREAM
+                if (SocketStream.connected(num)) {
+                    SocketStream.push(payload, length, false);
+                }
+#    endif
 
                 // send message to client
                 // webSocket.sendBIN(num, payload, length);
@@ -1664,16 +1945,9 @@ namespace WebUI {
     //check authentification
     AuthenticationLevel Web_Server::is_authenticated() {
 #    ifdef ENABLE_AUTHENTICATION
-        if (_webserver->hasHeader("Cookie")) {
-            String cookie = _webserver->header("Cookie");
-            int    pos    = cookie.indexOf("ESPSESSIONID=");
-            if (pos != -1) {
-                int       pos2      = cookie.indexOf(";", pos);
-                String    sessionID = cookie.substring(pos + strlen("ESPSESSIONID="), pos2);
-                IPAddress ip        = _webserver->client().remoteIP();
-                //check if cookie can be reset and clean table in same time
-                return ResetAuthIP(ip, sessionID.c_str());
-            }
+        char sessionID[SESSION_ID_LENGTH + 1];
+        if (getSessionID(sessionID)) {
+            return ResetAuthIP(_webserver->client().remoteIP(), sessionID);
         }
         return AuthenticationLevel::LEVEL_GUEST;
 #    else
@@ -1683,121 +1957,95 @@ namespace WebUI {
 
 #    ifdef ENABLE_AUTHENTICATION
 
-    //add the information in the linked list if possible
-    bool Web_Server::AddAuthIP(AuthenticationIP* item) {
-        if (_nb_ip > MAX_AUTH_IP) {
+    // Copies the ESPSESSIONID of the request's cookie into sessionID. Returns false if there is
+    // none, or it is not the length of one.
+    bool Web_Server::getSessionID(char* sessionID) {
+        if (!_webserver->hasHeader("Cookie")) {
+            return false;
+        }
+        const String& cookie = _webserver->header("Cookie");
+        const char*   id     = strstr(cookie.c_str(), "ESPSESSIONID=");
+        if (id == NULL) {
             return false;
         }
-        item->_next = _head;
-        _head       = item;
-        _nb_ip++;
+        id += strlen("ESPSESSIONID=");
+        size_t length = strcspn(id, "; ");
+        if (length != SESSION_ID_LENGTH) {
+            return false;
+        }
+        memcpy(sessionID, id, SESSION_ID_LENGTH);
+        sessionID[SESSION_ID_LENGTH] = '\0';
         return true;
     }
 
-    //Session ID based on IP and time using 16 char
-    char* Web_Server::create_session_ID() {
-        static char sessionID[17];
-        //reset SESSIONID
-        for (int i = 0; i < 17; i++) {
-            sessionID[i] = '\0';
-        }
-        //get time
-        uint32_t now = millis();
-        //get remote IP
-        IPAddress remoteIP = _webserver->client().remoteIP();
-        //generate SESSIONID
-        if (0 > sprintf(sessionID,
-                        "%02X%02X%02X%02X%02X%02X%02X%02X",
-                        remoteIP[0],
-                        remoteIP[1],
-                        remoteIP[2],
-                        remoteIP[3],
-                        (uint8_t)((now >> 0) & 0xff),
-                        (uint8_t)((now >> 8) & 0xff),
-                        (uint8_t)((now >> 16) & 0xff),
-                        (uint8_t)((now >> 24) & 0xff))) {
-            strcpy(sessionID, "NONE");
-        }
-        return sessionID;
+    // Compares in a time that does not depend on where the IDs differ.
+    static bool same_session(const char* a, const char* b) {
+        uint8_t diff = 0;
+        for (int i = 0; i < SESSION_ID_LENGTH; i++) {
+            diff |= a[i] ^ b[i];
+        }
+        return diff == 0;
     }
 
-    bool Web_Server::ClearAuthIP(IPAddress ip, const char* sessionID) {
-        AuthenticationIP* current  = _head;
-        AuthenticationIP* previous = NULL;
-        bool              done     = false;
-        while (current) {
-            if ((ip == current->ip) && (strcmp(sessionID, current->sessionID) == 0)) {
-                //remove
-                done = true;
-                if (current == _head) {
-                    _head = current->_next;
-                    _nb_ip--;
-                    delete current;
-                    current = _head;
-                } else {
-                    previous->_next = current->_next;
-                    _nb_ip--;
-                    delete current;
-                    current = previous->_next;
-                }
-            } else {
-                previous = current;
-                current  = current->_next;
+    static bool session_expired(const AuthenticationIP* session) {
+        return session->level == AuthenticationLevel::LEVEL_GUEST || (millis() - session->last_time) > SESSION_TIMEOUT_MS;
+    }
+
+    // The slot named by the first digit of sessionID, or -1.
+    static int session_slot(const char* sessionID) {
+        char c    = sessionID[0];
+        int  slot = isdigit(c) ? c - '0' : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+        return slot < MAX_AUTH_IP ? slot : -1;
+    }
+
+    // Takes a free or expired slot for a new session, with a new ID. Returns NULL if all are in use.
+    AuthenticationIP* Web_Server::AddAuthIP(IPAddress ip, AuthenticationLevel level, const char* userID) {
+        for (int slot = 0; slot < MAX_AUTH_IP; slot++) {
+            AuthenticationIP* session = &_sessions[slot];
+            if (!session_expired(session)) {
+                continue;
             }
+            snprintf(session->sessionID, sizeof(session->sessionID), "%X%07X%08X", slot, esp_random() & 0xfffffff, esp_random());
+            strncpy(session->userID, userID, sizeof(session->userID) - 1);
+            session->userID[sizeof(session->userID) - 1] = '\0';
+            session->ip                                  = ip;
+            session->level                               = level;
+            session->last_time                           = millis();
+            return session;
+        }
+        return NULL;
+    }
+
+    bool Web_Server::ClearAuthIP(IPAddress ip, const char* sessionID) {
+        AuthenticationIP* session = GetAuth(ip, sessionID);
+        if (session == NULL) {
+            return false;
         }
-        return done;
+        session->level = AuthenticationLevel::LEVEL_GUEST;
+        return true;
     }
 
     //Get info
     AuthenticationIP* Web_Server::GetAuth(IPAddress ip, const char* sessionID) {
-        AuthenticationIP* current = _head;
-        //AuthenticationIP * previous = NULL;
-        //get time
-        //uint32_t now = millis();
-        while (current) {
-            if (ip == current->ip) {
-                if (strcmp(sessionID, current->sessionID) == 0) {
-                    //found
-                    return current;
-                }
-            }
-            //previous = current;
-            current = current->_next;
+        int slot = session_slot(sessionID);
+        if (slot < 0) {
+            return NULL;
         }
-        return NULL;
+        AuthenticationIP* session = &_sessions[slot];
+        if (session_expired(session) || ip != session->ip || !same_session(sessionID, session->sessionID)) {
+            return NULL;
+        }
+        return session;
     }
 
-    //Review all IP to reset timers
+    // The level of the session, whose time is restarted, or LEVEL_GUEST if it has expired.
     AuthenticationLevel Web_Server::ResetAuthIP(IPAddress ip, const char* sessionID) {
-        AuthenticationIP* current  = _head;
-        AuthenticationIP* previous = NULL;
-        //get time
-        //uint32_t now = millis();
-        while (current) {
-            if ((millis() - current->last_time) > 360000) {
-                //remove
-                if (current == _head) {
-                    _head = current->_next;
-                    _nb_ip--;
-                    delete current;
-                    current = _head;
-                } else {
-                    previous->_next = current->_next;
-                    _nb_ip--;
-                    delete current;
-                    current = previous->_next;
-                }
-            } else {
-                if (ip == current->ip && strcmp(sessionID, current->sessionID) == 0) {
-                    //reset time
-                    current->last_time = millis();
-                    return (AuthenticationLevel)current->level;
-                }
-                previous = current;
-                current  = current->_next;
-            }
+        AuthenticationIP* session = GetAuth(ip, sessionID);
+        if (session == NULL) {
+            return AuthenticationLevel::LEVEL_GUEST;
         }
-        return AuthenticationLevel::LEVEL_GUEST;
+        session->last_time = millis();
+        return session->level;
     }
 #    endif
 }
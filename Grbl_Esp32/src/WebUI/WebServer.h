@@ -22,19 +22,25 @@
 
 #include "../Config.h"
 #include "Commands.h"
+#include <FS.h>
 
 class WebSocketsServer;
 class WebServer;
 
 namespace WebUI {
 #ifdef ENABLE_AUTHENTICATION
+    // The sessions are slots of a fixed table. The first of the 16 hex digits of a session ID
+    // is its slot, so a request is checked against one slot, and the other 15 are random.
+    const int      MAX_AUTH_IP        = 10;      // At most 16, one hex digit
+    const uint32_t SESSION_TIMEOUT_MS = 360000;  // Since the session's last request
+    const int      SESSION_ID_LENGTH  = 16;
+
     struct AuthenticationIP {
         IPAddress           ip;
-        AuthenticationLevel level;
+        AuthenticationLevel level;  // LEVEL_GUEST when the slot is free
         char                userID[17];
-        char                sessionID[17];
+        char                sessionID[SESSION_ID_LENGTH + 1];
         uint32_t            last_time;
-        AuthenticationIP*   _next;
     };
 #endif
 
@@ -51,6 +57,7 @@ namespace WebUI {
 
         static long     get_client_ID();
         static uint16_t port() { return _port; }
+        static bool     transferring();  // A download is being sent in the background
 
         ~Web_Server();
 
@@ -65,10 +72,9 @@ namespace WebUI {
         static String              get_Splited_Value(String data, char separator, int index);
         static AuthenticationLevel is_authenticated();
 #ifdef ENABLE_AUTHENTICATION
-        static AuthenticationIP*   _head;
-        static uint8_t             _nb_ip;
-        static bool                AddAuthIP(AuthenticationIP* item);
-        static char*               create_session_ID();
+        static AuthenticationIP    _sessions[MAX_AUTH_IP];
+        static AuthenticationIP*   AddAuthIP(IPAddress ip, AuthenticationLevel level, const char* userID);
+        static bool                getSessionID(char* sessionID);
         static bool                ClearAuthIP(IPAddress ip, const char* sessionID);
         static AuthenticationIP*   GetAuth(IPAddress ip, const char* sessionID);
         static AuthenticationLevel ResetAuthIP(IPAddress ip, const char* sessionID);
@@ -82,12 +88,20 @@ namespace WebUI {
         static void _handle_web_command(bool);
         static void handle_web_command() { _handle_web_command(false); }
         static void handle_web_command_silent() { _handle_web_command(true); }
+        static void handle_web_commands();
         static void handle_Websocket_Event(uint8_t num, uint8_t type, uint8_t* payload, size_t length);
         static void SPIFFSFileupload();
         static void handleFileList();
         static void handleUpdate();
         static void WebUpdateUpload();
         static void pushError(int code, const char* st, bool web_error = 500, uint16_t timeout = 1000);
+        static bool not_modified(const String& etag);
+        static bool send_file(fs::FS& fs, String path, bool sd);
+        static bool send_asset(const String& path);
+        static bool start_transfer(File& file, bool sd);
+        static bool start_transfer(const uint8_t* data, size_t size);
+        static void handle_transfers();
+        static void end_transfers();
         static void cancelUpload();
 #ifdef ENABLE_SD_CARD
         static void handle_direct_SDFileList();
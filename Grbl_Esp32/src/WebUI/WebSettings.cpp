@@ -24,12 +24,16 @@
 
 #include <WiFi.h>
 #include <FS.h>
-#include <SPIFFS.h>
+#include "../LocalFS.h"
 #include <esp_wifi.h>
 #include <esp_ota_ops.h>
+#ifdef ENABLE_ETHERNET
+#    include <ETH.h>
+#endif
 
 #include "ESPResponse.h"
 #include "WebServer.h"
+#include "Ssdp.h"
 #include <string.h>
 
 namespace WebUI {
@@ -62,6 +66,14 @@ namespace WebUI {
         { "DHCP", DHCP_MODE },
         { "Static", STATIC_MODE },
     };
+
+    EnumSetting* wifi_profile;
+    enum_opt_t   wifiProfileOptions = {
+        { "Auto", WIFI_PROFILE_AUTO },
+        { "Streaming", WIFI_PROFILE_STREAMING },
+        { "Balanced", WIFI_PROFILE_BALANCED },
+        { "LowPower", WIFI_PROFILE_LOW_POWER },
+    };
 #endif
 
 #ifdef WIFI_OR_BLUETOOTH
@@ -275,8 +287,8 @@ namespace WebUI {
 
     static Error SPIFFSSize(char* parameter, AuthenticationLevel auth_level) {  // ESP720
         webPrint(parameter);
-        webPrint("SPIFFS  Total:", ESPResponseStream::formatBytes(SPIFFS.totalBytes()));
-        webPrintln(" Used:", ESPResponseStream::formatBytes(SPIFFS.usedBytes()));
+        webPrint("SPIFFS  Total:", ESPResponseStream::formatBytes(LocalFS.totalBytes()));
+        webPrintln(" Used:", ESPResponseStream::formatBytes(LocalFS.usedBytes()));
         return Error::Ok;
     }
 
@@ -286,7 +298,7 @@ namespace WebUI {
             return Error::InvalidValue;
         }
         webPrint("Formatting");
-        SPIFFS.format();
+        LocalFS.format();
         webPrintln("...Done");
         return Error::Ok;
     }
@@ -300,11 +312,11 @@ namespace WebUI {
         if ((path.length() > 0) && (path[0] != '/')) {
             path = "/" + path;
         }
-        if (!SPIFFS.exists(path)) {
+        if (!LocalFS.exists(path)) {
             webPrintln("Error: No such file!");
             return Error::FsFileNotFound;
         }
-        File currentfile = SPIFFS.open(path, FILE_READ);
+        File currentfile = LocalFS.open(path, FILE_READ);
         if (!currentfile) {  //if file open success
             return Error::FsFailedOpenFile;
         }
@@ -328,6 +340,27 @@ namespace WebUI {
         return accumErr;
     }
 
+    static Error checkLocalFile(char* parameter, AuthenticationLevel auth_level) {
+        if (sys.state != State::Idle) {
+            return Error::IdleError;
+        }
+        String path = trim(parameter);
+        if ((path.length() > 0) && (path[0] != '/')) {
+            path = "/" + path;
+        }
+        if (!LocalFS.exists(path)) {
+            webPrintln("Error: No such file!");
+            return Error::FsFileNotFound;
+        }
+        File file = LocalFS.open(path, FILE_READ);
+        if (!file) {
+            return Error::FsFailedOpenFile;
+        }
+        Error err = file_check(file, path.c_str(), (espresponse) ? espresponse->client() : CLIENT_ALL);
+        file.close();
+        return err;
+    }
+
     static Error showLocalFile(char* parameter, AuthenticationLevel auth_level) {  // ESP701
         if (sys.state != State::Idle && sys.state != State::Alarm) {
             return Error::IdleError;
@@ -336,11 +369,11 @@ namespace WebUI {
         if ((path.length() > 0) && (path[0] != '/')) {
             path = "/" + path;
         }
-        if (!SPIFFS.exists(path)) {
+        if (!LocalFS.exists(path)) {
             webPrintln("Error: No such file!");
             return Error::FsFileNotFound;
         }
-        File currentfile = SPIFFS.open(path, FILE_READ);
+        File currentfile = LocalFS.open(path, FILE_READ);
         if (!currentfile) {
             return Error::FsFailedOpenFile;
         }
@@ -444,7 +477,7 @@ namespace WebUI {
                 }
             }
             webPrintln("Available Size for update: ", ESPResponseStream::formatBytes(flashsize));
-            webPrintln("Available Size for SPIFFS: ", ESPResponseStream::formatBytes(SPIFFS.totalBytes()));
+            webPrintln("Available Size for SPIFFS: ", ESPResponseStream::formatBytes(LocalFS.totalBytes()));
 
 #    if defined(ENABLE_HTTP)
             webPrintln("Web port: ", String(web_server.port()));
@@ -453,6 +486,9 @@ namespace WebUI {
             webPrintln("Data port: ", String(telnet_server.port()));
 #    endif
             webPrintln("Hostname: ", wifi_config.Hostname());
+#    if defined(ENABLE_HTTP) && defined(ENABLE_SSDP)
+            webPrintln("SSDP: ", String(ssdp_answered()) + " searches answered, " + String(ssdp_dropped()) + " dropped");
+#    endif
         }
 
         webPrint("Current WiFi Mode: ");
@@ -560,6 +596,18 @@ namespace WebUI {
                 webPrintln("Off");
                 break;
         }
+#    ifdef ENABLE_ETHERNET
+        webPrint("Ethernet: ");
+        if (wifi_config.Is_Ethernet_on()) {
+            webPrintln(String(ETH.linkSpeed()) + "Mbps" + (ETH.fullDuplex() ? " full duplex" : ""));
+            print_mac("ETH", ETH.macAddress());
+            webPrintln("IP: ", ETH.localIP());
+            webPrintln("Gateway: ", ETH.gatewayIP());
+            webPrintln("Mask: ", ETH.subnetMask());
+        } else {
+            webPrintln("Not connected");
+        }
+#    endif
 #endif  // ENABLE_WIFI
 #ifdef ENABLE_BLUETOOTH
         webPrint("Current BT Mode: ");
@@ -589,6 +637,10 @@ namespace WebUI {
             webPrint("(");
             webPrint(notificationsservice.getTypeString());
             webPrint(")");
+            if (notificationsservice.dropped()) {
+                webPrint(" dropped: ");
+                webPrint(String(notificationsservice.dropped()));
+            }
         }
         webPrintln("");
 #endif
@@ -659,7 +711,7 @@ namespace WebUI {
     }
 
     static Error listSettings(char* parameter, AuthenticationLevel auth_level) {  // ESP400
-        JSONencoder j(espresponse->client() != CLIENT_WEBUI);
+        JSONencoder j(espresponse->client() != CLIENT_WEBUI, espresponse);
         j.begin();
         j.begin_array("EEPROM");
         for (Setting* js = Setting::List; js; js = js->next()) {
@@ -668,12 +720,14 @@ namespace WebUI {
             }
         }
         j.end_array();
-        webPrint(j.end());
+        j.end();
         return Error::Ok;
     }
 
 #ifdef ENABLE_SD_CARD
-    static Error openSDFile(char* parameter) {
+    // For a job, the file is scanned for a time estimate if $SD/EstimateTime is on, and its compiled
+    // copy is opened if $SD/BinaryCache is on, compiling it first if needed.
+    static Error openSDFile(char* parameter, bool job = false) {
         if (*parameter == '\0') {
             webPrintln("Missing file name!");
             return Error::InvalidValue;
@@ -692,11 +746,34 @@ namespace WebUI {
                 return Error::FsFailedBusy;
             }
         }
-        if (!openFile(SD, path.c_str())) {
+        uint8_t client   = (espresponse) ? espresponse->client() : CLIENT_ALL;
+        String  source   = path;  // The log goes beside this, not beside a compiled copy
+        bool    compiled = false;
+        bool    packed   = sd_is_compressed(path.c_str());  // Neither scanned nor compiled; both read it raw
+        if (job && sd_estimate_time->get() && !packed && !path.endsWith(SD_CACHE_EXTENSION)) {
+            set_sd_state(SDState::BusyParsing);
+            sd_estimate_scan(sd_fs(), path.c_str(), client);
+            set_sd_state(SDState::Idle);
+        }
+        if (job && path.endsWith(SD_CACHE_EXTENSION)) {
+            compiled = true;  // Already a compiled copy
+        } else if (job && sd_binary_cache->get() && !packed) {
+            String cache_path;
+            compiled = sd_cache_current(sd_fs(), path.c_str(), cache_path) ||
+                       sd_cache_compile(sd_fs(), path.c_str(), cache_path, client) == Error::Ok;
+            if (compiled) {
+                path = cache_path;
+            }
+        }
+        if (!openFile(sd_fs(), path.c_str(), compiled)) {
+            sd_estimate_clear();
             report_status_message(Error::FsFailedRead, (espresponse) ? espresponse->client() : CLIENT_ALL);
             webPrintln("");
             return Error::FsFailedOpenFile;
         }
+        if (job) {
+            job_log_start_job(source.c_str(), client);
+        }
         return Error::Ok;
     }
     static Error showSDFile(char* parameter, AuthenticationLevel auth_level) {  // ESP221
@@ -727,7 +804,21 @@ namespace WebUI {
             webPrintln("Busy");
             return Error::IdleError;
         }
-        if ((err = openSDFile(parameter)) != Error::Ok) {
+        // path,line resumes the job at that line
+        uint32_t resume_line = 0;
+        char*    comma       = strrchr(parameter, ',');
+        if (comma && comma[1] && strspn(comma + 1, "0123456789") == strlen(comma + 1)) {
+            resume_line = atoi(comma + 1);
+            *comma      = '\0';
+        }
+        if ((err = openSDFile(parameter, true)) != Error::Ok) {
+            return err;
+        }
+        SD_client     = (espresponse) ? espresponse->client() : CLIENT_ALL;
+        SD_auth_level = auth_level;
+        if (resume_line > 1 && (err = sd_resume_at_line(resume_line, SD_client)) != Error::Ok) {
+            closeFile();
+            webPrintln("");
             return err;
         }
         char fileLine[255];
@@ -737,15 +828,75 @@ namespace WebUI {
             webPrintln("");
             return Error::Ok;
         }
-        SD_client     = (espresponse) ? espresponse->client() : CLIENT_ALL;
-        SD_auth_level = auth_level;
         // execute the first line now; Protocol.cpp handles later ones when SD_ready_next
-        report_status_message(execute_line(fileLine, SD_client, SD_auth_level), SD_client);
+        report_status_message(sd_execute_line(fileLine, SD_client, SD_auth_level), SD_client);
         report_realtime_status(SD_client);
         webPrintln("");
         return Error::Ok;
     }
 
+    // With a path, adds it to the jobs run after the current one, else lists them.
+    static Error queueSDFile(char* parameter, AuthenticationLevel auth_level) {
+        parameter = trim(parameter);
+        if (*parameter == '\0') {
+            for (int i = 0; i < sd_queue_count(); i++) {
+                webPrintln(sd_queue_path(i));
+            }
+            return Error::Ok;
+        }
+        if (!sd_queue_add(parameter)) {
+            webPrintln("Queue full");
+            return Error::InvalidValue;
+        }
+        return Error::Ok;
+    }
+
+    static Error clearSDQueue(char* parameter, AuthenticationLevel auth_level) {
+        sd_queue_clear();
+        return Error::Ok;
+    }
+
+    // With a path, logs a job that is about to be streamed there until SD/JobLog/Stop. SD jobs
+    // are logged beside their files without it. Without a path, tells whether a log is open.
+    static Error startJobLog(char* parameter, AuthenticationLevel auth_level) {
+        parameter = trim(parameter);
+        if (*parameter == '\0') {
+            webPrintln(job_log_active() ? "Logging" : "Not logging");
+            return Error::Ok;
+        }
+        if (sd_job_log_period->get() == 0) {
+            webPrintln("$SD/JobLog is 0");
+            return Error::InvalidValue;
+        }
+        String path = parameter;
+        if (path[0] != '/') {
+            path = "/" + path;
+        }
+        if (!job_log_start(path.c_str(), (espresponse) ? espresponse->client() : CLIENT_ALL)) {
+            webPrintln("Cannot open log");
+            return Error::FsFailedOpenFile;
+        }
+        return Error::Ok;
+    }
+
+    static Error stopJobLog(char* parameter, AuthenticationLevel auth_level) {
+        job_log_stop();
+        return Error::Ok;
+    }
+
+    // Runs the first queued job; the rest follow it.
+    static Error runSDQueue(char* parameter, AuthenticationLevel auth_level) {
+        String path;
+        if (!sd_queue_pop(path)) {
+            webPrintln("Queue empty");
+            return Error::InvalidValue;
+        }
+        char buf[LINE_BUFFER_SIZE];
+        strncpy(buf, path.c_str(), sizeof(buf) - 1);
+        buf[sizeof(buf) - 1] = '\0';
+        return runSDFile(buf, auth_level);
+    }
+
     static Error deleteSDObject(char* parameter, AuthenticationLevel auth_level) {  // ESP215
         parameter = trim(parameter);
         if (*parameter == '\0') {
@@ -761,19 +912,20 @@ namespace WebUI {
         if (parameter[0] != '/') {
             path = "/" + path;
         }
-        File file2del = SD.open(path);
+        sd_dir_index_invalidate();
+        File file2del = sd_fs().open(path);
         if (!file2del) {
             webPrintln("Cannot stat file!");
             return Error::FsFileNotFound;
         }
         if (file2del.isDirectory()) {
-            if (!SD.rmdir(path)) {
+            if (!sd_fs().rmdir(path)) {
                 webPrintln("Cannot delete directory! Is directory empty?");
                 return Error::FsFailedDelDir;
             }
             webPrintln("Directory deleted.");
         } else {
-            if (!SD.remove(path)) {
+            if (!sd_fs().remove(path)) {
                 webPrintln("Cannot delete file!");
                 return Error::FsFailedDelFile;
             }
@@ -783,6 +935,60 @@ namespace WebUI {
         return Error::Ok;
     }
 
+    static Error compileSDFile(char* parameter, AuthenticationLevel auth_level) {
+        if (sys.state != State::Idle && sys.state != State::Alarm) {
+            return Error::IdleError;
+        }
+        parameter = trim(parameter);
+        if (*parameter == '\0') {
+            webPrintln("Missing file name!");
+            return Error::InvalidValue;
+        }
+        SDState state = get_sd_state(true);
+        if (state != SDState::Idle) {
+            webPrintln((state == SDState::NotPresent) ? "No SD card" : "Busy");
+            return (state == SDState::NotPresent) ? Error::FsFailedMount : Error::FsFailedBusy;
+        }
+        String path = parameter;
+        if (parameter[0] != '/') {
+            path = "/" + path;
+        }
+        set_sd_state(SDState::BusyParsing);
+        Error err = sd_cache_compile(sd_fs(), path.c_str(), path + SD_CACHE_EXTENSION, (espresponse) ? espresponse->client() : CLIENT_ALL);
+        set_sd_state(SDState::Idle);
+        return err;
+    }
+
+    static Error checkSDFile(char* parameter, AuthenticationLevel auth_level) {
+        if (sys.state != State::Idle) {
+            return Error::IdleError;
+        }
+        parameter = trim(parameter);
+        if (*parameter == '\0') {
+            webPrintln("Missing file name!");
+            return Error::InvalidValue;
+        }
+        SDState state = get_sd_state(true);
+        if (state != SDState::Idle) {
+            webPrintln((state == SDState::NotPresent) ? "No SD card" : "Busy");
+            return (state == SDState::NotPresent) ? Error::FsFailedMount : Error::FsFailedBusy;
+        }
+        String path = parameter;
+        if (parameter[0] != '/') {
+            path = "/" + path;
+        }
+        File file = sd_fs().open(path, FILE_READ);
+        if (!file) {
+            webPrintln("Error: No such file!");
+            return Error::FsFileNotFound;
+        }
+        set_sd_state(SDState::BusyParsing);
+        Error err = file_check(file, path.c_str(), (espresponse) ? espresponse->client() : CLIENT_ALL);
+        file.close();
+        set_sd_state(SDState::Idle);
+        return err;
+    }
+
     static Error listSDFiles(char* parameter, AuthenticationLevel auth_level) {  // ESP210
         SDState state = get_sd_state(true);
         if (state != SDState::Idle) {
@@ -795,13 +1001,13 @@ namespace WebUI {
             }
         }
         webPrintln("");
-        listDir(SD, "/", 10, espresponse->client());
-        String ssd = "[SD Free:" + ESPResponseStream::formatBytes(SD.totalBytes() - SD.usedBytes());
-        ssd += " Used:" + ESPResponseStream::formatBytes(SD.usedBytes());
-        ssd += " Total:" + ESPResponseStream::formatBytes(SD.totalBytes());
+        listDir(sd_fs(), "/", 10, espresponse->client());
+        String ssd = "[SD Free:" + ESPResponseStream::formatBytes(sd_total_bytes() - sd_used_bytes());
+        ssd += " Used:" + ESPResponseStream::formatBytes(sd_used_bytes());
+        ssd += " Total:" + ESPResponseStream::formatBytes(sd_total_bytes());
         ssd += "]";
         webPrintln(ssd);
-        SD.end();
+        sd_unmount();
         return Error::Ok;
     }
 #endif
@@ -834,10 +1040,10 @@ namespace WebUI {
 
     static Error listLocalFiles(char* parameter, AuthenticationLevel auth_level) {  // No ESP command
         webPrintln("");
-        listDirLocalFS(SPIFFS, "/", 10, espresponse->client());
-        String ssd = "[Local FS Free:" + ESPResponseStream::formatBytes(SPIFFS.totalBytes() - SPIFFS.usedBytes());
-        ssd += " Used:" + ESPResponseStream::formatBytes(SPIFFS.usedBytes());
-        ssd += " Total:" + ESPResponseStream::formatBytes(SPIFFS.totalBytes());
+        listDirLocalFS(LocalFS, "/", 10, espresponse->client());
+        String ssd = "[Local FS Free:" + ESPResponseStream::formatBytes(LocalFS.totalBytes() - LocalFS.usedBytes());
+        ssd += " Used:" + ESPResponseStream::formatBytes(LocalFS.usedBytes());
+        ssd += " Total:" + ESPResponseStream::formatBytes(LocalFS.totalBytes());
         ssd += "]";
         webPrintln(ssd);
         return Error::Ok;
@@ -864,15 +1070,15 @@ namespace WebUI {
     }
 
     static Error listLocalFilesJSON(char* parameter, AuthenticationLevel auth_level) {  // No ESP command
-        JSONencoder j(espresponse->client() != CLIENT_WEBUI);
+        JSONencoder j(espresponse->client() != CLIENT_WEBUI, espresponse);
         j.begin();
         j.begin_array("files");
-        listDirJSON(SPIFFS, "/", 4, &j);
+        listDirJSON(LocalFS, "/", 4, &j);
         j.end_array();
-        j.member("total", SPIFFS.totalBytes());
-        j.member("used", SPIFFS.usedBytes());
-        j.member("occupation", String(100 * SPIFFS.usedBytes() / SPIFFS.totalBytes()));
-        webPrint(j.end());
+        j.member("total", LocalFS.totalBytes());
+        j.member("used", LocalFS.usedBytes());
+        j.member("occupation", String(100 * LocalFS.usedBytes() / LocalFS.totalBytes()));
+        j.end();
         if (espresponse->client() != CLIENT_WEBUI) {
             webPrintln("");
         }
@@ -1056,6 +1262,7 @@ namespace WebUI {
         new WebCommand("FORMAT", WEBCMD, WA, "ESP710", "LocalFS/Format", formatSpiffs);
         new WebCommand("path", WEBCMD, WU, "ESP701", "LocalFS/Show", showLocalFile);
         new WebCommand("path", WEBCMD, WU, "ESP700", "LocalFS/Run", runLocalFile);
+        new WebCommand("path", WEBCMD, WU, NULL, "LocalFS/Check", checkLocalFile);
         new WebCommand("path", WEBCMD, WU, NULL, "LocalFS/List", listLocalFiles);
         new WebCommand("path", WEBCMD, WU, NULL, "LocalFS/ListJSON", listLocalFilesJSON);
 #endif
@@ -1080,8 +1287,15 @@ namespace WebUI {
 #endif
 #ifdef ENABLE_SD_CARD
         new WebCommand("path", WEBCMD, WU, "ESP221", "SD/Show", showSDFile);
-        new WebCommand("path", WEBCMD, WU, "ESP220", "SD/Run", runSDFile);
+        new WebCommand("path[,line]", WEBCMD, WU, "ESP220", "SD/Run", runSDFile);
         new WebCommand("file_or_directory_path", WEBCMD, WU, "ESP215", "SD/Delete", deleteSDObject);
+        new WebCommand("path", WEBCMD, WU, NULL, "SD/Compile", compileSDFile);
+        new WebCommand("path", WEBCMD, WU, NULL, "SD/Check", checkSDFile);
+        new WebCommand("path", WEBCMD, WU, NULL, "SD/Queue", queueSDFile, anyState);
+        new WebCommand(NULL, WEBCMD, WU, NULL, "SD/Queue/Clear", clearSDQueue, anyState);
+        new WebCommand(NULL, WEBCMD, WU, NULL, "SD/Queue/Run", runSDQueue);
+        new WebCommand("path", WEBCMD, WU, NULL, "SD/JobLog/Start", startJobLog);
+        new WebCommand(NULL, WEBCMD, WU, NULL, "SD/JobLog/Stop", stopJobLog, anyState);
         new WebCommand(NULL, WEBCMD, WU, "ESP210", "SD/List", listSDFiles);
 #endif
 #ifdef WEB_COMMON
@@ -1166,6 +1380,8 @@ namespace WebUI {
         http_port =
             new IntSetting("HTTP Port", WEBSET, WA, "ESP121", "Http/Port", DEFAULT_WEBSERVER_PORT, MIN_HTTP_PORT, MAX_HTTP_PORT, NULL);
         http_enable   = new EnumSetting("HTTP Enable", WEBSET, WA, "ESP120", "Http/Enable", DEFAULT_HTTP_STATE, &onoffOptions, NULL);
+        wifi_profile =
+            new EnumSetting("WiFi power profile", WEBSET, WA, NULL, "WiFi/Power", DEFAULT_WIFI_PROFILE, &wifiProfileOptions, NULL);
         wifi_hostname = new StringSetting("Hostname",
                                           WEBSET,
                                           WA,
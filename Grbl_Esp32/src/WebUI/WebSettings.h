@@ -42,6 +42,7 @@ namespace WebUI {
     extern IntSetting*    http_port;
     extern EnumSetting*   telnet_enable;
     extern IntSetting*    telnet_port;
+    extern EnumSetting*   wifi_profile;
 #endif
 
 #ifdef WIFI_OR_BLUETOOTH
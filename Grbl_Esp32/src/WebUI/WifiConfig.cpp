@@ -29,12 +29,33 @@
 #    include <SPIFFS.h>
 #    include <cstring>
 #    include "WifiServices.h"
+#    ifdef ENABLE_ETHERNET
+#        include <ETH.h>
+#    endif
 
 namespace WebUI {
     WiFiConfig wifi_config;
 
-    String WiFiConfig::_hostname          = "";
-    bool   WiFiConfig::_events_registered = false;
+    String   WiFiConfig::_hostname          = "";
+    bool     WiFiConfig::_events_registered = false;
+    int      WiFiConfig::_profile           = -1;
+    uint32_t WiFiConfig::_busy_ms           = 0;
+    bool     WiFiConfig::_eth_started       = false;
+    bool     WiFiConfig::_eth_connected     = false;
+    bool     WiFiConfig::_eth_services      = false;
+
+    // Power save and transmit power by profile. Modem sleep holds the radio off for up to a
+    // beacon interval, so it adds that much, and a varying amount, to every response.
+    typedef struct {
+        wifi_ps_type_t power_save;
+        wifi_power_t   tx_power;
+    } wifi_profile_t;
+    static const wifi_profile_t wifi_profiles[] = {
+        { WIFI_PS_NONE, WIFI_POWER_19_5dBm },       // WIFI_PROFILE_AUTO, not used
+        { WIFI_PS_NONE, WIFI_POWER_19_5dBm },       // WIFI_PROFILE_STREAMING
+        { WIFI_PS_MIN_MODEM, WIFI_POWER_19_5dBm },  // WIFI_PROFILE_BALANCED
+        { WIFI_PS_MAX_MODEM, WIFI_POWER_11dBm },    // WIFI_PROFILE_LOW_POWER
+    };
 
     WiFiConfig::WiFiConfig() {}
 
@@ -215,6 +236,26 @@ namespace WebUI {
             case SYSTEM_EVENT_STA_DISCONNECTED:
                 grbl_send(CLIENT_ALL, "[MSG:Disconnected]\r\n");
                 break;
+#    ifdef ENABLE_ETHERNET
+            case SYSTEM_EVENT_ETH_START:
+                ETH.setHostname(_hostname.c_str());
+                break;
+            case SYSTEM_EVENT_ETH_GOT_IP:
+                grbl_sendf(CLIENT_ALL,
+                           "[MSG:Ethernet connected with %s, %dMbps%s]\r\n",
+                           ETH.localIP().toString().c_str(),
+                           ETH.linkSpeed(),
+                           ETH.fullDuplex() ? " full duplex" : "");
+                _eth_connected = true;
+                break;
+            case SYSTEM_EVENT_ETH_DISCONNECTED:
+            case SYSTEM_EVENT_ETH_STOP:
+                if (_eth_connected) {
+                    grbl_send(CLIENT_ALL, "[MSG:Ethernet disconnected]\r\n");
+                }
+                _eth_connected = false;
+                break;
+#    endif
             default:
                 break;
         }
@@ -286,6 +327,7 @@ namespace WebUI {
         }
         WiFi.enableAP(false);
         WiFi.mode(WIFI_STA);
+        _profile = -1;
         //Get parameters for STA
         String h = wifi_hostname->get();
         WiFi.setHostname(h.c_str());
@@ -331,6 +373,7 @@ namespace WebUI {
         }
         WiFi.enableSTA(false);
         WiFi.mode(WIFI_AP);
+        _profile = -1;
         //Get parameters for AP
         //SSID
         String SSID = wifi_ap_ssid->get();
@@ -374,6 +417,7 @@ namespace WebUI {
             WiFi.softAPdisconnect(true);
         }
         wifi_services.end();
+        _eth_services = false;
         WiFi.enableSTA(false);
         WiFi.enableAP(false);
         WiFi.mode(WIFI_OFF);
@@ -392,9 +436,19 @@ namespace WebUI {
             WiFi.onEvent(WiFiConfig::WiFiEvent);
             _events_registered = true;
         }
+        _eth_services = false;
         //Get hostname
         _hostname       = wifi_hostname->get();
         int8_t wifiMode = wifi_radio_mode->get();
+#    ifdef ENABLE_ETHERNET
+        // The PHY keeps running across WiFi restarts; the services listen on every interface.
+        if (!_eth_started) {
+            _eth_started = ETH.begin();
+            if (!_eth_started) {
+                grbl_send(CLIENT_ALL, "[MSG:Ethernet failed to start]\r\n");
+            }
+        }
+#    endif
         if (wifiMode == ESP_WIFI_AP) {
             StartAP();
             //start services
@@ -440,9 +494,37 @@ namespace WebUI {
     void WiFiConfig::handle() {
         //Services
         COMMANDS::wait(0);
+        applyProfile();
+        // With the radio off, the services start once Ethernet has an address.
+        if (!_eth_services && !Is_WiFi_on() && Is_Ethernet_on()) {
+            _eth_services = wifi_services.begin();
+        }
         wifi_services.handle();
     }
 
+    // Sets the radio to the chosen profile, or for Auto to the one the machine state calls for.
+    // Only station mode sleeps, but the transmit power applies to both.
+    void WiFiConfig::applyProfile() {
+        if (WiFi.getMode() == WIFI_OFF) {
+            return;
+        }
+        int profile = wifi_profile->get();
+        if (profile == WIFI_PROFILE_AUTO) {
+            State    state = sys.state;
+            uint32_t now   = millis();
+            if (state == State::Cycle || state == State::Hold || state == State::Jog || state == State::Homing) {
+                _busy_ms = now;
+            }
+            profile = (_busy_ms && now - _busy_ms < WIFI_PROFILE_IDLE_MS) ? WIFI_PROFILE_STREAMING : WIFI_PROFILE_BALANCED;
+        }
+        if (profile == _profile || profile < 0 || profile >= int(sizeof(wifi_profiles) / sizeof(wifi_profiles[0]))) {
+            return;
+        }
+        _profile = profile;
+        esp_wifi_set_ps(wifi_profiles[profile].power_save);
+        WiFi.setTxPower(wifi_profiles[profile].tx_power);
+    }
+
     WiFiConfig::~WiFiConfig() { end(); }
 }
 #endif  // ENABLE_WIFI
@@ -35,6 +35,13 @@ namespace WebUI {
     static const int DHCP_MODE   = 0;
     static const int STATIC_MODE = 1;
 
+    // WiFi/Power profiles. Auto streams while the machine is busy and goes back to balanced
+    // once it has been idle for WIFI_PROFILE_IDLE_MS.
+    static const int WIFI_PROFILE_AUTO      = 0;
+    static const int WIFI_PROFILE_STREAMING = 1;  // No modem sleep, full transmit power
+    static const int WIFI_PROFILE_BALANCED  = 2;  // Modem sleep between beacons
+    static const int WIFI_PROFILE_LOW_POWER = 3;  // Longest modem sleep, reduced transmit power
+
     //Switch
     static const int ESP_SAVE_ONLY = 0;
     static const int ESP_APPLY_NOW = 1;
@@ -64,6 +71,8 @@ namespace WebUI {
     static const char* HIDDEN_PASSWORD           = "********";
     static const char* DEFAULT_TOKEN             = "";
     static const int   DEFAULT_NOTIFICATION_TYPE = 0;
+    static const int   DEFAULT_WIFI_PROFILE      = WIFI_PROFILE_AUTO;
+    static const int   WIFI_PROFILE_IDLE_MS      = 5000;
 
     //boundaries
     static const int MAX_SSID_LENGTH     = 32;
@@ -106,14 +115,22 @@ namespace WebUI {
         static void        handle();
         static void        reset_settings();
         static bool        Is_WiFi_on();
+        static bool        Is_Ethernet_on() { return _eth_connected; }
+        static bool        Is_Network_on() { return Is_WiFi_on() || Is_Ethernet_on(); }
 
         ~WiFiConfig();
 
     private:
-        static bool   ConnectSTA2AP();
-        static void   WiFiEvent(WiFiEvent_t event);
-        static String _hostname;
-        static bool   _events_registered;
+        static bool     ConnectSTA2AP();
+        static void     WiFiEvent(WiFiEvent_t event);
+        static void     applyProfile();
+        static String   _hostname;
+        static bool     _events_registered;
+        static int      _profile;  // The profile the radio is set to, -1 to set it again
+        static uint32_t _busy_ms;  // When the machine was last seen busy, 0 for never
+        static bool     _eth_started;
+        static bool     _eth_connected;  // Link up with an address
+        static bool     _eth_services;   // The services were started for Ethernet alone
     };
 
     extern WiFiConfig wifi_config;
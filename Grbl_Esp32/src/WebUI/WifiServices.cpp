@@ -24,7 +24,7 @@
 
 #    include <WiFi.h>
 #    include <FS.h>
-#    include <SPIFFS.h>
+#    include "../LocalFS.h"
 #    include "WifiServices.h"
 #    ifdef ENABLE_MDNS
 #        include <ESPmDNS.h>
@@ -38,6 +38,9 @@
 #    ifdef ENABLE_TELNET
 #        include "TelnetServer.h"
 #    endif
+#    ifdef ENABLE_TCP_STREAM
+#        include "TcpStream.h"
+#    endif
 #    ifdef ENABLE_NOTIFICATIONS
 #        include "NotificationsService.h"
 #    endif
@@ -52,13 +55,13 @@ namespace WebUI {
     bool WiFiServices::begin() {
         bool no_error = true;
         //Sanity check
-        if (WiFi.getMode() == WIFI_OFF) {
+        if (!WiFiConfig::Is_Network_on()) {
             return false;
         }
         String h = wifi_hostname->get();
 
         //Start SPIFFS
-        SPIFFS.begin(true);
+        localfs_mount();
 #    ifdef ENABLE_OTA
         ArduinoOTA
             .onStart([]() {
@@ -66,9 +69,9 @@ namespace WebUI {
                 if (ArduinoOTA.getCommand() == U_FLASH) {
                     type = "sketch";
                 } else {  // U_SPIFFS
-                    // NOTE: if updating SPIFFS this would be the place to unmount SPIFFS using SPIFFS.end()
+                    // NOTE: if updating SPIFFS this would be the place to unmount SPIFFS using LocalFS.end()
                     type = "filesystem";
-                    SPIFFS.end();
+                    LocalFS.end();
                 }
                 grbl_sendf(CLIENT_ALL, "[MSG:Start OTA updating %s]\r\n", type.c_str());
             })
@@ -100,7 +103,7 @@ namespace WebUI {
 #    endif
 #    ifdef ENABLE_MDNS
         //no need in AP mode
-        if (WiFi.getMode() == WIFI_STA) {
+        if (WiFi.getMode() == WIFI_STA || WiFiConfig::Is_Ethernet_on()) {
             //start mDns
             if (!MDNS.begin(h.c_str())) {
                 grbl_send(CLIENT_ALL, "[MSG:Cannot start mDNS]\r\n");
@@ -116,17 +119,25 @@ namespace WebUI {
 #    ifdef ENABLE_TELNET
         telnet_server.begin();
 #    endif
+#    ifdef ENABLE_TCP_STREAM
+        TcpStream.begin();
+#    endif
 #    ifdef ENABLE_NOTIFICATIONS
         notificationsservice.begin();
 #    endif
         //be sure we are not is mixed mode in setup
-        WiFi.scanNetworks(true);
+        if (WiFi.getMode() != WIFI_OFF) {
+            WiFi.scanNetworks(true);
+        }
         return no_error;
     }
     void WiFiServices::end() {
 #    ifdef ENABLE_NOTIFICATIONS
         notificationsservice.end();
 #    endif
+#    ifdef ENABLE_TCP_STREAM
+        TcpStream.end();
+#    endif
 #    ifdef ENABLE_TELNET
         telnet_server.end();
 #    endif
@@ -138,7 +149,7 @@ namespace WebUI {
         ArduinoOTA.end();
 #    endif
         //Stop SPIFFS
-        SPIFFS.end();
+        LocalFS.end();
 #    ifdef ENABLE_MDNS
         //Stop mDNS
         MDNS.end();
@@ -23,14 +23,18 @@ if '-q' in sys.argv:
 if '-u' in sys.argv:
     sys.argv.remove('-u')
     extraArgs = '--target=upload'
+tiny = '-t' in sys.argv
+if tiny:
+    sys.argv.remove('-t')
 
 exitCode = 255
 if len(sys.argv) == 2:
-    exitCode = buildMachine(sys.argv[1], verbose=verbose, extraArgs=extraArgs)
+    exitCode = buildMachine(sys.argv[1], verbose=verbose, extraArgs=extraArgs, tiny=tiny)
 else:
-    print("Usage: ./build-machine.py [-q] [-u] machine_name.h")
+    print("Usage: ./build-machine.py [-q] [-u] [-t] machine_name.h")
     print(' Build for the given machine regardless of machine.h')
     print('  -q suppresses most messages')
     print('  -u uploads to the target after compilation')
+    print('  -t builds the tiny profile, without the radio and network services')
 
 sys.exit(exitCode)
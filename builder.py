@@ -3,17 +3,20 @@
 # The verbose argument controls whether the full output is
 # displayed, or filtered to show only summary information.
 # extraArgs can be used to perform uploading after compilation.
+# tiny builds the tiny environment of platformio.ini instead of the default one.
 
 from __future__ import print_function
 import subprocess, os
 
 env = dict(os.environ)
 
-def buildMachine(baseName, verbose=True, extraArgs=None):
+def buildMachine(baseName, verbose=True, extraArgs=None, tiny=False):
     cmd = ['platformio','run']
+    if tiny:
+        cmd += ['-e', 'tiny']
     if extraArgs:
         cmd.append(extraArgs)
-    displayName = baseName
+    displayName = baseName + (' (tiny)' if tiny else '')
     flags = '-DMACHINE_FILENAME=' + baseName
     print('Building machine ' + displayName)
     env['PLATFORMIO_BUILD_FLAGS'] = flags
@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Turns a Grbl_ESP32 job log into CSV and sums it up.
+
+The firmware writes the log beside an SD job, as <job>.tlm, when $SD/JobLog is the number of
+milliseconds between records, or wherever $SD/JobLog/Start=<path> puts it for a streamed job.
+See Grbl_Esp32/src/JobLog.h for the format.
+
+    job_log.py part.nc.tlm > part.csv
+    job_log.py --summary part.nc.tlm
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+HEADER = struct.Struct("<4sBBH")
+RECORD = struct.Struct("<IIHHHHBBBb")
+FIELDS = ("time_ms", "line", "feed", "programmed", "isr_max_us", "rx_used", "planner", "segments", "state", "rssi")
+STATES = ("Idle", "Alarm", "Check", "Home", "Run", "Hold", "Jog", "Door", "Sleep")
+
+
+def records(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    magic, version, size, period = HEADER.unpack_from(data)
+    if magic != b"GTLM" or size < RECORD.size:
+        raise SystemExit("%s is not a job log" % path)
+    offset = HEADER.size
+    out = []
+    while offset + size <= len(data):
+        out.append(dict(zip(FIELDS, RECORD.unpack_from(data, offset))))
+        offset += size
+    return period, out
+
+
+def state_name(state):
+    return STATES[state] if state < len(STATES) else str(state)
+
+
+def summary(period, log):
+    running = [r for r in log if r["state"] == 4]
+    print("%d records %d ms apart, %.1f s" % (len(log), period, log[-1]["time_ms"] / 1000.0 if log else 0))
+    if not running:
+        return
+    slow = [r for r in running if r["programmed"] and r["feed"] < 0.9 * r["programmed"]]
+    gaps = [(b["time_ms"] - a["time_ms"], b) for a, b in zip(log, log[1:]) if b["time_ms"] - a["time_ms"] > 2 * period]
+    print("running %.1f s, below 90%% of the programmed feed %.1f s" % (len(running) * period / 1000.0, len(slow) * period / 1000.0))
+    planner_empty = sum(1 for r in running if r["planner"] == 0)
+    segments_empty = sum(1 for r in running if r["segments"] == 0)
+    print("planner empty in %d records, segment buffer empty in %d" % (planner_empty, segments_empty))
+    print("longest stepper interrupt %d us" % max(r["isr_max_us"] for r in running))
+    rssi = [r["rssi"] for r in running if r["rssi"]]
+    if rssi:
+        print("WiFi %d to %d dBm" % (min(rssi), max(rssi)))
+    for gap, r in gaps[:10]:
+        print("main loop held up %d ms before %.1f s, line %d" % (gap, r["time_ms"] / 1000.0, r["line"]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log")
+    parser.add_argument("--summary", action="store_true", help="sum the log up instead of writing CSV")
+    args = parser.parse_args()
+
+    period, log = records(args.log)
+    if args.summary:
+        summary(period, log)
+        return 0
+    writer = csv.writer(sys.stdout)
+    writer.writerow(FIELDS)
+    for r in log:
+        writer.writerow([state_name(r[f]) if f == "state" else r[f] for f in FIELDS])
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""Packs a directory of WebUI files into the image of the "webui" flash partition.
+
+Every file is stored gzip'd, under its path without a .gz suffix, and a file that is
+already a .gz is stored as it is. See Grbl_Esp32/src/WebUI/FlashAssets.h for the format,
+and webui_assets.csv for the partition, which is written with esptool:
+
+    webui_assets.py Grbl_Esp32/data webui.bin
+    esptool.py write_flash 0x390000 webui.bin
+"""
+
+import argparse
+import gzip
+import os
+import struct
+import sys
+import zlib
+
+MAGIC = 0x41495557  # "WUIA"
+VERSION = 1
+HEADER = struct.Struct("<IHH")
+ENTRY = struct.Struct("<56sIII")
+PATH_MAX = 56
+PARTITION_SIZE = 0x40000
+
+
+def assets(root):
+    out = {}
+    for folder, _, files in os.walk(root):
+        for name in files:
+            full = os.path.join(folder, name)
+            path = "/" + os.path.relpath(full, root).replace(os.sep, "/")
+            with open(full, "rb") as f:
+                data = f.read()
+            if path.endswith(".gz"):
+                path = path[:-3]
+            else:
+                data = gzip.compress(data, 9, mtime=0)
+            if len(path.encode()) >= PATH_MAX:
+                raise SystemExit("%s: the path is longer than %d bytes" % (path, PATH_MAX - 1))
+            if path in out:
+                raise SystemExit("%s is there both gzip'd and not" % path)
+            out[path] = data
+    return out
+
+
+def image(files):
+    paths = sorted(files, key=lambda p: p.encode())  # The firmware searches with strcmp()
+    offset = HEADER.size + len(paths) * ENTRY.size
+    index = b""
+    body = b""
+    for path in paths:
+        data = files[path]
+        index += ENTRY.pack(path.encode(), offset + len(body), len(data), zlib.crc32(data))
+        body += data
+    return HEADER.pack(MAGIC, VERSION, len(paths)) + index + body
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("root", help="directory of the files, served from /")
+    parser.add_argument("image")
+    parser.add_argument("--size", type=lambda s: int(s, 0), default=PARTITION_SIZE, help="partition size, 0x40000 by default")
+    args = parser.parse_args()
+
+    files = assets(args.root)
+    data = image(files)
+    if len(data) > args.size:
+        raise SystemExit("%d bytes do not fit in the %d of the partition" % (len(data), args.size))
+    with open(args.image, "wb") as f:
+        f.write(data)
+    for path in sorted(files):
+        print("%-40s %7d" % (path, len(files[path])))
+    print("%d files, %d of %d bytes" % (len(files), len(data), args.size))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
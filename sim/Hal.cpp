@@ -0,0 +1,821 @@
+/*
+  Hal.cpp - Host implementation of the ESP32 core, ESP-IDF and FreeRTOS calls Grbl makes
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Sim.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <SPIFFS.h>
+#include <nvs.h>
+#include <esp_heap_caps.h>
+#include <driver/timer.h>
+#include <driver/uart.h>
+#include <soc/gpio_struct.h>
+#include <soc/ledc_struct.h>
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+// Time and timers
+
+static int64_t now_us = 0;
+static bool    in_isr = false;
+
+int64_t sim_now() {
+    return now_us;
+}
+
+bool sim_in_isr() {
+    return in_isr;
+}
+
+uint64_t sim_host_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// A timer group timer. It counts at 80 MHz over the divider and, with auto reload, restarts
+// from zero at each alarm, so the next alarm is always counted from the last one.
+struct SimTimer {
+    void (*handler)(void*);
+    void*    arg;
+    uint32_t divider;
+    uint64_t alarm;
+    bool     running;
+    double   zero_us;  // When the counter was last zero
+
+    double due() const { return zero_us + double(alarm ? alarm : 1) * divider / 80.0; }
+};
+
+static SimTimer timers[TIMER_GROUP_MAX][TIMER_MAX];
+
+timg_dev_t TIMERG0;
+timg_dev_t TIMERG1;
+
+static timg_dev_t& timer_regs(timer_group_t group) {
+    return group == TIMER_GROUP_0 ? TIMERG0 : TIMERG1;
+}
+
+// An esp_timer, for the spindle encoder sampler.
+struct esp_timer {
+    void (*callback)(void*);
+    void*    arg;
+    uint64_t period;
+    int64_t  due;
+    bool     running;
+};
+
+static std::vector<esp_timer*> esp_timers;
+
+void sim_run(int64_t until_us) {
+    for (;;) {
+        SimTimer* next     = nullptr;
+        double    next_due = double(until_us);
+        for (auto& group : timers) {
+            for (auto& t : group) {
+                if (t.running && t.handler && t.due() <= next_due) {
+                    next     = &t;
+                    next_due = t.due();
+                }
+            }
+        }
+        esp_timer* next_esp = nullptr;
+        for (auto t : esp_timers) {
+            if (t->running && t->due <= next_due) {
+                next_esp = t;
+                next_due = t->due;
+                next     = nullptr;
+            }
+        }
+        if (!next && !next_esp) {
+            break;
+        }
+        if (int64_t(next_due) > now_us) {
+            now_us = int64_t(next_due);
+        }
+        in_isr = true;
+        if (next) {
+            next->zero_us = next_due;
+            if (next == &timers[0][0]) {
+                uint64_t start = sim_host_ns();
+                next->handler(next->arg);
+                sim_stage_ns.isr += sim_host_ns() - start;
+            } else {
+                next->handler(next->arg);
+            }
+        } else {
+            next_esp->due += next_esp->period;
+            next_esp->running = next_esp->period != 0;
+            next_esp->callback(next_esp->arg);
+        }
+        in_isr = false;
+    }
+    if (until_us > now_us) {
+        now_us = until_us;
+    }
+}
+
+esp_err_t timer_init(timer_group_t group, timer_idx_t timer, const timer_config_t* config) {
+    SimTimer& t = timers[group][timer];
+    t.divider   = config->divider;
+    t.running   = config->counter_en == TIMER_START;
+    t.zero_us   = now_us;
+    return ESP_OK;
+}
+
+esp_err_t timer_set_counter_value(timer_group_t group, timer_idx_t timer, uint64_t value) {
+    SimTimer& t = timers[group][timer];
+    t.zero_us   = now_us - double(value) * t.divider / 80.0;
+    return ESP_OK;
+}
+
+esp_err_t timer_set_alarm_value(timer_group_t group, timer_idx_t timer, uint64_t value) {
+    timers[group][timer].alarm                  = value;
+    timer_regs(group).hw_timer[timer].alarm_low = uint32_t(value);
+    return ESP_OK;
+}
+
+esp_err_t timer_set_alarm(timer_group_t group, timer_idx_t timer, timer_alarm_t alarm_en) {
+    return ESP_OK;
+}
+
+esp_err_t timer_set_auto_reload(timer_group_t group, timer_idx_t timer, timer_autoreload_t reload) {
+    return ESP_OK;
+}
+
+esp_err_t timer_enable_intr(timer_group_t group, timer_idx_t timer) {
+    return ESP_OK;
+}
+
+esp_err_t timer_disable_intr(timer_group_t group, timer_idx_t timer) {
+    return ESP_OK;
+}
+
+esp_err_t timer_start(timer_group_t group, timer_idx_t timer) {
+    timers[group][timer].running = true;
+    return ESP_OK;
+}
+
+esp_err_t timer_pause(timer_group_t group, timer_idx_t timer) {
+    timers[group][timer].running = false;
+    return ESP_OK;
+}
+
+esp_err_t timer_isr_register(timer_group_t  group,
+                             timer_idx_t    timer,
+                             void (*handler)(void*),
+                             void*          arg,
+                             int            intr_alloc_flags,
+                             intr_handle_t* handle) {
+    timers[group][timer].handler = handler;
+    timers[group][timer].arg     = arg;
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time() {
+    return now_us;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out_handle) {
+    esp_timer* t = new esp_timer {args->callback, args->arg, 0, 0, false};
+    esp_timers.push_back(t);
+    *out_handle = t;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) {
+    timer->period  = period;
+    timer->due     = now_us + period;
+    timer->running = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    timer->period  = 0;
+    timer->due     = now_us + timeout_us;
+    timer->running = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    timer->running = false;
+    return ESP_OK;
+}
+
+unsigned long millis() {
+    return now_us / 1000;
+}
+
+unsigned long micros() {
+    return now_us;
+}
+
+void sim_nop() {
+    now_us++;
+}
+
+void delay(uint32_t ms) {
+    sim_run(now_us + int64_t(ms) * 1000);
+}
+
+void delayMicroseconds(uint32_t us) {
+    sim_run(now_us + us);
+}
+
+uint32_t xthal_get_ccount() {
+    return uint32_t(sim_host_ns() * 240 / 1000);
+}
+
+// GPIO and LEDC
+
+static uint8_t gpio_levels[GPIO_NUM_MAX];
+gpio_dev_t     GPIO;
+ledc_dev_t     LEDC;
+
+static void gpio_mirror(uint8_t pin) {
+    uint32_t bit = pin < 32 ? 1u << pin : 1u << (pin - 32);
+    if (pin < 32) {
+        GPIO.in = gpio_levels[pin] ? GPIO.in | bit : GPIO.in & ~bit;
+    } else {
+        GPIO.in1.data = gpio_levels[pin] ? GPIO.in1.data | bit : GPIO.in1.data & ~bit;
+    }
+}
+
+extern "C" void __pinMode(uint8_t pin, uint8_t mode) {}
+
+extern "C" void __digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin < GPIO_NUM_MAX) {
+        gpio_levels[pin] = val != 0;
+        gpio_mirror(pin);
+    }
+}
+
+extern "C" int __digitalRead(uint8_t pin) {
+    return pin < GPIO_NUM_MAX ? gpio_levels[pin] : 0;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num) {
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode) {
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+    __digitalWrite(gpio_num, level);
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+    return __digitalRead(gpio_num);
+}
+
+void gpio_matrix_out(uint32_t gpio, uint32_t signal_idx, bool out_inv, bool oen_inv) {}
+void gpio_matrix_in(uint32_t gpio, uint32_t signal_idx, bool inv) {}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode) {}
+void detachInterrupt(uint8_t pin) {}
+
+uint16_t analogRead(uint8_t pin) {
+    return 0;
+}
+
+void dacWrite(uint8_t pin, uint8_t value) {}
+
+double ledcSetup(uint8_t channel, double freq, uint8_t resolution_bits) {
+    return freq;
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty) {
+    LEDC.channel_group[channel / 8].channel[channel % 8].duty.duty = duty << 4;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel) {}
+void ledcDetachPin(uint8_t pin) {}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+uint32_t getApbFrequency() {
+    return 80000000;
+}
+
+uint32_t getCpuFrequencyMhz() {
+    return 240;
+}
+
+bool psramFound() {
+    return false;
+}
+
+EspClass  ESP;
+WiFiClass WiFi;
+
+void EspClass::restart() {
+    exit(0);
+}
+
+uint32_t EspClass::getFreeHeap() {
+    return esp_get_free_heap_size();
+}
+
+void esp_restart() {
+    exit(0);
+}
+
+esp_err_t esp_intr_alloc(int source, int flags, void (*handler)(void*), void* arg, intr_handle_t* ret_handle) {
+    return ESP_OK;
+}
+
+esp_err_t esp_intr_enable(intr_handle_t handle) {
+    return ESP_OK;
+}
+
+esp_err_t esp_intr_disable(intr_handle_t handle) {
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_task_wdt_reset() {
+    return ESP_OK;
+}
+
+// Heap. The host has plenty; the sizes reported are those of a chip without PSRAM.
+
+static const size_t SIM_HEAP_SIZE = 200 * 1024;
+
+void* heap_caps_malloc(size_t size, uint32_t caps) {
+    return malloc(size);
+}
+
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    return calloc(n, size);
+}
+
+void heap_caps_free(void* ptr) {
+    free(ptr);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    return caps & MALLOC_CAP_SPIRAM ? 0 : SIM_HEAP_SIZE;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    return heap_caps_get_free_size(caps);
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    return heap_caps_get_free_size(caps);
+}
+
+bool esp_ptr_external_ram(const void* p) {
+    return false;
+}
+
+uint32_t esp_get_free_heap_size() {
+    return SIM_HEAP_SIZE;
+}
+
+// NVS, in memory
+
+static std::map<std::string, std::vector<uint8_t>> nvs_entries;
+static std::vector<std::string>                    nvs_namespaces;
+
+static std::string nvs_key(nvs_handle handle, const char* key) {
+    return nvs_namespaces[handle - 1] + '/' + key;
+}
+
+template <typename T>
+static esp_err_t nvs_get(nvs_handle handle, const char* key, T* out_value) {
+    auto it = nvs_entries.find(nvs_key(handle, key));
+    if (it == nvs_entries.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    memcpy(out_value, it->second.data(), sizeof(T));
+    return ESP_OK;
+}
+
+template <typename T>
+static esp_err_t nvs_set(nvs_handle handle, const char* key, T value) {
+    auto p                            = reinterpret_cast<const uint8_t*>(&value);
+    nvs_entries[nvs_key(handle, key)] = std::vector<uint8_t>(p, p + sizeof(T));
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode open_mode, nvs_handle* out_handle) {
+    nvs_namespaces.push_back(name);
+    *out_handle = nvs_namespaces.size();
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle handle) {}
+
+esp_err_t nvs_commit(nvs_handle handle) {
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_i8(nvs_handle handle, const char* key, int8_t* out_value) {
+    return nvs_get(handle, key, out_value);
+}
+
+esp_err_t nvs_get_i32(nvs_handle handle, const char* key, int32_t* out_value) {
+    return nvs_get(handle, key, out_value);
+}
+
+esp_err_t nvs_get_blob(nvs_handle handle, const char* key, void* out_value, size_t* length) {
+    auto it = nvs_entries.find(nvs_key(handle, key));
+    if (it == nvs_entries.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (out_value) {
+        if (*length < it->second.size()) {
+            return ESP_ERR_NVS_INVALID_LENGTH;
+        }
+        memcpy(out_value, it->second.data(), it->second.size());
+    }
+    *length = it->second.size();
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_str(nvs_handle handle, const char* key, char* out_value, size_t* length) {
+    return nvs_get_blob(handle, key, out_value, length);
+}
+
+esp_err_t nvs_set_i8(nvs_handle handle, const char* key, int8_t value) {
+    return nvs_set(handle, key, value);
+}
+
+esp_err_t nvs_set_i32(nvs_handle handle, const char* key, int32_t value) {
+    return nvs_set(handle, key, value);
+}
+
+esp_err_t nvs_set_blob(nvs_handle handle, const char* key, const void* value, size_t length) {
+    auto p                            = static_cast<const uint8_t*>(value);
+    nvs_entries[nvs_key(handle, key)] = std::vector<uint8_t>(p, p + length);
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_str(nvs_handle handle, const char* key, const char* value) {
+    return nvs_set_blob(handle, key, value, strlen(value) + 1);
+}
+
+esp_err_t nvs_erase_key(nvs_handle handle, const char* key) {
+    return nvs_entries.erase(nvs_key(handle, key)) ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_erase_all(nvs_handle handle) {
+    std::string prefix = nvs_namespaces[handle - 1] + '/';
+    for (auto it = nvs_entries.begin(); it != nvs_entries.end();) {
+        it = it->first.compare(0, prefix.size(), prefix) == 0 ? nvs_entries.erase(it) : std::next(it);
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_stats(const char* part_name, nvs_stats_t* nvs_stats) {
+    nvs_stats->used_entries    = nvs_entries.size();
+    nvs_stats->total_entries   = 630;  // A 20 kB partition
+    nvs_stats->free_entries    = nvs_stats->total_entries - nvs_stats->used_entries;
+    nvs_stats->namespace_count = nvs_namespaces.size();
+    return ESP_OK;
+}
+
+// FreeRTOS. Tasks are never started: the simulation calls the work they would do itself.
+
+static int sim_task;  // Stands in for every task handle
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code,
+                                   const char*    name,
+                                   uint32_t       stack_depth,
+                                   void*          parameters,
+                                   UBaseType_t    priority,
+                                   TaskHandle_t*  created_task,
+                                   BaseType_t     core_id) {
+    if (created_task) {
+        *created_task = &sim_task;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code,
+                       const char*    name,
+                       uint32_t       stack_depth,
+                       void*          parameters,
+                       UBaseType_t    priority,
+                       TaskHandle_t*  created_task) {
+    return xTaskCreatePinnedToCore(code, name, stack_depth, parameters, priority, created_task, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {}
+
+void vTaskDelay(TickType_t ticks) {
+    delay(ticks * portTICK_PERIOD_MS);
+}
+
+void vTaskDelayUntil(TickType_t* previous_wake_time, TickType_t increment) {
+    *previous_wake_time += increment;
+    if (*previous_wake_time > xTaskGetTickCount()) {
+        delay(*previous_wake_time - xTaskGetTickCount());
+    }
+}
+
+TickType_t xTaskGetTickCount() {
+    return TickType_t(now_us / 1000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return &sim_task;
+}
+
+char* pcTaskGetTaskName(TaskHandle_t task) {
+    static char name[] = "sim";
+    return name;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    return 4096;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+    return 1;
+}
+
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority) {}
+
+BaseType_t xTaskGetAffinity(TaskHandle_t task) {
+    return 1;
+}
+
+void vTaskSuspend(TaskHandle_t task) {}
+void vTaskResume(TaskHandle_t task) {}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken) {}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+    return 0;
+}
+
+void vTaskSuspendAll() {}
+
+BaseType_t xTaskResumeAll() {
+    return pdFALSE;
+}
+
+BaseType_t xPortInIsrContext() {
+    return in_isr;
+}
+
+uint32_t xPortGetFreeHeapSize() {
+    return SIM_HEAP_SIZE;
+}
+
+int xPortGetCoreID() {
+    return 1;
+}
+
+struct SimQueue {
+    UBaseType_t                       length;
+    UBaseType_t                       item_size;
+    std::deque<std::vector<uint8_t>> items;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    return new SimQueue {length, item_size, {}};
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait) {
+    if (queue->items.size() >= queue->length) {
+        return pdFAIL;
+    }
+    auto p = static_cast<const uint8_t*>(item);
+    queue->items.emplace_back(p, p + queue->item_size);
+    return pdPASS;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* higher_priority_task_woken) {
+    return xQueueSend(queue, item, 0);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void* item) {
+    queue->items.clear();
+    return xQueueSend(queue, item, 0);
+}
+
+BaseType_t xQueueOverwriteFromISR(QueueHandle_t queue, const void* item, BaseType_t* higher_priority_task_woken) {
+    return xQueueOverwrite(queue, item);
+}
+
+// Nothing else runs while the caller waits, so an empty queue fails at once.
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks_to_wait) {
+    if (queue->items.empty()) {
+        return pdFAIL;
+    }
+    memcpy(item, queue->items.front().data(), queue->item_size);
+    queue->items.pop_front();
+    return pdPASS;
+}
+
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void* item, BaseType_t* higher_priority_task_woken) {
+    return xQueueReceive(queue, item, 0);
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    queue->items.clear();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    return queue->items.size();
+}
+
+// Locks never contend on one thread. Binary semaphores keep their count.
+struct SimSemaphore {
+    int count;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new SimSemaphore {1};
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return new SimSemaphore {0};
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+    return new SimSemaphore {1};
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic(StaticSemaphore_t* buffer) {
+    return new SimSemaphore {1};
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait) {
+    if (semaphore->count > 0) {
+        semaphore->count--;
+        return pdTRUE;
+    }
+    return pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    semaphore->count = 1;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait) {
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore) {
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* higher_priority_task_woken) {
+    return xSemaphoreGive(semaphore);
+}
+
+// UART driver. Used by the RS485 spindles; nothing answers them.
+
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t* config) {
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num) {
+    return ESP_OK;
+}
+
+esp_err_t uart_driver_install(uart_port_t    uart_num,
+                              int            rx_buffer_size,
+                              int            tx_buffer_size,
+                              int            queue_size,
+                              QueueHandle_t* queue,
+                              int            flags) {
+    return ESP_OK;
+}
+
+esp_err_t uart_driver_delete(uart_port_t uart_num) {
+    return ESP_OK;
+}
+
+esp_err_t uart_set_mode(uart_port_t uart_num, uart_mode_t mode) {
+    return ESP_OK;
+}
+
+esp_err_t uart_intr_config(uart_port_t uart_num, const uart_intr_config_t* config) {
+    return ESP_OK;
+}
+
+esp_err_t uart_flush(uart_port_t uart_num) {
+    return ESP_OK;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t uart_num, TickType_t ticks_to_wait) {
+    return ESP_OK;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t* size) {
+    *size = 0;
+    return ESP_OK;
+}
+
+int uart_read_bytes(uart_port_t uart_num, uint8_t* buf, uint32_t length, TickType_t ticks_to_wait) {
+    return 0;
+}
+
+int uart_write_bytes(uart_port_t uart_num, const char* src, size_t size) {
+    return size;
+}
+
+int uart_tx_chars(uart_port_t uart_num, const char* buffer, uint32_t len) {
+    return len;
+}
+
+// Strings and files
+
+static std::string number_string(unsigned long value, unsigned char base, bool negative) {
+    std::string s;
+    do {
+        s.insert(s.begin(), "0123456789abcdefghijklmnopqrstuvwxyz"[value % base]);
+        value /= base;
+    } while (value);
+    return negative ? '-' + s : s;
+}
+
+String::String(int value, unsigned char base) : String(long(value), base) {}
+
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base) {}
+
+String::String(long value, unsigned char base) :
+    _s(number_string(value < 0 && base == 10 ? 0ul - value : (unsigned long)value, base, value < 0 && base == 10)) {}
+
+String::String(unsigned long value, unsigned char base) : _s(number_string(value, base, false)) {}
+
+String::String(float value, unsigned char decimals) : String(double(value), decimals) {}
+
+String::String(double value, unsigned char decimals) {
+    char buf[40];
+    snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+    _s = buf;
+}
+
+void String::trim() {
+    size_t first = _s.find_first_not_of(" \t\r\n");
+    size_t last  = _s.find_last_not_of(" \t\r\n");
+    _s           = first == std::string::npos ? std::string() : _s.substr(first, last - first + 1);
+}
+
+void String::replace(const String& from, const String& to) {
+    if (from._s.empty()) {
+        return;
+    }
+    for (size_t pos = 0; (pos = _s.find(from._s, pos)) != std::string::npos; pos += to._s.length()) {
+        _s.replace(pos, from._s.length(), to._s);
+    }
+}
+
+int fs::File::available() {
+    return _f ? int(size() - position()) : 0;
+}
+
+int fs::File::peek() {
+    if (!_f) {
+        return -1;
+    }
+    int c = fgetc(_f);
+    if (c != EOF) {
+        ungetc(c, _f);
+    }
+    return c;
+}
+
+size_t fs::File::size() const {
+    struct stat st;
+    return _f && fstat(fileno(_f), &st) == 0 ? st.st_size : 0;
+}
+
+bool fs::FS::exists(const char* path) {
+    struct stat st;
+    return stat(local(path).c_str(), &st) == 0;
+}
+
+fs::FS SPIFFS;
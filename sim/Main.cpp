@@ -0,0 +1,277 @@
+/*
+  Main.cpp - Runs a G-code file through the Grbl_ESP32 motion core on the host
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The file is fed one line at a time, the way a streaming sender with the serial buffer kept
+  full would, and the steps come out of the real stepper interrupt. When the machine has
+  stopped, the step counts, the simulated run time and the host time spent in each stage
+  are reported.
+*/
+
+#include "Sim.h"
+
+#include "src/Grbl.h"
+
+#include <unistd.h>
+
+SimStageTimes sim_stage_ns;
+
+static FILE* trace_out;    // -t, the step trace file
+static FILE* estimate_in;  // -e, the file planned without running it
+
+// Moves the recorded step trace to its file, often enough that the buffer never fills.
+static void sim_save_trace() {
+    uint8_t bytes[4096];
+    size_t  count;
+    while (trace_out && (count = step_trace_read(bytes, sizeof(bytes))) > 0) {
+        fwrite(bytes, 1, count, trace_out);
+    }
+}
+
+// plan_buffer_line() and st_prep_buffer() are wrapped by the linker, see the Makefile. The
+// wrapper of st_prep_buffer() is where simulated time moves during motion.
+extern "C" uint8_t __real__Z16plan_buffer_linePfP16plan_line_data_t(float* target, plan_line_data_t* pl_data);
+extern "C" void    __real__Z14st_prep_bufferv();
+
+extern "C" uint8_t __wrap__Z16plan_buffer_linePfP16plan_line_data_t(float* target, plan_line_data_t* pl_data) {
+    uint64_t start  = sim_host_ns();
+    uint8_t  result = __real__Z16plan_buffer_linePfP16plan_line_data_t(target, pl_data);
+    sim_stage_ns.plan += sim_host_ns() - start;
+    return result;
+}
+
+extern "C" void __wrap__Z14st_prep_bufferv() {
+    // Nobody is there to press cycle start after a feed hold or M0, so it is pressed as soon
+    // as the machine has stopped.
+    if (sys.state == State::Hold && sys.suspend.bit.holdComplete) {
+        sys_rt_exec_state.bit.cycleStart = true;
+    }
+    uint64_t start = sim_host_ns();
+    __real__Z14st_prep_bufferv();
+    sim_stage_ns.prep += sim_host_ns() - start;
+    sim_run(sim_now() + SIM_PREP_PERIOD_US);
+    sim_save_trace();
+}
+
+namespace WebUI {
+    void make_web_settings() {}  // No $ESP settings without a network
+}
+
+// Clears the run state the way reset_variables() in Grbl.cpp does before the main loop.
+static void sim_reset() {
+    sys.f_override        = FeedOverride::Default;
+    sys.r_override        = RapidOverride::Default;
+    sys.f_adaptive        = FeedOverride::Default;
+    sys.spindle_speed_ovr = SpindleSpeedOverride::Default;
+    sys_rt_f_override     = FeedOverride::Default;
+    sys_rt_r_override     = RapidOverride::Default;
+    sys_rt_f_adaptive     = FeedOverride::Default;
+    sys_rt_s_override     = SpindleSpeedOverride::Default;
+    gc_init();
+    spindle->stop();
+    coolant_init();
+    limits_init();
+    probe_init();
+    plan_reset();
+    st_reset();
+    plan_sync_position();
+    gc_sync_position();
+    sys.state = State::Idle;
+}
+
+// Acts on the realtime characters in line and takes them out, as the serial receive task does.
+static void sim_pick_realtime(char* line) {
+    char* out = line;
+    for (char* in = line; *in; in++) {
+        if (is_realtime_command(uint8_t(*in))) {
+            execute_realtime_command(Cmd(uint8_t(*in)), CLIENT_SERIAL);
+        } else {
+            *out++ = *in;
+        }
+    }
+    *out = '\0';
+}
+
+// The tail of one pass of protocol_main_loop(), after the clients have been read.
+static void sim_main_loop_pass() {
+    mc_continue_arc();
+    jog_velocity_update();
+    plan_idle_recalculate();
+    if (plan_get_block_buffer_count() <= 1) {
+        mc_flush_fitted_lines();
+        mc_flush_merged_line();
+    }
+    protocol_auto_cycle_start();
+    protocol_execute_realtime();
+}
+
+// Feeds $Bench/Plan the G-code lines of the -e file. The $ lines are run here instead, as
+// the bench skips them, so that the settings they change hold for the estimate.
+static bool sim_estimate_line(char* line, size_t size) {
+    while (fgets(line, size, estimate_in)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        sim_pick_realtime(line);
+        if (line[0] != '$') {
+            return true;
+        }
+        report_status_message(execute_line(line, CLIENT_SERIAL, WebUI::AuthenticationLevel::LEVEL_ADMIN), CLIENT_SERIAL);
+    }
+    return false;
+}
+
+static void usage() {
+    fprintf(stderr,
+            "Usage: grbl_sim [-q] [-e | -c] [-l steps.csv] [-t steps.trace] file.nc\n"
+            "  -q  Do not print what Grbl sends to the serial port\n"
+            "  -e  Only plan the file, as $Bench/Plan does, and print how long its motion takes\n"
+            "  -c  Only check the file, as $SD/Check does, and print the summary\n"
+            "  -l  Write the time and step and direction masks of each step event to a file\n"
+            "  -t  Write the step trace of the stepper interrupt to a file, see trace_diff.py\n");
+    exit(2);
+}
+
+static void sim_report(uint32_t lines, uint32_t errors) {
+    float mpos[MAX_N_AXIS];
+    system_convert_array_steps_to_mpos(mpos, sys_position);
+    uint8_t n_axis = number_axis->get();
+
+    printf("Lines:       %u, %u with errors\n", lines, errors);
+    printf("Run time:    %.3f s simulated\n", sim_now() / 1e6);
+    printf("Step events: %llu", (unsigned long long)sim_steps.events);
+    if (sim_steps.events > 1) {
+        printf(", %.1f us apart at least, %.0f per second on average",
+               double(sim_steps.min_interval_us),
+               (sim_steps.events - 1) * 1e6 / (sim_steps.last_us - sim_steps.first_us));
+    }
+    printf("\nSteps:      ");
+    for (int axis = 0; axis < n_axis; axis++) {
+        printf(" %c%llu", report_get_axis_letter(axis), (unsigned long long)sim_steps.moved[axis]);
+    }
+    printf("\nMPos:       ");
+    for (int axis = 0; axis < n_axis; axis++) {
+        printf(" %c%.3f", report_get_axis_letter(axis), mpos[axis]);
+    }
+    uint64_t job   = sim_stage_ns.job;
+    uint64_t inner = sim_stage_ns.plan + sim_stage_ns.prep + sim_stage_ns.isr;
+    printf("\nHost time:   %.3f ms: parse and loop %.3f, plan %.3f, prep %.3f, stepper ISR %.3f\n",
+           job / 1e6,
+           (job > inner ? job - inner : 0) / 1e6,
+           sim_stage_ns.plan / 1e6,
+           sim_stage_ns.prep / 1e6,
+           sim_stage_ns.isr / 1e6);
+}
+
+int main(int argc, char** argv) {
+    int  opt;
+    bool estimate = false;
+    bool check    = false;
+    while ((opt = getopt(argc, argv, "qecl:t:")) != -1) {
+        switch (opt) {
+            case 'q':
+                sim_serial_out = nullptr;
+                break;
+            case 'e':
+                estimate = true;
+                break;
+            case 'c':
+                check = true;
+                break;
+            case 'l':
+                sim_step_log = fopen(optarg, "w");
+                if (!sim_step_log) {
+                    perror(optarg);
+                    return 1;
+                }
+                fprintf(sim_step_log, "time_us,step_mask,dir_mask\n");
+                break;
+            case 't':
+                trace_out = fopen(optarg, "wb");
+                if (!trace_out) {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            default:
+                usage();
+        }
+    }
+    if (optind != argc - 1 || (estimate && check)) {
+        usage();
+    }
+    FILE* in = fopen(argv[optind], "r");
+    if (!in) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    grbl_init();
+    sim_reset();
+    if (check) {
+        // The summary goes to the serial port, so it is printed even with -q.
+        File file(in, argv[optind]);
+        sim_serial_out = stdout;
+        file_check(file, argv[optind], CLIENT_SERIAL);
+        file.close();
+        return sys.abort ? 1 : 0;
+    }
+    if (estimate) {
+        estimate_in = in;
+        bench_run_lines(BenchStage::Plan, sim_estimate_line, CLIENT_SERIAL);
+        fclose(in);
+        if (sim_serial_out) {
+            fflush(sim_serial_out);
+        }
+        printf("Planned:     %.3f s\n", bench_planned_time());
+        return sys.abort ? 1 : 0;
+    }
+    if (trace_out) {
+        step_trace_start();
+    }
+
+    char     line[LINE_BUFFER_SIZE];
+    uint32_t lines = 0, errors = 0;
+    uint64_t start = sim_host_ns();
+    while (!sys.abort && fgets(line, sizeof(line), in)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        lines++;
+        sim_pick_realtime(line);
+        // Like must_defer_line() in Protocol.cpp, a G-code line waits for room in the planner.
+        while (line[0] && line[0] != '$' && line[0] != '[' && plan_check_full_buffer() && !sys.abort) {
+            sim_main_loop_pass();
+        }
+        Error status = execute_line(line, CLIENT_SERIAL, WebUI::AuthenticationLevel::LEVEL_ADMIN);
+        if (status != Error::Ok) {
+            errors++;
+        }
+        report_status_message(status, CLIENT_SERIAL);
+        sim_main_loop_pass();
+    }
+    protocol_buffer_synchronize();
+    sim_stage_ns.job = sim_host_ns() - start;
+    fclose(in);
+
+    if (sim_serial_out) {
+        fflush(sim_serial_out);
+    }
+    if (sim_step_log) {
+        fclose(sim_step_log);
+    }
+    if (trace_out) {
+        sim_save_trace();
+        fclose(trace_out);
+    }
+    sim_report(lines, errors);
+    return sys.abort ? 1 : 0;
+}
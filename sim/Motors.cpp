@@ -0,0 +1,109 @@
+/*
+  Motors.cpp - Host stand-in for Grbl_Esp32/src/Motors/Motors.cpp
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  There are no motor objects. Each axis counts the steps it is given, and the times of the
+  step events are kept for the report at the end of the run.
+*/
+
+#include "Sim.h"
+
+#include "src/Grbl.h"
+
+SimStepStats sim_steps = { 0, {}, {}, -1, -1, -1 };
+FILE*        sim_step_log;
+
+static uint8_t dir_bits;
+
+static void motors_record(uint8_t step_mask, int64_t time_us) {
+    if (!step_mask) {
+        return;
+    }
+    for (int axis = 0; axis < MAX_N_AXIS; axis++) {
+        if (bitnum_istrue(step_mask, axis)) {
+            sim_steps.steps[axis] += bitnum_istrue(dir_bits, axis) ? -1 : 1;
+            sim_steps.moved[axis]++;
+        }
+    }
+    if (sim_steps.last_us >= 0) {
+        int64_t interval = time_us - sim_steps.last_us;
+        if (sim_steps.min_interval_us < 0 || interval < sim_steps.min_interval_us) {
+            sim_steps.min_interval_us = interval;
+        }
+    } else {
+        sim_steps.first_us = time_us;
+    }
+    sim_steps.last_us = time_us;
+    sim_steps.events++;
+    if (sim_step_log) {
+        fprintf(sim_step_log, "%lld,%u,%u\n", (long long)time_us, step_mask, dir_bits);
+    }
+}
+
+void init_motors() {
+    grbl_msg_sendf(CLIENT_SERIAL, MsgLevel::Info, "Simulated motors on %d axes", number_axis->get());
+}
+
+uint8_t get_next_trinamic_driver_index() {
+    return 0;
+}
+
+void readSgTask(void* pvParameters) {}
+
+void servoUpdateTask(void* pvParameters) {}
+
+void motors_read_settings() {}
+
+uint8_t motors_set_homing_mode(uint8_t homing_mask, bool isHoming) {
+    return homing_mask;
+}
+
+void motors_set_disable(bool disable, uint8_t mask) {}
+
+bool motors_direction(uint8_t dir_mask) {
+    if (dir_mask == dir_bits) {
+        return false;
+    }
+    dir_bits = dir_mask;
+    return true;
+}
+
+void motors_step(uint8_t step_mask) {
+    if (ganged_mode == SquaringMode::None) {
+        return;  // No motor steps, as during $Bench
+    }
+    motors_record(step_mask, sim_now());
+}
+
+void motors_unstep() {}
+
+// tick_period is in RMT ticks, which the batch plays out from now.
+void motors_step_batch(const uint8_t* step_masks, uint8_t count, uint32_t tick_period) {
+#ifdef USE_RMT_BATCH_STEPS
+    for (uint8_t i = 0; i < count; i++) {
+        motors_record(step_masks[i], sim_now() + int64_t(i) * tick_period / rmtTicksPerMicrosecond);
+    }
+#endif
+}
+
+void motors_get_following_error(float* error) {
+    for (int axis = 0; axis < MAX_N_AXIS; axis++) {
+        error[axis] = 0.0f;
+    }
+}
+
+// The I2S output expander is not simulated. The stepper only calls this with ST_I2S_STREAM.
+uint32_t i2s_out_push_sample(uint32_t usec) {
+    return 0;
+}
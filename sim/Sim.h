@@ -0,0 +1,64 @@
+#pragma once
+
+/*
+  Sim.h - Host simulation of the Grbl_ESP32 motion core
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  The simulation runs on one host thread. Time only moves when the firmware waits: delay(),
+  vTaskDelay() and each call to st_prep_buffer() advance it, and the hardware timers that come
+  due on the way, the stepper timer among them, have their interrupt handlers called in order.
+*/
+
+#include <cstdint>
+#include <cstdio>
+
+// How far each call to st_prep_buffer() moves time on. The main loop on the chip refills
+// the segment buffer far more often than this; a millisecond keeps it just as full.
+const int64_t SIM_PREP_PERIOD_US = 1000;
+
+// Simulated microseconds since boot.
+int64_t sim_now();
+
+// Moves time on to until_us, calling the handlers of the timers that come due first.
+void sim_run(int64_t until_us);
+
+// True while a timer handler is being called, for xPortInIsrContext().
+bool sim_in_isr();
+
+// Host CPU time spent in each stage, in nanoseconds.
+struct SimStageTimes {
+    uint64_t job;   // The whole job, from the first line until the machine stops
+    uint64_t plan;  // plan_buffer_line()
+    uint64_t prep;  // st_prep_buffer()
+    uint64_t isr;   // Stepper timer interrupts
+};
+extern SimStageTimes sim_stage_ns;
+
+uint64_t sim_host_ns();
+
+// Step events seen by the motor stub, see Motors.cpp.
+struct SimStepStats {
+    uint64_t events;             // Interrupts that stepped at least one axis
+    int64_t  steps[6];           // Net steps per axis, signed by direction
+    uint64_t moved[6];           // Steps per axis regardless of direction
+    int64_t  first_us, last_us;  // Times of the first and last step events
+    int64_t  min_interval_us;    // Shortest time between two step events
+};
+extern SimStepStats sim_steps;
+
+// Writes a line per step event, time and masks, when set.
+extern FILE* sim_step_log;
+
+// Host output of the simulated serial port. Null drops it.
+extern FILE* sim_serial_out;
@@ -0,0 +1,105 @@
+/*
+  Uart.cpp - Host stand-in for Grbl_Esp32/src/Uart.cpp
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+
+  Output goes straight to sim_serial_out. Nothing is ever received: the simulation hands its
+  G-code to execute_line() itself.
+*/
+
+#include "Sim.h"
+
+#include "src/Grbl.h"
+
+FILE* sim_serial_out = stdout;
+
+Uart::Uart(int uart_num) :
+    _uart_num(uart_port_t(uart_num)), _pushback(-1), _rx_events(NULL), _tx_queue(NULL), _tx_size(0), _tx_head(0), _tx_tail(0),
+    _tx_lock(NULL), _tx_stats {} {}
+
+bool Uart::setHalfDuplex() {
+    return false;
+}
+
+bool Uart::setPins(int tx_pin, int rx_pin, int rts_pin, int cts_pin) {
+    return false;
+}
+
+void Uart::begin(unsigned long baud, Data dataBits, Stop stopBits, Parity parity, int rx_events) {}
+
+bool Uart::setRxTimeout(uint8_t symbols, uint8_t full_threshold) {
+    return false;
+}
+
+bool Uart::setBaudRate(uint32_t baud) {
+    return false;
+}
+
+bool Uart::setHwFlowControl(bool enable, uint8_t rts_threshold) {
+    return false;
+}
+
+bool Uart::setTxQueue(size_t size) {
+    return false;
+}
+
+int Uart::available() {
+    return 0;
+}
+
+int Uart::read() {
+    return -1;
+}
+
+int Uart::read(TickType_t timeout) {
+    return -1;
+}
+
+int Uart::peek() {
+    return -1;
+}
+
+size_t Uart::readBytes(char* buffer, size_t length, TickType_t timeout) {
+    return 0;
+}
+
+size_t Uart::readBytes(char* buffer, size_t length) {
+    return 0;
+}
+
+size_t Uart::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+size_t Uart::write(const uint8_t* buffer, size_t length) {
+    if (sim_serial_out) {
+        fwrite(buffer, 1, length, sim_serial_out);
+    }
+    return length;
+}
+
+size_t Uart::write(const uint8_t* buffer, size_t length, bool low_priority) {
+    return write(buffer, length);
+}
+
+size_t Uart::write(const char* text) {
+    return write((const uint8_t*)text, strlen(text));
+}
+
+bool Uart::flushTxTimed(TickType_t ticks) {
+    return true;
+}
+
+void Uart::drainTx() {}
+
+Uart Uart0(0);
@@ -0,0 +1,95 @@
+#pragma once
+
+/*
+  Arduino.h - Host stand-in for the parts of the Arduino ESP32 core that Grbl uses
+  Part of Grbl_ESP32
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include "binary.h"
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "esp32-hal.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x02
+#define PULLUP 0x04
+#define INPUT_PULLUP 0x05
+#define PULLDOWN 0x08
+#define INPUT_PULLDOWN 0x09
+#define OPEN_DRAIN 0x10
+#define OUTPUT_OPEN_DRAIN 0x12
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define PI 3.1415926535897932384626433832795
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define F(string_literal) (string_literal)
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+void     pinMode(uint8_t pin, uint8_t mode);
+void     digitalWrite(uint8_t pin, uint8_t val);
+int      digitalRead(uint8_t pin);
+void     attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void     detachInterrupt(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+void          delay(uint32_t ms);
+void          delayMicroseconds(uint32_t us);
+
+double   ledcSetup(uint8_t channel, double freq, uint8_t resolution_bits);
+void     ledcWrite(uint8_t channel, uint32_t duty);
+void     ledcAttachPin(uint8_t pin, uint8_t channel);
+void     ledcDetachPin(uint8_t pin);
+void     dacWrite(uint8_t pin, uint8_t value);
+uint32_t getApbFrequency();
+uint32_t getCpuFrequencyMhz();
+bool     psramFound();
+
+class EspClass {
+public:
+    void        restart();
+    uint32_t    getFreeHeap();
+    uint32_t    getCpuFreqMHz() { return getCpuFrequencyMhz(); }
+    uint32_t    getFlashChipSize() { return 4 * 1024 * 1024; }
+    uint64_t    getEfuseMac() { return 0; }
+    const char* getSdkVersion() { return "host"; }
+};
+
+extern EspClass ESP;
@@ -0,0 +1,71 @@
+#pragma once
+
+// Host stand-in for the Arduino ESP32 file system classes, on stdio. Paths are taken relative to
+// the directory the simulation runs in, so "/job.nc" is ./job.nc.
+
+#include <cstdio>
+
+#include "Stream.h"
+#include "WString.h"
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+    enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+    class File : public Stream {
+    public:
+        File(FILE* f = nullptr, const char* path = "") : _f(f), _path(path) {}
+        size_t      write(uint8_t c) override { return _f ? fputc(c, _f) != EOF : 0; }
+        size_t      write(const uint8_t* buffer, size_t size) override { return _f ? fwrite(buffer, 1, size, _f) : 0; }
+        int         available() override;
+        int         read() override { return _f ? fgetc(_f) : -1; }
+        size_t      read(uint8_t* buffer, size_t size) { return _f ? fread(buffer, 1, size, _f) : 0; }
+        int         peek() override;
+        void        flush() override {
+            if (_f) {
+                fflush(_f);
+            }
+        }
+        bool   seek(uint32_t pos, SeekMode mode = SeekSet) { return _f && fseek(_f, pos, mode) == 0; }
+        size_t position() const { return _f ? ftell(_f) : 0; }
+        size_t size() const;
+        void   close() {
+            if (_f) {
+                fclose(_f);
+                _f = nullptr;
+            }
+        }
+        time_t      getLastWrite() { return 0; }
+        const char* name() const { return _path.c_str(); }
+        bool        isDirectory() { return false; }
+        File        openNextFile() { return File(); }
+        operator bool() const { return _f != nullptr; }
+
+    private:
+        FILE*  _f;
+        String _path;
+    };
+
+    class FS {
+    public:
+        bool begin(bool formatOnFail = false) { return true; }
+        File open(const char* path, const char* mode = FILE_READ) { return File(fopen(local(path).c_str(), mode), path); }
+        File open(const String& path, const char* mode = FILE_READ) { return open(path.c_str(), mode); }
+        bool exists(const char* path);
+        bool exists(const String& path) { return exists(path.c_str()); }
+        bool remove(const char* path) { return ::remove(local(path).c_str()) == 0; }
+        bool remove(const String& path) { return remove(path.c_str()); }
+        bool rename(const char* from, const char* to) { return ::rename(local(from).c_str(), local(to).c_str()) == 0; }
+        bool mkdir(const char*) { return false; }
+        bool rmdir(const char*) { return false; }
+
+    protected:
+        static String local(const char* path) { return path[0] == '/' ? String(".") + path : String(path); }
+    };
+}
+
+using fs::File;
+using fs::FS;
@@ -0,0 +1,7 @@
+#pragma once
+
+// Host stand-in for the SPIFFS file system, kept in a directory on the host like SD.h.
+
+#include "FS.h"
+
+extern fs::FS SPIFFS;
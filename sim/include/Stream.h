@@ -0,0 +1,22 @@
+#pragma once
+
+// Host stand-in for the Arduino Stream class.
+
+#include "Print.h"
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read()      = 0;
+    virtual int peek()      = 0;
+    virtual void flush() {}
+    virtual size_t readBytes(char* buffer, size_t length) {
+        size_t n = 0;
+        int    c;
+        while (n < length && (c = read()) >= 0) {
+            buffer[n++] = c;
+        }
+        return n;
+    }
+    void setTimeout(unsigned long) {}
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+// Host stand-in for the Arduino String class, on std::string.
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+class String {
+public:
+    String() = default;
+    String(const char* s) : _s(s ? s : "") {}
+    String(const std::string& s) : _s(s) {}
+    String(char c) : _s(1, c) {}
+    String(int value, unsigned char base = 10);
+    String(unsigned int value, unsigned char base = 10);
+    String(long value, unsigned char base = 10);
+    String(unsigned long value, unsigned char base = 10);
+    String(float value, unsigned char decimals = 2);
+    String(double value, unsigned char decimals = 2);
+
+    const char*  c_str() const { return _s.c_str(); }
+    unsigned int length() const { return _s.length(); }
+    char         charAt(unsigned int index) const { return index < _s.length() ? _s[index] : 0; }
+    char         operator[](unsigned int index) const { return charAt(index); }
+    char&        operator[](unsigned int index) { return _s[index]; }
+    void         setCharAt(unsigned int index, char c) {
+        if (index < _s.length()) {
+            _s[index] = c;
+        }
+    }
+
+    String& operator+=(const String& rhs) {
+        _s += rhs._s;
+        return *this;
+    }
+    String& operator+=(const char* rhs) {
+        _s += rhs;
+        return *this;
+    }
+    String& operator+=(char rhs) {
+        _s += rhs;
+        return *this;
+    }
+    String& operator+=(int rhs) { return *this += String(rhs); }
+    String& operator+=(unsigned int rhs) { return *this += String(rhs); }
+    String& operator+=(float rhs) { return *this += String(rhs); }
+    bool    concat(const String& rhs) {
+        _s += rhs._s;
+        return true;
+    }
+
+    friend String operator+(const String& lhs, const String& rhs) { return String(lhs._s + rhs._s); }
+    friend String operator+(const String& lhs, const char* rhs) { return String(lhs._s + rhs); }
+    friend String operator+(const char* lhs, const String& rhs) { return String(lhs + rhs._s); }
+    friend String operator+(const String& lhs, char rhs) { return String(lhs._s + rhs); }
+
+    bool operator==(const String& rhs) const { return _s == rhs._s; }
+    bool operator==(const char* rhs) const { return _s == rhs; }
+    bool operator!=(const String& rhs) const { return _s != rhs._s; }
+    bool operator!=(const char* rhs) const { return _s != rhs; }
+    bool operator<(const String& rhs) const { return _s < rhs._s; }
+    bool equals(const String& rhs) const { return _s == rhs._s; }
+    bool equalsIgnoreCase(const String& rhs) const { return strcasecmp(_s.c_str(), rhs.c_str()) == 0; }
+    bool startsWith(const String& prefix) const { return _s.compare(0, prefix._s.length(), prefix._s) == 0; }
+    bool endsWith(const String& suffix) const {
+        return _s.length() >= suffix._s.length() && _s.compare(_s.length() - suffix._s.length(), suffix._s.length(), suffix._s) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const {
+        auto pos = _s.find(c, from);
+        return pos == std::string::npos ? -1 : int(pos);
+    }
+    int indexOf(const String& s, unsigned int from = 0) const {
+        auto pos = _s.find(s._s, from);
+        return pos == std::string::npos ? -1 : int(pos);
+    }
+    int lastIndexOf(char c) const {
+        auto pos = _s.rfind(c);
+        return pos == std::string::npos ? -1 : int(pos);
+    }
+    String substring(unsigned int from) const { return from < _s.length() ? String(_s.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        return from < to && from < _s.length() ? String(_s.substr(from, to - from)) : String();
+    }
+
+    void toUpperCase() {
+        for (auto& c : _s) {
+            c = toupper(c);
+        }
+    }
+    void toLowerCase() {
+        for (auto& c : _s) {
+            c = tolower(c);
+        }
+    }
+    void trim();
+    void replace(const String& from, const String& to);
+    void remove(unsigned int index, unsigned int count = 1) { _s.erase(index, count); }
+    long toInt() const { return strtol(_s.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(_s.c_str(), nullptr); }
+    void toCharArray(char* buf, unsigned int size, unsigned int index = 0) const {
+        if (size > 0) {
+            strncpy(buf, index < _s.length() ? _s.c_str() + index : "", size - 1);
+            buf[size - 1] = '\0';
+        }
+    }
+    bool reserve(unsigned int size) {
+        _s.reserve(size);
+        return true;
+    }
+
+private:
+    std::string _s;
+};
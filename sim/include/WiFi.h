@@ -0,0 +1,44 @@
+#pragma once
+
+// Host stand-in for the Arduino WiFi library. There is no radio; grbl_init() only turns it off.
+
+#include <cstdint>
+#include <cstdio>
+
+#include "WString.h"
+
+class IPAddress {
+public:
+    IPAddress(uint32_t address = 0) : _address(address) {}
+    bool fromString(const char* s) {
+        unsigned int b[4];
+        char         extra;
+        if (sscanf(s, "%u.%u.%u.%u%c", &b[0], &b[1], &b[2], &b[3], &extra) != 4 || b[0] > 255 || b[1] > 255 || b[2] > 255 || b[3] > 255) {
+            return false;
+        }
+        _address = b[0] | (b[1] << 8) | (b[2] << 16) | (b[3] << 24);
+        return true;
+    }
+    String toString() const {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _address & 0xff, (_address >> 8) & 0xff, (_address >> 16) & 0xff, _address >> 24);
+        return String(buf);
+    }
+    operator uint32_t() const { return _address; }
+
+private:
+    uint32_t _address;
+};
+
+typedef enum { WIFI_OFF = 0, WIFI_STA, WIFI_AP, WIFI_AP_STA } wifi_mode_t;
+
+class WiFiClass {
+public:
+    void persistent(bool) {}
+    bool disconnect(bool = false) { return true; }
+    bool enableSTA(bool) { return true; }
+    bool enableAP(bool) { return true; }
+    bool mode(wifi_mode_t) { return true; }
+};
+
+extern WiFiClass WiFi;
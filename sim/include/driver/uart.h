@@ -0,0 +1,59 @@
+#pragma once
+
+// Host stand-in for the ESP-IDF UART driver. Nothing is transmitted.
+
+#include "../freertos/FreeRTOS.h"
+
+typedef int uart_port_t;
+#define UART_NUM_0 0
+#define UART_NUM_1 1
+#define UART_NUM_2 2
+#define UART_PIN_NO_CHANGE -1
+#define UART_FIFO_LEN 128
+
+typedef enum { UART_DATA_5_BITS = 0, UART_DATA_6_BITS, UART_DATA_7_BITS, UART_DATA_8_BITS } uart_word_length_t;
+typedef enum { UART_STOP_BITS_1 = 1, UART_STOP_BITS_1_5, UART_STOP_BITS_2 } uart_stop_bits_t;
+typedef enum { UART_PARITY_DISABLE = 0, UART_PARITY_EVEN = 2, UART_PARITY_ODD = 3 } uart_parity_t;
+typedef enum { UART_HW_FLOWCTRL_DISABLE = 0, UART_HW_FLOWCTRL_CTS_RTS = 3 } uart_hw_flowcontrol_t;
+typedef enum { UART_MODE_UART = 0, UART_MODE_RS485_HALF_DUPLEX = 1 } uart_mode_t;
+typedef enum { UART_DATA = 0, UART_BREAK, UART_BUFFER_FULL, UART_FIFO_OVF, UART_FRAME_ERR, UART_PARITY_ERR } uart_event_type_t;
+
+typedef struct {
+    int                   baud_rate;
+    uart_word_length_t    data_bits;
+    uart_parity_t         parity;
+    uart_stop_bits_t      stop_bits;
+    uart_hw_flowcontrol_t flow_ctrl;
+    uint8_t               rx_flow_ctrl_thresh;
+    bool                  use_ref_tick;
+} uart_config_t;
+
+typedef struct {
+    uint32_t intr_enable_mask;
+    uint8_t  rx_timeout_thresh;
+    uint8_t  txfifo_empty_intr_thresh;
+    uint8_t  rxfifo_full_thresh;
+} uart_intr_config_t;
+
+typedef struct {
+    uart_event_type_t type;
+    size_t            size;
+} uart_event_t;
+
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t* config);
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num);
+esp_err_t uart_driver_install(uart_port_t    uart_num,
+                              int            rx_buffer_size,
+                              int            tx_buffer_size,
+                              int            queue_size,
+                              QueueHandle_t* queue,
+                              int            flags);
+esp_err_t uart_driver_delete(uart_port_t uart_num);
+esp_err_t uart_set_mode(uart_port_t uart_num, uart_mode_t mode);
+esp_err_t uart_intr_config(uart_port_t uart_num, const uart_intr_config_t* config);
+esp_err_t uart_flush(uart_port_t uart_num);
+esp_err_t uart_wait_tx_done(uart_port_t uart_num, TickType_t ticks_to_wait);
+esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t* size);
+int       uart_read_bytes(uart_port_t uart_num, uint8_t* buf, uint32_t length, TickType_t ticks_to_wait);
+int       uart_write_bytes(uart_port_t uart_num, const char* src, size_t size);
+int       uart_tx_chars(uart_port_t uart_num, const char* buffer, uint32_t len);
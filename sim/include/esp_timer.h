@@ -0,0 +1,5 @@
+#pragma once
+
+// Host stand-in. The esp_timer functions are declared with the rest of the core in esp32-hal.h.
+
+#include "esp32-hal.h"
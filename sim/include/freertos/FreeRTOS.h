@@ -0,0 +1,47 @@
+#pragma once
+
+// Host stand-ins for FreeRTOS. The simulation runs on one thread, so tasks are not started,
+// queues are short buffers and locks do nothing.
+
+#include <cstdint>
+
+#include "../esp32-hal.h"
+
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+#define portBASE_TYPE int
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xffffffffUL
+#define portTICK_PERIOD_MS 1
+#define portTICK_RATE_MS portTICK_PERIOD_MS
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define configMAX_PRIORITIES 25
+#define portNUM_PROCESSORS 2
+#define tskNO_AFFINITY 0x7fffffff
+
+typedef struct {
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED \
+    { 0, 0 }
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+#define portYIELD_FROM_ISR()
+#define portDISABLE_INTERRUPTS()
+#define portENABLE_INTERRUPTS()
+
+BaseType_t xPortInIsrContext();
+uint32_t   xPortGetFreeHeapSize();
+int        xPortGetCoreID();
+
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define tskNO_AFFINITY 0x7fffffff
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code,
+                                   const char*    name,
+                                   uint32_t       stack_depth,
+                                   void*          parameters,
+                                   UBaseType_t    priority,
+                                   TaskHandle_t*  created_task,
+                                   BaseType_t     core_id);
+BaseType_t xTaskCreate(TaskFunction_t code,
+                       const char*    name,
+                       uint32_t       stack_depth,
+                       void*          parameters,
+                       UBaseType_t    priority,
+                       TaskHandle_t*  created_task);
+void         vTaskDelete(TaskHandle_t task);
+void         vTaskDelay(TickType_t ticks);
+void         vTaskDelayUntil(TickType_t* previous_wake_time, TickType_t increment);
+TickType_t   xTaskGetTickCount();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+char*        pcTaskGetTaskName(TaskHandle_t task);
+UBaseType_t  uxTaskGetStackHighWaterMark(TaskHandle_t task);
+UBaseType_t  uxTaskPriorityGet(TaskHandle_t task);
+void         vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority);
+BaseType_t   xTaskGetAffinity(TaskHandle_t task);
+void         vTaskSuspend(TaskHandle_t task);
+void         vTaskResume(TaskHandle_t task);
+BaseType_t   xTaskNotifyGive(TaskHandle_t task);
+void         vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken);
+uint32_t     ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait);
+void         vTaskSuspendAll();
+BaseType_t   xTaskResumeAll();
@@ -0,0 +1,41 @@
+#pragma once
+
+// Host stand-in for ESP-IDF NVS. sim/Hal.cpp keeps the entries in memory, so every run starts
+// from the default settings.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp32-hal.h"
+
+typedef uint32_t nvs_handle;
+typedef nvs_handle nvs_handle_t;
+typedef enum { NVS_READONLY = 0, NVS_READWRITE } nvs_open_mode;
+typedef enum { NVS_TYPE_ANY = 0xff } nvs_type_t;
+typedef struct {
+    size_t used_entries;
+    size_t free_entries;
+    size_t total_entries;
+    size_t namespace_count;
+} nvs_stats_t;
+typedef void* nvs_iterator_t;
+typedef struct {
+    char       namespace_name[16];
+    char       key[16];
+    nvs_type_t type;
+} nvs_entry_info_t;
+
+esp_err_t nvs_open(const char* name, nvs_open_mode open_mode, nvs_handle* out_handle);
+void      nvs_close(nvs_handle handle);
+esp_err_t nvs_commit(nvs_handle handle);
+esp_err_t nvs_get_i8(nvs_handle handle, const char* key, int8_t* out_value);
+esp_err_t nvs_get_i32(nvs_handle handle, const char* key, int32_t* out_value);
+esp_err_t nvs_get_str(nvs_handle handle, const char* key, char* out_value, size_t* length);
+esp_err_t nvs_get_blob(nvs_handle handle, const char* key, void* out_value, size_t* length);
+esp_err_t nvs_set_i8(nvs_handle handle, const char* key, int8_t value);
+esp_err_t nvs_set_i32(nvs_handle handle, const char* key, int32_t value);
+esp_err_t nvs_set_str(nvs_handle handle, const char* key, const char* value);
+esp_err_t nvs_set_blob(nvs_handle handle, const char* key, const void* value, size_t length);
+esp_err_t nvs_erase_key(nvs_handle handle, const char* key);
+esp_err_t nvs_erase_all(nvs_handle handle);
+esp_err_t nvs_get_stats(const char* part_name, nvs_stats_t* nvs_stats);
@@ -0,0 +1,25 @@
+#pragma once
+
+// Host stand-in for the GPIO registers. The simulation keeps the input registers in step with
+// digitalRead(). Writes to the output set and clear registers go nowhere.
+
+#include <cstdint>
+
+typedef union {
+    struct {
+        uint32_t data : 8;
+        uint32_t reserved8 : 24;
+    };
+    uint32_t val;
+} gpio_reg1_t;
+
+typedef volatile struct gpio_dev_s {
+    uint32_t    out_w1ts;
+    uint32_t    out_w1tc;
+    gpio_reg1_t out1_w1ts;
+    gpio_reg1_t out1_w1tc;
+    uint32_t    in;
+    gpio_reg1_t in1;
+} gpio_dev_t;
+
+extern gpio_dev_t GPIO;
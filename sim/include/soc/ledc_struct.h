@@ -0,0 +1,38 @@
+#pragma once
+
+// Host stand-in for the LEDC registers. Writes land in memory and drive nothing.
+
+#include <cstdint>
+
+typedef struct {
+    struct {
+        struct {
+            struct {
+                uint32_t timer_sel : 2;
+                uint32_t sig_out_en : 1;
+                uint32_t idle_lv : 1;
+                uint32_t low_speed_update : 1;
+                uint32_t reserved5 : 26;
+                uint32_t clk_en : 1;
+            } conf0;
+            uint32_t hpoint;
+            struct {
+                uint32_t duty : 25;
+                uint32_t reserved25 : 7;
+            } duty;
+            struct {
+                uint32_t duty_scale : 10;
+                uint32_t duty_cycle : 10;
+                uint32_t duty_num : 10;
+                uint32_t duty_inc : 1;
+                uint32_t duty_start : 1;
+            } conf1;
+            struct {
+                uint32_t duty_read : 25;
+                uint32_t reserved25 : 7;
+            } duty_rd;
+        } channel[8];
+    } channel_group[2];
+} ledc_dev_t;
+
+extern ledc_dev_t LEDC;
@@ -0,0 +1,5 @@
+#pragma once
+
+// Host stand-in. The host has no external RAM, see esp_ptr_external_ram() in esp_heap_caps.h.
+
+#include "../esp_heap_caps.h"
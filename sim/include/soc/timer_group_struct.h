@@ -0,0 +1,52 @@
+#pragma once
+
+// The fields of the timer group registers that Grbl touches directly.
+
+#include <cstdint>
+
+typedef struct {
+    struct {
+        union {
+            struct {
+                uint32_t reserved0 : 10;
+                uint32_t alarm_en : 1;
+                uint32_t level_int_en : 1;
+                uint32_t edge_int_en : 1;
+                uint32_t divider : 16;
+                uint32_t autoreload : 1;
+                uint32_t increase : 1;
+                uint32_t enable : 1;
+            };
+            uint32_t val;
+        } config;
+        uint32_t cnt_low;
+        uint32_t cnt_high;
+        uint32_t update;
+        uint32_t alarm_low;
+        uint32_t alarm_high;
+        uint32_t load_low;
+        uint32_t load_high;
+        uint32_t reload;
+    } hw_timer[2];
+    union {
+        struct {
+            uint32_t t0 : 1;
+            uint32_t t1 : 1;
+            uint32_t wdt : 1;
+            uint32_t reserved3 : 29;
+        };
+        uint32_t val;
+    } int_clr_timers;
+    union {
+        struct {
+            uint32_t t0 : 1;
+            uint32_t t1 : 1;
+            uint32_t wdt : 1;
+            uint32_t reserved3 : 29;
+        };
+        uint32_t val;
+    } int_st_timers;
+} timg_dev_t;
+
+extern timg_dev_t TIMERG0;
+extern timg_dev_t TIMERG1;
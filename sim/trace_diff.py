@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+"""Compares two step traces and shows where they part.
+
+A trace is either the file grbl_sim -t writes or a log of $Stepper/Trace output from the
+firmware, with its [TRACE:<hex>] lines. See Grbl_Esp32/src/StepTrace.cpp for the format.
+
+    trace_diff.py old.trace new.trace
+    trace_diff.py --show steps.trace
+
+Exits with 1 if the traces differ.
+"""
+
+import argparse
+import re
+import sys
+
+TICKS_PER_US = 20  # Step timer ticks, see Stepper.h
+AXES = "XYZABC"
+
+
+def read_bytes(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if b"[TRACE:" not in data:
+        return data
+    hex_parts = re.findall(rb"\[TRACE:([0-9a-fA-F]*)\]", data)
+    return bytes.fromhex(b"".join(hex_parts).decode())
+
+
+def events(data):
+    """Yields (time in ticks, step mask, dir mask) for each step event."""
+    time = 0
+    dir_mask = 0
+    i = 0
+    while i < len(data):
+        word = 0
+        shift = 0
+        while True:
+            byte = data[i]
+            i += 1
+            word |= (byte & 0x7F) << shift
+            shift += 7
+            if byte < 0x80:
+                break
+        time += word >> 1
+        step_mask = data[i]
+        i += 1
+        if word & 1:
+            dir_mask = data[i]
+            i += 1
+        yield time, step_mask, dir_mask
+
+
+def axes(mask):
+    return "".join(AXES[axis] for axis in range(len(AXES)) if mask & (1 << axis)) or "-"
+
+
+def describe(event):
+    time, step_mask, dir_mask = event
+    return "%12.2f us  step %-6s dir %-6s" % (time / TICKS_PER_US, axes(step_mask), axes(dir_mask))
+
+
+def summary(trace):
+    steps = [0] * len(AXES)
+    for _, step_mask, dir_mask in trace:
+        for axis in range(len(AXES)):
+            if step_mask & (1 << axis):
+                steps[axis] += -1 if dir_mask & (1 << axis) else 1
+    end = trace[-1][0] / TICKS_PER_US if trace else 0
+    moved = " ".join("%s%d" % (AXES[axis], steps[axis]) for axis in range(len(AXES)) if steps[axis])
+    return "%d events, %.3f s of steps, net %s" % (len(trace), end / 1e6, moved or "none")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("old")
+    parser.add_argument("new", nargs="?")
+    parser.add_argument("--show", action="store_true", help="print the events of one trace")
+    parser.add_argument("--max", type=int, default=10, help="differences to list, 10 by default")
+    args = parser.parse_args()
+
+    old = list(events(read_bytes(args.old)))
+    if args.show or args.new is None:
+        for event in old:
+            print(describe(event))
+        print(summary(old))
+        return 0
+
+    new = list(events(read_bytes(args.new)))
+    print("old: " + summary(old))
+    print("new: " + summary(new))
+    differences = 0
+    for index in range(max(len(old), len(new))):
+        a = old[index] if index < len(old) else None
+        b = new[index] if index < len(new) else None
+        if a == b:
+            continue
+        differences += 1
+        if differences <= args.max:
+            print("event %d" % index)
+            print("  old %s" % (describe(a) if a else "(ended)"))
+            print("  new %s" % (describe(b) if b else "(ended)"))
+    if differences:
+        print("%d events differ" % differences)
+        return 1
+    print("identical")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())